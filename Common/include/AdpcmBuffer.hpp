@@ -0,0 +1,86 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __ADPCM_BUFFER_HPP__
+#define __ADPCM_BUFFER_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <string>
+#include <vector>
+
+// Sound kept in memory as IMA-ADPCM, 4 bits a sample instead of 16.
+// The data is laid out in the blocks of the wave format (format tag 0x11).
+// Every block starts with its first sample as it is, so any block decodes on its own
+// and a player only has to decode the block it's in.
+class AdpcmBuffer
+{
+
+public:
+
+	// Constructor
+	AdpcmBuffer( );
+
+	// Public functions. IMA-ADPCM wave files are read as they are,
+	// 8 and 16 bit PCM wave files are encoded while loading.
+	BIT_UINT32 Read( const std::string & p_FilePath );
+	BIT_UINT32 Write( const std::string & p_FilePath ) const;
+	void Clear( );
+
+	// Interleaved 16 bit frames. The frames per block is one more than a multiple of 8.
+	BIT_UINT32 Encode( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount, const BIT_UINT16 p_ChannelCount,
+		const BIT_UINT32 p_SampleRate, const BIT_UINT32 p_FramesPerBlock = 1017 );
+
+	// Returns the number of frames in the block, the last block may be short.
+	// The float version writes one array per channel, the right one is ignored for mono.
+	BIT_UINT32 DecodeBlock( const BIT_UINT32 p_Block, BIT_SINT16 * p_pFrames ) const;
+	BIT_UINT32 DecodeBlock( const BIT_UINT32 p_Block, BIT_FLOAT32 * p_pLeft, BIT_FLOAT32 * p_pRight ) const;
+
+	// Decodes a code at a time the way the reference IMA decoder does, slow.
+	// For checking the table driven decoder.
+	BIT_UINT32 DecodeBlockReference( const BIT_UINT32 p_Block, BIT_SINT16 * p_pFrames ) const;
+
+	// Get functions
+	BIT_BOOL IsEmpty( ) const;
+	BIT_UINT16 GetChannelCount( ) const;
+	BIT_UINT32 GetSampleRate( ) const;
+	BIT_UINT32 GetFrameCount( ) const;
+	BIT_UINT32 GetFramesPerBlock( ) const;
+	BIT_UINT32 GetBlockSize( ) const;
+	BIT_UINT32 GetBlockCount( ) const;
+	BIT_UINT32 GetDataSize( ) const;
+
+private:
+
+	// Private variables
+	std::vector< BIT_UINT8 > m_Data;
+	BIT_UINT16 m_ChannelCount;
+	BIT_UINT32 m_SampleRate;
+	BIT_UINT32 m_FrameCount;
+	BIT_UINT32 m_FramesPerBlock;
+	BIT_UINT32 m_BlockSize;
+
+};
+
+#endif
@@ -0,0 +1,97 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __ATLAS_PACKER_HPP__
+#define __ATLAS_PACKER_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <vector>
+
+// Runtime rectangle packer for texture atlases.
+// Every page keeps a skyline, the top edge of the packed rectangles as a list of
+// horizontal segments. A rectangle is placed on the segment where its bottom ends
+// up lowest (ties go to the narrowest segment), then the skyline is raised under it.
+// Rectangles are padded on every side so mipmaps don't bleed between neighbours.
+// A new page is started when a rectangle fits on none of the current pages.
+class AtlasPacker
+{
+
+public:
+
+	// Public structs
+	struct Region
+	{
+		BIT_UINT32 Page;
+		Bit::Vector2_ui32 Position;	// Lower left corner without the padding
+		Bit::Vector2_ui32 Size;
+	};
+
+	// Constructor/destructor
+	AtlasPacker( );
+	~AtlasPacker( );
+
+	// Public functions
+	BIT_UINT32 Load( const Bit::Vector2_ui32 p_PageSize, const BIT_UINT32 p_Padding, const BIT_UINT32 p_MaxPages );
+	BIT_UINT32 Add( const Bit::Vector2_ui32 p_Size, Region & p_Region );
+	void Clear( );
+
+	// Get functions
+	Bit::Vector2_ui32 GetPageSize( ) const;
+	BIT_UINT32 GetPadding( ) const;
+	BIT_UINT32 GetPageCount( ) const;
+	BIT_UINT32 GetMaxPageCount( ) const;
+	BIT_FLOAT32 GetOccupancy( const BIT_UINT32 p_Page ) const;
+
+private:
+
+	// Private structs
+	struct Segment
+	{
+		BIT_UINT32 X;
+		BIT_UINT32 Y;
+		BIT_UINT32 Width;
+	};
+
+	struct Page
+	{
+		std::vector< Segment > Skyline;
+		BIT_UINT32 UsedArea;
+	};
+
+	// Private functions
+	BIT_BOOL Fit( const Page & p_Page, const BIT_MEMSIZE p_Index, const Bit::Vector2_ui32 p_Size, BIT_UINT32 & p_Y ) const;
+	BIT_BOOL Insert( Page & p_Page, const Bit::Vector2_ui32 p_Size, Bit::Vector2_ui32 & p_Position );
+	void AddPage( );
+
+	// Private variables
+	Bit::Vector2_ui32 m_PageSize;
+	BIT_UINT32 m_Padding;
+	BIT_UINT32 m_MaxPages;
+	std::vector< Page > m_Pages;
+
+};
+
+#endif
@@ -0,0 +1,188 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __AUDIO_MIXER_HPP__
+#define __AUDIO_MIXER_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/Audio/AudioBuffer.hpp>
+#include <AudioOutput.hpp>
+#include <CpuFeatures.hpp>
+#include <Resampler.hpp>
+#include <AdpcmBuffer.hpp>
+#include <vector>
+
+// Software mixer, independent of any audio device.
+// Voices are mixed in float a block at a time into a stereo bus,
+// gain and pan changes are ramped over a block so they don't click.
+// The bus goes through a peak limiter and is converted to 16 bit stereo.
+// Mixing runs on SSE2 or AVX2 when the CPU has it.
+class AudioMixer
+{
+
+public:
+
+	// Public typedefs and constants, a voice handle turns invalid once the voice is reused
+	typedef BIT_UINT32 VoiceHandle;
+	static const VoiceHandle InvalidVoice = 0;
+
+	// Constructor/destructor
+	AudioMixer( );
+	~AudioMixer( );
+
+	// Public functions
+	BIT_UINT32 Open( const BIT_UINT32 p_SampleRate, const BIT_UINT32 p_MaxVoiceCount, const BIT_UINT32 p_BlockSize = 256 );
+	void Close( );
+
+	// Sounds are converted to float once, other sample rates are resampled to the rate of the mixer.
+	// Returns the sound index or -1.
+	BIT_SINT32 LoadSound( const Bit::AudioBuffer & p_AudioBuffer );
+	BIT_SINT32 LoadSound( const BIT_FLOAT32 * p_pSamples, const BIT_UINT32 p_FrameCount, const BIT_UINT16 p_ChannelCount,
+		const BIT_UINT32 p_SampleRate );
+
+	// IMA-ADPCM sounds stay compressed, voices decode the block they are playing
+	BIT_SINT32 LoadSound( const AdpcmBuffer & p_AdpcmBuffer );
+
+	// Pan goes from -1 (left) to 1 (right), returns InvalidVoice if every voice is busy
+	VoiceHandle Play( const BIT_UINT32 p_Sound, const BIT_FLOAT32 p_Gain = 1.0f, const BIT_FLOAT32 p_Pan = 0.0f,
+		const BIT_BOOL p_Loop = BIT_FALSE );
+	void Stop( const VoiceHandle p_Voice );
+	void StopAll( );
+
+	// Mixes interleaved 16 bit stereo frames
+	void Mix( BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount );
+	BIT_UINT32 Render( AudioOutput & p_Output, const BIT_UINT32 p_FrameCount );
+	void ResetStatistics( );
+
+	// Set functions
+	void SetGain( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Gain );
+	void SetPan( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Pan );
+
+	// Playback rate from 0.125 to 4, the voice is resampled from then on. Set it before the first mix for a clean start.
+	void SetPitch( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Pitch );
+
+	// Builds the pitch filters and sizes the buffers of the voices for them.
+	// Set it where sounds are loaded, not while another thread mixes.
+	void SetResampleQuality( const ResamplerFilter::eQuality p_Quality );
+
+	// Encode the sounds loaded from here on to IMA-ADPCM, an eighth of the memory of float
+	void SetCompressSounds( const BIT_BOOL p_Compress );
+	void SetMasterGain( const BIT_FLOAT32 p_Gain );
+	void SetLimiterThreshold( const BIT_FLOAT32 p_Threshold );
+	BIT_UINT32 SetInstructionSet( const CpuFeatures::eInstructionSet p_InstructionSet );
+
+	// Get functions
+	BIT_BOOL IsPlaying( const VoiceHandle p_Voice ) const;
+	BIT_UINT32 GetSampleRate( ) const;
+	BIT_UINT32 GetBlockSize( ) const;
+	BIT_UINT32 GetActiveCount( ) const;
+	BIT_FLOAT32 GetLimiterGain( ) const;
+	CpuFeatures::eInstructionSet GetInstructionSet( ) const;
+	ResamplerFilter::eQuality GetResampleQuality( ) const;
+	BIT_BOOL GetCompressSounds( ) const;
+
+	// Bytes of sample data of the loaded sounds
+	BIT_UINT32 GetSoundMemory( ) const;
+
+	// Frames mixed times the voices mixed into them, since the last reset
+	BIT_UINT64 GetVoiceFrameCount( ) const;
+
+private:
+
+	// Private structs
+	struct Sound
+	{
+		std::vector< BIT_FLOAT32 > Left;
+		std::vector< BIT_FLOAT32 > Right;
+		AdpcmBuffer Compressed;
+		BIT_UINT32 FrameCount;
+		BIT_UINT16 ChannelCount;
+	};
+
+	// The last block a voice decoded of a compressed sound
+	struct DecodedBlock
+	{
+		std::vector< BIT_FLOAT32 > Left;
+		std::vector< BIT_FLOAT32 > Right;
+		BIT_UINT32 Block;
+		BIT_UINT32 FrameCount;
+	};
+
+	struct Voice
+	{
+		BIT_UINT32 Sound;
+		BIT_UINT32 Position;
+		BIT_UINT32 Generation;
+		BIT_FLOAT32 Gain;
+		BIT_FLOAT32 Pan;
+		BIT_FLOAT32 GainLeft;
+		BIT_FLOAT32 GainRight;
+		BIT_FLOAT32 Pitch;
+		BIT_UINT32 Silence;
+		BIT_BOOL Active;
+		BIT_BOOL Loop;
+		BIT_BOOL Stopping;
+		BIT_BOOL Resampled;
+	};
+
+	// Private functions
+	BIT_SINT32 LoadCompressedSound( const BIT_FLOAT32 * p_pSamples, const BIT_UINT32 p_FrameCount, const BIT_UINT16 p_ChannelCount );
+	void MixBlock( BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount );
+	void MixVoice( const BIT_UINT32 p_Index, const BIT_UINT32 p_FrameCount );
+	void MixResampledVoice( const BIT_UINT32 p_Index, const BIT_UINT32 p_FrameCount, const BIT_FLOAT32 p_TargetLeft,
+		const BIT_FLOAT32 p_TargetRight );
+	void TargetGains( const Voice & p_Voice, BIT_FLOAT32 & p_Left, BIT_FLOAT32 & p_Right ) const;
+	BIT_UINT32 GetFrames( const BIT_UINT32 p_Index, const BIT_FLOAT32 * & p_pLeft, const BIT_FLOAT32 * & p_pRight );
+	Voice * GetVoice( const VoiceHandle p_Voice );
+	const ResamplerFilter * GetPitchFilter( const BIT_FLOAT32 p_Pitch ) const;
+	void CreatePitchFilters( );
+	void Release( const BIT_UINT32 p_Index );
+
+	// Private variables
+	std::vector< Sound > m_Sounds;
+	std::vector< Voice > m_Voices;
+	std::vector< BIT_UINT32 > m_FreeVoices;
+	std::vector< BIT_FLOAT32 > m_Left;
+	std::vector< BIT_FLOAT32 > m_Right;
+	std::vector< BIT_SINT16 > m_Output;
+	std::vector< DecodedBlock > m_DecodedBlocks;
+	std::vector< Resampler > m_Resamplers;
+	std::vector< ResamplerFilter > m_PitchFilters;
+	std::vector< BIT_FLOAT32 > m_VoiceLeft;
+	std::vector< BIT_FLOAT32 > m_VoiceRight;
+	BIT_UINT32 m_SampleRate;
+	BIT_UINT32 m_BlockSize;
+	BIT_FLOAT32 m_MasterGain;
+	BIT_FLOAT32 m_LimiterThreshold;
+	BIT_FLOAT32 m_LimiterGain;
+	BIT_FLOAT32 m_LimiterRelease;
+	BIT_UINT64 m_VoiceFrameCount;
+	CpuFeatures::eInstructionSet m_InstructionSet;
+	ResamplerFilter::eQuality m_ResampleQuality;
+	BIT_BOOL m_CompressSounds;
+
+};
+
+#endif
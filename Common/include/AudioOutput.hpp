@@ -0,0 +1,143 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __AUDIO_OUTPUT_HPP__
+#define __AUDIO_OUTPUT_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <EventWaiter.hpp>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+// Destination of the software mixer, 16 bit interleaved frames.
+class AudioOutput
+{
+
+public:
+
+	// Destructor
+	virtual ~AudioOutput( ) { }
+
+	// Public functions
+	virtual BIT_UINT32 Open( const BIT_UINT32 p_SampleRate, const BIT_UINT16 p_ChannelCount ) = 0;
+	virtual void Close( ) = 0;
+	virtual BIT_UINT32 Write( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount ) = 0;
+
+};
+
+// Throws the frames away, for benchmarks and headless runs.
+class NullAudioOutput : public AudioOutput
+{
+
+public:
+
+	// Constructor
+	NullAudioOutput( );
+
+	// Public functions
+	virtual BIT_UINT32 Open( const BIT_UINT32 p_SampleRate, const BIT_UINT16 p_ChannelCount );
+	virtual void Close( );
+	virtual BIT_UINT32 Write( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount );
+
+	// Get functions
+	BIT_UINT64 GetFrameCount( ) const;
+
+private:
+
+	// Private variables
+	BIT_UINT64 m_FrameCount;
+
+};
+
+// Writes the frames to a PCM wave file, the sizes in the header are set when closing.
+class WaveFileAudioOutput : public AudioOutput
+{
+
+public:
+
+	// Constructor/destructor
+	WaveFileAudioOutput( const std::string & p_FilePath );
+	~WaveFileAudioOutput( );
+
+	// Public functions
+	virtual BIT_UINT32 Open( const BIT_UINT32 p_SampleRate, const BIT_UINT16 p_ChannelCount );
+	virtual void Close( );
+	virtual BIT_UINT32 Write( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount );
+
+private:
+
+	// Private functions
+	void WriteHeader( );
+
+	// Private variables
+	std::string m_FilePath;
+	FILE * m_pFile;
+	BIT_UINT32 m_SampleRate;
+	BIT_UINT16 m_ChannelCount;
+	BIT_UINT32 m_DataSize;
+
+};
+
+// Plays the frames through a small ring of queued OpenAL buffers, one buffer per write.
+// Write waits while every buffer is queued, so the device clock paces the caller.
+// The audio device has to be open, the output uses its own OpenAL source.
+class OpenALAudioOutput : public AudioOutput
+{
+
+public:
+
+	// Constructor/destructor
+	OpenALAudioOutput( const BIT_UINT32 p_BufferCount = 4 );
+	~OpenALAudioOutput( );
+
+	// Public functions
+	virtual BIT_UINT32 Open( const BIT_UINT32 p_SampleRate, const BIT_UINT16 p_ChannelCount );
+	virtual void Close( );
+	virtual BIT_UINT32 Write( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount );
+
+	// Get functions, the source ran dry this many times
+	BIT_UINT32 GetUnderrunCount( ) const;
+
+private:
+
+	// Private functions
+	void Reclaim( );
+
+	// Private variables
+	EventWaiter m_Waiter;
+	std::vector< BIT_UINT32 > m_Buffers;
+	std::vector< BIT_UINT32 > m_FreeBuffers;
+	BIT_UINT32 m_BufferCount;
+	BIT_UINT32 m_Source;
+	BIT_SINT32 m_Format;
+	BIT_UINT32 m_SampleRate;
+	BIT_UINT16 m_ChannelCount;
+	BIT_BOOL m_Started;
+	BIT_UINT32 m_UnderrunCount;
+
+};
+
+#endif
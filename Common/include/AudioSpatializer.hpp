@@ -0,0 +1,123 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __AUDIO_SPATIALIZER_HPP__
+#define __AUDIO_SPATIALIZER_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Vector3.hpp>
+#include <AudioMixer.hpp>
+#include <CpuFeatures.hpp>
+#include <vector>
+
+// Distance attenuation, panning and Doppler of many emitters in one pass.
+// The emitters are kept as arrays of each property, padded to a multiple of eight,
+// and processed four at a time with SSE2 or eight with AVX2.
+// Emitters too quiet to hear are culled before they get a voice of the mixer,
+// the loudest of the rest are played. Emitters loop their sound.
+class AudioSpatializer
+{
+
+public:
+
+	// Constructor
+	AudioSpatializer( );
+
+	// Public functions
+	BIT_UINT32 AddEmitter( const BIT_UINT32 p_Sound, const Bit::Vector3_f32 & p_Position, const BIT_FLOAT32 p_Volume = 1.0f );
+	void Clear( AudioMixer & p_Mixer );
+
+	// Computes the gain, pan and pitch of every emitter and lists the audible ones
+	void Spatialize( );
+
+	// Plays the loudest audible emitters on at most p_MaxVoiceCount voices and stops the others
+	void Apply( AudioMixer & p_Mixer, const BIT_UINT32 p_MaxVoiceCount );
+
+	// Set functions, the listener faces the target direction like the audio device listener
+	void SetListenerPosition( const Bit::Vector3_f32 & p_Position );
+	void SetListenerTarget( const Bit::Vector3_f32 & p_Target );
+	void SetListenerVelocity( const Bit::Vector3_f32 & p_Velocity );
+	void SetEmitterPosition( const BIT_UINT32 p_Emitter, const Bit::Vector3_f32 & p_Position );
+	void SetEmitterVelocity( const BIT_UINT32 p_Emitter, const Bit::Vector3_f32 & p_Velocity );
+	void SetEmitterVolume( const BIT_UINT32 p_Emitter, const BIT_FLOAT32 p_Volume );
+
+	// Full volume up to the reference distance, inverse distance falloff to the max distance
+	void SetEmitterDistances( const BIT_UINT32 p_Emitter, const BIT_FLOAT32 p_ReferenceDistance, const BIT_FLOAT32 p_MaxDistance );
+	void SetRolloff( const BIT_FLOAT32 p_Rolloff );
+	void SetSpeedOfSound( const BIT_FLOAT32 p_SpeedOfSound );
+	void SetDopplerFactor( const BIT_FLOAT32 p_DopplerFactor );
+
+	// Emitters with a lower gain are culled, 0.001 (-60 dB) by default
+	void SetCullThreshold( const BIT_FLOAT32 p_Threshold );
+	BIT_UINT32 SetInstructionSet( const CpuFeatures::eInstructionSet p_InstructionSet );
+
+	// Get functions, the values of the last pass
+	BIT_UINT32 GetEmitterCount( ) const;
+	BIT_FLOAT32 GetGain( const BIT_UINT32 p_Emitter ) const;
+	BIT_FLOAT32 GetPan( const BIT_UINT32 p_Emitter ) const;
+	BIT_FLOAT32 GetPitch( const BIT_UINT32 p_Emitter ) const;
+	BIT_UINT32 GetAudibleCount( ) const;
+	const BIT_UINT32 * GetAudible( ) const;
+	BIT_UINT32 GetVoiceCount( ) const;
+	CpuFeatures::eInstructionSet GetInstructionSet( ) const;
+
+private:
+
+	// Private functions
+	void Pad( );
+
+	// Private variables
+	BIT_UINT32 m_Count;
+	std::vector< BIT_FLOAT32 > m_X;
+	std::vector< BIT_FLOAT32 > m_Y;
+	std::vector< BIT_FLOAT32 > m_Z;
+	std::vector< BIT_FLOAT32 > m_VelocityX;
+	std::vector< BIT_FLOAT32 > m_VelocityY;
+	std::vector< BIT_FLOAT32 > m_VelocityZ;
+	std::vector< BIT_FLOAT32 > m_Volume;
+	std::vector< BIT_FLOAT32 > m_ReferenceDistance;
+	std::vector< BIT_FLOAT32 > m_MaxDistance;
+	std::vector< BIT_UINT32 > m_Sounds;
+	std::vector< AudioMixer::VoiceHandle > m_Voices;
+	std::vector< BIT_FLOAT32 > m_Gains;
+	std::vector< BIT_FLOAT32 > m_Pans;
+	std::vector< BIT_FLOAT32 > m_Pitches;
+	std::vector< BIT_UINT32 > m_Audible;
+	BIT_UINT32 m_AudibleCount;
+	std::vector< BIT_UINT32 > m_Ranked;
+	std::vector< BIT_UINT32 > m_Voiced;
+	std::vector< BIT_UINT8 > m_Selected;
+	Bit::Vector3_f32 m_ListenerPosition;
+	Bit::Vector3_f32 m_ListenerTarget;
+	Bit::Vector3_f32 m_ListenerVelocity;
+	BIT_FLOAT32 m_Rolloff;
+	BIT_FLOAT32 m_SpeedOfSound;
+	BIT_FLOAT32 m_DopplerFactor;
+	BIT_FLOAT32 m_CullThreshold;
+	CpuFeatures::eInstructionSet m_InstructionSet;
+
+};
+
+#endif
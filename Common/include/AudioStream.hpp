@@ -0,0 +1,112 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __AUDIO_STREAM_HPP__
+#define __AUDIO_STREAM_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <WaveStream.hpp>
+#include <WorkerThread.hpp>
+#include <EventWaiter.hpp>
+#include <vector>
+#include <deque>
+#include <string>
+
+// Wave file played from disk through a small ring of queued OpenAL buffers.
+// A background thread refills the buffers as they are played,
+// so the memory use is the same for a jingle and for an hour of music.
+// The audio device has to be open, the stream uses its own OpenAL source.
+class AudioStream
+{
+
+public:
+
+	// Constructor/destructor
+	AudioStream( );
+	~AudioStream( );
+
+	// Public functions, the buffer length is in seconds
+	BIT_UINT32 Open( const std::string & p_FilePath, const BIT_UINT32 p_BufferCount = 4, const BIT_FLOAT32 p_BufferLength = 0.25f );
+	void Close( );
+	void Play( );
+	void Pause( );
+	void Stop( );
+	BIT_UINT32 Seek( const BIT_FLOAT64 p_Time );
+
+	// Set functions, the waiter is notified when the stream plays to the end
+	void SetLoop( const BIT_BOOL p_Loop );
+	void SetVolume( const BIT_FLOAT32 p_Volume );
+	void SetFinishedWaiter( EventWaiter * p_pWaiter );
+
+	// Get functions, the times are in seconds
+	BIT_BOOL IsOpen( ) const;
+	BIT_BOOL IsPlaying( );
+	BIT_BOOL GetLoop( ) const;
+	BIT_FLOAT64 GetTime( );
+	BIT_FLOAT64 GetLength( ) const;
+	BIT_UINT32 GetBufferMemory( ) const;
+	BIT_UINT32 GetUnderrunCount( ) const;
+
+private:
+
+	// Private enums
+	enum eState
+	{
+		State_Stopped,
+		State_Playing,
+		State_Paused
+	};
+
+	// Private functions, the mutex has to be locked
+	void Refill( );
+	void Flush( );
+	BIT_UINT32 FillBuffer( const BIT_UINT32 p_Buffer );
+
+	// Static functions
+	static void StreamThread( void * p_pStream );
+
+	// Private variables
+	WaveStream m_Wave;
+	WorkerThread m_Thread;
+	Mutex m_Mutex;
+	EventWaiter m_Waiter;
+	EventWaiter * m_pFinishedWaiter;
+	std::vector< BIT_UINT8 > m_Scratch;
+	std::vector< BIT_UINT32 > m_FreeBuffers;
+	std::vector< BIT_UINT32 > m_Buffers;
+	std::deque< BIT_UINT32 > m_QueuedStarts;
+	BIT_UINT32 m_Source;
+	BIT_SINT32 m_Format;
+	BIT_UINT32 m_BufferFrames;
+	BIT_FLOAT32 m_BufferLength;
+	eState m_State;
+	BIT_BOOL m_Loop;
+	BIT_BOOL m_EndOfStream;
+	BIT_BOOL m_Quit;
+	BIT_UINT32 m_UnderrunCount;
+
+};
+
+#endif
@@ -0,0 +1,164 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __AUDIO_THREAD_HPP__
+#define __AUDIO_THREAD_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <AudioMixer.hpp>
+#include <AudioOutput.hpp>
+#include <SpscQueue.hpp>
+#include <WorkerThread.hpp>
+#include <EventWaiter.hpp>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+// Runs the software mixer on its own thread, a block per period of the output.
+// The game thread sends commands through a lock-free queue and never waits on the audio thread,
+// the audio thread applies them at the start of the next block. Nothing is allocated per command.
+// Load the sounds before Start or after Stop, the mixer belongs to the audio thread in between.
+class AudioThread
+{
+
+public:
+
+	// Public typedefs and constants, voice handles of the audio thread, not of the mixer
+	typedef BIT_UINT32 VoiceHandle;
+	static const VoiceHandle InvalidVoice = 0;
+
+	// Constructor/destructor
+	AudioThread( );
+	~AudioThread( );
+
+	// Public functions. Blocks of the mixer block size are written to the output, paced to the sample rate
+	// when p_RealTime is true, otherwise as fast as the output takes them. Without an output the thread isn't started,
+	// call Render from the callback of the audio device instead.
+	BIT_UINT32 Start( AudioMixer & p_Mixer, AudioOutput * p_pOutput, const BIT_BOOL p_RealTime = BIT_TRUE,
+		const BIT_UINT32 p_QueueSize = 1024 );
+	void Stop( );
+
+	// Callback of the audio thread or the audio device, applies the queued commands and mixes 16 bit stereo frames
+	void Render( BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount );
+
+	// Game thread functions, they fail or return InvalidVoice when the queue is full
+	VoiceHandle Play( const BIT_UINT32 p_Sound, const BIT_FLOAT32 p_Gain = 1.0f, const BIT_FLOAT32 p_Pan = 0.0f,
+		const BIT_BOOL p_Loop = BIT_FALSE );
+	BIT_UINT32 Stop( const VoiceHandle p_Voice );
+	BIT_UINT32 StopAll( );
+	BIT_UINT32 SetGain( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Gain );
+	BIT_UINT32 SetPan( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Pan );
+	BIT_UINT32 SetPitch( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Pitch );
+	BIT_UINT32 SetMasterGain( const BIT_FLOAT32 p_Gain );
+	void ResetStatistics( );
+
+	// Get functions
+	BIT_BOOL IsRunning( ) const;
+	BIT_UINT32 GetDroppedCount( ) const;
+	BIT_UINT32 GetUnderrunCount( ) const;
+	BIT_UINT64 GetBlockCount( ) const;
+
+	// Seconds from queueing a command to the end of the block it was mixed into,
+	// the time the first affected sample is handed to the output. The buffering of the device comes on top.
+	BIT_UINT32 GetLatencyCount( ) const;
+	BIT_FLOAT64 GetAverageLatency( ) const;
+	BIT_FLOAT64 GetMaxLatency( ) const;
+
+private:
+
+	// Private enums
+	enum eCommand
+	{
+		Command_Play,
+		Command_Stop,
+		Command_StopAll,
+		Command_SetGain,
+		Command_SetPan,
+		Command_SetPitch,
+		Command_SetMasterGain
+	};
+
+	// Private structs
+	struct Command
+	{
+		Command( ) :
+			Type( Command_StopAll ),
+			Voice( InvalidVoice ),
+			Sound( 0 ),
+			Value( 0.0f ),
+			Pan( 0.0f ),
+			Loop( BIT_FALSE ),
+			Time( 0.0f )
+		{
+		}
+
+		eCommand Type;
+		VoiceHandle Voice;
+		BIT_UINT32 Sound;
+		BIT_FLOAT32 Value;
+		BIT_FLOAT32 Pan;
+		BIT_BOOL Loop;
+		BIT_FLOAT64 Time;
+	};
+
+	// Mixer voice of a handle, the table wraps around so old handles turn invalid
+	struct Voice
+	{
+		VoiceHandle Handle;
+		AudioMixer::VoiceHandle MixerVoice;
+	};
+
+	// Private functions
+	BIT_UINT32 Send( Command & p_Command );
+	void Apply( const Command & p_Command );
+	AudioMixer::VoiceHandle GetMixerVoice( const VoiceHandle p_Voice ) const;
+	BIT_FLOAT64 GetTime( ) const;
+
+	// Static functions
+	static void RenderThread( void * p_pAudioThread );
+
+	// Private variables
+	AudioMixer * m_pMixer;
+	AudioOutput * m_pOutput;
+	BIT_BOOL m_RealTime;
+	WorkerThread m_Thread;
+	EventWaiter m_Waiter;
+	std::chrono::steady_clock::time_point m_StartTime;	// Set before the audio thread starts, read by both threads
+	SpscQueue< Command > m_Commands;
+	std::vector< BIT_FLOAT64 > m_CommandTimes;
+	std::vector< Voice > m_Voices;
+	std::vector< BIT_SINT16 > m_Frames;
+	std::atomic< BIT_UINT32 > m_Quit;
+	std::atomic< BIT_UINT32 > m_UnderrunCount;
+	std::atomic< BIT_UINT64 > m_BlockCount;
+	std::atomic< BIT_UINT32 > m_LatencyCount;
+	std::atomic< BIT_UINT64 > m_LatencyTotal;
+	std::atomic< BIT_UINT64 > m_LatencyMax;
+	VoiceHandle m_NextVoice;
+	BIT_UINT32 m_DroppedCount;
+
+};
+
+#endif
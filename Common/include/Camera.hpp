@@ -44,6 +44,15 @@ public:
 		Backward = 3
 	};
 
+	// Angles in degrees and the position a view matrix is built from
+	struct ViewState
+	{
+		BIT_FLOAT32 Pitch;
+		BIT_FLOAT32 Yaw;
+		BIT_FLOAT32 Roll;
+		Bit::Vector3_f32 Position;
+	};
+
 	// Constructor
 	Camera( );
 
@@ -73,6 +82,15 @@ public:
 	BIT_FLOAT32 GetRotationSpeed( ) const;
 	BIT_FLOAT32 GetRotationResistance( ) const;
 	BIT_FLOAT32 GetRotationRollFactor( ) const;
+	ViewState GetViewState( ) const;
+	BIT_UINT32 GetVersion( ) const;
+	BIT_UINT32 GetSkipCount( ) const;
+
+	// Static functions, the view matrix is RotateZ( roll ) * RotateX( pitch ) * RotateY( yaw ) * Translate( -position )
+	// written out in closed form. The batch builds four matrices at a time with SSE2.
+	static void BuildViewMatrix( const ViewState & p_State, Bit::Matrix4x4 & p_Matrix );
+	static void BuildViewMatrices( const ViewState * p_pStates, Bit::Matrix4x4 * p_pMatrices, const BIT_UINT32 p_Count );
+	static void UpdateMatrices( Camera * const * p_ppCameras, const BIT_UINT32 p_Count );
 
 private:
 
@@ -94,6 +112,11 @@ private:
 	BIT_FLOAT32 m_RotationResistance;
 	BIT_FLOAT32 m_RotationRollFactor;
 
+	// The version is bumped every time the matrix is rebuilt,
+	// updates without any movement or rotation are counted as skipped.
+	BIT_BOOL m_Changed;
+	BIT_UINT32 m_Version;
+	BIT_UINT32 m_SkipCount;
 
 };
 
@@ -0,0 +1,66 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __CPU_FEATURES_HPP__
+#define __CPU_FEATURES_HPP__
+
+#include <Bit/DataTypes.hpp>
+
+// The SIMD paths the compiler can build. SSE2 is part of the target,
+// AVX2 functions are compiled on their own and only called if CPUID reports it
+// (Visual Studio 2008 has no AVX intrinsics). Include the intrinsics headers under these.
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define CPU_FEATURES_SSE2
+#endif
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+	#define CPU_FEATURES_AVX2
+	#define CPU_FEATURES_AVX2_FUNCTION __attribute__( ( target( "avx2" ) ) )
+#elif defined( _MSC_VER ) && _MSC_VER >= 1700 && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+	#define CPU_FEATURES_AVX2
+	#define CPU_FEATURES_AVX2_FUNCTION
+#endif
+
+// Instruction sets of the running CPU, detected once with CPUID.
+class CpuFeatures
+{
+
+public:
+
+	// Public enums, every level includes the ones below
+	enum eInstructionSet
+	{
+		InstructionSet_Scalar = 0,
+		InstructionSet_SSE2 = 1,
+		InstructionSet_AVX2 = 2
+	};
+
+	// Static functions
+	static eInstructionSet GetSupportedInstructionSet( );
+	static const char * GetInstructionSetName( const eInstructionSet p_InstructionSet );
+
+};
+
+#endif
@@ -0,0 +1,61 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __CPU_USAGE_HPP__
+#define __CPU_USAGE_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Timer.hpp>
+
+// CPU time used by the process against the wall clock time,
+// 1.0 is one core fully busy since Start was called.
+class CpuUsage
+{
+
+public:
+
+	// Constructor
+	CpuUsage( );
+
+	// Public functions
+	void Start( );
+
+	// Get functions, the times are in seconds
+	BIT_FLOAT64 GetCpuTime( ) const;
+	BIT_FLOAT64 GetWallTime( );
+	BIT_FLOAT64 GetUsage( );
+
+	// Static functions, user and kernel time of the whole process
+	static BIT_FLOAT64 GetProcessTime( );
+
+private:
+
+	// Private variables
+	Bit::Timer m_Timer;
+	BIT_FLOAT64 m_StartTime;
+
+};
+
+#endif
@@ -0,0 +1,147 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __DEFERRED_RENDERER_HPP__
+#define __DEFERRED_RENDERER_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/Graphics/GraphicDevice.hpp>
+#include <Bit/Graphics/ShaderProgram.hpp>
+#include <Bit/Graphics/VertexObject.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <RenderGraph.hpp>
+#include <FrameUniformBlock.hpp>
+#include <ShaderUniforms.hpp>
+#include <ShaderPermutations.hpp>
+#include <PointLightSet.hpp>
+#include <Frustum.hpp>
+#include <vector>
+#include <string>
+
+// Deferred shading of a model lit by a point light set.
+// The geometry pass writes a single RGBA32F G-buffer: the albedo packed into red,
+// an octahedral encoded view space normal in green/blue, the position is
+// reconstructed from the depth buffer. The lights are culled against the view
+// frustum on the CPU and every visible light is drawn as a screen space
+// rectangle covering its sphere, accumulated with additive blending.
+// The culled lights are kept until the view, the projection or the lights change.
+// Both passes can render into a smaller viewport in the lower left corner of
+// the targets, used by dynamic resolution.
+class DeferredRenderer
+{
+
+public:
+
+	// Constructor/destructor
+	DeferredRenderer( Bit::GraphicDevice * p_pGraphicDevice, Bit::Model * p_pModel,
+		const PointLightSet * p_pLights, FrameUniformBlock * p_pFrameUniforms );
+	~DeferredRenderer( );
+
+	// Public functions
+	BIT_UINT32 Load( const Bit::Vector2_ui32 p_Size );
+	void Unload( );
+	void AddPasses( RenderGraph & p_Graph, const BIT_UINT32 p_ColorTexture );
+
+	// Set functions
+	void SetUseNormalMapping( const BIT_BOOL p_Status );
+	void SetAmbient( const BIT_FLOAT32 p_Ambient );
+	void SetViewportSize( const Bit::Vector2_ui32 p_Size );
+
+	// Get functions
+	BIT_UINT32 GetVisibleLightCount( ) const;
+	BIT_FLOAT64 GetCullTime( ) const;
+	BIT_UINT32 GetCullSkipCount( ) const;
+	BIT_FLOAT32 GetAmbient( ) const;
+	Bit::Vector2_ui32 GetViewportSize( ) const;
+
+private:
+
+	// Private enums
+	enum ePassType
+	{
+		Pass_Geometry = 0,
+		Pass_Lighting = 1
+	};
+
+	// Private structs
+	struct GraphPass
+	{
+		DeferredRenderer * pRenderer;
+		ePassType Type;
+		BIT_UINT32 GBuffer;
+		BIT_UINT32 Depth;
+	};
+
+	struct VisibleLight
+	{
+		BIT_FLOAT32 Rect[ 4 ];		// Normalized x, y, width, height
+		BIT_FLOAT32 Position[ 3 ];	// View space
+		BIT_FLOAT32 Radius;
+		BIT_FLOAT32 Color[ 3 ];
+	};
+
+	// Private functions
+	BIT_UINT32 LoadShaders( );
+	BIT_UINT32 LoadProgram( const std::string & p_VertexSource, const std::string & p_FragmentSource,
+		Bit::Shader ** p_ppVertexShader, Bit::Shader ** p_ppFragmentShader, Bit::ShaderProgram ** p_ppShaderProgram );
+	BIT_UINT32 LoadQuad( );
+	void CullLights( );
+	void RenderGeometry( );
+	void RenderLighting( Bit::Texture * p_pGBuffer, Bit::Texture * p_pDepth );
+
+	// Static functions
+	static void ExecuteGraphPass( RenderGraph & p_Graph, void * p_pUserData );
+	static void SetupGeometryProgram( ShaderPermutations::Permutation & p_Permutation, void * p_pUserData );
+
+	// Private variables
+	BIT_BOOL m_Loaded;
+	Bit::GraphicDevice * m_pGraphicDevice;
+	Bit::Model * m_pModel;
+	const PointLightSet * m_pLights;
+	FrameUniformBlock * m_pFrameUniforms;
+	Bit::Vector2_ui32 m_Size;
+	Bit::Vector2_ui32 m_ViewportSize;
+	BIT_BOOL m_UseNormalMapping;
+	BIT_FLOAT32 m_Ambient;
+	Bit::VertexObject * m_pQuadVertexObject;
+	Frustum m_Frustum;
+	std::vector< VisibleLight > m_VisibleLights;
+	std::vector< GraphPass > m_GraphPasses;
+	BIT_FLOAT64 m_CullTime;
+	BIT_UINT32 m_CullMatrixVersion;
+	BIT_UINT32 m_CullLightVersion;
+	BIT_UINT32 m_CullSkipCount;
+
+	// Shaders, the geometry pass has a variant with and without normal mapping
+	ShaderPermutations * m_pGeometryPermutations;
+	BIT_UINT32 m_NormalMappingFeature;
+	Bit::Shader * m_pLightingVertexShader;
+	Bit::Shader * m_pLightingFragmentShader;
+	Bit::ShaderProgram * m_pLightingProgram;
+	ShaderUniforms * m_pLightingUniforms;
+
+};
+
+#endif
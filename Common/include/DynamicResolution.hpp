@@ -0,0 +1,101 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __DYNAMIC_RESOLUTION_HPP__
+#define __DYNAMIC_RESOLUTION_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <vector>
+
+// Render resolution scale kept at a frame time budget.
+// The scene is rendered into the lower left corner of a target sized for the
+// largest scale and stretched to the output size by the final composite.
+// Frame times are averaged over a few frames, then an incremental PI controller
+// on the relative error against the budget moves the scale, which is the same
+// for both axes. Errors within a small dead band are ignored to keep it from
+// jittering around the budget.
+class DynamicResolution
+{
+
+public:
+
+	// Public structs
+	struct HistoryEntry
+	{
+		BIT_UINT32 Frame;
+		BIT_FLOAT32 FrameTime;	// Average of the interval, in milliseconds
+		BIT_FLOAT32 Scale;		// Scale picked for the next interval
+	};
+
+	// Constructor/destructor
+	DynamicResolution( );
+	~DynamicResolution( );
+
+	// Public functions
+	BIT_UINT32 Load( const Bit::Vector2_ui32 p_OutputSize, const BIT_FLOAT32 p_MinScale, const BIT_FLOAT32 p_MaxScale );
+	BIT_BOOL Update( const BIT_FLOAT64 p_FrameTime );
+	void Reset( );
+	void PrintHistory( ) const;
+
+	// Set functions
+	void SetTargetFrameTime( const BIT_FLOAT32 p_FrameTime );
+	void SetGains( const BIT_FLOAT32 p_Proportional, const BIT_FLOAT32 p_Integral );
+	void SetInterval( const BIT_UINT32 p_Frames );
+	void SetScale( const BIT_FLOAT32 p_Scale );
+
+	// Get functions
+	BIT_FLOAT32 GetScale( ) const;
+	BIT_FLOAT32 GetMinScale( ) const;
+	BIT_FLOAT32 GetMaxScale( ) const;
+	BIT_FLOAT32 GetTargetFrameTime( ) const;
+	Bit::Vector2_ui32 GetTargetSize( ) const;
+	Bit::Vector2_ui32 GetViewportSize( ) const;
+	Bit::Vector2_f32 GetTextureScale( ) const;
+	const std::vector< HistoryEntry > & GetHistory( ) const;
+
+private:
+
+	// Private functions
+	BIT_UINT32 ScaleSize( const BIT_UINT32 p_Size, const BIT_FLOAT32 p_Scale ) const;
+
+	// Private variables
+	Bit::Vector2_ui32 m_OutputSize;
+	BIT_FLOAT32 m_MinScale;
+	BIT_FLOAT32 m_MaxScale;
+	BIT_FLOAT32 m_Scale;
+	BIT_FLOAT32 m_TargetFrameTime;
+	BIT_FLOAT32 m_ProportionalGain;
+	BIT_FLOAT32 m_IntegralGain;
+	BIT_FLOAT32 m_PreviousError;
+	BIT_UINT32 m_Interval;
+	BIT_UINT32 m_FrameCount;
+	BIT_UINT32 m_IntervalFrames;
+	BIT_FLOAT64 m_IntervalTime;
+	std::vector< HistoryEntry > m_History;
+
+};
+
+#endif
@@ -0,0 +1,64 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __EVENT_WAITER_HPP__
+#define __EVENT_WAITER_HPP__
+
+#include <Bit/DataTypes.hpp>
+#ifndef BIT_PLATFORM_WINDOWS
+	#include <pthread.h>
+#endif
+
+// Auto reset event a thread can sleep on until another thread notifies it or the timeout runs out.
+// Lets a main loop idle between input polls instead of spinning, and lets
+// the audio code wake it up early, e.g. when a sound is done playing.
+class EventWaiter
+{
+
+public:
+
+	// Constructor/destructor
+	EventWaiter( );
+	~EventWaiter( );
+
+	// Public functions, the timeout is in seconds.
+	// Wait returns true if notified, a notification before the wait is not lost.
+	BIT_BOOL Wait( const BIT_FLOAT64 p_Timeout );
+	void Notify( );
+
+private:
+
+	// Private variables
+#ifdef BIT_PLATFORM_WINDOWS
+	void * m_Event;
+#else
+	pthread_mutex_t m_Mutex;
+	pthread_cond_t m_Condition;
+	BIT_BOOL m_Notified;
+#endif
+
+};
+
+#endif
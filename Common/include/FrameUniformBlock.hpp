@@ -0,0 +1,100 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __FRAME_UNIFORM_BLOCK_HPP__
+#define __FRAME_UNIFORM_BLOCK_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/MatrixManager.hpp>
+#include <Bit/System/Vector3.hpp>
+#include <ShaderUniforms.hpp>
+
+// Per-frame uniform data shared by every shader program of an example.
+// The data is laid out as a std140 block and each member is versioned,
+// so a program only receives the members that changed since it last saw the block.
+class FrameUniformBlock
+{
+
+public:
+
+	// Public enums
+	enum eMember
+	{
+		Member_ProjectionMatrix = 0x01,
+		Member_ViewMatrix = 0x02,
+		Member_ShadowMatrix = 0x04,
+		Member_LightMatrix = 0x08,
+		Member_LightPosition = 0x10,
+		Member_All = 0x1F
+	};
+
+	// std140 layout of the block
+	struct Data
+	{
+		Bit::Matrix4x4 ProjectionMatrix;	// Offset 0
+		Bit::Matrix4x4 ViewMatrix;			// Offset 64
+		Bit::Matrix4x4 ShadowMatrix;		// Offset 128, Projection * ShadowView
+		Bit::Matrix4x4 LightMatrix;			// Offset 192, Bias * Projection * ShadowView
+		BIT_FLOAT32 LightPosition[ 4 ];		// Offset 256, vec3 padded to a vec4
+	};
+
+	// Constructor
+	FrameUniformBlock( );
+
+	// Public functions
+	void Apply( ShaderUniforms & p_Uniforms, const BIT_UINT32 p_Members );
+
+	// Set functions
+	void SetProjectionMatrix( const Bit::Matrix4x4 & p_Matrix );
+	void SetViewMatrix( const Bit::Matrix4x4 & p_Matrix );
+	void SetLightMatrices( const Bit::Matrix4x4 & p_BiasMatrix, const Bit::Matrix4x4 & p_ProjectionMatrix,
+		const Bit::Matrix4x4 & p_ShadowViewMatrix );
+	void SetLightPosition( const Bit::Vector3_f32 p_Position );
+
+	// Get functions
+	const Data & GetData( ) const;
+	BIT_UINT32 GetVersion( ) const;
+	BIT_UINT32 GetMemberVersion( const BIT_UINT32 p_Members ) const;
+
+	// Static uniform handles
+	static const UniformHandle ProjectionMatrixHandle;
+	static const UniformHandle ViewMatrixHandle;
+	static const UniformHandle ShadowMatrixHandle;
+	static const UniformHandle LightMatrixHandle;
+	static const UniformHandle LightPositionHandle;
+
+private:
+
+	// Private functions
+	void SetMatrix( Bit::Matrix4x4 & p_Destination, const Bit::Matrix4x4 & p_Source, const BIT_UINT32 p_Index );
+
+	// Private variables
+	Data m_Data;
+	BIT_UINT32 m_Version;
+	BIT_UINT32 m_MemberVersions[ 5 ];
+
+};
+
+#endif
@@ -0,0 +1,68 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __FRUSTUM_HPP__
+#define __FRUSTUM_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/MatrixManager.hpp>
+
+// View frustum planes, extracted from a projection * view matrix.
+// The plane normals point into the frustum.
+class Frustum
+{
+
+public:
+
+	// Public enums
+	enum ePlane
+	{
+		Plane_Left = 0,
+		Plane_Right = 1,
+		Plane_Bottom = 2,
+		Plane_Top = 3,
+		Plane_Near = 4,
+		Plane_Far = 5
+	};
+
+	// Constructor
+	Frustum( );
+
+	// Public functions
+	void Extract( const Bit::Matrix4x4 & p_ViewProjectionMatrix );
+	BIT_BOOL IntersectsSphere( const BIT_FLOAT32 p_X, const BIT_FLOAT32 p_Y, const BIT_FLOAT32 p_Z,
+		const BIT_FLOAT32 p_Radius ) const;
+
+	// Get functions
+	const BIT_FLOAT32 * GetPlane( const ePlane p_Plane ) const;
+
+private:
+
+	// Private variables
+	BIT_FLOAT32 m_Planes[ 6 ][ 4 ];
+
+};
+
+#endif
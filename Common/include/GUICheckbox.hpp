@@ -27,7 +27,14 @@
 
 #include <Bit/DataTypes.hpp>
 #include <Bit/System/Vector2.hpp>
+#include <WidgetGrid.hpp>
 
+class GUIManager;
+
+// The GUI manager links added checkboxes to itself, moving, resizing or
+// toggling a linked checkbox updates the hit-testing grid right away and
+// marks the covered area of the cached GUI layer for redraw.
+// Deleting a linked checkbox removes it from the manager.
 class GUICheckbox
 {
 
@@ -41,11 +48,13 @@ public:
 	void SetPosition( const Bit::Vector2_si32 p_Position );
 	void SetSize( const Bit::Vector2_ui32 p_Size);
 	void SetStatus( const BIT_BOOL p_Status );
+	void SetManager( GUIManager * p_pManager, const BIT_UINT32 p_GridId );
 
 	// Get functions
 	Bit::Vector2_si32 GetPosition( ) const;
 	Bit::Vector2_ui32 GetSize( ) const;
 	BIT_BOOL GetStatus( ) const;
+	BIT_UINT32 GetGridId( ) const;
 
 private:
 
@@ -53,6 +62,8 @@ private:
 	Bit::Vector2_si32 m_Position;
 	Bit::Vector2_ui32 m_Size;
 	BIT_BOOL m_Status;
+	GUIManager * m_pManager;
+	BIT_UINT32 m_GridId;
 
 };
 
@@ -28,16 +28,53 @@
 #include <Bit/DataTypes.hpp>
 #include <Bit/Window/Event.hpp>
 #include <Bit/Graphics/GraphicDevice.hpp>
+#include <Bit/Graphics/Texture.hpp>
+#include <Bit/Graphics/Framebuffer.hpp>
+#include <Bit/Graphics/VertexObject.hpp>
+#include <Bit/System/MatrixManager.hpp>
 #include <GUICheckbox.hpp>
 #include <GUISlider.hpp>
+#include <ShaderPermutations.hpp>
+#include <AtlasPacker.hpp>
+#include <WidgetGrid.hpp>
 #include <vector>
 #include <string>
 
+// Every widget is a textured quad with its image in a texture atlas.
+// The widget images and any image added later (glyphs, icons) are packed at
+// runtime into a few atlas pages, all pages are bound at once so the whole GUI
+// is drawn without texture switches. The pages keep a CPU copy, modified pages
+// are uploaded with their mipmaps before the next draw.
+// The batched render mode writes the position, size and atlas rectangle of all
+// widgets into a float texture every frame and draws every quad with a single
+// call, the vertex shader fetches the widget data by the index stored in the
+// vertices. The per widget mode draws one quad per widget through uniforms and
+// is kept around for comparison.
+// The retained render mode keeps the GUI in a cached layer texture. Changed
+// widgets mark their old and new rectangles dirty, only the dirty rectangles
+// are cleared and redrawn with the batched path, and the layer is composited
+// over the scene with a single blended quad. A frame without any change skips
+// the GUI redraw entirely. The layer is stored with premultiplied alpha.
+// Other quads, such as text, are drawn through the same batch with RenderQuads,
+// a quad is its position and size followed by the atlas rectangle of its image.
+// Mouse events are resolved through a uniform grid over the widget rectangles,
+// a hover or click only tests the widgets of the cell under the cursor.
 class GUIManager
 {
 
 public:
 
+	// Public constants, floats per quad passed to RenderQuads
+	static const BIT_UINT32 QuadSize = 8;
+
+	// Public enums
+	enum eRenderMode
+	{
+		Render_Batched = 0,
+		Render_PerWidget = 1,
+		Render_Retained = 2
+	};
+
 	// Construtor/destructor
 	GUIManager( Bit::GraphicDevice * p_pGraphicDevice );
 	~GUIManager( );
@@ -47,41 +84,142 @@ public:
 	void Unload( );
 	BIT_UINT32 Update( Bit::Event & p_Event );
 	void Render( );
-	BIT_UINT32 Add( const GUICheckbox * p_pCheckbox );
+	BIT_UINT32 Add( GUICheckbox * p_pCheckbox );
 	BIT_UINT32 Add( const GUISlider * p_pSlider );
-	BIT_UINT32 Remove( const GUICheckbox * p_pCheckbox );
+	BIT_UINT32 Remove( GUICheckbox * p_pCheckbox );
 	BIT_UINT32 Remove( const GUISlider * p_pSlider );
+	BIT_UINT32 AddImage( const Bit::Vector2_ui32 p_Size, const BIT_UINT8 * p_pPixels, BIT_UINT32 & p_Index );
+	void RenderQuads( const BIT_FLOAT32 * p_pQuads, const BIT_UINT32 p_Count );
+	void InvalidateLayer( );
+	void ResetLayerStatistics( );
 
 	// Set functions
 	void SetCheckboxImagePath( const std::string p_FilePath );
 	void SetSliderImagePath( const std::string p_FilePath );
+	void SetRenderMode( const eRenderMode p_Mode );
+	void SetClickButton( const BIT_UINT32 p_Button );
 
 	// Get functions
 	std::string GetCheckboxImagePath( ) const;
 	std::string GetSliderImagePath( ) const;
+	eRenderMode GetRenderMode( ) const;
+	BIT_UINT32 GetDrawCallCount( ) const;
+	BIT_FLOAT64 GetRenderTime( ) const;
+	BIT_UINT32 GetAtlasPageCount( ) const;
+	const AtlasPacker::Region & GetImageRegion( const BIT_UINT32 p_Index ) const;
+	const BIT_FLOAT32 * GetImageRect( const BIT_UINT32 p_Index ) const;
+	GUICheckbox * GetCheckboxAt( const Bit::Vector2_si32 p_Position ) const;
+	GUICheckbox * GetHoveredCheckbox( ) const;
+	const WidgetGrid & GetGrid( ) const;
+	BIT_UINT32 GetRedrawFrameCount( ) const;
+	BIT_UINT32 GetSkippedFrameCount( ) const;
+	BIT_UINT32 GetRedrawnWidgetCount( ) const;
 
 private:
 
+	// Linked checkboxes report their changes
+	friend class GUICheckbox;
+
+	// Private enums, the built in widget images
+	enum eWidgetImage
+	{
+		Image_CheckboxOff = 0,
+		Image_CheckboxOn = 1,
+		Image_SliderTrack = 2,
+		Image_SliderKnob = 3,
+		Image_Count = 4
+	};
+
+	// Private structs
+	struct AtlasImage
+	{
+		AtlasPacker::Region Region;
+		BIT_FLOAT32 Rect[ 4 ];	// Page + offset, size in texture coordinates
+	};
+
+	struct AtlasPage
+	{
+		Bit::Texture * pTexture;
+		std::vector< BIT_UINT8 > Pixels;	// RGBA, level 0 only
+		BIT_BOOL Modified;
+	};
+
+	struct DirtyRect
+	{
+		Bit::Vector2_si32 Position;
+		Bit::Vector2_ui32 Size;
+	};
+
 	// Private functions
 	BIT_UINT32 LoadVertexObject( );
+	BIT_UINT32 LoadBatchVertexObject( const BIT_UINT32 p_Capacity );
+	BIT_UINT32 LoadWidgetTexture( const BIT_UINT32 p_Capacity );
 	BIT_UINT32 LoadShaders( );
 	BIT_UINT32 LoadTextures( );
+	BIT_UINT32 LoadAtlasPage( );
+	BIT_UINT32 LoadLayer( );
+	BIT_UINT32 PackImage( const Bit::Vector2_ui32 p_Size, const BIT_UINT8 * p_pPixels, BIT_UINT32 & p_Index );
+	void UploadAtlasPages( );
+	void BindAtlasPages( ) const;
+	BIT_UINT32 ReserveBatch( const BIT_UINT32 p_Count );
+	void DrawBatch( const BIT_UINT32 p_Count, const BIT_UINT32 p_Key );
+	void RenderBatched( const std::vector< GUICheckbox * > & p_Checkboxes, const BIT_UINT32 p_Key );
+	void RenderPerWidget( );
+	void RenderRetained( );
+	void RenderLayer( );
+	void MarkDirty( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size );
+	void OnCheckboxChanged( GUICheckbox * p_pCheckbox, const Bit::Vector2_si32 p_OldPosition, const Bit::Vector2_ui32 p_OldSize );
+	Bit::Vector2_si32 GetCursorPosition( const Bit::Event & p_Event ) const;
+
+	// Static functions
+	static void SetupProgram( ShaderPermutations::Permutation & p_Permutation, void * p_pUserData );
 	
 	// Private variables
 	BIT_BOOL m_Loaded;
 	Bit::GraphicDevice * m_pGraphicDevice;
 	Bit::VertexObject * m_pVertexObject;
-	Bit::ShaderProgram * m_pShaderProgram;
-	Bit::Shader * m_pVertexShader;
-	Bit::Shader * m_pFragmentShader;
 	std::string m_CheckboxImagePath;
 	std::string m_SliderImagePath;
-	std::vector< const GUICheckbox * > m_Checkboxes;
+	std::vector< GUICheckbox * > m_Checkboxes;
 	std::vector< const GUISlider * > m_Sliders;
 	BIT_BOOL m_ButtonIsPressed;
 
-	// Private render variables
+	// Private input variables, the grid ids index the checkbox list
+	WidgetGrid m_Grid;
+	std::vector< GUICheckbox * > m_GridCheckboxes;
+	Bit::Vector2_ui32 m_ViewportSize;
+	GUICheckbox * m_pHoveredCheckbox;
+	GUICheckbox * m_pPressedCheckbox;
+	BIT_UINT32 m_ClickButton;
+
+	// Private render variables, the batch capacity grows by doubling
+	ShaderPermutations * m_pPermutations;
+	BIT_UINT32 m_BatchedFeature;
+	BIT_UINT32 m_PremultipliedFeature;
+	Bit::Matrix4x4 m_ProjectionMatrix;
+	AtlasPacker m_AtlasPacker;
+	std::vector< AtlasPage > m_AtlasPages;
+	std::vector< AtlasImage > m_Images;
+	BIT_UINT32 m_WidgetImages[ Image_Count ];
+	Bit::Texture * m_pWidgetTexture;
+	Bit::VertexObject * m_pBatchVertexObject;
+	BIT_UINT32 m_BatchCapacity;
+	std::vector< BIT_FLOAT32 > m_WidgetData;
+	eRenderMode m_RenderMode;
+	BIT_UINT32 m_DrawCallCount;
+	BIT_FLOAT64 m_RenderTime;
+
+	// Private layer variables, the layer is created the first time it's used
+	Bit::Texture * m_pLayerTexture;
+	Bit::Framebuffer * m_pLayerFramebuffer;
+	BIT_BOOL m_LayerValid;
+	std::vector< DirtyRect > m_DirtyRects;
+	std::vector< BIT_UINT32 > m_DirtyIds;
+	std::vector< GUICheckbox * > m_DirtyCheckboxes;
+	BIT_UINT32 m_RedrawFrameCount;
+	BIT_UINT32 m_SkippedFrameCount;
+	BIT_UINT32 m_RedrawnWidgetCount;
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,168 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __LIGHT_CLUSTER_GRID_HPP__
+#define __LIGHT_CLUSTER_GRID_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/Graphics/GraphicDevice.hpp>
+#include <Bit/Graphics/Texture.hpp>
+#include <Bit/System/MatrixManager.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <PointLightSet.hpp>
+#include <WorkerThread.hpp>
+#include <EventWaiter.hpp>
+#include <vector>
+
+// Clustered light list for forward shading.
+// The view frustum is split into a grid of screen tiles and exponential depth
+// slices. Every frame the lights are assigned to the clusters on the CPU, the
+// depth slices are spread over a few persistent worker threads and each cluster is tested
+// against four lights at a time. The assignment and the upload are skipped
+// while the light set and the version of the matrices stay the same. The result is uploaded as float textures:
+//  - Light texture, 2 x MaxLights: world position and radius, color.
+//  - Cluster texture, GridX * GridY x GridZ: offset and count in the index list.
+//  - Index texture, 1024 x N: four light indices per texel.
+class LightClusterGrid
+{
+
+public:
+
+	// Public constants
+	static const BIT_UINT32 IndexTextureWidth = 1024;
+
+	// Constructor/destructor
+	LightClusterGrid( Bit::GraphicDevice * p_pGraphicDevice );
+	~LightClusterGrid( );
+
+	// Public functions
+	BIT_UINT32 Load( const BIT_UINT32 p_GridX, const BIT_UINT32 p_GridY, const BIT_UINT32 p_GridZ,
+		const BIT_UINT32 p_MaxLights, const BIT_UINT32 p_MaxIndices, const BIT_UINT32 p_ThreadCount = 0 );
+	void Unload( );
+	void Assign( const PointLightSet & p_Lights, const Bit::Matrix4x4 & p_ViewMatrix,
+		const Bit::Matrix4x4 & p_ProjectionMatrix, const BIT_UINT32 p_MatrixVersion = 0 );
+	void Upload( const PointLightSet & p_Lights );
+	void Bind( const BIT_UINT32 p_LightUnit, const BIT_UINT32 p_ClusterUnit, const BIT_UINT32 p_IndexUnit ) const;
+
+	// Get functions
+	BIT_UINT32 GetGridX( ) const;
+	BIT_UINT32 GetGridY( ) const;
+	BIT_UINT32 GetGridZ( ) const;
+	BIT_UINT32 GetThreadCount( ) const;
+	BIT_UINT32 GetIndexCount( ) const;
+	BIT_BOOL GetOverflow( ) const;
+	BIT_FLOAT32 GetNear( ) const;
+	BIT_FLOAT32 GetFar( ) const;
+	BIT_FLOAT64 GetAssignTime( ) const;
+	BIT_FLOAT64 GetUploadTime( ) const;
+	BIT_UINT32 GetAssignSkipCount( ) const;
+	BIT_UINT32 GetUploadSkipCount( ) const;
+
+private:
+
+	// Private structs
+	struct Cluster
+	{
+		BIT_FLOAT32 Min[ 3 ];
+		BIT_FLOAT32 Max[ 3 ];
+		BIT_UINT32 Offset;
+		BIT_UINT32 Count;
+	};
+
+	struct ThreadData
+	{
+		std::vector< BIT_UINT32 > Indices;
+		std::vector< BIT_UINT32 > SliceLights;
+		std::vector< BIT_FLOAT32 > X;
+		std::vector< BIT_FLOAT32 > Y;
+		std::vector< BIT_FLOAT32 > Z;
+		std::vector< BIT_FLOAT32 > Radius;
+	};
+
+	// Worker thread assigning a fixed range of depth slices, woken once per assignment
+	struct Worker
+	{
+		WorkerThread Thread;
+		EventWaiter StartWaiter;
+		EventWaiter DoneWaiter;
+		LightClusterGrid * pGrid;
+		BIT_UINT32 Index;
+	};
+
+	// Private functions
+	void CalculateClusterBounds( const Bit::Matrix4x4 & p_ProjectionMatrix );
+	void AssignSlices( const BIT_UINT32 p_Thread, const BIT_UINT32 p_FirstSlice, const BIT_UINT32 p_EndSlice );
+	BIT_UINT32 LoadTexture( Bit::Texture ** p_ppTexture, const Bit::Vector2_ui32 p_Size );
+
+	// Static functions
+	static void WorkerFunction( void * p_pWorker );
+
+	// Private variables
+	BIT_BOOL m_Loaded;
+	Bit::GraphicDevice * m_pGraphicDevice;
+	BIT_UINT32 m_GridX;
+	BIT_UINT32 m_GridY;
+	BIT_UINT32 m_GridZ;
+	BIT_UINT32 m_MaxLights;
+	BIT_UINT32 m_MaxIndices;
+	BIT_UINT32 m_IndexCount;
+	BIT_BOOL m_Overflow;
+	BIT_FLOAT32 m_Near;
+	BIT_FLOAT32 m_Far;
+	Bit::Matrix4x4 m_ProjectionMatrix;
+	std::vector< Cluster > m_Clusters;
+	std::vector< ThreadData > m_Threads;
+	std::vector< Worker * > m_Workers;
+	BIT_BOOL m_QuitWorkers;
+	BIT_FLOAT64 m_AssignTime;
+	BIT_FLOAT64 m_UploadTime;
+
+	// Inputs of the last assignment and upload, a matrix version of 0 is never cached
+	const PointLightSet * m_pAssignedLights;
+	BIT_UINT32 m_AssignedLightVersion;
+	BIT_UINT32 m_AssignedMatrixVersion;
+	BIT_UINT32 m_AssignCount;
+	BIT_UINT32 m_UploadedLightVersion;
+	BIT_UINT32 m_UploadedAssignCount;
+	BIT_UINT32 m_AssignSkipCount;
+	BIT_UINT32 m_UploadSkipCount;
+
+	// View space lights, padded to a multiple of four
+	std::vector< BIT_FLOAT32 > m_LightX;
+	std::vector< BIT_FLOAT32 > m_LightY;
+	std::vector< BIT_FLOAT32 > m_LightZ;
+	std::vector< BIT_FLOAT32 > m_LightRadius;
+
+	// Upload data and textures
+	std::vector< BIT_FLOAT32 > m_LightData;
+	std::vector< BIT_FLOAT32 > m_ClusterData;
+	std::vector< BIT_FLOAT32 > m_IndexData;
+	Bit::Texture * m_pLightTexture;
+	Bit::Texture * m_pClusterTexture;
+	Bit::Texture * m_pIndexTexture;
+
+};
+
+#endif
@@ -0,0 +1,114 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __MATH_KERNELS_HPP__
+#define __MATH_KERNELS_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Vector3.hpp>
+#include <Bit/System/MatrixManager.hpp>
+#include <Frustum.hpp>
+#include <CpuFeatures.hpp>
+#include <vector>
+
+// Structure of arrays of 3D vectors, the batched counterpart of Bit::Vector3_f32.
+// Every component array is padded with zeros to a multiple of eight,
+// so the kernels never need a scalar tail.
+class Vector3Array
+{
+
+public:
+
+	// Public constants
+	static const BIT_UINT32 Padding = 8;
+
+	// Constructor
+	Vector3Array( );
+	Vector3Array( const BIT_UINT32 p_Count );
+
+	// Public functions
+	void Resize( const BIT_UINT32 p_Count );
+
+	// Set functions
+	void Set( const BIT_UINT32 p_Index, const Bit::Vector3_f32 & p_Vector );
+
+	// Get functions
+	Bit::Vector3_f32 Get( const BIT_UINT32 p_Index ) const;
+	BIT_UINT32 GetCount( ) const;
+	BIT_UINT32 GetPaddedCount( ) const;
+	BIT_FLOAT32 * GetX( );
+	BIT_FLOAT32 * GetY( );
+	BIT_FLOAT32 * GetZ( );
+	const BIT_FLOAT32 * GetX( ) const;
+	const BIT_FLOAT32 * GetY( ) const;
+	const BIT_FLOAT32 * GetZ( ) const;
+
+private:
+
+	// Private variables
+	BIT_UINT32 m_Count;
+	std::vector< BIT_FLOAT32 > m_X;
+	std::vector< BIT_FLOAT32 > m_Y;
+	std::vector< BIT_FLOAT32 > m_Z;
+
+};
+
+// Batched math on vector arrays, four lanes with SSE2 and eight with AVX2.
+// The instruction set is picked at startup from CPUID and can be overridden,
+// the results are bit-exact with the scalar operations on Bit::Vector3_f32
+// since every path uses the same operations in the same order and no FMA.
+// Output arrays are resized to the input count, the padding is computed too.
+class MathKernels
+{
+
+public:
+
+	// Public functions, a . b, a x b and v / |v| (zero vectors are kept)
+	static void Dot( const Vector3Array & p_A, const Vector3Array & p_B, std::vector< BIT_FLOAT32 > & p_Result );
+	static void Cross( const Vector3Array & p_A, const Vector3Array & p_B, Vector3Array & p_Result );
+	static void Normalize( Vector3Array & p_Vectors );
+
+	// Points transformed by a column major matrix, w = 1
+	static void TransformPoints( const Bit::Matrix4x4 & p_Matrix, const Vector3Array & p_Points, Vector3Array & p_Result );
+
+	// Axis aligned boxes transformed by a matrix, the result is the box around the transformed box (Arvo)
+	static void TransformBoxes( const Bit::Matrix4x4 & p_Matrix, const Vector3Array & p_Min, const Vector3Array & p_Max,
+		Vector3Array & p_ResultMin, Vector3Array & p_ResultMax );
+
+	// Frustum tests, 1 for every sphere/box intersecting the frustum and 0 for the rest
+	static void TestSpheres( const Frustum & p_Frustum, const Vector3Array & p_Centers, const std::vector< BIT_FLOAT32 > & p_Radii,
+		std::vector< BIT_UINT8 > & p_Result );
+	static void TestBoxes( const Frustum & p_Frustum, const Vector3Array & p_Min, const Vector3Array & p_Max,
+		std::vector< BIT_UINT8 > & p_Result );
+
+	// Set functions, fails if the CPU doesn't support the instruction set
+	static BIT_UINT32 SetInstructionSet( const CpuFeatures::eInstructionSet p_InstructionSet );
+
+	// Get functions
+	static CpuFeatures::eInstructionSet GetInstructionSet( );
+
+};
+
+#endif
@@ -0,0 +1,45 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __OPENGL_HPP__
+#define __OPENGL_HPP__
+
+#include <Bit/DataTypes.hpp>
+
+// Plain OpenGL 1.1 for the few states the graphic device doesn't expose
+// (depth function/mask, color mask, blend function and read backs).
+// Windows.h is left out on purpose, its CreateWindow macro clashes with the examples.
+#ifdef BIT_PLATFORM_WINDOWS
+	#ifndef APIENTRY
+		#define APIENTRY __stdcall
+	#endif
+	#ifndef WINGDIAPI
+		#define WINGDIAPI __declspec( dllimport )
+	#endif
+#endif
+
+#include <GL/gl.h>
+
+#endif
@@ -0,0 +1,128 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __PERFORMANCE_HUD_HPP__
+#define __PERFORMANCE_HUD_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <GUIManager.hpp>
+#include <TextRenderer.hpp>
+#include <RenderGraph.hpp>
+#include <vector>
+
+// On-screen performance overlay, a frame time graph over the last frames,
+// the CPU and GPU time of every render graph pass and the frame counters.
+// Frame times are recorded even while the overlay is hidden. The panel, the
+// graph bars, the pass bars and the text are laid out into a single quad list
+// and drawn through the GUI manager with one call. The GPU times of the passes
+// are only known while the timing of the render graph is enabled.
+class PerformanceHUD
+{
+
+public:
+
+	// Public constants
+	static const BIT_UINT32 HistorySize = 240;
+
+	// Public structs, counted by the application during the frame
+	struct Counters
+	{
+		Counters( );
+
+		BIT_UINT32 DrawCalls;
+		BIT_UINT32 Triangles;
+		BIT_UINT32 Binds;
+		BIT_UINT32 Memory;	// Bytes
+	};
+
+	// Constructor/destructor
+	PerformanceHUD( GUIManager * p_pManager, TextRenderer * p_pText );
+	~PerformanceHUD( );
+
+	// Public functions
+	BIT_UINT32 Load( );
+	void Unload( );
+	void Update( const BIT_FLOAT64 p_FrameTime, const Counters & p_Counters, const RenderGraph * p_pRenderGraph );
+	void Render( );
+
+	// Set functions
+	void SetVisible( const BIT_BOOL p_Visible );
+	void SetPosition( const Bit::Vector2_si32 p_Position );
+	void SetTargetFrameTime( const BIT_FLOAT32 p_FrameTime );
+
+	// Get functions
+	BIT_BOOL GetVisible( ) const;
+	BIT_FLOAT64 GetAverageFrameTime( ) const;
+	BIT_FLOAT64 GetMaxFrameTime( ) const;
+	BIT_FLOAT64 GetCost( ) const;
+
+private:
+
+	// Private enums, the solid color images
+	enum eColor
+	{
+		Color_Panel = 0,
+		Color_Good = 1,
+		Color_Warning = 2,
+		Color_Bad = 3,
+		Color_Cpu = 4,
+		Color_Gpu = 5,
+		Color_Line = 6,
+		Color_Count = 7
+	};
+
+	// Private functions
+	void AddRect( const BIT_FLOAT32 p_X, const BIT_FLOAT32 p_Y, const BIT_FLOAT32 p_Width, const BIT_FLOAT32 p_Height,
+		const eColor p_Color );
+	void AddText( const BIT_SINT32 p_X, const BIT_SINT32 p_Y, const char * p_pText );
+	void Reserve( const BIT_UINT32 p_Count );
+
+	// Private variables
+	BIT_BOOL m_Loaded;
+	BIT_BOOL m_Visible;
+	GUIManager * m_pManager;
+	TextRenderer * m_pText;
+	const RenderGraph * m_pRenderGraph;
+	Bit::Vector2_si32 m_Position;
+	BIT_FLOAT32 m_TargetFrameTime;
+	BIT_FLOAT32 m_ColorRects[ Color_Count ][ 4 ];
+
+	// Frame history, a ring buffer with the sum kept up to date
+	BIT_FLOAT32 m_History[ HistorySize ];
+	BIT_UINT32 m_HistoryIndex;
+	BIT_UINT32 m_HistoryCount;
+	BIT_FLOAT64 m_HistorySum;
+	Counters m_Counters;
+
+	// Quad list kept between frames, the cost is the time of the last update and render
+	std::vector< BIT_FLOAT32 > m_Quads;
+	BIT_UINT32 m_QuadCount;
+	BIT_FLOAT64 m_UpdateCost;
+	BIT_FLOAT64 m_Cost;
+
+};
+
+#endif
@@ -0,0 +1,78 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __POINT_LIGHT_SET_HPP__
+#define __POINT_LIGHT_SET_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Vector3.hpp>
+#include <vector>
+
+// Point light in world space.
+struct PointLight
+{
+	BIT_FLOAT32 Position[ 3 ];
+	BIT_FLOAT32 Radius;
+	BIT_FLOAT32 Color[ 3 ];
+	BIT_FLOAT32 Phase;
+};
+
+// Set of randomly placed point lights bobbing up and down.
+// The lights are generated from a seed, so every run and every
+// lighting path sees the exact same scene. The version is bumped
+// whenever the lights change, so derived data can be cached.
+class PointLightSet
+{
+
+public:
+
+	// Constructor
+	PointLightSet( );
+
+	// Public functions
+	void Generate( const BIT_UINT32 p_Count, const Bit::Vector3_f32 p_Min, const Bit::Vector3_f32 p_Max,
+		const BIT_FLOAT32 p_MinRadius, const BIT_FLOAT32 p_MaxRadius, const BIT_UINT32 p_Seed );
+	void Update( const BIT_FLOAT64 p_Time );
+
+	// Get functions
+	BIT_UINT32 GetCount( ) const;
+	const PointLight & GetLight( const BIT_UINT32 p_Index ) const;
+	const PointLight * GetLights( ) const;
+	BIT_UINT32 GetVersion( ) const;
+
+private:
+
+	// Private functions
+	BIT_FLOAT32 Random( const BIT_FLOAT32 p_Min, const BIT_FLOAT32 p_Max );
+
+	// Private variables
+	std::vector< PointLight > m_Lights;
+	std::vector< BIT_FLOAT32 > m_Heights;
+	BIT_UINT32 m_RandomState;
+	BIT_UINT32 m_Version;
+
+};
+
+#endif
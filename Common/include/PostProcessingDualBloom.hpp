@@ -0,0 +1,154 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __POST_PROCESSING_DUAL_BLOOM_HPP__
+#define __POST_PROCESSING_DUAL_BLOOM_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/Graphics/GraphicDevice.hpp>
+#include <Bit/Graphics/ShaderProgram.hpp>
+#include <Bit/Graphics/Framebuffer.hpp>
+#include <Bit/Graphics/Texture.hpp>
+#include <Bit/Graphics/VertexObject.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <RenderGraph.hpp>
+#include <ShaderPermutations.hpp>
+#include <vector>
+#include <string>
+
+// Dual filter (Kawase) bloom.
+// The bright parts of the color texture are downsampled through a chain of
+// half sized render targets and upsampled back again. Every tap sits between
+// texels so the bilinear filter averages four texels per fetch.
+// Load it without render targets and call AddPasses( ) to let a render graph
+// own the chain instead. A disabled bloom skips the chain and composites with
+// a variant of the shader that only copies the color.
+// The color can cover only a part of its texture (dynamic resolution), the first
+// downsample and the composite read that region and the composite stretches it
+// over the output.
+class PostProcessingDualBloom
+{
+
+public:
+
+	// Constructor/destructor
+	PostProcessingDualBloom( Bit::GraphicDevice * p_pGraphicDevice, Bit::VertexObject * p_pVertexObject,
+		Bit::Texture * p_pColorTexture );
+	~PostProcessingDualBloom( );
+
+	// Public functions
+	BIT_UINT32 Load( const Bit::Vector2_ui32 p_Size, const BIT_UINT32 p_Levels,
+		const BIT_FLOAT32 p_Threshold, const BIT_FLOAT32 p_Intensity, const BIT_BOOL p_CreateTargets = BIT_TRUE );
+	void Unload( );
+	void Process( );
+	void AddPasses( RenderGraph & p_Graph, const BIT_UINT32 p_ColorTexture, const BIT_BOOL p_Composite );
+
+	// Set functions
+	void SetThreshold( const BIT_FLOAT32 p_Threshold );
+	void SetIntensity( const BIT_FLOAT32 p_Intensity );
+	void SetEnabled( const BIT_BOOL p_Status );
+	void SetSourceSize( const Bit::Vector2_ui32 p_Size );
+	void SetSourceScale( const Bit::Vector2_f32 p_Scale );
+
+	// Get functions
+	BIT_UINT32 GetLevelCount( ) const;
+	BIT_FLOAT32 GetThreshold( ) const;
+	BIT_FLOAT32 GetIntensity( ) const;
+	BIT_BOOL GetEnabled( ) const;
+	Bit::Vector2_f32 GetSourceScale( ) const;
+	BIT_UINT32 GetTextureMemory( ) const;
+
+private:
+
+	// Private enums
+	enum ePassType
+	{
+		Pass_Downsample = 0,
+		Pass_Upsample = 1,
+		Pass_Composite = 2
+	};
+
+	// Private structs
+	struct GraphPass
+	{
+		PostProcessingDualBloom * pBloom;
+		ePassType Type;
+		BIT_UINT32 Level;
+		BIT_UINT32 Source;
+		BIT_UINT32 Color;
+		Bit::Vector2_ui32 SourceSize;
+	};
+
+	struct Level
+	{
+		Bit::Vector2_ui32 Size;
+		Bit::Texture * pDownTexture;
+		Bit::Framebuffer * pDownFramebuffer;
+		Bit::Texture * pUpTexture;
+		Bit::Framebuffer * pUpFramebuffer;
+	};
+
+	// Private functions
+	BIT_UINT32 LoadLevels( );
+	BIT_UINT32 LoadShaders( );
+	BIT_UINT32 LoadProgram( const std::string & p_FragmentSource, Bit::ShaderProgram ** p_ppShaderProgram,
+		Bit::Shader ** p_ppFragmentShader );
+	BIT_UINT32 LoadTarget( const Bit::Vector2_ui32 p_Size, Bit::Texture ** p_ppTexture, Bit::Framebuffer ** p_ppFramebuffer );
+	void RenderPass( Bit::ShaderProgram * p_pShaderProgram, Bit::Texture * p_pSource, const Bit::Vector2_ui32 p_SourceSize,
+		const Bit::Vector2_ui32 p_TargetSize );
+	void RenderComposite( Bit::Texture * p_pColor, Bit::Texture * p_pBloom );
+
+	// Static functions
+	static void ExecuteGraphPass( RenderGraph & p_Graph, void * p_pUserData );
+	static void SetupCompositeProgram( ShaderPermutations::Permutation & p_Permutation, void * p_pUserData );
+
+	// Private variables
+	BIT_BOOL m_Loaded;
+	Bit::GraphicDevice * m_pGraphicDevice;
+	Bit::VertexObject * m_pVertexObject;
+	Bit::Texture * m_pColorTexture;
+	Bit::Vector2_ui32 m_Size;
+	Bit::Vector2_ui32 m_SourceSize;
+	Bit::Vector2_f32 m_SourceScale;
+	BIT_UINT32 m_LevelCount;
+	BIT_FLOAT32 m_Threshold;
+	BIT_FLOAT32 m_Intensity;
+	BIT_BOOL m_Enabled;
+	BIT_BOOL m_CreateTargets;
+	std::vector< Level > m_Levels;
+	std::vector< GraphPass > m_GraphPasses;
+
+	// Shaders
+	Bit::Shader * m_pVertexShader;
+	Bit::Shader * m_pDownsampleShader;
+	Bit::Shader * m_pUpsampleShader;
+	Bit::ShaderProgram * m_pDownsampleProgram;
+	Bit::ShaderProgram * m_pUpsampleProgram;
+	ShaderPermutations * m_pCompositePermutations;
+	BIT_UINT32 m_BloomFeature;
+
+};
+
+#endif
@@ -0,0 +1,169 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __RENDER_GRAPH_HPP__
+#define __RENDER_GRAPH_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/Graphics/GraphicDevice.hpp>
+#include <Bit/Graphics/Framebuffer.hpp>
+#include <Bit/Graphics/Texture.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <vector>
+#include <string>
+
+// Frame described as passes reading and writing textures.
+// Compile( ) culls the passes that don't contribute to a pass with side effects
+// (e.g. rendering to the default framebuffer), works out the read after write
+// barriers and lets transient textures with disjoint lifetimes share memory.
+class RenderGraph
+{
+
+public:
+
+	// Public enums
+	enum eFormat
+	{
+		Format_RGB8 = 0,
+		Format_RGBA8 = 1,
+		Format_RGBA32F = 2,
+		Format_Depth32F = 3
+	};
+
+	// Public structs
+	struct TextureDescription
+	{
+		TextureDescription( );
+		TextureDescription( const Bit::Vector2_ui32 p_Size, const eFormat p_Format, const BIT_BOOL p_Linear );
+		BIT_BOOL operator == ( const TextureDescription & p_Description ) const;
+		BIT_UINT32 GetMemory( ) const;
+
+		Bit::Vector2_ui32 Size;
+		eFormat Format;
+		BIT_BOOL Linear;
+	};
+
+	// Public typedefs
+	typedef void ( * ExecuteFunction )( RenderGraph & p_Graph, void * p_pUserData );
+
+	// Public constants
+	static const BIT_UINT32 InvalidHandle = 0xFFFFFFFF;
+
+	// Constructor/destructor
+	RenderGraph( Bit::GraphicDevice * p_pGraphicDevice, const Bit::Vector2_ui32 p_BackbufferSize );
+	~RenderGraph( );
+
+	// Setup functions
+	BIT_UINT32 CreateTexture( const std::string & p_Name, const TextureDescription & p_Description );
+	BIT_UINT32 ImportTexture( const std::string & p_Name, Bit::Texture * p_pTexture, const TextureDescription & p_Description );
+	BIT_UINT32 AddPass( const std::string & p_Name, ExecuteFunction p_Function, void * p_pUserData,
+		const BIT_BOOL p_SideEffect = BIT_FALSE );
+	void Read( const BIT_UINT32 p_Pass, const BIT_UINT32 p_Texture );
+	void Write( const BIT_UINT32 p_Pass, const BIT_UINT32 p_Texture );
+
+	// Public functions
+	BIT_UINT32 Compile( );
+	void Execute( );
+	void Reset( );
+	void PrintStatistics( ) const;
+	void ResetTimings( );
+	void PrintTimings( ) const;
+
+	// Set functions
+	void SetTimingEnabled( const BIT_BOOL p_Status );
+
+	// Get functions
+	Bit::Texture * GetTexture( const BIT_UINT32 p_Texture ) const;
+	BIT_BOOL IsCompiled( ) const;
+	BIT_UINT32 GetPassCount( ) const;
+	BIT_UINT32 GetCulledPassCount( ) const;
+	BIT_UINT32 GetBarrierCount( ) const;
+	BIT_UINT32 GetPhysicalTextureCount( ) const;
+	BIT_UINT32 GetPeakMemory( ) const;
+	BIT_UINT32 GetUnaliasedMemory( ) const;
+	BIT_BOOL GetTimingEnabled( ) const;
+	BIT_FLOAT64 GetPassTime( const BIT_UINT32 p_Pass ) const;
+	BIT_FLOAT64 GetPassCpuTime( const BIT_UINT32 p_Pass ) const;
+	const std::string & GetPassName( const BIT_UINT32 p_Pass ) const;
+	BIT_BOOL IsPassCulled( const BIT_UINT32 p_Pass ) const;
+	BIT_FLOAT64 GetFrameTime( ) const;
+
+private:
+
+	// Private structs
+	struct Resource
+	{
+		std::string Name;
+		TextureDescription Description;
+		Bit::Texture * pTexture;
+		BIT_BOOL Imported;
+		BIT_SINT32 FirstPass;
+		BIT_SINT32 LastPass;
+	};
+
+	struct Pass
+	{
+		std::string Name;
+		ExecuteFunction Function;
+		void * pUserData;
+		BIT_BOOL SideEffect;
+		BIT_BOOL Culled;
+		std::vector< BIT_UINT32 > Reads;
+		std::vector< BIT_UINT32 > Writes;
+		std::vector< BIT_UINT32 > Barriers;
+		Bit::Framebuffer * pFramebuffer;
+		BIT_FLOAT64 Time;
+		BIT_FLOAT64 CpuTime;	// Last frame, without waiting for the GPU
+	};
+
+	struct PhysicalTexture
+	{
+		TextureDescription Description;
+		Bit::Texture * pTexture;
+		BIT_SINT32 LastPass;
+	};
+
+	// Private functions
+	void CullPasses( );
+	void CalculateLifetimes( );
+	void CalculateBarriers( );
+	BIT_UINT32 AllocateTextures( );
+	BIT_UINT32 CreateFramebuffers( );
+	Bit::Texture * CreatePhysicalTexture( const TextureDescription & p_Description );
+
+	// Private variables
+	Bit::GraphicDevice * m_pGraphicDevice;
+	Bit::Vector2_ui32 m_BackbufferSize;
+	BIT_BOOL m_Compiled;
+	BIT_BOOL m_TimingEnabled;
+	BIT_UINT32 m_TimedFrames;
+	BIT_FLOAT64 m_FrameTime;
+	std::vector< Resource > m_Resources;
+	std::vector< Pass > m_Passes;
+	std::vector< PhysicalTexture > m_PhysicalTextures;
+
+};
+
+#endif
@@ -0,0 +1,149 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __RESAMPLER_HPP__
+#define __RESAMPLER_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <CpuFeatures.hpp>
+#include <vector>
+
+// Table of windowed sinc filters, one row of taps for every phase between two input frames.
+// The table doesn't change while resampling, several resamplers can share it.
+class ResamplerFilter
+{
+
+public:
+
+	// Public enums, more taps cost more but keep more of the top octave and alias less
+	enum eQuality
+	{
+		Quality_Low = 0,	// 8 taps, 64 phases
+		Quality_Medium = 1,	// 16 taps, 128 phases
+		Quality_High = 2	// 32 taps, 256 phases
+	};
+
+	// Constructor
+	ResamplerFilter( );
+
+	// Public functions, the cutoff is relative to the input Nyquist frequency.
+	// Downsampling by a step of s needs a cutoff of 1 / s or less.
+	BIT_UINT32 Create( const eQuality p_Quality, const BIT_FLOAT32 p_Cutoff );
+
+	// Get functions
+	BIT_BOOL IsCreated( ) const;
+	eQuality GetQuality( ) const;
+	BIT_FLOAT32 GetCutoff( ) const;
+	BIT_UINT32 GetTapCount( ) const;
+	BIT_UINT32 GetPhaseCount( ) const;
+	const BIT_FLOAT32 * GetCoefficients( ) const;
+
+	// Static functions
+	static const char * GetQualityName( const eQuality p_Quality );
+
+private:
+
+	// Private variables
+	std::vector< BIT_FLOAT32 > m_Coefficients;
+	eQuality m_Quality;
+	BIT_FLOAT32 m_Cutoff;
+	BIT_UINT32 m_TapCount;
+	BIT_UINT32 m_PhaseCount;
+
+};
+
+// Polyphase sample rate converter working on a stream.
+// Frames are written in as they come and read out at the new rate,
+// the output lags the input by half the tap count of the filter.
+// The step, input frames per output frame, may change between reads
+// which is how a voice changes its pitch.
+class Resampler
+{
+
+public:
+
+	// Constructor
+	Resampler( );
+
+	// Public functions.
+	// A stream buffers the tap count plus p_MaxWriteCount frames per channel and never grows after Open,
+	// frames written past that are dropped and counted. 0 lets the buffer grow, for converting a whole sound at once.
+	// Opening again with no more channels or taps than before reuses the buffers.
+	BIT_UINT32 Open( const ResamplerFilter * p_pFilter, const BIT_UINT16 p_ChannelCount, const BIT_FLOAT64 p_Step,
+		const BIT_UINT32 p_MaxWriteCount = 0 );
+	void Reset( );
+
+	// Interleaved or one array per channel. The input is buffered until it has been read.
+	void Write( const BIT_FLOAT32 * p_pFrames, const BIT_UINT32 p_FrameCount );
+	void WritePlanar( const BIT_FLOAT32 * const * p_ppChannels, const BIT_UINT32 p_FrameCount );
+	void WriteSilence( const BIT_UINT32 p_FrameCount );
+
+	// Returns the frames read, fewer than asked for if more input is needed
+	BIT_UINT32 Read( BIT_FLOAT32 * p_pFrames, const BIT_UINT32 p_FrameCount );
+	BIT_UINT32 ReadPlanar( BIT_FLOAT32 * const * p_ppChannels, const BIT_UINT32 p_FrameCount );
+
+	// Set functions. A new filter must have as many taps as the old one.
+	BIT_UINT32 SetFilter( const ResamplerFilter * p_pFilter );
+	void SetStep( const BIT_FLOAT64 p_Step );
+	BIT_UINT32 SetInstructionSet( const CpuFeatures::eInstructionSet p_InstructionSet );
+
+	// Get functions
+	const ResamplerFilter * GetFilter( ) const;
+	BIT_FLOAT64 GetStep( ) const;
+	BIT_UINT16 GetChannelCount( ) const;
+	CpuFeatures::eInstructionSet GetInstructionSet( ) const;
+	BIT_UINT32 GetDroppedFrameCount( ) const;
+
+	// Input frames still to write before the given number of frames can be read
+	BIT_UINT32 GetInputFrameCount( const BIT_UINT32 p_OutputFrameCount ) const;
+
+	// Static functions, converts a whole sound at load time.
+	// The output is trimmed so it lines up with the input.
+	static BIT_UINT32 Convert( const BIT_FLOAT32 * p_pFrames, const BIT_UINT32 p_FrameCount, const BIT_UINT16 p_ChannelCount,
+		const BIT_UINT32 p_InputRate, const BIT_UINT32 p_OutputRate, const ResamplerFilter::eQuality p_Quality,
+		std::vector< BIT_FLOAT32 > & p_Output );
+
+private:
+
+	// Private functions
+	BIT_UINT32 GetReadableFrameCount( const BIT_UINT32 p_FrameCount ) const;
+	BIT_UINT32 Reserve( const BIT_UINT32 p_FrameCount );
+	void Consume( );
+
+	// Private variables
+	const ResamplerFilter * m_pFilter;
+	std::vector< std::vector< BIT_FLOAT32 > > m_Channels;
+	BIT_UINT16 m_ChannelCount;
+	BIT_UINT32 m_MaxWriteCount;
+	BIT_UINT32 m_Start;		// The buffered frames are the ones from m_Start up to m_End
+	BIT_UINT32 m_End;
+	BIT_UINT32 m_DroppedFrameCount;
+	BIT_UINT64 m_Position;	// 32.32 fixed point, in frames from m_Start
+	BIT_UINT64 m_Step;
+	CpuFeatures::eInstructionSet m_InstructionSet;
+
+};
+
+#endif
@@ -0,0 +1,109 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __SHADER_PERMUTATIONS_HPP__
+#define __SHADER_PERMUTATIONS_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/Graphics/GraphicDevice.hpp>
+#include <Bit/Graphics/Shader.hpp>
+#include <Bit/Graphics/ShaderProgram.hpp>
+#include <ShaderUniforms.hpp>
+#include <vector>
+#include <string>
+
+// Compile time variants of one vertex/fragment shader pair.
+// Every feature is a bit of the permutation key and a #define injected right
+// after the #version line of both sources, the shaders test them with #ifdef
+// instead of branching on uniforms. A variant is compiled the first time its
+// key is requested and cached for the rest of the run, so the key can be picked
+// on the CPU right before every draw.
+class ShaderPermutations
+{
+
+public:
+
+	// Public structs
+	struct Permutation
+	{
+		BIT_UINT32 Key;
+		Bit::Shader * pVertexShader;
+		Bit::Shader * pFragmentShader;
+		Bit::ShaderProgram * pShaderProgram;
+		ShaderUniforms * pUniforms;
+	};
+
+	// Called once for every new variant with its program bound, sets the uniforms that never change.
+	typedef void ( * SetupFunction )( Permutation & p_Permutation, void * p_pUserData );
+
+	// Constructor/destructor
+	ShaderPermutations( Bit::GraphicDevice * p_pGraphicDevice, const std::string & p_Name );
+	~ShaderPermutations( );
+
+	// Public functions
+	BIT_UINT32 AddFeature( const std::string & p_Define );
+	void AddAttribute( const std::string & p_Name, const BIT_UINT32 p_Location );
+	Permutation * Get( const BIT_UINT32 p_Key );
+	void Unload( );
+
+	// Set functions
+	void SetSources( const std::string & p_VertexSource, const std::string & p_FragmentSource );
+	void SetSetupFunction( SetupFunction p_Function, void * p_pUserData );
+
+	// Get functions
+	BIT_UINT32 GetFeatureCount( ) const;
+	BIT_UINT32 GetPermutationCount( ) const;
+	BIT_FLOAT64 GetCompileTime( ) const;
+	std::string GetDefines( const BIT_UINT32 p_Key ) const;
+
+private:
+
+	// Private structs
+	struct Attribute
+	{
+		std::string Name;
+		BIT_UINT32 Location;
+	};
+
+	// Private functions
+	BIT_UINT32 Compile( Permutation & p_Permutation );
+	std::string InjectDefines( const std::string & p_Source, const std::string & p_Defines ) const;
+
+	// Private variables
+	Bit::GraphicDevice * m_pGraphicDevice;
+	std::string m_Name;
+	std::string m_VertexSource;
+	std::string m_FragmentSource;
+	std::vector< std::string > m_Features;
+	std::vector< Attribute > m_Attributes;
+	std::vector< Permutation * > m_Permutations;
+	Permutation * m_pLastPermutation;
+	SetupFunction m_pSetupFunction;
+	void * m_pSetupUserData;
+	BIT_FLOAT64 m_CompileTime;
+
+};
+
+#endif
@@ -0,0 +1,134 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+#ifndef __SHADER_UNIFORMS_HPP__
+#define __SHADER_UNIFORMS_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/Graphics/ShaderProgram.hpp>
+#include <Bit/System/MatrixManager.hpp>
+#include <vector>
+
+// Uniform name with a precalculated hash.
+// Declare handles as static constants so the hash is only calculated once.
+class UniformHandle
+{
+
+public:
+
+	// Constructor
+	template< BIT_MEMSIZE Length >
+	UniformHandle( const char ( & p_Name )[ Length ] ) :
+		m_pName( p_Name ),
+		m_Hash( Hash( p_Name, Length - 1 ) )
+	{
+	}
+
+	// Get functions
+	const char * GetName( ) const
+	{
+		return m_pName;
+	}
+
+	BIT_UINT32 GetHash( ) const
+	{
+		return m_Hash;
+	}
+
+	// Static functions (FNV-1a)
+	static BIT_UINT32 Hash( const char * p_pName, const BIT_MEMSIZE p_Length )
+	{
+		BIT_UINT32 Hash = 2166136261U;
+		for( BIT_MEMSIZE i = 0; i < p_Length; i++ )
+		{
+			Hash = ( Hash ^ static_cast< BIT_UINT8 >( p_pName[ i ] ) ) * 16777619U;
+		}
+		return Hash;
+	}
+
+private:
+
+	// Private variables
+	const char * m_pName;
+	BIT_UINT32 m_Hash;
+
+};
+
+// Shadow copy of the uniform values of a shader program.
+// Values equal to the last uploaded ones never reach the driver.
+// The shader program only takes uniform names, so a changed value is still looked up by name.
+class ShaderUniforms
+{
+
+public:
+
+	// Public constants
+	static const BIT_UINT32 FrameBlockMemberCount = 8;
+
+	// Constructor/destructor
+	ShaderUniforms( Bit::ShaderProgram * p_pShaderProgram );
+	~ShaderUniforms( );
+
+	// Public functions, the shader program has to be bound.
+	void SetUniform1i( const UniformHandle & p_Handle, const BIT_SINT32 p_Value );
+	void SetUniform1f( const UniformHandle & p_Handle, const BIT_FLOAT32 p_Value );
+	void SetUniform2f( const UniformHandle & p_Handle, const BIT_FLOAT32 p_X, const BIT_FLOAT32 p_Y );
+	void SetUniform3f( const UniformHandle & p_Handle, const BIT_FLOAT32 p_X, const BIT_FLOAT32 p_Y, const BIT_FLOAT32 p_Z );
+	void SetUniformMatrix4x4f( const UniformHandle & p_Handle, const Bit::Matrix4x4 & p_Matrix );
+	void Invalidate( );
+	void ResetStatistics( );
+
+	// Set functions, the frame block version the program has seen of each member of the mask
+	void SetFrameBlockVersion( const BIT_UINT32 p_Members, const BIT_UINT32 p_Version );
+
+	// Get functions
+	Bit::ShaderProgram * GetShaderProgram( ) const;
+	BIT_UINT32 GetFrameBlockVersion( const BIT_UINT32 p_Member ) const;
+	BIT_UINT32 GetUploadCount( ) const;
+	BIT_UINT32 GetSkipCount( ) const;
+
+private:
+
+	// Private structs
+	struct Entry
+	{
+		const char * pName;
+		BIT_UINT32 Hash;
+		BIT_UINT32 Size;
+		BIT_UINT8 Data[ 64 ];
+	};
+
+	// Private functions
+	BIT_BOOL Changed( const UniformHandle & p_Handle, const void * p_pData, const BIT_UINT32 p_Size );
+
+	// Private variables
+	Bit::ShaderProgram * m_pShaderProgram;
+	std::vector< Entry > m_Entries;
+	BIT_UINT32 m_FrameBlockVersions[ FrameBlockMemberCount ];
+	BIT_UINT32 m_UploadCount;
+	BIT_UINT32 m_SkipCount;
+
+};
+
+#endif
@@ -0,0 +1,125 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __SPSC_QUEUE_HPP__
+#define __SPSC_QUEUE_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <atomic>
+#include <vector>
+
+// Fixed size ring buffer between one producer thread and one consumer thread.
+// Push and Pop never lock, wait or allocate, Push fails when the ring is full.
+// The indices run freely and wrap around, the capacity is a power of two.
+template< typename Type >
+class SpscQueue
+{
+
+public:
+
+	// Constructor
+	SpscQueue( ) :
+		m_Mask( 0 ),
+		m_Head( 0 ),
+		m_Tail( 0 )
+	{
+	}
+
+	// Public functions, create the queue before the threads use it.
+	// The capacity is rounded up to a power of two.
+	void Create( const BIT_UINT32 p_Capacity )
+	{
+		BIT_UINT32 Capacity = 1;
+		while( Capacity < p_Capacity )
+		{
+			Capacity <<= 1;
+		}
+
+		m_Items.assign( Capacity, Type( ) );
+		m_Mask = Capacity - 1;
+		m_Head.store( 0, std::memory_order_relaxed );
+		m_Tail.store( 0, std::memory_order_relaxed );
+	}
+
+	// Producer thread only
+	BIT_BOOL Push( const Type & p_Item )
+	{
+		const BIT_UINT32 Tail = m_Tail.load( std::memory_order_relaxed );
+		if( m_Items.empty( ) || Tail - m_Head.load( std::memory_order_acquire ) > m_Mask )
+		{
+			return BIT_FALSE;
+		}
+
+		// The item has to be written before the consumer can see the new tail
+		m_Items[ Tail & m_Mask ] = p_Item;
+		m_Tail.store( Tail + 1, std::memory_order_release );
+		return BIT_TRUE;
+	}
+
+	// Consumer thread only
+	BIT_BOOL Pop( Type & p_Item )
+	{
+		const BIT_UINT32 Head = m_Head.load( std::memory_order_relaxed );
+		if( Head == m_Tail.load( std::memory_order_acquire ) )
+		{
+			return BIT_FALSE;
+		}
+
+		// The slot is free for the producer once the new head is seen
+		p_Item = m_Items[ Head & m_Mask ];
+		m_Head.store( Head + 1, std::memory_order_release );
+		return BIT_TRUE;
+	}
+
+	// Get functions, the size is only a snapshot while the threads run
+	BIT_UINT32 GetSize( ) const
+	{
+		return m_Tail.load( std::memory_order_acquire ) - m_Head.load( std::memory_order_acquire );
+	}
+
+	BIT_UINT32 GetCapacity( ) const
+	{
+		return static_cast< BIT_UINT32 >( m_Items.size( ) );
+	}
+
+private:
+
+	// Copying the queue while the threads use it makes no sense
+	SpscQueue( const SpscQueue & );
+	SpscQueue & operator = ( const SpscQueue & );
+
+	// Private variables, the indices are kept on their own cache lines
+	// so the two threads don't fight over them.
+	std::vector< Type > m_Items;
+	BIT_UINT32 m_Mask;
+	BIT_UINT8 m_HeadPadding[ 64 ];
+	std::atomic< BIT_UINT32 > m_Head;
+	BIT_UINT8 m_TailPadding[ 64 ];
+	std::atomic< BIT_UINT32 > m_Tail;
+	BIT_UINT8 m_EndPadding[ 64 ];
+
+};
+
+#endif
@@ -0,0 +1,81 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __TEXT_RENDERER_HPP__
+#define __TEXT_RENDERER_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <GUIManager.hpp>
+#include <vector>
+#include <string>
+
+// Bitmap font text drawn through the batch of the GUI manager.
+// The glyphs of a built in 5x7 font are packed into the GUI atlas when loaded.
+// Strings added during the frame are laid out into a quad list that is kept
+// between frames, Render draws the whole list with a single call since every
+// atlas page is bound at once. Positions are the upper left corner of the
+// first line in GUI coordinates, the scale is an integer to keep the pixels sharp.
+// Layout writes the quads of a string into a list of the caller instead, room
+// for one quad per character is needed, so text can share a draw with other quads.
+class TextRenderer
+{
+
+public:
+
+	// Constructor/destructor
+	TextRenderer( GUIManager * p_pManager );
+	~TextRenderer( );
+
+	// Public functions
+	BIT_UINT32 Load( );
+	void Unload( );
+	void Begin( );
+	void Add( const Bit::Vector2_si32 p_Position, const std::string & p_Text, const BIT_UINT32 p_Scale = 1 );
+	void Render( );
+	BIT_UINT32 Layout( const Bit::Vector2_si32 p_Position, const std::string & p_Text, const BIT_UINT32 p_Scale,
+		BIT_FLOAT32 * p_pQuads ) const;
+
+	// Get functions
+	Bit::Vector2_ui32 GetGlyphSize( ) const;
+	Bit::Vector2_ui32 GetTextSize( const std::string & p_Text, const BIT_UINT32 p_Scale = 1 ) const;
+	BIT_UINT32 GetGlyphCount( ) const;
+
+private:
+
+	// Private constants, the printable ascii characters
+	static const BIT_UINT32 FirstCharacter = 32;
+	static const BIT_UINT32 CharacterCount = 95;
+
+	// Private variables
+	BIT_BOOL m_Loaded;
+	GUIManager * m_pManager;
+	BIT_FLOAT32 m_GlyphRects[ CharacterCount ][ 4 ];
+	std::vector< BIT_FLOAT32 > m_Quads;
+	BIT_UINT32 m_GlyphCount;
+
+};
+
+#endif
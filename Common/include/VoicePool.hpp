@@ -0,0 +1,110 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __VOICE_POOL_HPP__
+#define __VOICE_POOL_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/Audio/AudioBuffer.hpp>
+#include <Bit/System/Vector3.hpp>
+#include <vector>
+
+// Fixed set of OpenAL sources shared by every one-shot sound.
+// A sound is uploaded once and any number of voices can play it at the same time.
+// When every voice is busy the lowest priority voice is stolen, the quietest
+// and then the oldest among equals, unless the new sound is less important.
+// Playing doesn't allocate, everything is sized when the pool is opened.
+class VoicePool
+{
+
+public:
+
+	// Public typedefs and constants, a voice handle turns invalid once the voice is reused
+	typedef BIT_UINT32 VoiceHandle;
+	static const VoiceHandle InvalidVoice = 0;
+
+	// Constructor/destructor
+	VoicePool( );
+	~VoicePool( );
+
+	// Public functions, the audio device has to be open.
+	// Fewer voices than asked for are created if OpenAL runs out of sources.
+	BIT_UINT32 Open( const BIT_UINT32 p_VoiceCount, const BIT_UINT32 p_MaxSoundCount = 64 );
+	void Close( );
+
+	// Returns the sound index or -1
+	BIT_SINT32 LoadSound( const Bit::AudioBuffer & p_AudioBuffer );
+
+	// Relative to the listener if no position is given, returns InvalidVoice if rejected
+	VoiceHandle Play( const BIT_UINT32 p_Sound, const BIT_SINT32 p_Priority, const BIT_FLOAT32 p_Volume = 1.0f,
+		const Bit::Vector3_f32 * p_pPosition = BIT_NULL );
+	void Stop( const VoiceHandle p_Voice );
+	void StopAll( );
+
+	// Takes the finished voices back, call once per frame
+	void Update( );
+
+	// Get functions
+	BIT_BOOL IsPlaying( const VoiceHandle p_Voice ) const;
+	BIT_UINT32 GetVoiceCount( ) const;
+	BIT_UINT32 GetActiveCount( ) const;
+	BIT_UINT32 GetStealCount( ) const;
+	BIT_UINT32 GetRejectCount( ) const;
+	BIT_FLOAT64 GetSoundLength( const BIT_UINT32 p_Sound ) const;
+
+private:
+
+	// Private structs
+	struct Voice
+	{
+		BIT_UINT32 Source;
+		BIT_UINT32 Generation;
+		BIT_SINT32 Priority;
+		BIT_FLOAT32 Volume;
+		BIT_UINT32 StartIndex;
+		BIT_BOOL Active;
+	};
+
+	struct Sound
+	{
+		BIT_UINT32 Buffer;
+		BIT_FLOAT64 Length;
+	};
+
+	// Private functions
+	BIT_UINT32 FindVictim( const BIT_SINT32 p_Priority, const BIT_FLOAT32 p_Volume ) const;
+	void Release( const BIT_UINT32 p_Index );
+
+	// Private variables
+	std::vector< Voice > m_Voices;
+	std::vector< BIT_UINT32 > m_FreeVoices;
+	std::vector< Sound > m_Sounds;
+	BIT_UINT32 m_PlayIndex;
+	BIT_UINT32 m_StealCount;
+	BIT_UINT32 m_RejectCount;
+
+};
+
+#endif
@@ -0,0 +1,90 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __WAVE_STREAM_HPP__
+#define __WAVE_STREAM_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <string>
+
+// Memory mapped PCM wave file read a few frames at a time.
+// Only the pages around the read position stay resident, the pages behind it
+// are handed back to the OS and the next ones are prefetched,
+// so the memory use doesn't depend on the length of the file.
+class WaveStream
+{
+
+public:
+
+	// Constructor/destructor
+	WaveStream( );
+	~WaveStream( );
+
+	// Public functions, 8 and 16 bit PCM only
+	BIT_UINT32 Open( const std::string & p_FilePath );
+	void Close( );
+
+	// Reads up to p_FrameCount frames, returns the number read, 0 at the end of the file
+	BIT_UINT32 Read( void * p_pData, const BIT_UINT32 p_FrameCount );
+	BIT_UINT32 Seek( const BIT_UINT32 p_Frame );
+
+	// Get functions
+	BIT_BOOL IsOpen( ) const;
+	BIT_UINT16 GetChannelCount( ) const;
+	BIT_UINT32 GetSampleRate( ) const;
+	BIT_UINT16 GetBitsPerSample( ) const;
+	BIT_UINT32 GetFrameSize( ) const;
+	BIT_UINT32 GetFrameCount( ) const;
+	BIT_UINT32 GetPosition( ) const;
+
+private:
+
+	// Private functions
+	BIT_UINT32 Map( const std::string & p_FilePath );
+	void Unmap( );
+	void UpdateResidency( );
+
+	// Private variables
+	const BIT_UINT8 * m_pFile;
+	BIT_UINT64 m_FileSize;
+	const BIT_UINT8 * m_pData;
+	BIT_UINT32 m_DataSize;
+	BIT_UINT64 m_ReleasedOffset;
+	BIT_UINT64 m_PrefetchedOffset;
+	BIT_UINT16 m_ChannelCount;
+	BIT_UINT32 m_SampleRate;
+	BIT_UINT16 m_BitsPerSample;
+	BIT_UINT32 m_FrameSize;
+	BIT_UINT32 m_Position;
+#ifdef BIT_PLATFORM_WINDOWS
+	void * m_FileHandle;
+	void * m_MappingHandle;
+#else
+	int m_FileDescriptor;
+#endif
+
+};
+
+#endif
@@ -0,0 +1,98 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __WIDGET_GRID_HPP__
+#define __WIDGET_GRID_HPP__
+
+#include <Bit/DataTypes.hpp>
+#include <Bit/System/Vector2.hpp>
+#include <vector>
+
+// Uniform grid over widget rectangles for hit-testing.
+// Every cell lists the widgets overlapping it, a point query only tests the
+// widgets of a single cell. Rectangles outside the area are clamped to the
+// border cells. Moving a widget only relinks it when it covers other cells.
+// Widgets added later are on top and win a query.
+// A rectangle query lists every widget overlapping it in draw order.
+class WidgetGrid
+{
+
+public:
+
+	// Public constants
+	static const BIT_UINT32 InvalidId = 0xFFFFFFFF;
+
+	// Constructor/destructor
+	WidgetGrid( );
+	~WidgetGrid( );
+
+	// Public functions
+	BIT_UINT32 Load( const Bit::Vector2_ui32 p_AreaSize, const BIT_UINT32 p_CellSize );
+	BIT_UINT32 Add( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size );
+	void Move( const BIT_UINT32 p_Id, const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size );
+	void Remove( const BIT_UINT32 p_Id );
+	BIT_UINT32 Query( const Bit::Vector2_si32 p_Point ) const;
+	void Query( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size, std::vector< BIT_UINT32 > & p_Ids ) const;
+	void Clear( );
+
+	// Get functions
+	BIT_UINT32 GetCount( ) const;
+	BIT_UINT32 GetCellSize( ) const;
+	Bit::Vector2_ui32 GetGridSize( ) const;
+	BIT_UINT32 GetRelinkCount( ) const;
+
+private:
+
+	// Private structs
+	struct Entry
+	{
+		Bit::Vector2_si32 Position;
+		Bit::Vector2_ui32 Size;
+		Bit::Vector2_ui32 CellMin;
+		Bit::Vector2_ui32 CellMax;
+		BIT_UINT32 Order;
+		BIT_BOOL Used;
+	};
+
+	// Private functions
+	void GetCellRange( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size,
+		Bit::Vector2_ui32 & p_Min, Bit::Vector2_ui32 & p_Max ) const;
+	BIT_UINT32 GetCell( const BIT_SINT32 p_Coordinate, const BIT_UINT32 p_Count ) const;
+	void Link( const BIT_UINT32 p_Id );
+	void Unlink( const BIT_UINT32 p_Id );
+
+	// Private variables
+	Bit::Vector2_ui32 m_GridSize;
+	BIT_UINT32 m_CellSize;
+	std::vector< std::vector< BIT_UINT32 > > m_Cells;
+	std::vector< Entry > m_Entries;
+	std::vector< BIT_UINT32 > m_FreeIds;
+	BIT_UINT32 m_NextOrder;
+	BIT_UINT32 m_Count;
+	BIT_UINT32 m_RelinkCount;
+
+};
+
+#endif
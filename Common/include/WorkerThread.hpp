@@ -0,0 +1,104 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#ifndef __WORKER_THREAD_HPP__
+#define __WORKER_THREAD_HPP__
+
+#include <Bit/DataTypes.hpp>
+#ifndef BIT_PLATFORM_WINDOWS
+	#include <pthread.h>
+#endif
+
+// Plain mutex, Win32 critical section or pthread mutex.
+class Mutex
+{
+
+public:
+
+	// Constructor/destructor
+	Mutex( );
+	~Mutex( );
+
+	// Public functions
+	void Lock( );
+	void Unlock( );
+
+private:
+
+	// Copying a mutex makes no sense
+	Mutex( const Mutex & );
+	Mutex & operator = ( const Mutex & );
+
+	// Private variables
+#ifdef BIT_PLATFORM_WINDOWS
+	void * m_pCriticalSection;
+#else
+	pthread_mutex_t m_Mutex;
+#endif
+
+};
+
+// Thread running a single function until it returns.
+class WorkerThread
+{
+
+public:
+
+	// Public typedefs
+	typedef void ( * Function )( void * p_pUserData );
+
+	// Constructor/destructor, the destructor waits for the thread.
+	WorkerThread( );
+	~WorkerThread( );
+
+	// Public functions
+	BIT_UINT32 Start( Function p_Function, void * p_pUserData );
+	void Join( );
+
+	// Get functions
+	BIT_BOOL IsRunning( ) const;
+
+private:
+
+	// Static functions
+#ifdef BIT_PLATFORM_WINDOWS
+	static unsigned long __stdcall Entry( void * p_pThread );
+#else
+	static void * Entry( void * p_pThread );
+#endif
+
+	// Private variables
+	Function m_Function;
+	void * m_pUserData;
+	BIT_BOOL m_Running;
+#ifdef BIT_PLATFORM_WINDOWS
+	void * m_Handle;
+#else
+	pthread_t m_Thread;
+#endif
+
+};
+
+#endif
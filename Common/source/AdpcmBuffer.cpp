@@ -0,0 +1,550 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <AdpcmBuffer.hpp>
+#include <cstdio>
+#include <cstring>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// IMA-ADPCM tables, the step size and how the step index moves for every code
+static const BIT_SINT32 StepTable[ 89 ] =
+{
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const BIT_SINT32 IndexTable[ 16 ] =
+{
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+// Little endian helpers, the chunk data isn't aligned
+static BIT_UINT32 ReadUInt32( const BIT_UINT8 * p_pData )
+{
+	return static_cast< BIT_UINT32 >( p_pData[ 0 ] ) | ( static_cast< BIT_UINT32 >( p_pData[ 1 ] ) << 8 ) |
+		( static_cast< BIT_UINT32 >( p_pData[ 2 ] ) << 16 ) | ( static_cast< BIT_UINT32 >( p_pData[ 3 ] ) << 24 );
+}
+
+static BIT_UINT16 ReadUInt16( const BIT_UINT8 * p_pData )
+{
+	return static_cast< BIT_UINT16 >( p_pData[ 0 ] | ( p_pData[ 1 ] << 8 ) );
+}
+
+static void WriteUInt32( FILE * p_pFile, const BIT_UINT32 p_Value )
+{
+	const BIT_UINT8 Bytes[ 4 ] =
+	{
+		static_cast< BIT_UINT8 >( p_Value ), static_cast< BIT_UINT8 >( p_Value >> 8 ),
+		static_cast< BIT_UINT8 >( p_Value >> 16 ), static_cast< BIT_UINT8 >( p_Value >> 24 )
+	};
+	fwrite( Bytes, 1, 4, p_pFile );
+}
+
+static void WriteUInt16( FILE * p_pFile, const BIT_UINT16 p_Value )
+{
+	const BIT_UINT8 Bytes[ 2 ] = { static_cast< BIT_UINT8 >( p_Value ), static_cast< BIT_UINT8 >( p_Value >> 8 ) };
+	fwrite( Bytes, 1, 2, p_pFile );
+}
+
+// The signed difference a code adds to the predictor, before the predictor is clamped
+static inline BIT_SINT32 GetDifference( const BIT_UINT32 p_Nibble, const BIT_SINT32 p_Step )
+{
+	BIT_SINT32 Difference = p_Step >> 3;
+	if( p_Nibble & 4 ) Difference += p_Step;
+	if( p_Nibble & 2 ) Difference += p_Step >> 1;
+	if( p_Nibble & 1 ) Difference += p_Step >> 2;
+
+	return ( p_Nibble & 8 ) ? -Difference : Difference;
+}
+
+// Applies a code to the predictor, the encoder runs it too so both sides stay in step
+static inline void DecodeNibble( const BIT_UINT32 p_Nibble, BIT_SINT32 & p_Predictor, BIT_SINT32 & p_Index )
+{
+	p_Predictor += GetDifference( p_Nibble, StepTable[ p_Index ] );
+	p_Predictor = p_Predictor < -32768 ? -32768 : ( p_Predictor > 32767 ? 32767 : p_Predictor );
+
+	p_Index += IndexTable[ p_Nibble ];
+	p_Index = p_Index < 0 ? 0 : ( p_Index > 88 ? 88 : p_Index );
+}
+
+// The difference and the next step index of every step index and code,
+// so the decoder does two lookups a sample and no branches.
+// Only the predictor is clamped, a difference of a large step doesn't fit in 16 bits.
+struct DecodeTable
+{
+	DecodeTable( )
+	{
+		for( BIT_SINT32 Index = 0; Index < 89; Index++ )
+		{
+			for( BIT_UINT32 Nibble = 0; Nibble < 16; Nibble++ )
+			{
+				const BIT_SINT32 NextIndex = Index + IndexTable[ Nibble ];
+				Differences[ Index * 16 + Nibble ] = GetDifference( Nibble, StepTable[ Index ] );
+				NextIndices[ Index * 16 + Nibble ] = static_cast< BIT_UINT16 >(
+					( NextIndex < 0 ? 0 : ( NextIndex > 88 ? 88 : NextIndex ) ) * 16 );
+			}
+		}
+	}
+
+	BIT_SINT32 Differences[ 89 * 16 ];
+	BIT_UINT16 NextIndices[ 89 * 16 ];
+};
+
+static const DecodeTable Table;
+
+static inline BIT_UINT32 EncodeNibble( const BIT_SINT32 p_Sample, BIT_SINT32 & p_Predictor, BIT_SINT32 & p_Index )
+{
+	BIT_SINT32 Step = StepTable[ p_Index ];
+	BIT_SINT32 Difference = p_Sample - p_Predictor;
+	BIT_UINT32 Nibble = 0;
+	if( Difference < 0 )
+	{
+		Nibble = 8;
+		Difference = -Difference;
+	}
+
+	for( BIT_UINT32 Bit = 4; Bit; Bit >>= 1 )
+	{
+		if( Difference >= Step )
+		{
+			Nibble |= Bit;
+			Difference -= Step;
+		}
+		Step >>= 1;
+	}
+
+	DecodeNibble( Nibble, p_Predictor, p_Index );
+	return Nibble;
+}
+
+static inline void StoreSample( BIT_SINT16 & p_Output, const BIT_SINT32 p_Sample )
+{
+	p_Output = static_cast< BIT_SINT16 >( p_Sample );
+}
+
+static inline void StoreSample( BIT_FLOAT32 & p_Output, const BIT_SINT32 p_Sample )
+{
+	p_Output = static_cast< BIT_FLOAT32 >( p_Sample ) * ( 1.0f / 32768.0f );
+}
+
+// A block is a 4 byte header per channel followed by 4 byte groups
+// of 8 samples per channel in turn, low nibble first.
+// The channels are decoded side by side, their predictors don't depend on each other.
+template< typename Type, BIT_UINT32 ChannelCount >
+static void DecodeChannels( const BIT_UINT8 * p_pBlock, const BIT_UINT32 p_FrameCount, Type * const * p_ppOutput,
+	const BIT_UINT32 p_Stride )
+{
+	BIT_SINT32 Predictors[ ChannelCount ];
+	BIT_UINT32 Rows[ ChannelCount ];
+	for( BIT_UINT32 c = 0; c < ChannelCount; c++ )
+	{
+		Predictors[ c ] = static_cast< BIT_SINT16 >( ReadUInt16( p_pBlock + c * 4 ) );
+		Rows[ c ] = ( p_pBlock[ c * 4 + 2 ] > 88 ? 88 : p_pBlock[ c * 4 + 2 ] ) * 16;
+		StoreSample( p_ppOutput[ c ][ 0 ], Predictors[ c ] );
+	}
+
+	const BIT_UINT8 * pGroup = p_pBlock + ChannelCount * 4;
+	for( BIT_UINT32 i = 1; i < p_FrameCount; i += 8 )
+	{
+		const BIT_UINT32 Count = p_FrameCount - i < 8 ? p_FrameCount - i : 8;
+		for( BIT_UINT32 j = 0; j < Count; j++ )
+		{
+			for( BIT_UINT32 c = 0; c < ChannelCount; c++ )
+			{
+				const BIT_UINT32 Entry = Rows[ c ] + ( ( pGroup[ c * 4 + ( j >> 1 ) ] >> ( ( j & 1 ) * 4 ) ) & 0x0F );
+				const BIT_SINT32 Predictor = Predictors[ c ] + Table.Differences[ Entry ];
+				Predictors[ c ] = Predictor < -32768 ? -32768 : ( Predictor > 32767 ? 32767 : Predictor );
+				Rows[ c ] = Table.NextIndices[ Entry ];
+				StoreSample( p_ppOutput[ c ][ ( i + j ) * p_Stride ], Predictors[ c ] );
+			}
+		}
+		pGroup += ChannelCount * 4;
+	}
+}
+
+static void EncodeChannel( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_Channel, const BIT_UINT32 p_ChannelCount,
+	const BIT_UINT32 p_FrameCount, const BIT_UINT32 p_FramesPerBlock, BIT_UINT8 * p_pBlock, BIT_SINT32 & p_Index )
+{
+	// The first sample is stored as it is, the step index goes on from the last block
+	BIT_SINT32 Predictor = p_pFrames[ p_Channel ];
+	BIT_UINT8 * pHeader = p_pBlock + p_Channel * 4;
+	pHeader[ 0 ] = static_cast< BIT_UINT8 >( Predictor );
+	pHeader[ 1 ] = static_cast< BIT_UINT8 >( Predictor >> 8 );
+	pHeader[ 2 ] = static_cast< BIT_UINT8 >( p_Index );
+	pHeader[ 3 ] = 0;
+
+	BIT_UINT8 * pGroup = p_pBlock + ( p_ChannelCount + p_Channel ) * 4;
+	for( BIT_UINT32 i = 1; i < p_FramesPerBlock; i += 8 )
+	{
+		for( BIT_UINT32 j = 0; j < 8; j++ )
+		{
+			// A short last block holds its last sample
+			const BIT_UINT32 Frame = i + j < p_FrameCount ? i + j : p_FrameCount - 1;
+			const BIT_UINT32 Nibble = EncodeNibble( p_pFrames[ Frame * p_ChannelCount + p_Channel ], Predictor, p_Index );
+			pGroup[ j >> 1 ] = static_cast< BIT_UINT8 >( ( j & 1 ) ? ( pGroup[ j >> 1 ] | ( Nibble << 4 ) ) : Nibble );
+		}
+		pGroup += p_ChannelCount * 4;
+	}
+}
+
+// Constructor
+AdpcmBuffer::AdpcmBuffer( ) :
+	m_ChannelCount( 0 ),
+	m_SampleRate( 0 ),
+	m_FrameCount( 0 ),
+	m_FramesPerBlock( 0 ),
+	m_BlockSize( 0 )
+{
+}
+
+// Public functions
+BIT_UINT32 AdpcmBuffer::Read( const std::string & p_FilePath )
+{
+	Clear( );
+
+	FILE * pFile = fopen( p_FilePath.c_str( ), "rb" );
+	if( pFile == BIT_NULL )
+	{
+		bitTrace( "[AdpcmBuffer::Read] Can not open the file: %s\n", p_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	std::vector< BIT_UINT8 > File;
+	fseek( pFile, 0, SEEK_END );
+	const long FileSize = ftell( pFile );
+	fseek( pFile, 0, SEEK_SET );
+	if( FileSize > 0 )
+	{
+		File.resize( static_cast< BIT_MEMSIZE >( FileSize ) );
+		File.resize( fread( &File[ 0 ], 1, File.size( ), pFile ) );
+	}
+	fclose( pFile );
+
+	if( File.size( ) < 12 || memcmp( &File[ 0 ], "RIFF", 4 ) != 0 || memcmp( &File[ 8 ], "WAVE", 4 ) != 0 )
+	{
+		bitTrace( "[AdpcmBuffer::Read] Not a wave file: %s\n", p_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	// Walk the chunks, the fact chunk holds the frame count of compressed files
+	BIT_UINT16 Format = 0;
+	BIT_UINT16 ChannelCount = 0;
+	BIT_UINT32 SampleRate = 0;
+	BIT_UINT16 BlockAlign = 0;
+	BIT_UINT16 BitsPerSample = 0;
+	BIT_UINT32 FramesPerBlock = 0;
+	BIT_UINT32 FactFrameCount = 0;
+	const BIT_UINT8 * pData = BIT_NULL;
+	BIT_UINT32 DataSize = 0;
+
+	BIT_MEMSIZE Offset = 12;
+	while( Offset + 8 <= File.size( ) )
+	{
+		const BIT_UINT8 * pChunk = &File[ Offset ];
+		const BIT_UINT32 ChunkSize = ReadUInt32( pChunk + 4 );
+		const BIT_MEMSIZE Available = File.size( ) - Offset - 8;
+
+		if( memcmp( pChunk, "fmt ", 4 ) == 0 && ChunkSize >= 16 && ChunkSize <= Available )
+		{
+			Format = ReadUInt16( pChunk + 8 );
+			ChannelCount = ReadUInt16( pChunk + 10 );
+			SampleRate = ReadUInt32( pChunk + 12 );
+			BlockAlign = ReadUInt16( pChunk + 20 );
+			BitsPerSample = ReadUInt16( pChunk + 22 );
+			FramesPerBlock = ChunkSize >= 20 ? ReadUInt16( pChunk + 26 ) : 0;
+		}
+		else if( memcmp( pChunk, "fact", 4 ) == 0 && ChunkSize >= 4 && ChunkSize <= Available )
+		{
+			FactFrameCount = ReadUInt32( pChunk + 8 );
+		}
+		else if( memcmp( pChunk, "data", 4 ) == 0 )
+		{
+			// Truncated files play what's there
+			pData = pChunk + 8;
+			DataSize = static_cast< BIT_UINT32 >( ChunkSize < Available ? ChunkSize : Available );
+		}
+
+		// Chunks are padded to an even size
+		Offset += 8 + static_cast< BIT_MEMSIZE >( ChunkSize ) + ( ChunkSize & 1 );
+	}
+
+	if( pData == BIT_NULL || ChannelCount == 0 || ChannelCount > 2 || SampleRate == 0 )
+	{
+		bitTrace( "[AdpcmBuffer::Read] Broken wave file: %s\n", p_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	// PCM is encoded here
+	if( Format == 1 && ( BitsPerSample == 8 || BitsPerSample == 16 ) )
+	{
+		const BIT_UINT32 SampleCount = DataSize / ( BitsPerSample / 8 ) / ChannelCount * ChannelCount;
+		std::vector< BIT_SINT16 > Samples( SampleCount );
+		for( BIT_UINT32 i = 0; i < SampleCount; i++ )
+		{
+			Samples[ i ] = BitsPerSample == 8 ? static_cast< BIT_SINT16 >( ( static_cast< BIT_SINT32 >( pData[ i ] ) - 128 ) << 8 ) :
+				static_cast< BIT_SINT16 >( ReadUInt16( pData + i * 2 ) );
+		}
+
+		return Encode( SampleCount ? &Samples[ 0 ] : BIT_NULL, SampleCount / ChannelCount, ChannelCount, SampleRate );
+	}
+
+	// IMA-ADPCM is kept as it is, the blocks have to match the layout of the decoder
+	const BIT_UINT32 MaxFramesPerBlock = BlockAlign > ChannelCount * 4 ? ( BlockAlign - ChannelCount * 4 ) * 2 / ChannelCount + 1 : 0;
+	if( Format != 0x11 || BitsPerSample != 4 || FramesPerBlock == 0 || FramesPerBlock > MaxFramesPerBlock ||
+		( FramesPerBlock - 1 ) % 8 != 0 )
+	{
+		bitTrace( "[AdpcmBuffer::Read] Only PCM and IMA-ADPCM wave files are supported: %s\n", p_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	const BIT_UINT32 BlockCount = ( DataSize + BlockAlign - 1 ) / BlockAlign;
+	const BIT_UINT32 FrameCount = BlockCount * FramesPerBlock;
+	m_ChannelCount = ChannelCount;
+	m_SampleRate = SampleRate;
+	m_FramesPerBlock = FramesPerBlock;
+	m_BlockSize = BlockAlign;
+	m_FrameCount = FactFrameCount && FactFrameCount < FrameCount ? FactFrameCount : FrameCount;
+
+	// A short last block is padded, its missing codes decode as silence
+	m_Data.assign( pData, pData + DataSize );
+	m_Data.resize( BlockCount * BlockAlign, 0 );
+
+	return BIT_OK;
+}
+
+BIT_UINT32 AdpcmBuffer::Write( const std::string & p_FilePath ) const
+{
+	if( IsEmpty( ) )
+	{
+		bitTrace( "[AdpcmBuffer::Write] The buffer is empty\n" );
+		return BIT_ERROR;
+	}
+
+	FILE * pFile = fopen( p_FilePath.c_str( ), "wb" );
+	if( pFile == BIT_NULL )
+	{
+		bitTrace( "[AdpcmBuffer::Write] Can not open the file: %s\n", p_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	const BIT_UINT32 DataSize = static_cast< BIT_UINT32 >( m_Data.size( ) );
+	fwrite( "RIFF", 1, 4, pFile );
+	WriteUInt32( pFile, 4 + 28 + 12 + 8 + DataSize );
+	fwrite( "WAVEfmt ", 1, 8, pFile );
+	WriteUInt32( pFile, 20 );
+	WriteUInt16( pFile, 0x11 );
+	WriteUInt16( pFile, m_ChannelCount );
+	WriteUInt32( pFile, m_SampleRate );
+	WriteUInt32( pFile, static_cast< BIT_UINT32 >( static_cast< BIT_UINT64 >( m_SampleRate ) * m_BlockSize / m_FramesPerBlock ) );
+	WriteUInt16( pFile, static_cast< BIT_UINT16 >( m_BlockSize ) );
+	WriteUInt16( pFile, 4 );
+	WriteUInt16( pFile, 2 );
+	WriteUInt16( pFile, static_cast< BIT_UINT16 >( m_FramesPerBlock ) );
+	fwrite( "fact", 1, 4, pFile );
+	WriteUInt32( pFile, 4 );
+	WriteUInt32( pFile, m_FrameCount );
+	fwrite( "data", 1, 4, pFile );
+	WriteUInt32( pFile, DataSize );
+	const BIT_MEMSIZE Written = fwrite( &m_Data[ 0 ], 1, DataSize, pFile );
+	fclose( pFile );
+
+	if( Written != DataSize )
+	{
+		bitTrace( "[AdpcmBuffer::Write] Can not write the file: %s\n", p_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+void AdpcmBuffer::Clear( )
+{
+	m_Data.clear( );
+	m_ChannelCount = 0;
+	m_SampleRate = 0;
+	m_FrameCount = 0;
+	m_FramesPerBlock = 0;
+	m_BlockSize = 0;
+}
+
+BIT_UINT32 AdpcmBuffer::Encode( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount, const BIT_UINT16 p_ChannelCount,
+	const BIT_UINT32 p_SampleRate, const BIT_UINT32 p_FramesPerBlock )
+{
+	Clear( );
+
+	if( p_pFrames == BIT_NULL || p_FrameCount == 0 || p_ChannelCount == 0 || p_ChannelCount > 2 || p_SampleRate == 0 )
+	{
+		bitTrace( "[AdpcmBuffer::Encode] Empty sound or unsupported channel count\n" );
+		return BIT_ERROR;
+	}
+
+	// The block size field of the wave format is 16 bits
+	if( p_FramesPerBlock < 9 || ( p_FramesPerBlock - 1 ) % 8 != 0 || p_FramesPerBlock > 8185 )
+	{
+		bitTrace( "[AdpcmBuffer::Encode] The frames per block has to be one more than a multiple of 8\n" );
+		return BIT_ERROR;
+	}
+
+	m_ChannelCount = p_ChannelCount;
+	m_SampleRate = p_SampleRate;
+	m_FrameCount = p_FrameCount;
+	m_FramesPerBlock = p_FramesPerBlock;
+	m_BlockSize = p_ChannelCount * 4 + ( p_FramesPerBlock - 1 ) / 2 * p_ChannelCount;
+	m_Data.resize( GetBlockCount( ) * m_BlockSize );
+
+	BIT_SINT32 Indices[ 2 ] = { 0, 0 };
+	for( BIT_UINT32 Block = 0; Block < GetBlockCount( ); Block++ )
+	{
+		const BIT_UINT32 First = Block * m_FramesPerBlock;
+		const BIT_UINT32 Count = p_FrameCount - First < m_FramesPerBlock ? p_FrameCount - First : m_FramesPerBlock;
+		for( BIT_UINT32 c = 0; c < p_ChannelCount; c++ )
+		{
+			EncodeChannel( p_pFrames + First * p_ChannelCount, c, p_ChannelCount, Count, m_FramesPerBlock,
+				&m_Data[ Block * m_BlockSize ], Indices[ c ] );
+		}
+	}
+
+	return BIT_OK;
+}
+
+BIT_UINT32 AdpcmBuffer::DecodeBlock( const BIT_UINT32 p_Block, BIT_SINT16 * p_pFrames ) const
+{
+	if( p_Block >= GetBlockCount( ) )
+	{
+		return 0;
+	}
+
+	const BIT_UINT32 First = p_Block * m_FramesPerBlock;
+	const BIT_UINT32 Count = m_FrameCount - First < m_FramesPerBlock ? m_FrameCount - First : m_FramesPerBlock;
+	BIT_SINT16 * Channels[ 2 ] = { p_pFrames, p_pFrames + 1 };
+	if( m_ChannelCount == 1 )
+	{
+		DecodeChannels< BIT_SINT16, 1 >( &m_Data[ p_Block * m_BlockSize ], Count, Channels, 1 );
+	}
+	else
+	{
+		DecodeChannels< BIT_SINT16, 2 >( &m_Data[ p_Block * m_BlockSize ], Count, Channels, 2 );
+	}
+
+	return Count;
+}
+
+BIT_UINT32 AdpcmBuffer::DecodeBlock( const BIT_UINT32 p_Block, BIT_FLOAT32 * p_pLeft, BIT_FLOAT32 * p_pRight ) const
+{
+	if( p_Block >= GetBlockCount( ) )
+	{
+		return 0;
+	}
+
+	const BIT_UINT32 First = p_Block * m_FramesPerBlock;
+	const BIT_UINT32 Count = m_FrameCount - First < m_FramesPerBlock ? m_FrameCount - First : m_FramesPerBlock;
+	BIT_FLOAT32 * Channels[ 2 ] = { p_pLeft, p_pRight };
+	if( m_ChannelCount == 1 )
+	{
+		DecodeChannels< BIT_FLOAT32, 1 >( &m_Data[ p_Block * m_BlockSize ], Count, Channels, 1 );
+	}
+	else
+	{
+		DecodeChannels< BIT_FLOAT32, 2 >( &m_Data[ p_Block * m_BlockSize ], Count, Channels, 1 );
+	}
+
+	return Count;
+}
+
+BIT_UINT32 AdpcmBuffer::DecodeBlockReference( const BIT_UINT32 p_Block, BIT_SINT16 * p_pFrames ) const
+{
+	if( p_Block >= GetBlockCount( ) )
+	{
+		return 0;
+	}
+
+	// A code at a time with the predictor and step index of the encoder, no tables
+	const BIT_UINT32 First = p_Block * m_FramesPerBlock;
+	const BIT_UINT32 Count = m_FrameCount - First < m_FramesPerBlock ? m_FrameCount - First : m_FramesPerBlock;
+	const BIT_UINT8 * pBlock = &m_Data[ p_Block * m_BlockSize ];
+	for( BIT_UINT32 c = 0; c < m_ChannelCount; c++ )
+	{
+		BIT_SINT32 Predictor = static_cast< BIT_SINT16 >( ReadUInt16( pBlock + c * 4 ) );
+		BIT_SINT32 Index = pBlock[ c * 4 + 2 ] > 88 ? 88 : pBlock[ c * 4 + 2 ];
+		p_pFrames[ c ] = static_cast< BIT_SINT16 >( Predictor );
+
+		for( BIT_UINT32 i = 1; i < Count; i++ )
+		{
+			const BIT_UINT32 Group = ( i - 1 ) / 8;
+			const BIT_UINT32 Sample = ( i - 1 ) % 8;
+			const BIT_UINT8 Byte = pBlock[ ( m_ChannelCount * ( Group + 1 ) + c ) * 4 + Sample / 2 ];
+			DecodeNibble( ( Sample & 1 ) ? ( Byte >> 4 ) : ( Byte & 0x0F ), Predictor, Index );
+			p_pFrames[ i * m_ChannelCount + c ] = static_cast< BIT_SINT16 >( Predictor );
+		}
+	}
+
+	return Count;
+}
+
+// Get functions
+BIT_BOOL AdpcmBuffer::IsEmpty( ) const
+{
+	return m_FrameCount == 0;
+}
+
+BIT_UINT16 AdpcmBuffer::GetChannelCount( ) const
+{
+	return m_ChannelCount;
+}
+
+BIT_UINT32 AdpcmBuffer::GetSampleRate( ) const
+{
+	return m_SampleRate;
+}
+
+BIT_UINT32 AdpcmBuffer::GetFrameCount( ) const
+{
+	return m_FrameCount;
+}
+
+BIT_UINT32 AdpcmBuffer::GetFramesPerBlock( ) const
+{
+	return m_FramesPerBlock;
+}
+
+BIT_UINT32 AdpcmBuffer::GetBlockSize( ) const
+{
+	return m_BlockSize;
+}
+
+BIT_UINT32 AdpcmBuffer::GetBlockCount( ) const
+{
+	return m_FramesPerBlock ? ( m_FrameCount + m_FramesPerBlock - 1 ) / m_FramesPerBlock : 0;
+}
+
+BIT_UINT32 AdpcmBuffer::GetDataSize( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Data.size( ) );
+}
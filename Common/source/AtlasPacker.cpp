@@ -0,0 +1,261 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <AtlasPacker.hpp>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor/destructor
+AtlasPacker::AtlasPacker( ) :
+	m_PageSize( 0, 0 ),
+	m_Padding( 0 ),
+	m_MaxPages( 0 )
+{
+}
+
+AtlasPacker::~AtlasPacker( )
+{
+}
+
+// Public functions
+BIT_UINT32 AtlasPacker::Load( const Bit::Vector2_ui32 p_PageSize, const BIT_UINT32 p_Padding, const BIT_UINT32 p_MaxPages )
+{
+	if( p_PageSize.x == 0 || p_PageSize.y == 0 || p_MaxPages == 0 )
+	{
+		bitTrace( "[AtlasPacker::Load] The page size and the page count can not be zero\n" );
+		return BIT_ERROR;
+	}
+
+	m_PageSize = p_PageSize;
+	m_Padding = p_Padding;
+	m_MaxPages = p_MaxPages;
+	Clear( );
+
+	return BIT_OK;
+}
+
+BIT_UINT32 AtlasPacker::Add( const Bit::Vector2_ui32 p_Size, Region & p_Region )
+{
+	const Bit::Vector2_ui32 PaddedSize( p_Size.x + m_Padding * 2, p_Size.y + m_Padding * 2 );
+
+	if( p_Size.x == 0 || p_Size.y == 0 || PaddedSize.x > m_PageSize.x || PaddedSize.y > m_PageSize.y )
+	{
+		bitTrace( "[AtlasPacker::Add] The rectangle does not fit on a page: %ux%u\n", p_Size.x, p_Size.y );
+		return BIT_ERROR;
+	}
+
+	// Try the current pages first, the earlier pages are the fullest
+	Bit::Vector2_ui32 Position( 0, 0 );
+	BIT_UINT32 PageIndex = 0;
+
+	while( PageIndex < m_Pages.size( ) && !Insert( m_Pages[ PageIndex ], PaddedSize, Position ) )
+	{
+		PageIndex++;
+	}
+
+	if( PageIndex == m_Pages.size( ) )
+	{
+		if( m_Pages.size( ) >= m_MaxPages )
+		{
+			bitTrace( "[AtlasPacker::Add] All %u pages are full\n", m_MaxPages );
+			return BIT_ERROR;
+		}
+
+		AddPage( );
+		if( !Insert( m_Pages.back( ), PaddedSize, Position ) )
+		{
+			return BIT_ERROR;
+		}
+	}
+
+	m_Pages[ PageIndex ].UsedArea += p_Size.x * p_Size.y;
+
+	p_Region.Page = PageIndex;
+	p_Region.Position = Bit::Vector2_ui32( Position.x + m_Padding, Position.y + m_Padding );
+	p_Region.Size = p_Size;
+	return BIT_OK;
+}
+
+void AtlasPacker::Clear( )
+{
+	m_Pages.clear( );
+}
+
+// Get functions
+Bit::Vector2_ui32 AtlasPacker::GetPageSize( ) const
+{
+	return m_PageSize;
+}
+
+BIT_UINT32 AtlasPacker::GetPadding( ) const
+{
+	return m_Padding;
+}
+
+BIT_UINT32 AtlasPacker::GetPageCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Pages.size( ) );
+}
+
+BIT_UINT32 AtlasPacker::GetMaxPageCount( ) const
+{
+	return m_MaxPages;
+}
+
+BIT_FLOAT32 AtlasPacker::GetOccupancy( const BIT_UINT32 p_Page ) const
+{
+	if( p_Page >= m_Pages.size( ) )
+	{
+		return 0.0f;
+	}
+
+	return static_cast< BIT_FLOAT32 >( m_Pages[ p_Page ].UsedArea ) /
+		static_cast< BIT_FLOAT32 >( m_PageSize.x * m_PageSize.y );
+}
+
+// Private functions
+BIT_BOOL AtlasPacker::Fit( const Page & p_Page, const BIT_MEMSIZE p_Index, const Bit::Vector2_ui32 p_Size, BIT_UINT32 & p_Y ) const
+{
+	// The rectangle rests on the highest segment it spans
+	const std::vector< Segment > & Skyline = p_Page.Skyline;
+	if( Skyline[ p_Index ].X + p_Size.x > m_PageSize.x )
+	{
+		return BIT_FALSE;
+	}
+
+	BIT_UINT32 WidthLeft = p_Size.x;
+	BIT_UINT32 Y = Skyline[ p_Index ].Y;
+
+	for( BIT_MEMSIZE i = p_Index; WidthLeft > 0; i++ )
+	{
+		Y = Skyline[ i ].Y > Y ? Skyline[ i ].Y : Y;
+		if( Y + p_Size.y > m_PageSize.y )
+		{
+			return BIT_FALSE;
+		}
+
+		WidthLeft = WidthLeft > Skyline[ i ].Width ? WidthLeft - Skyline[ i ].Width : 0;
+	}
+
+	p_Y = Y;
+	return BIT_TRUE;
+}
+
+BIT_BOOL AtlasPacker::Insert( Page & p_Page, const Bit::Vector2_ui32 p_Size, Bit::Vector2_ui32 & p_Position )
+{
+	std::vector< Segment > & Skyline = p_Page.Skyline;
+
+	// Find the lowest placement
+	BIT_MEMSIZE BestIndex = Skyline.size( );
+	BIT_UINT32 BestBottom = 0;
+	BIT_UINT32 BestWidth = 0;
+	BIT_UINT32 BestY = 0;
+
+	for( BIT_MEMSIZE i = 0; i < Skyline.size( ); i++ )
+	{
+		BIT_UINT32 Y = 0;
+		if( !Fit( p_Page, i, p_Size, Y ) )
+		{
+			continue;
+		}
+
+		const BIT_UINT32 Bottom = Y + p_Size.y;
+		if( BestIndex == Skyline.size( ) || Bottom < BestBottom ||
+			( Bottom == BestBottom && Skyline[ i ].Width < BestWidth ) )
+		{
+			BestIndex = i;
+			BestBottom = Bottom;
+			BestWidth = Skyline[ i ].Width;
+			BestY = Y;
+		}
+	}
+
+	if( BestIndex == Skyline.size( ) )
+	{
+		return BIT_FALSE;
+	}
+
+	p_Position = Bit::Vector2_ui32( Skyline[ BestIndex ].X, BestY );
+
+	// Raise the skyline under the rectangle
+	Segment NewSegment;
+	NewSegment.X = Skyline[ BestIndex ].X;
+	NewSegment.Y = BestY + p_Size.y;
+	NewSegment.Width = p_Size.x;
+	Skyline.insert( Skyline.begin( ) + BestIndex, NewSegment );
+
+	// Cut the segments covered by the new one
+	for( BIT_MEMSIZE i = BestIndex + 1; i < Skyline.size( ); )
+	{
+		const Segment & Previous = Skyline[ i - 1 ];
+		Segment & Current = Skyline[ i ];
+		const BIT_UINT32 PreviousEnd = Previous.X + Previous.Width;
+
+		if( Current.X >= PreviousEnd )
+		{
+			break;
+		}
+
+		const BIT_UINT32 Shrink = PreviousEnd - Current.X;
+		if( Current.Width > Shrink )
+		{
+			Current.X += Shrink;
+			Current.Width -= Shrink;
+			break;
+		}
+
+		Skyline.erase( Skyline.begin( ) + i );
+	}
+
+	// Merge neighbours at the same height
+	for( BIT_MEMSIZE i = 0; i + 1 < Skyline.size( ); )
+	{
+		if( Skyline[ i ].Y == Skyline[ i + 1 ].Y )
+		{
+			Skyline[ i ].Width += Skyline[ i + 1 ].Width;
+			Skyline.erase( Skyline.begin( ) + i + 1 );
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	return BIT_TRUE;
+}
+
+void AtlasPacker::AddPage( )
+{
+	// An empty page is a single segment at the bottom
+	Segment Bottom;
+	Bottom.X = 0;
+	Bottom.Y = 0;
+	Bottom.Width = m_PageSize.x;
+
+	Page NewPage;
+	NewPage.Skyline.push_back( Bottom );
+	NewPage.UsedArea = 0;
+	m_Pages.push_back( NewPage );
+}
@@ -0,0 +1,1074 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <AudioMixer.hpp>
+#include <cmath>
+#ifdef CPU_FEATURES_SSE2
+	#include <emmintrin.h>
+#endif
+#ifdef CPU_FEATURES_AVX2
+	#include <immintrin.h>
+#endif
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Mixing kernels of one instruction set. The gain of frame i in a block is
+// Gain + Step * ( Start + i ), Start is the frame the span begins at within the block.
+struct MixKernels
+{
+	void ( * MixMono )( const BIT_FLOAT32 *, BIT_FLOAT32 *, BIT_FLOAT32 *, const BIT_UINT32, const BIT_UINT32,
+		const BIT_FLOAT32, const BIT_FLOAT32, const BIT_FLOAT32, const BIT_FLOAT32 );
+	void ( * MixStereo )( const BIT_FLOAT32 *, const BIT_FLOAT32 *, BIT_FLOAT32 *, BIT_FLOAT32 *, const BIT_UINT32, const BIT_UINT32,
+		const BIT_FLOAT32, const BIT_FLOAT32, const BIT_FLOAT32, const BIT_FLOAT32 );
+	BIT_FLOAT32 ( * Peak )( const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_UINT32 );
+	void ( * Convert )( const BIT_FLOAT32 *, const BIT_FLOAT32 *, BIT_SINT16 *, const BIT_UINT32, const BIT_FLOAT32, const BIT_FLOAT32 );
+};
+
+// Scalar kernels
+static void MixMonoScalar( const BIT_FLOAT32 * p_pSource, BIT_FLOAT32 * p_pLeft, BIT_FLOAT32 * p_pRight,
+	const BIT_UINT32 p_Start, const BIT_UINT32 p_Count, const BIT_FLOAT32 p_GainLeft, const BIT_FLOAT32 p_GainRight,
+	const BIT_FLOAT32 p_StepLeft, const BIT_FLOAT32 p_StepRight )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 Frame = static_cast< BIT_FLOAT32 >( p_Start + i );
+		p_pLeft[ i ] += p_pSource[ i ] * ( p_GainLeft + p_StepLeft * Frame );
+		p_pRight[ i ] += p_pSource[ i ] * ( p_GainRight + p_StepRight * Frame );
+	}
+}
+
+static void MixStereoScalar( const BIT_FLOAT32 * p_pSourceLeft, const BIT_FLOAT32 * p_pSourceRight, BIT_FLOAT32 * p_pLeft, BIT_FLOAT32 * p_pRight,
+	const BIT_UINT32 p_Start, const BIT_UINT32 p_Count, const BIT_FLOAT32 p_GainLeft, const BIT_FLOAT32 p_GainRight,
+	const BIT_FLOAT32 p_StepLeft, const BIT_FLOAT32 p_StepRight )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 Frame = static_cast< BIT_FLOAT32 >( p_Start + i );
+		p_pLeft[ i ] += p_pSourceLeft[ i ] * ( p_GainLeft + p_StepLeft * Frame );
+		p_pRight[ i ] += p_pSourceRight[ i ] * ( p_GainRight + p_StepRight * Frame );
+	}
+}
+
+static BIT_FLOAT32 PeakScalar( const BIT_FLOAT32 * p_pLeft, const BIT_FLOAT32 * p_pRight, const BIT_UINT32 p_Count )
+{
+	BIT_FLOAT32 Peak = 0.0f;
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 Left = fabsf( p_pLeft[ i ] );
+		const BIT_FLOAT32 Right = fabsf( p_pRight[ i ] );
+		Peak = Left > Peak ? Left : Peak;
+		Peak = Right > Peak ? Right : Peak;
+	}
+	return Peak;
+}
+
+// Clamps and rounds half to even like the SIMD conversions do, lrintf is missing before Visual Studio 2013
+static BIT_SINT16 ConvertSample( const BIT_FLOAT32 p_Sample )
+{
+	BIT_FLOAT32 Sample = p_Sample < 32767.0f ? p_Sample : 32767.0f;
+	Sample = Sample > -32768.0f ? Sample : -32768.0f;
+
+	const BIT_FLOAT32 Floor = floorf( Sample );
+	const BIT_FLOAT32 Fraction = Sample - Floor;
+	BIT_SINT32 Integer = static_cast< BIT_SINT32 >( Floor );
+	if( Fraction > 0.5f || ( Fraction == 0.5f && ( Integer & 1 ) ) )
+	{
+		Integer++;
+	}
+
+	return static_cast< BIT_SINT16 >( Integer );
+}
+
+static void ConvertScalar( const BIT_FLOAT32 * p_pLeft, const BIT_FLOAT32 * p_pRight, BIT_SINT16 * p_pFrames,
+	const BIT_UINT32 p_Count, const BIT_FLOAT32 p_Gain, const BIT_FLOAT32 p_Step )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 Scale = ( p_Gain + p_Step * static_cast< BIT_FLOAT32 >( i ) ) * 32767.0f;
+		p_pFrames[ i * 2 ] = ConvertSample( p_pLeft[ i ] * Scale );
+		p_pFrames[ i * 2 + 1 ] = ConvertSample( p_pRight[ i ] * Scale );
+	}
+}
+
+static const MixKernels ScalarKernels =
+{
+	MixMonoScalar, MixStereoScalar, PeakScalar, ConvertScalar
+};
+
+#ifdef CPU_FEATURES_SSE2
+// SSE2 kernels, four frames at a time
+static void MixMonoSSE2( const BIT_FLOAT32 * p_pSource, BIT_FLOAT32 * p_pLeft, BIT_FLOAT32 * p_pRight,
+	const BIT_UINT32 p_Start, const BIT_UINT32 p_Count, const BIT_FLOAT32 p_GainLeft, const BIT_FLOAT32 p_GainRight,
+	const BIT_FLOAT32 p_StepLeft, const BIT_FLOAT32 p_StepRight )
+{
+	const __m128 Offsets = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+	const __m128 GainLeft = _mm_set1_ps( p_GainLeft );
+	const __m128 GainRight = _mm_set1_ps( p_GainRight );
+	const __m128 StepLeft = _mm_set1_ps( p_StepLeft );
+	const __m128 StepRight = _mm_set1_ps( p_StepRight );
+
+	BIT_UINT32 i = 0;
+	for( ; i + 4 <= p_Count; i += 4 )
+	{
+		const __m128 Frame = _mm_add_ps( _mm_set1_ps( static_cast< BIT_FLOAT32 >( p_Start + i ) ), Offsets );
+		const __m128 Source = _mm_loadu_ps( p_pSource + i );
+		const __m128 Left = _mm_mul_ps( Source, _mm_add_ps( GainLeft, _mm_mul_ps( StepLeft, Frame ) ) );
+		const __m128 Right = _mm_mul_ps( Source, _mm_add_ps( GainRight, _mm_mul_ps( StepRight, Frame ) ) );
+		_mm_storeu_ps( p_pLeft + i, _mm_add_ps( _mm_loadu_ps( p_pLeft + i ), Left ) );
+		_mm_storeu_ps( p_pRight + i, _mm_add_ps( _mm_loadu_ps( p_pRight + i ), Right ) );
+	}
+
+	MixMonoScalar( p_pSource + i, p_pLeft + i, p_pRight + i, p_Start + i, p_Count - i, p_GainLeft, p_GainRight, p_StepLeft, p_StepRight );
+}
+
+static void MixStereoSSE2( const BIT_FLOAT32 * p_pSourceLeft, const BIT_FLOAT32 * p_pSourceRight, BIT_FLOAT32 * p_pLeft, BIT_FLOAT32 * p_pRight,
+	const BIT_UINT32 p_Start, const BIT_UINT32 p_Count, const BIT_FLOAT32 p_GainLeft, const BIT_FLOAT32 p_GainRight,
+	const BIT_FLOAT32 p_StepLeft, const BIT_FLOAT32 p_StepRight )
+{
+	const __m128 Offsets = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+	const __m128 GainLeft = _mm_set1_ps( p_GainLeft );
+	const __m128 GainRight = _mm_set1_ps( p_GainRight );
+	const __m128 StepLeft = _mm_set1_ps( p_StepLeft );
+	const __m128 StepRight = _mm_set1_ps( p_StepRight );
+
+	BIT_UINT32 i = 0;
+	for( ; i + 4 <= p_Count; i += 4 )
+	{
+		const __m128 Frame = _mm_add_ps( _mm_set1_ps( static_cast< BIT_FLOAT32 >( p_Start + i ) ), Offsets );
+		const __m128 Left = _mm_mul_ps( _mm_loadu_ps( p_pSourceLeft + i ), _mm_add_ps( GainLeft, _mm_mul_ps( StepLeft, Frame ) ) );
+		const __m128 Right = _mm_mul_ps( _mm_loadu_ps( p_pSourceRight + i ), _mm_add_ps( GainRight, _mm_mul_ps( StepRight, Frame ) ) );
+		_mm_storeu_ps( p_pLeft + i, _mm_add_ps( _mm_loadu_ps( p_pLeft + i ), Left ) );
+		_mm_storeu_ps( p_pRight + i, _mm_add_ps( _mm_loadu_ps( p_pRight + i ), Right ) );
+	}
+
+	MixStereoScalar( p_pSourceLeft + i, p_pSourceRight + i, p_pLeft + i, p_pRight + i, p_Start + i, p_Count - i,
+		p_GainLeft, p_GainRight, p_StepLeft, p_StepRight );
+}
+
+static BIT_FLOAT32 PeakSSE2( const BIT_FLOAT32 * p_pLeft, const BIT_FLOAT32 * p_pRight, const BIT_UINT32 p_Count )
+{
+	const __m128 AbsoluteMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+	__m128 Peak = _mm_setzero_ps( );
+
+	BIT_UINT32 i = 0;
+	for( ; i + 4 <= p_Count; i += 4 )
+	{
+		Peak = _mm_max_ps( Peak, _mm_and_ps( _mm_loadu_ps( p_pLeft + i ), AbsoluteMask ) );
+		Peak = _mm_max_ps( Peak, _mm_and_ps( _mm_loadu_ps( p_pRight + i ), AbsoluteMask ) );
+	}
+
+	BIT_FLOAT32 Peaks[ 4 ];
+	_mm_storeu_ps( Peaks, Peak );
+	BIT_FLOAT32 Result = PeakScalar( p_pLeft + i, p_pRight + i, p_Count - i );
+	for( BIT_UINT32 j = 0; j < 4; j++ )
+	{
+		Result = Peaks[ j ] > Result ? Peaks[ j ] : Result;
+	}
+	return Result;
+}
+
+static void ConvertSSE2( const BIT_FLOAT32 * p_pLeft, const BIT_FLOAT32 * p_pRight, BIT_SINT16 * p_pFrames,
+	const BIT_UINT32 p_Count, const BIT_FLOAT32 p_Gain, const BIT_FLOAT32 p_Step )
+{
+	const __m128 Offsets = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+	const __m128 Gain = _mm_set1_ps( p_Gain );
+	const __m128 Step = _mm_set1_ps( p_Step );
+	const __m128 Range = _mm_set1_ps( 32767.0f );
+	const __m128 Minimum = _mm_set1_ps( -32768.0f );
+
+	BIT_UINT32 i = 0;
+	for( ; i + 4 <= p_Count; i += 4 )
+	{
+		const __m128 Frame = _mm_add_ps( _mm_set1_ps( static_cast< BIT_FLOAT32 >( i ) ), Offsets );
+		const __m128 Scale = _mm_mul_ps( _mm_add_ps( Gain, _mm_mul_ps( Step, Frame ) ), Range );
+
+		// Clamp before converting, out of range floats turn into the smallest integer
+		const __m128 Left = _mm_max_ps( _mm_min_ps( _mm_mul_ps( _mm_loadu_ps( p_pLeft + i ), Scale ), Range ), Minimum );
+		const __m128 Right = _mm_max_ps( _mm_min_ps( _mm_mul_ps( _mm_loadu_ps( p_pRight + i ), Scale ), Range ), Minimum );
+
+		// L0 L1 L2 L3 R0 R1 R2 R3 -> L0 R0 L1 R1 L2 R2 L3 R3
+		const __m128i Packed = _mm_packs_epi32( _mm_cvtps_epi32( Left ), _mm_cvtps_epi32( Right ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i * >( p_pFrames + i * 2 ), _mm_unpacklo_epi16( Packed, _mm_srli_si128( Packed, 8 ) ) );
+	}
+
+	// The tail uses the gain of its own frame index, the same as the lanes above
+	for( ; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 Scale = ( p_Gain + p_Step * static_cast< BIT_FLOAT32 >( i ) ) * 32767.0f;
+		p_pFrames[ i * 2 ] = ConvertSample( p_pLeft[ i ] * Scale );
+		p_pFrames[ i * 2 + 1 ] = ConvertSample( p_pRight[ i ] * Scale );
+	}
+}
+
+static const MixKernels SSE2Kernels =
+{
+	MixMonoSSE2, MixStereoSSE2, PeakSSE2, ConvertSSE2
+};
+#endif
+
+#if defined( CPU_FEATURES_AVX2 ) && defined( CPU_FEATURES_SSE2 )
+// AVX2 kernels, eight frames at a time. The bus work per block is small, it stays on SSE2.
+CPU_FEATURES_AVX2_FUNCTION
+static void MixMonoAVX2( const BIT_FLOAT32 * p_pSource, BIT_FLOAT32 * p_pLeft, BIT_FLOAT32 * p_pRight,
+	const BIT_UINT32 p_Start, const BIT_UINT32 p_Count, const BIT_FLOAT32 p_GainLeft, const BIT_FLOAT32 p_GainRight,
+	const BIT_FLOAT32 p_StepLeft, const BIT_FLOAT32 p_StepRight )
+{
+	const __m256 Offsets = _mm256_set_ps( 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f );
+	const __m256 GainLeft = _mm256_set1_ps( p_GainLeft );
+	const __m256 GainRight = _mm256_set1_ps( p_GainRight );
+	const __m256 StepLeft = _mm256_set1_ps( p_StepLeft );
+	const __m256 StepRight = _mm256_set1_ps( p_StepRight );
+
+	BIT_UINT32 i = 0;
+	for( ; i + 8 <= p_Count; i += 8 )
+	{
+		const __m256 Frame = _mm256_add_ps( _mm256_set1_ps( static_cast< BIT_FLOAT32 >( p_Start + i ) ), Offsets );
+		const __m256 Source = _mm256_loadu_ps( p_pSource + i );
+		const __m256 Left = _mm256_mul_ps( Source, _mm256_add_ps( GainLeft, _mm256_mul_ps( StepLeft, Frame ) ) );
+		const __m256 Right = _mm256_mul_ps( Source, _mm256_add_ps( GainRight, _mm256_mul_ps( StepRight, Frame ) ) );
+		_mm256_storeu_ps( p_pLeft + i, _mm256_add_ps( _mm256_loadu_ps( p_pLeft + i ), Left ) );
+		_mm256_storeu_ps( p_pRight + i, _mm256_add_ps( _mm256_loadu_ps( p_pRight + i ), Right ) );
+	}
+
+	MixMonoScalar( p_pSource + i, p_pLeft + i, p_pRight + i, p_Start + i, p_Count - i, p_GainLeft, p_GainRight, p_StepLeft, p_StepRight );
+}
+
+CPU_FEATURES_AVX2_FUNCTION
+static void MixStereoAVX2( const BIT_FLOAT32 * p_pSourceLeft, const BIT_FLOAT32 * p_pSourceRight, BIT_FLOAT32 * p_pLeft, BIT_FLOAT32 * p_pRight,
+	const BIT_UINT32 p_Start, const BIT_UINT32 p_Count, const BIT_FLOAT32 p_GainLeft, const BIT_FLOAT32 p_GainRight,
+	const BIT_FLOAT32 p_StepLeft, const BIT_FLOAT32 p_StepRight )
+{
+	const __m256 Offsets = _mm256_set_ps( 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f );
+	const __m256 GainLeft = _mm256_set1_ps( p_GainLeft );
+	const __m256 GainRight = _mm256_set1_ps( p_GainRight );
+	const __m256 StepLeft = _mm256_set1_ps( p_StepLeft );
+	const __m256 StepRight = _mm256_set1_ps( p_StepRight );
+
+	BIT_UINT32 i = 0;
+	for( ; i + 8 <= p_Count; i += 8 )
+	{
+		const __m256 Frame = _mm256_add_ps( _mm256_set1_ps( static_cast< BIT_FLOAT32 >( p_Start + i ) ), Offsets );
+		const __m256 Left = _mm256_mul_ps( _mm256_loadu_ps( p_pSourceLeft + i ), _mm256_add_ps( GainLeft, _mm256_mul_ps( StepLeft, Frame ) ) );
+		const __m256 Right = _mm256_mul_ps( _mm256_loadu_ps( p_pSourceRight + i ), _mm256_add_ps( GainRight, _mm256_mul_ps( StepRight, Frame ) ) );
+		_mm256_storeu_ps( p_pLeft + i, _mm256_add_ps( _mm256_loadu_ps( p_pLeft + i ), Left ) );
+		_mm256_storeu_ps( p_pRight + i, _mm256_add_ps( _mm256_loadu_ps( p_pRight + i ), Right ) );
+	}
+
+	MixStereoScalar( p_pSourceLeft + i, p_pSourceRight + i, p_pLeft + i, p_pRight + i, p_Start + i, p_Count - i,
+		p_GainLeft, p_GainRight, p_StepLeft, p_StepRight );
+}
+
+static const MixKernels AVX2Kernels =
+{
+	MixMonoAVX2, MixStereoAVX2, PeakSSE2, ConvertSSE2
+};
+#endif
+
+static const MixKernels & GetKernels( const CpuFeatures::eInstructionSet p_InstructionSet )
+{
+	switch( p_InstructionSet )
+	{
+#if defined( CPU_FEATURES_AVX2 ) && defined( CPU_FEATURES_SSE2 )
+		case CpuFeatures::InstructionSet_AVX2:
+			return AVX2Kernels;
+#endif
+#ifdef CPU_FEATURES_SSE2
+		case CpuFeatures::InstructionSet_SSE2:
+			return SSE2Kernels;
+#endif
+		default:
+			break;
+	}
+
+	return ScalarKernels;
+}
+
+// Constructor/destructor
+AudioMixer::AudioMixer( ) :
+	m_SampleRate( 0 ),
+	m_BlockSize( 0 ),
+	m_MasterGain( 1.0f ),
+	m_LimiterThreshold( 0.98f ),
+	m_LimiterGain( 1.0f ),
+	m_LimiterRelease( 0.0f ),
+	m_VoiceFrameCount( 0 ),
+	m_InstructionSet( CpuFeatures::GetSupportedInstructionSet( ) ),
+	m_ResampleQuality( ResamplerFilter::Quality_Medium ),
+	m_CompressSounds( BIT_FALSE )
+{
+}
+
+AudioMixer::~AudioMixer( )
+{
+	Close( );
+}
+
+// Public functions
+BIT_UINT32 AudioMixer::Open( const BIT_UINT32 p_SampleRate, const BIT_UINT32 p_MaxVoiceCount, const BIT_UINT32 p_BlockSize )
+{
+	Close( );
+
+	// The handles keep the voice index in the low 16 bits
+	if( p_SampleRate == 0 || p_MaxVoiceCount == 0 || p_MaxVoiceCount > 0xFFFF || p_BlockSize == 0 )
+	{
+		bitTrace( "[AudioMixer::Open] Invalid sample rate, voice count or block size\n" );
+		return BIT_ERROR;
+	}
+
+	m_SampleRate = p_SampleRate;
+	m_BlockSize = p_BlockSize;
+	m_Left.resize( p_BlockSize );
+	m_Right.resize( p_BlockSize );
+	m_Output.resize( p_BlockSize * 2 );
+	m_VoiceLeft.resize( p_BlockSize );
+	m_VoiceRight.resize( p_BlockSize );
+
+	Voice EmptyVoice;
+	EmptyVoice.Sound = 0;
+	EmptyVoice.Position = 0;
+	EmptyVoice.Generation = 1;
+	EmptyVoice.Gain = 0.0f;
+	EmptyVoice.Pan = 0.0f;
+	EmptyVoice.GainLeft = 0.0f;
+	EmptyVoice.GainRight = 0.0f;
+	EmptyVoice.Pitch = 1.0f;
+	EmptyVoice.Silence = 0;
+	EmptyVoice.Active = BIT_FALSE;
+	EmptyVoice.Loop = BIT_FALSE;
+	EmptyVoice.Stopping = BIT_FALSE;
+	EmptyVoice.Resampled = BIT_FALSE;
+	m_Voices.assign( p_MaxVoiceCount, EmptyVoice );
+	m_Resamplers.assign( p_MaxVoiceCount, Resampler( ) );
+
+	DecodedBlock EmptyBlock;
+	EmptyBlock.Block = 0xFFFFFFFF;
+	EmptyBlock.FrameCount = 0;
+	m_DecodedBlocks.assign( p_MaxVoiceCount, EmptyBlock );
+
+	// One filter for pitches up to 1 and one for every quarter octave above
+	m_PitchFilters.assign( 9, ResamplerFilter( ) );
+	CreatePitchFilters( );
+
+	m_FreeVoices.reserve( p_MaxVoiceCount );
+	for( BIT_UINT32 i = p_MaxVoiceCount; i > 0; i-- )
+	{
+		m_FreeVoices.push_back( i - 1 );
+	}
+
+	// Recover from limiting with a time constant of 100 ms
+	m_LimiterGain = 1.0f;
+	m_LimiterRelease = 1.0f - expf( -static_cast< BIT_FLOAT32 >( p_BlockSize ) / ( static_cast< BIT_FLOAT32 >( p_SampleRate ) * 0.1f ) );
+	m_VoiceFrameCount = 0;
+
+	return BIT_OK;
+}
+
+void AudioMixer::Close( )
+{
+	m_Sounds.clear( );
+	m_Voices.clear( );
+	m_FreeVoices.clear( );
+	m_Left.clear( );
+	m_Right.clear( );
+	m_Output.clear( );
+	m_DecodedBlocks.clear( );
+	m_Resamplers.clear( );
+	m_PitchFilters.clear( );
+	m_VoiceLeft.clear( );
+	m_VoiceRight.clear( );
+	m_SampleRate = 0;
+	m_BlockSize = 0;
+}
+
+BIT_SINT32 AudioMixer::LoadSound( const Bit::AudioBuffer & p_AudioBuffer )
+{
+	const BIT_UINT16 Channels = p_AudioBuffer.GetChannelCount( );
+	const BIT_UINT16 Bits = p_AudioBuffer.GetBitsPerSample( );
+	if( ( Channels != 1 && Channels != 2 ) || ( Bits != 8 && Bits != 16 ) )
+	{
+		bitTrace( "[AudioMixer::LoadSound] Unsupported audio format\n" );
+		return -1;
+	}
+
+	// 8 bit samples are unsigned, 16 bit signed
+	const BIT_UINT32 SampleCount = p_AudioBuffer.GetBufferSize( ) / ( Bits / 8 );
+	std::vector< BIT_FLOAT32 > Samples( SampleCount );
+	const BIT_UINT8 * pData = p_AudioBuffer.GetBuffer( );
+	for( BIT_UINT32 i = 0; i < SampleCount; i++ )
+	{
+		if( Bits == 8 )
+		{
+			Samples[ i ] = static_cast< BIT_FLOAT32 >( static_cast< BIT_SINT32 >( pData[ i ] ) - 128 ) / 128.0f;
+		}
+		else
+		{
+			const BIT_SINT16 Sample = static_cast< BIT_SINT16 >( pData[ i * 2 ] | ( pData[ i * 2 + 1 ] << 8 ) );
+			Samples[ i ] = static_cast< BIT_FLOAT32 >( Sample ) / 32768.0f;
+		}
+	}
+
+	return LoadSound( SampleCount ? &Samples[ 0 ] : BIT_NULL, SampleCount / Channels, Channels, p_AudioBuffer.GetSampleRate( ) );
+}
+
+BIT_SINT32 AudioMixer::LoadSound( const BIT_FLOAT32 * p_pSamples, const BIT_UINT32 p_FrameCount, const BIT_UINT16 p_ChannelCount,
+	const BIT_UINT32 p_SampleRate )
+{
+	if( m_SampleRate == 0 )
+	{
+		bitTrace( "[AudioMixer::LoadSound] The mixer is not open\n" );
+		return -1;
+	}
+
+	if( p_pSamples == BIT_NULL || p_FrameCount == 0 || ( p_ChannelCount != 1 && p_ChannelCount != 2 ) )
+	{
+		bitTrace( "[AudioMixer::LoadSound] Empty sound or unsupported channel count\n" );
+		return -1;
+	}
+
+	// Resample once here rather than every time the sound plays
+	if( p_SampleRate != m_SampleRate )
+	{
+		std::vector< BIT_FLOAT32 > Resampled;
+		if( Resampler::Convert( p_pSamples, p_FrameCount, p_ChannelCount, p_SampleRate, m_SampleRate, m_ResampleQuality,
+			Resampled ) != BIT_OK )
+		{
+			bitTrace( "[AudioMixer::LoadSound] Can not resample from %u Hz to %u Hz\n", p_SampleRate, m_SampleRate );
+			return -1;
+		}
+
+		return LoadSound( &Resampled[ 0 ], static_cast< BIT_UINT32 >( Resampled.size( ) / p_ChannelCount ),
+			p_ChannelCount, m_SampleRate );
+	}
+
+	if( m_CompressSounds )
+	{
+		return LoadCompressedSound( p_pSamples, p_FrameCount, p_ChannelCount );
+	}
+
+	// Split the channels, the kernels read one channel at a time
+	m_Sounds.push_back( Sound( ) );
+	Sound & NewSound = m_Sounds.back( );
+	NewSound.FrameCount = p_FrameCount;
+	NewSound.ChannelCount = p_ChannelCount;
+	NewSound.Left.resize( p_FrameCount );
+	if( p_ChannelCount == 2 )
+	{
+		NewSound.Right.resize( p_FrameCount );
+	}
+
+	for( BIT_UINT32 i = 0; i < p_FrameCount; i++ )
+	{
+		NewSound.Left[ i ] = p_pSamples[ i * p_ChannelCount ];
+		if( p_ChannelCount == 2 )
+		{
+			NewSound.Right[ i ] = p_pSamples[ i * 2 + 1 ];
+		}
+	}
+
+	return static_cast< BIT_SINT32 >( m_Sounds.size( ) - 1 );
+}
+
+BIT_SINT32 AudioMixer::LoadSound( const AdpcmBuffer & p_AdpcmBuffer )
+{
+	if( m_SampleRate == 0 )
+	{
+		bitTrace( "[AudioMixer::LoadSound] The mixer is not open\n" );
+		return -1;
+	}
+
+	if( p_AdpcmBuffer.IsEmpty( ) )
+	{
+		bitTrace( "[AudioMixer::LoadSound] Empty sound\n" );
+		return -1;
+	}
+
+	// Decoded, resampled and encoded again, so it stays compressed
+	if( p_AdpcmBuffer.GetSampleRate( ) != m_SampleRate )
+	{
+		const BIT_UINT16 ChannelCount = p_AdpcmBuffer.GetChannelCount( );
+		const BIT_UINT32 FramesPerBlock = p_AdpcmBuffer.GetFramesPerBlock( );
+		std::vector< BIT_SINT16 > Decoded( p_AdpcmBuffer.GetBlockCount( ) * FramesPerBlock * ChannelCount );
+		for( BIT_UINT32 i = 0; i < p_AdpcmBuffer.GetBlockCount( ); i++ )
+		{
+			p_AdpcmBuffer.DecodeBlock( i, &Decoded[ i * FramesPerBlock * ChannelCount ] );
+		}
+
+		std::vector< BIT_FLOAT32 > Samples( p_AdpcmBuffer.GetFrameCount( ) * ChannelCount );
+		for( BIT_UINT32 i = 0; i < Samples.size( ); i++ )
+		{
+			Samples[ i ] = static_cast< BIT_FLOAT32 >( Decoded[ i ] ) / 32768.0f;
+		}
+
+		std::vector< BIT_FLOAT32 > Resampled;
+		if( Resampler::Convert( &Samples[ 0 ], p_AdpcmBuffer.GetFrameCount( ), ChannelCount, p_AdpcmBuffer.GetSampleRate( ),
+			m_SampleRate, m_ResampleQuality, Resampled ) != BIT_OK )
+		{
+			bitTrace( "[AudioMixer::LoadSound] Can not resample from %u Hz to %u Hz\n", p_AdpcmBuffer.GetSampleRate( ), m_SampleRate );
+			return -1;
+		}
+
+		return LoadCompressedSound( &Resampled[ 0 ], static_cast< BIT_UINT32 >( Resampled.size( ) / ChannelCount ), ChannelCount );
+	}
+
+	m_Sounds.push_back( Sound( ) );
+	Sound & NewSound = m_Sounds.back( );
+	NewSound.Compressed = p_AdpcmBuffer;
+	NewSound.FrameCount = p_AdpcmBuffer.GetFrameCount( );
+	NewSound.ChannelCount = p_AdpcmBuffer.GetChannelCount( );
+
+	// Every voice can decode a block of the largest sound without allocating while it mixes
+	const BIT_UINT32 FramesPerBlock = p_AdpcmBuffer.GetFramesPerBlock( );
+	for( BIT_UINT32 i = 0; i < m_DecodedBlocks.size( ); i++ )
+	{
+		if( m_DecodedBlocks[ i ].Left.size( ) < FramesPerBlock )
+		{
+			m_DecodedBlocks[ i ].Left.resize( FramesPerBlock );
+			m_DecodedBlocks[ i ].Right.resize( FramesPerBlock );
+		}
+	}
+
+	return static_cast< BIT_SINT32 >( m_Sounds.size( ) - 1 );
+}
+
+AudioMixer::VoiceHandle AudioMixer::Play( const BIT_UINT32 p_Sound, const BIT_FLOAT32 p_Gain, const BIT_FLOAT32 p_Pan,
+	const BIT_BOOL p_Loop )
+{
+	if( p_Sound >= m_Sounds.size( ) || m_FreeVoices.size( ) == 0 )
+	{
+		return InvalidVoice;
+	}
+
+	const BIT_UINT32 Index = m_FreeVoices.back( );
+	m_FreeVoices.pop_back( );
+
+	Voice & NewVoice = m_Voices[ Index ];
+	NewVoice.Sound = p_Sound;
+	NewVoice.Position = 0;
+	NewVoice.Gain = p_Gain;
+	NewVoice.Pan = p_Pan < -1.0f ? -1.0f : ( p_Pan > 1.0f ? 1.0f : p_Pan );
+	NewVoice.Active = BIT_TRUE;
+	NewVoice.Pitch = 1.0f;
+	NewVoice.Silence = 0;
+	NewVoice.Loop = p_Loop;
+	NewVoice.Stopping = BIT_FALSE;
+	NewVoice.Resampled = BIT_FALSE;
+	m_DecodedBlocks[ Index ].Block = 0xFFFFFFFF;
+
+	// Sounds start at their gain, they begin at silence anyway
+	TargetGains( NewVoice, NewVoice.GainLeft, NewVoice.GainRight );
+
+	// A new generation makes the handles of the previous sound invalid
+	NewVoice.Generation = ( NewVoice.Generation + 1 ) & 0xFFFF;
+	NewVoice.Generation = NewVoice.Generation ? NewVoice.Generation : 1;
+
+	return ( NewVoice.Generation << 16 ) | Index;
+}
+
+void AudioMixer::Stop( const VoiceHandle p_Voice )
+{
+	// Faded out over the next block, cutting it would click
+	Voice * pVoice = GetVoice( p_Voice );
+	if( pVoice )
+	{
+		pVoice->Stopping = BIT_TRUE;
+	}
+}
+
+void AudioMixer::StopAll( )
+{
+	for( BIT_UINT32 i = 0; i < m_Voices.size( ); i++ )
+	{
+		if( m_Voices[ i ].Active )
+		{
+			Release( i );
+		}
+	}
+}
+
+void AudioMixer::Mix( BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount )
+{
+	for( BIT_UINT32 i = 0; i < p_FrameCount; i += m_BlockSize )
+	{
+		const BIT_UINT32 Count = p_FrameCount - i < m_BlockSize ? p_FrameCount - i : m_BlockSize;
+		MixBlock( p_pFrames + i * 2, Count );
+	}
+}
+
+BIT_UINT32 AudioMixer::Render( AudioOutput & p_Output, const BIT_UINT32 p_FrameCount )
+{
+	if( m_BlockSize == 0 )
+	{
+		bitTrace( "[AudioMixer::Render] The mixer is not open\n" );
+		return BIT_ERROR;
+	}
+
+	for( BIT_UINT32 i = 0; i < p_FrameCount; i += m_BlockSize )
+	{
+		const BIT_UINT32 Count = p_FrameCount - i < m_BlockSize ? p_FrameCount - i : m_BlockSize;
+		MixBlock( &m_Output[ 0 ], Count );
+		if( p_Output.Write( &m_Output[ 0 ], Count ) != BIT_OK )
+		{
+			return BIT_ERROR;
+		}
+	}
+
+	return BIT_OK;
+}
+
+void AudioMixer::ResetStatistics( )
+{
+	m_VoiceFrameCount = 0;
+}
+
+// Set functions
+void AudioMixer::SetGain( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Gain )
+{
+	Voice * pVoice = GetVoice( p_Voice );
+	if( pVoice )
+	{
+		pVoice->Gain = p_Gain;
+	}
+}
+
+void AudioMixer::SetPan( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Pan )
+{
+	Voice * pVoice = GetVoice( p_Voice );
+	if( pVoice )
+	{
+		pVoice->Pan = p_Pan < -1.0f ? -1.0f : ( p_Pan > 1.0f ? 1.0f : p_Pan );
+	}
+}
+
+void AudioMixer::SetPitch( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Pitch )
+{
+	Voice * pVoice = GetVoice( p_Voice );
+	if( pVoice == BIT_NULL )
+	{
+		return;
+	}
+
+	pVoice->Pitch = p_Pitch < 0.125f ? 0.125f : ( p_Pitch > 4.0f ? 4.0f : p_Pitch );
+
+	// Voices at the original pitch skip the resampler until the pitch is first changed.
+	// The buffers of the resampler are already sized, opening it only starts the stream over.
+	if( !pVoice->Resampled && pVoice->Pitch != 1.0f )
+	{
+		m_Resamplers[ p_Voice & 0xFFFF ].Open( GetPitchFilter( pVoice->Pitch ), m_Sounds[ pVoice->Sound ].ChannelCount,
+			pVoice->Pitch, m_BlockSize * 4 );
+		pVoice->Resampled = BIT_TRUE;
+	}
+}
+
+void AudioMixer::SetResampleQuality( const ResamplerFilter::eQuality p_Quality )
+{
+	m_ResampleQuality = p_Quality;
+	if( m_PitchFilters.size( ) )
+	{
+		CreatePitchFilters( );
+	}
+}
+
+void AudioMixer::SetCompressSounds( const BIT_BOOL p_Compress )
+{
+	m_CompressSounds = p_Compress;
+}
+
+void AudioMixer::SetMasterGain( const BIT_FLOAT32 p_Gain )
+{
+	m_MasterGain = p_Gain;
+}
+
+void AudioMixer::SetLimiterThreshold( const BIT_FLOAT32 p_Threshold )
+{
+	m_LimiterThreshold = p_Threshold > 0.0f ? p_Threshold : 0.0f;
+}
+
+BIT_UINT32 AudioMixer::SetInstructionSet( const CpuFeatures::eInstructionSet p_InstructionSet )
+{
+	if( p_InstructionSet > CpuFeatures::GetSupportedInstructionSet( ) )
+	{
+		bitTrace( "[AudioMixer::SetInstructionSet] %s is not supported by this CPU\n",
+			CpuFeatures::GetInstructionSetName( p_InstructionSet ) );
+		return BIT_ERROR;
+	}
+
+	m_InstructionSet = p_InstructionSet;
+	for( BIT_UINT32 i = 0; i < m_Resamplers.size( ); i++ )
+	{
+		m_Resamplers[ i ].SetInstructionSet( p_InstructionSet );
+	}
+	return BIT_OK;
+}
+
+// Get functions
+BIT_BOOL AudioMixer::IsPlaying( const VoiceHandle p_Voice ) const
+{
+	const BIT_UINT32 Index = p_Voice & 0xFFFF;
+	return Index < m_Voices.size( ) && m_Voices[ Index ].Active && m_Voices[ Index ].Generation == ( p_Voice >> 16 );
+}
+
+BIT_UINT32 AudioMixer::GetSampleRate( ) const
+{
+	return m_SampleRate;
+}
+
+BIT_UINT32 AudioMixer::GetBlockSize( ) const
+{
+	return m_BlockSize;
+}
+
+BIT_UINT32 AudioMixer::GetActiveCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Voices.size( ) - m_FreeVoices.size( ) );
+}
+
+BIT_FLOAT32 AudioMixer::GetLimiterGain( ) const
+{
+	return m_LimiterGain;
+}
+
+CpuFeatures::eInstructionSet AudioMixer::GetInstructionSet( ) const
+{
+	return m_InstructionSet;
+}
+
+ResamplerFilter::eQuality AudioMixer::GetResampleQuality( ) const
+{
+	return m_ResampleQuality;
+}
+
+BIT_BOOL AudioMixer::GetCompressSounds( ) const
+{
+	return m_CompressSounds;
+}
+
+BIT_UINT32 AudioMixer::GetSoundMemory( ) const
+{
+	BIT_UINT32 Size = 0;
+	for( BIT_UINT32 i = 0; i < m_Sounds.size( ); i++ )
+	{
+		Size += m_Sounds[ i ].Compressed.GetDataSize( );
+		Size += static_cast< BIT_UINT32 >( ( m_Sounds[ i ].Left.size( ) + m_Sounds[ i ].Right.size( ) ) * sizeof( BIT_FLOAT32 ) );
+	}
+	return Size;
+}
+
+BIT_UINT64 AudioMixer::GetVoiceFrameCount( ) const
+{
+	return m_VoiceFrameCount;
+}
+
+// Private functions
+BIT_SINT32 AudioMixer::LoadCompressedSound( const BIT_FLOAT32 * p_pSamples, const BIT_UINT32 p_FrameCount,
+	const BIT_UINT16 p_ChannelCount )
+{
+	std::vector< BIT_SINT16 > Samples( p_FrameCount * p_ChannelCount );
+	for( BIT_UINT32 i = 0; i < Samples.size( ); i++ )
+	{
+		// Rounded like the mixer output, the decoder scales back by 1 / 32768
+		Samples[ i ] = ConvertSample( p_pSamples[ i ] * 32768.0f );
+	}
+
+	AdpcmBuffer Compressed;
+	if( Compressed.Encode( &Samples[ 0 ], p_FrameCount, p_ChannelCount, m_SampleRate ) != BIT_OK )
+	{
+		return -1;
+	}
+
+	return LoadSound( Compressed );
+}
+
+void AudioMixer::MixBlock( BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount )
+{
+	const MixKernels & Kernels = GetKernels( m_InstructionSet );
+
+	for( BIT_UINT32 i = 0; i < p_FrameCount; i++ )
+	{
+		m_Left[ i ] = 0.0f;
+		m_Right[ i ] = 0.0f;
+	}
+
+	for( BIT_UINT32 i = 0; i < m_Voices.size( ); i++ )
+	{
+		if( m_Voices[ i ].Active )
+		{
+			MixVoice( i, p_FrameCount );
+			if( !m_Voices[ i ].Active )
+			{
+				Release( i );
+			}
+		}
+	}
+
+	// Pull the gain down at once if the bus would clip, let it back up slowly
+	const BIT_FLOAT32 Peak = Kernels.Peak( &m_Left[ 0 ], &m_Right[ 0 ], p_FrameCount ) * m_MasterGain;
+	const BIT_FLOAT32 Target = Peak > m_LimiterThreshold ? m_LimiterThreshold / Peak : 1.0f;
+	BIT_FLOAT32 StartGain = m_LimiterGain;
+	BIT_FLOAT32 EndGain = m_LimiterGain + ( 1.0f - m_LimiterGain ) * m_LimiterRelease;
+	if( Target < EndGain )
+	{
+		StartGain = Target < StartGain ? Target : StartGain;
+		EndGain = Target;
+	}
+	m_LimiterGain = EndGain;
+
+	Kernels.Convert( &m_Left[ 0 ], &m_Right[ 0 ], p_pFrames, p_FrameCount, StartGain * m_MasterGain,
+		( EndGain - StartGain ) * m_MasterGain / static_cast< BIT_FLOAT32 >( p_FrameCount ) );
+}
+
+void AudioMixer::MixVoice( const BIT_UINT32 p_Index, const BIT_UINT32 p_FrameCount )
+{
+	const MixKernels & Kernels = GetKernels( m_InstructionSet );
+	Voice & CurrentVoice = m_Voices[ p_Index ];
+	const Sound & CurrentSound = m_Sounds[ CurrentVoice.Sound ];
+
+	// Ramp from the gains of the last block to the new ones
+	BIT_FLOAT32 TargetLeft = 0.0f;
+	BIT_FLOAT32 TargetRight = 0.0f;
+	if( !CurrentVoice.Stopping )
+	{
+		TargetGains( CurrentVoice, TargetLeft, TargetRight );
+	}
+
+	if( CurrentVoice.Resampled )
+	{
+		MixResampledVoice( p_Index, p_FrameCount, TargetLeft, TargetRight );
+		return;
+	}
+
+	const BIT_FLOAT32 StepLeft = ( TargetLeft - CurrentVoice.GainLeft ) / static_cast< BIT_FLOAT32 >( p_FrameCount );
+	const BIT_FLOAT32 StepRight = ( TargetRight - CurrentVoice.GainRight ) / static_cast< BIT_FLOAT32 >( p_FrameCount );
+
+	BIT_UINT32 Offset = 0;
+	while( Offset < p_FrameCount )
+	{
+		const BIT_FLOAT32 * pLeft = BIT_NULL;
+		const BIT_FLOAT32 * pRight = BIT_NULL;
+		const BIT_UINT32 Available = GetFrames( p_Index, pLeft, pRight );
+		if( Available == 0 )
+		{
+			if( CurrentVoice.Loop )
+			{
+				CurrentVoice.Position = 0;
+				continue;
+			}
+
+			CurrentVoice.Active = BIT_FALSE;
+			break;
+		}
+
+		const BIT_UINT32 Count = p_FrameCount - Offset < Available ? p_FrameCount - Offset : Available;
+		if( CurrentSound.ChannelCount == 1 )
+		{
+			Kernels.MixMono( pLeft, &m_Left[ Offset ], &m_Right[ Offset ], Offset, Count,
+				CurrentVoice.GainLeft, CurrentVoice.GainRight, StepLeft, StepRight );
+		}
+		else
+		{
+			Kernels.MixStereo( pLeft, pRight, &m_Left[ Offset ], &m_Right[ Offset ], Offset, Count,
+				CurrentVoice.GainLeft, CurrentVoice.GainRight, StepLeft, StepRight );
+		}
+
+		CurrentVoice.Position += Count;
+		Offset += Count;
+	}
+
+	m_VoiceFrameCount += Offset;
+	CurrentVoice.GainLeft = TargetLeft;
+	CurrentVoice.GainRight = TargetRight;
+
+	if( CurrentVoice.Stopping || ( !CurrentVoice.Loop && CurrentVoice.Position == CurrentSound.FrameCount ) )
+	{
+		CurrentVoice.Active = BIT_FALSE;
+	}
+}
+
+void AudioMixer::MixResampledVoice( const BIT_UINT32 p_Index, const BIT_UINT32 p_FrameCount, const BIT_FLOAT32 p_TargetLeft,
+	const BIT_FLOAT32 p_TargetRight )
+{
+	const MixKernels & Kernels = GetKernels( m_InstructionSet );
+	Voice & CurrentVoice = m_Voices[ p_Index ];
+	const Sound & CurrentSound = m_Sounds[ CurrentVoice.Sound ];
+	Resampler & VoiceResampler = m_Resamplers[ p_Index ];
+
+	// The filter follows the pitch, it has to cut more the faster the sound plays.
+	// Every pitch filter has the tap count of the quality, so this never fails.
+	const ResamplerFilter * pFilter = GetPitchFilter( CurrentVoice.Pitch );
+	if( VoiceResampler.GetFilter( ) != pFilter )
+	{
+		VoiceResampler.SetFilter( pFilter );
+	}
+	VoiceResampler.SetStep( CurrentVoice.Pitch );
+
+	// Feed the resampler what it needs for the block, silence once a one-shot has ended
+	BIT_UINT32 Needed = VoiceResampler.GetInputFrameCount( p_FrameCount );
+	while( Needed )
+	{
+		const BIT_FLOAT32 * Channels[ 2 ] = { BIT_NULL, BIT_NULL };
+		const BIT_UINT32 Available = GetFrames( p_Index, Channels[ 0 ], Channels[ 1 ] );
+		if( Available == 0 )
+		{
+			if( CurrentVoice.Loop )
+			{
+				CurrentVoice.Position = 0;
+				continue;
+			}
+
+			VoiceResampler.WriteSilence( Needed );
+			CurrentVoice.Silence += Needed;
+			break;
+		}
+
+		const BIT_UINT32 Count = Needed < Available ? Needed : Available;
+		VoiceResampler.WritePlanar( Channels, Count );
+
+		CurrentVoice.Position += Count;
+		Needed -= Count;
+	}
+
+	BIT_FLOAT32 * Output[ 2 ] = { &m_VoiceLeft[ 0 ], &m_VoiceRight[ 0 ] };
+	const BIT_UINT32 Count = VoiceResampler.ReadPlanar( Output, p_FrameCount );
+	const BIT_FLOAT32 StepLeft = ( p_TargetLeft - CurrentVoice.GainLeft ) / static_cast< BIT_FLOAT32 >( p_FrameCount );
+	const BIT_FLOAT32 StepRight = ( p_TargetRight - CurrentVoice.GainRight ) / static_cast< BIT_FLOAT32 >( p_FrameCount );
+	if( CurrentSound.ChannelCount == 1 )
+	{
+		Kernels.MixMono( Output[ 0 ], &m_Left[ 0 ], &m_Right[ 0 ], 0, Count, CurrentVoice.GainLeft, CurrentVoice.GainRight,
+			StepLeft, StepRight );
+	}
+	else
+	{
+		Kernels.MixStereo( Output[ 0 ], Output[ 1 ], &m_Left[ 0 ], &m_Right[ 0 ], 0, Count, CurrentVoice.GainLeft,
+			CurrentVoice.GainRight, StepLeft, StepRight );
+	}
+
+	m_VoiceFrameCount += Count;
+	CurrentVoice.GainLeft = p_TargetLeft;
+	CurrentVoice.GainRight = p_TargetRight;
+
+	// The end of the sound is out once the filter has been flushed with a tap count of silence
+	if( CurrentVoice.Stopping || CurrentVoice.Silence >= pFilter->GetTapCount( ) )
+	{
+		CurrentVoice.Active = BIT_FALSE;
+	}
+}
+
+void AudioMixer::TargetGains( const Voice & p_Voice, BIT_FLOAT32 & p_Left, BIT_FLOAT32 & p_Right ) const
+{
+	if( m_Sounds[ p_Voice.Sound ].ChannelCount == 1 )
+	{
+		// Constant power, the sum of the squares stays the same across the field
+		const BIT_FLOAT32 Angle = ( p_Voice.Pan + 1.0f ) * 0.785398163f;
+		p_Left = cosf( Angle ) * p_Voice.Gain;
+		p_Right = sinf( Angle ) * p_Voice.Gain;
+	}
+	else
+	{
+		// Balance, the far channel is turned down
+		p_Left = ( p_Voice.Pan > 0.0f ? 1.0f - p_Voice.Pan : 1.0f ) * p_Voice.Gain;
+		p_Right = ( p_Voice.Pan < 0.0f ? 1.0f + p_Voice.Pan : 1.0f ) * p_Voice.Gain;
+	}
+}
+
+BIT_UINT32 AudioMixer::GetFrames( const BIT_UINT32 p_Index, const BIT_FLOAT32 * & p_pLeft, const BIT_FLOAT32 * & p_pRight )
+{
+	// Frames from the position of the voice to the end of the sound, or of the block for compressed sounds
+	const Voice & CurrentVoice = m_Voices[ p_Index ];
+	const Sound & CurrentSound = m_Sounds[ CurrentVoice.Sound ];
+	if( CurrentVoice.Position >= CurrentSound.FrameCount )
+	{
+		return 0;
+	}
+
+	if( CurrentSound.Compressed.IsEmpty( ) )
+	{
+		p_pLeft = &CurrentSound.Left[ CurrentVoice.Position ];
+		p_pRight = CurrentSound.ChannelCount == 2 ? &CurrentSound.Right[ CurrentVoice.Position ] : BIT_NULL;
+		return CurrentSound.FrameCount - CurrentVoice.Position;
+	}
+
+	const BIT_UINT32 FramesPerBlock = CurrentSound.Compressed.GetFramesPerBlock( );
+	const BIT_UINT32 Block = CurrentVoice.Position / FramesPerBlock;
+	DecodedBlock & Decoded = m_DecodedBlocks[ p_Index ];
+	if( Decoded.Block != Block )
+	{
+		Decoded.FrameCount = CurrentSound.Compressed.DecodeBlock( Block, &Decoded.Left[ 0 ], &Decoded.Right[ 0 ] );
+		Decoded.Block = Block;
+	}
+
+	const BIT_UINT32 Offset = CurrentVoice.Position - Block * FramesPerBlock;
+	p_pLeft = &Decoded.Left[ Offset ];
+	p_pRight = &Decoded.Right[ Offset ];
+	return Decoded.FrameCount - Offset;
+}
+
+AudioMixer::Voice * AudioMixer::GetVoice( const VoiceHandle p_Voice )
+{
+	return IsPlaying( p_Voice ) ? &m_Voices[ p_Voice & 0xFFFF ] : BIT_NULL;
+}
+
+const ResamplerFilter * AudioMixer::GetPitchFilter( const BIT_FLOAT32 p_Pitch ) const
+{
+	// Playing faster than the mixer rate has to remove what would fold back over Nyquist
+	BIT_UINT32 Band = 0;
+	if( p_Pitch > 1.0f )
+	{
+		Band = static_cast< BIT_UINT32 >( ceilf( logf( p_Pitch ) / logf( 2.0f ) * 4.0f - 0.001f ) );
+		Band = Band < 8 ? Band : 8;
+	}
+
+	return &m_PitchFilters[ Band ];
+}
+
+void AudioMixer::CreatePitchFilters( )
+{
+	// Band b cuts at a quarter octave below the last, for pitches up to 2^(b/4)
+	for( BIT_UINT32 i = 0; i < m_PitchFilters.size( ); i++ )
+	{
+		m_PitchFilters[ i ].Create( m_ResampleQuality, powf( 2.0f, -static_cast< BIT_FLOAT32 >( i ) / 4.0f ) );
+	}
+
+	// Size the buffers of every voice for stereo and the tap count, so voices never allocate while they mix.
+	// A block reads at most 4 input frames per output frame, at the highest pitch.
+	for( BIT_UINT32 i = 0; i < m_Resamplers.size( ); i++ )
+	{
+		Resampler & VoiceResampler = m_Resamplers[ i ];
+		VoiceResampler.Open( &m_PitchFilters[ 0 ], 2, 1.0f, m_BlockSize * 4 );
+		VoiceResampler.SetInstructionSet( m_InstructionSet );
+
+		// Voices already resampling start over with the new tap count
+		const Voice & CurrentVoice = m_Voices[ i ];
+		if( CurrentVoice.Active && CurrentVoice.Resampled )
+		{
+			VoiceResampler.Open( GetPitchFilter( CurrentVoice.Pitch ), m_Sounds[ CurrentVoice.Sound ].ChannelCount,
+				CurrentVoice.Pitch, m_BlockSize * 4 );
+		}
+	}
+}
+
+void AudioMixer::Release( const BIT_UINT32 p_Index )
+{
+	m_Voices[ p_Index ].Active = BIT_FALSE;
+	m_FreeVoices.push_back( p_Index );
+}
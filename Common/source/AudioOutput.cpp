@@ -0,0 +1,284 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <AudioOutput.hpp>
+#include <AL/al.h>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Little endian writers for the wave header
+static void WriteUInt32( FILE * p_pFile, const BIT_UINT32 p_Value )
+{
+	const BIT_UINT8 Bytes[ 4 ] =
+	{
+		static_cast< BIT_UINT8 >( p_Value ), static_cast< BIT_UINT8 >( p_Value >> 8 ),
+		static_cast< BIT_UINT8 >( p_Value >> 16 ), static_cast< BIT_UINT8 >( p_Value >> 24 )
+	};
+	fwrite( Bytes, 1, 4, p_pFile );
+}
+
+static void WriteUInt16( FILE * p_pFile, const BIT_UINT16 p_Value )
+{
+	const BIT_UINT8 Bytes[ 2 ] = { static_cast< BIT_UINT8 >( p_Value ), static_cast< BIT_UINT8 >( p_Value >> 8 ) };
+	fwrite( Bytes, 1, 2, p_pFile );
+}
+
+// Null output
+NullAudioOutput::NullAudioOutput( ) :
+	m_FrameCount( 0 )
+{
+}
+
+BIT_UINT32 NullAudioOutput::Open( const BIT_UINT32 /* p_SampleRate */, const BIT_UINT16 /* p_ChannelCount */ )
+{
+	m_FrameCount = 0;
+	return BIT_OK;
+}
+
+void NullAudioOutput::Close( )
+{
+}
+
+BIT_UINT32 NullAudioOutput::Write( const BIT_SINT16 * /* p_pFrames */, const BIT_UINT32 p_FrameCount )
+{
+	m_FrameCount += p_FrameCount;
+	return BIT_OK;
+}
+
+BIT_UINT64 NullAudioOutput::GetFrameCount( ) const
+{
+	return m_FrameCount;
+}
+
+// Wave file output
+WaveFileAudioOutput::WaveFileAudioOutput( const std::string & p_FilePath ) :
+	m_FilePath( p_FilePath ),
+	m_pFile( BIT_NULL ),
+	m_SampleRate( 0 ),
+	m_ChannelCount( 0 ),
+	m_DataSize( 0 )
+{
+}
+
+WaveFileAudioOutput::~WaveFileAudioOutput( )
+{
+	Close( );
+}
+
+BIT_UINT32 WaveFileAudioOutput::Open( const BIT_UINT32 p_SampleRate, const BIT_UINT16 p_ChannelCount )
+{
+	Close( );
+
+	if( ( m_pFile = fopen( m_FilePath.c_str( ), "wb" ) ) == BIT_NULL )
+	{
+		bitTrace( "[WaveFileAudioOutput::Open] Can not open the file: %s\n", m_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	m_SampleRate = p_SampleRate;
+	m_ChannelCount = p_ChannelCount;
+	m_DataSize = 0;
+	WriteHeader( );
+
+	return BIT_OK;
+}
+
+void WaveFileAudioOutput::Close( )
+{
+	if( m_pFile == BIT_NULL )
+	{
+		return;
+	}
+
+	// Now the sizes are known
+	fseek( m_pFile, 0, SEEK_SET );
+	WriteHeader( );
+	fclose( m_pFile );
+	m_pFile = BIT_NULL;
+}
+
+BIT_UINT32 WaveFileAudioOutput::Write( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount )
+{
+	if( m_pFile == BIT_NULL )
+	{
+		return BIT_ERROR;
+	}
+
+	// The samples are written as they are, the wave format is little endian like the platforms we run on
+	const BIT_UINT32 SampleCount = p_FrameCount * m_ChannelCount;
+	if( fwrite( p_pFrames, sizeof( BIT_SINT16 ), SampleCount, m_pFile ) != SampleCount )
+	{
+		bitTrace( "[WaveFileAudioOutput::Write] Can not write to the file\n" );
+		return BIT_ERROR;
+	}
+
+	m_DataSize += SampleCount * sizeof( BIT_SINT16 );
+	return BIT_OK;
+}
+
+void WaveFileAudioOutput::WriteHeader( )
+{
+	const BIT_UINT16 BlockAlign = m_ChannelCount * sizeof( BIT_SINT16 );
+
+	fwrite( "RIFF", 1, 4, m_pFile );
+	WriteUInt32( m_pFile, 36 + m_DataSize );
+	fwrite( "WAVEfmt ", 1, 8, m_pFile );
+	WriteUInt32( m_pFile, 16 );
+	WriteUInt16( m_pFile, 1 );
+	WriteUInt16( m_pFile, m_ChannelCount );
+	WriteUInt32( m_pFile, m_SampleRate );
+	WriteUInt32( m_pFile, m_SampleRate * BlockAlign );
+	WriteUInt16( m_pFile, BlockAlign );
+	WriteUInt16( m_pFile, 16 );
+	fwrite( "data", 1, 4, m_pFile );
+	WriteUInt32( m_pFile, m_DataSize );
+}
+
+// OpenAL output
+OpenALAudioOutput::OpenALAudioOutput( const BIT_UINT32 p_BufferCount ) :
+	m_BufferCount( p_BufferCount < 2 ? 2 : p_BufferCount ),
+	m_Source( 0 ),
+	m_Format( 0 ),
+	m_SampleRate( 0 ),
+	m_ChannelCount( 0 ),
+	m_Started( BIT_FALSE ),
+	m_UnderrunCount( 0 )
+{
+}
+
+OpenALAudioOutput::~OpenALAudioOutput( )
+{
+	Close( );
+}
+
+BIT_UINT32 OpenALAudioOutput::Open( const BIT_UINT32 p_SampleRate, const BIT_UINT16 p_ChannelCount )
+{
+	Close( );
+
+	if( p_SampleRate == 0 || ( p_ChannelCount != 1 && p_ChannelCount != 2 ) )
+	{
+		bitTrace( "[OpenALAudioOutput::Open] Invalid sample rate or channel count\n" );
+		return BIT_ERROR;
+	}
+
+	alGetError( );
+	ALuint Source = 0;
+	alGenSources( 1, &Source );
+	m_Buffers.resize( m_BufferCount );
+	alGenBuffers( static_cast< ALsizei >( m_BufferCount ), reinterpret_cast< ALuint * >( &m_Buffers[ 0 ] ) );
+	if( alGetError( ) != AL_NO_ERROR )
+	{
+		bitTrace( "[OpenALAudioOutput::Open] Can not create the OpenAL source and buffers\n" );
+		alDeleteSources( 1, &Source );
+		m_Buffers.clear( );
+		return BIT_ERROR;
+	}
+
+	// The mixer already panned the frames, play them as they are
+	m_Source = Source;
+	alSourcei( m_Source, AL_SOURCE_RELATIVE, 1 );
+	alSource3f( m_Source, AL_POSITION, 0.0f, 0.0f, 0.0f );
+	m_FreeBuffers = m_Buffers;
+	m_Format = p_ChannelCount == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+	m_SampleRate = p_SampleRate;
+	m_ChannelCount = p_ChannelCount;
+	m_Started = BIT_FALSE;
+	m_UnderrunCount = 0;
+
+	return BIT_OK;
+}
+
+void OpenALAudioOutput::Close( )
+{
+	if( m_Source )
+	{
+		alSourceStop( m_Source );
+		alSourcei( m_Source, AL_BUFFER, 0 );
+		ALuint Source = m_Source;
+		alDeleteSources( 1, &Source );
+		m_Source = 0;
+	}
+
+	if( m_Buffers.size( ) )
+	{
+		alDeleteBuffers( static_cast< ALsizei >( m_Buffers.size( ) ), reinterpret_cast< ALuint * >( &m_Buffers[ 0 ] ) );
+		m_Buffers.clear( );
+	}
+	m_FreeBuffers.clear( );
+}
+
+BIT_UINT32 OpenALAudioOutput::Write( const BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount )
+{
+	if( m_Source == 0 )
+	{
+		bitTrace( "[OpenALAudioOutput::Write] The output is not open\n" );
+		return BIT_ERROR;
+	}
+
+	// Wait for the source to finish a buffer, a quarter of a write at a time
+	const BIT_FLOAT64 Period = static_cast< BIT_FLOAT64 >( p_FrameCount ) / static_cast< BIT_FLOAT64 >( m_SampleRate );
+	Reclaim( );
+	while( m_FreeBuffers.size( ) == 0 )
+	{
+		m_Waiter.Wait( Period * 0.25f );
+		Reclaim( );
+	}
+
+	const ALuint Buffer = m_FreeBuffers.back( );
+	m_FreeBuffers.pop_back( );
+	alBufferData( Buffer, m_Format, p_pFrames, static_cast< ALsizei >( p_FrameCount * m_ChannelCount * sizeof( BIT_SINT16 ) ),
+		static_cast< ALsizei >( m_SampleRate ) );
+	alSourceQueueBuffers( m_Source, 1, &Buffer );
+
+	// Start once every buffer is queued, again after the source ran dry
+	ALint State = AL_STOPPED;
+	alGetSourcei( m_Source, AL_SOURCE_STATE, &State );
+	if( State != AL_PLAYING && m_FreeBuffers.size( ) == 0 )
+	{
+		m_UnderrunCount += m_Started ? 1 : 0;
+		m_Started = BIT_TRUE;
+		alSourcePlay( m_Source );
+	}
+
+	return BIT_OK;
+}
+
+BIT_UINT32 OpenALAudioOutput::GetUnderrunCount( ) const
+{
+	return m_UnderrunCount;
+}
+
+void OpenALAudioOutput::Reclaim( )
+{
+	// The free list is as large as the ring, this never allocates
+	ALint Processed = 0;
+	alGetSourcei( m_Source, AL_BUFFERS_PROCESSED, &Processed );
+	while( Processed-- > 0 )
+	{
+		ALuint Buffer = 0;
+		alSourceUnqueueBuffers( m_Source, 1, &Buffer );
+		m_FreeBuffers.push_back( Buffer );
+	}
+}
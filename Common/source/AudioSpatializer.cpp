@@ -0,0 +1,588 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <AudioSpatializer.hpp>
+#include <algorithm>
+#include <cmath>
+#ifdef CPU_FEATURES_SSE2
+	#include <emmintrin.h>
+#endif
+#ifdef CPU_FEATURES_AVX2
+	#include <immintrin.h>
+#endif
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Listener and settings of a pass
+struct ListenerState
+{
+	BIT_FLOAT32 X, Y, Z;
+	BIT_FLOAT32 RightX, RightY, RightZ;
+	BIT_FLOAT32 VelocityX, VelocityY, VelocityZ;
+	BIT_FLOAT32 Rolloff;
+	BIT_FLOAT32 SpeedOfSound;
+	BIT_FLOAT32 DopplerFactor;
+	BIT_FLOAT32 MaxSpeed;
+	BIT_FLOAT32 Threshold;
+};
+
+// Emitter arrays in and out of a pass
+struct EmitterArrays
+{
+	const BIT_FLOAT32 * pX;
+	const BIT_FLOAT32 * pY;
+	const BIT_FLOAT32 * pZ;
+	const BIT_FLOAT32 * pVelocityX;
+	const BIT_FLOAT32 * pVelocityY;
+	const BIT_FLOAT32 * pVelocityZ;
+	const BIT_FLOAT32 * pVolume;
+	const BIT_FLOAT32 * pReferenceDistance;
+	const BIT_FLOAT32 * pMaxDistance;
+	BIT_FLOAT32 * pGains;
+	BIT_FLOAT32 * pPans;
+	BIT_FLOAT32 * pPitches;
+	BIT_UINT32 * pAudible;
+};
+
+// Returns the number of audible emitters. Every path does the same operations
+// in the same order without FMA, so the results match the scalar ones exactly.
+typedef BIT_UINT32 ( * SpatializeFunction )( const ListenerState & p_Listener, const EmitterArrays & p_Emitters,
+	const BIT_UINT32 p_Count );
+
+static BIT_UINT32 SpatializeScalar( const ListenerState & p_Listener, const EmitterArrays & p_Emitters, const BIT_UINT32 p_Count )
+{
+	BIT_UINT32 AudibleCount = 0;
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 X = p_Emitters.pX[ i ] - p_Listener.X;
+		const BIT_FLOAT32 Y = p_Emitters.pY[ i ] - p_Listener.Y;
+		const BIT_FLOAT32 Z = p_Emitters.pZ[ i ] - p_Listener.Z;
+		const BIT_FLOAT32 Distance = sqrtf( X * X + Y * Y + Z * Z );
+		const BIT_FLOAT32 Inverse = Distance > 0.0f ? 1.0f / Distance : 0.0f;
+
+		// Inverse distance, clamped to the reference and max distance
+		const BIT_FLOAT32 Reference = p_Emitters.pReferenceDistance[ i ];
+		BIT_FLOAT32 Clamped = Distance > Reference ? Distance : Reference;
+		Clamped = Clamped < p_Emitters.pMaxDistance[ i ] ? Clamped : p_Emitters.pMaxDistance[ i ];
+		const BIT_FLOAT32 Gain = Reference / ( Reference + p_Listener.Rolloff * ( Clamped - Reference ) ) * p_Emitters.pVolume[ i ];
+
+		// Sideways part of the direction to the emitter
+		const BIT_FLOAT32 Pan = ( X * p_Listener.RightX + Y * p_Listener.RightY + Z * p_Listener.RightZ ) * Inverse;
+
+		// Speeds away from each other along the line between them
+		BIT_FLOAT32 Listener = ( X * p_Listener.VelocityX + Y * p_Listener.VelocityY + Z * p_Listener.VelocityZ ) * Inverse;
+		BIT_FLOAT32 Emitter = ( X * p_Emitters.pVelocityX[ i ] + Y * p_Emitters.pVelocityY[ i ] + Z * p_Emitters.pVelocityZ[ i ] ) * Inverse;
+		Listener = Listener < p_Listener.MaxSpeed ? Listener : p_Listener.MaxSpeed;
+		Listener = Listener > -p_Listener.MaxSpeed ? Listener : -p_Listener.MaxSpeed;
+		Emitter = Emitter < p_Listener.MaxSpeed ? Emitter : p_Listener.MaxSpeed;
+		Emitter = Emitter > -p_Listener.MaxSpeed ? Emitter : -p_Listener.MaxSpeed;
+		const BIT_FLOAT32 Pitch = ( p_Listener.SpeedOfSound + p_Listener.DopplerFactor * Listener ) /
+			( p_Listener.SpeedOfSound + p_Listener.DopplerFactor * Emitter );
+
+		p_Emitters.pGains[ i ] = Gain;
+		p_Emitters.pPans[ i ] = Pan;
+		p_Emitters.pPitches[ i ] = Pitch;
+		if( Gain >= p_Listener.Threshold && Distance <= p_Emitters.pMaxDistance[ i ] )
+		{
+			p_Emitters.pAudible[ AudibleCount++ ] = i;
+		}
+	}
+
+	return AudibleCount;
+}
+
+#ifdef CPU_FEATURES_SSE2
+static BIT_UINT32 SpatializeSSE2( const ListenerState & p_Listener, const EmitterArrays & p_Emitters, const BIT_UINT32 p_Count )
+{
+	const __m128 ListenerX = _mm_set1_ps( p_Listener.X );
+	const __m128 ListenerY = _mm_set1_ps( p_Listener.Y );
+	const __m128 ListenerZ = _mm_set1_ps( p_Listener.Z );
+	const __m128 RightX = _mm_set1_ps( p_Listener.RightX );
+	const __m128 RightY = _mm_set1_ps( p_Listener.RightY );
+	const __m128 RightZ = _mm_set1_ps( p_Listener.RightZ );
+	const __m128 VelocityX = _mm_set1_ps( p_Listener.VelocityX );
+	const __m128 VelocityY = _mm_set1_ps( p_Listener.VelocityY );
+	const __m128 VelocityZ = _mm_set1_ps( p_Listener.VelocityZ );
+	const __m128 Rolloff = _mm_set1_ps( p_Listener.Rolloff );
+	const __m128 SpeedOfSound = _mm_set1_ps( p_Listener.SpeedOfSound );
+	const __m128 DopplerFactor = _mm_set1_ps( p_Listener.DopplerFactor );
+	const __m128 MaxSpeed = _mm_set1_ps( p_Listener.MaxSpeed );
+	const __m128 MinSpeed = _mm_set1_ps( -p_Listener.MaxSpeed );
+	const __m128 Threshold = _mm_set1_ps( p_Listener.Threshold );
+	const __m128 Zero = _mm_setzero_ps( );
+	const __m128 One = _mm_set1_ps( 1.0f );
+
+	BIT_UINT32 AudibleCount = 0;
+	for( BIT_UINT32 i = 0; i < p_Count; i += 4 )
+	{
+		const __m128 X = _mm_sub_ps( _mm_loadu_ps( p_Emitters.pX + i ), ListenerX );
+		const __m128 Y = _mm_sub_ps( _mm_loadu_ps( p_Emitters.pY + i ), ListenerY );
+		const __m128 Z = _mm_sub_ps( _mm_loadu_ps( p_Emitters.pZ + i ), ListenerZ );
+		const __m128 Distance = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( X, X ), _mm_mul_ps( Y, Y ) ), _mm_mul_ps( Z, Z ) ) );
+		const __m128 Inverse = _mm_and_ps( _mm_cmpgt_ps( Distance, Zero ), _mm_div_ps( One, Distance ) );
+
+		const __m128 Reference = _mm_loadu_ps( p_Emitters.pReferenceDistance + i );
+		const __m128 MaxDistance = _mm_loadu_ps( p_Emitters.pMaxDistance + i );
+		const __m128 Clamped = _mm_min_ps( _mm_max_ps( Distance, Reference ), MaxDistance );
+		const __m128 Gain = _mm_mul_ps( _mm_div_ps( Reference, _mm_add_ps( Reference, _mm_mul_ps( Rolloff, _mm_sub_ps( Clamped, Reference ) ) ) ),
+			_mm_loadu_ps( p_Emitters.pVolume + i ) );
+
+		const __m128 Pan = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( X, RightX ), _mm_mul_ps( Y, RightY ) ), _mm_mul_ps( Z, RightZ ) ),
+			Inverse );
+
+		__m128 Listener = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( X, VelocityX ), _mm_mul_ps( Y, VelocityY ) ),
+			_mm_mul_ps( Z, VelocityZ ) ), Inverse );
+		__m128 Emitter = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( X, _mm_loadu_ps( p_Emitters.pVelocityX + i ) ),
+			_mm_mul_ps( Y, _mm_loadu_ps( p_Emitters.pVelocityY + i ) ) ), _mm_mul_ps( Z, _mm_loadu_ps( p_Emitters.pVelocityZ + i ) ) ), Inverse );
+		Listener = _mm_max_ps( _mm_min_ps( Listener, MaxSpeed ), MinSpeed );
+		Emitter = _mm_max_ps( _mm_min_ps( Emitter, MaxSpeed ), MinSpeed );
+		const __m128 Pitch = _mm_div_ps( _mm_add_ps( SpeedOfSound, _mm_mul_ps( DopplerFactor, Listener ) ),
+			_mm_add_ps( SpeedOfSound, _mm_mul_ps( DopplerFactor, Emitter ) ) );
+
+		_mm_storeu_ps( p_Emitters.pGains + i, Gain );
+		_mm_storeu_ps( p_Emitters.pPans + i, Pan );
+		_mm_storeu_ps( p_Emitters.pPitches + i, Pitch );
+
+		// Most emitters are culled, skip them four at a time
+		BIT_UINT32 Audible = static_cast< BIT_UINT32 >( _mm_movemask_ps( _mm_and_ps( _mm_cmpge_ps( Gain, Threshold ),
+			_mm_cmple_ps( Distance, MaxDistance ) ) ) );
+		for( BIT_UINT32 j = i; Audible; j++, Audible >>= 1 )
+		{
+			if( Audible & 1 )
+			{
+				p_Emitters.pAudible[ AudibleCount++ ] = j;
+			}
+		}
+	}
+
+	return AudibleCount;
+}
+#endif
+
+#if defined( CPU_FEATURES_AVX2 ) && defined( CPU_FEATURES_SSE2 )
+CPU_FEATURES_AVX2_FUNCTION
+static BIT_UINT32 SpatializeAVX2( const ListenerState & p_Listener, const EmitterArrays & p_Emitters, const BIT_UINT32 p_Count )
+{
+	const __m256 ListenerX = _mm256_set1_ps( p_Listener.X );
+	const __m256 ListenerY = _mm256_set1_ps( p_Listener.Y );
+	const __m256 ListenerZ = _mm256_set1_ps( p_Listener.Z );
+	const __m256 RightX = _mm256_set1_ps( p_Listener.RightX );
+	const __m256 RightY = _mm256_set1_ps( p_Listener.RightY );
+	const __m256 RightZ = _mm256_set1_ps( p_Listener.RightZ );
+	const __m256 VelocityX = _mm256_set1_ps( p_Listener.VelocityX );
+	const __m256 VelocityY = _mm256_set1_ps( p_Listener.VelocityY );
+	const __m256 VelocityZ = _mm256_set1_ps( p_Listener.VelocityZ );
+	const __m256 Rolloff = _mm256_set1_ps( p_Listener.Rolloff );
+	const __m256 SpeedOfSound = _mm256_set1_ps( p_Listener.SpeedOfSound );
+	const __m256 DopplerFactor = _mm256_set1_ps( p_Listener.DopplerFactor );
+	const __m256 MaxSpeed = _mm256_set1_ps( p_Listener.MaxSpeed );
+	const __m256 MinSpeed = _mm256_set1_ps( -p_Listener.MaxSpeed );
+	const __m256 Threshold = _mm256_set1_ps( p_Listener.Threshold );
+	const __m256 Zero = _mm256_setzero_ps( );
+	const __m256 One = _mm256_set1_ps( 1.0f );
+
+	BIT_UINT32 AudibleCount = 0;
+	for( BIT_UINT32 i = 0; i < p_Count; i += 8 )
+	{
+		const __m256 X = _mm256_sub_ps( _mm256_loadu_ps( p_Emitters.pX + i ), ListenerX );
+		const __m256 Y = _mm256_sub_ps( _mm256_loadu_ps( p_Emitters.pY + i ), ListenerY );
+		const __m256 Z = _mm256_sub_ps( _mm256_loadu_ps( p_Emitters.pZ + i ), ListenerZ );
+		const __m256 Distance = _mm256_sqrt_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( X, X ), _mm256_mul_ps( Y, Y ) ),
+			_mm256_mul_ps( Z, Z ) ) );
+		const __m256 Inverse = _mm256_and_ps( _mm256_cmp_ps( Distance, Zero, _CMP_GT_OQ ), _mm256_div_ps( One, Distance ) );
+
+		const __m256 Reference = _mm256_loadu_ps( p_Emitters.pReferenceDistance + i );
+		const __m256 MaxDistance = _mm256_loadu_ps( p_Emitters.pMaxDistance + i );
+		const __m256 Clamped = _mm256_min_ps( _mm256_max_ps( Distance, Reference ), MaxDistance );
+		const __m256 Gain = _mm256_mul_ps( _mm256_div_ps( Reference, _mm256_add_ps( Reference,
+			_mm256_mul_ps( Rolloff, _mm256_sub_ps( Clamped, Reference ) ) ) ), _mm256_loadu_ps( p_Emitters.pVolume + i ) );
+
+		const __m256 Pan = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( X, RightX ), _mm256_mul_ps( Y, RightY ) ),
+			_mm256_mul_ps( Z, RightZ ) ), Inverse );
+
+		__m256 Listener = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( X, VelocityX ), _mm256_mul_ps( Y, VelocityY ) ),
+			_mm256_mul_ps( Z, VelocityZ ) ), Inverse );
+		__m256 Emitter = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( X, _mm256_loadu_ps( p_Emitters.pVelocityX + i ) ),
+			_mm256_mul_ps( Y, _mm256_loadu_ps( p_Emitters.pVelocityY + i ) ) ),
+			_mm256_mul_ps( Z, _mm256_loadu_ps( p_Emitters.pVelocityZ + i ) ) ), Inverse );
+		Listener = _mm256_max_ps( _mm256_min_ps( Listener, MaxSpeed ), MinSpeed );
+		Emitter = _mm256_max_ps( _mm256_min_ps( Emitter, MaxSpeed ), MinSpeed );
+		const __m256 Pitch = _mm256_div_ps( _mm256_add_ps( SpeedOfSound, _mm256_mul_ps( DopplerFactor, Listener ) ),
+			_mm256_add_ps( SpeedOfSound, _mm256_mul_ps( DopplerFactor, Emitter ) ) );
+
+		_mm256_storeu_ps( p_Emitters.pGains + i, Gain );
+		_mm256_storeu_ps( p_Emitters.pPans + i, Pan );
+		_mm256_storeu_ps( p_Emitters.pPitches + i, Pitch );
+
+		BIT_UINT32 Audible = static_cast< BIT_UINT32 >( _mm256_movemask_ps( _mm256_and_ps(
+			_mm256_cmp_ps( Gain, Threshold, _CMP_GE_OQ ), _mm256_cmp_ps( Distance, MaxDistance, _CMP_LE_OQ ) ) ) );
+		for( BIT_UINT32 j = i; Audible; j++, Audible >>= 1 )
+		{
+			if( Audible & 1 )
+			{
+				p_Emitters.pAudible[ AudibleCount++ ] = j;
+			}
+		}
+	}
+
+	return AudibleCount;
+}
+#endif
+
+static SpatializeFunction GetSpatializeFunction( const CpuFeatures::eInstructionSet p_InstructionSet )
+{
+	switch( p_InstructionSet )
+	{
+#if defined( CPU_FEATURES_AVX2 ) && defined( CPU_FEATURES_SSE2 )
+		case CpuFeatures::InstructionSet_AVX2:
+			return SpatializeAVX2;
+#endif
+#ifdef CPU_FEATURES_SSE2
+		case CpuFeatures::InstructionSet_SSE2:
+			return SpatializeSSE2;
+#endif
+		default:
+			break;
+	}
+
+	return SpatializeScalar;
+}
+
+// Orders emitter indices loudest first
+struct LouderEmitter
+{
+	LouderEmitter( const BIT_FLOAT32 * p_pGains ) :
+		pGains( p_pGains )
+	{
+	}
+
+	bool operator ( )( const BIT_UINT32 p_A, const BIT_UINT32 p_B ) const
+	{
+		return pGains[ p_A ] > pGains[ p_B ];
+	}
+
+	const BIT_FLOAT32 * pGains;
+};
+
+// Constructor
+AudioSpatializer::AudioSpatializer( ) :
+	m_Count( 0 ),
+	m_AudibleCount( 0 ),
+	m_ListenerPosition( 0.0f, 0.0f, 0.0f ),
+	m_ListenerTarget( 0.0f, 0.0f, 1.0f ),
+	m_ListenerVelocity( 0.0f, 0.0f, 0.0f ),
+	m_Rolloff( 1.0f ),
+	m_SpeedOfSound( 343.3f ),
+	m_DopplerFactor( 1.0f ),
+	m_CullThreshold( 0.001f ),
+	m_InstructionSet( CpuFeatures::GetSupportedInstructionSet( ) )
+{
+}
+
+// Public functions
+BIT_UINT32 AudioSpatializer::AddEmitter( const BIT_UINT32 p_Sound, const Bit::Vector3_f32 & p_Position, const BIT_FLOAT32 p_Volume )
+{
+	if( m_Count == m_X.size( ) )
+	{
+		Pad( );
+	}
+
+	const BIT_UINT32 Index = m_Count++;
+	m_X[ Index ] = p_Position.x;
+	m_Y[ Index ] = p_Position.y;
+	m_Z[ Index ] = p_Position.z;
+	m_Volume[ Index ] = p_Volume;
+	m_ReferenceDistance[ Index ] = 1.0f;
+	m_MaxDistance[ Index ] = 100.0f;
+	m_Sounds.push_back( p_Sound );
+	m_Voices.push_back( static_cast< AudioMixer::VoiceHandle >( AudioMixer::InvalidVoice ) );
+	m_Selected.push_back( 0 );
+
+	return Index;
+}
+
+void AudioSpatializer::Clear( AudioMixer & p_Mixer )
+{
+	for( BIT_UINT32 i = 0; i < m_Voiced.size( ); i++ )
+	{
+		p_Mixer.Stop( m_Voices[ m_Voiced[ i ] ] );
+	}
+
+	m_Count = 0;
+	m_X.clear( );
+	m_Y.clear( );
+	m_Z.clear( );
+	m_VelocityX.clear( );
+	m_VelocityY.clear( );
+	m_VelocityZ.clear( );
+	m_Volume.clear( );
+	m_ReferenceDistance.clear( );
+	m_MaxDistance.clear( );
+	m_Sounds.clear( );
+	m_Voices.clear( );
+	m_Gains.clear( );
+	m_Pans.clear( );
+	m_Pitches.clear( );
+	m_Audible.clear( );
+	m_AudibleCount = 0;
+	m_Ranked.clear( );
+	m_Voiced.clear( );
+	m_Selected.clear( );
+}
+
+void AudioSpatializer::Spatialize( )
+{
+	// The right hand side of the listener, the world up is y
+	const BIT_FLOAT32 Length = sqrtf( m_ListenerTarget.x * m_ListenerTarget.x + m_ListenerTarget.y * m_ListenerTarget.y +
+		m_ListenerTarget.z * m_ListenerTarget.z );
+	BIT_FLOAT32 RightX = -m_ListenerTarget.z;
+	BIT_FLOAT32 RightZ = m_ListenerTarget.x;
+	const BIT_FLOAT32 RightLength = sqrtf( RightX * RightX + RightZ * RightZ );
+	RightX = RightLength > 0.0f && Length > 0.0f ? RightX / RightLength : 0.0f;
+	RightZ = RightLength > 0.0f && Length > 0.0f ? RightZ / RightLength : 0.0f;
+
+	// Sources approaching at the speed of sound would divide by zero
+	ListenerState Listener;
+	Listener.X = m_ListenerPosition.x;
+	Listener.Y = m_ListenerPosition.y;
+	Listener.Z = m_ListenerPosition.z;
+	Listener.RightX = RightX;
+	Listener.RightY = 0.0f;
+	Listener.RightZ = RightZ;
+	Listener.VelocityX = m_ListenerVelocity.x;
+	Listener.VelocityY = m_ListenerVelocity.y;
+	Listener.VelocityZ = m_ListenerVelocity.z;
+	Listener.Rolloff = m_Rolloff;
+	Listener.SpeedOfSound = m_SpeedOfSound;
+	Listener.DopplerFactor = m_DopplerFactor;
+	Listener.MaxSpeed = m_DopplerFactor > 0.0f ? m_SpeedOfSound * 0.5f / m_DopplerFactor : 0.0f;
+	Listener.Threshold = m_CullThreshold;
+
+	EmitterArrays Emitters;
+	Emitters.pX = m_Count ? &m_X[ 0 ] : BIT_NULL;
+	Emitters.pY = m_Count ? &m_Y[ 0 ] : BIT_NULL;
+	Emitters.pZ = m_Count ? &m_Z[ 0 ] : BIT_NULL;
+	Emitters.pVelocityX = m_Count ? &m_VelocityX[ 0 ] : BIT_NULL;
+	Emitters.pVelocityY = m_Count ? &m_VelocityY[ 0 ] : BIT_NULL;
+	Emitters.pVelocityZ = m_Count ? &m_VelocityZ[ 0 ] : BIT_NULL;
+	Emitters.pVolume = m_Count ? &m_Volume[ 0 ] : BIT_NULL;
+	Emitters.pReferenceDistance = m_Count ? &m_ReferenceDistance[ 0 ] : BIT_NULL;
+	Emitters.pMaxDistance = m_Count ? &m_MaxDistance[ 0 ] : BIT_NULL;
+	Emitters.pGains = m_Count ? &m_Gains[ 0 ] : BIT_NULL;
+	Emitters.pPans = m_Count ? &m_Pans[ 0 ] : BIT_NULL;
+	Emitters.pPitches = m_Count ? &m_Pitches[ 0 ] : BIT_NULL;
+	Emitters.pAudible = m_Count ? &m_Audible[ 0 ] : BIT_NULL;
+
+	// The padding is processed too, it's never audible
+	m_AudibleCount = GetSpatializeFunction( m_InstructionSet )( Listener, Emitters, static_cast< BIT_UINT32 >( m_X.size( ) ) );
+}
+
+void AudioSpatializer::Apply( AudioMixer & p_Mixer, const BIT_UINT32 p_MaxVoiceCount )
+{
+	// Only the loudest audible emitters get a voice
+	m_Ranked.assign( m_Audible.begin( ), m_Audible.begin( ) + m_AudibleCount );
+	if( m_Ranked.size( ) > p_MaxVoiceCount )
+	{
+		std::nth_element( m_Ranked.begin( ), m_Ranked.begin( ) + p_MaxVoiceCount, m_Ranked.end( ), LouderEmitter( &m_Gains[ 0 ] ) );
+		m_Ranked.resize( p_MaxVoiceCount );
+	}
+
+	for( BIT_UINT32 i = 0; i < m_Ranked.size( ); i++ )
+	{
+		m_Selected[ m_Ranked[ i ] ] = 1;
+	}
+
+	// Emitters that dropped out give their voice back
+	for( BIT_UINT32 i = 0; i < m_Voiced.size( ); i++ )
+	{
+		const BIT_UINT32 Emitter = m_Voiced[ i ];
+		if( !m_Selected[ Emitter ] )
+		{
+			p_Mixer.Stop( m_Voices[ Emitter ] );
+			m_Voices[ Emitter ] = AudioMixer::InvalidVoice;
+		}
+	}
+	m_Voiced.clear( );
+
+	for( BIT_UINT32 i = 0; i < m_Ranked.size( ); i++ )
+	{
+		const BIT_UINT32 Emitter = m_Ranked[ i ];
+		m_Selected[ Emitter ] = 0;
+
+		if( p_Mixer.IsPlaying( m_Voices[ Emitter ] ) )
+		{
+			p_Mixer.SetGain( m_Voices[ Emitter ], m_Gains[ Emitter ] );
+			p_Mixer.SetPan( m_Voices[ Emitter ], m_Pans[ Emitter ] );
+		}
+		else
+		{
+			// Voices being faded out may keep the mixer full for a block, try again next time
+			m_Voices[ Emitter ] = p_Mixer.Play( m_Sounds[ Emitter ], m_Gains[ Emitter ], m_Pans[ Emitter ], BIT_TRUE );
+			if( m_Voices[ Emitter ] == AudioMixer::InvalidVoice )
+			{
+				continue;
+			}
+		}
+
+		p_Mixer.SetPitch( m_Voices[ Emitter ], m_Pitches[ Emitter ] );
+		m_Voiced.push_back( Emitter );
+	}
+}
+
+// Set functions
+void AudioSpatializer::SetListenerPosition( const Bit::Vector3_f32 & p_Position )
+{
+	m_ListenerPosition = p_Position;
+}
+
+void AudioSpatializer::SetListenerTarget( const Bit::Vector3_f32 & p_Target )
+{
+	m_ListenerTarget = p_Target;
+}
+
+void AudioSpatializer::SetListenerVelocity( const Bit::Vector3_f32 & p_Velocity )
+{
+	m_ListenerVelocity = p_Velocity;
+}
+
+void AudioSpatializer::SetEmitterPosition( const BIT_UINT32 p_Emitter, const Bit::Vector3_f32 & p_Position )
+{
+	m_X[ p_Emitter ] = p_Position.x;
+	m_Y[ p_Emitter ] = p_Position.y;
+	m_Z[ p_Emitter ] = p_Position.z;
+}
+
+void AudioSpatializer::SetEmitterVelocity( const BIT_UINT32 p_Emitter, const Bit::Vector3_f32 & p_Velocity )
+{
+	m_VelocityX[ p_Emitter ] = p_Velocity.x;
+	m_VelocityY[ p_Emitter ] = p_Velocity.y;
+	m_VelocityZ[ p_Emitter ] = p_Velocity.z;
+}
+
+void AudioSpatializer::SetEmitterVolume( const BIT_UINT32 p_Emitter, const BIT_FLOAT32 p_Volume )
+{
+	m_Volume[ p_Emitter ] = p_Volume;
+}
+
+void AudioSpatializer::SetEmitterDistances( const BIT_UINT32 p_Emitter, const BIT_FLOAT32 p_ReferenceDistance,
+	const BIT_FLOAT32 p_MaxDistance )
+{
+	m_ReferenceDistance[ p_Emitter ] = p_ReferenceDistance > 0.0f ? p_ReferenceDistance : 0.001f;
+	m_MaxDistance[ p_Emitter ] = p_MaxDistance > m_ReferenceDistance[ p_Emitter ] ? p_MaxDistance : m_ReferenceDistance[ p_Emitter ];
+}
+
+void AudioSpatializer::SetRolloff( const BIT_FLOAT32 p_Rolloff )
+{
+	m_Rolloff = p_Rolloff > 0.0f ? p_Rolloff : 0.0f;
+}
+
+void AudioSpatializer::SetSpeedOfSound( const BIT_FLOAT32 p_SpeedOfSound )
+{
+	m_SpeedOfSound = p_SpeedOfSound > 0.0f ? p_SpeedOfSound : 343.3f;
+}
+
+void AudioSpatializer::SetDopplerFactor( const BIT_FLOAT32 p_DopplerFactor )
+{
+	m_DopplerFactor = p_DopplerFactor > 0.0f ? p_DopplerFactor : 0.0f;
+}
+
+void AudioSpatializer::SetCullThreshold( const BIT_FLOAT32 p_Threshold )
+{
+	m_CullThreshold = p_Threshold;
+}
+
+BIT_UINT32 AudioSpatializer::SetInstructionSet( const CpuFeatures::eInstructionSet p_InstructionSet )
+{
+	if( p_InstructionSet > CpuFeatures::GetSupportedInstructionSet( ) )
+	{
+		bitTrace( "[AudioSpatializer::SetInstructionSet] %s is not supported by this CPU\n",
+			CpuFeatures::GetInstructionSetName( p_InstructionSet ) );
+		return BIT_ERROR;
+	}
+
+	m_InstructionSet = p_InstructionSet;
+	return BIT_OK;
+}
+
+// Get functions
+BIT_UINT32 AudioSpatializer::GetEmitterCount( ) const
+{
+	return m_Count;
+}
+
+BIT_FLOAT32 AudioSpatializer::GetGain( const BIT_UINT32 p_Emitter ) const
+{
+	return m_Gains[ p_Emitter ];
+}
+
+BIT_FLOAT32 AudioSpatializer::GetPan( const BIT_UINT32 p_Emitter ) const
+{
+	return m_Pans[ p_Emitter ];
+}
+
+BIT_FLOAT32 AudioSpatializer::GetPitch( const BIT_UINT32 p_Emitter ) const
+{
+	return m_Pitches[ p_Emitter ];
+}
+
+BIT_UINT32 AudioSpatializer::GetAudibleCount( ) const
+{
+	return m_AudibleCount;
+}
+
+const BIT_UINT32 * AudioSpatializer::GetAudible( ) const
+{
+	return m_AudibleCount ? &m_Audible[ 0 ] : BIT_NULL;
+}
+
+BIT_UINT32 AudioSpatializer::GetVoiceCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Voiced.size( ) );
+}
+
+CpuFeatures::eInstructionSet AudioSpatializer::GetInstructionSet( ) const
+{
+	return m_InstructionSet;
+}
+
+// Private functions
+void AudioSpatializer::Pad( )
+{
+	// Padding emitters are silent and out of range, so they are never audible
+	const BIT_UINT32 Size = static_cast< BIT_UINT32 >( m_X.size( ) ) + 8;
+	m_X.resize( Size, 0.0f );
+	m_Y.resize( Size, 0.0f );
+	m_Z.resize( Size, 0.0f );
+	m_VelocityX.resize( Size, 0.0f );
+	m_VelocityY.resize( Size, 0.0f );
+	m_VelocityZ.resize( Size, 0.0f );
+	m_Volume.resize( Size, 0.0f );
+	m_ReferenceDistance.resize( Size, 1.0f );
+	m_MaxDistance.resize( Size, -1.0f );
+	m_Gains.resize( Size, 0.0f );
+	m_Pans.resize( Size, 0.0f );
+	m_Pitches.resize( Size, 1.0f );
+	m_Audible.resize( Size, 0 );
+}
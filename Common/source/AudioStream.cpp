@@ -0,0 +1,453 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <AudioStream.hpp>
+#include <AL/al.h>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor/destructor
+AudioStream::AudioStream( ) :
+	m_pFinishedWaiter( BIT_NULL ),
+	m_Source( 0 ),
+	m_Format( 0 ),
+	m_BufferFrames( 0 ),
+	m_BufferLength( 0.0f ),
+	m_State( State_Stopped ),
+	m_Loop( BIT_FALSE ),
+	m_EndOfStream( BIT_FALSE ),
+	m_Quit( BIT_FALSE ),
+	m_UnderrunCount( 0 )
+{
+}
+
+AudioStream::~AudioStream( )
+{
+	Close( );
+}
+
+// Public functions
+BIT_UINT32 AudioStream::Open( const std::string & p_FilePath, const BIT_UINT32 p_BufferCount, const BIT_FLOAT32 p_BufferLength )
+{
+	Close( );
+
+	if( p_BufferCount < 2 || p_BufferLength <= 0.0f )
+	{
+		bitTrace( "[AudioStream::Open] At least two buffers with a length are needed\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_Wave.Open( p_FilePath ) != BIT_OK )
+	{
+		return BIT_ERROR;
+	}
+
+	const BIT_BOOL Stereo = m_Wave.GetChannelCount( ) == 2;
+	if( m_Wave.GetBitsPerSample( ) == 16 )
+	{
+		m_Format = Stereo ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+	}
+	else
+	{
+		m_Format = Stereo ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8;
+	}
+
+	// The only memory besides the mapped window around the read position
+	m_BufferLength = p_BufferLength;
+	m_BufferFrames = static_cast< BIT_UINT32 >( static_cast< BIT_FLOAT32 >( m_Wave.GetSampleRate( ) ) * p_BufferLength );
+	m_BufferFrames = m_BufferFrames ? m_BufferFrames : 1;
+	m_Scratch.resize( m_BufferFrames * m_Wave.GetFrameSize( ) );
+
+	alGetError( );
+	ALuint Source = 0;
+	alGenSources( 1, &Source );
+	m_Buffers.resize( p_BufferCount );
+	alGenBuffers( static_cast< ALsizei >( p_BufferCount ), reinterpret_cast< ALuint * >( &m_Buffers[ 0 ] ) );
+	if( alGetError( ) != AL_NO_ERROR )
+	{
+		bitTrace( "[AudioStream::Open] Can not create the OpenAL source and buffers\n" );
+		alDeleteSources( 1, &Source );
+		m_Buffers.clear( );
+		m_Wave.Close( );
+		return BIT_ERROR;
+	}
+	m_Source = Source;
+	alSourcei( m_Source, AL_SOURCE_RELATIVE, 1 );
+	alSource3f( m_Source, AL_POSITION, 0.0f, 0.0f, 0.0f );
+	m_FreeBuffers = m_Buffers;
+
+	m_State = State_Stopped;
+	m_EndOfStream = BIT_FALSE;
+	m_Quit = BIT_FALSE;
+	m_UnderrunCount = 0;
+
+	if( m_Thread.Start( StreamThread, this ) != BIT_OK )
+	{
+		Close( );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+void AudioStream::Close( )
+{
+	if( m_Thread.IsRunning( ) )
+	{
+		m_Mutex.Lock( );
+		m_Quit = BIT_TRUE;
+		m_Mutex.Unlock( );
+		m_Waiter.Notify( );
+		m_Thread.Join( );
+	}
+
+	if( m_Source )
+	{
+		alSourceStop( m_Source );
+		alSourcei( m_Source, AL_BUFFER, 0 );
+		ALuint Source = m_Source;
+		alDeleteSources( 1, &Source );
+		m_Source = 0;
+	}
+
+	if( m_Buffers.size( ) )
+	{
+		alDeleteBuffers( static_cast< ALsizei >( m_Buffers.size( ) ), reinterpret_cast< ALuint * >( &m_Buffers[ 0 ] ) );
+	}
+
+	m_Buffers.clear( );
+	m_FreeBuffers.clear( );
+	m_QueuedStarts.clear( );
+	m_Scratch.clear( );
+	m_Wave.Close( );
+	m_State = State_Stopped;
+}
+
+void AudioStream::Play( )
+{
+	if( m_Source == 0 )
+	{
+		return;
+	}
+
+	m_Mutex.Lock( );
+
+	// A paused stream still has its buffers queued
+	if( m_State == State_Stopped )
+	{
+		Flush( );
+		Refill( );
+	}
+
+	alSourcePlay( m_Source );
+	m_State = State_Playing;
+
+	m_Mutex.Unlock( );
+	m_Waiter.Notify( );
+}
+
+void AudioStream::Pause( )
+{
+	if( m_Source == 0 )
+	{
+		return;
+	}
+
+	m_Mutex.Lock( );
+	if( m_State == State_Playing )
+	{
+		alSourcePause( m_Source );
+		m_State = State_Paused;
+	}
+	m_Mutex.Unlock( );
+}
+
+void AudioStream::Stop( )
+{
+	if( m_Source == 0 )
+	{
+		return;
+	}
+
+	m_Mutex.Lock( );
+	Flush( );
+	m_Wave.Seek( 0 );
+	m_State = State_Stopped;
+	m_Mutex.Unlock( );
+}
+
+BIT_UINT32 AudioStream::Seek( const BIT_FLOAT64 p_Time )
+{
+	if( m_Source == 0 )
+	{
+		bitTrace( "[AudioStream::Seek] The stream is not open\n" );
+		return BIT_ERROR;
+	}
+
+	BIT_UINT32 Frame = static_cast< BIT_UINT32 >( ( p_Time > 0.0f ? p_Time : 0.0f ) * static_cast< BIT_FLOAT64 >( m_Wave.GetSampleRate( ) ) );
+	Frame = Frame < m_Wave.GetFrameCount( ) ? Frame : m_Wave.GetFrameCount( );
+
+	// Throw away the queued buffers and fill them again from the new position
+	m_Mutex.Lock( );
+	Flush( );
+	m_Wave.Seek( Frame );
+	if( m_State != State_Stopped )
+	{
+		Refill( );
+		if( m_State == State_Playing )
+		{
+			alSourcePlay( m_Source );
+		}
+	}
+	m_Mutex.Unlock( );
+
+	return BIT_OK;
+}
+
+// Set functions
+void AudioStream::SetLoop( const BIT_BOOL p_Loop )
+{
+	m_Mutex.Lock( );
+	m_Loop = p_Loop;
+	m_Mutex.Unlock( );
+}
+
+void AudioStream::SetVolume( const BIT_FLOAT32 p_Volume )
+{
+	if( m_Source )
+	{
+		alSourcef( m_Source, AL_GAIN, p_Volume );
+	}
+}
+
+void AudioStream::SetFinishedWaiter( EventWaiter * p_pWaiter )
+{
+	m_Mutex.Lock( );
+	m_pFinishedWaiter = p_pWaiter;
+	m_Mutex.Unlock( );
+}
+
+// Get functions
+BIT_BOOL AudioStream::IsOpen( ) const
+{
+	return m_Source != 0;
+}
+
+BIT_BOOL AudioStream::IsPlaying( )
+{
+	m_Mutex.Lock( );
+	const BIT_BOOL Playing = m_State == State_Playing;
+	m_Mutex.Unlock( );
+	return Playing;
+}
+
+BIT_BOOL AudioStream::GetLoop( ) const
+{
+	return m_Loop;
+}
+
+BIT_FLOAT64 AudioStream::GetTime( )
+{
+	if( m_Source == 0 )
+	{
+		return 0.0f;
+	}
+
+	m_Mutex.Lock( );
+
+	// The first queued buffer is the one playing
+	BIT_UINT32 Frame = m_Wave.GetPosition( );
+	if( m_QueuedStarts.size( ) )
+	{
+		ALint Offset = 0;
+		alGetSourcei( m_Source, AL_SAMPLE_OFFSET, &Offset );
+		Frame = m_QueuedStarts.front( ) + static_cast< BIT_UINT32 >( Offset );
+		if( m_Wave.GetFrameCount( ) && Frame >= m_Wave.GetFrameCount( ) )
+		{
+			Frame -= m_Wave.GetFrameCount( );
+		}
+	}
+
+	m_Mutex.Unlock( );
+
+	return static_cast< BIT_FLOAT64 >( Frame ) / static_cast< BIT_FLOAT64 >( m_Wave.GetSampleRate( ) );
+}
+
+BIT_FLOAT64 AudioStream::GetLength( ) const
+{
+	if( m_Wave.GetSampleRate( ) == 0 )
+	{
+		return 0.0f;
+	}
+
+	return static_cast< BIT_FLOAT64 >( m_Wave.GetFrameCount( ) ) / static_cast< BIT_FLOAT64 >( m_Wave.GetSampleRate( ) );
+}
+
+BIT_UINT32 AudioStream::GetBufferMemory( ) const
+{
+	// The OpenAL buffers and the scratch buffer they are filled from
+	return static_cast< BIT_UINT32 >( ( m_Buffers.size( ) + 1 ) * m_Scratch.size( ) );
+}
+
+BIT_UINT32 AudioStream::GetUnderrunCount( ) const
+{
+	return m_UnderrunCount;
+}
+
+// Private functions
+void AudioStream::Refill( )
+{
+	// Take back the played buffers
+	ALint Processed = 0;
+	alGetSourcei( m_Source, AL_BUFFERS_PROCESSED, &Processed );
+	for( ALint i = 0; i < Processed; i++ )
+	{
+		ALuint Buffer = 0;
+		alSourceUnqueueBuffers( m_Source, 1, &Buffer );
+		m_FreeBuffers.push_back( Buffer );
+		if( m_QueuedStarts.size( ) )
+		{
+			m_QueuedStarts.pop_front( );
+		}
+	}
+
+	// Queue as many as there is data for
+	while( m_FreeBuffers.size( ) && !m_EndOfStream )
+	{
+		if( FillBuffer( m_FreeBuffers.back( ) ) == 0 )
+		{
+			m_EndOfStream = BIT_TRUE;
+			break;
+		}
+		m_FreeBuffers.pop_back( );
+	}
+}
+
+void AudioStream::Flush( )
+{
+	// A stopped source marks every buffer as processed
+	alSourceStop( m_Source );
+	m_EndOfStream = BIT_FALSE;
+
+	ALint Processed = 0;
+	alGetSourcei( m_Source, AL_BUFFERS_PROCESSED, &Processed );
+	for( ALint i = 0; i < Processed; i++ )
+	{
+		ALuint Buffer = 0;
+		alSourceUnqueueBuffers( m_Source, 1, &Buffer );
+		m_FreeBuffers.push_back( Buffer );
+	}
+	m_QueuedStarts.clear( );
+}
+
+BIT_UINT32 AudioStream::FillBuffer( const BIT_UINT32 p_Buffer )
+{
+	const BIT_UINT32 FrameSize = m_Wave.GetFrameSize( );
+	const BIT_UINT32 Start = m_Wave.GetPosition( );
+	BIT_UINT32 Frames = 0;
+
+	while( Frames < m_BufferFrames )
+	{
+		const BIT_UINT32 Read = m_Wave.Read( &m_Scratch[ Frames * FrameSize ], m_BufferFrames - Frames );
+		if( Read == 0 )
+		{
+			// Wrap around in the middle of the buffer, the loop point is seamless
+			if( m_Loop && m_Wave.GetFrameCount( ) && m_Wave.Seek( 0 ) == BIT_OK )
+			{
+				continue;
+			}
+			break;
+		}
+		Frames += Read;
+	}
+
+	if( Frames == 0 )
+	{
+		return 0;
+	}
+
+	ALuint Buffer = p_Buffer;
+	alBufferData( Buffer, m_Format, &m_Scratch[ 0 ], static_cast< ALsizei >( Frames * FrameSize ),
+		static_cast< ALsizei >( m_Wave.GetSampleRate( ) ) );
+	alSourceQueueBuffers( m_Source, 1, &Buffer );
+	m_QueuedStarts.push_back( Start );
+
+	return Frames;
+}
+
+// Static functions
+void AudioStream::StreamThread( void * p_pStream )
+{
+	AudioStream * pStream = static_cast< AudioStream * >( p_pStream );
+
+	while( 1 )
+	{
+		// Wake up twice per buffer, a buffer is always queued ahead of the playing one
+		pStream->m_Waiter.Wait( static_cast< BIT_FLOAT64 >( pStream->m_BufferLength ) * 0.5f );
+
+		pStream->m_Mutex.Lock( );
+
+		if( pStream->m_Quit )
+		{
+			pStream->m_Mutex.Unlock( );
+			break;
+		}
+
+		EventWaiter * pFinishedWaiter = BIT_NULL;
+		if( pStream->m_State == State_Playing )
+		{
+			pStream->Refill( );
+
+			ALint State = AL_STOPPED;
+			alGetSourcei( pStream->m_Source, AL_SOURCE_STATE, &State );
+			if( State != AL_PLAYING )
+			{
+				ALint Queued = 0;
+				alGetSourcei( pStream->m_Source, AL_BUFFERS_QUEUED, &Queued );
+
+				// The source ran dry before we refilled it, or the stream is done
+				if( Queued > 0 )
+				{
+					alSourcePlay( pStream->m_Source );
+					pStream->m_UnderrunCount++;
+				}
+				else
+				{
+					pStream->Flush( );
+					pStream->m_Wave.Seek( 0 );
+					pStream->m_State = State_Stopped;
+					pFinishedWaiter = pStream->m_pFinishedWaiter;
+				}
+			}
+		}
+
+		pStream->m_Mutex.Unlock( );
+
+		if( pFinishedWaiter )
+		{
+			pFinishedWaiter->Notify( );
+		}
+	}
+}
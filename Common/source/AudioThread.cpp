@@ -0,0 +1,359 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <AudioThread.hpp>
+#include <cstring>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Handles older than this many plays turn invalid, a power of two
+static const BIT_UINT32 VoiceTableSize = 4096;
+
+// Constructor/destructor
+AudioThread::AudioThread( ) :
+	m_pMixer( BIT_NULL ),
+	m_pOutput( BIT_NULL ),
+	m_RealTime( BIT_TRUE ),
+	m_Quit( 0 ),
+	m_UnderrunCount( 0 ),
+	m_BlockCount( 0 ),
+	m_LatencyCount( 0 ),
+	m_LatencyTotal( 0 ),
+	m_LatencyMax( 0 ),
+	m_NextVoice( 1 ),
+	m_DroppedCount( 0 )
+{
+}
+
+AudioThread::~AudioThread( )
+{
+	Stop( );
+}
+
+// Public functions
+BIT_UINT32 AudioThread::Start( AudioMixer & p_Mixer, AudioOutput * p_pOutput, const BIT_BOOL p_RealTime,
+	const BIT_UINT32 p_QueueSize )
+{
+	if( m_pMixer )
+	{
+		bitTrace( "[AudioThread::Start] The audio thread is already running\n" );
+		return BIT_ERROR;
+	}
+
+	if( p_Mixer.GetBlockSize( ) == 0 )
+	{
+		bitTrace( "[AudioThread::Start] The mixer is not open\n" );
+		return BIT_ERROR;
+	}
+
+	// Everything the audio thread needs is allocated here
+	m_Commands.Create( p_QueueSize );
+	m_CommandTimes.clear( );
+	m_CommandTimes.reserve( m_Commands.GetCapacity( ) );
+	const Voice EmptyVoice = { InvalidVoice, AudioMixer::InvalidVoice };
+	m_Voices.assign( VoiceTableSize, EmptyVoice );
+	m_Frames.resize( p_Mixer.GetBlockSize( ) * 2 );
+	m_pMixer = &p_Mixer;
+	m_pOutput = p_pOutput;
+	m_RealTime = p_RealTime;
+	m_Quit.store( 0 );
+	m_DroppedCount = 0;
+	ResetStatistics( );
+	m_StartTime = std::chrono::steady_clock::now( );
+
+	if( m_pOutput && m_Thread.Start( RenderThread, this ) != BIT_OK )
+	{
+		bitTrace( "[AudioThread::Start] Can not start the thread\n" );
+		m_pMixer = BIT_NULL;
+		m_pOutput = BIT_NULL;
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+void AudioThread::Stop( )
+{
+	m_Quit.store( 1 );
+	m_Waiter.Notify( );
+	m_Thread.Join( );
+
+	m_pMixer = BIT_NULL;
+	m_pOutput = BIT_NULL;
+}
+
+void AudioThread::Render( BIT_SINT16 * p_pFrames, const BIT_UINT32 p_FrameCount )
+{
+	if( m_pMixer == BIT_NULL )
+	{
+		memset( p_pFrames, 0, p_FrameCount * 2 * sizeof( BIT_SINT16 ) );
+		return;
+	}
+
+	// Commands queued while this block is mixed wait for the next one
+	BIT_UINT32 Count = m_Commands.GetCapacity( );
+	Command Current;
+	m_CommandTimes.clear( );
+	while( Count-- && m_Commands.Pop( Current ) )
+	{
+		Apply( Current );
+		m_CommandTimes.push_back( Current.Time );
+	}
+
+	m_pMixer->Mix( p_pFrames, p_FrameCount );
+
+	// The first sample of every command is in this block
+	const BIT_FLOAT64 Time = GetTime( );
+	for( BIT_UINT32 i = 0; i < m_CommandTimes.size( ); i++ )
+	{
+		const BIT_UINT64 Latency = static_cast< BIT_UINT64 >( ( Time - m_CommandTimes[ i ] ) * 1000000.0f );
+		m_LatencyTotal.fetch_add( Latency );
+		if( Latency > m_LatencyMax.load( ) )
+		{
+			m_LatencyMax.store( Latency );
+		}
+	}
+	m_LatencyCount.fetch_add( static_cast< BIT_UINT32 >( m_CommandTimes.size( ) ) );
+	m_BlockCount.fetch_add( 1 );
+}
+
+AudioThread::VoiceHandle AudioThread::Play( const BIT_UINT32 p_Sound, const BIT_FLOAT32 p_Gain, const BIT_FLOAT32 p_Pan,
+	const BIT_BOOL p_Loop )
+{
+	// The handle is known before the audio thread starts the voice
+	const VoiceHandle Handle = m_NextVoice;
+
+	Command Play;
+	Play.Type = Command_Play;
+	Play.Voice = Handle;
+	Play.Sound = p_Sound;
+	Play.Value = p_Gain;
+	Play.Pan = p_Pan;
+	Play.Loop = p_Loop;
+	if( Send( Play ) != BIT_OK )
+	{
+		return InvalidVoice;
+	}
+
+	m_NextVoice = m_NextVoice + 1 == InvalidVoice ? m_NextVoice + 2 : m_NextVoice + 1;
+	return Handle;
+}
+
+BIT_UINT32 AudioThread::Stop( const VoiceHandle p_Voice )
+{
+	Command Stop;
+	Stop.Type = Command_Stop;
+	Stop.Voice = p_Voice;
+	return Send( Stop );
+}
+
+BIT_UINT32 AudioThread::StopAll( )
+{
+	Command StopAll;
+	StopAll.Type = Command_StopAll;
+	return Send( StopAll );
+}
+
+BIT_UINT32 AudioThread::SetGain( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Gain )
+{
+	Command SetGain;
+	SetGain.Type = Command_SetGain;
+	SetGain.Voice = p_Voice;
+	SetGain.Value = p_Gain;
+	return Send( SetGain );
+}
+
+BIT_UINT32 AudioThread::SetPan( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Pan )
+{
+	Command SetPan;
+	SetPan.Type = Command_SetPan;
+	SetPan.Voice = p_Voice;
+	SetPan.Value = p_Pan;
+	return Send( SetPan );
+}
+
+BIT_UINT32 AudioThread::SetPitch( const VoiceHandle p_Voice, const BIT_FLOAT32 p_Pitch )
+{
+	Command SetPitch;
+	SetPitch.Type = Command_SetPitch;
+	SetPitch.Voice = p_Voice;
+	SetPitch.Value = p_Pitch;
+	return Send( SetPitch );
+}
+
+BIT_UINT32 AudioThread::SetMasterGain( const BIT_FLOAT32 p_Gain )
+{
+	Command SetMasterGain;
+	SetMasterGain.Type = Command_SetMasterGain;
+	SetMasterGain.Value = p_Gain;
+	return Send( SetMasterGain );
+}
+
+void AudioThread::ResetStatistics( )
+{
+	m_UnderrunCount.store( 0 );
+	m_BlockCount.store( 0 );
+	m_LatencyCount.store( 0 );
+	m_LatencyTotal.store( 0 );
+	m_LatencyMax.store( 0 );
+}
+
+// Get functions
+BIT_BOOL AudioThread::IsRunning( ) const
+{
+	return m_pMixer != BIT_NULL;
+}
+
+BIT_UINT32 AudioThread::GetDroppedCount( ) const
+{
+	return m_DroppedCount;
+}
+
+BIT_UINT32 AudioThread::GetUnderrunCount( ) const
+{
+	return m_UnderrunCount.load( );
+}
+
+BIT_UINT64 AudioThread::GetBlockCount( ) const
+{
+	return m_BlockCount.load( );
+}
+
+BIT_UINT32 AudioThread::GetLatencyCount( ) const
+{
+	return m_LatencyCount.load( );
+}
+
+BIT_FLOAT64 AudioThread::GetAverageLatency( ) const
+{
+	const BIT_UINT32 Count = m_LatencyCount.load( );
+	return Count ? static_cast< BIT_FLOAT64 >( m_LatencyTotal.load( ) ) / static_cast< BIT_FLOAT64 >( Count ) / 1000000.0f : 0.0f;
+}
+
+BIT_FLOAT64 AudioThread::GetMaxLatency( ) const
+{
+	return static_cast< BIT_FLOAT64 >( m_LatencyMax.load( ) ) / 1000000.0f;
+}
+
+// Private functions
+BIT_UINT32 AudioThread::Send( Command & p_Command )
+{
+	if( m_pMixer == BIT_NULL )
+	{
+		return BIT_ERROR;
+	}
+
+	p_Command.Time = GetTime( );
+	if( !m_Commands.Push( p_Command ) )
+	{
+		// Never wait for the audio thread, the caller can try again next frame
+		m_DroppedCount++;
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+void AudioThread::Apply( const Command & p_Command )
+{
+	switch( p_Command.Type )
+	{
+		case Command_Play:
+		{
+			Voice & NewVoice = m_Voices[ p_Command.Voice & ( VoiceTableSize - 1 ) ];
+			NewVoice.Handle = p_Command.Voice;
+			NewVoice.MixerVoice = m_pMixer->Play( p_Command.Sound, p_Command.Value, p_Command.Pan, p_Command.Loop );
+		}
+		break;
+		case Command_Stop:
+			m_pMixer->Stop( GetMixerVoice( p_Command.Voice ) );
+		break;
+		case Command_StopAll:
+			m_pMixer->StopAll( );
+		break;
+		case Command_SetGain:
+			m_pMixer->SetGain( GetMixerVoice( p_Command.Voice ), p_Command.Value );
+		break;
+		case Command_SetPan:
+			m_pMixer->SetPan( GetMixerVoice( p_Command.Voice ), p_Command.Value );
+		break;
+		case Command_SetPitch:
+			m_pMixer->SetPitch( GetMixerVoice( p_Command.Voice ), p_Command.Value );
+		break;
+		case Command_SetMasterGain:
+			m_pMixer->SetMasterGain( p_Command.Value );
+		break;
+	}
+}
+
+AudioMixer::VoiceHandle AudioThread::GetMixerVoice( const VoiceHandle p_Voice ) const
+{
+	const Voice & CurrentVoice = m_Voices[ p_Voice & ( VoiceTableSize - 1 ) ];
+	return CurrentVoice.Handle == p_Voice ? CurrentVoice.MixerVoice : static_cast< AudioMixer::VoiceHandle >( AudioMixer::InvalidVoice );
+}
+
+BIT_FLOAT64 AudioThread::GetTime( ) const
+{
+	// Seconds since Start, from a monotonic clock that both threads may read
+	return std::chrono::duration< BIT_FLOAT64 >( std::chrono::steady_clock::now( ) - m_StartTime ).count( );
+}
+
+// Static functions
+void AudioThread::RenderThread( void * p_pAudioThread )
+{
+	AudioThread * pAudioThread = static_cast< AudioThread * >( p_pAudioThread );
+	const BIT_UINT32 BlockSize = pAudioThread->m_pMixer->GetBlockSize( );
+	const BIT_FLOAT64 Period = static_cast< BIT_FLOAT64 >( BlockSize ) /
+		static_cast< BIT_FLOAT64 >( pAudioThread->m_pMixer->GetSampleRate( ) );
+	BIT_FLOAT64 Deadline = pAudioThread->GetTime( );
+
+	while( pAudioThread->m_Quit.load( ) == 0 )
+	{
+		pAudioThread->Render( &pAudioThread->m_Frames[ 0 ], BlockSize );
+		if( pAudioThread->m_pOutput->Write( &pAudioThread->m_Frames[ 0 ], BlockSize ) != BIT_OK )
+		{
+			bitTrace( "[AudioThread::RenderThread] Can not write to the output\n" );
+			return;
+		}
+
+		if( !pAudioThread->m_RealTime )
+		{
+			continue;
+		}
+
+		// Sleep until the output wants the next block, a block finished after that is an underrun
+		Deadline += Period;
+		const BIT_FLOAT64 Wait = Deadline - pAudioThread->GetTime( );
+		if( Wait > 0.0f )
+		{
+			pAudioThread->m_Waiter.Wait( Wait );
+		}
+		else
+		{
+			pAudioThread->m_UnderrunCount.fetch_add( 1 );
+			Deadline = pAudioThread->GetTime( );
+		}
+	}
+}
@@ -24,9 +24,65 @@
 
 #include <Camera.hpp>
 #include <iostream>
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define CAMERA_SSE
+	#include <emmintrin.h>
+#endif
+
 #include <Bit/System/Debugger.hpp>
 #include <Bit/System/MemoryLeak.hpp>
 
+static const BIT_FLOAT32 DegreesToRadians = 3.14159265358979f / 180.0f;
+
+#ifdef CAMERA_SSE
+// Sine and cosine of four angles in radians, the Cephes single precision polynomials.
+// The angle is reduced to an octant around zero, accurate to about one ulp for the angles a camera uses.
+static void SinCos4( const __m128 p_Angles, __m128 & p_Sin, __m128 & p_Cos )
+{
+	const __m128 SignMask = _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) );
+	const __m128i One = _mm_set1_epi32( 1 );
+	const __m128i Two = _mm_set1_epi32( 2 );
+	const __m128i Four = _mm_set1_epi32( 4 );
+
+	__m128 SinSign = _mm_and_ps( p_Angles, SignMask );
+	__m128 X = _mm_andnot_ps( SignMask, p_Angles );
+
+	// Octant, rounded up to an even one
+	__m128i Octant = _mm_cvttps_epi32( _mm_mul_ps( X, _mm_set1_ps( 1.27323954473516f ) ) );
+	Octant = _mm_and_si128( _mm_add_epi32( Octant, One ), _mm_set1_epi32( ~1 ) );
+	const __m128 Y = _mm_cvtepi32_ps( Octant );
+
+	SinSign = _mm_xor_ps( SinSign, _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( Octant, Four ), 29 ) ) );
+	const __m128 CosSign = _mm_castsi128_ps( _mm_slli_epi32( _mm_andnot_si128( _mm_sub_epi32( Octant, Two ), Four ), 29 ) );
+	const __m128 PolynomialMask = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( Octant, Two ), _mm_setzero_si128( ) ) );
+
+	// Extended precision reduction, x - y * pi / 4
+	X = _mm_sub_ps( X, _mm_mul_ps( Y, _mm_set1_ps( 0.78515625f ) ) );
+	X = _mm_sub_ps( X, _mm_mul_ps( Y, _mm_set1_ps( 2.4187564849853515625e-4f ) ) );
+	X = _mm_sub_ps( X, _mm_mul_ps( Y, _mm_set1_ps( 3.77489497744594108e-8f ) ) );
+	const __m128 Z = _mm_mul_ps( X, X );
+
+	__m128 Cos = _mm_set1_ps( 2.443315711809948e-5f );
+	Cos = _mm_add_ps( _mm_mul_ps( Cos, Z ), _mm_set1_ps( -1.388731625493765e-3f ) );
+	Cos = _mm_add_ps( _mm_mul_ps( Cos, Z ), _mm_set1_ps( 4.166664568298827e-2f ) );
+	Cos = _mm_mul_ps( _mm_mul_ps( Cos, Z ), Z );
+	Cos = _mm_add_ps( _mm_sub_ps( Cos, _mm_mul_ps( Z, _mm_set1_ps( 0.5f ) ) ), _mm_set1_ps( 1.0f ) );
+
+	__m128 Sin = _mm_set1_ps( -1.9515295891e-4f );
+	Sin = _mm_add_ps( _mm_mul_ps( Sin, Z ), _mm_set1_ps( 8.3321608736e-3f ) );
+	Sin = _mm_add_ps( _mm_mul_ps( Sin, Z ), _mm_set1_ps( -1.6666654611e-1f ) );
+	Sin = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( Sin, Z ), X ), X );
+
+	// Odd octants swap the polynomials
+	const __m128 SinResult = _mm_or_ps( _mm_and_ps( PolynomialMask, Sin ), _mm_andnot_ps( PolynomialMask, Cos ) );
+	const __m128 CosResult = _mm_or_ps( _mm_and_ps( PolynomialMask, Cos ), _mm_andnot_ps( PolynomialMask, Sin ) );
+	p_Sin = _mm_xor_ps( SinResult, SinSign );
+	p_Cos = _mm_xor_ps( CosResult, CosSign );
+}
+#endif
+
 // Constructor
 Camera::Camera( ) :
 	m_RotationDirections( 0, 0 ),
@@ -38,7 +94,10 @@ Camera::Camera( ) :
 	m_MovementSpeed( 1.0f ),
 	m_RotationSpeed( 1.0f ),
 	m_RotationResistance( 1.0f ),
-	m_RotationRollFactor( 0.0f )
+	m_RotationRollFactor( 0.0f ),
+	m_Changed( BIT_FALSE ),
+	m_Version( 0 ),
+	m_SkipCount( 0 )
 {
 	CalculateDirectionFlank( );
 	UpdateMatrix( );
@@ -173,14 +232,19 @@ BIT_BOOL Camera::Update( const BIT_FLOAT64 p_DeltaTime )
 	m_RotationForce.y /= 1.0f + ( p_DeltaTime * m_RotationResistance );
 
 
-	// Update the matrix
-	if( 1 /*MatrixUpdate*/ )
+	// Update the matrix, the setters force an update as well
+	if( MatrixUpdate || m_Changed )
 	{
 		// Calculate the directions
 		CalculateDirectionsFromAngles( );
 
 		// Update the matrix
 		UpdateMatrix( );
+		MatrixUpdate = BIT_TRUE;
+	}
+	else
+	{
+		m_SkipCount++;
 	}
 
 
@@ -194,25 +258,21 @@ BIT_BOOL Camera::Update( const BIT_FLOAT64 p_DeltaTime )
 
 
 	// Return the matrix update state
-	//return MatrixUpdate;
-
-	return BIT_TRUE;
+	return MatrixUpdate;
 }
 
 void Camera::UpdateMatrix( )
 {
-	// Rotate and translate the camera matrix
-	m_Matrix.Identity( );
-	m_Matrix.RotateZ( m_RotationForce.x * m_RotationRollFactor );
-	m_Matrix.RotateX( m_Angles.x );
-	m_Matrix.RotateY( m_Angles.y );
-	m_Matrix.Translate( -m_Position.x, -m_Position.y, -m_Position.z );
+	BuildViewMatrix( GetViewState( ), m_Matrix );
+	m_Changed = BIT_FALSE;
+	m_Version++;
 }
 
 // Set functions
 void Camera::SetPosition( const Bit::Vector3_f32 p_Position )
 {
 	m_Position = p_Position;
+	m_Changed = BIT_TRUE;
 }
 
 void Camera::SetDirection( Bit::Vector3_f32 p_Direction )
@@ -238,6 +298,7 @@ void Camera::SetDirection( Bit::Vector3_f32 p_Direction )
 
 	m_Direction = p_Direction;
 	CalculateDirectionFlank( );
+	m_Changed = BIT_TRUE;
 }
 
 void Camera::SetMovementSpeed( const BIT_FLOAT32 p_Speed )
@@ -257,6 +318,7 @@ void Camera::SetRotationResistance( const BIT_FLOAT32 p_Resistance )
 void Camera::SetRotationRollFactor( const BIT_FLOAT32 p_Roll )
 {
 	m_RotationRollFactor = p_Roll;
+	m_Changed = BIT_TRUE;
 }
 
 // Get functions
@@ -300,6 +362,147 @@ BIT_FLOAT32 Camera::GetRotationRollFactor( ) const
 	return m_RotationRollFactor;
 }
 
+Camera::ViewState Camera::GetViewState( ) const
+{
+	ViewState State;
+	State.Pitch = m_Angles.x;
+	State.Yaw = m_Angles.y;
+	State.Roll = m_RotationForce.x * m_RotationRollFactor;
+	State.Position = m_Position;
+	return State;
+}
+
+BIT_UINT32 Camera::GetVersion( ) const
+{
+	return m_Version;
+}
+
+BIT_UINT32 Camera::GetSkipCount( ) const
+{
+	return m_SkipCount;
+}
+
+// Static functions
+void Camera::BuildViewMatrix( const ViewState & p_State, Bit::Matrix4x4 & p_Matrix )
+{
+	const BIT_FLOAT32 Cx = cos( p_State.Pitch * DegreesToRadians );
+	const BIT_FLOAT32 Sx = sin( p_State.Pitch * DegreesToRadians );
+	const BIT_FLOAT32 Cy = cos( p_State.Yaw * DegreesToRadians );
+	const BIT_FLOAT32 Sy = sin( p_State.Yaw * DegreesToRadians );
+	const BIT_FLOAT32 Cz = cos( p_State.Roll * DegreesToRadians );
+	const BIT_FLOAT32 Sz = sin( p_State.Roll * DegreesToRadians );
+
+	// Rows of RotateX * RotateY, the roll mixes the first two
+	const BIT_FLOAT32 A[ 3 ][ 3 ] =
+	{
+		{ Cy, 0.0f, Sy },
+		{ Sx * Sy, Cx, -Sx * Cy },
+		{ -Cx * Sy, Sx, Cx * Cy }
+	};
+
+	BIT_FLOAT32 * pM = p_Matrix.m;
+	for( BIT_UINT32 j = 0; j < 3; j++ )
+	{
+		pM[ j * 4 ] = Cz * A[ 0 ][ j ] - Sz * A[ 1 ][ j ];
+		pM[ j * 4 + 1 ] = Sz * A[ 0 ][ j ] + Cz * A[ 1 ][ j ];
+		pM[ j * 4 + 2 ] = A[ 2 ][ j ];
+		pM[ j * 4 + 3 ] = 0.0f;
+	}
+
+	// The translation is the rotated negative position
+	const Bit::Vector3_f32 & P = p_State.Position;
+	pM[ 12 ] = -( pM[ 0 ] * P.x + pM[ 4 ] * P.y + pM[ 8 ] * P.z );
+	pM[ 13 ] = -( pM[ 1 ] * P.x + pM[ 5 ] * P.y + pM[ 9 ] * P.z );
+	pM[ 14 ] = -( pM[ 2 ] * P.x + pM[ 6 ] * P.y + pM[ 10 ] * P.z );
+	pM[ 15 ] = 1.0f;
+}
+
+void Camera::BuildViewMatrices( const ViewState * p_pStates, Bit::Matrix4x4 * p_pMatrices, const BIT_UINT32 p_Count )
+{
+	BIT_UINT32 i = 0;
+
+#ifdef CAMERA_SSE
+	// Four cameras at a time, one per lane
+	const __m128 Scale = _mm_set1_ps( DegreesToRadians );
+	const __m128 Zero = _mm_setzero_ps( );
+
+	for( ; i + 4 <= p_Count; i += 4 )
+	{
+		const ViewState * pS = p_pStates + i;
+		__m128 Sx, Cx, Sy, Cy, Sz, Cz;
+		SinCos4( _mm_mul_ps( _mm_setr_ps( pS[ 0 ].Pitch, pS[ 1 ].Pitch, pS[ 2 ].Pitch, pS[ 3 ].Pitch ), Scale ), Sx, Cx );
+		SinCos4( _mm_mul_ps( _mm_setr_ps( pS[ 0 ].Yaw, pS[ 1 ].Yaw, pS[ 2 ].Yaw, pS[ 3 ].Yaw ), Scale ), Sy, Cy );
+		SinCos4( _mm_mul_ps( _mm_setr_ps( pS[ 0 ].Roll, pS[ 1 ].Roll, pS[ 2 ].Roll, pS[ 3 ].Roll ), Scale ), Sz, Cz );
+
+		// Rows of RotateX * RotateY, the roll mixes the first two
+		const __m128 A1x = _mm_mul_ps( Sx, Sy );
+		const __m128 A1z = _mm_sub_ps( Zero, _mm_mul_ps( Sx, Cy ) );
+		const __m128 A2x = _mm_sub_ps( Zero, _mm_mul_ps( Cx, Sy ) );
+		const __m128 A2z = _mm_mul_ps( Cx, Cy );
+
+		__m128 Column[ 4 ][ 4 ] =
+		{
+			{ _mm_sub_ps( _mm_mul_ps( Cz, Cy ), _mm_mul_ps( Sz, A1x ) ), _mm_add_ps( _mm_mul_ps( Sz, Cy ), _mm_mul_ps( Cz, A1x ) ), A2x, Zero },
+			{ _mm_sub_ps( Zero, _mm_mul_ps( Sz, Cx ) ), _mm_mul_ps( Cz, Cx ), Sx, Zero },
+			{ _mm_sub_ps( _mm_mul_ps( Cz, Sy ), _mm_mul_ps( Sz, A1z ) ), _mm_add_ps( _mm_mul_ps( Sz, Sy ), _mm_mul_ps( Cz, A1z ) ), A2z, Zero },
+			{ Zero, Zero, Zero, _mm_set1_ps( 1.0f ) }
+		};
+
+		// The translation is the rotated negative position
+		const __m128 Px = _mm_setr_ps( pS[ 0 ].Position.x, pS[ 1 ].Position.x, pS[ 2 ].Position.x, pS[ 3 ].Position.x );
+		const __m128 Py = _mm_setr_ps( pS[ 0 ].Position.y, pS[ 1 ].Position.y, pS[ 2 ].Position.y, pS[ 3 ].Position.y );
+		const __m128 Pz = _mm_setr_ps( pS[ 0 ].Position.z, pS[ 1 ].Position.z, pS[ 2 ].Position.z, pS[ 3 ].Position.z );
+		for( BIT_UINT32 r = 0; r < 3; r++ )
+		{
+			Column[ 3 ][ r ] = _mm_sub_ps( Zero, _mm_add_ps( _mm_add_ps( _mm_mul_ps( Column[ 0 ][ r ], Px ),
+				_mm_mul_ps( Column[ 1 ][ r ], Py ) ), _mm_mul_ps( Column[ 2 ][ r ], Pz ) ) );
+		}
+
+		// Transpose the lanes, every column turns into one store per camera
+		for( BIT_UINT32 c = 0; c < 4; c++ )
+		{
+			_MM_TRANSPOSE4_PS( Column[ c ][ 0 ], Column[ c ][ 1 ], Column[ c ][ 2 ], Column[ c ][ 3 ] );
+			for( BIT_UINT32 j = 0; j < 4; j++ )
+			{
+				_mm_storeu_ps( p_pMatrices[ i + j ].m + c * 4, Column[ c ][ j ] );
+			}
+		}
+	}
+#endif
+
+	// The rest one by one
+	for( ; i < p_Count; i++ )
+	{
+		BuildViewMatrix( p_pStates[ i ], p_pMatrices[ i ] );
+	}
+}
+
+void Camera::UpdateMatrices( Camera * const * p_ppCameras, const BIT_UINT32 p_Count )
+{
+	// Gather the cameras in small chunks so the batch never allocates
+	const BIT_UINT32 ChunkSize = 32;
+	ViewState States[ ChunkSize ];
+	Bit::Matrix4x4 Matrices[ ChunkSize ];
+
+	for( BIT_UINT32 i = 0; i < p_Count; i += ChunkSize )
+	{
+		const BIT_UINT32 Count = p_Count - i < ChunkSize ? p_Count - i : ChunkSize;
+		for( BIT_UINT32 j = 0; j < Count; j++ )
+		{
+			States[ j ] = p_ppCameras[ i + j ]->GetViewState( );
+		}
+
+		BuildViewMatrices( States, Matrices, Count );
+
+		for( BIT_UINT32 j = 0; j < Count; j++ )
+		{
+			p_ppCameras[ i + j ]->m_Matrix = Matrices[ j ];
+			p_ppCameras[ i + j ]->m_Changed = BIT_FALSE;
+			p_ppCameras[ i + j ]->m_Version++;
+		}
+	}
+}
+
 // Private functions
 void Camera::CalculateDirectionsFromAngles( )
 {
@@ -0,0 +1,128 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <CpuFeatures.hpp>
+#if defined( CPU_FEATURES_AVX2 ) && defined( __GNUC__ )
+	#include <cpuid.h>
+#elif defined( CPU_FEATURES_AVX2 )
+	#include <intrin.h>
+	#include <immintrin.h>
+#endif
+#include <Bit/System/MemoryLeak.hpp>
+
+// CPU detection
+static CpuFeatures::eInstructionSet DetectInstructionSet( )
+{
+	CpuFeatures::eInstructionSet InstructionSet = CpuFeatures::InstructionSet_Scalar;
+
+#if defined( CPU_FEATURES_SSE2 ) && ( defined( _M_X64 ) || defined( __x86_64__ ) )
+	// Every x64 CPU has SSE2
+	InstructionSet = CpuFeatures::InstructionSet_SSE2;
+#endif
+
+#ifdef CPU_FEATURES_AVX2
+	BIT_UINT32 Info[ 4 ] = { 0, 0, 0, 0 };
+	BIT_UINT32 ExtendedInfo[ 4 ] = { 0, 0, 0, 0 };
+	BIT_UINT32 MaxLeaf = 0;
+	BIT_UINT64 EnabledStates = 0;
+
+	#if defined( __GNUC__ )
+		MaxLeaf = __get_cpuid_max( 0, BIT_NULL );
+		__cpuid( 1, Info[ 0 ], Info[ 1 ], Info[ 2 ], Info[ 3 ] );
+		if( MaxLeaf >= 7 )
+		{
+			__cpuid_count( 7, 0, ExtendedInfo[ 0 ], ExtendedInfo[ 1 ], ExtendedInfo[ 2 ], ExtendedInfo[ 3 ] );
+		}
+	#else
+		int Registers[ 4 ];
+		__cpuid( Registers, 0 );
+		MaxLeaf = static_cast< BIT_UINT32 >( Registers[ 0 ] );
+		__cpuid( Registers, 1 );
+		for( BIT_UINT32 i = 0; i < 4; i++ )
+		{
+			Info[ i ] = static_cast< BIT_UINT32 >( Registers[ i ] );
+		}
+		if( MaxLeaf >= 7 )
+		{
+			__cpuidex( Registers, 7, 0 );
+			for( BIT_UINT32 i = 0; i < 4; i++ )
+			{
+				ExtendedInfo[ i ] = static_cast< BIT_UINT32 >( Registers[ i ] );
+			}
+		}
+	#endif
+
+	#ifdef CPU_FEATURES_SSE2
+		if( Info[ 3 ] & ( 1 << 26 ) )
+		{
+			InstructionSet = CpuFeatures::InstructionSet_SSE2;
+		}
+	#endif
+
+	// AVX needs the OS to save the YMM registers (OSXSAVE and XCR0)
+	if( ( Info[ 2 ] & ( 1 << 27 ) ) && ( Info[ 2 ] & ( 1 << 28 ) ) )
+	{
+	#if defined( __GNUC__ )
+		BIT_UINT32 Low = 0;
+		BIT_UINT32 High = 0;
+		__asm__ __volatile__( "xgetbv" : "=a"( Low ), "=d"( High ) : "c"( 0 ) );
+		EnabledStates = ( static_cast< BIT_UINT64 >( High ) << 32 ) | Low;
+	#else
+		EnabledStates = _xgetbv( 0 );
+	#endif
+	}
+
+	if( ( EnabledStates & 6 ) == 6 && ( ExtendedInfo[ 1 ] & ( 1 << 5 ) ) &&
+		InstructionSet == CpuFeatures::InstructionSet_SSE2 )
+	{
+		InstructionSet = CpuFeatures::InstructionSet_AVX2;
+	}
+#endif
+
+	return InstructionSet;
+}
+
+// Static functions
+CpuFeatures::eInstructionSet CpuFeatures::GetSupportedInstructionSet( )
+{
+	// Detected on first use, other static initializers may ask for it
+	static const eInstructionSet Supported = DetectInstructionSet( );
+	return Supported;
+}
+
+const char * CpuFeatures::GetInstructionSetName( const eInstructionSet p_InstructionSet )
+{
+	switch( p_InstructionSet )
+	{
+		case InstructionSet_SSE2:
+			return "SSE2";
+		case InstructionSet_AVX2:
+			return "AVX2";
+		default:
+			break;
+	}
+
+	return "scalar";
+}
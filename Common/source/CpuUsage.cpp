@@ -0,0 +1,89 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <CpuUsage.hpp>
+#ifdef BIT_PLATFORM_WINDOWS
+	#include <windows.h>
+#else
+	#include <sys/resource.h>
+#endif
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor
+CpuUsage::CpuUsage( ) :
+	m_StartTime( 0.0f )
+{
+	Start( );
+}
+
+// Public functions
+void CpuUsage::Start( )
+{
+	m_StartTime = GetProcessTime( );
+	m_Timer.Start( );
+}
+
+// Get functions
+BIT_FLOAT64 CpuUsage::GetCpuTime( ) const
+{
+	return GetProcessTime( ) - m_StartTime;
+}
+
+BIT_FLOAT64 CpuUsage::GetWallTime( )
+{
+	return m_Timer.GetLapsedTime( );
+}
+
+BIT_FLOAT64 CpuUsage::GetUsage( )
+{
+	const BIT_FLOAT64 WallTime = GetWallTime( );
+	return WallTime > 0.0f ? GetCpuTime( ) / WallTime : 0.0f;
+}
+
+// Static functions
+BIT_FLOAT64 CpuUsage::GetProcessTime( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	FILETIME Creation, Exit, Kernel, User;
+	if( GetProcessTimes( GetCurrentProcess( ), &Creation, &Exit, &Kernel, &User ) == 0 )
+	{
+		return 0.0f;
+	}
+
+	// 100 nanosecond units
+	const BIT_UINT64 KernelTime = ( static_cast< BIT_UINT64 >( Kernel.dwHighDateTime ) << 32 ) | Kernel.dwLowDateTime;
+	const BIT_UINT64 UserTime = ( static_cast< BIT_UINT64 >( User.dwHighDateTime ) << 32 ) | User.dwLowDateTime;
+	return static_cast< BIT_FLOAT64 >( KernelTime + UserTime ) / 10000000.0f;
+#else
+	rusage Usage;
+	if( getrusage( RUSAGE_SELF, &Usage ) != 0 )
+	{
+		return 0.0f;
+	}
+
+	return static_cast< BIT_FLOAT64 >( Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec ) +
+		static_cast< BIT_FLOAT64 >( Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec ) / 1000000.0f;
+#endif
+}
@@ -0,0 +1,690 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <DeferredRenderer.hpp>
+#include <Bit/System/Timer.hpp>
+#include <OpenGL.hpp>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Uniform handles
+static const UniformHandle RectPositionHandle( "RectPosition" );
+static const UniformHandle RectSizeHandle( "RectSize" );
+static const UniformHandle ScreenSizeHandle( "ScreenSize" );
+static const UniformHandle TextureScaleHandle( "TextureScale" );
+static const UniformHandle ProjectionScaleHandle( "ProjectionScale" );
+static const UniformHandle ProjectionDepthHandle( "ProjectionDepth" );
+static const UniformHandle LightPositionHandle( "LightPosition" );
+static const UniformHandle LightColorHandle( "LightColor" );
+static const UniformHandle LightRadiusHandle( "LightRadius" );
+static const UniformHandle AmbientHandle( "Ambient" );
+
+// Shader sources
+static const std::string GeometryVertexSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec3 Position; \n"
+	"in vec2 Texture; \n"
+	"in vec3 Normal; \n"
+	"in vec3 Tangent; \n"
+	"in vec3 Binormal; \n"
+
+	"out vec2 out_Texture; \n"
+	"out mat3 out_TangentSpace; \n"
+
+	"uniform mat4 ProjectionMatrix; \n"
+	"uniform mat4 ViewMatrix; \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	out_Texture = Texture; \n"
+	"	out_TangentSpace = mat3( normalize( Tangent ), normalize( Binormal ), normalize( Normal ) ); \n"
+	"	gl_Position = ProjectionMatrix * ViewMatrix * vec4( Position, 1.0 ); \n"
+	"} \n";
+
+// The albedo is stored as an exact 24 bit integer in the red channel.
+static const std::string GeometryFragmentSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec2 out_Texture; \n"
+	"in mat3 out_TangentSpace; \n"
+	"out vec4 out_Color; \n"
+
+	"uniform sampler2D DiffuseTexture; \n"
+	"uniform sampler2D NormalTexture; \n"
+	"uniform mat4 ViewMatrix; \n"
+
+	"vec2 EncodeNormal( vec3 p_Normal ) \n"
+	"{ \n"
+	"	p_Normal /= abs( p_Normal.x ) + abs( p_Normal.y ) + abs( p_Normal.z ); \n"
+	"	if( p_Normal.z < 0.0 ) \n"
+	"	{ \n"
+	"		vec2 Sign = vec2( p_Normal.x >= 0.0 ? 1.0 : -1.0, p_Normal.y >= 0.0 ? 1.0 : -1.0 ); \n"
+	"		p_Normal.xy = ( 1.0 - abs( p_Normal.yx ) ) * Sign; \n"
+	"	} \n"
+	"	return p_Normal.xy; \n"
+	"} \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	vec4 DiffuseMap = texture2D( DiffuseTexture, out_Texture ); \n"
+	"	if( DiffuseMap.a == 0.0 ) { discard; } \n"
+
+	"#ifdef NORMAL_MAPPING \n"
+	"	vec4 NormalMap = texture2D( NormalTexture, out_Texture ); \n"
+	"	NormalMap.y = 1.0 - NormalMap.y; \n"
+	"	vec3 Normal = out_TangentSpace * ( 2.0 * NormalMap.rgb - 1.0 ); \n"
+	"#else \n"
+	"	vec3 Normal = out_TangentSpace[ 2 ]; \n"
+	"#endif \n"
+	"	Normal = normalize( mat3( ViewMatrix ) * Normal ); \n"
+
+	"	uvec3 Albedo = uvec3( DiffuseMap.rgb * 255.0 + 0.5 ); \n"
+	"	float PackedAlbedo = float( Albedo.r | ( Albedo.g << 8u ) | ( Albedo.b << 16u ) ); \n"
+	"	out_Color = vec4( PackedAlbedo, EncodeNormal( Normal ), 1.0 ); \n"
+	"} \n";
+
+// The quad is a unit square moved over the light's screen rectangle.
+static const std::string LightingVertexSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec3 Position; \n"
+	"in vec2 Texture; \n"
+
+	"uniform vec2 RectPosition; \n"
+	"uniform vec2 RectSize; \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	gl_Position = vec4( ( RectPosition + Position.xy * RectSize ) * 2.0 - 1.0, 0.0, 1.0 ); \n"
+	"} \n";
+
+// A radius of 0 renders the ambient term instead of a light.
+static const std::string LightingFragmentSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"out vec4 out_Color; \n"
+
+	"uniform sampler2D GBufferTexture; \n"
+	"uniform sampler2D DepthTexture; \n"
+	"uniform vec2 ScreenSize; \n"
+	"uniform vec2 TextureScale; \n"
+	"uniform vec2 ProjectionScale; \n"
+	"uniform vec2 ProjectionDepth; \n"
+	"uniform vec3 LightPosition; \n"
+	"uniform vec3 LightColor; \n"
+	"uniform float LightRadius; \n"
+	"uniform float Ambient; \n"
+
+	"vec3 DecodeNormal( vec2 p_Encoded ) \n"
+	"{ \n"
+	"	vec3 Normal = vec3( p_Encoded, 1.0 - abs( p_Encoded.x ) - abs( p_Encoded.y ) ); \n"
+	"	float Fold = clamp( -Normal.z, 0.0, 1.0 ); \n"
+	"	Normal.x += Normal.x >= 0.0 ? -Fold : Fold; \n"
+	"	Normal.y += Normal.y >= 0.0 ? -Fold : Fold; \n"
+	"	return normalize( Normal ); \n"
+	"} \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	vec2 Coord = gl_FragCoord.xy / ScreenSize; \n"
+	"	vec2 TextureCoord = Coord * TextureScale; \n"
+	"	float Depth = texture2D( DepthTexture, TextureCoord ).r; \n"
+	"	if( Depth == 1.0 ) { discard; } \n"
+
+	"	vec4 GBuffer = texture2D( GBufferTexture, TextureCoord ); \n"
+	"	uint PackedAlbedo = uint( GBuffer.r ); \n"
+	"	vec3 Albedo = vec3( uvec3( PackedAlbedo, PackedAlbedo >> 8u, PackedAlbedo >> 16u ) & 255u ) / 255.0; \n"
+
+	"	if( LightRadius <= 0.0 ) \n"
+	"	{ \n"
+	"		out_Color = vec4( Albedo * Ambient, 1.0 ); \n"
+	"		return; \n"
+	"	} \n"
+
+	// Reconstruct the view space position from the depth
+	"	float ViewDepth = -ProjectionDepth.y / ( Depth * 2.0 - 1.0 + ProjectionDepth.x ); \n"
+	"	vec3 Position = vec3( ( Coord * 2.0 - 1.0 ) * -ViewDepth / ProjectionScale, ViewDepth ); \n"
+
+	"	vec3 ToLight = LightPosition - Position; \n"
+	"	float Distance = length( ToLight ); \n"
+	"	float Attenuation = clamp( 1.0 - Distance / LightRadius, 0.0, 1.0 ); \n"
+	"	float Diffuse = max( dot( DecodeNormal( GBuffer.gb ), ToLight / Distance ), 0.0 ); \n"
+	"	out_Color = vec4( Albedo * LightColor * ( Diffuse * Attenuation * Attenuation ), 1.0 ); \n"
+	"} \n";
+
+
+// Constructor/destructor
+DeferredRenderer::DeferredRenderer( Bit::GraphicDevice * p_pGraphicDevice, Bit::Model * p_pModel,
+	const PointLightSet * p_pLights, FrameUniformBlock * p_pFrameUniforms ) :
+	m_Loaded( BIT_FALSE ),
+	m_pGraphicDevice( p_pGraphicDevice ),
+	m_pModel( p_pModel ),
+	m_pLights( p_pLights ),
+	m_pFrameUniforms( p_pFrameUniforms ),
+	m_Size( 0, 0 ),
+	m_ViewportSize( 0, 0 ),
+	m_UseNormalMapping( BIT_TRUE ),
+	m_Ambient( 0.1f ),
+	m_pQuadVertexObject( BIT_NULL ),
+	m_CullTime( 0.0f ),
+	m_CullMatrixVersion( 0 ),
+	m_CullLightVersion( 0 ),
+	m_CullSkipCount( 0 ),
+	m_pGeometryPermutations( BIT_NULL ),
+	m_NormalMappingFeature( 0 ),
+	m_pLightingVertexShader( BIT_NULL ),
+	m_pLightingFragmentShader( BIT_NULL ),
+	m_pLightingProgram( BIT_NULL ),
+	m_pLightingUniforms( BIT_NULL )
+{
+}
+
+DeferredRenderer::~DeferredRenderer( )
+{
+	Unload( );
+}
+
+// Public functions
+BIT_UINT32 DeferredRenderer::Load( const Bit::Vector2_ui32 p_Size )
+{
+	if( m_Loaded )
+	{
+		bitTrace( "[DeferredRenderer::Load] Already loaded\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_pGraphicDevice == BIT_NULL || m_pModel == BIT_NULL || m_pLights == BIT_NULL || m_pFrameUniforms == BIT_NULL )
+	{
+		bitTrace( "[DeferredRenderer::Load] NULL param\n" );
+		return BIT_ERROR;
+	}
+
+	m_Size = p_Size;
+	m_ViewportSize = p_Size;
+
+	if( LoadQuad( ) != BIT_OK )
+	{
+		bitTrace( "[DeferredRenderer::Load] Can not load the light quad\n" );
+		return BIT_ERROR;
+	}
+
+	if( LoadShaders( ) != BIT_OK )
+	{
+		bitTrace( "[DeferredRenderer::Load] Can not load the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	m_Loaded = BIT_TRUE;
+	return BIT_OK;
+}
+
+void DeferredRenderer::Unload( )
+{
+	m_GraphPasses.clear( );
+	m_VisibleLights.clear( );
+	m_CullMatrixVersion = 0;
+	m_CullLightVersion = 0;
+
+	if( m_pGeometryPermutations )
+	{
+		delete m_pGeometryPermutations;
+		m_pGeometryPermutations = BIT_NULL;
+	}
+
+	if( m_pLightingUniforms )
+	{
+		delete m_pLightingUniforms;
+		m_pLightingUniforms = BIT_NULL;
+	}
+
+	// Delete the shaders
+	if( m_pLightingProgram )
+	{
+		delete m_pLightingProgram;
+		m_pLightingProgram = BIT_NULL;
+	}
+
+	Bit::Shader ** ppShaders[ 2 ] = { &m_pLightingVertexShader, &m_pLightingFragmentShader };
+	for( BIT_MEMSIZE i = 0; i < 2; i++ )
+	{
+		if( *ppShaders[ i ] )
+		{
+			delete *ppShaders[ i ];
+			*ppShaders[ i ] = BIT_NULL;
+		}
+	}
+
+	if( m_pQuadVertexObject )
+	{
+		delete m_pQuadVertexObject;
+		m_pQuadVertexObject = BIT_NULL;
+	}
+
+	m_Loaded = BIT_FALSE;
+}
+
+void DeferredRenderer::AddPasses( RenderGraph & p_Graph, const BIT_UINT32 p_ColorTexture )
+{
+	if( !m_Loaded )
+	{
+		bitTrace( "[DeferredRenderer::AddPasses] Is not loaded yet\n" );
+		return;
+	}
+
+	// The graph keeps pointers to the pass data, so the vector must never grow after this.
+	m_GraphPasses.clear( );
+	m_GraphPasses.reserve( 2 );
+
+	GraphPass NewPass;
+	NewPass.pRenderer = this;
+	NewPass.GBuffer = p_Graph.CreateTexture( "GBuffer",
+		RenderGraph::TextureDescription( m_Size, RenderGraph::Format_RGBA32F, BIT_FALSE ) );
+	NewPass.Depth = p_Graph.CreateTexture( "SceneDepth",
+		RenderGraph::TextureDescription( m_Size, RenderGraph::Format_Depth32F, BIT_FALSE ) );
+
+	// Geometry pass
+	NewPass.Type = Pass_Geometry;
+	m_GraphPasses.push_back( NewPass );
+
+	const BIT_UINT32 GeometryPass = p_Graph.AddPass( "DeferredGeometry", ExecuteGraphPass, &m_GraphPasses.back( ) );
+	p_Graph.Write( GeometryPass, NewPass.GBuffer );
+	p_Graph.Write( GeometryPass, NewPass.Depth );
+
+	// Lighting pass, the depth is only sampled so it isn't attached
+	NewPass.Type = Pass_Lighting;
+	m_GraphPasses.push_back( NewPass );
+
+	const BIT_UINT32 LightingPass = p_Graph.AddPass( "DeferredLighting", ExecuteGraphPass, &m_GraphPasses.back( ) );
+	p_Graph.Read( LightingPass, NewPass.GBuffer );
+	p_Graph.Read( LightingPass, NewPass.Depth );
+	p_Graph.Write( LightingPass, p_ColorTexture );
+}
+
+// Set functions
+void DeferredRenderer::SetUseNormalMapping( const BIT_BOOL p_Status )
+{
+	m_UseNormalMapping = p_Status;
+}
+
+void DeferredRenderer::SetAmbient( const BIT_FLOAT32 p_Ambient )
+{
+	m_Ambient = p_Ambient;
+}
+
+void DeferredRenderer::SetViewportSize( const Bit::Vector2_ui32 p_Size )
+{
+	// The viewport has to fit in the targets
+	m_ViewportSize.x = p_Size.x < m_Size.x ? p_Size.x : m_Size.x;
+	m_ViewportSize.y = p_Size.y < m_Size.y ? p_Size.y : m_Size.y;
+}
+
+// Get functions
+BIT_UINT32 DeferredRenderer::GetVisibleLightCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_VisibleLights.size( ) );
+}
+
+BIT_FLOAT64 DeferredRenderer::GetCullTime( ) const
+{
+	return m_CullTime;
+}
+
+BIT_UINT32 DeferredRenderer::GetCullSkipCount( ) const
+{
+	return m_CullSkipCount;
+}
+
+BIT_FLOAT32 DeferredRenderer::GetAmbient( ) const
+{
+	return m_Ambient;
+}
+
+Bit::Vector2_ui32 DeferredRenderer::GetViewportSize( ) const
+{
+	return m_ViewportSize;
+}
+
+// Private functions
+BIT_UINT32 DeferredRenderer::LoadShaders( )
+{
+	if( LoadProgram( LightingVertexSource, LightingFragmentSource,
+			&m_pLightingVertexShader, &m_pLightingFragmentShader, &m_pLightingProgram ) != BIT_OK )
+	{
+		return BIT_ERROR;
+	}
+
+	// The geometry variants are compiled when they are first rendered,
+	// compile the current one right away to catch errors early.
+	m_pGeometryPermutations = new ShaderPermutations( m_pGraphicDevice, "DeferredGeometry" );
+	m_pGeometryPermutations->SetSources( GeometryVertexSource, GeometryFragmentSource );
+	m_pGeometryPermutations->SetSetupFunction( SetupGeometryProgram, this );
+	m_NormalMappingFeature = m_pGeometryPermutations->AddFeature( "NORMAL_MAPPING" );
+	m_pGeometryPermutations->AddAttribute( "Position", 0 );
+	m_pGeometryPermutations->AddAttribute( "Texture", 1 );
+	m_pGeometryPermutations->AddAttribute( "Normal", 2 );
+	m_pGeometryPermutations->AddAttribute( "Tangent", 3 );
+	m_pGeometryPermutations->AddAttribute( "Binormal", 4 );
+
+	if( m_pGeometryPermutations->Get( m_UseNormalMapping ? m_NormalMappingFeature : 0 ) == BIT_NULL )
+	{
+		return BIT_ERROR;
+	}
+
+	// Set uniforms
+	m_pLightingUniforms = new ShaderUniforms( m_pLightingProgram );
+	m_pLightingProgram->Bind( );
+	m_pLightingProgram->SetUniform1i( "GBufferTexture", 0 );
+	m_pLightingProgram->SetUniform1i( "DepthTexture", 1 );
+	m_pLightingProgram->Unbind( );
+
+	return BIT_OK;
+}
+
+BIT_UINT32 DeferredRenderer::LoadProgram( const std::string & p_VertexSource, const std::string & p_FragmentSource,
+	Bit::Shader ** p_ppVertexShader, Bit::Shader ** p_ppFragmentShader, Bit::ShaderProgram ** p_ppShaderProgram )
+{
+	// Create and compile the shaders
+	if( ( *p_ppVertexShader = m_pGraphicDevice->CreateShader( Bit::Shader::Vertex ) ) == BIT_NULL ||
+		( *p_ppFragmentShader = m_pGraphicDevice->CreateShader( Bit::Shader::Fragment ) ) == BIT_NULL )
+	{
+		bitTrace( "[DeferredRenderer::LoadProgram] Can not create the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	( *p_ppVertexShader )->SetSource( p_VertexSource );
+	( *p_ppFragmentShader )->SetSource( p_FragmentSource );
+	if( ( *p_ppVertexShader )->Compile( ) != BIT_OK ||
+		( *p_ppFragmentShader )->Compile( ) != BIT_OK )
+	{
+		bitTrace( "[DeferredRenderer::LoadProgram] Can not compile the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	// Create the shader program
+	if( ( *p_ppShaderProgram = m_pGraphicDevice->CreateShaderProgram( ) ) == BIT_NULL )
+	{
+		bitTrace( "[DeferredRenderer::LoadProgram] Can not create the shader program\n" );
+		return BIT_ERROR;
+	}
+
+	// Attach the shaders
+	if( ( *p_ppShaderProgram )->AttachShaders( *p_ppVertexShader ) != BIT_OK ||
+		( *p_ppShaderProgram )->AttachShaders( *p_ppFragmentShader ) != BIT_OK )
+	{
+		bitTrace( "[DeferredRenderer::LoadProgram] Can not attach the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	// Set attribute locations, the light quad's layout
+	( *p_ppShaderProgram )->SetAttributeLocation( "Position", 0 );
+	( *p_ppShaderProgram )->SetAttributeLocation( "Texture", 1 );
+
+	// Link the shaders
+	if( ( *p_ppShaderProgram )->Link( ) != BIT_OK )
+	{
+		bitTrace( "[DeferredRenderer::LoadProgram] Can not link the shader program\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+BIT_UINT32 DeferredRenderer::LoadQuad( )
+{
+	if( ( m_pQuadVertexObject = m_pGraphicDevice->CreateVertexObject( ) ) == BIT_NULL )
+	{
+		bitTrace( "[DeferredRenderer::LoadQuad] Can not create the vertex object\n" );
+		return BIT_ERROR;
+	}
+
+	BIT_FLOAT32 VertexPositions[ 18 ] =
+	{
+		0.0f, 0.0f, 0.0f,
+		1.0f, 0.0f, 0.0f,
+		1.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f,
+		1.0f, 1.0f, 0.0f,
+		0.0f, 1.0f, 0.0f
+	};
+
+	BIT_FLOAT32 VertexTextures[ 12 ] =
+	{
+		0.0f, 0.0f,		1.0f, 0.0f,		1.0f, 1.0f,
+		0.0f, 0.0f,		1.0f, 1.0f,		0.0f, 1.0f
+	};
+
+	if( m_pQuadVertexObject->AddVertexBuffer( VertexPositions, 3, Bit::Type_Float32 ) != BIT_OK ||
+		m_pQuadVertexObject->AddVertexBuffer( VertexTextures, 2, Bit::Type_Float32 ) != BIT_OK ||
+		m_pQuadVertexObject->Load( 2, 3 ) != BIT_OK )
+	{
+		bitTrace( "[DeferredRenderer::LoadQuad] Can not load the vertex object\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+void DeferredRenderer::CullLights( )
+{
+	// The visible lights are still valid if neither the matrices nor the lights changed
+	const BIT_UINT32 MatrixVersion = m_pFrameUniforms->GetMemberVersion(
+		FrameUniformBlock::Member_ProjectionMatrix | FrameUniformBlock::Member_ViewMatrix );
+	if( MatrixVersion == m_CullMatrixVersion && m_pLights->GetVersion( ) == m_CullLightVersion )
+	{
+		m_CullSkipCount++;
+		m_CullTime = 0.0f;
+		return;
+	}
+
+	m_CullMatrixVersion = MatrixVersion;
+	m_CullLightVersion = m_pLights->GetVersion( );
+
+	Bit::Timer Timer;
+	Timer.Start( );
+
+	const FrameUniformBlock::Data & FrameData = m_pFrameUniforms->GetData( );
+	const BIT_FLOAT32 * v = FrameData.ViewMatrix.m;
+	const BIT_FLOAT32 * p = FrameData.ProjectionMatrix.m;
+	m_Frustum.Extract( FrameData.ProjectionMatrix * FrameData.ViewMatrix );
+
+	// Distance to the near plane of a standard perspective projection
+	const BIT_FLOAT32 Near = p[ 14 ] / ( p[ 10 ] - 1.0f );
+
+	m_VisibleLights.clear( );
+	const PointLight * pLights = m_pLights->GetLights( );
+
+	for( BIT_UINT32 i = 0; i < m_pLights->GetCount( ); i++ )
+	{
+		const PointLight & Light = pLights[ i ];
+		if( !m_Frustum.IntersectsSphere( Light.Position[ 0 ], Light.Position[ 1 ], Light.Position[ 2 ], Light.Radius ) )
+		{
+			continue;
+		}
+
+		VisibleLight NewLight;
+		NewLight.Radius = Light.Radius;
+		for( BIT_UINT32 j = 0; j < 3; j++ )
+		{
+			NewLight.Position[ j ] = v[ j ] * Light.Position[ 0 ] + v[ j + 4 ] * Light.Position[ 1 ] +
+				v[ j + 8 ] * Light.Position[ 2 ] + v[ j + 12 ];
+			NewLight.Color[ j ] = Light.Color[ j ];
+		}
+
+		// Lights reaching the near plane cover the whole screen
+		if( NewLight.Position[ 2 ] + Light.Radius > -Near )
+		{
+			NewLight.Rect[ 0 ] = 0.0f;
+			NewLight.Rect[ 1 ] = 0.0f;
+			NewLight.Rect[ 2 ] = 1.0f;
+			NewLight.Rect[ 3 ] = 1.0f;
+			m_VisibleLights.push_back( NewLight );
+			continue;
+		}
+
+		// Project the corners of the box around the sphere
+		BIT_FLOAT32 Min[ 2 ] = { 1.0f, 1.0f };
+		BIT_FLOAT32 Max[ 2 ] = { -1.0f, -1.0f };
+		for( BIT_UINT32 j = 0; j < 8; j++ )
+		{
+			const BIT_FLOAT32 x = NewLight.Position[ 0 ] + ( ( j & 1 ) ? Light.Radius : -Light.Radius );
+			const BIT_FLOAT32 y = NewLight.Position[ 1 ] + ( ( j & 2 ) ? Light.Radius : -Light.Radius );
+			const BIT_FLOAT32 z = NewLight.Position[ 2 ] + ( ( j & 4 ) ? Light.Radius : -Light.Radius );
+			const BIT_FLOAT32 Ndc[ 2 ] =
+			{
+				( p[ 0 ] * x + p[ 8 ] * z ) / -z,
+				( p[ 5 ] * y + p[ 9 ] * z ) / -z
+			};
+
+			for( BIT_UINT32 k = 0; k < 2; k++ )
+			{
+				Min[ k ] = Ndc[ k ] < Min[ k ] ? Ndc[ k ] : Min[ k ];
+				Max[ k ] = Ndc[ k ] > Max[ k ] ? Ndc[ k ] : Max[ k ];
+			}
+		}
+
+		// Clamp to the screen and convert to texture coordinates
+		for( BIT_UINT32 k = 0; k < 2; k++ )
+		{
+			Min[ k ] = Min[ k ] < -1.0f ? -1.0f : Min[ k ];
+			Max[ k ] = Max[ k ] > 1.0f ? 1.0f : Max[ k ];
+		}
+
+		if( Min[ 0 ] >= Max[ 0 ] || Min[ 1 ] >= Max[ 1 ] )
+		{
+			continue;
+		}
+
+		NewLight.Rect[ 0 ] = Min[ 0 ] * 0.5f + 0.5f;
+		NewLight.Rect[ 1 ] = Min[ 1 ] * 0.5f + 0.5f;
+		NewLight.Rect[ 2 ] = ( Max[ 0 ] - Min[ 0 ] ) * 0.5f;
+		NewLight.Rect[ 3 ] = ( Max[ 1 ] - Min[ 1 ] ) * 0.5f;
+		m_VisibleLights.push_back( NewLight );
+	}
+
+	Timer.Stop( );
+	m_CullTime = Timer.GetTime( ) * 1000.0f;
+}
+
+void DeferredRenderer::RenderGeometry( )
+{
+	m_pGraphicDevice->SetViewport( 0, 0, m_ViewportSize.x, m_ViewportSize.y );
+	m_pGraphicDevice->EnableDepthTest( );
+	m_pGraphicDevice->ClearColor( );
+	m_pGraphicDevice->ClearDepth( );
+
+	// Pick the variant of the current settings
+	ShaderPermutations::Permutation * pPermutation =
+		m_pGeometryPermutations->Get( m_UseNormalMapping ? m_NormalMappingFeature : 0 );
+
+	if( pPermutation )
+	{
+		pPermutation->pShaderProgram->Bind( );
+		m_pFrameUniforms->Apply( *pPermutation->pUniforms,
+			FrameUniformBlock::Member_ProjectionMatrix | FrameUniformBlock::Member_ViewMatrix );
+		m_pModel->Render( Bit::VertexObject::RenderMode_Triangles );
+		pPermutation->pShaderProgram->Unbind( );
+	}
+
+	m_pGraphicDevice->DisableDepthTest( );
+}
+
+void DeferredRenderer::RenderLighting( Bit::Texture * p_pGBuffer, Bit::Texture * p_pDepth )
+{
+	CullLights( );
+
+	m_pGraphicDevice->SetViewport( 0, 0, m_ViewportSize.x, m_ViewportSize.y );
+	m_pGraphicDevice->DisableDepthTest( );
+	m_pGraphicDevice->ClearColor( );
+
+	m_pLightingProgram->Bind( );
+	p_pGBuffer->Bind( 0 );
+	p_pDepth->Bind( 1 );
+
+	// The G-buffer is only covered up to the viewport size
+	m_pLightingUniforms->SetUniform2f( ScreenSizeHandle,
+		static_cast< BIT_FLOAT32 >( m_ViewportSize.x ), static_cast< BIT_FLOAT32 >( m_ViewportSize.y ) );
+	m_pLightingUniforms->SetUniform2f( TextureScaleHandle,
+		static_cast< BIT_FLOAT32 >( m_ViewportSize.x ) / static_cast< BIT_FLOAT32 >( m_Size.x ),
+		static_cast< BIT_FLOAT32 >( m_ViewportSize.y ) / static_cast< BIT_FLOAT32 >( m_Size.y ) );
+
+	const BIT_FLOAT32 * p = m_pFrameUniforms->GetData( ).ProjectionMatrix.m;
+	m_pLightingUniforms->SetUniform2f( ProjectionScaleHandle, p[ 0 ], p[ 5 ] );
+	m_pLightingUniforms->SetUniform2f( ProjectionDepthHandle, p[ 10 ], p[ 14 ] );
+
+	// Ambient term over the whole screen
+	m_pLightingUniforms->SetUniform2f( RectPositionHandle, 0.0f, 0.0f );
+	m_pLightingUniforms->SetUniform2f( RectSizeHandle, 1.0f, 1.0f );
+	m_pLightingUniforms->SetUniform1f( LightRadiusHandle, 0.0f );
+	m_pLightingUniforms->SetUniform1f( AmbientHandle, m_Ambient );
+	m_pQuadVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
+
+	// Accumulate the lights
+	glBlendFunc( GL_ONE, GL_ONE );
+
+	for( BIT_MEMSIZE i = 0; i < m_VisibleLights.size( ); i++ )
+	{
+		const VisibleLight & Light = m_VisibleLights[ i ];
+		m_pLightingUniforms->SetUniform2f( RectPositionHandle, Light.Rect[ 0 ], Light.Rect[ 1 ] );
+		m_pLightingUniforms->SetUniform2f( RectSizeHandle, Light.Rect[ 2 ], Light.Rect[ 3 ] );
+		m_pLightingUniforms->SetUniform3f( LightPositionHandle, Light.Position[ 0 ], Light.Position[ 1 ], Light.Position[ 2 ] );
+		m_pLightingUniforms->SetUniform3f( LightColorHandle, Light.Color[ 0 ], Light.Color[ 1 ], Light.Color[ 2 ] );
+		m_pLightingUniforms->SetUniform1f( LightRadiusHandle, Light.Radius );
+		m_pQuadVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
+	}
+
+	m_pGraphicDevice->EnableAlpha( );
+	m_pLightingProgram->Unbind( );
+}
+
+// Static functions
+void DeferredRenderer::ExecuteGraphPass( RenderGraph & p_Graph, void * p_pUserData )
+{
+	const GraphPass * pPass = reinterpret_cast< const GraphPass * >( p_pUserData );
+
+	switch( pPass->Type )
+	{
+		case Pass_Geometry:
+		{
+			pPass->pRenderer->RenderGeometry( );
+		}
+		break;
+		case Pass_Lighting:
+		{
+			pPass->pRenderer->RenderLighting( p_Graph.GetTexture( pPass->GBuffer ), p_Graph.GetTexture( pPass->Depth ) );
+		}
+		break;
+	}
+}
+
+void DeferredRenderer::SetupGeometryProgram( ShaderPermutations::Permutation & p_Permutation, void * /* p_pUserData */ )
+{
+	p_Permutation.pShaderProgram->SetUniform1i( "DiffuseTexture", 0 );
+	p_Permutation.pShaderProgram->SetUniform1i( "NormalTexture", 1 );
+}
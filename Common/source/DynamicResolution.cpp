@@ -0,0 +1,224 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <DynamicResolution.hpp>
+#include <cmath>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Controller constants
+static const BIT_FLOAT32 DeadBand = 0.05f;			// Relative frame time error
+static const BIT_FLOAT64 MaxFrameTime = 250.0;		// Hitches like loading aren't counted
+static const BIT_MEMSIZE MaxHistoryEntries = 1024;
+
+// Constructor/destructor
+DynamicResolution::DynamicResolution( ) :
+	m_OutputSize( 0, 0 ),
+	m_MinScale( 1.0f ),
+	m_MaxScale( 1.0f ),
+	m_Scale( 1.0f ),
+	m_TargetFrameTime( 16.6f ),
+	m_ProportionalGain( 0.2f ),
+	m_IntegralGain( 0.1f ),
+	m_PreviousError( 0.0f ),
+	m_Interval( 10 ),
+	m_FrameCount( 0 ),
+	m_IntervalFrames( 0 ),
+	m_IntervalTime( 0.0f )
+{
+}
+
+DynamicResolution::~DynamicResolution( )
+{
+}
+
+// Public functions
+BIT_UINT32 DynamicResolution::Load( const Bit::Vector2_ui32 p_OutputSize, const BIT_FLOAT32 p_MinScale, const BIT_FLOAT32 p_MaxScale )
+{
+	if( p_OutputSize.x == 0 || p_OutputSize.y == 0 )
+	{
+		bitTrace( "[DynamicResolution::Load] The output size is zero\n" );
+		return BIT_ERROR;
+	}
+
+	if( p_MinScale <= 0.0f || p_MinScale > p_MaxScale )
+	{
+		bitTrace( "[DynamicResolution::Load] The scale range is invalid\n" );
+		return BIT_ERROR;
+	}
+
+	m_OutputSize = p_OutputSize;
+	m_MinScale = p_MinScale;
+	m_MaxScale = p_MaxScale;
+	Reset( );
+
+	return BIT_OK;
+}
+
+BIT_BOOL DynamicResolution::Update( const BIT_FLOAT64 p_FrameTime )
+{
+	m_FrameCount++;
+
+	if( p_FrameTime <= 0.0f || p_FrameTime > MaxFrameTime )
+	{
+		return BIT_FALSE;
+	}
+
+	m_IntervalTime += p_FrameTime;
+	if( ++m_IntervalFrames < m_Interval )
+	{
+		return BIT_FALSE;
+	}
+
+	const BIT_FLOAT32 FrameTime = static_cast< BIT_FLOAT32 >( m_IntervalTime / static_cast< BIT_FLOAT64 >( m_IntervalFrames ) );
+	m_IntervalTime = 0.0f;
+	m_IntervalFrames = 0;
+
+	// Positive when there is time left in the budget
+	BIT_FLOAT32 Error = ( m_TargetFrameTime - FrameTime ) / m_TargetFrameTime;
+	if( fabsf( Error ) < DeadBand )
+	{
+		Error = 0.0f;
+	}
+
+	// The incremental form integrates by itself and can't wind up at the limits
+	const BIT_FLOAT32 PreviousScale = m_Scale;
+	m_Scale += m_ProportionalGain * ( Error - m_PreviousError ) + m_IntegralGain * Error;
+	m_Scale = m_Scale < m_MinScale ? m_MinScale : ( m_Scale > m_MaxScale ? m_MaxScale : m_Scale );
+	m_PreviousError = Error;
+
+	// Log the interval
+	if( m_History.size( ) >= MaxHistoryEntries )
+	{
+		m_History.erase( m_History.begin( ) );
+	}
+
+	HistoryEntry NewEntry;
+	NewEntry.Frame = m_FrameCount;
+	NewEntry.FrameTime = FrameTime;
+	NewEntry.Scale = m_Scale;
+	m_History.push_back( NewEntry );
+
+	// Only changes of at least a pixel matter
+	return ScaleSize( m_OutputSize.x, m_Scale ) != ScaleSize( m_OutputSize.x, PreviousScale ) ||
+		ScaleSize( m_OutputSize.y, m_Scale ) != ScaleSize( m_OutputSize.y, PreviousScale );
+}
+
+void DynamicResolution::Reset( )
+{
+	// Start at the native resolution if the range allows it
+	m_Scale = 1.0f < m_MinScale ? m_MinScale : ( 1.0f > m_MaxScale ? m_MaxScale : 1.0f );
+	m_PreviousError = 0.0f;
+	m_FrameCount = 0;
+	m_IntervalFrames = 0;
+	m_IntervalTime = 0.0f;
+	m_History.clear( );
+}
+
+void DynamicResolution::PrintHistory( ) const
+{
+	bitTrace( "Dynamic resolution, %.2f ms budget, scale %.2f - %.2f, %u intervals of %u frames:\n",
+		m_TargetFrameTime, m_MinScale, m_MaxScale, static_cast< BIT_UINT32 >( m_History.size( ) ), m_Interval );
+
+	for( BIT_MEMSIZE i = 0; i < m_History.size( ); i++ )
+	{
+		const HistoryEntry & Entry = m_History[ i ];
+		bitTrace( "  frame %6u  %7.3f ms  scale %.3f (%ux%u)\n", Entry.Frame, Entry.FrameTime, Entry.Scale,
+			ScaleSize( m_OutputSize.x, Entry.Scale ), ScaleSize( m_OutputSize.y, Entry.Scale ) );
+	}
+}
+
+// Set functions
+void DynamicResolution::SetTargetFrameTime( const BIT_FLOAT32 p_FrameTime )
+{
+	m_TargetFrameTime = p_FrameTime > 0.0f ? p_FrameTime : 16.6f;
+}
+
+void DynamicResolution::SetGains( const BIT_FLOAT32 p_Proportional, const BIT_FLOAT32 p_Integral )
+{
+	m_ProportionalGain = p_Proportional;
+	m_IntegralGain = p_Integral;
+}
+
+void DynamicResolution::SetInterval( const BIT_UINT32 p_Frames )
+{
+	m_Interval = p_Frames ? p_Frames : 1;
+}
+
+void DynamicResolution::SetScale( const BIT_FLOAT32 p_Scale )
+{
+	m_Scale = p_Scale < m_MinScale ? m_MinScale : ( p_Scale > m_MaxScale ? m_MaxScale : p_Scale );
+}
+
+// Get functions
+BIT_FLOAT32 DynamicResolution::GetScale( ) const
+{
+	return m_Scale;
+}
+
+BIT_FLOAT32 DynamicResolution::GetMinScale( ) const
+{
+	return m_MinScale;
+}
+
+BIT_FLOAT32 DynamicResolution::GetMaxScale( ) const
+{
+	return m_MaxScale;
+}
+
+BIT_FLOAT32 DynamicResolution::GetTargetFrameTime( ) const
+{
+	return m_TargetFrameTime;
+}
+
+Bit::Vector2_ui32 DynamicResolution::GetTargetSize( ) const
+{
+	return Bit::Vector2_ui32( ScaleSize( m_OutputSize.x, m_MaxScale ), ScaleSize( m_OutputSize.y, m_MaxScale ) );
+}
+
+Bit::Vector2_ui32 DynamicResolution::GetViewportSize( ) const
+{
+	return Bit::Vector2_ui32( ScaleSize( m_OutputSize.x, m_Scale ), ScaleSize( m_OutputSize.y, m_Scale ) );
+}
+
+Bit::Vector2_f32 DynamicResolution::GetTextureScale( ) const
+{
+	const Bit::Vector2_ui32 TargetSize = GetTargetSize( );
+	const Bit::Vector2_ui32 ViewportSize = GetViewportSize( );
+	return Bit::Vector2_f32( static_cast< BIT_FLOAT32 >( ViewportSize.x ) / static_cast< BIT_FLOAT32 >( TargetSize.x ),
+		static_cast< BIT_FLOAT32 >( ViewportSize.y ) / static_cast< BIT_FLOAT32 >( TargetSize.y ) );
+}
+
+const std::vector< DynamicResolution::HistoryEntry > & DynamicResolution::GetHistory( ) const
+{
+	return m_History;
+}
+
+// Private functions
+BIT_UINT32 DynamicResolution::ScaleSize( const BIT_UINT32 p_Size, const BIT_FLOAT32 p_Scale ) const
+{
+	const BIT_UINT32 Size = static_cast< BIT_UINT32 >( static_cast< BIT_FLOAT32 >( p_Size ) * p_Scale + 0.5f );
+	return Size ? Size : 1;
+}
@@ -0,0 +1,116 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <EventWaiter.hpp>
+#ifdef BIT_PLATFORM_WINDOWS
+	#include <windows.h>
+#else
+	#include <sys/time.h>
+	#include <cerrno>
+#endif
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor/destructor
+EventWaiter::EventWaiter( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	if( ( m_Event = CreateEvent( BIT_NULL, FALSE, FALSE, BIT_NULL ) ) == BIT_NULL )
+	{
+		bitTrace( "[EventWaiter::EventWaiter] Can not create the event\n" );
+	}
+#else
+	pthread_mutex_init( &m_Mutex, BIT_NULL );
+	pthread_cond_init( &m_Condition, BIT_NULL );
+	m_Notified = BIT_FALSE;
+#endif
+}
+
+EventWaiter::~EventWaiter( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	if( m_Event )
+	{
+		CloseHandle( m_Event );
+	}
+#else
+	pthread_cond_destroy( &m_Condition );
+	pthread_mutex_destroy( &m_Mutex );
+#endif
+}
+
+// Public functions
+BIT_BOOL EventWaiter::Wait( const BIT_FLOAT64 p_Timeout )
+{
+	const BIT_FLOAT64 Timeout = p_Timeout > 0.0f ? p_Timeout : 0.0f;
+
+#ifdef BIT_PLATFORM_WINDOWS
+	if( m_Event == BIT_NULL )
+	{
+		Sleep( static_cast< DWORD >( Timeout * 1000.0f ) );
+		return BIT_FALSE;
+	}
+
+	return WaitForSingleObject( m_Event, static_cast< DWORD >( Timeout * 1000.0f + 0.5f ) ) == WAIT_OBJECT_0;
+#else
+	// The condition variable takes an absolute time
+	timeval Now;
+	gettimeofday( &Now, BIT_NULL );
+	const BIT_UINT64 Nanoseconds = static_cast< BIT_UINT64 >( Now.tv_usec ) * 1000 +
+		static_cast< BIT_UINT64 >( Timeout * 1000000000.0f );
+	timespec Deadline;
+	Deadline.tv_sec = Now.tv_sec + static_cast< time_t >( Nanoseconds / 1000000000 );
+	Deadline.tv_nsec = static_cast< long >( Nanoseconds % 1000000000 );
+
+	pthread_mutex_lock( &m_Mutex );
+	while( !m_Notified )
+	{
+		if( pthread_cond_timedwait( &m_Condition, &m_Mutex, &Deadline ) == ETIMEDOUT )
+		{
+			break;
+		}
+	}
+	const BIT_BOOL Notified = m_Notified;
+	m_Notified = BIT_FALSE;
+	pthread_mutex_unlock( &m_Mutex );
+
+	return Notified;
+#endif
+}
+
+void EventWaiter::Notify( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	if( m_Event )
+	{
+		SetEvent( m_Event );
+	}
+#else
+	pthread_mutex_lock( &m_Mutex );
+	m_Notified = BIT_TRUE;
+	pthread_cond_signal( &m_Condition );
+	pthread_mutex_unlock( &m_Mutex );
+#endif
+}
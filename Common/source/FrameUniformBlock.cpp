@@ -0,0 +1,160 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <FrameUniformBlock.hpp>
+#include <cstring>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Static uniform handles
+const UniformHandle FrameUniformBlock::ProjectionMatrixHandle( "ProjectionMatrix" );
+const UniformHandle FrameUniformBlock::ViewMatrixHandle( "ViewMatrix" );
+const UniformHandle FrameUniformBlock::ShadowMatrixHandle( "ShadowMatrix" );
+const UniformHandle FrameUniformBlock::LightMatrixHandle( "LightMatrix" );
+const UniformHandle FrameUniformBlock::LightPositionHandle( "LightPosition" );
+
+// Constructor
+FrameUniformBlock::FrameUniformBlock( ) :
+	m_Version( 1 )
+{
+	m_Data.ProjectionMatrix.Identity( );
+	m_Data.ViewMatrix.Identity( );
+	m_Data.ShadowMatrix.Identity( );
+	m_Data.LightMatrix.Identity( );
+
+	for( BIT_MEMSIZE i = 0; i < 4; i++ )
+	{
+		m_Data.LightPosition[ i ] = 0.0f;
+	}
+
+	// Every member is new to the programs
+	for( BIT_MEMSIZE i = 0; i < 5; i++ )
+	{
+		m_MemberVersions[ i ] = m_Version;
+	}
+}
+
+// Public functions
+void FrameUniformBlock::Apply( ShaderUniforms & p_Uniforms, const BIT_UINT32 p_Members )
+{
+	// The versions are tracked per member, the program may be applied with more members later
+	if( ( p_Members & Member_ProjectionMatrix ) && m_MemberVersions[ 0 ] > p_Uniforms.GetFrameBlockVersion( 0 ) )
+	{
+		p_Uniforms.SetUniformMatrix4x4f( ProjectionMatrixHandle, m_Data.ProjectionMatrix );
+	}
+	if( ( p_Members & Member_ViewMatrix ) && m_MemberVersions[ 1 ] > p_Uniforms.GetFrameBlockVersion( 1 ) )
+	{
+		p_Uniforms.SetUniformMatrix4x4f( ViewMatrixHandle, m_Data.ViewMatrix );
+	}
+	if( ( p_Members & Member_ShadowMatrix ) && m_MemberVersions[ 2 ] > p_Uniforms.GetFrameBlockVersion( 2 ) )
+	{
+		p_Uniforms.SetUniformMatrix4x4f( ShadowMatrixHandle, m_Data.ShadowMatrix );
+	}
+	if( ( p_Members & Member_LightMatrix ) && m_MemberVersions[ 3 ] > p_Uniforms.GetFrameBlockVersion( 3 ) )
+	{
+		p_Uniforms.SetUniformMatrix4x4f( LightMatrixHandle, m_Data.LightMatrix );
+	}
+	if( ( p_Members & Member_LightPosition ) && m_MemberVersions[ 4 ] > p_Uniforms.GetFrameBlockVersion( 4 ) )
+	{
+		p_Uniforms.SetUniform3f( LightPositionHandle, m_Data.LightPosition[ 0 ],
+			m_Data.LightPosition[ 1 ], m_Data.LightPosition[ 2 ] );
+	}
+
+	p_Uniforms.SetFrameBlockVersion( p_Members, m_Version );
+}
+
+// Set functions
+void FrameUniformBlock::SetProjectionMatrix( const Bit::Matrix4x4 & p_Matrix )
+{
+	SetMatrix( m_Data.ProjectionMatrix, p_Matrix, 0 );
+}
+
+void FrameUniformBlock::SetViewMatrix( const Bit::Matrix4x4 & p_Matrix )
+{
+	SetMatrix( m_Data.ViewMatrix, p_Matrix, 1 );
+}
+
+void FrameUniformBlock::SetLightMatrices( const Bit::Matrix4x4 & p_BiasMatrix, const Bit::Matrix4x4 & p_ProjectionMatrix,
+	const Bit::Matrix4x4 & p_ShadowViewMatrix )
+{
+	// Premultiply the light matrices once on the CPU instead of per vertex.
+	const Bit::Matrix4x4 ShadowMatrix = p_ProjectionMatrix * p_ShadowViewMatrix;
+	SetMatrix( m_Data.ShadowMatrix, ShadowMatrix, 2 );
+	SetMatrix( m_Data.LightMatrix, p_BiasMatrix * ShadowMatrix, 3 );
+}
+
+void FrameUniformBlock::SetLightPosition( const Bit::Vector3_f32 p_Position )
+{
+	if( m_Data.LightPosition[ 0 ] == p_Position.x &&
+		m_Data.LightPosition[ 1 ] == p_Position.y &&
+		m_Data.LightPosition[ 2 ] == p_Position.z )
+	{
+		return;
+	}
+
+	m_Data.LightPosition[ 0 ] = p_Position.x;
+	m_Data.LightPosition[ 1 ] = p_Position.y;
+	m_Data.LightPosition[ 2 ] = p_Position.z;
+	m_MemberVersions[ 4 ] = ++m_Version;
+}
+
+// Get functions
+const FrameUniformBlock::Data & FrameUniformBlock::GetData( ) const
+{
+	return m_Data;
+}
+
+BIT_UINT32 FrameUniformBlock::GetVersion( ) const
+{
+	return m_Version;
+}
+
+BIT_UINT32 FrameUniformBlock::GetMemberVersion( const BIT_UINT32 p_Members ) const
+{
+	// The latest change of any of the members
+	BIT_UINT32 Version = 0;
+	for( BIT_UINT32 i = 0; i < 5; i++ )
+	{
+		if( ( p_Members & ( 1 << i ) ) && m_MemberVersions[ i ] > Version )
+		{
+			Version = m_MemberVersions[ i ];
+		}
+	}
+
+	return Version;
+}
+
+// Private functions
+void FrameUniformBlock::SetMatrix( Bit::Matrix4x4 & p_Destination, const Bit::Matrix4x4 & p_Source, const BIT_UINT32 p_Index )
+{
+	// Only bump the version if the matrix actually changed
+	if( memcmp( p_Destination.m, p_Source.m, sizeof( p_Destination.m ) ) == 0 )
+	{
+		return;
+	}
+
+	p_Destination = p_Source;
+	m_MemberVersions[ p_Index ] = ++m_Version;
+}
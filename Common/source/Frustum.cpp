@@ -0,0 +1,94 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <Frustum.hpp>
+#include <cmath>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor
+Frustum::Frustum( )
+{
+	for( BIT_UINT32 i = 0; i < 6; i++ )
+	{
+		m_Planes[ i ][ 0 ] = 0.0f;
+		m_Planes[ i ][ 1 ] = 0.0f;
+		m_Planes[ i ][ 2 ] = 0.0f;
+		m_Planes[ i ][ 3 ] = 0.0f;
+	}
+}
+
+// Public functions
+void Frustum::Extract( const Bit::Matrix4x4 & p_ViewProjectionMatrix )
+{
+	// Gribb/Hartmann, the matrix is column major so row i is m[ i ], m[ i + 4 ], ...
+	const BIT_FLOAT32 * m = p_ViewProjectionMatrix.m;
+
+	for( BIT_UINT32 i = 0; i < 3; i++ )
+	{
+		for( BIT_UINT32 j = 0; j < 4; j++ )
+		{
+			m_Planes[ i * 2 ][ j ] = m[ j * 4 + 3 ] + m[ j * 4 + i ];
+			m_Planes[ i * 2 + 1 ][ j ] = m[ j * 4 + 3 ] - m[ j * 4 + i ];
+		}
+	}
+
+	// Normalize the planes so the distances are in world units
+	for( BIT_UINT32 i = 0; i < 6; i++ )
+	{
+		const BIT_FLOAT32 Length = sqrtf( m_Planes[ i ][ 0 ] * m_Planes[ i ][ 0 ] +
+			m_Planes[ i ][ 1 ] * m_Planes[ i ][ 1 ] + m_Planes[ i ][ 2 ] * m_Planes[ i ][ 2 ] );
+
+		if( Length > 0.0f )
+		{
+			m_Planes[ i ][ 0 ] /= Length;
+			m_Planes[ i ][ 1 ] /= Length;
+			m_Planes[ i ][ 2 ] /= Length;
+			m_Planes[ i ][ 3 ] /= Length;
+		}
+	}
+}
+
+BIT_BOOL Frustum::IntersectsSphere( const BIT_FLOAT32 p_X, const BIT_FLOAT32 p_Y, const BIT_FLOAT32 p_Z,
+	const BIT_FLOAT32 p_Radius ) const
+{
+	for( BIT_UINT32 i = 0; i < 6; i++ )
+	{
+		const BIT_FLOAT32 Distance = m_Planes[ i ][ 0 ] * p_X + m_Planes[ i ][ 1 ] * p_Y +
+			m_Planes[ i ][ 2 ] * p_Z + m_Planes[ i ][ 3 ];
+
+		if( Distance < -p_Radius )
+		{
+			return BIT_FALSE;
+		}
+	}
+
+	return BIT_TRUE;
+}
+
+// Get functions
+const BIT_FLOAT32 * Frustum::GetPlane( const ePlane p_Plane ) const
+{
+	return m_Planes[ p_Plane ];
+}
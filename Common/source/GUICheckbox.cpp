@@ -23,6 +23,7 @@
 // ///////////////////////////////////////////////////////////////////////////
 
 #include <GUICheckbox.hpp>
+#include <GUIManager.hpp>
 #include <Bit/System/Debugger.hpp>
 #include <Bit/System/MemoryLeak.hpp>
 
@@ -30,28 +31,63 @@
 GUICheckbox::GUICheckbox( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size, const BIT_BOOL p_Status ) :
 	m_Position( p_Position ),
 	m_Size( p_Size ),
-	m_Status( p_Status )
+	m_Status( p_Status ),
+	m_pManager( BIT_NULL ),
+	m_GridId( WidgetGrid::InvalidId )
 {
 }
 
 GUICheckbox::~GUICheckbox( )
 {
+	// Unlink from the manager, so the checkbox and the manager can be deleted in any order
+	if( m_pManager )
+	{
+		m_pManager->Remove( this );
+	}
 }
 
 // Set functions
 void GUICheckbox::SetPosition( const Bit::Vector2_si32 p_Position )
 {
+	const Bit::Vector2_si32 OldPosition = m_Position;
 	m_Position = p_Position;
+
+	if( m_pManager )
+	{
+		m_pManager->OnCheckboxChanged( this, OldPosition, m_Size );
+	}
 }
 
 void GUICheckbox::SetSize( const Bit::Vector2_ui32 p_Size)
 {
+	const Bit::Vector2_ui32 OldSize = m_Size;
 	m_Size = p_Size;
+
+	if( m_pManager )
+	{
+		m_pManager->OnCheckboxChanged( this, m_Position, OldSize );
+	}
 }
 
 void GUICheckbox::SetStatus( const BIT_BOOL p_Status )
 {
+	if( m_Status == p_Status )
+	{
+		return;
+	}
+
 	m_Status = p_Status;
+
+	if( m_pManager )
+	{
+		m_pManager->OnCheckboxChanged( this, m_Position, m_Size );
+	}
+}
+
+void GUICheckbox::SetManager( GUIManager * p_pManager, const BIT_UINT32 p_GridId )
+{
+	m_pManager = p_pManager;
+	m_GridId = p_GridId;
 }
 
 // Get functions
@@ -70,4 +106,9 @@ BIT_BOOL GUICheckbox::GetStatus( ) const
 	return m_Status;
 }
 
+BIT_UINT32 GUICheckbox::GetGridId( ) const
+{
+	return m_GridId;
+}
+
 
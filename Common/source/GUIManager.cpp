@@ -24,21 +24,140 @@
 
 #include <GUIManager.hpp>
 #include <Bit/Graphics/ShaderProgram.hpp>
+#include <Bit/System/Timer.hpp>
+#include <OpenGL.hpp>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
 #include <Bit/System/Debugger.hpp>
 #include <Bit/System/MemoryLeak.hpp>
 
+// Widget texture layout, two RGBA32F texels per widget, has to match the vertex shader
+static const BIT_UINT32 WidgetTextureWidth = 1024;
+static const BIT_UINT32 TexelsPerWidget = GUIManager::QuadSize / 4;
+static const BIT_UINT32 MinBatchCapacity = 64;
+
+// Atlas layout, the pages are bound to the first texture units and the widget texture after them.
+// The padding keeps the first mipmap levels from bleeding between the images.
+static const BIT_UINT32 MaxAtlasPages = 4;
+static const BIT_UINT32 AtlasPageSize = 512;
+static const BIT_UINT32 AtlasPadding = 2;
+static const BIT_UINT32 WidgetTextureUnit = MaxAtlasPages;
+static const BIT_UINT32 WidgetImageSize = 16;
+
+// Hit-testing grid cell size in pixels
+static const BIT_UINT32 GridCellSize = 64;
+
+// Dirty rectangles of the layer, further rectangles are merged into the closest one
+static const BIT_UINT32 MaxDirtyRects = 8;
+
+// Uniform handles
+static const UniformHandle WidgetCountHandle( "WidgetCount" );
+
+// Shader sources, the batched variant reads the widgets from the widget texture
+// and the per widget variant from uniforms. The premultiplied variant draws into the layer.
+static const std::string VertexSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec3 Position; \n"
+	"in vec2 Texture; \n"
+
+	"out vec2 out_Texture; \n"
+	"flat out int out_Page; \n"
+
+	"uniform mat4 ProjectionMatrix; \n"
+
+	"#ifdef BATCHED \n"
+	"uniform sampler2D WidgetTexture; \n"
+	"uniform int WidgetCount; \n"
+	"#else \n"
+	"uniform vec2 VertexPosition; \n"
+	"uniform vec2 VertexSize; \n"
+	"uniform vec2 AtlasOffset; \n"
+	"uniform vec2 AtlasSize; \n"
+	"#endif \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"#ifdef BATCHED \n"
+	// The widget index is stored in the z component, unused quads are collapsed
+	"	int Index = int( Position.z ); \n"
+	"	if( Index >= WidgetCount ) \n"
+	"	{ \n"
+	"		out_Texture = vec2( 0.0 ); \n"
+	"		out_Page = 0; \n"
+	"		gl_Position = vec4( 0.0, 0.0, 0.0, 1.0 ); \n"
+	"		return; \n"
+	"	} \n"
+
+	"	ivec2 Texel = ivec2( ( Index * 2 ) % 1024, ( Index * 2 ) / 1024 ); \n"
+	"	vec4 Rect = texelFetch( WidgetTexture, Texel, 0 ); \n"
+	"	vec4 AtlasRect = texelFetch( WidgetTexture, Texel + ivec2( 1, 0 ), 0 ); \n"
+	"#else \n"
+	"	vec4 Rect = vec4( VertexPosition, VertexSize ); \n"
+	"	vec4 AtlasRect = vec4( AtlasOffset, AtlasSize ); \n"
+	"#endif \n"
+
+	// The atlas page is the integer part of the horizontal offset
+	"	out_Page = int( AtlasRect.x ); \n"
+	"	out_Texture = vec2( fract( AtlasRect.x ), AtlasRect.y ) + Texture * AtlasRect.zw; \n"
+	"	gl_Position = ProjectionMatrix * vec4( Position.xy * Rect.zw + Rect.xy, 0.0, 1.0 ); \n"
+	"} \n";
+
+static const std::string FragmentSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec2 out_Texture; \n"
+	"flat in int out_Page; \n"
+	"out vec4 out_Color; \n"
+
+	"uniform sampler2D AtlasTexture[ 4 ]; \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	if( out_Page == 0 )			{ out_Color = texture2D( AtlasTexture[ 0 ], out_Texture ); } \n"
+	"	else if( out_Page == 1 )	{ out_Color = texture2D( AtlasTexture[ 1 ], out_Texture ); } \n"
+	"	else if( out_Page == 2 )	{ out_Color = texture2D( AtlasTexture[ 2 ], out_Texture ); } \n"
+	"	else						{ out_Color = texture2D( AtlasTexture[ 3 ], out_Texture ); } \n"
+
+	"#ifdef PREMULTIPLIED \n"
+	"	out_Color.rgb *= out_Color.a; \n"
+	"#endif \n"
+	"} \n";
+
 
 // Construtor/destructor
 GUIManager::GUIManager( Bit::GraphicDevice * p_pGraphicDevice ) :
 	m_Loaded( BIT_FALSE ),
 	m_pGraphicDevice( p_pGraphicDevice ),
 	m_pVertexObject( BIT_NULL ),
-	m_pShaderProgram( BIT_NULL ),
-	m_pVertexShader( BIT_NULL ),
-	m_pFragmentShader( BIT_NULL ),
-	m_ButtonIsPressed( BIT_FALSE )
+	m_ButtonIsPressed( BIT_FALSE ),
+	m_ViewportSize( 0, 0 ),
+	m_pHoveredCheckbox( BIT_NULL ),
+	m_pPressedCheckbox( BIT_NULL ),
+	m_ClickButton( 1 ),
+	m_pPermutations( BIT_NULL ),
+	m_BatchedFeature( 0 ),
+	m_PremultipliedFeature( 0 ),
+	m_pWidgetTexture( BIT_NULL ),
+	m_pBatchVertexObject( BIT_NULL ),
+	m_BatchCapacity( 0 ),
+	m_RenderMode( Render_Batched ),
+	m_DrawCallCount( 0 ),
+	m_RenderTime( 0.0f ),
+	m_pLayerTexture( BIT_NULL ),
+	m_pLayerFramebuffer( BIT_NULL ),
+	m_LayerValid( BIT_FALSE ),
+	m_RedrawFrameCount( 0 ),
+	m_SkippedFrameCount( 0 ),
+	m_RedrawnWidgetCount( 0 )
 {
-
+	for( BIT_UINT32 i = 0; i < Image_Count; i++ )
+	{
+		m_WidgetImages[ i ] = 0;
+	}
 }
 
 GUIManager::~GUIManager( )
@@ -79,6 +198,14 @@ BIT_UINT32 GUIManager::Load( )
 		return BIT_ERROR;
 	}
 
+	// The grid covers the viewport, widgets outside of it end up in the border cells
+	m_ViewportSize = Bit::Vector2_ui32( m_pGraphicDevice->GetViewportHigh( ).x, m_pGraphicDevice->GetViewportHigh( ).y );
+	if( m_Grid.Load( m_ViewportSize, GridCellSize ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::Load] Can not load the hit-testing grid\n" );
+		return BIT_ERROR;
+	}
+
 	m_Loaded = BIT_TRUE;
 	return BIT_OK;
 }
@@ -94,27 +221,61 @@ void GUIManager::Unload( )
 		m_pVertexObject = BIT_NULL;
 	}
 
-	if( m_pShaderProgram )
+	if( m_pBatchVertexObject )
+	{
+		delete m_pBatchVertexObject;
+		m_pBatchVertexObject = BIT_NULL;
+	}
+
+	if( m_pPermutations )
 	{
-		delete m_pShaderProgram;
-		m_pShaderProgram = BIT_NULL;
+		delete m_pPermutations;
+		m_pPermutations = BIT_NULL;
 	}
 
-	if( m_pVertexShader )
+	for( BIT_MEMSIZE i = 0; i < m_AtlasPages.size( ); i++ )
 	{
-		delete m_pVertexShader;
-		m_pVertexShader = BIT_NULL;
+		delete m_AtlasPages[ i ].pTexture;
 	}
+	m_AtlasPages.clear( );
+	m_Images.clear( );
+	m_AtlasPacker.Clear( );
 
-	if( m_pFragmentShader )
+	if( m_pWidgetTexture )
 	{
-		delete m_pFragmentShader;
-		m_pFragmentShader = BIT_NULL;
+		delete m_pWidgetTexture;
+		m_pWidgetTexture = BIT_NULL;
 	}
 
+	m_BatchCapacity = 0;
+	m_WidgetData.clear( );
+
+	if( m_pLayerFramebuffer )
+	{
+		delete m_pLayerFramebuffer;
+		m_pLayerFramebuffer = BIT_NULL;
+	}
+
+	if( m_pLayerTexture )
+	{
+		delete m_pLayerTexture;
+		m_pLayerTexture = BIT_NULL;
+	}
+
+	m_LayerValid = BIT_FALSE;
+	m_DirtyRects.clear( );
+
 	// Clear the GUI elements
+	for( BIT_MEMSIZE i = 0; i < m_Checkboxes.size( ); i++ )
+	{
+		m_Checkboxes[ i ]->SetManager( BIT_NULL, WidgetGrid::InvalidId );
+	}
 	m_Checkboxes.clear( );
 	m_Sliders.clear( );
+	m_Grid.Clear( );
+	m_GridCheckboxes.clear( );
+	m_pHoveredCheckbox = BIT_NULL;
+	m_pPressedCheckbox = BIT_NULL;
 
 	// Reset some flags
 	m_ButtonIsPressed = BIT_FALSE;
@@ -123,6 +284,46 @@ void GUIManager::Unload( )
 
 BIT_UINT32 GUIManager::Update( Bit::Event & p_Event )
 {
+	if( !m_Loaded )
+	{
+		return BIT_ERROR;
+	}
+
+	switch( p_Event.Type )
+	{
+		case Bit::Event::MouseMoved:
+		{
+			m_pHoveredCheckbox = GetCheckboxAt( GetCursorPosition( p_Event ) );
+		}
+		break;
+		case Bit::Event::ButtonJustPressed:
+		{
+			if( p_Event.Button == m_ClickButton )
+			{
+				m_pPressedCheckbox = GetCheckboxAt( GetCursorPosition( p_Event ) );
+				m_ButtonIsPressed = BIT_TRUE;
+			}
+		}
+		break;
+		case Bit::Event::ButtonJustReleased:
+		{
+			// A click has to be pressed and released on the same checkbox
+			if( p_Event.Button == m_ClickButton )
+			{
+				if( m_pPressedCheckbox && m_pPressedCheckbox == GetCheckboxAt( GetCursorPosition( p_Event ) ) )
+				{
+					m_pPressedCheckbox->SetStatus( !m_pPressedCheckbox->GetStatus( ) );
+				}
+
+				m_pPressedCheckbox = BIT_NULL;
+				m_ButtonIsPressed = BIT_FALSE;
+			}
+		}
+		break;
+		default:
+			break;
+	}
+
 	return BIT_OK;
 }
 
@@ -134,27 +335,35 @@ void GUIManager::Render( )
 		return;
 	}
 
+	Bit::Timer Timer;
+	Timer.Start( );
+	m_DrawCallCount = 0;
+
+	// Upload the modified atlas pages
+	UploadAtlasPages( );
+
 	// Render the checkboxes
-	// ..
-	for( BIT_MEMSIZE i = 0; i < m_Checkboxes.size( ); i++ )
+	if( m_RenderMode == Render_Batched )
 	{
-		m_pShaderProgram->Bind( );
-		m_pShaderProgram->SetUniform2f( "VertexPosition", m_Checkboxes[ i ]->GetPosition( ).x,
-			m_Checkboxes[ i ]->GetPosition( ).y );
-		m_pShaderProgram->SetUniform2f( "VertexSize", m_Checkboxes[ i ]->GetSize( ).x,
-			m_Checkboxes[ i ]->GetSize( ).y );
-
-		m_pVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
-		m_pShaderProgram->Unbind( );
+		RenderBatched( m_Checkboxes, m_BatchedFeature );
+	}
+	else if( m_RenderMode == Render_PerWidget )
+	{
+		RenderPerWidget( );
+	}
+	else
+	{
+		RenderRetained( );
 	}
-
 
 	// Render the sliders
 	// ..
 
+	Timer.Stop( );
+	m_RenderTime = Timer.GetTime( ) * 1000.0f;
 }
 
-BIT_UINT32 GUIManager::Add( const GUICheckbox * p_pCheckbox )
+BIT_UINT32 GUIManager::Add( GUICheckbox * p_pCheckbox )
 {
 	if( p_pCheckbox == BIT_NULL )
 	{
@@ -162,7 +371,29 @@ BIT_UINT32 GUIManager::Add( const GUICheckbox * p_pCheckbox )
 		return BIT_ERROR;
 	}
 
+	if( !m_Loaded )
+	{
+		bitTrace( "[GUIManager::Add(Checkbox)] Is not loaded yet\n" );
+		return BIT_ERROR;
+	}
+
+	// Link the checkbox, it keeps the grid and the layer up to date when it's changed
+	const BIT_UINT32 Id = m_Grid.Add( p_pCheckbox->GetPosition( ), p_pCheckbox->GetSize( ) );
+	if( Id == WidgetGrid::InvalidId )
+	{
+		bitTrace( "[GUIManager::Add(Checkbox)] Can not add the checkbox to the grid\n" );
+		return BIT_ERROR;
+	}
+
+	if( Id >= m_GridCheckboxes.size( ) )
+	{
+		m_GridCheckboxes.resize( Id + 1, BIT_NULL );
+	}
+	m_GridCheckboxes[ Id ] = p_pCheckbox;
+	p_pCheckbox->SetManager( this, Id );
+
 	m_Checkboxes.push_back( p_pCheckbox );
+	MarkDirty( p_pCheckbox->GetPosition( ), p_pCheckbox->GetSize( ) );
 	return BIT_OK;
 }
 
@@ -178,12 +409,36 @@ BIT_UINT32 GUIManager::Add( const GUISlider * p_pSlider )
 	return BIT_OK;
 }
 
-BIT_UINT32 GUIManager::Remove( const GUICheckbox * p_pCheckbox )
+BIT_UINT32 GUIManager::Remove( GUICheckbox * p_pCheckbox )
 {
 	// Search for the pointer
-	// ...
+	for( BIT_MEMSIZE i = 0; i < m_Checkboxes.size( ); i++ )
+	{
+		if( m_Checkboxes[ i ] != p_pCheckbox )
+		{
+			continue;
+		}
+
+		m_Grid.Remove( p_pCheckbox->GetGridId( ) );
+		m_GridCheckboxes[ p_pCheckbox->GetGridId( ) ] = BIT_NULL;
+		p_pCheckbox->SetManager( BIT_NULL, WidgetGrid::InvalidId );
+		m_Checkboxes.erase( m_Checkboxes.begin( ) + i );
+		MarkDirty( p_pCheckbox->GetPosition( ), p_pCheckbox->GetSize( ) );
+
+		if( m_pHoveredCheckbox == p_pCheckbox )
+		{
+			m_pHoveredCheckbox = BIT_NULL;
+		}
+		if( m_pPressedCheckbox == p_pCheckbox )
+		{
+			m_pPressedCheckbox = BIT_NULL;
+		}
+
+		return BIT_OK;
+	}
 
-	return BIT_OK;
+	bitTrace( "[GUIManager::Remove(Checkbox)] The checkbox is not added\n" );
+	return BIT_ERROR;
 }
 
 BIT_UINT32 GUIManager::Remove( const GUISlider * p_pSlider )
@@ -194,6 +449,44 @@ BIT_UINT32 GUIManager::Remove( const GUISlider * p_pSlider )
 	return BIT_OK;
 }
 
+BIT_UINT32 GUIManager::AddImage( const Bit::Vector2_ui32 p_Size, const BIT_UINT8 * p_pPixels, BIT_UINT32 & p_Index )
+{
+	if( !m_Loaded )
+	{
+		bitTrace( "[GUIManager::AddImage] Is not loaded yet\n" );
+		return BIT_ERROR;
+	}
+
+	return PackImage( p_Size, p_pPixels, p_Index );
+}
+
+void GUIManager::RenderQuads( const BIT_FLOAT32 * p_pQuads, const BIT_UINT32 p_Count )
+{
+	if( !m_Loaded || p_Count == 0 || ReserveBatch( p_Count ) != BIT_OK )
+	{
+		return;
+	}
+
+	// Images added since the last render have to reach the atlas first
+	UploadAtlasPages( );
+
+	memcpy( &m_WidgetData[ 0 ], p_pQuads, p_Count * QuadSize * sizeof( BIT_FLOAT32 ) );
+	DrawBatch( p_Count, m_BatchedFeature );
+}
+
+void GUIManager::InvalidateLayer( )
+{
+	// Redraw the whole layer the next frame
+	m_LayerValid = BIT_FALSE;
+	m_DirtyRects.clear( );
+}
+
+void GUIManager::ResetLayerStatistics( )
+{
+	m_RedrawFrameCount = 0;
+	m_SkippedFrameCount = 0;
+}
+
 // Set functions
 void GUIManager::SetCheckboxImagePath( const std::string p_FilePath )
 {
@@ -205,6 +498,22 @@ void GUIManager::SetSliderImagePath( const std::string p_FilePath )
 	m_SliderImagePath = p_FilePath;
 }
 
+void GUIManager::SetRenderMode( const eRenderMode p_Mode )
+{
+	// Changes aren't tracked by the other modes
+	if( p_Mode == Render_Retained && m_RenderMode != Render_Retained )
+	{
+		InvalidateLayer( );
+	}
+
+	m_RenderMode = p_Mode;
+}
+
+void GUIManager::SetClickButton( const BIT_UINT32 p_Button )
+{
+	m_ClickButton = p_Button;
+}
+
 // Get functions
 std::string GUIManager::GetCheckboxImagePath( ) const
 {
@@ -216,6 +525,68 @@ std::string GUIManager::GetSliderImagePath( ) const
 	return m_SliderImagePath;
 }
 
+GUIManager::eRenderMode GUIManager::GetRenderMode( ) const
+{
+	return m_RenderMode;
+}
+
+BIT_UINT32 GUIManager::GetDrawCallCount( ) const
+{
+	return m_DrawCallCount;
+}
+
+BIT_FLOAT64 GUIManager::GetRenderTime( ) const
+{
+	return m_RenderTime;
+}
+
+BIT_UINT32 GUIManager::GetAtlasPageCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_AtlasPages.size( ) );
+}
+
+const AtlasPacker::Region & GUIManager::GetImageRegion( const BIT_UINT32 p_Index ) const
+{
+	return m_Images[ p_Index ].Region;
+}
+
+const BIT_FLOAT32 * GUIManager::GetImageRect( const BIT_UINT32 p_Index ) const
+{
+	return m_Images[ p_Index ].Rect;
+}
+
+GUICheckbox * GUIManager::GetCheckboxAt( const Bit::Vector2_si32 p_Position ) const
+{
+	const BIT_UINT32 Id = m_Grid.Query( p_Position );
+	return Id != WidgetGrid::InvalidId ? m_GridCheckboxes[ Id ] : BIT_NULL;
+}
+
+GUICheckbox * GUIManager::GetHoveredCheckbox( ) const
+{
+	return m_pHoveredCheckbox;
+}
+
+const WidgetGrid & GUIManager::GetGrid( ) const
+{
+	return m_Grid;
+}
+
+BIT_UINT32 GUIManager::GetRedrawFrameCount( ) const
+{
+	return m_RedrawFrameCount;
+}
+
+BIT_UINT32 GUIManager::GetSkippedFrameCount( ) const
+{
+	return m_SkippedFrameCount;
+}
+
+BIT_UINT32 GUIManager::GetRedrawnWidgetCount( ) const
+{
+	return m_RedrawnWidgetCount;
+}
+
+// Private functions
 BIT_UINT32 GUIManager::LoadVertexObject( )
 {
 	// Create the fullscreen vertex object
@@ -239,9 +610,6 @@ BIT_UINT32 GUIManager::LoadVertexObject( )
 		0.0f, 0.0f,		1.0f, 1.0f,		0.0f, 1.0f
 	};
 
-	// SLOW WAY 
-
-
 	if( m_pVertexObject->AddVertexBuffer( VertexPositions, 3, Bit::Type_Float32 ) != BIT_OK )
 	{
 		bitTrace( "[GUIManager::LoadVertexObject] Can not add vertex position buffer\n" );
@@ -263,142 +631,674 @@ BIT_UINT32 GUIManager::LoadVertexObject( )
 	return BIT_OK;
 }
 
-BIT_UINT32 GUIManager::LoadShaders( )
+BIT_UINT32 GUIManager::LoadBatchVertexObject( const BIT_UINT32 p_Capacity )
 {
-		// Shader sources
-	static const std::string VertexSource =
-		"#version 330 \n"
-		"precision highp float; \n"
+	if( m_pBatchVertexObject )
+	{
+		delete m_pBatchVertexObject;
+		m_pBatchVertexObject = BIT_NULL;
+	}
+
+	if( ( m_pBatchVertexObject = m_pGraphicDevice->CreateVertexObject( ) ) == BIT_NULL )
+	{
+		bitTrace( "[GUIManager::LoadBatchVertexObject] Can not create the vertex object via the graphic device\n" );
+		return BIT_ERROR;
+	}
+
+	// One quad per widget, the same unit quad with the widget index in z.
+	// The vertices never change, the widgets are streamed through the widget texture.
+	static const BIT_FLOAT32 Corners[ 12 ] =
+	{
+		0.0f, 0.0f,		1.0f, 0.0f,		1.0f, 1.0f,
+		0.0f, 0.0f,		1.0f, 1.0f,		0.0f, 1.0f
+	};
+
+	std::vector< BIT_FLOAT32 > VertexPositions( p_Capacity * 18 );
+	std::vector< BIT_FLOAT32 > VertexTextures( p_Capacity * 12 );
+
+	for( BIT_UINT32 i = 0; i < p_Capacity; i++ )
+	{
+		for( BIT_UINT32 j = 0; j < 6; j++ )
+		{
+			VertexPositions[ i * 18 + j * 3 ] = Corners[ j * 2 ];
+			VertexPositions[ i * 18 + j * 3 + 1 ] = Corners[ j * 2 + 1 ];
+			VertexPositions[ i * 18 + j * 3 + 2 ] = static_cast< BIT_FLOAT32 >( i );
+			VertexTextures[ i * 12 + j * 2 ] = Corners[ j * 2 ];
+			VertexTextures[ i * 12 + j * 2 + 1 ] = Corners[ j * 2 + 1 ];
+		}
+	}
+
+	if( m_pBatchVertexObject->AddVertexBuffer( &VertexPositions[ 0 ], 3, Bit::Type_Float32 ) != BIT_OK ||
+		m_pBatchVertexObject->AddVertexBuffer( &VertexTextures[ 0 ], 2, Bit::Type_Float32 ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::LoadBatchVertexObject] Can not add the vertex buffers\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_pBatchVertexObject->Load( p_Capacity * 2, 3 ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::LoadBatchVertexObject] Can not load the vertex object\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+BIT_UINT32 GUIManager::LoadWidgetTexture( const BIT_UINT32 p_Capacity )
+{
+	if( m_pWidgetTexture )
+	{
+		delete m_pWidgetTexture;
+		m_pWidgetTexture = BIT_NULL;
+	}
+
+	if( ( m_pWidgetTexture = m_pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
+	{
+		bitTrace( "[GUIManager::LoadWidgetTexture] Can not create the texture\n" );
+		return BIT_ERROR;
+	}
+
+	// Whole rows are uploaded, size the CPU copy to match
+	const BIT_UINT32 Rows = ( p_Capacity * TexelsPerWidget + WidgetTextureWidth - 1 ) / WidgetTextureWidth;
+	m_WidgetData.resize( Rows * WidgetTextureWidth * 4, 0.0f );
+
+	if( m_pWidgetTexture->Load( Bit::Vector2_ui32( WidgetTextureWidth, Rows ), Bit::RGBA, Bit::RGBA,
+		Bit::Type_Float32, BIT_NULL ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::LoadWidgetTexture] Can not load the texture\n" );
+		return BIT_ERROR;
+	}
 
-		"in vec3 Position; \n"
-		"in vec2 Texture; \n"
+	Bit::Texture::eFilter Filters[ ] =
+	{
+		Bit::Texture::Filter_Min, Bit::Texture::Filter_Nearest,
+		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Nearest,
+		Bit::Texture::Filter_Wrap_X, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_Wrap_Y, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_None, Bit::Texture::Filter_None
+	};
 
-		"out vec3 out_Position; \n"
-		"out vec2 out_Texture; \n"
+	if( m_pWidgetTexture->SetFilters( Filters ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::LoadWidgetTexture] Can not set the texture filters\n" );
+		return BIT_ERROR;
+	}
 
-		"uniform mat4 ProjectionMatrix; \n"
-		"uniform vec2 VertexPosition; \n"
-		"uniform vec2 VertexSize; \n"
+	return BIT_OK;
+}
 
-		"void main(void) \n"
-		"{ \n"
+BIT_UINT32 GUIManager::LoadShaders( )
+{
+	// The batched variant is compiled right away to catch errors early,
+	// the per widget variant the first time it's used.
+	m_pPermutations = new ShaderPermutations( m_pGraphicDevice, "GUI" );
+	m_pPermutations->SetSources( VertexSource, FragmentSource );
+	m_pPermutations->SetSetupFunction( SetupProgram, this );
+	m_BatchedFeature = m_pPermutations->AddFeature( "BATCHED" );
+	m_PremultipliedFeature = m_pPermutations->AddFeature( "PREMULTIPLIED" );
+	m_pPermutations->AddAttribute( "Position", 0 );
+	m_pPermutations->AddAttribute( "Texture", 1 );
 
-		// Set the output position
-		"	gl_Position = ProjectionMatrix * vec4( Position * vec3( VertexSize, 0.0 ) + vec3( VertexPosition, 0.0 ), 1.0 ); \n"
+	// Set uniforms
+	m_ProjectionMatrix.Orthographic( 0.0f, m_pGraphicDevice->GetViewportHigh( ).x,
+		0.0f, m_pGraphicDevice->GetViewportHigh( ).y, -1.0f, 1.0f );
+
+	if( m_pPermutations->Get( m_BatchedFeature ) == BIT_NULL )
+	{
+		bitTrace( "[GUIManager::LoadShaders] Can not load the batched shader program\n" );
+		return BIT_ERROR;
+	}
 
-		"} \n";
+	return BIT_OK;
+}
 
-	static const std::string FragmentSource =
-		"#version 330 \n"
-		"precision highp float; \n"
+BIT_UINT32 GUIManager::LoadTextures( )
+{
+	if( m_AtlasPacker.Load( Bit::Vector2_ui32( AtlasPageSize, AtlasPageSize ), AtlasPadding, MaxAtlasPages ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::LoadTextures] Can not load the atlas packer\n" );
+		return BIT_ERROR;
+	}
 
-		"in vec3 out_Position; \n"
-		"in vec2 out_Texture; \n"
-		"out vec4 out_Color; \n"
+	// Generate the built in widget images
+	std::vector< BIT_UINT8 > Pixels( WidgetImageSize * WidgetImageSize * 4 );
 
-		"uniform sampler2D Texture; \n"
+	for( BIT_UINT32 i = 0; i < Image_Count; i++ )
+	{
+		for( BIT_UINT32 y = 0; y < WidgetImageSize; y++ )
+		{
+			for( BIT_UINT32 x = 0; x < WidgetImageSize; x++ )
+			{
+				const BIT_BOOL Border = x == 0 || y == 0 || x == WidgetImageSize - 1 || y == WidgetImageSize - 1;
+				const BIT_BOOL Inner = x >= 4 && y >= 4 && x < WidgetImageSize - 4 && y < WidgetImageSize - 4;
+				const BIT_BOOL Center = y >= WidgetImageSize / 2 - 2 && y < WidgetImageSize / 2 + 2;
+				BIT_UINT8 * pPixel = &Pixels[ ( y * WidgetImageSize + x ) * 4 ];
+
+				// Gray value and alpha of the pixel
+				BIT_UINT8 Value = 40;
+				BIT_UINT8 Alpha = 160;
+
+				switch( i )
+				{
+					case Image_CheckboxOff:
+					{
+						Value = Border ? 230 : 40;
+						Alpha = Border ? 255 : 160;
+					}
+					break;
+					case Image_CheckboxOn:
+					{
+						Value = Border || Inner ? 230 : 40;
+						Alpha = Border || Inner ? 255 : 160;
+					}
+					break;
+					case Image_SliderTrack:
+					{
+						Value = 180;
+						Alpha = Center ? 255 : 0;
+					}
+					break;
+					case Image_SliderKnob:
+					{
+						Value = Border ? 255 : 200;
+						Alpha = 255;
+					}
+					break;
+				}
+
+				pPixel[ 0 ] = pPixel[ 1 ] = pPixel[ 2 ] = Value;
+				pPixel[ 3 ] = Alpha;
+			}
+		}
+
+		if( PackImage( Bit::Vector2_ui32( WidgetImageSize, WidgetImageSize ), &Pixels[ 0 ], m_WidgetImages[ i ] ) != BIT_OK )
+		{
+			bitTrace( "[GUIManager::LoadTextures] Can not pack the widget images\n" );
+			return BIT_ERROR;
+		}
+	}
 
-		"void main(void) \n"
-		"{ \n"
+	return BIT_OK;
+}
 
-		// Set the output color
-		"	out_Color =  vec4( 1.0, 0.0, 0.0, 1.0 ); \n"
-		"} \n";
+BIT_UINT32 GUIManager::LoadAtlasPage( )
+{
+	AtlasPage NewPage;
+	NewPage.Pixels.resize( AtlasPageSize * AtlasPageSize * 4, 0 );
+	NewPage.Modified = BIT_TRUE;
 
-	// Load the shaders
-	// Create the vertex and fragment shaders
-	if( ( m_pVertexShader = m_pGraphicDevice->CreateShader( Bit::Shader::Vertex ) ) == BIT_NULL )
+	if( ( NewPage.pTexture = m_pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
 	{
-		bitTrace( "[GUIManager::LoadShaders] Can not create the vertex shader\n" );
+		bitTrace( "[GUIManager::LoadAtlasPage] Can not create the texture\n" );
 		return BIT_ERROR;
 	}
-	if( ( m_pFragmentShader = m_pGraphicDevice->CreateShader( Bit::Shader::Fragment ) ) == BIT_NULL )
+
+	if( NewPage.pTexture->Load( Bit::Vector2_ui32( AtlasPageSize, AtlasPageSize ), Bit::RGBA, Bit::RGBA,
+		Bit::Type_UChar8, &NewPage.Pixels[ 0 ] ) != BIT_OK )
 	{
-		bitTrace( "[GUIManager::LoadShaders] Can not create the vertex shader\n" );
+		bitTrace( "[GUIManager::LoadAtlasPage] Can not load the texture\n" );
+		delete NewPage.pTexture;
 		return BIT_ERROR;
 	}
 
-	// Set the sources
-	m_pVertexShader->SetSource( VertexSource );
-	m_pFragmentShader->SetSource( FragmentSource );
+	Bit::Texture::eFilter Filters[ ] =
+	{
+		Bit::Texture::Filter_Min, Bit::Texture::Filter_Linear_Mipmap,
+		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Linear,
+		Bit::Texture::Filter_Wrap_X, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_Wrap_Y, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_None, Bit::Texture::Filter_None
+	};
 
-	// Compile the shaders
-	if( m_pVertexShader->Compile( ) != BIT_OK )
+	if( NewPage.pTexture->SetFilters( Filters ) != BIT_OK )
 	{
-		bitTrace( "[GUIManager::LoadShaders] Can not compile the vertex shader\n" );
+		bitTrace( "[GUIManager::LoadAtlasPage] Can not set the texture filters\n" );
+		delete NewPage.pTexture;
 		return BIT_ERROR;
 	}
-	if( m_pFragmentShader->Compile( ) != BIT_OK )
+
+	m_AtlasPages.push_back( NewPage );
+	return BIT_OK;
+}
+
+BIT_UINT32 GUIManager::LoadLayer( )
+{
+	if( ( m_pLayerTexture = m_pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
 	{
-		bitTrace( "[GUIManager::LoadShaders] Can not compile the fragment shader\n" );
+		bitTrace( "[GUIManager::LoadLayer] Can not create the texture\n" );
 		return BIT_ERROR;
 	}
 
+	if( m_pLayerTexture->Load( m_ViewportSize, Bit::RGBA, Bit::RGBA, Bit::Type_UChar8, BIT_NULL ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::LoadLayer] Can not load the texture\n" );
+		return BIT_ERROR;
+	}
 
-	// Create the shader program
-	if( ( m_pShaderProgram = m_pGraphicDevice->CreateShaderProgram( ) ) == BIT_NULL )
+	// The layer covers the viewport texel by texel
+	Bit::Texture::eFilter Filters[ ] =
 	{
-		bitTrace( "[GUIManager::LoadShaders] Can not create the shader program\n" );
+		Bit::Texture::Filter_Min, Bit::Texture::Filter_Nearest,
+		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Nearest,
+		Bit::Texture::Filter_Wrap_X, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_Wrap_Y, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_None, Bit::Texture::Filter_None
+	};
+
+	if( m_pLayerTexture->SetFilters( Filters ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::LoadLayer] Can not set the texture filters\n" );
 		return BIT_ERROR;
 	}
 
-	// Attach the shaders
-	if( m_pShaderProgram->AttachShaders( m_pVertexShader ) != BIT_OK )
+	if( ( m_pLayerFramebuffer = m_pGraphicDevice->CreateFramebuffer( ) ) == BIT_NULL )
 	{
-		bitTrace( "[GUIManager::LoadShaders] Can not attach the vertex shader\n" );
+		bitTrace( "[GUIManager::LoadLayer] Can not create the framebuffer\n" );
 		return BIT_ERROR;
 	}
-	if( m_pShaderProgram->AttachShaders( m_pFragmentShader ) != BIT_OK )
+
+	if( m_pLayerFramebuffer->Attach( m_pLayerTexture ) != BIT_OK )
 	{
-		bitTrace( "[GUIManager::LoadShaders] Can not attach the fragment shader\n" );
+		bitTrace( "[GUIManager::LoadLayer] Can not attach the texture to the framebuffer\n" );
 		return BIT_ERROR;
 	}
 
-	// Set attribute locations
-	m_pShaderProgram->SetAttributeLocation( "Position", 0 );
-	m_pShaderProgram->SetAttributeLocation( "Texture", 1 );
+	return BIT_OK;
+}
 
-	// Link the shaders
-	if( m_pShaderProgram->Link( ) != BIT_OK )
+BIT_UINT32 GUIManager::PackImage( const Bit::Vector2_ui32 p_Size, const BIT_UINT8 * p_pPixels, BIT_UINT32 & p_Index )
+{
+	if( p_pPixels == BIT_NULL )
 	{
-		bitTrace( "[GUIManager::LoadShaders] Can not link the shader program\n" );
+		bitTrace( "[GUIManager::PackImage] NULL param\n" );
 		return BIT_ERROR;
 	}
 
-	// Set uniforms
-	Bit::Matrix4x4 Matrix;
-	Matrix.Orthographic( 0.0f, m_pGraphicDevice->GetViewportHigh( ).x,
-		0.0f, m_pGraphicDevice->GetViewportHigh( ).y, -1.0f, 1.0f );
+	AtlasImage NewImage;
+	if( m_AtlasPacker.Add( p_Size, NewImage.Region ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::PackImage] Can not fit the image in the atlas\n" );
+		return BIT_ERROR;
+	}
+
+	const AtlasPacker::Region & Region = NewImage.Region;
+	while( m_AtlasPages.size( ) <= Region.Page )
+	{
+		if( LoadAtlasPage( ) != BIT_OK )
+		{
+			return BIT_ERROR;
+		}
+	}
+
+	// Copy the rows into the page, the upload waits for the next render
+	AtlasPage & Page = m_AtlasPages[ Region.Page ];
+	for( BIT_UINT32 y = 0; y < Region.Size.y; y++ )
+	{
+		memcpy( &Page.Pixels[ ( ( Region.Position.y + y ) * AtlasPageSize + Region.Position.x ) * 4 ],
+			p_pPixels + y * Region.Size.x * 4, Region.Size.x * 4 );
+	}
+	Page.Modified = BIT_TRUE;
+
+	// The page is stored in the integer part of the horizontal offset
+	const BIT_FLOAT32 Scale = 1.0f / static_cast< BIT_FLOAT32 >( AtlasPageSize );
+	NewImage.Rect[ 0 ] = static_cast< BIT_FLOAT32 >( Region.Page ) + static_cast< BIT_FLOAT32 >( Region.Position.x ) * Scale;
+	NewImage.Rect[ 1 ] = static_cast< BIT_FLOAT32 >( Region.Position.y ) * Scale;
+	NewImage.Rect[ 2 ] = static_cast< BIT_FLOAT32 >( Region.Size.x ) * Scale;
+	NewImage.Rect[ 3 ] = static_cast< BIT_FLOAT32 >( Region.Size.y ) * Scale;
+
+	p_Index = static_cast< BIT_UINT32 >( m_Images.size( ) );
+	m_Images.push_back( NewImage );
+	return BIT_OK;
+}
+
+void GUIManager::UploadAtlasPages( )
+{
+	std::vector< BIT_UINT8 > Levels[ 2 ];
+
+	for( BIT_MEMSIZE i = 0; i < m_AtlasPages.size( ); i++ )
+	{
+		AtlasPage & Page = m_AtlasPages[ i ];
+		if( !Page.Modified )
+		{
+			continue;
+		}
+
+		Page.pTexture->Bind( 0 );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, AtlasPageSize, AtlasPageSize, GL_RGBA, GL_UNSIGNED_BYTE, &Page.Pixels[ 0 ] );
+
+		// Box filter the mipmaps down to 1x1
+		const BIT_UINT8 * pSource = &Page.Pixels[ 0 ];
+		BIT_UINT32 Size = AtlasPageSize;
+
+		for( GLint Level = 1; Size > 1; Level++ )
+		{
+			const BIT_UINT32 SourceSize = Size;
+			Size /= 2;
+
+			std::vector< BIT_UINT8 > & Destination = Levels[ Level % 2 ];
+			Destination.resize( Size * Size * 4 );
+
+			for( BIT_UINT32 y = 0; y < Size; y++ )
+			{
+				for( BIT_UINT32 x = 0; x < Size; x++ )
+				{
+					const BIT_UINT8 * pTexel = pSource + ( y * 2 * SourceSize + x * 2 ) * 4;
+					for( BIT_UINT32 c = 0; c < 4; c++ )
+					{
+						Destination[ ( y * Size + x ) * 4 + c ] = static_cast< BIT_UINT8 >( ( pTexel[ c ] + pTexel[ 4 + c ] +
+							pTexel[ SourceSize * 4 + c ] + pTexel[ SourceSize * 4 + 4 + c ] + 2 ) / 4 );
+					}
+				}
+			}
+
+			glTexImage2D( GL_TEXTURE_2D, Level, GL_RGBA, Size, Size, 0, GL_RGBA, GL_UNSIGNED_BYTE, &Destination[ 0 ] );
+			pSource = &Destination[ 0 ];
+		}
+
+		Page.Modified = BIT_FALSE;
+	}
+}
+
+void GUIManager::BindAtlasPages( ) const
+{
+	for( BIT_MEMSIZE i = 0; i < m_AtlasPages.size( ); i++ )
+	{
+		m_AtlasPages[ i ].pTexture->Bind( static_cast< BIT_UINT32 >( i ) );
+	}
+}
+
+BIT_UINT32 GUIManager::ReserveBatch( const BIT_UINT32 p_Count )
+{
+	if( p_Count <= m_BatchCapacity )
+	{
+		return BIT_OK;
+	}
+
+	BIT_UINT32 Capacity = m_BatchCapacity > MinBatchCapacity ? m_BatchCapacity : MinBatchCapacity;
+	while( Capacity < p_Count )
+	{
+		Capacity *= 2;
+	}
+
+	if( LoadBatchVertexObject( Capacity ) != BIT_OK || LoadWidgetTexture( Capacity ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::ReserveBatch] Can not grow the batch to %u quads\n", Capacity );
+		m_BatchCapacity = 0;
+		return BIT_ERROR;
+	}
 
-	m_pShaderProgram->Bind( );
-	m_pShaderProgram->SetUniform1i( "Texture", 0 );
-	m_pShaderProgram->SetUniformMatrix4x4f( "ProjectionMatrix", Matrix );
+	m_BatchCapacity = Capacity;
+	return BIT_OK;
+}
 
-	m_pShaderProgram->Unbind( );
+void GUIManager::DrawBatch( const BIT_UINT32 p_Count, const BIT_UINT32 p_Key )
+{
+	ShaderPermutations::Permutation * pPermutation = m_pPermutations->Get( p_Key );
+	if( pPermutation == BIT_NULL )
+	{
+		return;
+	}
 
+	// Upload the rows in use
+	const BIT_UINT32 Rows = ( p_Count * TexelsPerWidget + WidgetTextureWidth - 1 ) / WidgetTextureWidth;
+	m_pWidgetTexture->Bind( WidgetTextureUnit );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, WidgetTextureWidth, Rows, GL_RGBA, GL_FLOAT, &m_WidgetData[ 0 ] );
 
+	// Draw every quad at once
+	pPermutation->pShaderProgram->Bind( );
+	pPermutation->pUniforms->SetUniform1i( WidgetCountHandle, static_cast< BIT_SINT32 >( p_Count ) );
+	BindAtlasPages( );
+	m_pBatchVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
+	pPermutation->pShaderProgram->Unbind( );
 
+	m_DrawCallCount++;
+}
 
+void GUIManager::RenderBatched( const std::vector< GUICheckbox * > & p_Checkboxes, const BIT_UINT32 p_Key )
+{
+	const BIT_UINT32 WidgetCount = static_cast< BIT_UINT32 >( p_Checkboxes.size( ) );
+	if( WidgetCount == 0 || ReserveBatch( WidgetCount ) != BIT_OK )
+	{
+		return;
+	}
 
+	// Write the widgets, position and size followed by the atlas rectangle
+	for( BIT_UINT32 i = 0; i < WidgetCount; i++ )
+	{
+		const GUICheckbox * pCheckbox = p_Checkboxes[ i ];
+		BIT_FLOAT32 * pData = &m_WidgetData[ i * TexelsPerWidget * 4 ];
+
+		pData[ 0 ] = static_cast< BIT_FLOAT32 >( pCheckbox->GetPosition( ).x );
+		pData[ 1 ] = static_cast< BIT_FLOAT32 >( pCheckbox->GetPosition( ).y );
+		pData[ 2 ] = static_cast< BIT_FLOAT32 >( pCheckbox->GetSize( ).x );
+		pData[ 3 ] = static_cast< BIT_FLOAT32 >( pCheckbox->GetSize( ).y );
+		const BIT_FLOAT32 * pRect = m_Images[ m_WidgetImages[ pCheckbox->GetStatus( ) ? Image_CheckboxOn : Image_CheckboxOff ] ].Rect;
+		pData[ 4 ] = pRect[ 0 ];
+		pData[ 5 ] = pRect[ 1 ];
+		pData[ 6 ] = pRect[ 2 ];
+		pData[ 7 ] = pRect[ 3 ];
+	}
 
+	DrawBatch( WidgetCount, p_Key );
+}
 
+void GUIManager::RenderPerWidget( )
+{
+	ShaderPermutations::Permutation * pPermutation = m_pPermutations->Get( 0 );
+	if( pPermutation == BIT_NULL )
+	{
+		return;
+	}
 
+	for( BIT_MEMSIZE i = 0; i < m_Checkboxes.size( ); i++ )
+	{
+		const BIT_FLOAT32 * pAtlasRect = m_Images[ m_WidgetImages[ m_Checkboxes[ i ]->GetStatus( ) ? Image_CheckboxOn : Image_CheckboxOff ] ].Rect;
 
+		pPermutation->pShaderProgram->Bind( );
+		BindAtlasPages( );
+		pPermutation->pShaderProgram->SetUniform2f( "VertexPosition", m_Checkboxes[ i ]->GetPosition( ).x,
+			m_Checkboxes[ i ]->GetPosition( ).y );
+		pPermutation->pShaderProgram->SetUniform2f( "VertexSize", m_Checkboxes[ i ]->GetSize( ).x,
+			m_Checkboxes[ i ]->GetSize( ).y );
+		pPermutation->pShaderProgram->SetUniform2f( "AtlasOffset", pAtlasRect[ 0 ], pAtlasRect[ 1 ] );
+		pPermutation->pShaderProgram->SetUniform2f( "AtlasSize", pAtlasRect[ 2 ], pAtlasRect[ 3 ] );
 
+		m_pVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
+		pPermutation->pShaderProgram->Unbind( );
 
+		m_DrawCallCount++;
+	}
+}
 
+void GUIManager::RenderRetained( )
+{
+	if( m_pLayerFramebuffer == BIT_NULL && LoadLayer( ) != BIT_OK )
+	{
+		bitTrace( "[GUIManager::RenderRetained] Can not load the layer\n" );
+		m_RenderMode = Render_Batched;
+		return;
+	}
 
+	if( !m_LayerValid )
+	{
+		DirtyRect Rect;
+		Rect.Position = Bit::Vector2_si32( 0, 0 );
+		Rect.Size = m_ViewportSize;
+		m_DirtyRects.clear( );
+		m_DirtyRects.push_back( Rect );
+		m_LayerValid = BIT_TRUE;
+	}
 
+	// Redraw the dirty rectangles, the layer is kept as it is when nothing changed
+	m_RedrawnWidgetCount = 0;
+	if( m_DirtyRects.size( ) )
+	{
+		RenderLayer( );
+		m_DirtyRects.clear( );
+		m_RedrawFrameCount++;
+	}
+	else
+	{
+		m_SkippedFrameCount++;
+	}
 
+	ShaderPermutations::Permutation * pPermutation = m_pPermutations->Get( 0 );
+	if( pPermutation == BIT_NULL )
+	{
+		return;
+	}
 
+	// Composite the layer as a single quad, the layer is bound in place of the first atlas page
+	glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
 
+	pPermutation->pShaderProgram->Bind( );
+	m_pLayerTexture->Bind( 0 );
+	pPermutation->pShaderProgram->SetUniform2f( "VertexPosition", 0.0f, 0.0f );
+	pPermutation->pShaderProgram->SetUniform2f( "VertexSize", m_ViewportSize.x, m_ViewportSize.y );
+	pPermutation->pShaderProgram->SetUniform2f( "AtlasOffset", 0.0f, 0.0f );
+	pPermutation->pShaderProgram->SetUniform2f( "AtlasSize", 1.0f, 1.0f );
+	m_pVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
+	pPermutation->pShaderProgram->Unbind( );
 
+	m_pGraphicDevice->EnableAlpha( );
+	m_DrawCallCount++;
+}
 
+void GUIManager::RenderLayer( )
+{
+	// Keep the clear color of the application
+	GLfloat ClearColor[ 4 ];
+	glGetFloatv( GL_COLOR_CLEAR_VALUE, ClearColor );
 
-	return BIT_OK;
+	m_pLayerFramebuffer->Bind( );
+	m_pGraphicDevice->SetViewport( 0, 0, m_ViewportSize.x, m_ViewportSize.y );
+	glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+	glEnable( GL_SCISSOR_TEST );
+
+	// The widgets are premultiplied, blend them the same way
+	glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+
+	for( BIT_MEMSIZE i = 0; i < m_DirtyRects.size( ); i++ )
+	{
+		const DirtyRect & Rect = m_DirtyRects[ i ];
+		glScissor( Rect.Position.x, Rect.Position.y, Rect.Size.x, Rect.Size.y );
+		glClear( GL_COLOR_BUFFER_BIT );
+
+		// Every widget overlapping the rectangle is redrawn in order, the scissor keeps the rest intact
+		m_Grid.Query( Rect.Position, Rect.Size, m_DirtyIds );
+		m_DirtyCheckboxes.resize( m_DirtyIds.size( ) );
+		for( BIT_MEMSIZE j = 0; j < m_DirtyIds.size( ); j++ )
+		{
+			m_DirtyCheckboxes[ j ] = m_GridCheckboxes[ m_DirtyIds[ j ] ];
+		}
+
+		RenderBatched( m_DirtyCheckboxes, m_BatchedFeature | m_PremultipliedFeature );
+		m_RedrawnWidgetCount += static_cast< BIT_UINT32 >( m_DirtyCheckboxes.size( ) );
+	}
+
+	glDisable( GL_SCISSOR_TEST );
+	glClearColor( ClearColor[ 0 ], ClearColor[ 1 ], ClearColor[ 2 ], ClearColor[ 3 ] );
+	m_pGraphicDevice->EnableAlpha( );
+	m_pGraphicDevice->BindDefaultFramebuffer( );
 }
 
-BIT_UINT32 GUIManager::LoadTextures( )
+void GUIManager::MarkDirty( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size )
 {
-	return BIT_OK;
+	// Only the retained mode keeps track of the changes, an invalid layer is redrawn as a whole
+	if( m_RenderMode != Render_Retained || !m_LayerValid )
+	{
+		return;
+	}
+
+	// Clip the rectangle to the layer
+	const BIT_SINT32 Left = std::max( p_Position.x, 0 );
+	const BIT_SINT32 Bottom = std::max( p_Position.y, 0 );
+	const BIT_SINT32 Right = std::min( p_Position.x + static_cast< BIT_SINT32 >( p_Size.x ), static_cast< BIT_SINT32 >( m_ViewportSize.x ) );
+	const BIT_SINT32 Top = std::min( p_Position.y + static_cast< BIT_SINT32 >( p_Size.y ), static_cast< BIT_SINT32 >( m_ViewportSize.y ) );
+
+	if( Right <= Left || Top <= Bottom )
+	{
+		return;
+	}
+
+	DirtyRect NewRect;
+	NewRect.Position = Bit::Vector2_si32( Left, Bottom );
+	NewRect.Size = Bit::Vector2_ui32( Right - Left, Top - Bottom );
+
+	// Rectangles already covered are skipped, a toggled checkbox is often dirty already
+	BIT_MEMSIZE Closest = 0;
+	BIT_SINT64 ClosestGrowth = 0;
+
+	for( BIT_MEMSIZE i = 0; i < m_DirtyRects.size( ); i++ )
+	{
+		const DirtyRect & Rect = m_DirtyRects[ i ];
+		const BIT_SINT32 RectRight = Rect.Position.x + static_cast< BIT_SINT32 >( Rect.Size.x );
+		const BIT_SINT32 RectTop = Rect.Position.y + static_cast< BIT_SINT32 >( Rect.Size.y );
+
+		if( Left >= Rect.Position.x && Bottom >= Rect.Position.y && Right <= RectRight && Top <= RectTop )
+		{
+			return;
+		}
+
+		// Area growth of the union, picks the rectangle to merge with when the list is full
+		const BIT_SINT64 UnionArea = static_cast< BIT_SINT64 >( std::max( Right, RectRight ) - std::min( Left, Rect.Position.x ) ) *
+			static_cast< BIT_SINT64 >( std::max( Top, RectTop ) - std::min( Bottom, Rect.Position.y ) );
+		const BIT_SINT64 Growth = UnionArea - static_cast< BIT_SINT64 >( Rect.Size.x ) * static_cast< BIT_SINT64 >( Rect.Size.y );
+
+		if( i == 0 || Growth < ClosestGrowth )
+		{
+			Closest = i;
+			ClosestGrowth = Growth;
+		}
+	}
+
+	if( m_DirtyRects.size( ) < MaxDirtyRects )
+	{
+		m_DirtyRects.push_back( NewRect );
+		return;
+	}
+
+	DirtyRect & Rect = m_DirtyRects[ Closest ];
+	const BIT_SINT32 MergedLeft = std::min( Left, Rect.Position.x );
+	const BIT_SINT32 MergedBottom = std::min( Bottom, Rect.Position.y );
+	const BIT_SINT32 MergedRight = std::max( Right, Rect.Position.x + static_cast< BIT_SINT32 >( Rect.Size.x ) );
+	const BIT_SINT32 MergedTop = std::max( Top, Rect.Position.y + static_cast< BIT_SINT32 >( Rect.Size.y ) );
+	Rect.Position = Bit::Vector2_si32( MergedLeft, MergedBottom );
+	Rect.Size = Bit::Vector2_ui32( MergedRight - MergedLeft, MergedTop - MergedBottom );
+}
+
+void GUIManager::OnCheckboxChanged( GUICheckbox * p_pCheckbox, const Bit::Vector2_si32 p_OldPosition, const Bit::Vector2_ui32 p_OldSize )
+{
+	m_Grid.Move( p_pCheckbox->GetGridId( ), p_pCheckbox->GetPosition( ), p_pCheckbox->GetSize( ) );
+
+	// Both the area left behind and the new area need a redraw
+	MarkDirty( p_OldPosition, p_OldSize );
+	if( p_OldPosition.x != p_pCheckbox->GetPosition( ).x || p_OldPosition.y != p_pCheckbox->GetPosition( ).y ||
+		p_OldSize.x != p_pCheckbox->GetSize( ).x || p_OldSize.y != p_pCheckbox->GetSize( ).y )
+	{
+		MarkDirty( p_pCheckbox->GetPosition( ), p_pCheckbox->GetSize( ) );
+	}
+}
+
+Bit::Vector2_si32 GUIManager::GetCursorPosition( const Bit::Event & p_Event ) const
+{
+	// Window coordinates start at the top, the GUI at the bottom
+	return Bit::Vector2_si32( p_Event.MousePosition.x,
+		static_cast< BIT_SINT32 >( m_ViewportSize.y ) - 1 - p_Event.MousePosition.y );
+}
+
+// Static functions
+void GUIManager::SetupProgram( ShaderPermutations::Permutation & p_Permutation, void * p_pUserData )
+{
+	const GUIManager * pManager = reinterpret_cast< const GUIManager * >( p_pUserData );
+
+	p_Permutation.pShaderProgram->SetUniformMatrix4x4f( "ProjectionMatrix", pManager->m_ProjectionMatrix );
+	p_Permutation.pShaderProgram->SetUniform1i( "WidgetTexture", WidgetTextureUnit );
+
+	for( BIT_UINT32 i = 0; i < MaxAtlasPages; i++ )
+	{
+		char Name[ 32 ];
+		sprintf( Name, "AtlasTexture[%u]", i );
+		p_Permutation.pShaderProgram->SetUniform1i( Name, i );
+	}
 }
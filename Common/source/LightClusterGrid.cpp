@@ -0,0 +1,654 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <LightClusterGrid.hpp>
+#include <Bit/System/Timer.hpp>
+#include <OpenGL.hpp>
+#include <cmath>
+#include <cstring>
+
+// Visual Studio 2008 has no std::thread to ask for the core count, the assignment runs on
+// the calling thread there unless a thread count is given.
+#if !defined( _MSC_VER ) || _MSC_VER >= 1700
+	#define LIGHT_CLUSTER_THREADS
+	#include <thread>
+#endif
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+	#define LIGHT_CLUSTER_SSE
+	#include <xmmintrin.h>
+#endif
+
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Padding lights are placed far away with a zero radius so they never hit a cluster
+static const BIT_FLOAT32 PaddingPosition = 1.0e18f;
+static const BIT_UINT32 MaxThreadCount = 8;
+
+// Constructor/destructor
+LightClusterGrid::LightClusterGrid( Bit::GraphicDevice * p_pGraphicDevice ) :
+	m_Loaded( BIT_FALSE ),
+	m_pGraphicDevice( p_pGraphicDevice ),
+	m_GridX( 0 ),
+	m_GridY( 0 ),
+	m_GridZ( 0 ),
+	m_MaxLights( 0 ),
+	m_MaxIndices( 0 ),
+	m_IndexCount( 0 ),
+	m_Overflow( BIT_FALSE ),
+	m_Near( 0.0f ),
+	m_Far( 0.0f ),
+	m_QuitWorkers( BIT_FALSE ),
+	m_AssignTime( 0.0f ),
+	m_UploadTime( 0.0f ),
+	m_pAssignedLights( BIT_NULL ),
+	m_AssignedLightVersion( 0 ),
+	m_AssignedMatrixVersion( 0 ),
+	m_AssignCount( 0 ),
+	m_UploadedLightVersion( 0 ),
+	m_UploadedAssignCount( 0 ),
+	m_AssignSkipCount( 0 ),
+	m_UploadSkipCount( 0 ),
+	m_pLightTexture( BIT_NULL ),
+	m_pClusterTexture( BIT_NULL ),
+	m_pIndexTexture( BIT_NULL )
+{
+	m_ProjectionMatrix.Identity( );
+}
+
+LightClusterGrid::~LightClusterGrid( )
+{
+	Unload( );
+}
+
+// Public functions
+BIT_UINT32 LightClusterGrid::Load( const BIT_UINT32 p_GridX, const BIT_UINT32 p_GridY, const BIT_UINT32 p_GridZ,
+	const BIT_UINT32 p_MaxLights, const BIT_UINT32 p_MaxIndices, const BIT_UINT32 p_ThreadCount )
+{
+	if( m_Loaded )
+	{
+		bitTrace( "[LightClusterGrid::Load] Already loaded\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_pGraphicDevice == BIT_NULL )
+	{
+		bitTrace( "[LightClusterGrid::Load] NULL param\n" );
+		return BIT_ERROR;
+	}
+
+	if( p_GridX == 0 || p_GridY == 0 || p_GridZ == 0 || p_MaxLights == 0 || p_MaxIndices == 0 )
+	{
+		bitTrace( "[LightClusterGrid::Load] The grid and the light lists can not be empty\n" );
+		return BIT_ERROR;
+	}
+
+	m_GridX = p_GridX;
+	m_GridY = p_GridY;
+	m_GridZ = p_GridZ;
+	m_MaxLights = p_MaxLights;
+
+	// Fill whole rows of the index texture
+	const BIT_UINT32 RowSize = IndexTextureWidth * 4;
+	const BIT_UINT32 IndexRows = ( p_MaxIndices + RowSize - 1 ) / RowSize;
+	m_MaxIndices = IndexRows * RowSize;
+
+	// Pick the thread count, never more threads than depth slices
+	BIT_UINT32 ThreadCount = 1;
+#ifdef LIGHT_CLUSTER_THREADS
+	ThreadCount = p_ThreadCount ? p_ThreadCount : std::thread::hardware_concurrency( );
+#endif
+	ThreadCount = ThreadCount < 1 ? 1 : ( ThreadCount > MaxThreadCount ? MaxThreadCount : ThreadCount );
+	ThreadCount = ThreadCount > m_GridZ ? m_GridZ : ThreadCount;
+	m_Threads.resize( ThreadCount );
+
+	// Size the lists for the worst case so the assignment never allocates
+	for( BIT_UINT32 i = 0; i < ThreadCount; i++ )
+	{
+		ThreadData & Data = m_Threads[ i ];
+		Data.Indices.reserve( m_MaxIndices );
+		Data.SliceLights.reserve( m_MaxLights + 3 );
+		Data.X.reserve( m_MaxLights + 3 );
+		Data.Y.reserve( m_MaxLights + 3 );
+		Data.Z.reserve( m_MaxLights + 3 );
+		Data.Radius.reserve( m_MaxLights + 3 );
+	}
+	m_LightX.reserve( m_MaxLights + 3 );
+	m_LightY.reserve( m_MaxLights + 3 );
+	m_LightZ.reserve( m_MaxLights + 3 );
+	m_LightRadius.reserve( m_MaxLights + 3 );
+
+	// Allocate the CPU side data
+	const BIT_UINT32 ClusterCount = m_GridX * m_GridY * m_GridZ;
+	m_Clusters.resize( ClusterCount );
+	m_LightData.resize( m_MaxLights * 8 );
+	m_ClusterData.resize( ClusterCount * 4, 0.0f );
+	m_IndexData.resize( m_MaxIndices, 0.0f );
+
+	// Create the textures
+	if( LoadTexture( &m_pLightTexture, Bit::Vector2_ui32( 2, m_MaxLights ) ) != BIT_OK ||
+		LoadTexture( &m_pClusterTexture, Bit::Vector2_ui32( m_GridX * m_GridY, m_GridZ ) ) != BIT_OK ||
+		LoadTexture( &m_pIndexTexture, Bit::Vector2_ui32( IndexTextureWidth, IndexRows ) ) != BIT_OK )
+	{
+		bitTrace( "[LightClusterGrid::Load] Can not load the textures\n" );
+		return BIT_ERROR;
+	}
+
+	// The calling thread takes the first range of slices, the workers wait for the others
+	m_QuitWorkers = BIT_FALSE;
+	for( BIT_UINT32 i = 1; i < ThreadCount; i++ )
+	{
+		Worker * pWorker = new Worker;
+		pWorker->pGrid = this;
+		pWorker->Index = i;
+		m_Workers.push_back( pWorker );
+
+		if( pWorker->Thread.Start( WorkerFunction, pWorker ) != BIT_OK )
+		{
+			bitTrace( "[LightClusterGrid::Load] Can not start the worker threads\n" );
+			return BIT_ERROR;
+		}
+	}
+
+	// Force the cluster bounds to be calculated by the first assignment
+	m_ProjectionMatrix.Identity( );
+	m_pAssignedLights = BIT_NULL;
+	m_Near = m_Far = 0.0f;
+
+	m_Loaded = BIT_TRUE;
+	return BIT_OK;
+}
+
+void LightClusterGrid::Unload( )
+{
+	m_QuitWorkers = BIT_TRUE;
+	for( BIT_MEMSIZE i = 0; i < m_Workers.size( ); i++ )
+	{
+		m_Workers[ i ]->StartWaiter.Notify( );
+		m_Workers[ i ]->Thread.Join( );
+		delete m_Workers[ i ];
+	}
+	m_Workers.clear( );
+
+	Bit::Texture ** ppTextures[ 3 ] = { &m_pLightTexture, &m_pClusterTexture, &m_pIndexTexture };
+	for( BIT_MEMSIZE i = 0; i < 3; i++ )
+	{
+		if( *ppTextures[ i ] )
+		{
+			delete *ppTextures[ i ];
+			*ppTextures[ i ] = BIT_NULL;
+		}
+	}
+
+	m_Clusters.clear( );
+	m_Threads.clear( );
+	m_LightData.clear( );
+	m_ClusterData.clear( );
+	m_IndexData.clear( );
+	m_IndexCount = 0;
+	m_Loaded = BIT_FALSE;
+}
+
+void LightClusterGrid::Assign( const PointLightSet & p_Lights, const Bit::Matrix4x4 & p_ViewMatrix,
+	const Bit::Matrix4x4 & p_ProjectionMatrix, const BIT_UINT32 p_MatrixVersion )
+{
+	if( !m_Loaded )
+	{
+		bitTrace( "[LightClusterGrid::Assign] Is not loaded yet\n" );
+		return;
+	}
+
+	// The clusters are still valid if neither the matrices nor the lights changed
+	if( p_MatrixVersion != 0 && p_MatrixVersion == m_AssignedMatrixVersion &&
+		&p_Lights == m_pAssignedLights && p_Lights.GetVersion( ) == m_AssignedLightVersion )
+	{
+		m_AssignSkipCount++;
+		m_AssignTime = 0.0f;
+		return;
+	}
+
+	m_pAssignedLights = &p_Lights;
+	m_AssignedLightVersion = p_Lights.GetVersion( );
+	m_AssignedMatrixVersion = p_MatrixVersion;
+	m_AssignCount++;
+
+	Bit::Timer Timer;
+	Timer.Start( );
+
+	// The cluster bounds only depend on the projection
+	if( m_Far == 0.0f || memcmp( m_ProjectionMatrix.m, p_ProjectionMatrix.m, sizeof( m_ProjectionMatrix.m ) ) != 0 )
+	{
+		CalculateClusterBounds( p_ProjectionMatrix );
+	}
+
+	// Move the lights to view space
+	const BIT_UINT32 LightCount = p_Lights.GetCount( ) < m_MaxLights ? p_Lights.GetCount( ) : m_MaxLights;
+	const BIT_UINT32 PaddedCount = ( LightCount + 3 ) & ~3;
+	m_LightX.resize( PaddedCount );
+	m_LightY.resize( PaddedCount );
+	m_LightZ.resize( PaddedCount );
+	m_LightRadius.resize( PaddedCount );
+
+	const BIT_FLOAT32 * v = p_ViewMatrix.m;
+	const PointLight * pLights = p_Lights.GetLights( );
+	for( BIT_UINT32 i = 0; i < LightCount; i++ )
+	{
+		const BIT_FLOAT32 * p = pLights[ i ].Position;
+		m_LightX[ i ] = v[ 0 ] * p[ 0 ] + v[ 4 ] * p[ 1 ] + v[ 8 ] * p[ 2 ] + v[ 12 ];
+		m_LightY[ i ] = v[ 1 ] * p[ 0 ] + v[ 5 ] * p[ 1 ] + v[ 9 ] * p[ 2 ] + v[ 13 ];
+		m_LightZ[ i ] = v[ 2 ] * p[ 0 ] + v[ 6 ] * p[ 1 ] + v[ 10 ] * p[ 2 ] + v[ 14 ];
+		m_LightRadius[ i ] = pLights[ i ].Radius;
+	}
+
+	// Every thread owns a range of depth slices and writes its own index list
+	const BIT_UINT32 ThreadCount = static_cast< BIT_UINT32 >( m_Threads.size( ) );
+	for( BIT_MEMSIZE i = 0; i < m_Workers.size( ); i++ )
+	{
+		m_Workers[ i ]->StartWaiter.Notify( );
+	}
+
+	AssignSlices( 0, 0, m_GridZ / ThreadCount );
+
+	for( BIT_MEMSIZE i = 0; i < m_Workers.size( ); i++ )
+	{
+		while( !m_Workers[ i ]->DoneWaiter.Wait( 1.0f ) )
+		{
+		}
+	}
+
+	// Merge the index lists, the offsets of each thread's clusters are shifted by the lists before it
+	const BIT_UINT32 SliceSize = m_GridX * m_GridY;
+	BIT_UINT32 Base = 0;
+	m_Overflow = BIT_FALSE;
+
+	for( BIT_UINT32 i = 0; i < ThreadCount; i++ )
+	{
+		const std::vector< BIT_UINT32 > & Indices = m_Threads[ i ].Indices;
+		const BIT_UINT32 FirstCluster = ( i * m_GridZ / ThreadCount ) * SliceSize;
+		const BIT_UINT32 EndCluster = ( ( i + 1 ) * m_GridZ / ThreadCount ) * SliceSize;
+
+		for( BIT_UINT32 j = FirstCluster; j < EndCluster; j++ )
+		{
+			Cluster & CurrentCluster = m_Clusters[ j ];
+			CurrentCluster.Offset += Base;
+
+			// Drop the lights that don't fit in the index texture
+			if( CurrentCluster.Offset + CurrentCluster.Count > m_MaxIndices )
+			{
+				CurrentCluster.Count = CurrentCluster.Offset < m_MaxIndices ? m_MaxIndices - CurrentCluster.Offset : 0;
+				m_Overflow = BIT_TRUE;
+			}
+		}
+
+		for( BIT_MEMSIZE j = 0; j < Indices.size( ) && Base < m_MaxIndices; j++ )
+		{
+			m_IndexData[ Base++ ] = static_cast< BIT_FLOAT32 >( Indices[ j ] );
+		}
+	}
+
+	m_IndexCount = Base;
+
+	Timer.Stop( );
+	m_AssignTime = Timer.GetTime( ) * 1000.0f;
+}
+
+void LightClusterGrid::Upload( const PointLightSet & p_Lights )
+{
+	if( !m_Loaded )
+	{
+		bitTrace( "[LightClusterGrid::Upload] Is not loaded yet\n" );
+		return;
+	}
+
+	// Nothing to upload if the lights and the clusters are the ones on the GPU
+	if( m_UploadedAssignCount == m_AssignCount && &p_Lights == m_pAssignedLights &&
+		p_Lights.GetVersion( ) == m_UploadedLightVersion )
+	{
+		m_UploadSkipCount++;
+		m_UploadTime = 0.0f;
+		return;
+	}
+
+	m_UploadedAssignCount = m_AssignCount;
+	m_UploadedLightVersion = p_Lights.GetVersion( );
+
+	Bit::Timer Timer;
+	Timer.Start( );
+
+	// Lights
+	const BIT_UINT32 LightCount = p_Lights.GetCount( ) < m_MaxLights ? p_Lights.GetCount( ) : m_MaxLights;
+	const PointLight * pLights = p_Lights.GetLights( );
+	for( BIT_UINT32 i = 0; i < LightCount; i++ )
+	{
+		BIT_FLOAT32 * pData = &m_LightData[ i * 8 ];
+		pData[ 0 ] = pLights[ i ].Position[ 0 ];
+		pData[ 1 ] = pLights[ i ].Position[ 1 ];
+		pData[ 2 ] = pLights[ i ].Position[ 2 ];
+		pData[ 3 ] = pLights[ i ].Radius;
+		pData[ 4 ] = pLights[ i ].Color[ 0 ];
+		pData[ 5 ] = pLights[ i ].Color[ 1 ];
+		pData[ 6 ] = pLights[ i ].Color[ 2 ];
+		pData[ 7 ] = 0.0f;
+	}
+
+	if( LightCount > 0 )
+	{
+		m_pLightTexture->Bind( 0 );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, 2, LightCount, GL_RGBA, GL_FLOAT, &m_LightData[ 0 ] );
+	}
+
+	// Clusters
+	for( BIT_MEMSIZE i = 0; i < m_Clusters.size( ); i++ )
+	{
+		m_ClusterData[ i * 4 ] = static_cast< BIT_FLOAT32 >( m_Clusters[ i ].Offset );
+		m_ClusterData[ i * 4 + 1 ] = static_cast< BIT_FLOAT32 >( m_Clusters[ i ].Count );
+	}
+
+	m_pClusterTexture->Bind( 0 );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, m_GridX * m_GridY, m_GridZ, GL_RGBA, GL_FLOAT, &m_ClusterData[ 0 ] );
+
+	// Indices, only the rows in use
+	const BIT_UINT32 RowSize = IndexTextureWidth * 4;
+	const BIT_UINT32 IndexRows = ( m_IndexCount + RowSize - 1 ) / RowSize;
+	if( IndexRows > 0 )
+	{
+		m_pIndexTexture->Bind( 0 );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, IndexTextureWidth, IndexRows, GL_RGBA, GL_FLOAT, &m_IndexData[ 0 ] );
+	}
+
+	Timer.Stop( );
+	m_UploadTime = Timer.GetTime( ) * 1000.0f;
+}
+
+void LightClusterGrid::Bind( const BIT_UINT32 p_LightUnit, const BIT_UINT32 p_ClusterUnit, const BIT_UINT32 p_IndexUnit ) const
+{
+	m_pLightTexture->Bind( p_LightUnit );
+	m_pClusterTexture->Bind( p_ClusterUnit );
+	m_pIndexTexture->Bind( p_IndexUnit );
+}
+
+// Get functions
+BIT_UINT32 LightClusterGrid::GetGridX( ) const
+{
+	return m_GridX;
+}
+
+BIT_UINT32 LightClusterGrid::GetGridY( ) const
+{
+	return m_GridY;
+}
+
+BIT_UINT32 LightClusterGrid::GetGridZ( ) const
+{
+	return m_GridZ;
+}
+
+BIT_UINT32 LightClusterGrid::GetThreadCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Threads.size( ) );
+}
+
+BIT_UINT32 LightClusterGrid::GetIndexCount( ) const
+{
+	return m_IndexCount;
+}
+
+BIT_BOOL LightClusterGrid::GetOverflow( ) const
+{
+	return m_Overflow;
+}
+
+BIT_FLOAT32 LightClusterGrid::GetNear( ) const
+{
+	return m_Near;
+}
+
+BIT_FLOAT32 LightClusterGrid::GetFar( ) const
+{
+	return m_Far;
+}
+
+BIT_FLOAT64 LightClusterGrid::GetAssignTime( ) const
+{
+	return m_AssignTime;
+}
+
+BIT_FLOAT64 LightClusterGrid::GetUploadTime( ) const
+{
+	return m_UploadTime;
+}
+
+BIT_UINT32 LightClusterGrid::GetAssignSkipCount( ) const
+{
+	return m_AssignSkipCount;
+}
+
+BIT_UINT32 LightClusterGrid::GetUploadSkipCount( ) const
+{
+	return m_UploadSkipCount;
+}
+
+// Private functions
+void LightClusterGrid::CalculateClusterBounds( const Bit::Matrix4x4 & p_ProjectionMatrix )
+{
+	// Near and far planes of a standard symmetric perspective projection
+	const BIT_FLOAT32 * p = p_ProjectionMatrix.m;
+	m_ProjectionMatrix = p_ProjectionMatrix;
+	m_Near = p[ 14 ] / ( p[ 10 ] - 1.0f );
+	m_Far = p[ 14 ] / ( p[ 10 ] + 1.0f );
+
+	for( BIT_UINT32 k = 0; k < m_GridZ; k++ )
+	{
+		// Exponential slices, every slice covers the same depth ratio
+		const BIT_FLOAT32 SliceNear = m_Near * powf( m_Far / m_Near, static_cast< BIT_FLOAT32 >( k ) / m_GridZ );
+		const BIT_FLOAT32 SliceFar = m_Near * powf( m_Far / m_Near, static_cast< BIT_FLOAT32 >( k + 1 ) / m_GridZ );
+
+		for( BIT_UINT32 j = 0; j < m_GridY; j++ )
+		{
+			const BIT_FLOAT32 Y0 = -1.0f + 2.0f * j / m_GridY;
+			const BIT_FLOAT32 Y1 = -1.0f + 2.0f * ( j + 1 ) / m_GridY;
+
+			for( BIT_UINT32 i = 0; i < m_GridX; i++ )
+			{
+				const BIT_FLOAT32 X0 = -1.0f + 2.0f * i / m_GridX;
+				const BIT_FLOAT32 X1 = -1.0f + 2.0f * ( i + 1 ) / m_GridX;
+
+				// Box around the frustum piece, the sides are the widest at either end
+				Cluster & CurrentCluster = m_Clusters[ ( k * m_GridY + j ) * m_GridX + i ];
+				CurrentCluster.Min[ 0 ] = ( X0 < 0.0f ? X0 * SliceFar : X0 * SliceNear ) / p[ 0 ];
+				CurrentCluster.Max[ 0 ] = ( X1 > 0.0f ? X1 * SliceFar : X1 * SliceNear ) / p[ 0 ];
+				CurrentCluster.Min[ 1 ] = ( Y0 < 0.0f ? Y0 * SliceFar : Y0 * SliceNear ) / p[ 5 ];
+				CurrentCluster.Max[ 1 ] = ( Y1 > 0.0f ? Y1 * SliceFar : Y1 * SliceNear ) / p[ 5 ];
+				CurrentCluster.Min[ 2 ] = -SliceFar;
+				CurrentCluster.Max[ 2 ] = -SliceNear;
+				CurrentCluster.Offset = 0;
+				CurrentCluster.Count = 0;
+			}
+		}
+	}
+}
+
+void LightClusterGrid::AssignSlices( const BIT_UINT32 p_Thread, const BIT_UINT32 p_FirstSlice, const BIT_UINT32 p_EndSlice )
+{
+	ThreadData & Data = m_Threads[ p_Thread ];
+	Data.Indices.clear( );
+
+	const BIT_UINT32 SliceSize = m_GridX * m_GridY;
+	const BIT_UINT32 LightCount = static_cast< BIT_UINT32 >( m_LightX.size( ) );
+
+	for( BIT_UINT32 k = p_FirstSlice; k < p_EndSlice; k++ )
+	{
+		// Gather the lights overlapping the depth range of the slice
+		const Cluster & FirstCluster = m_Clusters[ k * SliceSize ];
+		Data.SliceLights.clear( );
+		Data.X.clear( );
+		Data.Y.clear( );
+		Data.Z.clear( );
+		Data.Radius.clear( );
+
+		for( BIT_UINT32 i = 0; i < LightCount; i++ )
+		{
+			if( m_LightZ[ i ] - m_LightRadius[ i ] <= FirstCluster.Max[ 2 ] &&
+				m_LightZ[ i ] + m_LightRadius[ i ] >= FirstCluster.Min[ 2 ] &&
+				m_LightRadius[ i ] > 0.0f )
+			{
+				Data.SliceLights.push_back( i );
+				Data.X.push_back( m_LightX[ i ] );
+				Data.Y.push_back( m_LightY[ i ] );
+				Data.Z.push_back( m_LightZ[ i ] );
+				Data.Radius.push_back( m_LightRadius[ i ] );
+			}
+		}
+
+		while( Data.X.size( ) & 3 )
+		{
+			Data.SliceLights.push_back( 0 );
+			Data.X.push_back( PaddingPosition );
+			Data.Y.push_back( PaddingPosition );
+			Data.Z.push_back( PaddingPosition );
+			Data.Radius.push_back( 0.0f );
+		}
+
+		// Sphere against box, four lights at a time
+		const BIT_UINT32 SliceLightCount = static_cast< BIT_UINT32 >( Data.X.size( ) );
+		for( BIT_UINT32 c = k * SliceSize; c < ( k + 1 ) * SliceSize; c++ )
+		{
+			Cluster & CurrentCluster = m_Clusters[ c ];
+			CurrentCluster.Offset = static_cast< BIT_UINT32 >( Data.Indices.size( ) );
+
+#ifdef LIGHT_CLUSTER_SSE
+			const __m128 MinX = _mm_set1_ps( CurrentCluster.Min[ 0 ] );
+			const __m128 MinY = _mm_set1_ps( CurrentCluster.Min[ 1 ] );
+			const __m128 MinZ = _mm_set1_ps( CurrentCluster.Min[ 2 ] );
+			const __m128 MaxX = _mm_set1_ps( CurrentCluster.Max[ 0 ] );
+			const __m128 MaxY = _mm_set1_ps( CurrentCluster.Max[ 1 ] );
+			const __m128 MaxZ = _mm_set1_ps( CurrentCluster.Max[ 2 ] );
+			const __m128 Zero = _mm_setzero_ps( );
+
+			for( BIT_UINT32 i = 0; i < SliceLightCount; i += 4 )
+			{
+				// Distance from the sphere center to the box along each axis, 0 inside
+				const __m128 X = _mm_loadu_ps( &Data.X[ i ] );
+				const __m128 Y = _mm_loadu_ps( &Data.Y[ i ] );
+				const __m128 Z = _mm_loadu_ps( &Data.Z[ i ] );
+				const __m128 R = _mm_loadu_ps( &Data.Radius[ i ] );
+				const __m128 Dx = _mm_max_ps( _mm_max_ps( _mm_sub_ps( MinX, X ), _mm_sub_ps( X, MaxX ) ), Zero );
+				const __m128 Dy = _mm_max_ps( _mm_max_ps( _mm_sub_ps( MinY, Y ), _mm_sub_ps( Y, MaxY ) ), Zero );
+				const __m128 Dz = _mm_max_ps( _mm_max_ps( _mm_sub_ps( MinZ, Z ), _mm_sub_ps( Z, MaxZ ) ), Zero );
+				const __m128 Distance = _mm_add_ps( _mm_add_ps( _mm_mul_ps( Dx, Dx ), _mm_mul_ps( Dy, Dy ) ), _mm_mul_ps( Dz, Dz ) );
+				const BIT_SINT32 Mask = _mm_movemask_ps( _mm_cmple_ps( Distance, _mm_mul_ps( R, R ) ) );
+
+				for( BIT_UINT32 j = 0; j < 4; j++ )
+				{
+					if( Mask & ( 1 << j ) )
+					{
+						Data.Indices.push_back( Data.SliceLights[ i + j ] );
+					}
+				}
+			}
+#else
+			for( BIT_UINT32 i = 0; i < SliceLightCount; i++ )
+			{
+				BIT_FLOAT32 Distance = 0.0f;
+				const BIT_FLOAT32 Center[ 3 ] = { Data.X[ i ], Data.Y[ i ], Data.Z[ i ] };
+				for( BIT_UINT32 j = 0; j < 3; j++ )
+				{
+					const BIT_FLOAT32 d = Center[ j ] < CurrentCluster.Min[ j ] ? CurrentCluster.Min[ j ] - Center[ j ] :
+						( Center[ j ] > CurrentCluster.Max[ j ] ? Center[ j ] - CurrentCluster.Max[ j ] : 0.0f );
+					Distance += d * d;
+				}
+
+				if( Distance <= Data.Radius[ i ] * Data.Radius[ i ] )
+				{
+					Data.Indices.push_back( Data.SliceLights[ i ] );
+				}
+			}
+#endif
+
+			CurrentCluster.Count = static_cast< BIT_UINT32 >( Data.Indices.size( ) ) - CurrentCluster.Offset;
+		}
+	}
+}
+
+BIT_UINT32 LightClusterGrid::LoadTexture( Bit::Texture ** p_ppTexture, const Bit::Vector2_ui32 p_Size )
+{
+	if( ( *p_ppTexture = m_pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
+	{
+		bitTrace( "[LightClusterGrid::LoadTexture] Can not create the texture\n" );
+		return BIT_ERROR;
+	}
+
+	if( ( *p_ppTexture )->Load( p_Size, Bit::RGBA, Bit::RGBA, Bit::Type_Float32, BIT_NULL ) != BIT_OK )
+	{
+		bitTrace( "[LightClusterGrid::LoadTexture] Can not load the texture\n" );
+		return BIT_ERROR;
+	}
+
+	// The shader uses texelFetch, but the texture still has to be complete without mipmaps
+	Bit::Texture::eFilter TextureFilters[ ] =
+	{
+		Bit::Texture::Filter_Min, Bit::Texture::Filter_Nearest,
+		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Nearest,
+		Bit::Texture::Filter_Wrap_X, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_Wrap_Y, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_None, Bit::Texture::Filter_None
+	};
+
+	if( ( *p_ppTexture )->SetFilters( TextureFilters ) != BIT_OK )
+	{
+		bitTrace( "[LightClusterGrid::LoadTexture] Can not set the texture filters\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+// Static functions
+void LightClusterGrid::WorkerFunction( void * p_pWorker )
+{
+	Worker * pWorker = static_cast< Worker * >( p_pWorker );
+	LightClusterGrid * pGrid = pWorker->pGrid;
+	const BIT_UINT32 ThreadCount = static_cast< BIT_UINT32 >( pGrid->m_Threads.size( ) );
+	const BIT_UINT32 FirstSlice = pWorker->Index * pGrid->m_GridZ / ThreadCount;
+	const BIT_UINT32 EndSlice = ( pWorker->Index + 1 ) * pGrid->m_GridZ / ThreadCount;
+
+	// Sleep between the assignments, the waiters order the memory accesses of the threads
+	while( BIT_TRUE )
+	{
+		if( !pWorker->StartWaiter.Wait( 1.0f ) )
+		{
+			continue;
+		}
+
+		if( pGrid->m_QuitWorkers )
+		{
+			return;
+		}
+
+		pGrid->AssignSlices( pWorker->Index, FirstSlice, EndSlice );
+		pWorker->DoneWaiter.Notify( );
+	}
+}
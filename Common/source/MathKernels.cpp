@@ -0,0 +1,736 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <MathKernels.hpp>
+#include <cmath>
+
+#ifdef CPU_FEATURES_SSE2
+	#include <emmintrin.h>
+#endif
+#ifdef CPU_FEATURES_AVX2
+	#include <immintrin.h>
+#endif
+
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Kernels of one instruction set, the arrays are padded to Vector3Array::Padding
+struct KernelTable
+{
+	void ( * Dot )( const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_FLOAT32 *,
+		const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_FLOAT32 *, BIT_FLOAT32 *, const BIT_UINT32 );
+	void ( * Cross )( const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_FLOAT32 *,
+		const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_FLOAT32 *, BIT_FLOAT32 *, BIT_FLOAT32 *, BIT_FLOAT32 *, const BIT_UINT32 );
+	void ( * Normalize )( BIT_FLOAT32 *, BIT_FLOAT32 *, BIT_FLOAT32 *, const BIT_UINT32 );
+	void ( * TransformPoints )( const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_FLOAT32 *,
+		BIT_FLOAT32 *, BIT_FLOAT32 *, BIT_FLOAT32 *, const BIT_UINT32 );
+	void ( * TransformBoxes )( const BIT_FLOAT32 *, const BIT_FLOAT32 * const *, const BIT_FLOAT32 * const *,
+		BIT_FLOAT32 * const *, BIT_FLOAT32 * const *, const BIT_UINT32 );
+	void ( * TestSpheres )( const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_FLOAT32 *, const BIT_FLOAT32 *,
+		const BIT_FLOAT32 *, BIT_UINT8 *, const BIT_UINT32 );
+	void ( * TestBoxes )( const BIT_FLOAT32 *, const BIT_FLOAT32 * const *, const BIT_FLOAT32 * const *, BIT_UINT8 *, const BIT_UINT32 );
+};
+
+// Scalar kernels, the reference every other path has to match
+static void DotScalar( const BIT_FLOAT32 * p_pAx, const BIT_FLOAT32 * p_pAy, const BIT_FLOAT32 * p_pAz,
+	const BIT_FLOAT32 * p_pBx, const BIT_FLOAT32 * p_pBy, const BIT_FLOAT32 * p_pBz, BIT_FLOAT32 * p_pResult, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		p_pResult[ i ] = p_pAx[ i ] * p_pBx[ i ] + p_pAy[ i ] * p_pBy[ i ] + p_pAz[ i ] * p_pBz[ i ];
+	}
+}
+
+static void CrossScalar( const BIT_FLOAT32 * p_pAx, const BIT_FLOAT32 * p_pAy, const BIT_FLOAT32 * p_pAz,
+	const BIT_FLOAT32 * p_pBx, const BIT_FLOAT32 * p_pBy, const BIT_FLOAT32 * p_pBz,
+	BIT_FLOAT32 * p_pX, BIT_FLOAT32 * p_pY, BIT_FLOAT32 * p_pZ, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 X = p_pAy[ i ] * p_pBz[ i ] - p_pAz[ i ] * p_pBy[ i ];
+		const BIT_FLOAT32 Y = p_pAz[ i ] * p_pBx[ i ] - p_pAx[ i ] * p_pBz[ i ];
+		const BIT_FLOAT32 Z = p_pAx[ i ] * p_pBy[ i ] - p_pAy[ i ] * p_pBx[ i ];
+		p_pX[ i ] = X;
+		p_pY[ i ] = Y;
+		p_pZ[ i ] = Z;
+	}
+}
+
+static void NormalizeScalar( BIT_FLOAT32 * p_pX, BIT_FLOAT32 * p_pY, BIT_FLOAT32 * p_pZ, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 Length = sqrtf( p_pX[ i ] * p_pX[ i ] + p_pY[ i ] * p_pY[ i ] + p_pZ[ i ] * p_pZ[ i ] );
+		if( Length > 0.0f )
+		{
+			p_pX[ i ] /= Length;
+			p_pY[ i ] /= Length;
+			p_pZ[ i ] /= Length;
+		}
+	}
+}
+
+static void TransformPointsScalar( const BIT_FLOAT32 * m, const BIT_FLOAT32 * p_pX, const BIT_FLOAT32 * p_pY, const BIT_FLOAT32 * p_pZ,
+	BIT_FLOAT32 * p_pResultX, BIT_FLOAT32 * p_pResultY, BIT_FLOAT32 * p_pResultZ, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 X = m[ 0 ] * p_pX[ i ] + m[ 4 ] * p_pY[ i ] + m[ 8 ] * p_pZ[ i ] + m[ 12 ];
+		const BIT_FLOAT32 Y = m[ 1 ] * p_pX[ i ] + m[ 5 ] * p_pY[ i ] + m[ 9 ] * p_pZ[ i ] + m[ 13 ];
+		const BIT_FLOAT32 Z = m[ 2 ] * p_pX[ i ] + m[ 6 ] * p_pY[ i ] + m[ 10 ] * p_pZ[ i ] + m[ 14 ];
+		p_pResultX[ i ] = X;
+		p_pResultY[ i ] = Y;
+		p_pResultZ[ i ] = Z;
+	}
+}
+
+static void TransformBoxesScalar( const BIT_FLOAT32 * m, const BIT_FLOAT32 * const * p_ppMin, const BIT_FLOAT32 * const * p_ppMax,
+	BIT_FLOAT32 * const * p_ppResultMin, BIT_FLOAT32 * const * p_ppResultMax, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		BIT_FLOAT32 Min[ 3 ];
+		BIT_FLOAT32 Max[ 3 ];
+		for( BIT_UINT32 r = 0; r < 3; r++ )
+		{
+			Min[ r ] = Max[ r ] = m[ 12 + r ];
+			for( BIT_UINT32 c = 0; c < 3; c++ )
+			{
+				const BIT_FLOAT32 A = m[ c * 4 + r ] * p_ppMin[ c ][ i ];
+				const BIT_FLOAT32 B = m[ c * 4 + r ] * p_ppMax[ c ][ i ];
+				Min[ r ] += A < B ? A : B;
+				Max[ r ] += A > B ? A : B;
+			}
+		}
+
+		for( BIT_UINT32 r = 0; r < 3; r++ )
+		{
+			p_ppResultMin[ r ][ i ] = Min[ r ];
+			p_ppResultMax[ r ][ i ] = Max[ r ];
+		}
+	}
+}
+
+static void TestSpheresScalar( const BIT_FLOAT32 * p_pPlanes, const BIT_FLOAT32 * p_pX, const BIT_FLOAT32 * p_pY, const BIT_FLOAT32 * p_pZ,
+	const BIT_FLOAT32 * p_pRadii, BIT_UINT8 * p_pResult, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		BIT_UINT8 Visible = 1;
+		for( BIT_UINT32 j = 0; j < 6; j++ )
+		{
+			const BIT_FLOAT32 * p = p_pPlanes + j * 4;
+			if( p[ 0 ] * p_pX[ i ] + p[ 1 ] * p_pY[ i ] + p[ 2 ] * p_pZ[ i ] + p[ 3 ] < -p_pRadii[ i ] )
+			{
+				Visible = 0;
+				break;
+			}
+		}
+		p_pResult[ i ] = Visible;
+	}
+}
+
+static void TestBoxesScalar( const BIT_FLOAT32 * p_pPlanes, const BIT_FLOAT32 * const * p_ppMin, const BIT_FLOAT32 * const * p_ppMax,
+	BIT_UINT8 * p_pResult, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		// The corner furthest along each plane normal decides
+		BIT_UINT8 Visible = 1;
+		for( BIT_UINT32 j = 0; j < 6; j++ )
+		{
+			const BIT_FLOAT32 * p = p_pPlanes + j * 4;
+			const BIT_FLOAT32 X = p[ 0 ] >= 0.0f ? p_ppMax[ 0 ][ i ] : p_ppMin[ 0 ][ i ];
+			const BIT_FLOAT32 Y = p[ 1 ] >= 0.0f ? p_ppMax[ 1 ][ i ] : p_ppMin[ 1 ][ i ];
+			const BIT_FLOAT32 Z = p[ 2 ] >= 0.0f ? p_ppMax[ 2 ][ i ] : p_ppMin[ 2 ][ i ];
+			if( p[ 0 ] * X + p[ 1 ] * Y + p[ 2 ] * Z + p[ 3 ] < 0.0f )
+			{
+				Visible = 0;
+				break;
+			}
+		}
+		p_pResult[ i ] = Visible;
+	}
+}
+
+static const KernelTable ScalarKernels =
+{
+	DotScalar, CrossScalar, NormalizeScalar, TransformPointsScalar, TransformBoxesScalar, TestSpheresScalar, TestBoxesScalar
+};
+
+#ifdef CPU_FEATURES_SSE2
+// SSE2 kernels, four vectors at a time
+static void DotSSE2( const BIT_FLOAT32 * p_pAx, const BIT_FLOAT32 * p_pAy, const BIT_FLOAT32 * p_pAz,
+	const BIT_FLOAT32 * p_pBx, const BIT_FLOAT32 * p_pBy, const BIT_FLOAT32 * p_pBz, BIT_FLOAT32 * p_pResult, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i += 4 )
+	{
+		const __m128 X = _mm_mul_ps( _mm_loadu_ps( p_pAx + i ), _mm_loadu_ps( p_pBx + i ) );
+		const __m128 Y = _mm_mul_ps( _mm_loadu_ps( p_pAy + i ), _mm_loadu_ps( p_pBy + i ) );
+		const __m128 Z = _mm_mul_ps( _mm_loadu_ps( p_pAz + i ), _mm_loadu_ps( p_pBz + i ) );
+		_mm_storeu_ps( p_pResult + i, _mm_add_ps( _mm_add_ps( X, Y ), Z ) );
+	}
+}
+
+static void CrossSSE2( const BIT_FLOAT32 * p_pAx, const BIT_FLOAT32 * p_pAy, const BIT_FLOAT32 * p_pAz,
+	const BIT_FLOAT32 * p_pBx, const BIT_FLOAT32 * p_pBy, const BIT_FLOAT32 * p_pBz,
+	BIT_FLOAT32 * p_pX, BIT_FLOAT32 * p_pY, BIT_FLOAT32 * p_pZ, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i += 4 )
+	{
+		const __m128 Ax = _mm_loadu_ps( p_pAx + i );
+		const __m128 Ay = _mm_loadu_ps( p_pAy + i );
+		const __m128 Az = _mm_loadu_ps( p_pAz + i );
+		const __m128 Bx = _mm_loadu_ps( p_pBx + i );
+		const __m128 By = _mm_loadu_ps( p_pBy + i );
+		const __m128 Bz = _mm_loadu_ps( p_pBz + i );
+		_mm_storeu_ps( p_pX + i, _mm_sub_ps( _mm_mul_ps( Ay, Bz ), _mm_mul_ps( Az, By ) ) );
+		_mm_storeu_ps( p_pY + i, _mm_sub_ps( _mm_mul_ps( Az, Bx ), _mm_mul_ps( Ax, Bz ) ) );
+		_mm_storeu_ps( p_pZ + i, _mm_sub_ps( _mm_mul_ps( Ax, By ), _mm_mul_ps( Ay, Bx ) ) );
+	}
+}
+
+static void NormalizeSSE2( BIT_FLOAT32 * p_pX, BIT_FLOAT32 * p_pY, BIT_FLOAT32 * p_pZ, const BIT_UINT32 p_Count )
+{
+	// A real square root and division, the reciprocal estimates wouldn't match the scalar result
+	const __m128 Zero = _mm_setzero_ps( );
+	for( BIT_UINT32 i = 0; i < p_Count; i += 4 )
+	{
+		const __m128 X = _mm_loadu_ps( p_pX + i );
+		const __m128 Y = _mm_loadu_ps( p_pY + i );
+		const __m128 Z = _mm_loadu_ps( p_pZ + i );
+		const __m128 Length = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( X, X ), _mm_mul_ps( Y, Y ) ), _mm_mul_ps( Z, Z ) ) );
+		const __m128 Mask = _mm_cmpgt_ps( Length, Zero );
+		_mm_storeu_ps( p_pX + i, _mm_or_ps( _mm_and_ps( Mask, _mm_div_ps( X, Length ) ), _mm_andnot_ps( Mask, X ) ) );
+		_mm_storeu_ps( p_pY + i, _mm_or_ps( _mm_and_ps( Mask, _mm_div_ps( Y, Length ) ), _mm_andnot_ps( Mask, Y ) ) );
+		_mm_storeu_ps( p_pZ + i, _mm_or_ps( _mm_and_ps( Mask, _mm_div_ps( Z, Length ) ), _mm_andnot_ps( Mask, Z ) ) );
+	}
+}
+
+static void TransformPointsSSE2( const BIT_FLOAT32 * m, const BIT_FLOAT32 * p_pX, const BIT_FLOAT32 * p_pY, const BIT_FLOAT32 * p_pZ,
+	BIT_FLOAT32 * p_pResultX, BIT_FLOAT32 * p_pResultY, BIT_FLOAT32 * p_pResultZ, const BIT_UINT32 p_Count )
+{
+	const __m128 M0 = _mm_set1_ps( m[ 0 ] ), M1 = _mm_set1_ps( m[ 1 ] ), M2 = _mm_set1_ps( m[ 2 ] );
+	const __m128 M4 = _mm_set1_ps( m[ 4 ] ), M5 = _mm_set1_ps( m[ 5 ] ), M6 = _mm_set1_ps( m[ 6 ] );
+	const __m128 M8 = _mm_set1_ps( m[ 8 ] ), M9 = _mm_set1_ps( m[ 9 ] ), M10 = _mm_set1_ps( m[ 10 ] );
+	const __m128 M12 = _mm_set1_ps( m[ 12 ] ), M13 = _mm_set1_ps( m[ 13 ] ), M14 = _mm_set1_ps( m[ 14 ] );
+
+	for( BIT_UINT32 i = 0; i < p_Count; i += 4 )
+	{
+		const __m128 X = _mm_loadu_ps( p_pX + i );
+		const __m128 Y = _mm_loadu_ps( p_pY + i );
+		const __m128 Z = _mm_loadu_ps( p_pZ + i );
+		const __m128 ResultX = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( M0, X ), _mm_mul_ps( M4, Y ) ), _mm_mul_ps( M8, Z ) ), M12 );
+		const __m128 ResultY = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( M1, X ), _mm_mul_ps( M5, Y ) ), _mm_mul_ps( M9, Z ) ), M13 );
+		const __m128 ResultZ = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( M2, X ), _mm_mul_ps( M6, Y ) ), _mm_mul_ps( M10, Z ) ), M14 );
+		_mm_storeu_ps( p_pResultX + i, ResultX );
+		_mm_storeu_ps( p_pResultY + i, ResultY );
+		_mm_storeu_ps( p_pResultZ + i, ResultZ );
+	}
+}
+
+static void TransformBoxesSSE2( const BIT_FLOAT32 * m, const BIT_FLOAT32 * const * p_ppMin, const BIT_FLOAT32 * const * p_ppMax,
+	BIT_FLOAT32 * const * p_ppResultMin, BIT_FLOAT32 * const * p_ppResultMax, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i += 4 )
+	{
+		const __m128 Min[ 3 ] = { _mm_loadu_ps( p_ppMin[ 0 ] + i ), _mm_loadu_ps( p_ppMin[ 1 ] + i ), _mm_loadu_ps( p_ppMin[ 2 ] + i ) };
+		const __m128 Max[ 3 ] = { _mm_loadu_ps( p_ppMax[ 0 ] + i ), _mm_loadu_ps( p_ppMax[ 1 ] + i ), _mm_loadu_ps( p_ppMax[ 2 ] + i ) };
+		__m128 ResultMin[ 3 ];
+		__m128 ResultMax[ 3 ];
+
+		for( BIT_UINT32 r = 0; r < 3; r++ )
+		{
+			ResultMin[ r ] = ResultMax[ r ] = _mm_set1_ps( m[ 12 + r ] );
+			for( BIT_UINT32 c = 0; c < 3; c++ )
+			{
+				const __m128 Element = _mm_set1_ps( m[ c * 4 + r ] );
+				const __m128 A = _mm_mul_ps( Element, Min[ c ] );
+				const __m128 B = _mm_mul_ps( Element, Max[ c ] );
+				ResultMin[ r ] = _mm_add_ps( ResultMin[ r ], _mm_min_ps( A, B ) );
+				ResultMax[ r ] = _mm_add_ps( ResultMax[ r ], _mm_max_ps( A, B ) );
+			}
+		}
+
+		for( BIT_UINT32 r = 0; r < 3; r++ )
+		{
+			_mm_storeu_ps( p_ppResultMin[ r ] + i, ResultMin[ r ] );
+			_mm_storeu_ps( p_ppResultMax[ r ] + i, ResultMax[ r ] );
+		}
+	}
+}
+
+static void StoreMaskSSE2( const __m128 p_Mask, BIT_UINT8 * p_pResult )
+{
+	const BIT_SINT32 Bits = _mm_movemask_ps( p_Mask );
+	for( BIT_UINT32 j = 0; j < 4; j++ )
+	{
+		p_pResult[ j ] = static_cast< BIT_UINT8 >( ( Bits >> j ) & 1 );
+	}
+}
+
+static void TestSpheresSSE2( const BIT_FLOAT32 * p_pPlanes, const BIT_FLOAT32 * p_pX, const BIT_FLOAT32 * p_pY, const BIT_FLOAT32 * p_pZ,
+	const BIT_FLOAT32 * p_pRadii, BIT_UINT8 * p_pResult, const BIT_UINT32 p_Count )
+{
+	const __m128 SignMask = _mm_set1_ps( -0.0f );
+	for( BIT_UINT32 i = 0; i < p_Count; i += 4 )
+	{
+		const __m128 X = _mm_loadu_ps( p_pX + i );
+		const __m128 Y = _mm_loadu_ps( p_pY + i );
+		const __m128 Z = _mm_loadu_ps( p_pZ + i );
+		const __m128 NegativeRadius = _mm_xor_ps( _mm_loadu_ps( p_pRadii + i ), SignMask );
+		__m128 Outside = _mm_setzero_ps( );
+
+		for( BIT_UINT32 j = 0; j < 6; j++ )
+		{
+			const BIT_FLOAT32 * p = p_pPlanes + j * 4;
+			const __m128 Distance = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( p[ 0 ] ), X ),
+				_mm_mul_ps( _mm_set1_ps( p[ 1 ] ), Y ) ), _mm_mul_ps( _mm_set1_ps( p[ 2 ] ), Z ) ), _mm_set1_ps( p[ 3 ] ) );
+			Outside = _mm_or_ps( Outside, _mm_cmplt_ps( Distance, NegativeRadius ) );
+		}
+
+		StoreMaskSSE2( _mm_andnot_ps( Outside, _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) ), p_pResult + i );
+	}
+}
+
+static void TestBoxesSSE2( const BIT_FLOAT32 * p_pPlanes, const BIT_FLOAT32 * const * p_ppMin, const BIT_FLOAT32 * const * p_ppMax,
+	BIT_UINT8 * p_pResult, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i += 4 )
+	{
+		__m128 Outside = _mm_setzero_ps( );
+		for( BIT_UINT32 j = 0; j < 6; j++ )
+		{
+			// The plane picks the corner, the same for every box
+			const BIT_FLOAT32 * p = p_pPlanes + j * 4;
+			const __m128 X = _mm_loadu_ps( ( p[ 0 ] >= 0.0f ? p_ppMax[ 0 ] : p_ppMin[ 0 ] ) + i );
+			const __m128 Y = _mm_loadu_ps( ( p[ 1 ] >= 0.0f ? p_ppMax[ 1 ] : p_ppMin[ 1 ] ) + i );
+			const __m128 Z = _mm_loadu_ps( ( p[ 2 ] >= 0.0f ? p_ppMax[ 2 ] : p_ppMin[ 2 ] ) + i );
+			const __m128 Distance = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( p[ 0 ] ), X ),
+				_mm_mul_ps( _mm_set1_ps( p[ 1 ] ), Y ) ), _mm_mul_ps( _mm_set1_ps( p[ 2 ] ), Z ) ), _mm_set1_ps( p[ 3 ] ) );
+			Outside = _mm_or_ps( Outside, _mm_cmplt_ps( Distance, _mm_setzero_ps( ) ) );
+		}
+
+		StoreMaskSSE2( _mm_andnot_ps( Outside, _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) ), p_pResult + i );
+	}
+}
+
+static const KernelTable SSE2Kernels =
+{
+	DotSSE2, CrossSSE2, NormalizeSSE2, TransformPointsSSE2, TransformBoxesSSE2, TestSpheresSSE2, TestBoxesSSE2
+};
+#endif
+
+#ifdef CPU_FEATURES_AVX2
+// AVX2 kernels, eight vectors at a time
+CPU_FEATURES_AVX2_FUNCTION
+static void DotAVX2( const BIT_FLOAT32 * p_pAx, const BIT_FLOAT32 * p_pAy, const BIT_FLOAT32 * p_pAz,
+	const BIT_FLOAT32 * p_pBx, const BIT_FLOAT32 * p_pBy, const BIT_FLOAT32 * p_pBz, BIT_FLOAT32 * p_pResult, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i += 8 )
+	{
+		const __m256 X = _mm256_mul_ps( _mm256_loadu_ps( p_pAx + i ), _mm256_loadu_ps( p_pBx + i ) );
+		const __m256 Y = _mm256_mul_ps( _mm256_loadu_ps( p_pAy + i ), _mm256_loadu_ps( p_pBy + i ) );
+		const __m256 Z = _mm256_mul_ps( _mm256_loadu_ps( p_pAz + i ), _mm256_loadu_ps( p_pBz + i ) );
+		_mm256_storeu_ps( p_pResult + i, _mm256_add_ps( _mm256_add_ps( X, Y ), Z ) );
+	}
+}
+
+CPU_FEATURES_AVX2_FUNCTION
+static void CrossAVX2( const BIT_FLOAT32 * p_pAx, const BIT_FLOAT32 * p_pAy, const BIT_FLOAT32 * p_pAz,
+	const BIT_FLOAT32 * p_pBx, const BIT_FLOAT32 * p_pBy, const BIT_FLOAT32 * p_pBz,
+	BIT_FLOAT32 * p_pX, BIT_FLOAT32 * p_pY, BIT_FLOAT32 * p_pZ, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i += 8 )
+	{
+		const __m256 Ax = _mm256_loadu_ps( p_pAx + i );
+		const __m256 Ay = _mm256_loadu_ps( p_pAy + i );
+		const __m256 Az = _mm256_loadu_ps( p_pAz + i );
+		const __m256 Bx = _mm256_loadu_ps( p_pBx + i );
+		const __m256 By = _mm256_loadu_ps( p_pBy + i );
+		const __m256 Bz = _mm256_loadu_ps( p_pBz + i );
+		_mm256_storeu_ps( p_pX + i, _mm256_sub_ps( _mm256_mul_ps( Ay, Bz ), _mm256_mul_ps( Az, By ) ) );
+		_mm256_storeu_ps( p_pY + i, _mm256_sub_ps( _mm256_mul_ps( Az, Bx ), _mm256_mul_ps( Ax, Bz ) ) );
+		_mm256_storeu_ps( p_pZ + i, _mm256_sub_ps( _mm256_mul_ps( Ax, By ), _mm256_mul_ps( Ay, Bx ) ) );
+	}
+}
+
+CPU_FEATURES_AVX2_FUNCTION
+static void NormalizeAVX2( BIT_FLOAT32 * p_pX, BIT_FLOAT32 * p_pY, BIT_FLOAT32 * p_pZ, const BIT_UINT32 p_Count )
+{
+	const __m256 Zero = _mm256_setzero_ps( );
+	for( BIT_UINT32 i = 0; i < p_Count; i += 8 )
+	{
+		const __m256 X = _mm256_loadu_ps( p_pX + i );
+		const __m256 Y = _mm256_loadu_ps( p_pY + i );
+		const __m256 Z = _mm256_loadu_ps( p_pZ + i );
+		const __m256 Length = _mm256_sqrt_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( X, X ), _mm256_mul_ps( Y, Y ) ),
+			_mm256_mul_ps( Z, Z ) ) );
+		const __m256 Mask = _mm256_cmp_ps( Length, Zero, _CMP_GT_OQ );
+		_mm256_storeu_ps( p_pX + i, _mm256_blendv_ps( X, _mm256_div_ps( X, Length ), Mask ) );
+		_mm256_storeu_ps( p_pY + i, _mm256_blendv_ps( Y, _mm256_div_ps( Y, Length ), Mask ) );
+		_mm256_storeu_ps( p_pZ + i, _mm256_blendv_ps( Z, _mm256_div_ps( Z, Length ), Mask ) );
+	}
+}
+
+CPU_FEATURES_AVX2_FUNCTION
+static void TransformPointsAVX2( const BIT_FLOAT32 * m, const BIT_FLOAT32 * p_pX, const BIT_FLOAT32 * p_pY, const BIT_FLOAT32 * p_pZ,
+	BIT_FLOAT32 * p_pResultX, BIT_FLOAT32 * p_pResultY, BIT_FLOAT32 * p_pResultZ, const BIT_UINT32 p_Count )
+{
+	const __m256 M0 = _mm256_set1_ps( m[ 0 ] ), M1 = _mm256_set1_ps( m[ 1 ] ), M2 = _mm256_set1_ps( m[ 2 ] );
+	const __m256 M4 = _mm256_set1_ps( m[ 4 ] ), M5 = _mm256_set1_ps( m[ 5 ] ), M6 = _mm256_set1_ps( m[ 6 ] );
+	const __m256 M8 = _mm256_set1_ps( m[ 8 ] ), M9 = _mm256_set1_ps( m[ 9 ] ), M10 = _mm256_set1_ps( m[ 10 ] );
+	const __m256 M12 = _mm256_set1_ps( m[ 12 ] ), M13 = _mm256_set1_ps( m[ 13 ] ), M14 = _mm256_set1_ps( m[ 14 ] );
+
+	for( BIT_UINT32 i = 0; i < p_Count; i += 8 )
+	{
+		const __m256 X = _mm256_loadu_ps( p_pX + i );
+		const __m256 Y = _mm256_loadu_ps( p_pY + i );
+		const __m256 Z = _mm256_loadu_ps( p_pZ + i );
+		const __m256 ResultX = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( M0, X ), _mm256_mul_ps( M4, Y ) ), _mm256_mul_ps( M8, Z ) ), M12 );
+		const __m256 ResultY = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( M1, X ), _mm256_mul_ps( M5, Y ) ), _mm256_mul_ps( M9, Z ) ), M13 );
+		const __m256 ResultZ = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( M2, X ), _mm256_mul_ps( M6, Y ) ), _mm256_mul_ps( M10, Z ) ), M14 );
+		_mm256_storeu_ps( p_pResultX + i, ResultX );
+		_mm256_storeu_ps( p_pResultY + i, ResultY );
+		_mm256_storeu_ps( p_pResultZ + i, ResultZ );
+	}
+}
+
+CPU_FEATURES_AVX2_FUNCTION
+static void TransformBoxesAVX2( const BIT_FLOAT32 * m, const BIT_FLOAT32 * const * p_ppMin, const BIT_FLOAT32 * const * p_ppMax,
+	BIT_FLOAT32 * const * p_ppResultMin, BIT_FLOAT32 * const * p_ppResultMax, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i += 8 )
+	{
+		const __m256 Min[ 3 ] = { _mm256_loadu_ps( p_ppMin[ 0 ] + i ), _mm256_loadu_ps( p_ppMin[ 1 ] + i ), _mm256_loadu_ps( p_ppMin[ 2 ] + i ) };
+		const __m256 Max[ 3 ] = { _mm256_loadu_ps( p_ppMax[ 0 ] + i ), _mm256_loadu_ps( p_ppMax[ 1 ] + i ), _mm256_loadu_ps( p_ppMax[ 2 ] + i ) };
+		__m256 ResultMin[ 3 ];
+		__m256 ResultMax[ 3 ];
+
+		for( BIT_UINT32 r = 0; r < 3; r++ )
+		{
+			ResultMin[ r ] = ResultMax[ r ] = _mm256_set1_ps( m[ 12 + r ] );
+			for( BIT_UINT32 c = 0; c < 3; c++ )
+			{
+				const __m256 Element = _mm256_set1_ps( m[ c * 4 + r ] );
+				const __m256 A = _mm256_mul_ps( Element, Min[ c ] );
+				const __m256 B = _mm256_mul_ps( Element, Max[ c ] );
+				ResultMin[ r ] = _mm256_add_ps( ResultMin[ r ], _mm256_min_ps( A, B ) );
+				ResultMax[ r ] = _mm256_add_ps( ResultMax[ r ], _mm256_max_ps( A, B ) );
+			}
+		}
+
+		for( BIT_UINT32 r = 0; r < 3; r++ )
+		{
+			_mm256_storeu_ps( p_ppResultMin[ r ] + i, ResultMin[ r ] );
+			_mm256_storeu_ps( p_ppResultMax[ r ] + i, ResultMax[ r ] );
+		}
+	}
+}
+
+CPU_FEATURES_AVX2_FUNCTION
+static void StoreMaskAVX2( const __m256 p_Outside, BIT_UINT8 * p_pResult )
+{
+	const BIT_SINT32 Bits = ~_mm256_movemask_ps( p_Outside );
+	for( BIT_UINT32 j = 0; j < 8; j++ )
+	{
+		p_pResult[ j ] = static_cast< BIT_UINT8 >( ( Bits >> j ) & 1 );
+	}
+}
+
+CPU_FEATURES_AVX2_FUNCTION
+static void TestSpheresAVX2( const BIT_FLOAT32 * p_pPlanes, const BIT_FLOAT32 * p_pX, const BIT_FLOAT32 * p_pY, const BIT_FLOAT32 * p_pZ,
+	const BIT_FLOAT32 * p_pRadii, BIT_UINT8 * p_pResult, const BIT_UINT32 p_Count )
+{
+	const __m256 SignMask = _mm256_set1_ps( -0.0f );
+	for( BIT_UINT32 i = 0; i < p_Count; i += 8 )
+	{
+		const __m256 X = _mm256_loadu_ps( p_pX + i );
+		const __m256 Y = _mm256_loadu_ps( p_pY + i );
+		const __m256 Z = _mm256_loadu_ps( p_pZ + i );
+		const __m256 NegativeRadius = _mm256_xor_ps( _mm256_loadu_ps( p_pRadii + i ), SignMask );
+		__m256 Outside = _mm256_setzero_ps( );
+
+		for( BIT_UINT32 j = 0; j < 6; j++ )
+		{
+			const BIT_FLOAT32 * p = p_pPlanes + j * 4;
+			const __m256 Distance = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( p[ 0 ] ), X ),
+				_mm256_mul_ps( _mm256_set1_ps( p[ 1 ] ), Y ) ), _mm256_mul_ps( _mm256_set1_ps( p[ 2 ] ), Z ) ), _mm256_set1_ps( p[ 3 ] ) );
+			Outside = _mm256_or_ps( Outside, _mm256_cmp_ps( Distance, NegativeRadius, _CMP_LT_OQ ) );
+		}
+
+		StoreMaskAVX2( Outside, p_pResult + i );
+	}
+}
+
+CPU_FEATURES_AVX2_FUNCTION
+static void TestBoxesAVX2( const BIT_FLOAT32 * p_pPlanes, const BIT_FLOAT32 * const * p_ppMin, const BIT_FLOAT32 * const * p_ppMax,
+	BIT_UINT8 * p_pResult, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i += 8 )
+	{
+		__m256 Outside = _mm256_setzero_ps( );
+		for( BIT_UINT32 j = 0; j < 6; j++ )
+		{
+			const BIT_FLOAT32 * p = p_pPlanes + j * 4;
+			const __m256 X = _mm256_loadu_ps( ( p[ 0 ] >= 0.0f ? p_ppMax[ 0 ] : p_ppMin[ 0 ] ) + i );
+			const __m256 Y = _mm256_loadu_ps( ( p[ 1 ] >= 0.0f ? p_ppMax[ 1 ] : p_ppMin[ 1 ] ) + i );
+			const __m256 Z = _mm256_loadu_ps( ( p[ 2 ] >= 0.0f ? p_ppMax[ 2 ] : p_ppMin[ 2 ] ) + i );
+			const __m256 Distance = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( p[ 0 ] ), X ),
+				_mm256_mul_ps( _mm256_set1_ps( p[ 1 ] ), Y ) ), _mm256_mul_ps( _mm256_set1_ps( p[ 2 ] ), Z ) ), _mm256_set1_ps( p[ 3 ] ) );
+			Outside = _mm256_or_ps( Outside, _mm256_cmp_ps( Distance, _mm256_setzero_ps( ), _CMP_LT_OQ ) );
+		}
+
+		StoreMaskAVX2( Outside, p_pResult + i );
+	}
+}
+
+static const KernelTable AVX2Kernels =
+{
+	DotAVX2, CrossAVX2, NormalizeAVX2, TransformPointsAVX2, TransformBoxesAVX2, TestSpheresAVX2, TestBoxesAVX2
+};
+#endif
+
+static CpuFeatures::eInstructionSet CurrentInstructionSet = CpuFeatures::GetSupportedInstructionSet( );
+
+static const KernelTable & GetKernels( )
+{
+	switch( CurrentInstructionSet )
+	{
+#ifdef CPU_FEATURES_AVX2
+		case CpuFeatures::InstructionSet_AVX2:
+			return AVX2Kernels;
+#endif
+#ifdef CPU_FEATURES_SSE2
+		case CpuFeatures::InstructionSet_SSE2:
+			return SSE2Kernels;
+#endif
+		default:
+			break;
+	}
+
+	return ScalarKernels;
+}
+
+// Vector array
+Vector3Array::Vector3Array( ) :
+	m_Count( 0 )
+{
+}
+
+Vector3Array::Vector3Array( const BIT_UINT32 p_Count ) :
+	m_Count( 0 )
+{
+	Resize( p_Count );
+}
+
+void Vector3Array::Resize( const BIT_UINT32 p_Count )
+{
+	const BIT_UINT32 PaddedCount = ( p_Count + Padding - 1 ) & ~( Padding - 1 );
+	m_Count = p_Count;
+	m_X.resize( PaddedCount, 0.0f );
+	m_Y.resize( PaddedCount, 0.0f );
+	m_Z.resize( PaddedCount, 0.0f );
+}
+
+void Vector3Array::Set( const BIT_UINT32 p_Index, const Bit::Vector3_f32 & p_Vector )
+{
+	m_X[ p_Index ] = p_Vector.x;
+	m_Y[ p_Index ] = p_Vector.y;
+	m_Z[ p_Index ] = p_Vector.z;
+}
+
+Bit::Vector3_f32 Vector3Array::Get( const BIT_UINT32 p_Index ) const
+{
+	return Bit::Vector3_f32( m_X[ p_Index ], m_Y[ p_Index ], m_Z[ p_Index ] );
+}
+
+BIT_UINT32 Vector3Array::GetCount( ) const
+{
+	return m_Count;
+}
+
+BIT_UINT32 Vector3Array::GetPaddedCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_X.size( ) );
+}
+
+BIT_FLOAT32 * Vector3Array::GetX( )
+{
+	return m_X.size( ) ? &m_X[ 0 ] : BIT_NULL;
+}
+
+BIT_FLOAT32 * Vector3Array::GetY( )
+{
+	return m_Y.size( ) ? &m_Y[ 0 ] : BIT_NULL;
+}
+
+BIT_FLOAT32 * Vector3Array::GetZ( )
+{
+	return m_Z.size( ) ? &m_Z[ 0 ] : BIT_NULL;
+}
+
+const BIT_FLOAT32 * Vector3Array::GetX( ) const
+{
+	return m_X.size( ) ? &m_X[ 0 ] : BIT_NULL;
+}
+
+const BIT_FLOAT32 * Vector3Array::GetY( ) const
+{
+	return m_Y.size( ) ? &m_Y[ 0 ] : BIT_NULL;
+}
+
+const BIT_FLOAT32 * Vector3Array::GetZ( ) const
+{
+	return m_Z.size( ) ? &m_Z[ 0 ] : BIT_NULL;
+}
+
+// Public functions
+void MathKernels::Dot( const Vector3Array & p_A, const Vector3Array & p_B, std::vector< BIT_FLOAT32 > & p_Result )
+{
+	const BIT_UINT32 Count = p_A.GetPaddedCount( ) < p_B.GetPaddedCount( ) ? p_A.GetPaddedCount( ) : p_B.GetPaddedCount( );
+	p_Result.resize( Count );
+	if( Count )
+	{
+		GetKernels( ).Dot( p_A.GetX( ), p_A.GetY( ), p_A.GetZ( ), p_B.GetX( ), p_B.GetY( ), p_B.GetZ( ), &p_Result[ 0 ], Count );
+	}
+}
+
+void MathKernels::Cross( const Vector3Array & p_A, const Vector3Array & p_B, Vector3Array & p_Result )
+{
+	const BIT_UINT32 Count = p_A.GetCount( ) < p_B.GetCount( ) ? p_A.GetCount( ) : p_B.GetCount( );
+	p_Result.Resize( Count );
+	if( Count )
+	{
+		GetKernels( ).Cross( p_A.GetX( ), p_A.GetY( ), p_A.GetZ( ), p_B.GetX( ), p_B.GetY( ), p_B.GetZ( ),
+			p_Result.GetX( ), p_Result.GetY( ), p_Result.GetZ( ), p_Result.GetPaddedCount( ) );
+	}
+}
+
+void MathKernels::Normalize( Vector3Array & p_Vectors )
+{
+	if( p_Vectors.GetCount( ) )
+	{
+		GetKernels( ).Normalize( p_Vectors.GetX( ), p_Vectors.GetY( ), p_Vectors.GetZ( ), p_Vectors.GetPaddedCount( ) );
+	}
+}
+
+void MathKernels::TransformPoints( const Bit::Matrix4x4 & p_Matrix, const Vector3Array & p_Points, Vector3Array & p_Result )
+{
+	p_Result.Resize( p_Points.GetCount( ) );
+	if( p_Points.GetCount( ) )
+	{
+		GetKernels( ).TransformPoints( p_Matrix.m, p_Points.GetX( ), p_Points.GetY( ), p_Points.GetZ( ),
+			p_Result.GetX( ), p_Result.GetY( ), p_Result.GetZ( ), p_Result.GetPaddedCount( ) );
+	}
+}
+
+void MathKernels::TransformBoxes( const Bit::Matrix4x4 & p_Matrix, const Vector3Array & p_Min, const Vector3Array & p_Max,
+	Vector3Array & p_ResultMin, Vector3Array & p_ResultMax )
+{
+	const BIT_UINT32 Count = p_Min.GetCount( ) < p_Max.GetCount( ) ? p_Min.GetCount( ) : p_Max.GetCount( );
+	p_ResultMin.Resize( Count );
+	p_ResultMax.Resize( Count );
+	if( Count )
+	{
+		const BIT_FLOAT32 * pMin[ 3 ] = { p_Min.GetX( ), p_Min.GetY( ), p_Min.GetZ( ) };
+		const BIT_FLOAT32 * pMax[ 3 ] = { p_Max.GetX( ), p_Max.GetY( ), p_Max.GetZ( ) };
+		BIT_FLOAT32 * pResultMin[ 3 ] = { p_ResultMin.GetX( ), p_ResultMin.GetY( ), p_ResultMin.GetZ( ) };
+		BIT_FLOAT32 * pResultMax[ 3 ] = { p_ResultMax.GetX( ), p_ResultMax.GetY( ), p_ResultMax.GetZ( ) };
+		GetKernels( ).TransformBoxes( p_Matrix.m, pMin, pMax, pResultMin, pResultMax, p_ResultMin.GetPaddedCount( ) );
+	}
+}
+
+void MathKernels::TestSpheres( const Frustum & p_Frustum, const Vector3Array & p_Centers, const std::vector< BIT_FLOAT32 > & p_Radii,
+	std::vector< BIT_UINT8 > & p_Result )
+{
+	// The radii have to cover the padding as well
+	if( p_Radii.size( ) < p_Centers.GetPaddedCount( ) )
+	{
+		bitTrace( "[MathKernels::TestSpheres] The radii are not padded like the centers\n" );
+		p_Result.clear( );
+		return;
+	}
+
+	BIT_FLOAT32 Planes[ 24 ];
+	for( BIT_UINT32 i = 0; i < 6; i++ )
+	{
+		const BIT_FLOAT32 * pPlane = p_Frustum.GetPlane( static_cast< Frustum::ePlane >( i ) );
+		for( BIT_UINT32 j = 0; j < 4; j++ )
+		{
+			Planes[ i * 4 + j ] = pPlane[ j ];
+		}
+	}
+
+	p_Result.resize( p_Centers.GetPaddedCount( ) );
+	if( p_Centers.GetCount( ) )
+	{
+		GetKernels( ).TestSpheres( Planes, p_Centers.GetX( ), p_Centers.GetY( ), p_Centers.GetZ( ), &p_Radii[ 0 ],
+			&p_Result[ 0 ], p_Centers.GetPaddedCount( ) );
+	}
+}
+
+void MathKernels::TestBoxes( const Frustum & p_Frustum, const Vector3Array & p_Min, const Vector3Array & p_Max,
+	std::vector< BIT_UINT8 > & p_Result )
+{
+	BIT_FLOAT32 Planes[ 24 ];
+	for( BIT_UINT32 i = 0; i < 6; i++ )
+	{
+		const BIT_FLOAT32 * pPlane = p_Frustum.GetPlane( static_cast< Frustum::ePlane >( i ) );
+		for( BIT_UINT32 j = 0; j < 4; j++ )
+		{
+			Planes[ i * 4 + j ] = pPlane[ j ];
+		}
+	}
+
+	const BIT_UINT32 Count = p_Min.GetPaddedCount( ) < p_Max.GetPaddedCount( ) ? p_Min.GetPaddedCount( ) : p_Max.GetPaddedCount( );
+	p_Result.resize( Count );
+	if( Count )
+	{
+		const BIT_FLOAT32 * pMin[ 3 ] = { p_Min.GetX( ), p_Min.GetY( ), p_Min.GetZ( ) };
+		const BIT_FLOAT32 * pMax[ 3 ] = { p_Max.GetX( ), p_Max.GetY( ), p_Max.GetZ( ) };
+		GetKernels( ).TestBoxes( Planes, pMin, pMax, &p_Result[ 0 ], Count );
+	}
+}
+
+// Set functions
+BIT_UINT32 MathKernels::SetInstructionSet( const CpuFeatures::eInstructionSet p_InstructionSet )
+{
+	if( p_InstructionSet > CpuFeatures::GetSupportedInstructionSet( ) )
+	{
+		bitTrace( "[MathKernels::SetInstructionSet] %s is not supported by this CPU\n",
+			CpuFeatures::GetInstructionSetName( p_InstructionSet ) );
+		return BIT_ERROR;
+	}
+
+	CurrentInstructionSet = p_InstructionSet;
+	return BIT_OK;
+}
+
+// Get functions
+CpuFeatures::eInstructionSet MathKernels::GetInstructionSet( )
+{
+	return CurrentInstructionSet;
+}
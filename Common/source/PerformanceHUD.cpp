@@ -0,0 +1,360 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <PerformanceHUD.hpp>
+#include <Bit/System/Timer.hpp>
+#include <cstdio>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Panel layout in pixels, two pixels per graph bar
+static const BIT_UINT32 BarWidth = 2;
+static const BIT_FLOAT32 GraphWidth = static_cast< BIT_FLOAT32 >( PerformanceHUD::HistorySize * BarWidth );
+static const BIT_FLOAT32 GraphHeight = 80.0f;
+static const BIT_SINT32 Padding = 6;
+static const BIT_SINT32 LineHeight = 10;
+static const BIT_SINT32 PassTextWidth = 200;
+static const BIT_UINT32 MaxPassNameLength = 14;
+static const BIT_UINT32 ColorImageSize = 4;
+
+// Colors of the solid images, RGBA
+static const BIT_UINT8 Colors[ ][ 4 ] =
+{
+	{ 0, 0, 0, 170 },		// Panel
+	{ 80, 200, 80, 255 },	// Good
+	{ 230, 200, 60, 255 },	// Warning
+	{ 220, 60, 50, 255 },	// Bad
+	{ 80, 140, 230, 255 },	// Cpu
+	{ 240, 140, 40, 255 },	// Gpu
+	{ 255, 255, 255, 140 }	// Line
+};
+
+// Counters
+PerformanceHUD::Counters::Counters( ) :
+	DrawCalls( 0 ),
+	Triangles( 0 ),
+	Binds( 0 ),
+	Memory( 0 )
+{
+}
+
+// Constructor/destructor
+PerformanceHUD::PerformanceHUD( GUIManager * p_pManager, TextRenderer * p_pText ) :
+	m_Loaded( BIT_FALSE ),
+	m_Visible( BIT_FALSE ),
+	m_pManager( p_pManager ),
+	m_pText( p_pText ),
+	m_pRenderGraph( BIT_NULL ),
+	m_Position( 0, 0 ),
+	m_TargetFrameTime( 16.6f ),
+	m_HistoryIndex( 0 ),
+	m_HistoryCount( 0 ),
+	m_HistorySum( 0.0 ),
+	m_QuadCount( 0 ),
+	m_UpdateCost( 0.0 ),
+	m_Cost( 0.0 )
+{
+}
+
+PerformanceHUD::~PerformanceHUD( )
+{
+	Unload( );
+}
+
+// Public functions
+BIT_UINT32 PerformanceHUD::Load( )
+{
+	if( m_Loaded )
+	{
+		bitTrace( "[PerformanceHUD::Load] Already loaded\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_pManager == BIT_NULL || m_pText == BIT_NULL )
+	{
+		bitTrace( "[PerformanceHUD::Load] NULL param\n" );
+		return BIT_ERROR;
+	}
+
+	// Solid color images, the quads sample the center texel only
+	BIT_UINT8 Pixels[ ColorImageSize * ColorImageSize * 4 ];
+
+	for( BIT_UINT32 i = 0; i < Color_Count; i++ )
+	{
+		for( BIT_UINT32 j = 0; j < ColorImageSize * ColorImageSize; j++ )
+		{
+			for( BIT_UINT32 c = 0; c < 4; c++ )
+			{
+				Pixels[ j * 4 + c ] = Colors[ i ][ c ];
+			}
+		}
+
+		BIT_UINT32 Index = 0;
+		if( m_pManager->AddImage( Bit::Vector2_ui32( ColorImageSize, ColorImageSize ), Pixels, Index ) != BIT_OK )
+		{
+			bitTrace( "[PerformanceHUD::Load] Can not add the color images to the GUI atlas\n" );
+			return BIT_ERROR;
+		}
+
+		const BIT_FLOAT32 * pRect = m_pManager->GetImageRect( Index );
+		m_ColorRects[ i ][ 0 ] = pRect[ 0 ] + pRect[ 2 ] * 0.5f;
+		m_ColorRects[ i ][ 1 ] = pRect[ 1 ] + pRect[ 3 ] * 0.5f;
+		m_ColorRects[ i ][ 2 ] = 0.0f;
+		m_ColorRects[ i ][ 3 ] = 0.0f;
+	}
+
+	m_Loaded = BIT_TRUE;
+	return BIT_OK;
+}
+
+void PerformanceHUD::Unload( )
+{
+	// The color images stay in the atlas of the GUI manager
+	m_Quads.clear( );
+	m_QuadCount = 0;
+	m_pRenderGraph = BIT_NULL;
+	m_Loaded = BIT_FALSE;
+}
+
+void PerformanceHUD::Update( const BIT_FLOAT64 p_FrameTime, const Counters & p_Counters, const RenderGraph * p_pRenderGraph )
+{
+	Bit::Timer Timer;
+	Timer.Start( );
+
+	// Replace the oldest frame
+	if( m_HistoryCount == HistorySize )
+	{
+		m_HistorySum -= m_History[ m_HistoryIndex ];
+	}
+	else
+	{
+		m_HistoryCount++;
+	}
+
+	m_History[ m_HistoryIndex ] = static_cast< BIT_FLOAT32 >( p_FrameTime );
+	m_HistorySum += p_FrameTime;
+	m_HistoryIndex = ( m_HistoryIndex + 1 ) % HistorySize;
+
+	m_Counters = p_Counters;
+	m_pRenderGraph = p_pRenderGraph;
+
+	Timer.Stop( );
+	m_UpdateCost = Timer.GetTime( ) * 1000.0f;
+}
+
+void PerformanceHUD::Render( )
+{
+	if( !m_Loaded || !m_Visible )
+	{
+		return;
+	}
+
+	Bit::Timer Timer;
+	Timer.Start( );
+
+	char Line[ 128 ];
+	const BIT_SINT32 Left = m_Position.x + Padding;
+	BIT_SINT32 Top = m_Position.y - Padding;
+	m_QuadCount = 0;
+
+	// The panel is the first quad, its height is known at the end
+	AddRect( 0.0f, 0.0f, 0.0f, 0.0f, Color_Panel );
+
+	// Frame time summary
+	const BIT_FLOAT32 Last = m_HistoryCount ? m_History[ ( m_HistoryIndex + HistorySize - 1 ) % HistorySize ] : 0.0f;
+	const BIT_FLOAT64 Average = GetAverageFrameTime( );
+	sprintf( Line, "Frame %6.2f ms  avg %6.2f  max %6.2f  %4.0f FPS", Last, Average, GetMaxFrameTime( ),
+		Average > 0.0 ? 1000.0 / Average : 0.0 );
+	AddText( Left, Top, Line );
+	Top -= LineHeight + 2;
+
+	// Frame time graph, the newest frame to the right and the budget at half the height
+	const BIT_FLOAT32 GraphBottom = static_cast< BIT_FLOAT32 >( Top ) - GraphHeight;
+	const BIT_UINT32 First = m_HistoryCount == HistorySize ? m_HistoryIndex : 0;
+	const BIT_FLOAT32 HeightScale = GraphHeight * 0.5f / m_TargetFrameTime;
+
+	for( BIT_UINT32 i = 0; i < m_HistoryCount; i++ )
+	{
+		const BIT_FLOAT32 Time = m_History[ ( First + i ) % HistorySize ];
+		const BIT_FLOAT32 Height = Time * HeightScale < GraphHeight ? Time * HeightScale : GraphHeight;
+		const eColor Color = Time <= m_TargetFrameTime ? Color_Good :
+			( Time <= m_TargetFrameTime * 1.5f ? Color_Warning : Color_Bad );
+
+		AddRect( static_cast< BIT_FLOAT32 >( Left ) + static_cast< BIT_FLOAT32 >( ( HistorySize - m_HistoryCount + i ) * BarWidth ),
+			GraphBottom, static_cast< BIT_FLOAT32 >( BarWidth ), Height, Color );
+	}
+
+	AddRect( static_cast< BIT_FLOAT32 >( Left ), GraphBottom + GraphHeight * 0.5f, GraphWidth, 1.0f, Color_Line );
+	Top = static_cast< BIT_SINT32 >( GraphBottom ) - Padding;
+
+	// Frame counters
+	sprintf( Line, "Draws %u  Triangles %u  Binds %u  Targets %.1f MB", m_Counters.DrawCalls, m_Counters.Triangles,
+		m_Counters.Binds, static_cast< BIT_FLOAT64 >( m_Counters.Memory ) / 1048576.0 );
+	AddText( Left, Top, Line );
+	Top -= LineHeight;
+
+	// Pass breakdown, the bars are scaled to fill the width at the budget
+	if( m_pRenderGraph )
+	{
+		const BIT_BOOL Timed = m_pRenderGraph->GetTimingEnabled( );
+		const BIT_FLOAT32 BarScale = ( GraphWidth - static_cast< BIT_FLOAT32 >( PassTextWidth ) ) / m_TargetFrameTime;
+		const BIT_FLOAT32 BarMax = GraphWidth - static_cast< BIT_FLOAT32 >( PassTextWidth );
+
+		sprintf( Line, "Pass            CPU ms  %s", Timed ? "GPU ms" : "GPU off (T)" );
+		AddText( Left, Top, Line );
+		Top -= LineHeight;
+
+		for( BIT_UINT32 i = 0; i < m_pRenderGraph->GetPassCount( ); i++ )
+		{
+			if( m_pRenderGraph->IsPassCulled( i ) )
+			{
+				continue;
+			}
+
+			const BIT_FLOAT32 CpuTime = static_cast< BIT_FLOAT32 >( m_pRenderGraph->GetPassCpuTime( i ) );
+			const BIT_FLOAT32 GpuTime = static_cast< BIT_FLOAT32 >( m_pRenderGraph->GetPassTime( i ) );
+			const std::string Name = m_pRenderGraph->GetPassName( i ).substr( 0, MaxPassNameLength );
+
+			if( Timed )
+			{
+				sprintf( Line, "%-14s  %6.3f  %6.3f", Name.c_str( ), CpuTime, GpuTime );
+			}
+			else
+			{
+				sprintf( Line, "%-14s  %6.3f", Name.c_str( ), CpuTime );
+			}
+			AddText( Left, Top, Line );
+
+			// CPU in the upper half of the line and GPU in the lower half
+			const BIT_FLOAT32 BarLeft = static_cast< BIT_FLOAT32 >( Left + PassTextWidth );
+			const BIT_FLOAT32 LineBottom = static_cast< BIT_FLOAT32 >( Top - LineHeight );
+			AddRect( BarLeft, LineBottom + 5.0f, CpuTime * BarScale < BarMax ? CpuTime * BarScale : BarMax, 4.0f, Color_Cpu );
+			if( Timed )
+			{
+				AddRect( BarLeft, LineBottom + 1.0f, GpuTime * BarScale < BarMax ? GpuTime * BarScale : BarMax, 4.0f, Color_Gpu );
+			}
+
+			Top -= LineHeight;
+		}
+	}
+
+	// The cost of the overlay itself, from the last frame
+	sprintf( Line, "HUD %.3f ms", m_Cost );
+	AddText( Left, Top, Line );
+	Top -= LineHeight;
+
+	// Size the panel
+	BIT_FLOAT32 * pPanel = &m_Quads[ 0 ];
+	pPanel[ 0 ] = static_cast< BIT_FLOAT32 >( m_Position.x );
+	pPanel[ 1 ] = static_cast< BIT_FLOAT32 >( Top - Padding );
+	pPanel[ 2 ] = GraphWidth + static_cast< BIT_FLOAT32 >( Padding * 2 );
+	pPanel[ 3 ] = static_cast< BIT_FLOAT32 >( m_Position.y - Top + Padding );
+
+	m_pManager->RenderQuads( &m_Quads[ 0 ], m_QuadCount );
+
+	Timer.Stop( );
+	m_Cost = m_UpdateCost + Timer.GetTime( ) * 1000.0f;
+}
+
+// Set functions
+void PerformanceHUD::SetVisible( const BIT_BOOL p_Visible )
+{
+	m_Visible = p_Visible;
+}
+
+void PerformanceHUD::SetPosition( const Bit::Vector2_si32 p_Position )
+{
+	m_Position = p_Position;
+}
+
+void PerformanceHUD::SetTargetFrameTime( const BIT_FLOAT32 p_FrameTime )
+{
+	m_TargetFrameTime = p_FrameTime > 0.0f ? p_FrameTime : 16.6f;
+}
+
+// Get functions
+BIT_BOOL PerformanceHUD::GetVisible( ) const
+{
+	return m_Visible;
+}
+
+BIT_FLOAT64 PerformanceHUD::GetAverageFrameTime( ) const
+{
+	return m_HistoryCount ? m_HistorySum / static_cast< BIT_FLOAT64 >( m_HistoryCount ) : 0.0;
+}
+
+BIT_FLOAT64 PerformanceHUD::GetMaxFrameTime( ) const
+{
+	BIT_FLOAT32 Max = 0.0f;
+	for( BIT_UINT32 i = 0; i < m_HistoryCount; i++ )
+	{
+		if( m_History[ i ] > Max )
+		{
+			Max = m_History[ i ];
+		}
+	}
+
+	return Max;
+}
+
+BIT_FLOAT64 PerformanceHUD::GetCost( ) const
+{
+	return m_Cost;
+}
+
+// Private functions
+void PerformanceHUD::AddRect( const BIT_FLOAT32 p_X, const BIT_FLOAT32 p_Y, const BIT_FLOAT32 p_Width, const BIT_FLOAT32 p_Height,
+	const eColor p_Color )
+{
+	Reserve( 1 );
+
+	BIT_FLOAT32 * pQuad = &m_Quads[ m_QuadCount * GUIManager::QuadSize ];
+	pQuad[ 0 ] = p_X;
+	pQuad[ 1 ] = p_Y;
+	pQuad[ 2 ] = p_Width;
+	pQuad[ 3 ] = p_Height;
+	pQuad[ 4 ] = m_ColorRects[ p_Color ][ 0 ];
+	pQuad[ 5 ] = m_ColorRects[ p_Color ][ 1 ];
+	pQuad[ 6 ] = m_ColorRects[ p_Color ][ 2 ];
+	pQuad[ 7 ] = m_ColorRects[ p_Color ][ 3 ];
+	m_QuadCount++;
+}
+
+void PerformanceHUD::AddText( const BIT_SINT32 p_X, const BIT_SINT32 p_Y, const char * p_pText )
+{
+	const std::string Text( p_pText );
+	Reserve( static_cast< BIT_UINT32 >( Text.size( ) ) );
+	m_QuadCount += m_pText->Layout( Bit::Vector2_si32( p_X, p_Y ), Text, 1, &m_Quads[ m_QuadCount * GUIManager::QuadSize ] );
+}
+
+void PerformanceHUD::Reserve( const BIT_UINT32 p_Count )
+{
+	// Grows by doubling, the list is reused every frame
+	const BIT_MEMSIZE Needed = ( m_QuadCount + p_Count ) * GUIManager::QuadSize;
+	if( Needed > m_Quads.size( ) )
+	{
+		m_Quads.resize( Needed > m_Quads.size( ) * 2 ? Needed : m_Quads.size( ) * 2 );
+	}
+}
@@ -0,0 +1,114 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <PointLightSet.hpp>
+#include <cmath>
+#include <Bit/System/MemoryLeak.hpp>
+
+// How far the lights move up and down
+static const BIT_FLOAT32 BobbingHeight = 60.0f;
+
+// Constructor
+PointLightSet::PointLightSet( ) :
+	m_RandomState( 1 ),
+	m_Version( 1 )
+{
+}
+
+// Public functions
+void PointLightSet::Generate( const BIT_UINT32 p_Count, const Bit::Vector3_f32 p_Min, const Bit::Vector3_f32 p_Max,
+	const BIT_FLOAT32 p_MinRadius, const BIT_FLOAT32 p_MaxRadius, const BIT_UINT32 p_Seed )
+{
+	m_Lights.resize( p_Count );
+	m_Heights.resize( p_Count );
+	m_RandomState = p_Seed;
+
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		PointLight & Light = m_Lights[ i ];
+		Light.Position[ 0 ] = Random( p_Min.x, p_Max.x );
+		Light.Position[ 1 ] = Random( p_Min.y, p_Max.y );
+		Light.Position[ 2 ] = Random( p_Min.z, p_Max.z );
+		Light.Radius = Random( p_MinRadius, p_MaxRadius );
+		Light.Phase = Random( 0.0f, 6.2831853f );
+
+		// Saturated colors, at least one channel is bright
+		Light.Color[ 0 ] = Random( 0.1f, 1.0f );
+		Light.Color[ 1 ] = Random( 0.1f, 1.0f );
+		Light.Color[ 2 ] = Random( 0.1f, 1.0f );
+		const BIT_FLOAT32 Brightest = Light.Color[ 0 ] > Light.Color[ 1 ] ?
+			( Light.Color[ 0 ] > Light.Color[ 2 ] ? Light.Color[ 0 ] : Light.Color[ 2 ] ) :
+			( Light.Color[ 1 ] > Light.Color[ 2 ] ? Light.Color[ 1 ] : Light.Color[ 2 ] );
+		Light.Color[ 0 ] /= Brightest;
+		Light.Color[ 1 ] /= Brightest;
+		Light.Color[ 2 ] /= Brightest;
+
+		m_Heights[ i ] = Light.Position[ 1 ];
+	}
+
+	m_Version++;
+}
+
+void PointLightSet::Update( const BIT_FLOAT64 p_Time )
+{
+	for( BIT_MEMSIZE i = 0; i < m_Lights.size( ); i++ )
+	{
+		PointLight & Light = m_Lights[ i ];
+		Light.Position[ 1 ] = m_Heights[ i ] +
+			sinf( static_cast< BIT_FLOAT32 >( p_Time ) + Light.Phase ) * BobbingHeight;
+	}
+
+	m_Version++;
+}
+
+// Get functions
+BIT_UINT32 PointLightSet::GetCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Lights.size( ) );
+}
+
+const PointLight & PointLightSet::GetLight( const BIT_UINT32 p_Index ) const
+{
+	return m_Lights[ p_Index ];
+}
+
+const PointLight * PointLightSet::GetLights( ) const
+{
+	return m_Lights.size( ) ? &m_Lights[ 0 ] : BIT_NULL;
+}
+
+BIT_UINT32 PointLightSet::GetVersion( ) const
+{
+	return m_Version;
+}
+
+// Private functions
+BIT_FLOAT32 PointLightSet::Random( const BIT_FLOAT32 p_Min, const BIT_FLOAT32 p_Max )
+{
+	// Numerical Recipes LCG, the upper 24 bits are used
+	m_RandomState = m_RandomState * 1664525U + 1013904223U;
+	const BIT_FLOAT32 Unit = static_cast< BIT_FLOAT32 >( m_RandomState >> 8 ) / 16777216.0f;
+	return p_Min + ( p_Max - p_Min ) * Unit;
+}
@@ -0,0 +1,727 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <PostProcessingDualBloom.hpp>
+#include <Bit/System/MatrixManager.hpp>
+#include <cstdio>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Uniform handles
+static const UniformHandle ColorScaleHandle( "ColorScale" );
+
+// Shader sources
+static const std::string VertexSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec3 Position; \n"
+	"in vec2 Texture; \n"
+	"out vec2 out_Texture; \n"
+
+	"uniform mat4 ProjectionMatrix; \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	out_Texture = Texture; \n"
+	"	gl_Position = ProjectionMatrix * vec4( Position, 1.0 ); \n"
+	"} \n";
+
+// 5 bilinear taps, the center weighted by 4, covering a 4x4 texel area.
+// The threshold is only used by the first level, 0 leaves the color untouched.
+static const std::string DownsampleSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec2 out_Texture; \n"
+	"out vec4 out_Color; \n"
+
+	"uniform sampler2D SourceTexture; \n"
+	"uniform vec2 TexelSize; \n"
+	"uniform float Threshold; \n"
+	"uniform vec2 SourceScale; \n"
+
+	"vec3 Sample( vec2 p_Offset ) \n"
+	"{ \n"
+	"	vec2 Coord = min( out_Texture * SourceScale + p_Offset * TexelSize, SourceScale - 0.5 * TexelSize ); \n"
+	"	vec3 Color = texture2D( SourceTexture, Coord ).rgb; \n"
+	"	float Brightness = max( Color.r, max( Color.g, Color.b ) ); \n"
+	"	return Color * ( max( Brightness - Threshold, 0.0 ) / max( Brightness, 0.0001 ) ); \n"
+	"} \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	vec3 Sum = Sample( vec2( 0.0, 0.0 ) ) * 4.0; \n"
+	"	Sum += Sample( vec2( -1.0, -1.0 ) ); \n"
+	"	Sum += Sample( vec2( 1.0, -1.0 ) ); \n"
+	"	Sum += Sample( vec2( -1.0, 1.0 ) ); \n"
+	"	Sum += Sample( vec2( 1.0, 1.0 ) ); \n"
+	"	out_Color = vec4( Sum * 0.125, 1.0 ); \n"
+	"} \n";
+
+// 8 bilinear taps in a diamond, the diagonal ones weighted by 2.
+static const std::string UpsampleSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec2 out_Texture; \n"
+	"out vec4 out_Color; \n"
+
+	"uniform sampler2D SourceTexture; \n"
+	"uniform vec2 TexelSize; \n"
+
+	"vec3 Sample( vec2 p_Offset ) \n"
+	"{ \n"
+	"	return texture2D( SourceTexture, out_Texture + p_Offset * TexelSize ).rgb; \n"
+	"} \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	vec3 Sum = Sample( vec2( -1.0, 0.0 ) ); \n"
+	"	Sum += Sample( vec2( 1.0, 0.0 ) ); \n"
+	"	Sum += Sample( vec2( 0.0, -1.0 ) ); \n"
+	"	Sum += Sample( vec2( 0.0, 1.0 ) ); \n"
+	"	Sum += Sample( vec2( -0.5, -0.5 ) ) * 2.0; \n"
+	"	Sum += Sample( vec2( 0.5, -0.5 ) ) * 2.0; \n"
+	"	Sum += Sample( vec2( -0.5, 0.5 ) ) * 2.0; \n"
+	"	Sum += Sample( vec2( 0.5, 0.5 ) ) * 2.0; \n"
+	"	out_Color = vec4( Sum / 12.0, 1.0 ); \n"
+	"} \n";
+
+static const std::string CompositeSource =
+	"#version 330 \n"
+	"precision highp float; \n"
+
+	"in vec2 out_Texture; \n"
+	"out vec4 out_Color; \n"
+
+	"uniform sampler2D ColorTexture; \n"
+	"uniform vec2 ColorScale; \n"
+
+	"#ifdef BLOOM \n"
+	"uniform sampler2D BloomTexture; \n"
+	"uniform float Intensity; \n"
+	"#endif \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	vec3 Color = texture2D( ColorTexture, out_Texture * ColorScale ).rgb; \n"
+	"#ifdef BLOOM \n"
+	"	Color += texture2D( BloomTexture, out_Texture ).rgb * Intensity; \n"
+	"#endif \n"
+	"	out_Color = vec4( Color, 1.0 ); \n"
+	"} \n";
+
+
+// Constructor/destructor
+PostProcessingDualBloom::PostProcessingDualBloom( Bit::GraphicDevice * p_pGraphicDevice, Bit::VertexObject * p_pVertexObject,
+	Bit::Texture * p_pColorTexture ) :
+	m_Loaded( BIT_FALSE ),
+	m_pGraphicDevice( p_pGraphicDevice ),
+	m_pVertexObject( p_pVertexObject ),
+	m_pColorTexture( p_pColorTexture ),
+	m_Size( 0, 0 ),
+	m_SourceSize( 0, 0 ),
+	m_SourceScale( 1.0f, 1.0f ),
+	m_LevelCount( 0 ),
+	m_Threshold( 0.0f ),
+	m_Intensity( 1.0f ),
+	m_Enabled( BIT_TRUE ),
+	m_CreateTargets( BIT_TRUE ),
+	m_pVertexShader( BIT_NULL ),
+	m_pDownsampleShader( BIT_NULL ),
+	m_pUpsampleShader( BIT_NULL ),
+	m_pDownsampleProgram( BIT_NULL ),
+	m_pUpsampleProgram( BIT_NULL ),
+	m_pCompositePermutations( BIT_NULL ),
+	m_BloomFeature( 0 )
+{
+}
+
+PostProcessingDualBloom::~PostProcessingDualBloom( )
+{
+	Unload( );
+}
+
+// Public functions
+BIT_UINT32 PostProcessingDualBloom::Load( const Bit::Vector2_ui32 p_Size, const BIT_UINT32 p_Levels,
+	const BIT_FLOAT32 p_Threshold, const BIT_FLOAT32 p_Intensity, const BIT_BOOL p_CreateTargets )
+{
+	if( m_Loaded )
+	{
+		bitTrace( "[PostProcessingDualBloom::Load] Already loaded\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_pGraphicDevice == BIT_NULL || m_pVertexObject == BIT_NULL || ( p_CreateTargets && m_pColorTexture == BIT_NULL ) )
+	{
+		bitTrace( "[PostProcessingDualBloom::Load] NULL param\n" );
+		return BIT_ERROR;
+	}
+
+	if( p_Levels == 0 )
+	{
+		bitTrace( "[PostProcessingDualBloom::Load] The chain needs at least one level\n" );
+		return BIT_ERROR;
+	}
+
+	m_Size = p_Size;
+	m_SourceSize = p_Size;
+	m_SourceScale = Bit::Vector2_f32( 1.0f, 1.0f );
+	m_LevelCount = p_Levels;
+	m_Threshold = p_Threshold;
+	m_Intensity = p_Intensity;
+	m_CreateTargets = p_CreateTargets;
+
+	if( LoadLevels( ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::Load] Can not load the render targets\n" );
+		return BIT_ERROR;
+	}
+
+	if( LoadShaders( ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::Load] Can not load the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	m_Loaded = BIT_TRUE;
+	return BIT_OK;
+}
+
+void PostProcessingDualBloom::Unload( )
+{
+	// Delete the render targets
+	for( BIT_MEMSIZE i = 0; i < m_Levels.size( ); i++ )
+	{
+		delete m_Levels[ i ].pDownFramebuffer;
+		delete m_Levels[ i ].pDownTexture;
+		delete m_Levels[ i ].pUpFramebuffer;
+		delete m_Levels[ i ].pUpTexture;
+	}
+	m_Levels.clear( );
+	m_GraphPasses.clear( );
+
+	// Delete the shaders
+	if( m_pCompositePermutations )
+	{
+		delete m_pCompositePermutations;
+		m_pCompositePermutations = BIT_NULL;
+	}
+
+	Bit::ShaderProgram ** ppPrograms[ 2 ] = { &m_pDownsampleProgram, &m_pUpsampleProgram };
+	for( BIT_MEMSIZE i = 0; i < 2; i++ )
+	{
+		if( *ppPrograms[ i ] )
+		{
+			delete *ppPrograms[ i ];
+			*ppPrograms[ i ] = BIT_NULL;
+		}
+	}
+
+	Bit::Shader ** ppShaders[ 3 ] = { &m_pVertexShader, &m_pDownsampleShader, &m_pUpsampleShader };
+	for( BIT_MEMSIZE i = 0; i < 3; i++ )
+	{
+		if( *ppShaders[ i ] )
+		{
+			delete *ppShaders[ i ];
+			*ppShaders[ i ] = BIT_NULL;
+		}
+	}
+
+	m_LevelCount = 0;
+	m_Loaded = BIT_FALSE;
+}
+
+void PostProcessingDualBloom::Process( )
+{
+	if( !m_Loaded )
+	{
+		bitTrace( "[PostProcessingDualBloom::Process] Is not loaded yet\n" );
+		return;
+	}
+
+	if( !m_CreateTargets )
+	{
+		bitTrace( "[PostProcessingDualBloom::Process] The render targets are owned by a render graph\n" );
+		return;
+	}
+
+	// Only copy the color when the bloom is disabled
+	if( !m_Enabled )
+	{
+		m_pGraphicDevice->BindDefaultFramebuffer( );
+		RenderComposite( m_pColorTexture, BIT_NULL );
+		return;
+	}
+
+	// Downsample, only the first pass applies the threshold and reads a part of its source
+	Bit::Texture * pSource = m_pColorTexture;
+	Bit::Vector2_ui32 SourceSize = m_SourceSize;
+
+	for( BIT_MEMSIZE i = 0; i < m_Levels.size( ); i++ )
+	{
+		m_pDownsampleProgram->Bind( );
+		m_pDownsampleProgram->SetUniform1f( "Threshold", i == 0 ? m_Threshold : 0.0f );
+		m_pDownsampleProgram->SetUniform2f( "SourceScale", i == 0 ? m_SourceScale.x : 1.0f, i == 0 ? m_SourceScale.y : 1.0f );
+
+		m_Levels[ i ].pDownFramebuffer->Bind( );
+		RenderPass( m_pDownsampleProgram, pSource, SourceSize, m_Levels[ i ].Size );
+
+		pSource = m_Levels[ i ].pDownTexture;
+		SourceSize = m_Levels[ i ].Size;
+	}
+
+	// Upsample back to the first level
+	for( BIT_SINT32 i = static_cast< BIT_SINT32 >( m_Levels.size( ) ) - 2; i >= 0; i-- )
+	{
+		m_Levels[ i ].pUpFramebuffer->Bind( );
+		RenderPass( m_pUpsampleProgram, pSource, SourceSize, m_Levels[ i ].Size );
+
+		pSource = m_Levels[ i ].pUpTexture;
+		SourceSize = m_Levels[ i ].Size;
+	}
+
+	// Composite the bloom on top of the color texture
+	m_pGraphicDevice->BindDefaultFramebuffer( );
+	RenderComposite( m_pColorTexture, pSource );
+}
+
+void PostProcessingDualBloom::AddPasses( RenderGraph & p_Graph, const BIT_UINT32 p_ColorTexture, const BIT_BOOL p_Composite )
+{
+	if( !m_Loaded || m_CreateTargets )
+	{
+		bitTrace( "[PostProcessingDualBloom::AddPasses] Has to be loaded without render targets\n" );
+		return;
+	}
+
+	// The graph keeps pointers to the pass data, so the vector must never grow after this.
+	m_GraphPasses.clear( );
+	m_GraphPasses.reserve( m_Levels.size( ) * 2 );
+
+	GraphPass NewPass;
+	NewPass.pBloom = this;
+	NewPass.Color = p_ColorTexture;
+	NewPass.Source = p_ColorTexture;
+	NewPass.SourceSize = m_SourceSize;
+
+	// Downsample chain, a disabled bloom only declares the composite pass
+	char Name[ 32 ];
+	for( BIT_MEMSIZE i = 0; m_Enabled && i < m_Levels.size( ); i++ )
+	{
+		sprintf( Name, "BloomDown%u", static_cast< BIT_UINT32 >( i ) );
+		const BIT_UINT32 Target = p_Graph.CreateTexture( Name,
+			RenderGraph::TextureDescription( m_Levels[ i ].Size, RenderGraph::Format_RGB8, BIT_TRUE ) );
+
+		NewPass.Type = Pass_Downsample;
+		NewPass.Level = static_cast< BIT_UINT32 >( i );
+		m_GraphPasses.push_back( NewPass );
+
+		const BIT_UINT32 Pass = p_Graph.AddPass( Name, ExecuteGraphPass, &m_GraphPasses.back( ) );
+		p_Graph.Read( Pass, NewPass.Source );
+		p_Graph.Write( Pass, Target );
+
+		NewPass.Source = Target;
+		NewPass.SourceSize = m_Levels[ i ].Size;
+	}
+
+	// Upsample chain
+	for( BIT_SINT32 i = static_cast< BIT_SINT32 >( m_Levels.size( ) ) - 2; m_Enabled && i >= 0; i-- )
+	{
+		sprintf( Name, "BloomUp%u", static_cast< BIT_UINT32 >( i ) );
+		const BIT_UINT32 Target = p_Graph.CreateTexture( Name,
+			RenderGraph::TextureDescription( m_Levels[ i ].Size, RenderGraph::Format_RGB8, BIT_TRUE ) );
+
+		NewPass.Type = Pass_Upsample;
+		NewPass.Level = static_cast< BIT_UINT32 >( i );
+		m_GraphPasses.push_back( NewPass );
+
+		const BIT_UINT32 Pass = p_Graph.AddPass( Name, ExecuteGraphPass, &m_GraphPasses.back( ) );
+		p_Graph.Read( Pass, NewPass.Source );
+		p_Graph.Write( Pass, Target );
+
+		NewPass.Source = Target;
+		NewPass.SourceSize = m_Levels[ i ].Size;
+	}
+
+	// Without the composite pass nothing reads the chain and the graph culls it
+	if( p_Composite )
+	{
+		NewPass.Type = Pass_Composite;
+		NewPass.Level = 0;
+		m_GraphPasses.push_back( NewPass );
+
+		const BIT_UINT32 Pass = p_Graph.AddPass( "BloomComposite", ExecuteGraphPass, &m_GraphPasses.back( ), BIT_TRUE );
+		p_Graph.Read( Pass, p_ColorTexture );
+		if( m_Enabled )
+		{
+			p_Graph.Read( Pass, NewPass.Source );
+		}
+	}
+}
+
+// Set functions
+void PostProcessingDualBloom::SetThreshold( const BIT_FLOAT32 p_Threshold )
+{
+	m_Threshold = p_Threshold;
+}
+
+void PostProcessingDualBloom::SetIntensity( const BIT_FLOAT32 p_Intensity )
+{
+	m_Intensity = p_Intensity;
+}
+
+void PostProcessingDualBloom::SetEnabled( const BIT_BOOL p_Status )
+{
+	// Render graph users have to add the passes again
+	m_Enabled = p_Status;
+}
+
+void PostProcessingDualBloom::SetSourceSize( const Bit::Vector2_ui32 p_Size )
+{
+	// Render graph users have to add the passes again
+	m_SourceSize = p_Size;
+}
+
+void PostProcessingDualBloom::SetSourceScale( const Bit::Vector2_f32 p_Scale )
+{
+	m_SourceScale = p_Scale;
+}
+
+// Get functions
+BIT_UINT32 PostProcessingDualBloom::GetLevelCount( ) const
+{
+	return m_LevelCount;
+}
+
+BIT_FLOAT32 PostProcessingDualBloom::GetThreshold( ) const
+{
+	return m_Threshold;
+}
+
+BIT_FLOAT32 PostProcessingDualBloom::GetIntensity( ) const
+{
+	return m_Intensity;
+}
+
+BIT_BOOL PostProcessingDualBloom::GetEnabled( ) const
+{
+	return m_Enabled;
+}
+
+Bit::Vector2_f32 PostProcessingDualBloom::GetSourceScale( ) const
+{
+	return m_SourceScale;
+}
+
+BIT_UINT32 PostProcessingDualBloom::GetTextureMemory( ) const
+{
+	// RGB, 8 bits per channel
+	BIT_UINT32 Memory = 0;
+	for( BIT_MEMSIZE i = 0; i < m_Levels.size( ); i++ )
+	{
+		const BIT_UINT32 LevelMemory = m_Levels[ i ].Size.x * m_Levels[ i ].Size.y * 3;
+		Memory += LevelMemory;
+
+		if( i + 1 < m_Levels.size( ) )
+		{
+			Memory += LevelMemory;
+		}
+	}
+
+	return Memory;
+}
+
+// Private functions
+BIT_UINT32 PostProcessingDualBloom::LoadLevels( )
+{
+	Bit::Vector2_ui32 Size = m_Size;
+
+	for( BIT_UINT32 i = 0; i < m_LevelCount; i++ )
+	{
+		// Every level is half the size of the previous one
+		Size.x = Size.x > 1 ? Size.x / 2 : 1;
+		Size.y = Size.y > 1 ? Size.y / 2 : 1;
+
+		Level NewLevel;
+		NewLevel.Size = Size;
+		NewLevel.pDownTexture = BIT_NULL;
+		NewLevel.pDownFramebuffer = BIT_NULL;
+		NewLevel.pUpTexture = BIT_NULL;
+		NewLevel.pUpFramebuffer = BIT_NULL;
+		m_Levels.push_back( NewLevel );
+
+		if( !m_CreateTargets )
+		{
+			continue;
+		}
+
+		Level & CurrentLevel = m_Levels.back( );
+		if( LoadTarget( Size, &CurrentLevel.pDownTexture, &CurrentLevel.pDownFramebuffer ) != BIT_OK )
+		{
+			return BIT_ERROR;
+		}
+
+		// The smallest level is never upsampled into
+		if( i + 1 < m_LevelCount &&
+			LoadTarget( Size, &CurrentLevel.pUpTexture, &CurrentLevel.pUpFramebuffer ) != BIT_OK )
+		{
+			return BIT_ERROR;
+		}
+	}
+
+	return BIT_OK;
+}
+
+BIT_UINT32 PostProcessingDualBloom::LoadShaders( )
+{
+	// Create the shared vertex shader
+	if( ( m_pVertexShader = m_pGraphicDevice->CreateShader( Bit::Shader::Vertex ) ) == BIT_NULL )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadShaders] Can not create the vertex shader\n" );
+		return BIT_ERROR;
+	}
+
+	m_pVertexShader->SetSource( VertexSource );
+	if( m_pVertexShader->Compile( ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadShaders] Can not compile the vertex shader\n" );
+		return BIT_ERROR;
+	}
+
+	// Create the programs
+	if( LoadProgram( DownsampleSource, &m_pDownsampleProgram, &m_pDownsampleShader ) != BIT_OK ||
+		LoadProgram( UpsampleSource, &m_pUpsampleProgram, &m_pUpsampleShader ) != BIT_OK )
+	{
+		return BIT_ERROR;
+	}
+
+	// The composite has a variant with and without the bloom, compile the enabled one right away
+	m_pCompositePermutations = new ShaderPermutations( m_pGraphicDevice, "BloomComposite" );
+	m_pCompositePermutations->SetSources( VertexSource, CompositeSource );
+	m_pCompositePermutations->SetSetupFunction( SetupCompositeProgram, this );
+	m_BloomFeature = m_pCompositePermutations->AddFeature( "BLOOM" );
+	m_pCompositePermutations->AddAttribute( "Position", 0 );
+	m_pCompositePermutations->AddAttribute( "Texture", 1 );
+
+	if( m_pCompositePermutations->Get( m_BloomFeature ) == BIT_NULL )
+	{
+		return BIT_ERROR;
+	}
+
+	// Set uniforms
+	Bit::Matrix4x4 OrthographicMatrix;
+	OrthographicMatrix.Orthographic( 0.0f, static_cast< BIT_FLOAT32 >( m_Size.x ),
+		0.0f, static_cast< BIT_FLOAT32 >( m_Size.y ), -1.0f, 1.0f );
+
+	m_pDownsampleProgram->Bind( );
+	m_pDownsampleProgram->SetUniformMatrix4x4f( "ProjectionMatrix", OrthographicMatrix );
+	m_pDownsampleProgram->SetUniform1i( "SourceTexture", 0 );
+	m_pDownsampleProgram->Unbind( );
+
+	m_pUpsampleProgram->Bind( );
+	m_pUpsampleProgram->SetUniformMatrix4x4f( "ProjectionMatrix", OrthographicMatrix );
+	m_pUpsampleProgram->SetUniform1i( "SourceTexture", 0 );
+	m_pUpsampleProgram->Unbind( );
+
+	return BIT_OK;
+}
+
+BIT_UINT32 PostProcessingDualBloom::LoadProgram( const std::string & p_FragmentSource, Bit::ShaderProgram ** p_ppShaderProgram,
+	Bit::Shader ** p_ppFragmentShader )
+{
+	// Create and compile the fragment shader
+	if( ( *p_ppFragmentShader = m_pGraphicDevice->CreateShader( Bit::Shader::Fragment ) ) == BIT_NULL )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadProgram] Can not create the fragment shader\n" );
+		return BIT_ERROR;
+	}
+
+	( *p_ppFragmentShader )->SetSource( p_FragmentSource );
+	if( ( *p_ppFragmentShader )->Compile( ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadProgram] Can not compile the fragment shader\n" );
+		return BIT_ERROR;
+	}
+
+	// Create the shader program
+	if( ( *p_ppShaderProgram = m_pGraphicDevice->CreateShaderProgram( ) ) == BIT_NULL )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadProgram] Can not create the shader program\n" );
+		return BIT_ERROR;
+	}
+
+	// Attach the shaders
+	if( ( *p_ppShaderProgram )->AttachShaders( m_pVertexShader ) != BIT_OK ||
+		( *p_ppShaderProgram )->AttachShaders( *p_ppFragmentShader ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadProgram] Can not attach the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	// Set attribute locations
+	( *p_ppShaderProgram )->SetAttributeLocation( "Position", 0 );
+	( *p_ppShaderProgram )->SetAttributeLocation( "Texture", 1 );
+
+	// Link the shaders
+	if( ( *p_ppShaderProgram )->Link( ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadProgram] Can not link the shader program\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+BIT_UINT32 PostProcessingDualBloom::LoadTarget( const Bit::Vector2_ui32 p_Size, Bit::Texture ** p_ppTexture,
+	Bit::Framebuffer ** p_ppFramebuffer )
+{
+	// Create the texture
+	if( ( *p_ppTexture = m_pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadTarget] Can not create the texture\n" );
+		return BIT_ERROR;
+	}
+
+	if( ( *p_ppTexture )->Load( p_Size, Bit::RGB, Bit::RGB, Bit::Type_UChar8, BIT_NULL ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadTarget] Can not load the texture\n" );
+		return BIT_ERROR;
+	}
+
+	// The taps rely on bilinear filtering
+	Bit::Texture::eFilter TextureFilters[ ] =
+	{
+		Bit::Texture::Filter_Min, Bit::Texture::Filter_Linear,
+		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Linear,
+		Bit::Texture::Filter_Wrap_X, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_Wrap_Y, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_None, Bit::Texture::Filter_None
+	};
+
+	if( ( *p_ppTexture )->SetFilters( TextureFilters ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadTarget] Can not set the texture filters\n" );
+		return BIT_ERROR;
+	}
+
+	// Create the framebuffer
+	if( ( *p_ppFramebuffer = m_pGraphicDevice->CreateFramebuffer( ) ) == BIT_NULL )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadTarget] Can not create the framebuffer\n" );
+		return BIT_ERROR;
+	}
+
+	if( ( *p_ppFramebuffer )->Attach( *p_ppTexture ) != BIT_OK )
+	{
+		bitTrace( "[PostProcessingDualBloom::LoadTarget] Can not attach the texture to the framebuffer\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+void PostProcessingDualBloom::RenderPass( Bit::ShaderProgram * p_pShaderProgram, Bit::Texture * p_pSource,
+	const Bit::Vector2_ui32 p_SourceSize, const Bit::Vector2_ui32 p_TargetSize )
+{
+	m_pGraphicDevice->SetViewport( 0, 0, p_TargetSize.x, p_TargetSize.y );
+
+	p_pShaderProgram->Bind( );
+	p_pShaderProgram->SetUniform2f( "TexelSize", 1.0f / static_cast< BIT_FLOAT32 >( p_SourceSize.x ),
+		1.0f / static_cast< BIT_FLOAT32 >( p_SourceSize.y ) );
+	p_pSource->Bind( 0 );
+	m_pVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
+	p_pShaderProgram->Unbind( );
+}
+
+void PostProcessingDualBloom::RenderComposite( Bit::Texture * p_pColor, Bit::Texture * p_pBloom )
+{
+	m_pGraphicDevice->SetViewport( 0, 0, m_Size.x, m_Size.y );
+
+	// The bloom texture is NULL for the copy variant
+	ShaderPermutations::Permutation * pPermutation = m_pCompositePermutations->Get( p_pBloom ? m_BloomFeature : 0 );
+	if( pPermutation == BIT_NULL )
+	{
+		return;
+	}
+
+	pPermutation->pShaderProgram->Bind( );
+	pPermutation->pUniforms->SetUniform2f( ColorScaleHandle, m_SourceScale.x, m_SourceScale.y );
+	p_pColor->Bind( 0 );
+	if( p_pBloom )
+	{
+		pPermutation->pShaderProgram->SetUniform1f( "Intensity", m_Intensity );
+		p_pBloom->Bind( 1 );
+	}
+	m_pVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
+	pPermutation->pShaderProgram->Unbind( );
+}
+
+// Static functions
+void PostProcessingDualBloom::ExecuteGraphPass( RenderGraph & p_Graph, void * p_pUserData )
+{
+	const GraphPass * pPass = reinterpret_cast< const GraphPass * >( p_pUserData );
+	PostProcessingDualBloom * pBloom = pPass->pBloom;
+	const Level & CurrentLevel = pBloom->m_Levels[ pPass->Level ];
+
+	switch( pPass->Type )
+	{
+		case Pass_Downsample:
+		{
+			pBloom->m_pDownsampleProgram->Bind( );
+			pBloom->m_pDownsampleProgram->SetUniform1f( "Threshold", pPass->Level == 0 ? pBloom->m_Threshold : 0.0f );
+			pBloom->m_pDownsampleProgram->SetUniform2f( "SourceScale", pPass->Level == 0 ? pBloom->m_SourceScale.x : 1.0f,
+				pPass->Level == 0 ? pBloom->m_SourceScale.y : 1.0f );
+			pBloom->RenderPass( pBloom->m_pDownsampleProgram, p_Graph.GetTexture( pPass->Source ),
+				pPass->SourceSize, CurrentLevel.Size );
+		}
+		break;
+		case Pass_Upsample:
+		{
+			pBloom->RenderPass( pBloom->m_pUpsampleProgram, p_Graph.GetTexture( pPass->Source ),
+				pPass->SourceSize, CurrentLevel.Size );
+		}
+		break;
+		case Pass_Composite:
+		{
+			pBloom->RenderComposite( p_Graph.GetTexture( pPass->Color ),
+				pBloom->m_Enabled ? p_Graph.GetTexture( pPass->Source ) : BIT_NULL );
+		}
+		break;
+	}
+}
+
+void PostProcessingDualBloom::SetupCompositeProgram( ShaderPermutations::Permutation & p_Permutation, void * p_pUserData )
+{
+	const PostProcessingDualBloom * pBloom = reinterpret_cast< const PostProcessingDualBloom * >( p_pUserData );
+
+	Bit::Matrix4x4 OrthographicMatrix;
+	OrthographicMatrix.Orthographic( 0.0f, static_cast< BIT_FLOAT32 >( pBloom->m_Size.x ),
+		0.0f, static_cast< BIT_FLOAT32 >( pBloom->m_Size.y ), -1.0f, 1.0f );
+
+	p_Permutation.pShaderProgram->SetUniformMatrix4x4f( "ProjectionMatrix", OrthographicMatrix );
+	p_Permutation.pShaderProgram->SetUniform1i( "ColorTexture", 0 );
+	p_Permutation.pShaderProgram->SetUniform1i( "BloomTexture", 1 );
+}
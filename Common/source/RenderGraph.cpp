@@ -0,0 +1,686 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <RenderGraph.hpp>
+#include <OpenGL.hpp>
+#include <Bit/System/Timer.hpp>
+#include <algorithm>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Texture description
+RenderGraph::TextureDescription::TextureDescription( ) :
+	Size( 0, 0 ),
+	Format( Format_RGB8 ),
+	Linear( BIT_FALSE )
+{
+}
+
+RenderGraph::TextureDescription::TextureDescription( const Bit::Vector2_ui32 p_Size, const eFormat p_Format, const BIT_BOOL p_Linear ) :
+	Size( p_Size ),
+	Format( p_Format ),
+	Linear( p_Linear )
+{
+}
+
+BIT_BOOL RenderGraph::TextureDescription::operator == ( const TextureDescription & p_Description ) const
+{
+	return	Size.x == p_Description.Size.x && Size.y == p_Description.Size.y &&
+			Format == p_Description.Format && Linear == p_Description.Linear;
+}
+
+BIT_UINT32 RenderGraph::TextureDescription::GetMemory( ) const
+{
+	static const BIT_UINT32 PixelSizes[ 4 ] = { 3, 4, 16, 4 };
+	return Size.x * Size.y * PixelSizes[ Format ];
+}
+
+// Constructor/destructor
+RenderGraph::RenderGraph( Bit::GraphicDevice * p_pGraphicDevice, const Bit::Vector2_ui32 p_BackbufferSize ) :
+	m_pGraphicDevice( p_pGraphicDevice ),
+	m_BackbufferSize( p_BackbufferSize ),
+	m_Compiled( BIT_FALSE ),
+	m_TimingEnabled( BIT_FALSE ),
+	m_TimedFrames( 0 ),
+	m_FrameTime( 0.0 )
+{
+}
+
+RenderGraph::~RenderGraph( )
+{
+	Reset( );
+}
+
+// Setup functions
+BIT_UINT32 RenderGraph::CreateTexture( const std::string & p_Name, const TextureDescription & p_Description )
+{
+	Resource NewResource;
+	NewResource.Name = p_Name;
+	NewResource.Description = p_Description;
+	NewResource.pTexture = BIT_NULL;
+	NewResource.Imported = BIT_FALSE;
+	NewResource.FirstPass = -1;
+	NewResource.LastPass = -1;
+	m_Resources.push_back( NewResource );
+
+	m_Compiled = BIT_FALSE;
+	return static_cast< BIT_UINT32 >( m_Resources.size( ) - 1 );
+}
+
+BIT_UINT32 RenderGraph::ImportTexture( const std::string & p_Name, Bit::Texture * p_pTexture, const TextureDescription & p_Description )
+{
+	if( p_pTexture == BIT_NULL )
+	{
+		bitTrace( "[RenderGraph::ImportTexture] NULL param\n" );
+		return InvalidHandle;
+	}
+
+	const BIT_UINT32 Handle = CreateTexture( p_Name, p_Description );
+	m_Resources[ Handle ].pTexture = p_pTexture;
+	m_Resources[ Handle ].Imported = BIT_TRUE;
+	return Handle;
+}
+
+BIT_UINT32 RenderGraph::AddPass( const std::string & p_Name, ExecuteFunction p_Function, void * p_pUserData,
+	const BIT_BOOL p_SideEffect )
+{
+	Pass NewPass;
+	NewPass.Name = p_Name;
+	NewPass.Function = p_Function;
+	NewPass.pUserData = p_pUserData;
+	NewPass.SideEffect = p_SideEffect;
+	NewPass.Culled = BIT_FALSE;
+	NewPass.pFramebuffer = BIT_NULL;
+	NewPass.Time = 0.0;
+	NewPass.CpuTime = 0.0;
+	m_Passes.push_back( NewPass );
+
+	m_Compiled = BIT_FALSE;
+	return static_cast< BIT_UINT32 >( m_Passes.size( ) - 1 );
+}
+
+void RenderGraph::Read( const BIT_UINT32 p_Pass, const BIT_UINT32 p_Texture )
+{
+	if( p_Pass >= m_Passes.size( ) || p_Texture >= m_Resources.size( ) )
+	{
+		bitTrace( "[RenderGraph::Read] Invalid pass or texture\n" );
+		return;
+	}
+
+	m_Passes[ p_Pass ].Reads.push_back( p_Texture );
+	m_Compiled = BIT_FALSE;
+}
+
+void RenderGraph::Write( const BIT_UINT32 p_Pass, const BIT_UINT32 p_Texture )
+{
+	if( p_Pass >= m_Passes.size( ) || p_Texture >= m_Resources.size( ) )
+	{
+		bitTrace( "[RenderGraph::Write] Invalid pass or texture\n" );
+		return;
+	}
+
+	m_Passes[ p_Pass ].Writes.push_back( p_Texture );
+	m_Compiled = BIT_FALSE;
+}
+
+// Public functions
+BIT_UINT32 RenderGraph::Compile( )
+{
+	if( m_Compiled )
+	{
+		return BIT_OK;
+	}
+
+	if( m_pGraphicDevice == BIT_NULL )
+	{
+		bitTrace( "[RenderGraph::Compile] Graphic device is NULL\n" );
+		return BIT_ERROR;
+	}
+
+	CullPasses( );
+	CalculateLifetimes( );
+	CalculateBarriers( );
+
+	if( AllocateTextures( ) != BIT_OK )
+	{
+		bitTrace( "[RenderGraph::Compile] Can not allocate the textures\n" );
+		return BIT_ERROR;
+	}
+
+	if( CreateFramebuffers( ) != BIT_OK )
+	{
+		bitTrace( "[RenderGraph::Compile] Can not create the framebuffers\n" );
+		return BIT_ERROR;
+	}
+
+	m_Compiled = BIT_TRUE;
+	return BIT_OK;
+}
+
+void RenderGraph::Execute( )
+{
+	if( !m_Compiled )
+	{
+		bitTrace( "[RenderGraph::Execute] Is not compiled yet\n" );
+		return;
+	}
+
+	// Timing waits for the GPU around every pass, only use it while profiling.
+	// The CPU time of the passes is always measured, it doesn't wait for anything.
+	Bit::Timer Timer;
+	Bit::Timer CpuTimer;
+	if( m_TimingEnabled )
+	{
+		glFinish( );
+		m_TimedFrames++;
+		m_FrameTime = 0.0;
+	}
+
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		Pass & CurrentPass = m_Passes[ i ];
+		if( CurrentPass.Culled )
+		{
+			CurrentPass.CpuTime = 0.0;
+			continue;
+		}
+
+		// OpenGL resolves the render target to texture hazards itself,
+		// binding the next framebuffer is enough to order the barriers.
+		if( CurrentPass.pFramebuffer )
+		{
+			const Bit::Vector2_ui32 Size = m_Resources[ CurrentPass.Writes[ 0 ] ].Description.Size;
+			CurrentPass.pFramebuffer->Bind( );
+			m_pGraphicDevice->SetViewport( 0, 0, Size.x, Size.y );
+		}
+		else
+		{
+			m_pGraphicDevice->BindDefaultFramebuffer( );
+			m_pGraphicDevice->SetViewport( 0, 0, m_BackbufferSize.x, m_BackbufferSize.y );
+		}
+
+		if( m_TimingEnabled )
+		{
+			Timer.Start( );
+			CpuTimer.Start( );
+			CurrentPass.Function( *this, CurrentPass.pUserData );
+			CpuTimer.Stop( );
+			glFinish( );
+			Timer.Stop( );
+			CurrentPass.Time += Timer.GetTime( );
+			m_FrameTime += Timer.GetTime( );
+		}
+		else
+		{
+			CpuTimer.Start( );
+			CurrentPass.Function( *this, CurrentPass.pUserData );
+			CpuTimer.Stop( );
+		}
+
+		CurrentPass.CpuTime = CpuTimer.GetTime( );
+	}
+
+	m_pGraphicDevice->BindDefaultFramebuffer( );
+}
+
+void RenderGraph::Reset( )
+{
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		if( m_Passes[ i ].pFramebuffer )
+		{
+			delete m_Passes[ i ].pFramebuffer;
+		}
+	}
+
+	for( BIT_MEMSIZE i = 0; i < m_PhysicalTextures.size( ); i++ )
+	{
+		delete m_PhysicalTextures[ i ].pTexture;
+	}
+
+	m_Passes.clear( );
+	m_Resources.clear( );
+	m_PhysicalTextures.clear( );
+	m_Compiled = BIT_FALSE;
+	m_TimedFrames = 0;
+}
+
+void RenderGraph::PrintStatistics( ) const
+{
+	bitTrace( "Render graph: %u passes (%u culled), %u barriers, %u physical textures.\n",
+		GetPassCount( ), GetCulledPassCount( ), GetBarrierCount( ), GetPhysicalTextureCount( ) );
+	bitTrace( "Render graph: peak render target memory %.2f MB (%.2f MB without aliasing).\n",
+		static_cast< BIT_FLOAT64 >( GetPeakMemory( ) ) / 1048576.0,
+		static_cast< BIT_FLOAT64 >( GetUnaliasedMemory( ) ) / 1048576.0 );
+
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		const Pass & CurrentPass = m_Passes[ i ];
+		bitTrace( "  %-20s %s\n", CurrentPass.Name.c_str( ), CurrentPass.Culled ? "culled" : "" );
+
+		for( BIT_MEMSIZE j = 0; j < CurrentPass.Barriers.size( ); j++ )
+		{
+			bitTrace( "    barrier: %s render target -> shader read\n",
+				m_Resources[ CurrentPass.Barriers[ j ] ].Name.c_str( ) );
+		}
+	}
+}
+
+void RenderGraph::ResetTimings( )
+{
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		m_Passes[ i ].Time = 0.0;
+	}
+
+	m_TimedFrames = 0;
+	m_FrameTime = 0.0;
+}
+
+void RenderGraph::PrintTimings( ) const
+{
+	if( m_TimedFrames == 0 )
+	{
+		return;
+	}
+
+	BIT_FLOAT64 Total = 0.0;
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		if( m_Passes[ i ].Culled )
+		{
+			continue;
+		}
+
+		const BIT_FLOAT64 Time = GetPassTime( static_cast< BIT_UINT32 >( i ) );
+		bitTrace( "  %-20s %.3f ms\n", m_Passes[ i ].Name.c_str( ), Time );
+		Total += Time;
+	}
+
+	bitTrace( "  %-20s %.3f ms (%u frames)\n", "Total", Total, m_TimedFrames );
+}
+
+// Set functions
+void RenderGraph::SetTimingEnabled( const BIT_BOOL p_Status )
+{
+	m_TimingEnabled = p_Status;
+	ResetTimings( );
+}
+
+// Get functions
+Bit::Texture * RenderGraph::GetTexture( const BIT_UINT32 p_Texture ) const
+{
+	if( p_Texture >= m_Resources.size( ) )
+	{
+		return BIT_NULL;
+	}
+
+	return m_Resources[ p_Texture ].pTexture;
+}
+
+BIT_BOOL RenderGraph::IsCompiled( ) const
+{
+	return m_Compiled;
+}
+
+BIT_UINT32 RenderGraph::GetPassCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Passes.size( ) );
+}
+
+BIT_UINT32 RenderGraph::GetCulledPassCount( ) const
+{
+	BIT_UINT32 Count = 0;
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		if( m_Passes[ i ].Culled )
+		{
+			Count++;
+		}
+	}
+
+	return Count;
+}
+
+BIT_UINT32 RenderGraph::GetBarrierCount( ) const
+{
+	BIT_UINT32 Count = 0;
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		Count += static_cast< BIT_UINT32 >( m_Passes[ i ].Barriers.size( ) );
+	}
+
+	return Count;
+}
+
+BIT_UINT32 RenderGraph::GetPhysicalTextureCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_PhysicalTextures.size( ) );
+}
+
+BIT_UINT32 RenderGraph::GetPeakMemory( ) const
+{
+	// Every physical texture stays alive for the whole frame
+	BIT_UINT32 Memory = 0;
+	for( BIT_MEMSIZE i = 0; i < m_PhysicalTextures.size( ); i++ )
+	{
+		Memory += m_PhysicalTextures[ i ].Description.GetMemory( );
+	}
+
+	for( BIT_MEMSIZE i = 0; i < m_Resources.size( ); i++ )
+	{
+		if( m_Resources[ i ].Imported && m_Resources[ i ].FirstPass >= 0 )
+		{
+			Memory += m_Resources[ i ].Description.GetMemory( );
+		}
+	}
+
+	return Memory;
+}
+
+BIT_UINT32 RenderGraph::GetUnaliasedMemory( ) const
+{
+	BIT_UINT32 Memory = 0;
+	for( BIT_MEMSIZE i = 0; i < m_Resources.size( ); i++ )
+	{
+		if( m_Resources[ i ].FirstPass >= 0 )
+		{
+			Memory += m_Resources[ i ].Description.GetMemory( );
+		}
+	}
+
+	return Memory;
+}
+
+BIT_BOOL RenderGraph::GetTimingEnabled( ) const
+{
+	return m_TimingEnabled;
+}
+
+BIT_FLOAT64 RenderGraph::GetPassTime( const BIT_UINT32 p_Pass ) const
+{
+	// Average time in milliseconds
+	if( p_Pass >= m_Passes.size( ) || m_TimedFrames == 0 )
+	{
+		return 0.0;
+	}
+
+	return m_Passes[ p_Pass ].Time * 1000.0 / static_cast< BIT_FLOAT64 >( m_TimedFrames );
+}
+
+BIT_FLOAT64 RenderGraph::GetPassCpuTime( const BIT_UINT32 p_Pass ) const
+{
+	// Last frame in milliseconds
+	if( p_Pass >= m_Passes.size( ) )
+	{
+		return 0.0;
+	}
+
+	return m_Passes[ p_Pass ].CpuTime * 1000.0;
+}
+
+const std::string & RenderGraph::GetPassName( const BIT_UINT32 p_Pass ) const
+{
+	return m_Passes[ p_Pass ].Name;
+}
+
+BIT_BOOL RenderGraph::IsPassCulled( const BIT_UINT32 p_Pass ) const
+{
+	if( p_Pass >= m_Passes.size( ) )
+	{
+		return BIT_TRUE;
+	}
+
+	return m_Passes[ p_Pass ].Culled;
+}
+
+BIT_FLOAT64 RenderGraph::GetFrameTime( ) const
+{
+	// Time of all passes of the last timed frame in milliseconds
+	return m_FrameTime * 1000.0;
+}
+
+// Private functions
+void RenderGraph::CullPasses( )
+{
+	// Walk the passes backwards, a pass is needed if it has side effects
+	// or if it writes a texture that a needed pass reads.
+	std::vector< BIT_BOOL > Needed( m_Resources.size( ), BIT_FALSE );
+
+	for( BIT_SINT32 i = static_cast< BIT_SINT32 >( m_Passes.size( ) ) - 1; i >= 0; i-- )
+	{
+		Pass & CurrentPass = m_Passes[ i ];
+		CurrentPass.Culled = !CurrentPass.SideEffect;
+
+		for( BIT_MEMSIZE j = 0; j < CurrentPass.Writes.size( ) && CurrentPass.Culled; j++ )
+		{
+			if( Needed[ CurrentPass.Writes[ j ] ] )
+			{
+				CurrentPass.Culled = BIT_FALSE;
+			}
+		}
+
+		if( CurrentPass.Culled )
+		{
+			continue;
+		}
+
+		for( BIT_MEMSIZE j = 0; j < CurrentPass.Reads.size( ); j++ )
+		{
+			Needed[ CurrentPass.Reads[ j ] ] = BIT_TRUE;
+		}
+	}
+}
+
+void RenderGraph::CalculateLifetimes( )
+{
+	for( BIT_MEMSIZE i = 0; i < m_Resources.size( ); i++ )
+	{
+		m_Resources[ i ].FirstPass = -1;
+		m_Resources[ i ].LastPass = -1;
+	}
+
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		const Pass & CurrentPass = m_Passes[ i ];
+		if( CurrentPass.Culled )
+		{
+			continue;
+		}
+
+		for( BIT_MEMSIZE j = 0; j < CurrentPass.Reads.size( ) + CurrentPass.Writes.size( ); j++ )
+		{
+			const BIT_UINT32 Index = j < CurrentPass.Reads.size( ) ?
+				CurrentPass.Reads[ j ] : CurrentPass.Writes[ j - CurrentPass.Reads.size( ) ];
+			Resource & CurrentResource = m_Resources[ Index ];
+
+			if( CurrentResource.FirstPass < 0 )
+			{
+				CurrentResource.FirstPass = static_cast< BIT_SINT32 >( i );
+			}
+			CurrentResource.LastPass = static_cast< BIT_SINT32 >( i );
+		}
+	}
+}
+
+void RenderGraph::CalculateBarriers( )
+{
+	// A texture needs a barrier the first time it's read after being rendered to.
+	std::vector< BIT_BOOL > Written( m_Resources.size( ), BIT_FALSE );
+
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		Pass & CurrentPass = m_Passes[ i ];
+		CurrentPass.Barriers.clear( );
+
+		if( CurrentPass.Culled )
+		{
+			continue;
+		}
+
+		for( BIT_MEMSIZE j = 0; j < CurrentPass.Reads.size( ); j++ )
+		{
+			if( Written[ CurrentPass.Reads[ j ] ] )
+			{
+				CurrentPass.Barriers.push_back( CurrentPass.Reads[ j ] );
+				Written[ CurrentPass.Reads[ j ] ] = BIT_FALSE;
+			}
+		}
+
+		for( BIT_MEMSIZE j = 0; j < CurrentPass.Writes.size( ); j++ )
+		{
+			Written[ CurrentPass.Writes[ j ] ] = BIT_TRUE;
+		}
+	}
+}
+
+BIT_UINT32 RenderGraph::AllocateTextures( )
+{
+	// Sort the used transient textures by their first use
+	std::vector< std::pair< BIT_SINT32, BIT_UINT32 > > Order;
+	for( BIT_MEMSIZE i = 0; i < m_Resources.size( ); i++ )
+	{
+		if( !m_Resources[ i ].Imported && m_Resources[ i ].FirstPass >= 0 )
+		{
+			Order.push_back( std::pair< BIT_SINT32, BIT_UINT32 >( m_Resources[ i ].FirstPass, static_cast< BIT_UINT32 >( i ) ) );
+		}
+	}
+	std::sort( Order.begin( ), Order.end( ) );
+
+	// Reuse a physical texture if its previous owner is dead by now
+	for( BIT_MEMSIZE i = 0; i < Order.size( ); i++ )
+	{
+		Resource & CurrentResource = m_Resources[ Order[ i ].second ];
+		CurrentResource.pTexture = BIT_NULL;
+
+		for( BIT_MEMSIZE j = 0; j < m_PhysicalTextures.size( ); j++ )
+		{
+			PhysicalTexture & Physical = m_PhysicalTextures[ j ];
+
+			if( Physical.LastPass < CurrentResource.FirstPass && Physical.Description == CurrentResource.Description )
+			{
+				CurrentResource.pTexture = Physical.pTexture;
+				Physical.LastPass = CurrentResource.LastPass;
+				break;
+			}
+		}
+
+		if( CurrentResource.pTexture )
+		{
+			continue;
+		}
+
+		// Allocate a new texture
+		PhysicalTexture NewPhysical;
+		NewPhysical.Description = CurrentResource.Description;
+		NewPhysical.LastPass = CurrentResource.LastPass;
+		if( ( NewPhysical.pTexture = CreatePhysicalTexture( CurrentResource.Description ) ) == BIT_NULL )
+		{
+			bitTrace( "[RenderGraph::AllocateTextures] Can not create the texture %s\n", CurrentResource.Name.c_str( ) );
+			return BIT_ERROR;
+		}
+
+		m_PhysicalTextures.push_back( NewPhysical );
+		CurrentResource.pTexture = NewPhysical.pTexture;
+	}
+
+	return BIT_OK;
+}
+
+BIT_UINT32 RenderGraph::CreateFramebuffers( )
+{
+	for( BIT_MEMSIZE i = 0; i < m_Passes.size( ); i++ )
+	{
+		Pass & CurrentPass = m_Passes[ i ];
+		if( CurrentPass.Culled || CurrentPass.Writes.size( ) == 0 )
+		{
+			continue;
+		}
+
+		if( ( CurrentPass.pFramebuffer = m_pGraphicDevice->CreateFramebuffer( ) ) == BIT_NULL )
+		{
+			bitTrace( "[RenderGraph::CreateFramebuffers] Can not create the framebuffer of %s\n", CurrentPass.Name.c_str( ) );
+			return BIT_ERROR;
+		}
+
+		for( BIT_MEMSIZE j = 0; j < CurrentPass.Writes.size( ); j++ )
+		{
+			if( CurrentPass.pFramebuffer->Attach( m_Resources[ CurrentPass.Writes[ j ] ].pTexture ) != BIT_OK )
+			{
+				bitTrace( "[RenderGraph::CreateFramebuffers] Can not attach %s to %s\n",
+					m_Resources[ CurrentPass.Writes[ j ] ].Name.c_str( ), CurrentPass.Name.c_str( ) );
+				return BIT_ERROR;
+			}
+		}
+	}
+
+	return BIT_OK;
+}
+
+Bit::Texture * RenderGraph::CreatePhysicalTexture( const TextureDescription & p_Description )
+{
+	Bit::Texture * pTexture = BIT_NULL;
+	if( ( pTexture = m_pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
+	{
+		return BIT_NULL;
+	}
+
+	// Pick the format
+	BIT_UINT32 Status = BIT_ERROR;
+	switch( p_Description.Format )
+	{
+		case Format_RGB8:
+			Status = pTexture->Load( p_Description.Size, Bit::RGB, Bit::RGB, Bit::Type_UChar8, BIT_NULL );
+			break;
+		case Format_RGBA8:
+			Status = pTexture->Load( p_Description.Size, Bit::RGBA, Bit::RGBA, Bit::Type_UChar8, BIT_NULL );
+			break;
+		case Format_RGBA32F:
+			Status = pTexture->Load( p_Description.Size, Bit::RGBA, Bit::RGBA, Bit::Type_Float32, BIT_NULL );
+			break;
+		case Format_Depth32F:
+			Status = pTexture->Load( p_Description.Size, Bit::Depth, Bit::Depth, Bit::Type_Float32, BIT_NULL );
+			break;
+	}
+
+	// Set the filters
+	const Bit::Texture::eFilter Filter = p_Description.Linear ? Bit::Texture::Filter_Linear : Bit::Texture::Filter_Nearest;
+	Bit::Texture::eFilter TextureFilters[ ] =
+	{
+		Bit::Texture::Filter_Min, Filter,
+		Bit::Texture::Filter_Mag, Filter,
+		Bit::Texture::Filter_Wrap_X, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_Wrap_Y, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_None, Bit::Texture::Filter_None
+	};
+
+	if( Status != BIT_OK || pTexture->SetFilters( TextureFilters ) != BIT_OK )
+	{
+		delete pTexture;
+		return BIT_NULL;
+	}
+
+	return pTexture;
+}
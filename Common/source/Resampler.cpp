@@ -0,0 +1,592 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <Resampler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef CPU_FEATURES_SSE2
+	#include <emmintrin.h>
+#endif
+#ifdef CPU_FEATURES_AVX2
+	#include <immintrin.h>
+#endif
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Filters a run of output frames of one channel. Every tap count is a multiple of 8.
+typedef void ( * FilterFunction )( const BIT_FLOAT32 * p_pCoefficients, const BIT_UINT32 p_TapCount, const BIT_UINT32 p_PhaseShift,
+	const BIT_FLOAT32 * p_pInput, BIT_UINT64 p_Position, const BIT_UINT64 p_Step,
+	BIT_FLOAT32 * p_pOutput, const BIT_UINT32 p_Stride, const BIT_UINT32 p_Count );
+
+static void FilterScalar( const BIT_FLOAT32 * p_pCoefficients, const BIT_UINT32 p_TapCount, const BIT_UINT32 p_PhaseShift,
+	const BIT_FLOAT32 * p_pInput, BIT_UINT64 p_Position, const BIT_UINT64 p_Step,
+	BIT_FLOAT32 * p_pOutput, const BIT_UINT32 p_Stride, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 * pTaps = p_pCoefficients + ( static_cast< BIT_UINT32 >( p_Position ) >> p_PhaseShift ) * p_TapCount;
+		const BIT_FLOAT32 * pInput = p_pInput + ( p_Position >> 32 );
+
+		BIT_FLOAT32 Sum = 0.0f;
+		for( BIT_UINT32 j = 0; j < p_TapCount; j++ )
+		{
+			Sum += pTaps[ j ] * pInput[ j ];
+		}
+
+		p_pOutput[ i * p_Stride ] = Sum;
+		p_Position += p_Step;
+	}
+}
+
+#ifdef CPU_FEATURES_SSE2
+static void FilterSSE2( const BIT_FLOAT32 * p_pCoefficients, const BIT_UINT32 p_TapCount, const BIT_UINT32 p_PhaseShift,
+	const BIT_FLOAT32 * p_pInput, BIT_UINT64 p_Position, const BIT_UINT64 p_Step,
+	BIT_FLOAT32 * p_pOutput, const BIT_UINT32 p_Stride, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 * pTaps = p_pCoefficients + ( static_cast< BIT_UINT32 >( p_Position ) >> p_PhaseShift ) * p_TapCount;
+		const BIT_FLOAT32 * pInput = p_pInput + ( p_Position >> 32 );
+
+		// Two sums hide the latency of the adds
+		__m128 Sum0 = _mm_setzero_ps( );
+		__m128 Sum1 = _mm_setzero_ps( );
+		for( BIT_UINT32 j = 0; j < p_TapCount; j += 8 )
+		{
+			Sum0 = _mm_add_ps( Sum0, _mm_mul_ps( _mm_loadu_ps( pTaps + j ), _mm_loadu_ps( pInput + j ) ) );
+			Sum1 = _mm_add_ps( Sum1, _mm_mul_ps( _mm_loadu_ps( pTaps + j + 4 ), _mm_loadu_ps( pInput + j + 4 ) ) );
+		}
+
+		__m128 Sum = _mm_add_ps( Sum0, Sum1 );
+		Sum = _mm_add_ps( Sum, _mm_movehl_ps( Sum, Sum ) );
+		Sum = _mm_add_ss( Sum, _mm_shuffle_ps( Sum, Sum, 1 ) );
+
+		p_pOutput[ i * p_Stride ] = _mm_cvtss_f32( Sum );
+		p_Position += p_Step;
+	}
+}
+#endif
+
+#if defined( CPU_FEATURES_AVX2 ) && defined( CPU_FEATURES_SSE2 )
+CPU_FEATURES_AVX2_FUNCTION
+static void FilterAVX2( const BIT_FLOAT32 * p_pCoefficients, const BIT_UINT32 p_TapCount, const BIT_UINT32 p_PhaseShift,
+	const BIT_FLOAT32 * p_pInput, BIT_UINT64 p_Position, const BIT_UINT64 p_Step,
+	BIT_FLOAT32 * p_pOutput, const BIT_UINT32 p_Stride, const BIT_UINT32 p_Count )
+{
+	for( BIT_UINT32 i = 0; i < p_Count; i++ )
+	{
+		const BIT_FLOAT32 * pTaps = p_pCoefficients + ( static_cast< BIT_UINT32 >( p_Position ) >> p_PhaseShift ) * p_TapCount;
+		const BIT_FLOAT32 * pInput = p_pInput + ( p_Position >> 32 );
+
+		__m256 Sum256 = _mm256_setzero_ps( );
+		for( BIT_UINT32 j = 0; j < p_TapCount; j += 8 )
+		{
+			Sum256 = _mm256_add_ps( Sum256, _mm256_mul_ps( _mm256_loadu_ps( pTaps + j ), _mm256_loadu_ps( pInput + j ) ) );
+		}
+
+		__m128 Sum = _mm_add_ps( _mm256_castps256_ps128( Sum256 ), _mm256_extractf128_ps( Sum256, 1 ) );
+		Sum = _mm_add_ps( Sum, _mm_movehl_ps( Sum, Sum ) );
+		Sum = _mm_add_ss( Sum, _mm_shuffle_ps( Sum, Sum, 1 ) );
+
+		p_pOutput[ i * p_Stride ] = _mm_cvtss_f32( Sum );
+		p_Position += p_Step;
+	}
+}
+#endif
+
+static FilterFunction GetFilterFunction( const CpuFeatures::eInstructionSet p_InstructionSet )
+{
+	switch( p_InstructionSet )
+	{
+#if defined( CPU_FEATURES_AVX2 ) && defined( CPU_FEATURES_SSE2 )
+		case CpuFeatures::InstructionSet_AVX2:
+			return FilterAVX2;
+#endif
+#ifdef CPU_FEATURES_SSE2
+		case CpuFeatures::InstructionSet_SSE2:
+			return FilterSSE2;
+#endif
+		default:
+			break;
+	}
+
+	return FilterScalar;
+}
+
+// Log2 of the phase count, the phase is the top bits of the fraction
+static BIT_UINT32 GetPhaseShift( const ResamplerFilter * p_pFilter )
+{
+	BIT_UINT32 Shift = 32;
+	for( BIT_UINT32 Phases = p_pFilter->GetPhaseCount( ); Phases > 1; Phases >>= 1 )
+	{
+		Shift--;
+	}
+	return Shift;
+}
+
+// Resampler filter class
+// Constructor
+ResamplerFilter::ResamplerFilter( ) :
+	m_Quality( Quality_Medium ),
+	m_Cutoff( 0.0f ),
+	m_TapCount( 0 ),
+	m_PhaseCount( 0 )
+{
+}
+
+// Public functions
+BIT_UINT32 ResamplerFilter::Create( const eQuality p_Quality, const BIT_FLOAT32 p_Cutoff )
+{
+	static const BIT_UINT32 TapCounts[ 3 ] = { 8, 16, 32 };
+	static const BIT_UINT32 PhaseCounts[ 3 ] = { 64, 128, 256 };
+
+	// Short filters have a wide transition band, it has to start below the cutoff
+	static const BIT_FLOAT64 Passbands[ 3 ] = { 0.80f, 0.90f, 0.95f };
+
+	if( p_Quality < Quality_Low || p_Quality > Quality_High || p_Cutoff <= 0.0f || p_Cutoff > 1.0f )
+	{
+		bitTrace( "[ResamplerFilter::Create] Invalid quality or cutoff\n" );
+		return BIT_ERROR;
+	}
+
+	m_Quality = p_Quality;
+	m_Cutoff = p_Cutoff;
+	m_TapCount = TapCounts[ p_Quality ];
+	m_PhaseCount = PhaseCounts[ p_Quality ];
+	m_Coefficients.resize( m_TapCount * m_PhaseCount );
+
+	const BIT_FLOAT64 Pi = 3.14159265358979323846;
+	const BIT_FLOAT64 Cutoff = static_cast< BIT_FLOAT64 >( p_Cutoff ) * Passbands[ p_Quality ];
+	const BIT_FLOAT64 HalfLength = static_cast< BIT_FLOAT64 >( m_TapCount / 2 );
+
+	for( BIT_UINT32 Phase = 0; Phase < m_PhaseCount; Phase++ )
+	{
+		// Tap count / 2 - 1 is the input frame at or before the output frame
+		const BIT_FLOAT64 Fraction = static_cast< BIT_FLOAT64 >( Phase ) / static_cast< BIT_FLOAT64 >( m_PhaseCount );
+		BIT_FLOAT32 * pTaps = &m_Coefficients[ Phase * m_TapCount ];
+		BIT_FLOAT64 Sum = 0.0f;
+
+		for( BIT_UINT32 Tap = 0; Tap < m_TapCount; Tap++ )
+		{
+			const BIT_FLOAT64 X = static_cast< BIT_FLOAT64 >( Tap ) - ( HalfLength - 1.0f ) - Fraction;
+			const BIT_FLOAT64 Sinc = X == 0.0f ? 1.0f : sin( Pi * Cutoff * X ) / ( Pi * Cutoff * X );
+			const BIT_FLOAT64 Window = 0.42f + 0.5f * cos( Pi * X / HalfLength ) + 0.08f * cos( 2.0f * Pi * X / HalfLength );
+			const BIT_FLOAT64 Value = Cutoff * Sinc * Window;
+
+			pTaps[ Tap ] = static_cast< BIT_FLOAT32 >( Value );
+			Sum += Value;
+		}
+
+		// Every phase passes a constant signal untouched
+		for( BIT_UINT32 Tap = 0; Tap < m_TapCount; Tap++ )
+		{
+			pTaps[ Tap ] = static_cast< BIT_FLOAT32 >( pTaps[ Tap ] / Sum );
+		}
+	}
+
+	return BIT_OK;
+}
+
+// Get functions
+BIT_BOOL ResamplerFilter::IsCreated( ) const
+{
+	return m_TapCount != 0;
+}
+
+ResamplerFilter::eQuality ResamplerFilter::GetQuality( ) const
+{
+	return m_Quality;
+}
+
+BIT_FLOAT32 ResamplerFilter::GetCutoff( ) const
+{
+	return m_Cutoff;
+}
+
+BIT_UINT32 ResamplerFilter::GetTapCount( ) const
+{
+	return m_TapCount;
+}
+
+BIT_UINT32 ResamplerFilter::GetPhaseCount( ) const
+{
+	return m_PhaseCount;
+}
+
+const BIT_FLOAT32 * ResamplerFilter::GetCoefficients( ) const
+{
+	return m_Coefficients.size( ) ? &m_Coefficients[ 0 ] : BIT_NULL;
+}
+
+// Static functions
+const char * ResamplerFilter::GetQualityName( const eQuality p_Quality )
+{
+	switch( p_Quality )
+	{
+		case Quality_Low:
+			return "low";
+		case Quality_Medium:
+			return "medium";
+		case Quality_High:
+			return "high";
+		default:
+			break;
+	}
+
+	return "unknown";
+}
+
+// Resampler class
+// Constructor
+Resampler::Resampler( ) :
+	m_pFilter( BIT_NULL ),
+	m_ChannelCount( 0 ),
+	m_MaxWriteCount( 0 ),
+	m_Start( 0 ),
+	m_End( 0 ),
+	m_DroppedFrameCount( 0 ),
+	m_Position( 0 ),
+	m_Step( 0 ),
+	m_InstructionSet( CpuFeatures::GetSupportedInstructionSet( ) )
+{
+}
+
+// Public functions
+BIT_UINT32 Resampler::Open( const ResamplerFilter * p_pFilter, const BIT_UINT16 p_ChannelCount, const BIT_FLOAT64 p_Step,
+	const BIT_UINT32 p_MaxWriteCount )
+{
+	if( p_pFilter == BIT_NULL || !p_pFilter->IsCreated( ) )
+	{
+		bitTrace( "[Resampler::Open] The filter is not created\n" );
+		return BIT_ERROR;
+	}
+
+	if( p_ChannelCount == 0 || p_Step <= 0.0f )
+	{
+		bitTrace( "[Resampler::Open] Invalid channel count or step\n" );
+		return BIT_ERROR;
+	}
+
+	m_pFilter = p_pFilter;
+	m_MaxWriteCount = p_MaxWriteCount;
+	m_ChannelCount = p_ChannelCount;
+
+	// Channels past the count keep their buffers for a later Open with more channels
+	if( m_Channels.size( ) < p_ChannelCount )
+	{
+		m_Channels.resize( p_ChannelCount );
+	}
+	for( BIT_UINT32 i = 0; m_MaxWriteCount && i < p_ChannelCount; i++ )
+	{
+		m_Channels[ i ].resize( p_pFilter->GetTapCount( ) + m_MaxWriteCount );
+	}
+	SetStep( p_Step );
+	Reset( );
+
+	return BIT_OK;
+}
+
+void Resampler::Reset( )
+{
+	// Silence before the first frame, so the first output frame lines up with the first input frame
+	const BIT_UINT32 Padding = m_pFilter ? m_pFilter->GetTapCount( ) / 2 - 1 : 0;
+	for( BIT_UINT32 i = 0; i < m_ChannelCount; i++ )
+	{
+		if( m_Channels[ i ].size( ) < Padding )
+		{
+			m_Channels[ i ].resize( Padding );
+		}
+		std::fill( m_Channels[ i ].begin( ), m_Channels[ i ].begin( ) + Padding, 0.0f );
+	}
+	m_Start = 0;
+	m_End = Padding;
+	m_Position = 0;
+}
+
+void Resampler::Write( const BIT_FLOAT32 * p_pFrames, const BIT_UINT32 p_FrameCount )
+{
+	const BIT_UINT32 ChannelCount = m_ChannelCount;
+	const BIT_UINT32 Count = Reserve( p_FrameCount );
+	for( BIT_UINT32 c = 0; Count && c < ChannelCount; c++ )
+	{
+		BIT_FLOAT32 * pChannel = &m_Channels[ c ][ m_End ];
+		for( BIT_UINT32 i = 0; i < Count; i++ )
+		{
+			pChannel[ i ] = p_pFrames[ i * ChannelCount + c ];
+		}
+	}
+	m_End += Count;
+}
+
+void Resampler::WritePlanar( const BIT_FLOAT32 * const * p_ppChannels, const BIT_UINT32 p_FrameCount )
+{
+	const BIT_UINT32 Count = Reserve( p_FrameCount );
+	for( BIT_UINT32 c = 0; Count && c < m_ChannelCount; c++ )
+	{
+		memcpy( &m_Channels[ c ][ m_End ], p_ppChannels[ c ], Count * sizeof( BIT_FLOAT32 ) );
+	}
+	m_End += Count;
+}
+
+void Resampler::WriteSilence( const BIT_UINT32 p_FrameCount )
+{
+	const BIT_UINT32 Count = Reserve( p_FrameCount );
+	for( BIT_UINT32 c = 0; c < m_ChannelCount; c++ )
+	{
+		std::fill( m_Channels[ c ].begin( ) + m_End, m_Channels[ c ].begin( ) + ( m_End + Count ), 0.0f );
+	}
+	m_End += Count;
+}
+
+BIT_UINT32 Resampler::Read( BIT_FLOAT32 * p_pFrames, const BIT_UINT32 p_FrameCount )
+{
+	const BIT_UINT32 Count = GetReadableFrameCount( p_FrameCount );
+	const BIT_UINT32 ChannelCount = m_ChannelCount;
+	const FilterFunction Filter = GetFilterFunction( m_InstructionSet );
+
+	for( BIT_UINT32 c = 0; Count && c < ChannelCount; c++ )
+	{
+		Filter( m_pFilter->GetCoefficients( ), m_pFilter->GetTapCount( ), GetPhaseShift( m_pFilter ), &m_Channels[ c ][ m_Start ],
+			m_Position, m_Step, p_pFrames + c, ChannelCount, Count );
+	}
+
+	m_Position += m_Step * Count;
+	Consume( );
+	return Count;
+}
+
+BIT_UINT32 Resampler::ReadPlanar( BIT_FLOAT32 * const * p_ppChannels, const BIT_UINT32 p_FrameCount )
+{
+	const BIT_UINT32 Count = GetReadableFrameCount( p_FrameCount );
+	const FilterFunction Filter = GetFilterFunction( m_InstructionSet );
+
+	for( BIT_UINT32 c = 0; Count && c < m_ChannelCount; c++ )
+	{
+		Filter( m_pFilter->GetCoefficients( ), m_pFilter->GetTapCount( ), GetPhaseShift( m_pFilter ), &m_Channels[ c ][ m_Start ],
+			m_Position, m_Step, p_ppChannels[ c ], 1, Count );
+	}
+
+	m_Position += m_Step * Count;
+	Consume( );
+	return Count;
+}
+
+// Set functions
+BIT_UINT32 Resampler::SetFilter( const ResamplerFilter * p_pFilter )
+{
+	// The buffered frames are laid out for the tap count
+	if( p_pFilter == BIT_NULL || m_pFilter == BIT_NULL || p_pFilter->GetTapCount( ) != m_pFilter->GetTapCount( ) )
+	{
+		bitTrace( "[Resampler::SetFilter] The filter has to have as many taps as the current one\n" );
+		return BIT_ERROR;
+	}
+
+	m_pFilter = p_pFilter;
+	return BIT_OK;
+}
+
+void Resampler::SetStep( const BIT_FLOAT64 p_Step )
+{
+	m_Step = static_cast< BIT_UINT64 >( p_Step * 4294967296.0 + 0.5 );
+	m_Step = m_Step ? m_Step : 1;
+}
+
+BIT_UINT32 Resampler::SetInstructionSet( const CpuFeatures::eInstructionSet p_InstructionSet )
+{
+	if( p_InstructionSet > CpuFeatures::GetSupportedInstructionSet( ) )
+	{
+		bitTrace( "[Resampler::SetInstructionSet] %s is not supported by this CPU\n",
+			CpuFeatures::GetInstructionSetName( p_InstructionSet ) );
+		return BIT_ERROR;
+	}
+
+	m_InstructionSet = p_InstructionSet;
+	return BIT_OK;
+}
+
+// Get functions
+const ResamplerFilter * Resampler::GetFilter( ) const
+{
+	return m_pFilter;
+}
+
+BIT_FLOAT64 Resampler::GetStep( ) const
+{
+	return static_cast< BIT_FLOAT64 >( m_Step ) / 4294967296.0;
+}
+
+BIT_UINT16 Resampler::GetChannelCount( ) const
+{
+	return m_ChannelCount;
+}
+
+CpuFeatures::eInstructionSet Resampler::GetInstructionSet( ) const
+{
+	return m_InstructionSet;
+}
+
+BIT_UINT32 Resampler::GetDroppedFrameCount( ) const
+{
+	return m_DroppedFrameCount;
+}
+
+BIT_UINT32 Resampler::GetInputFrameCount( const BIT_UINT32 p_OutputFrameCount ) const
+{
+	if( m_pFilter == BIT_NULL || m_ChannelCount == 0 || p_OutputFrameCount == 0 )
+	{
+		return 0;
+	}
+
+	// The last output frame reads a tap count of frames from its position
+	const BIT_UINT64 Needed = ( ( m_Position + m_Step * ( p_OutputFrameCount - 1 ) ) >> 32 ) + m_pFilter->GetTapCount( );
+	const BIT_UINT64 Buffered = m_End - m_Start;
+	return Needed > Buffered ? static_cast< BIT_UINT32 >( Needed - Buffered ) : 0;
+}
+
+// Static functions
+BIT_UINT32 Resampler::Convert( const BIT_FLOAT32 * p_pFrames, const BIT_UINT32 p_FrameCount, const BIT_UINT16 p_ChannelCount,
+	const BIT_UINT32 p_InputRate, const BIT_UINT32 p_OutputRate, const ResamplerFilter::eQuality p_Quality,
+	std::vector< BIT_FLOAT32 > & p_Output )
+{
+	if( p_InputRate == 0 || p_OutputRate == 0 )
+	{
+		bitTrace( "[Resampler::Convert] Invalid sample rate\n" );
+		return BIT_ERROR;
+	}
+
+	// Band limit to the lower of the two Nyquist frequencies
+	ResamplerFilter Filter;
+	const BIT_FLOAT32 Cutoff = p_OutputRate < p_InputRate ?
+		static_cast< BIT_FLOAT32 >( p_OutputRate ) / static_cast< BIT_FLOAT32 >( p_InputRate ) : 1.0f;
+	Resampler Converter;
+	if( Filter.Create( p_Quality, Cutoff ) != BIT_OK ||
+		Converter.Open( &Filter, p_ChannelCount, 1.0f ) != BIT_OK )
+	{
+		return BIT_ERROR;
+	}
+
+	// An exact step, a rounded one drifts over long sounds
+	Converter.m_Step = ( static_cast< BIT_UINT64 >( p_InputRate ) << 32 ) / p_OutputRate;
+
+	// Silence after the last frame flushes the filter
+	const BIT_UINT32 OutputFrameCount = static_cast< BIT_UINT32 >(
+		( static_cast< BIT_UINT64 >( p_FrameCount ) * p_OutputRate + p_InputRate - 1 ) / p_InputRate );
+	Converter.Write( p_pFrames, p_FrameCount );
+	Converter.WriteSilence( Filter.GetTapCount( ) / 2 );
+
+	p_Output.resize( OutputFrameCount * p_ChannelCount );
+	if( OutputFrameCount && Converter.Read( &p_Output[ 0 ], OutputFrameCount ) != OutputFrameCount )
+	{
+		bitTrace( "[Resampler::Convert] Not every frame was converted\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+// Private functions
+BIT_UINT32 Resampler::GetReadableFrameCount( const BIT_UINT32 p_FrameCount ) const
+{
+	if( m_pFilter == BIT_NULL || m_ChannelCount == 0 || p_FrameCount == 0 )
+	{
+		return 0;
+	}
+
+	// Frames whose taps all lie in the buffer, the position has to stay below the end
+	const BIT_UINT64 Buffered = m_End - m_Start;
+	const BIT_UINT64 TapCount = m_pFilter->GetTapCount( );
+	if( Buffered < TapCount || ( m_Position >> 32 ) > Buffered - TapCount )
+	{
+		return 0;
+	}
+
+	const BIT_UINT64 End = ( Buffered - TapCount + 1 ) << 32;
+	const BIT_UINT64 Readable = ( End - m_Position - 1 ) / m_Step + 1;
+	return Readable < p_FrameCount ? static_cast< BIT_UINT32 >( Readable ) : p_FrameCount;
+}
+
+BIT_UINT32 Resampler::Reserve( const BIT_UINT32 p_FrameCount )
+{
+	// Returns how many of the frames fit after m_End
+	if( m_ChannelCount == 0 )
+	{
+		return 0;
+	}
+
+	// Slide the frames left to read to the front once the end is reached.
+	// Reads that keep up with the writes leave less than a tap count of them.
+	const BIT_UINT32 Size = static_cast< BIT_UINT32 >( m_Channels[ 0 ].size( ) );
+	if( m_Start && m_End + p_FrameCount > Size )
+	{
+		for( BIT_UINT32 c = 0; c < m_ChannelCount; c++ )
+		{
+			memmove( &m_Channels[ c ][ 0 ], &m_Channels[ c ][ m_Start ], ( m_End - m_Start ) * sizeof( BIT_FLOAT32 ) );
+		}
+		m_End -= m_Start;
+		m_Start = 0;
+	}
+
+	if( m_End + p_FrameCount <= Size )
+	{
+		return p_FrameCount;
+	}
+
+	if( m_MaxWriteCount == 0 )
+	{
+		for( BIT_UINT32 c = 0; c < m_ChannelCount; c++ )
+		{
+			m_Channels[ c ].resize( m_End + p_FrameCount );
+		}
+		return p_FrameCount;
+	}
+
+	// No trace, this runs on the audio thread
+	m_DroppedFrameCount += m_End + p_FrameCount - Size;
+	return Size - m_End;
+}
+
+void Resampler::Consume( )
+{
+	// Throw away the frames no output frame reads anymore
+	const BIT_UINT64 Consumed = m_Position >> 32;
+	if( Consumed == 0 )
+	{
+		return;
+	}
+
+	// Large steps can point past the buffer, the rest is skipped once it's written
+	const BIT_UINT64 Buffered = m_End - m_Start;
+	const BIT_UINT64 Count = Consumed < Buffered ? Consumed : Buffered;
+	m_Start += static_cast< BIT_UINT32 >( Count );
+	m_Position -= Count << 32;
+
+	// An empty buffer starts over from the front for free
+	if( m_Start == m_End )
+	{
+		m_Start = 0;
+		m_End = 0;
+	}
+}
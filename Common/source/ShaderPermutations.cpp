@@ -0,0 +1,290 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <ShaderPermutations.hpp>
+#include <Bit/System/Timer.hpp>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor/destructor
+ShaderPermutations::ShaderPermutations( Bit::GraphicDevice * p_pGraphicDevice, const std::string & p_Name ) :
+	m_pGraphicDevice( p_pGraphicDevice ),
+	m_Name( p_Name ),
+	m_pLastPermutation( BIT_NULL ),
+	m_pSetupFunction( BIT_NULL ),
+	m_pSetupUserData( BIT_NULL ),
+	m_CompileTime( 0.0f )
+{
+}
+
+ShaderPermutations::~ShaderPermutations( )
+{
+	Unload( );
+}
+
+// Public functions
+BIT_UINT32 ShaderPermutations::AddFeature( const std::string & p_Define )
+{
+	// The key is a 32 bit mask
+	if( m_Features.size( ) >= 32 )
+	{
+		bitTrace( "[ShaderPermutations::AddFeature] %s: Too many features\n", m_Name.c_str( ) );
+		return 0;
+	}
+
+	m_Features.push_back( p_Define );
+	return 1U << static_cast< BIT_UINT32 >( m_Features.size( ) - 1 );
+}
+
+void ShaderPermutations::AddAttribute( const std::string & p_Name, const BIT_UINT32 p_Location )
+{
+	Attribute NewAttribute;
+	NewAttribute.Name = p_Name;
+	NewAttribute.Location = p_Location;
+	m_Attributes.push_back( NewAttribute );
+}
+
+ShaderPermutations::Permutation * ShaderPermutations::Get( const BIT_UINT32 p_Key )
+{
+	// Most draws ask for the same variant as the previous one
+	if( m_pLastPermutation && m_pLastPermutation->Key == p_Key )
+	{
+		return m_pLastPermutation->pShaderProgram ? m_pLastPermutation : BIT_NULL;
+	}
+
+	// Only a handful of variants are ever used, a linear search is enough.
+	// Failed variants are cached as well so they aren't compiled again every frame.
+	for( BIT_MEMSIZE i = 0; i < m_Permutations.size( ); i++ )
+	{
+		if( m_Permutations[ i ]->Key == p_Key )
+		{
+			m_pLastPermutation = m_Permutations[ i ];
+			return m_pLastPermutation->pShaderProgram ? m_pLastPermutation : BIT_NULL;
+		}
+	}
+
+	// Compile the new variant
+	Permutation * pPermutation = new Permutation;
+	pPermutation->Key = p_Key;
+	pPermutation->pVertexShader = BIT_NULL;
+	pPermutation->pFragmentShader = BIT_NULL;
+	pPermutation->pShaderProgram = BIT_NULL;
+	pPermutation->pUniforms = BIT_NULL;
+	m_Permutations.push_back( pPermutation );
+	m_pLastPermutation = pPermutation;
+
+	Bit::Timer Timer;
+	Timer.Start( );
+	const BIT_UINT32 Status = Compile( *pPermutation );
+	Timer.Stop( );
+	m_CompileTime += Timer.GetTime( ) * 1000.0f;
+
+	if( Status != BIT_OK )
+	{
+		bitTrace( "[ShaderPermutations::Get] %s: Can not compile the variant \"%s\"\n",
+			m_Name.c_str( ), GetDefines( p_Key ).c_str( ) );
+
+		// Keep the entry, without a program
+		if( pPermutation->pShaderProgram )
+		{
+			delete pPermutation->pShaderProgram;
+			pPermutation->pShaderProgram = BIT_NULL;
+		}
+		return BIT_NULL;
+	}
+
+	bitTrace( "%s: Compiled the variant \"%s\" in %.3f ms.\n",
+		m_Name.c_str( ), GetDefines( p_Key ).c_str( ), Timer.GetTime( ) * 1000.0f );
+	return pPermutation;
+}
+
+void ShaderPermutations::Unload( )
+{
+	for( BIT_MEMSIZE i = 0; i < m_Permutations.size( ); i++ )
+	{
+		Permutation * pPermutation = m_Permutations[ i ];
+
+		if( pPermutation->pUniforms )
+		{
+			delete pPermutation->pUniforms;
+		}
+
+		if( pPermutation->pShaderProgram )
+		{
+			delete pPermutation->pShaderProgram;
+		}
+
+		if( pPermutation->pVertexShader )
+		{
+			delete pPermutation->pVertexShader;
+		}
+
+		if( pPermutation->pFragmentShader )
+		{
+			delete pPermutation->pFragmentShader;
+		}
+
+		delete pPermutation;
+	}
+
+	m_Permutations.clear( );
+	m_pLastPermutation = BIT_NULL;
+	m_CompileTime = 0.0f;
+}
+
+// Set functions
+void ShaderPermutations::SetSources( const std::string & p_VertexSource, const std::string & p_FragmentSource )
+{
+	// New sources make every compiled variant stale
+	Unload( );
+	m_VertexSource = p_VertexSource;
+	m_FragmentSource = p_FragmentSource;
+}
+
+void ShaderPermutations::SetSetupFunction( SetupFunction p_Function, void * p_pUserData )
+{
+	m_pSetupFunction = p_Function;
+	m_pSetupUserData = p_pUserData;
+}
+
+// Get functions
+BIT_UINT32 ShaderPermutations::GetFeatureCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Features.size( ) );
+}
+
+BIT_UINT32 ShaderPermutations::GetPermutationCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Permutations.size( ) );
+}
+
+BIT_FLOAT64 ShaderPermutations::GetCompileTime( ) const
+{
+	return m_CompileTime;
+}
+
+std::string ShaderPermutations::GetDefines( const BIT_UINT32 p_Key ) const
+{
+	std::string Defines;
+	for( BIT_MEMSIZE i = 0; i < m_Features.size( ); i++ )
+	{
+		if( p_Key & ( 1U << i ) )
+		{
+			if( Defines.size( ) )
+			{
+				Defines += " ";
+			}
+			Defines += m_Features[ i ];
+		}
+	}
+
+	return Defines;
+}
+
+// Private functions
+BIT_UINT32 ShaderPermutations::Compile( Permutation & p_Permutation )
+{
+	// Build the define block of the key
+	std::string Defines;
+	for( BIT_MEMSIZE i = 0; i < m_Features.size( ); i++ )
+	{
+		if( p_Permutation.Key & ( 1U << i ) )
+		{
+			Defines += "#define " + m_Features[ i ] + " \n";
+		}
+	}
+
+	// Create and compile the shaders
+	if( ( p_Permutation.pVertexShader = m_pGraphicDevice->CreateShader( Bit::Shader::Vertex ) ) == BIT_NULL ||
+		( p_Permutation.pFragmentShader = m_pGraphicDevice->CreateShader( Bit::Shader::Fragment ) ) == BIT_NULL )
+	{
+		bitTrace( "[ShaderPermutations::Compile] Can not create the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	p_Permutation.pVertexShader->SetSource( InjectDefines( m_VertexSource, Defines ) );
+	p_Permutation.pFragmentShader->SetSource( InjectDefines( m_FragmentSource, Defines ) );
+	if( p_Permutation.pVertexShader->Compile( ) != BIT_OK ||
+		p_Permutation.pFragmentShader->Compile( ) != BIT_OK )
+	{
+		bitTrace( "[ShaderPermutations::Compile] Can not compile the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	// Create the shader program
+	if( ( p_Permutation.pShaderProgram = m_pGraphicDevice->CreateShaderProgram( ) ) == BIT_NULL )
+	{
+		bitTrace( "[ShaderPermutations::Compile] Can not create the shader program\n" );
+		return BIT_ERROR;
+	}
+
+	// Attach the shaders
+	if( p_Permutation.pShaderProgram->AttachShaders( p_Permutation.pVertexShader ) != BIT_OK ||
+		p_Permutation.pShaderProgram->AttachShaders( p_Permutation.pFragmentShader ) != BIT_OK )
+	{
+		bitTrace( "[ShaderPermutations::Compile] Can not attach the shaders\n" );
+		return BIT_ERROR;
+	}
+
+	// Set attribute locations
+	for( BIT_MEMSIZE i = 0; i < m_Attributes.size( ); i++ )
+	{
+		p_Permutation.pShaderProgram->SetAttributeLocation( m_Attributes[ i ].Name.c_str( ), m_Attributes[ i ].Location );
+	}
+
+	// Link the shaders
+	if( p_Permutation.pShaderProgram->Link( ) != BIT_OK )
+	{
+		bitTrace( "[ShaderPermutations::Compile] Can not link the shader program\n" );
+		return BIT_ERROR;
+	}
+
+	// Set the uniforms of the new program
+	p_Permutation.pUniforms = new ShaderUniforms( p_Permutation.pShaderProgram );
+
+	if( m_pSetupFunction )
+	{
+		p_Permutation.pShaderProgram->Bind( );
+		m_pSetupFunction( p_Permutation, m_pSetupUserData );
+		p_Permutation.pShaderProgram->Unbind( );
+	}
+
+	return BIT_OK;
+}
+
+std::string ShaderPermutations::InjectDefines( const std::string & p_Source, const std::string & p_Defines ) const
+{
+	// The #version directive has to stay the first line
+	if( p_Source.compare( 0, 8, "#version" ) == 0 )
+	{
+		const std::string::size_type LineEnd = p_Source.find( '\n' );
+		if( LineEnd != std::string::npos )
+		{
+			return p_Source.substr( 0, LineEnd + 1 ) + p_Defines + p_Source.substr( LineEnd + 1 );
+		}
+	}
+
+	return p_Defines + p_Source;
+}
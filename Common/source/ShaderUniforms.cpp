@@ -0,0 +1,175 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+#include <ShaderUniforms.hpp>
+#include <cstring>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor/destructor
+ShaderUniforms::ShaderUniforms( Bit::ShaderProgram * p_pShaderProgram ) :
+	m_pShaderProgram( p_pShaderProgram ),
+	m_UploadCount( 0 ),
+	m_SkipCount( 0 )
+{
+	for( BIT_MEMSIZE i = 0; i < FrameBlockMemberCount; i++ )
+	{
+		m_FrameBlockVersions[ i ] = 0;
+	}
+}
+
+ShaderUniforms::~ShaderUniforms( )
+{
+}
+
+// Public functions
+void ShaderUniforms::SetUniform1i( const UniformHandle & p_Handle, const BIT_SINT32 p_Value )
+{
+	if( Changed( p_Handle, &p_Value, sizeof( p_Value ) ) )
+	{
+		m_pShaderProgram->SetUniform1i( p_Handle.GetName( ), p_Value );
+	}
+}
+
+void ShaderUniforms::SetUniform1f( const UniformHandle & p_Handle, const BIT_FLOAT32 p_Value )
+{
+	if( Changed( p_Handle, &p_Value, sizeof( p_Value ) ) )
+	{
+		m_pShaderProgram->SetUniform1f( p_Handle.GetName( ), p_Value );
+	}
+}
+
+void ShaderUniforms::SetUniform2f( const UniformHandle & p_Handle, const BIT_FLOAT32 p_X, const BIT_FLOAT32 p_Y )
+{
+	const BIT_FLOAT32 Values[ 2 ] = { p_X, p_Y };
+	if( Changed( p_Handle, Values, sizeof( Values ) ) )
+	{
+		m_pShaderProgram->SetUniform2f( p_Handle.GetName( ), p_X, p_Y );
+	}
+}
+
+void ShaderUniforms::SetUniform3f( const UniformHandle & p_Handle, const BIT_FLOAT32 p_X, const BIT_FLOAT32 p_Y, const BIT_FLOAT32 p_Z )
+{
+	const BIT_FLOAT32 Values[ 3 ] = { p_X, p_Y, p_Z };
+	if( Changed( p_Handle, Values, sizeof( Values ) ) )
+	{
+		m_pShaderProgram->SetUniform3f( p_Handle.GetName( ), p_X, p_Y, p_Z );
+	}
+}
+
+void ShaderUniforms::SetUniformMatrix4x4f( const UniformHandle & p_Handle, const Bit::Matrix4x4 & p_Matrix )
+{
+	if( Changed( p_Handle, p_Matrix.m, sizeof( p_Matrix.m ) ) )
+	{
+		m_pShaderProgram->SetUniformMatrix4x4f( p_Handle.GetName( ), p_Matrix );
+	}
+}
+
+void ShaderUniforms::Invalidate( )
+{
+	// Force every uniform to be uploaded again, needed after relinking the program.
+	m_Entries.clear( );
+	for( BIT_MEMSIZE i = 0; i < FrameBlockMemberCount; i++ )
+	{
+		m_FrameBlockVersions[ i ] = 0;
+	}
+}
+
+void ShaderUniforms::ResetStatistics( )
+{
+	m_UploadCount = 0;
+	m_SkipCount = 0;
+}
+
+// Set functions
+void ShaderUniforms::SetFrameBlockVersion( const BIT_UINT32 p_Members, const BIT_UINT32 p_Version )
+{
+	for( BIT_UINT32 i = 0; i < FrameBlockMemberCount; i++ )
+	{
+		if( p_Members & ( 1 << i ) )
+		{
+			m_FrameBlockVersions[ i ] = p_Version;
+		}
+	}
+}
+
+// Get functions
+Bit::ShaderProgram * ShaderUniforms::GetShaderProgram( ) const
+{
+	return m_pShaderProgram;
+}
+
+BIT_UINT32 ShaderUniforms::GetFrameBlockVersion( const BIT_UINT32 p_Member ) const
+{
+	return p_Member < FrameBlockMemberCount ? m_FrameBlockVersions[ p_Member ] : 0;
+}
+
+BIT_UINT32 ShaderUniforms::GetUploadCount( ) const
+{
+	return m_UploadCount;
+}
+
+BIT_UINT32 ShaderUniforms::GetSkipCount( ) const
+{
+	return m_SkipCount;
+}
+
+// Private functions
+BIT_BOOL ShaderUniforms::Changed( const UniformHandle & p_Handle, const void * p_pData, const BIT_UINT32 p_Size )
+{
+	// Programs only have a handful of uniforms, a linear search beats a map here.
+	for( BIT_MEMSIZE i = 0; i < m_Entries.size( ); i++ )
+	{
+		Entry & CurrentEntry = m_Entries[ i ];
+
+		// Different names can share a hash, the name decides
+		if( CurrentEntry.Hash != p_Handle.GetHash( ) ||
+			( CurrentEntry.pName != p_Handle.GetName( ) && strcmp( CurrentEntry.pName, p_Handle.GetName( ) ) != 0 ) )
+		{
+			continue;
+		}
+
+		if( CurrentEntry.Size == p_Size && memcmp( CurrentEntry.Data, p_pData, p_Size ) == 0 )
+		{
+			m_SkipCount++;
+			return BIT_FALSE;
+		}
+
+		CurrentEntry.Size = p_Size;
+		memcpy( CurrentEntry.Data, p_pData, p_Size );
+		m_UploadCount++;
+		return BIT_TRUE;
+	}
+
+	// First time we see this uniform
+	Entry NewEntry;
+	NewEntry.pName = p_Handle.GetName( );
+	NewEntry.Hash = p_Handle.GetHash( );
+	NewEntry.Size = p_Size;
+	memcpy( NewEntry.Data, p_pData, p_Size );
+	m_Entries.push_back( NewEntry );
+
+	m_UploadCount++;
+	return BIT_TRUE;
+}
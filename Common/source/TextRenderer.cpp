@@ -0,0 +1,331 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <TextRenderer.hpp>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Glyph cell, the 5x7 glyph with a column and a row of spacing
+static const BIT_UINT32 GlyphWidth = 6;
+static const BIT_UINT32 GlyphHeight = 8;
+
+// 5x7 font, five columns per character with the top row in the lowest bit
+static const BIT_UINT8 FontColumns[ 95 * 5 ] =
+{
+	0x00, 0x00, 0x00, 0x00, 0x00,	// Space
+	0x00, 0x00, 0x5F, 0x00, 0x00,	// !
+	0x00, 0x07, 0x00, 0x07, 0x00,	// "
+	0x14, 0x7F, 0x14, 0x7F, 0x14,	// #
+	0x24, 0x2A, 0x7F, 0x2A, 0x12,	// $
+	0x23, 0x13, 0x08, 0x64, 0x62,	// %
+	0x36, 0x49, 0x55, 0x22, 0x50,	// &
+	0x00, 0x05, 0x03, 0x00, 0x00,	// '
+	0x00, 0x1C, 0x22, 0x41, 0x00,	// (
+	0x00, 0x41, 0x22, 0x1C, 0x00,	// )
+	0x08, 0x2A, 0x1C, 0x2A, 0x08,	// *
+	0x08, 0x08, 0x3E, 0x08, 0x08,	// +
+	0x00, 0x50, 0x30, 0x00, 0x00,	// ,
+	0x08, 0x08, 0x08, 0x08, 0x08,	// -
+	0x00, 0x60, 0x60, 0x00, 0x00,	// .
+	0x20, 0x10, 0x08, 0x04, 0x02,	// /
+	0x3E, 0x51, 0x49, 0x45, 0x3E,	// 0
+	0x00, 0x42, 0x7F, 0x40, 0x00,	// 1
+	0x42, 0x61, 0x51, 0x49, 0x46,	// 2
+	0x21, 0x41, 0x45, 0x4B, 0x31,	// 3
+	0x18, 0x14, 0x12, 0x7F, 0x10,	// 4
+	0x27, 0x45, 0x45, 0x45, 0x39,	// 5
+	0x3C, 0x4A, 0x49, 0x49, 0x30,	// 6
+	0x01, 0x71, 0x09, 0x05, 0x03,	// 7
+	0x36, 0x49, 0x49, 0x49, 0x36,	// 8
+	0x06, 0x49, 0x49, 0x29, 0x1E,	// 9
+	0x00, 0x36, 0x36, 0x00, 0x00,	// :
+	0x00, 0x56, 0x36, 0x00, 0x00,	// ;
+	0x08, 0x14, 0x22, 0x41, 0x00,	// <
+	0x14, 0x14, 0x14, 0x14, 0x14,	// =
+	0x00, 0x41, 0x22, 0x14, 0x08,	// >
+	0x02, 0x01, 0x51, 0x09, 0x06,	// ?
+	0x32, 0x49, 0x79, 0x41, 0x3E,	// @
+	0x7E, 0x11, 0x11, 0x11, 0x7E,	// A
+	0x7F, 0x49, 0x49, 0x49, 0x36,	// B
+	0x3E, 0x41, 0x41, 0x41, 0x22,	// C
+	0x7F, 0x41, 0x41, 0x22, 0x1C,	// D
+	0x7F, 0x49, 0x49, 0x49, 0x41,	// E
+	0x7F, 0x09, 0x09, 0x01, 0x01,	// F
+	0x3E, 0x41, 0x41, 0x51, 0x32,	// G
+	0x7F, 0x08, 0x08, 0x08, 0x7F,	// H
+	0x00, 0x41, 0x7F, 0x41, 0x00,	// I
+	0x20, 0x40, 0x41, 0x3F, 0x01,	// J
+	0x7F, 0x08, 0x14, 0x22, 0x41,	// K
+	0x7F, 0x40, 0x40, 0x40, 0x40,	// L
+	0x7F, 0x02, 0x04, 0x02, 0x7F,	// M
+	0x7F, 0x04, 0x08, 0x10, 0x7F,	// N
+	0x3E, 0x41, 0x41, 0x41, 0x3E,	// O
+	0x7F, 0x09, 0x09, 0x09, 0x06,	// P
+	0x3E, 0x41, 0x51, 0x21, 0x5E,	// Q
+	0x7F, 0x09, 0x19, 0x29, 0x46,	// R
+	0x46, 0x49, 0x49, 0x49, 0x31,	// S
+	0x01, 0x01, 0x7F, 0x01, 0x01,	// T
+	0x3F, 0x40, 0x40, 0x40, 0x3F,	// U
+	0x1F, 0x20, 0x40, 0x20, 0x1F,	// V
+	0x7F, 0x20, 0x18, 0x20, 0x7F,	// W
+	0x63, 0x14, 0x08, 0x14, 0x63,	// X
+	0x03, 0x04, 0x78, 0x04, 0x03,	// Y
+	0x61, 0x51, 0x49, 0x45, 0x43,	// Z
+	0x00, 0x7F, 0x41, 0x41, 0x00,	// [
+	0x02, 0x04, 0x08, 0x10, 0x20,	// Backslash
+	0x00, 0x41, 0x41, 0x7F, 0x00,	// ]
+	0x04, 0x02, 0x01, 0x02, 0x04,	// ^
+	0x40, 0x40, 0x40, 0x40, 0x40,	// _
+	0x00, 0x01, 0x02, 0x04, 0x00,	// `
+	0x20, 0x54, 0x54, 0x54, 0x78,	// a
+	0x7F, 0x48, 0x44, 0x44, 0x38,	// b
+	0x38, 0x44, 0x44, 0x44, 0x20,	// c
+	0x38, 0x44, 0x44, 0x48, 0x7F,	// d
+	0x38, 0x54, 0x54, 0x54, 0x18,	// e
+	0x08, 0x7E, 0x09, 0x01, 0x02,	// f
+	0x0C, 0x52, 0x52, 0x52, 0x3E,	// g
+	0x7F, 0x08, 0x04, 0x04, 0x78,	// h
+	0x00, 0x44, 0x7D, 0x40, 0x00,	// i
+	0x20, 0x40, 0x44, 0x3D, 0x00,	// j
+	0x7F, 0x10, 0x28, 0x44, 0x00,	// k
+	0x00, 0x41, 0x7F, 0x40, 0x00,	// l
+	0x7C, 0x04, 0x18, 0x04, 0x78,	// m
+	0x7C, 0x08, 0x04, 0x04, 0x78,	// n
+	0x38, 0x44, 0x44, 0x44, 0x38,	// o
+	0x7C, 0x14, 0x14, 0x14, 0x08,	// p
+	0x08, 0x14, 0x14, 0x18, 0x7C,	// q
+	0x7C, 0x08, 0x04, 0x04, 0x08,	// r
+	0x48, 0x54, 0x54, 0x54, 0x20,	// s
+	0x04, 0x3F, 0x44, 0x40, 0x20,	// t
+	0x3C, 0x40, 0x40, 0x20, 0x7C,	// u
+	0x1C, 0x20, 0x40, 0x20, 0x1C,	// v
+	0x3C, 0x40, 0x30, 0x40, 0x3C,	// w
+	0x44, 0x28, 0x10, 0x28, 0x44,	// x
+	0x0C, 0x50, 0x50, 0x50, 0x3C,	// y
+	0x44, 0x64, 0x54, 0x4C, 0x44,	// z
+	0x00, 0x08, 0x36, 0x41, 0x00,	// {
+	0x00, 0x00, 0x7F, 0x00, 0x00,	// |
+	0x00, 0x41, 0x36, 0x08, 0x00,	// }
+	0x02, 0x01, 0x02, 0x04, 0x02	// ~
+};
+
+// Constructor/destructor
+TextRenderer::TextRenderer( GUIManager * p_pManager ) :
+	m_Loaded( BIT_FALSE ),
+	m_pManager( p_pManager ),
+	m_GlyphCount( 0 )
+{
+}
+
+TextRenderer::~TextRenderer( )
+{
+	Unload( );
+}
+
+// Public functions
+BIT_UINT32 TextRenderer::Load( )
+{
+	if( m_Loaded )
+	{
+		bitTrace( "[TextRenderer::Load] Already loaded\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_pManager == BIT_NULL )
+	{
+		bitTrace( "[TextRenderer::Load] GUI manager is NULL\n" );
+		return BIT_ERROR;
+	}
+
+	// Rasterize every glyph as a white image, the coverage goes to the alpha.
+	// Image rows start at the bottom of the quad.
+	BIT_UINT8 Pixels[ GlyphWidth * GlyphHeight * 4 ];
+
+	for( BIT_UINT32 i = 0; i < CharacterCount; i++ )
+	{
+		for( BIT_UINT32 y = 0; y < GlyphHeight; y++ )
+		{
+			for( BIT_UINT32 x = 0; x < GlyphWidth; x++ )
+			{
+				const BIT_UINT32 Row = GlyphHeight - 1 - y;
+				const BIT_BOOL Set = x < 5 && Row < 7 && ( ( FontColumns[ i * 5 + x ] >> Row ) & 1 );
+				BIT_UINT8 * pPixel = &Pixels[ ( y * GlyphWidth + x ) * 4 ];
+
+				pPixel[ 0 ] = pPixel[ 1 ] = pPixel[ 2 ] = 255;
+				pPixel[ 3 ] = Set ? 255 : 0;
+			}
+		}
+
+		BIT_UINT32 Index = 0;
+		if( m_pManager->AddImage( Bit::Vector2_ui32( GlyphWidth, GlyphHeight ), Pixels, Index ) != BIT_OK )
+		{
+			bitTrace( "[TextRenderer::Load] Can not add the glyph images to the GUI atlas\n" );
+			return BIT_ERROR;
+		}
+
+		const BIT_FLOAT32 * pRect = m_pManager->GetImageRect( Index );
+		for( BIT_UINT32 j = 0; j < 4; j++ )
+		{
+			m_GlyphRects[ i ][ j ] = pRect[ j ];
+		}
+	}
+
+	m_GlyphCount = 0;
+	m_Loaded = BIT_TRUE;
+	return BIT_OK;
+}
+
+void TextRenderer::Unload( )
+{
+	// The glyph images stay in the atlas of the GUI manager
+	m_Quads.clear( );
+	m_GlyphCount = 0;
+	m_Loaded = BIT_FALSE;
+}
+
+void TextRenderer::Begin( )
+{
+	// The quad list keeps its memory
+	m_GlyphCount = 0;
+}
+
+void TextRenderer::Add( const Bit::Vector2_si32 p_Position, const std::string & p_Text, const BIT_UINT32 p_Scale )
+{
+	if( !m_Loaded )
+	{
+		return;
+	}
+
+	// Make room for every character, spaces and line breaks leave some unused
+	const BIT_MEMSIZE Needed = ( m_GlyphCount + p_Text.size( ) ) * GUIManager::QuadSize;
+	if( Needed > m_Quads.size( ) )
+	{
+		m_Quads.resize( Needed > m_Quads.size( ) * 2 ? Needed : m_Quads.size( ) * 2 );
+	}
+
+	m_GlyphCount += Layout( p_Position, p_Text, p_Scale, &m_Quads[ m_GlyphCount * GUIManager::QuadSize ] );
+}
+
+BIT_UINT32 TextRenderer::Layout( const Bit::Vector2_si32 p_Position, const std::string & p_Text, const BIT_UINT32 p_Scale,
+	BIT_FLOAT32 * p_pQuads ) const
+{
+	const BIT_FLOAT32 Width = static_cast< BIT_FLOAT32 >( GlyphWidth * p_Scale );
+	const BIT_FLOAT32 Height = static_cast< BIT_FLOAT32 >( GlyphHeight * p_Scale );
+	BIT_FLOAT32 X = static_cast< BIT_FLOAT32 >( p_Position.x );
+	BIT_FLOAT32 Y = static_cast< BIT_FLOAT32 >( p_Position.y ) - Height;
+	BIT_FLOAT32 * pQuad = p_pQuads;
+	BIT_UINT32 Count = 0;
+
+	for( BIT_MEMSIZE i = 0; i < p_Text.size( ); i++ )
+	{
+		BIT_UINT32 Character = static_cast< BIT_UINT8 >( p_Text[ i ] );
+
+		if( Character == '\n' )
+		{
+			X = static_cast< BIT_FLOAT32 >( p_Position.x );
+			Y -= Height;
+			continue;
+		}
+
+		if( Character == ' ' )
+		{
+			X += Width;
+			continue;
+		}
+
+		// Characters outside of the font are shown as question marks
+		if( Character < FirstCharacter || Character >= FirstCharacter + CharacterCount )
+		{
+			Character = '?';
+		}
+
+		const BIT_FLOAT32 * pRect = m_GlyphRects[ Character - FirstCharacter ];
+		pQuad[ 0 ] = X;
+		pQuad[ 1 ] = Y;
+		pQuad[ 2 ] = Width;
+		pQuad[ 3 ] = Height;
+		pQuad[ 4 ] = pRect[ 0 ];
+		pQuad[ 5 ] = pRect[ 1 ];
+		pQuad[ 6 ] = pRect[ 2 ];
+		pQuad[ 7 ] = pRect[ 3 ];
+		pQuad += GUIManager::QuadSize;
+
+		X += Width;
+		Count++;
+	}
+
+	return Count;
+}
+
+void TextRenderer::Render( )
+{
+	if( !m_Loaded || m_GlyphCount == 0 )
+	{
+		return;
+	}
+
+	m_pManager->RenderQuads( &m_Quads[ 0 ], m_GlyphCount );
+}
+
+// Get functions
+Bit::Vector2_ui32 TextRenderer::GetGlyphSize( ) const
+{
+	return Bit::Vector2_ui32( GlyphWidth, GlyphHeight );
+}
+
+Bit::Vector2_ui32 TextRenderer::GetTextSize( const std::string & p_Text, const BIT_UINT32 p_Scale ) const
+{
+	if( p_Text.size( ) == 0 )
+	{
+		return Bit::Vector2_ui32( 0, 0 );
+	}
+
+	// The widest line times the line count
+	BIT_UINT32 Columns = 0;
+	BIT_UINT32 MaxColumns = 0;
+	BIT_UINT32 Lines = 1;
+
+	for( BIT_MEMSIZE i = 0; i < p_Text.size( ); i++ )
+	{
+		if( p_Text[ i ] == '\n' )
+		{
+			Columns = 0;
+			Lines++;
+			continue;
+		}
+
+		if( ++Columns > MaxColumns )
+		{
+			MaxColumns = Columns;
+		}
+	}
+
+	return Bit::Vector2_ui32( MaxColumns * GlyphWidth * p_Scale, Lines * GlyphHeight * p_Scale );
+}
+
+BIT_UINT32 TextRenderer::GetGlyphCount( ) const
+{
+	return m_GlyphCount;
+}
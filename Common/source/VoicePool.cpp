@@ -0,0 +1,341 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <VoicePool.hpp>
+#include <AL/al.h>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor/destructor
+VoicePool::VoicePool( ) :
+	m_PlayIndex( 0 ),
+	m_StealCount( 0 ),
+	m_RejectCount( 0 )
+{
+}
+
+VoicePool::~VoicePool( )
+{
+	Close( );
+}
+
+// Public functions
+BIT_UINT32 VoicePool::Open( const BIT_UINT32 p_VoiceCount, const BIT_UINT32 p_MaxSoundCount )
+{
+	Close( );
+
+	// The handles keep the voice index in the low 16 bits
+	if( p_VoiceCount == 0 || p_VoiceCount > 0xFFFF )
+	{
+		bitTrace( "[VoicePool::Open] Invalid voice count: %u\n", p_VoiceCount );
+		return BIT_ERROR;
+	}
+
+	m_Voices.reserve( p_VoiceCount );
+	m_FreeVoices.reserve( p_VoiceCount );
+	m_Sounds.reserve( p_MaxSoundCount );
+
+	alGetError( );
+	for( BIT_UINT32 i = 0; i < p_VoiceCount; i++ )
+	{
+		ALuint Source = 0;
+		alGenSources( 1, &Source );
+		if( alGetError( ) != AL_NO_ERROR )
+		{
+			break;
+		}
+
+		Voice NewVoice;
+		NewVoice.Source = Source;
+		NewVoice.Generation = 1;
+		NewVoice.Priority = 0;
+		NewVoice.Volume = 0.0f;
+		NewVoice.StartIndex = 0;
+		NewVoice.Active = BIT_FALSE;
+		m_Voices.push_back( NewVoice );
+	}
+
+	if( m_Voices.size( ) == 0 )
+	{
+		bitTrace( "[VoicePool::Open] Can not create any OpenAL source\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_Voices.size( ) < p_VoiceCount )
+	{
+		bitTrace( "[VoicePool::Open] Only got %u of %u voices\n", static_cast< BIT_UINT32 >( m_Voices.size( ) ), p_VoiceCount );
+	}
+
+	// Hand out the first voices first
+	for( BIT_UINT32 i = static_cast< BIT_UINT32 >( m_Voices.size( ) ); i > 0; i-- )
+	{
+		m_FreeVoices.push_back( i - 1 );
+	}
+
+	return BIT_OK;
+}
+
+void VoicePool::Close( )
+{
+	for( BIT_MEMSIZE i = 0; i < m_Voices.size( ); i++ )
+	{
+		ALuint Source = m_Voices[ i ].Source;
+		alSourceStop( Source );
+		alSourcei( Source, AL_BUFFER, 0 );
+		alDeleteSources( 1, &Source );
+	}
+
+	for( BIT_MEMSIZE i = 0; i < m_Sounds.size( ); i++ )
+	{
+		ALuint Buffer = m_Sounds[ i ].Buffer;
+		alDeleteBuffers( 1, &Buffer );
+	}
+
+	m_Voices.clear( );
+	m_FreeVoices.clear( );
+	m_Sounds.clear( );
+	m_PlayIndex = 0;
+	m_StealCount = 0;
+	m_RejectCount = 0;
+}
+
+BIT_SINT32 VoicePool::LoadSound( const Bit::AudioBuffer & p_AudioBuffer )
+{
+	if( m_Sounds.size( ) == m_Sounds.capacity( ) )
+	{
+		bitTrace( "[VoicePool::LoadSound] The pool is full of sounds\n" );
+		return -1;
+	}
+
+	const BIT_UINT16 Channels = p_AudioBuffer.GetChannelCount( );
+	const BIT_UINT16 Bits = p_AudioBuffer.GetBitsPerSample( );
+	if( ( Channels != 1 && Channels != 2 ) || ( Bits != 8 && Bits != 16 ) || p_AudioBuffer.GetSampleRate( ) == 0 )
+	{
+		bitTrace( "[VoicePool::LoadSound] Unsupported audio format\n" );
+		return -1;
+	}
+
+	ALenum Format = AL_FORMAT_MONO8;
+	if( Bits == 16 )
+	{
+		Format = Channels == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+	}
+	else if( Channels == 2 )
+	{
+		Format = AL_FORMAT_STEREO8;
+	}
+
+	// One buffer for every voice playing the sound
+	alGetError( );
+	ALuint Buffer = 0;
+	alGenBuffers( 1, &Buffer );
+	alBufferData( Buffer, Format, p_AudioBuffer.GetBuffer( ), static_cast< ALsizei >( p_AudioBuffer.GetBufferSize( ) ),
+		static_cast< ALsizei >( p_AudioBuffer.GetSampleRate( ) ) );
+	if( alGetError( ) != AL_NO_ERROR )
+	{
+		bitTrace( "[VoicePool::LoadSound] Can not create the OpenAL buffer\n" );
+		alDeleteBuffers( 1, &Buffer );
+		return -1;
+	}
+
+	Sound NewSound;
+	NewSound.Buffer = Buffer;
+	NewSound.Length = static_cast< BIT_FLOAT64 >( p_AudioBuffer.GetBufferSize( ) / ( Channels * ( Bits / 8 ) ) ) /
+		static_cast< BIT_FLOAT64 >( p_AudioBuffer.GetSampleRate( ) );
+	m_Sounds.push_back( NewSound );
+
+	return static_cast< BIT_SINT32 >( m_Sounds.size( ) - 1 );
+}
+
+VoicePool::VoiceHandle VoicePool::Play( const BIT_UINT32 p_Sound, const BIT_SINT32 p_Priority, const BIT_FLOAT32 p_Volume,
+	const Bit::Vector3_f32 * p_pPosition )
+{
+	if( p_Sound >= m_Sounds.size( ) || m_Voices.size( ) == 0 )
+	{
+		return InvalidVoice;
+	}
+
+	// Look for voices that are done before stealing one
+	if( m_FreeVoices.size( ) == 0 )
+	{
+		Update( );
+	}
+
+	BIT_UINT32 Index = 0;
+	if( m_FreeVoices.size( ) )
+	{
+		Index = m_FreeVoices.back( );
+		m_FreeVoices.pop_back( );
+	}
+	else
+	{
+		Index = FindVictim( p_Priority, p_Volume );
+		if( Index == m_Voices.size( ) )
+		{
+			m_RejectCount++;
+			return InvalidVoice;
+		}
+		m_StealCount++;
+	}
+
+	Voice & CurrentVoice = m_Voices[ Index ];
+	const ALuint Source = CurrentVoice.Source;
+	alSourceStop( Source );
+	alSourcei( Source, AL_BUFFER, static_cast< ALint >( m_Sounds[ p_Sound ].Buffer ) );
+	alSourcef( Source, AL_GAIN, p_Volume );
+	if( p_pPosition )
+	{
+		alSourcei( Source, AL_SOURCE_RELATIVE, 0 );
+		alSource3f( Source, AL_POSITION, p_pPosition->x, p_pPosition->y, p_pPosition->z );
+	}
+	else
+	{
+		alSourcei( Source, AL_SOURCE_RELATIVE, 1 );
+		alSource3f( Source, AL_POSITION, 0.0f, 0.0f, 0.0f );
+	}
+	alSourcePlay( Source );
+
+	// A new generation makes the handles of the previous sound invalid
+	CurrentVoice.Generation = ( CurrentVoice.Generation + 1 ) & 0xFFFF;
+	CurrentVoice.Generation = CurrentVoice.Generation ? CurrentVoice.Generation : 1;
+	CurrentVoice.Priority = p_Priority;
+	CurrentVoice.Volume = p_Volume;
+	CurrentVoice.StartIndex = m_PlayIndex++;
+	CurrentVoice.Active = BIT_TRUE;
+
+	return ( CurrentVoice.Generation << 16 ) | Index;
+}
+
+void VoicePool::Stop( const VoiceHandle p_Voice )
+{
+	if( IsPlaying( p_Voice ) )
+	{
+		const BIT_UINT32 Index = p_Voice & 0xFFFF;
+		alSourceStop( m_Voices[ Index ].Source );
+		Release( Index );
+	}
+}
+
+void VoicePool::StopAll( )
+{
+	for( BIT_UINT32 i = 0; i < m_Voices.size( ); i++ )
+	{
+		if( m_Voices[ i ].Active )
+		{
+			alSourceStop( m_Voices[ i ].Source );
+			Release( i );
+		}
+	}
+}
+
+void VoicePool::Update( )
+{
+	for( BIT_UINT32 i = 0; i < m_Voices.size( ); i++ )
+	{
+		if( !m_Voices[ i ].Active )
+		{
+			continue;
+		}
+
+		ALint State = AL_STOPPED;
+		alGetSourcei( m_Voices[ i ].Source, AL_SOURCE_STATE, &State );
+		if( State != AL_PLAYING && State != AL_PAUSED )
+		{
+			Release( i );
+		}
+	}
+}
+
+// Get functions
+BIT_BOOL VoicePool::IsPlaying( const VoiceHandle p_Voice ) const
+{
+	const BIT_UINT32 Index = p_Voice & 0xFFFF;
+	return Index < m_Voices.size( ) && m_Voices[ Index ].Active && m_Voices[ Index ].Generation == ( p_Voice >> 16 );
+}
+
+BIT_UINT32 VoicePool::GetVoiceCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Voices.size( ) );
+}
+
+BIT_UINT32 VoicePool::GetActiveCount( ) const
+{
+	return static_cast< BIT_UINT32 >( m_Voices.size( ) - m_FreeVoices.size( ) );
+}
+
+BIT_UINT32 VoicePool::GetStealCount( ) const
+{
+	return m_StealCount;
+}
+
+BIT_UINT32 VoicePool::GetRejectCount( ) const
+{
+	return m_RejectCount;
+}
+
+BIT_FLOAT64 VoicePool::GetSoundLength( const BIT_UINT32 p_Sound ) const
+{
+	return p_Sound < m_Sounds.size( ) ? m_Sounds[ p_Sound ].Length : 0.0f;
+}
+
+// Private functions
+BIT_UINT32 VoicePool::FindVictim( const BIT_SINT32 p_Priority, const BIT_FLOAT32 p_Volume ) const
+{
+	// Lowest priority, then quietest, then oldest
+	BIT_UINT32 Victim = 0;
+	for( BIT_UINT32 i = 1; i < m_Voices.size( ); i++ )
+	{
+		const Voice & Candidate = m_Voices[ i ];
+		const Voice & Current = m_Voices[ Victim ];
+
+		if( Candidate.Priority != Current.Priority )
+		{
+			Victim = Candidate.Priority < Current.Priority ? i : Victim;
+		}
+		else if( Candidate.Volume != Current.Volume )
+		{
+			Victim = Candidate.Volume < Current.Volume ? i : Victim;
+		}
+		else if( Candidate.StartIndex - m_PlayIndex < Current.StartIndex - m_PlayIndex )
+		{
+			Victim = i;
+		}
+	}
+
+	// Never cut off something more important, or as important and louder
+	const Voice & Found = m_Voices[ Victim ];
+	if( Found.Priority > p_Priority || ( Found.Priority == p_Priority && Found.Volume > p_Volume ) )
+	{
+		return static_cast< BIT_UINT32 >( m_Voices.size( ) );
+	}
+
+	return Victim;
+}
+
+void VoicePool::Release( const BIT_UINT32 p_Index )
+{
+	m_Voices[ p_Index ].Active = BIT_FALSE;
+	m_FreeVoices.push_back( p_Index );
+}
@@ -0,0 +1,348 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <WaveStream.hpp>
+#include <cstring>
+#ifdef BIT_PLATFORM_WINDOWS
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Block size of the prefetching ahead of the read position and of the releasing behind it
+static const BIT_UINT32 ReadAheadSize = 256 * 1024;
+
+// Little endian helpers, the chunk data isn't aligned
+static BIT_UINT32 ReadUInt32( const BIT_UINT8 * p_pData )
+{
+	return static_cast< BIT_UINT32 >( p_pData[ 0 ] ) | ( static_cast< BIT_UINT32 >( p_pData[ 1 ] ) << 8 ) |
+		( static_cast< BIT_UINT32 >( p_pData[ 2 ] ) << 16 ) | ( static_cast< BIT_UINT32 >( p_pData[ 3 ] ) << 24 );
+}
+
+static BIT_UINT16 ReadUInt16( const BIT_UINT8 * p_pData )
+{
+	return static_cast< BIT_UINT16 >( p_pData[ 0 ] | ( p_pData[ 1 ] << 8 ) );
+}
+
+// Constructor/destructor
+WaveStream::WaveStream( ) :
+	m_pFile( BIT_NULL ),
+	m_FileSize( 0 ),
+	m_pData( BIT_NULL ),
+	m_DataSize( 0 ),
+	m_ReleasedOffset( 0 ),
+	m_PrefetchedOffset( 0 ),
+	m_ChannelCount( 0 ),
+	m_SampleRate( 0 ),
+	m_BitsPerSample( 0 ),
+	m_FrameSize( 0 ),
+	m_Position( 0 )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	m_FileHandle = BIT_NULL;
+	m_MappingHandle = BIT_NULL;
+#else
+	m_FileDescriptor = -1;
+#endif
+}
+
+WaveStream::~WaveStream( )
+{
+	Close( );
+}
+
+// Public functions
+BIT_UINT32 WaveStream::Open( const std::string & p_FilePath )
+{
+	Close( );
+
+	if( Map( p_FilePath ) != BIT_OK )
+	{
+		return BIT_ERROR;
+	}
+
+	if( m_FileSize < 12 || memcmp( m_pFile, "RIFF", 4 ) != 0 || memcmp( m_pFile + 8, "WAVE", 4 ) != 0 )
+	{
+		bitTrace( "[WaveStream::Open] Not a wave file: %s\n", p_FilePath.c_str( ) );
+		Close( );
+		return BIT_ERROR;
+	}
+
+	// Walk the chunks, the format chunk has to come before the data
+	BIT_UINT64 Offset = 12;
+	while( Offset + 8 <= m_FileSize && m_pData == BIT_NULL )
+	{
+		const BIT_UINT8 * pChunk = m_pFile + Offset;
+		const BIT_UINT32 ChunkSize = ReadUInt32( pChunk + 4 );
+
+		if( memcmp( pChunk, "fmt ", 4 ) == 0 && ChunkSize >= 16 && Offset + 8 + ChunkSize <= m_FileSize )
+		{
+			if( ReadUInt16( pChunk + 8 ) != 1 )
+			{
+				bitTrace( "[WaveStream::Open] Only PCM wave files are supported: %s\n", p_FilePath.c_str( ) );
+				Close( );
+				return BIT_ERROR;
+			}
+
+			m_ChannelCount = ReadUInt16( pChunk + 10 );
+			m_SampleRate = ReadUInt32( pChunk + 12 );
+			m_BitsPerSample = ReadUInt16( pChunk + 22 );
+			m_FrameSize = m_ChannelCount * ( m_BitsPerSample / 8 );
+		}
+		else if( memcmp( pChunk, "data", 4 ) == 0 && m_FrameSize )
+		{
+			// Truncated files play what's there
+			const BIT_UINT64 Available = m_FileSize - Offset - 8;
+			m_pData = pChunk + 8;
+			m_DataSize = static_cast< BIT_UINT32 >( ChunkSize < Available ? ChunkSize : Available );
+		}
+
+		// Chunks are padded to an even size
+		Offset += 8 + static_cast< BIT_UINT64 >( ChunkSize ) + ( ChunkSize & 1 );
+	}
+
+	if( m_pData == BIT_NULL || ( m_BitsPerSample != 8 && m_BitsPerSample != 16 ) || m_ChannelCount == 0 || m_ChannelCount > 2 )
+	{
+		bitTrace( "[WaveStream::Open] Unsupported or broken wave file: %s\n", p_FilePath.c_str( ) );
+		Close( );
+		return BIT_ERROR;
+	}
+
+	m_DataSize -= m_DataSize % m_FrameSize;
+	m_Position = 0;
+	m_ReleasedOffset = 0;
+	m_PrefetchedOffset = 0;
+	UpdateResidency( );
+
+	return BIT_OK;
+}
+
+void WaveStream::Close( )
+{
+	Unmap( );
+	m_pData = BIT_NULL;
+	m_DataSize = 0;
+	m_ChannelCount = 0;
+	m_SampleRate = 0;
+	m_BitsPerSample = 0;
+	m_FrameSize = 0;
+	m_Position = 0;
+}
+
+BIT_UINT32 WaveStream::Read( void * p_pData, const BIT_UINT32 p_FrameCount )
+{
+	if( m_pData == BIT_NULL )
+	{
+		return 0;
+	}
+
+	const BIT_UINT32 FramesLeft = GetFrameCount( ) - m_Position;
+	const BIT_UINT32 FrameCount = p_FrameCount < FramesLeft ? p_FrameCount : FramesLeft;
+	const BIT_UINT32 Offset = m_Position * m_FrameSize;
+
+	memcpy( p_pData, m_pData + Offset, FrameCount * m_FrameSize );
+	m_Position += FrameCount;
+	UpdateResidency( );
+
+	return FrameCount;
+}
+
+BIT_UINT32 WaveStream::Seek( const BIT_UINT32 p_Frame )
+{
+	if( m_pData == BIT_NULL || p_Frame > GetFrameCount( ) )
+	{
+		bitTrace( "[WaveStream::Seek] Seeking outside of the stream\n" );
+		return BIT_ERROR;
+	}
+
+	// Drop the pages around the old position and start over at the new one
+	BIT_UINT8 * pFile = const_cast< BIT_UINT8 * >( m_pFile );
+	if( m_PrefetchedOffset > m_ReleasedOffset )
+	{
+#ifdef BIT_PLATFORM_WINDOWS
+		VirtualUnlock( pFile + m_ReleasedOffset, static_cast< SIZE_T >( m_PrefetchedOffset - m_ReleasedOffset ) );
+#else
+		madvise( pFile + m_ReleasedOffset, m_PrefetchedOffset - m_ReleasedOffset, MADV_DONTNEED );
+#endif
+	}
+
+	m_Position = p_Frame;
+	const BIT_UINT64 Position = static_cast< BIT_UINT64 >( m_pData - m_pFile ) + static_cast< BIT_UINT64 >( m_Position ) * m_FrameSize;
+	m_ReleasedOffset = m_PrefetchedOffset = Position & ~static_cast< BIT_UINT64 >( ReadAheadSize - 1 );
+	UpdateResidency( );
+	return BIT_OK;
+}
+
+// Get functions
+BIT_BOOL WaveStream::IsOpen( ) const
+{
+	return m_pData != BIT_NULL;
+}
+
+BIT_UINT16 WaveStream::GetChannelCount( ) const
+{
+	return m_ChannelCount;
+}
+
+BIT_UINT32 WaveStream::GetSampleRate( ) const
+{
+	return m_SampleRate;
+}
+
+BIT_UINT16 WaveStream::GetBitsPerSample( ) const
+{
+	return m_BitsPerSample;
+}
+
+BIT_UINT32 WaveStream::GetFrameSize( ) const
+{
+	return m_FrameSize;
+}
+
+BIT_UINT32 WaveStream::GetFrameCount( ) const
+{
+	return m_FrameSize ? m_DataSize / m_FrameSize : 0;
+}
+
+BIT_UINT32 WaveStream::GetPosition( ) const
+{
+	return m_Position;
+}
+
+// Private functions
+BIT_UINT32 WaveStream::Map( const std::string & p_FilePath )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	if( ( m_FileHandle = CreateFileA( p_FilePath.c_str( ), GENERIC_READ, FILE_SHARE_READ, BIT_NULL, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, BIT_NULL ) ) == INVALID_HANDLE_VALUE )
+	{
+		m_FileHandle = BIT_NULL;
+		bitTrace( "[WaveStream::Map] Can not open the file: %s\n", p_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	LARGE_INTEGER Size;
+	if( GetFileSizeEx( m_FileHandle, &Size ) == 0 || Size.QuadPart == 0 ||
+		( m_MappingHandle = CreateFileMappingA( m_FileHandle, BIT_NULL, PAGE_READONLY, 0, 0, BIT_NULL ) ) == BIT_NULL ||
+		( m_pFile = static_cast< const BIT_UINT8 * >( MapViewOfFile( m_MappingHandle, FILE_MAP_READ, 0, 0, 0 ) ) ) == BIT_NULL )
+	{
+		bitTrace( "[WaveStream::Map] Can not map the file: %s\n", p_FilePath.c_str( ) );
+		Unmap( );
+		return BIT_ERROR;
+	}
+	m_FileSize = static_cast< BIT_UINT64 >( Size.QuadPart );
+#else
+	if( ( m_FileDescriptor = open( p_FilePath.c_str( ), O_RDONLY ) ) < 0 )
+	{
+		bitTrace( "[WaveStream::Map] Can not open the file: %s\n", p_FilePath.c_str( ) );
+		return BIT_ERROR;
+	}
+
+	struct stat Status;
+	void * pMapping = MAP_FAILED;
+	if( fstat( m_FileDescriptor, &Status ) != 0 || Status.st_size == 0 ||
+		( pMapping = mmap( BIT_NULL, Status.st_size, PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0 ) ) == MAP_FAILED )
+	{
+		bitTrace( "[WaveStream::Map] Can not map the file: %s\n", p_FilePath.c_str( ) );
+		Unmap( );
+		return BIT_ERROR;
+	}
+	m_pFile = static_cast< const BIT_UINT8 * >( pMapping );
+	m_FileSize = static_cast< BIT_UINT64 >( Status.st_size );
+	madvise( pMapping, m_FileSize, MADV_SEQUENTIAL );
+#endif
+
+	return BIT_OK;
+}
+
+void WaveStream::Unmap( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	if( m_pFile )
+	{
+		UnmapViewOfFile( m_pFile );
+	}
+	if( m_MappingHandle )
+	{
+		CloseHandle( m_MappingHandle );
+		m_MappingHandle = BIT_NULL;
+	}
+	if( m_FileHandle )
+	{
+		CloseHandle( m_FileHandle );
+		m_FileHandle = BIT_NULL;
+	}
+#else
+	if( m_pFile )
+	{
+		munmap( const_cast< BIT_UINT8 * >( m_pFile ), m_FileSize );
+	}
+	if( m_FileDescriptor >= 0 )
+	{
+		close( m_FileDescriptor );
+		m_FileDescriptor = -1;
+	}
+#endif
+
+	m_pFile = BIT_NULL;
+	m_FileSize = 0;
+}
+
+void WaveStream::UpdateResidency( )
+{
+	const BIT_UINT64 BlockMask = ~static_cast< BIT_UINT64 >( ReadAheadSize - 1 );
+	const BIT_UINT64 Position = static_cast< BIT_UINT64 >( m_pData - m_pFile ) + static_cast< BIT_UINT64 >( m_Position ) * m_FrameSize;
+	BIT_UINT8 * pFile = const_cast< BIT_UINT8 * >( m_pFile );
+
+	// Hand back the whole blocks more than a block behind the read position
+	const BIT_UINT64 ReleaseEnd = Position > ReadAheadSize ? ( Position - ReadAheadSize ) & BlockMask : 0;
+	if( ReleaseEnd > m_ReleasedOffset )
+	{
+#ifdef BIT_PLATFORM_WINDOWS
+		// Unlocking pages that aren't locked drops them from the working set
+		VirtualUnlock( pFile + m_ReleasedOffset, static_cast< SIZE_T >( ReleaseEnd - m_ReleasedOffset ) );
+#else
+		madvise( pFile + m_ReleasedOffset, ReleaseEnd - m_ReleasedOffset, MADV_DONTNEED );
+#endif
+		m_ReleasedOffset = ReleaseEnd;
+	}
+
+	// Ask for the next block once reading gets within a block of the prefetched data.
+	// Windows leaves the read ahead to the cache manager, FILE_FLAG_SEQUENTIAL_SCAN asks for it.
+	if( Position + ReadAheadSize > m_PrefetchedOffset && m_PrefetchedOffset < m_FileSize )
+	{
+		const BIT_UINT64 Start = m_PrefetchedOffset > ( Position & BlockMask ) ? m_PrefetchedOffset : ( Position & BlockMask );
+		const BIT_UINT64 End = Start + ReadAheadSize < m_FileSize ? Start + ReadAheadSize : m_FileSize;
+#ifndef BIT_PLATFORM_WINDOWS
+		madvise( pFile + Start, End - Start, MADV_WILLNEED );
+#endif
+		m_PrefetchedOffset = End;
+	}
+}
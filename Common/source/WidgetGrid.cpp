@@ -0,0 +1,306 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <WidgetGrid.hpp>
+#include <algorithm>
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Constructor/destructor
+WidgetGrid::WidgetGrid( ) :
+	m_GridSize( 0, 0 ),
+	m_CellSize( 0 ),
+	m_NextOrder( 0 ),
+	m_Count( 0 ),
+	m_RelinkCount( 0 )
+{
+}
+
+WidgetGrid::~WidgetGrid( )
+{
+}
+
+// Public functions
+BIT_UINT32 WidgetGrid::Load( const Bit::Vector2_ui32 p_AreaSize, const BIT_UINT32 p_CellSize )
+{
+	if( p_AreaSize.x == 0 || p_AreaSize.y == 0 || p_CellSize == 0 )
+	{
+		bitTrace( "[WidgetGrid::Load] The area and the cell size can not be zero\n" );
+		return BIT_ERROR;
+	}
+
+	m_CellSize = p_CellSize;
+	m_GridSize = Bit::Vector2_ui32( ( p_AreaSize.x + p_CellSize - 1 ) / p_CellSize,
+		( p_AreaSize.y + p_CellSize - 1 ) / p_CellSize );
+	Clear( );
+
+	return BIT_OK;
+}
+
+BIT_UINT32 WidgetGrid::Add( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size )
+{
+	if( m_Cells.size( ) == 0 )
+	{
+		bitTrace( "[WidgetGrid::Add] Is not loaded yet\n" );
+		return InvalidId;
+	}
+
+	// Reuse the ids of removed widgets
+	BIT_UINT32 Id = static_cast< BIT_UINT32 >( m_Entries.size( ) );
+	if( m_FreeIds.size( ) )
+	{
+		Id = m_FreeIds.back( );
+		m_FreeIds.pop_back( );
+	}
+	else
+	{
+		m_Entries.push_back( Entry( ) );
+	}
+
+	Entry & NewEntry = m_Entries[ Id ];
+	NewEntry.Position = p_Position;
+	NewEntry.Size = p_Size;
+	NewEntry.Order = m_NextOrder++;
+	NewEntry.Used = BIT_TRUE;
+	GetCellRange( p_Position, p_Size, NewEntry.CellMin, NewEntry.CellMax );
+
+	Link( Id );
+	m_Count++;
+	return Id;
+}
+
+void WidgetGrid::Move( const BIT_UINT32 p_Id, const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size )
+{
+	if( p_Id >= m_Entries.size( ) || !m_Entries[ p_Id ].Used )
+	{
+		return;
+	}
+
+	Entry & CurrentEntry = m_Entries[ p_Id ];
+	Bit::Vector2_ui32 CellMin;
+	Bit::Vector2_ui32 CellMax;
+	GetCellRange( p_Position, p_Size, CellMin, CellMax );
+
+	// Small moves stay within the same cells
+	if( CellMin.x != CurrentEntry.CellMin.x || CellMin.y != CurrentEntry.CellMin.y ||
+		CellMax.x != CurrentEntry.CellMax.x || CellMax.y != CurrentEntry.CellMax.y )
+	{
+		Unlink( p_Id );
+		CurrentEntry.CellMin = CellMin;
+		CurrentEntry.CellMax = CellMax;
+		Link( p_Id );
+		m_RelinkCount++;
+	}
+
+	CurrentEntry.Position = p_Position;
+	CurrentEntry.Size = p_Size;
+}
+
+void WidgetGrid::Remove( const BIT_UINT32 p_Id )
+{
+	if( p_Id >= m_Entries.size( ) || !m_Entries[ p_Id ].Used )
+	{
+		return;
+	}
+
+	Unlink( p_Id );
+	m_Entries[ p_Id ].Used = BIT_FALSE;
+	m_FreeIds.push_back( p_Id );
+	m_Count--;
+}
+
+BIT_UINT32 WidgetGrid::Query( const Bit::Vector2_si32 p_Point ) const
+{
+	if( m_Cells.size( ) == 0 )
+	{
+		return InvalidId;
+	}
+
+	// Points outside the area end up in the border cells, the rectangle test sorts them out
+	const std::vector< BIT_UINT32 > & Cell =
+		m_Cells[ GetCell( p_Point.y, m_GridSize.y ) * m_GridSize.x + GetCell( p_Point.x, m_GridSize.x ) ];
+
+	BIT_UINT32 Hit = InvalidId;
+	BIT_UINT32 HitOrder = 0;
+
+	for( BIT_MEMSIZE i = 0; i < Cell.size( ); i++ )
+	{
+		const Entry & CurrentEntry = m_Entries[ Cell[ i ] ];
+
+		if( p_Point.x >= CurrentEntry.Position.x && p_Point.y >= CurrentEntry.Position.y &&
+			p_Point.x < CurrentEntry.Position.x + static_cast< BIT_SINT32 >( CurrentEntry.Size.x ) &&
+			p_Point.y < CurrentEntry.Position.y + static_cast< BIT_SINT32 >( CurrentEntry.Size.y ) &&
+			( Hit == InvalidId || CurrentEntry.Order > HitOrder ) )
+		{
+			Hit = Cell[ i ];
+			HitOrder = CurrentEntry.Order;
+		}
+	}
+
+	return Hit;
+}
+
+void WidgetGrid::Query( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size, std::vector< BIT_UINT32 > & p_Ids ) const
+{
+	p_Ids.clear( );
+
+	if( m_Cells.size( ) == 0 || p_Size.x == 0 || p_Size.y == 0 )
+	{
+		return;
+	}
+
+	Bit::Vector2_ui32 CellMin;
+	Bit::Vector2_ui32 CellMax;
+	GetCellRange( p_Position, p_Size, CellMin, CellMax );
+
+	// Sort keys, the order in the high bits and the id in the low bits
+	std::vector< BIT_UINT64 > Keys;
+
+	for( BIT_UINT32 y = CellMin.y; y <= CellMax.y; y++ )
+	{
+		for( BIT_UINT32 x = CellMin.x; x <= CellMax.x; x++ )
+		{
+			const std::vector< BIT_UINT32 > & Cell = m_Cells[ y * m_GridSize.x + x ];
+
+			for( BIT_MEMSIZE i = 0; i < Cell.size( ); i++ )
+			{
+				const Entry & CurrentEntry = m_Entries[ Cell[ i ] ];
+
+				// A widget covering several cells is only listed by the first shared cell
+				if( x != std::max( CellMin.x, CurrentEntry.CellMin.x ) || y != std::max( CellMin.y, CurrentEntry.CellMin.y ) )
+				{
+					continue;
+				}
+
+				if( p_Position.x < CurrentEntry.Position.x + static_cast< BIT_SINT32 >( CurrentEntry.Size.x ) &&
+					p_Position.y < CurrentEntry.Position.y + static_cast< BIT_SINT32 >( CurrentEntry.Size.y ) &&
+					CurrentEntry.Position.x < p_Position.x + static_cast< BIT_SINT32 >( p_Size.x ) &&
+					CurrentEntry.Position.y < p_Position.y + static_cast< BIT_SINT32 >( p_Size.y ) )
+				{
+					Keys.push_back( ( static_cast< BIT_UINT64 >( CurrentEntry.Order ) << 32 ) | Cell[ i ] );
+				}
+			}
+		}
+	}
+
+	std::sort( Keys.begin( ), Keys.end( ) );
+
+	p_Ids.resize( Keys.size( ) );
+	for( BIT_MEMSIZE i = 0; i < Keys.size( ); i++ )
+	{
+		p_Ids[ i ] = static_cast< BIT_UINT32 >( Keys[ i ] & 0xFFFFFFFF );
+	}
+}
+
+void WidgetGrid::Clear( )
+{
+	m_Cells.clear( );
+	m_Cells.resize( m_GridSize.x * m_GridSize.y );
+	m_Entries.clear( );
+	m_FreeIds.clear( );
+	m_NextOrder = 0;
+	m_Count = 0;
+	m_RelinkCount = 0;
+}
+
+// Get functions
+BIT_UINT32 WidgetGrid::GetCount( ) const
+{
+	return m_Count;
+}
+
+BIT_UINT32 WidgetGrid::GetCellSize( ) const
+{
+	return m_CellSize;
+}
+
+Bit::Vector2_ui32 WidgetGrid::GetGridSize( ) const
+{
+	return m_GridSize;
+}
+
+BIT_UINT32 WidgetGrid::GetRelinkCount( ) const
+{
+	return m_RelinkCount;
+}
+
+// Private functions
+void WidgetGrid::GetCellRange( const Bit::Vector2_si32 p_Position, const Bit::Vector2_ui32 p_Size,
+	Bit::Vector2_ui32 & p_Min, Bit::Vector2_ui32 & p_Max ) const
+{
+	// The last pixel of the rectangle decides the last cell, empty rectangles cover a single cell
+	const BIT_SINT32 EndX = p_Position.x + ( p_Size.x ? static_cast< BIT_SINT32 >( p_Size.x ) - 1 : 0 );
+	const BIT_SINT32 EndY = p_Position.y + ( p_Size.y ? static_cast< BIT_SINT32 >( p_Size.y ) - 1 : 0 );
+
+	p_Min = Bit::Vector2_ui32( GetCell( p_Position.x, m_GridSize.x ), GetCell( p_Position.y, m_GridSize.y ) );
+	p_Max = Bit::Vector2_ui32( GetCell( EndX, m_GridSize.x ), GetCell( EndY, m_GridSize.y ) );
+}
+
+BIT_UINT32 WidgetGrid::GetCell( const BIT_SINT32 p_Coordinate, const BIT_UINT32 p_Count ) const
+{
+	if( p_Coordinate < 0 )
+	{
+		return 0;
+	}
+
+	const BIT_UINT32 Cell = static_cast< BIT_UINT32 >( p_Coordinate ) / m_CellSize;
+	return Cell < p_Count ? Cell : p_Count - 1;
+}
+
+void WidgetGrid::Link( const BIT_UINT32 p_Id )
+{
+	const Entry & CurrentEntry = m_Entries[ p_Id ];
+
+	for( BIT_UINT32 y = CurrentEntry.CellMin.y; y <= CurrentEntry.CellMax.y; y++ )
+	{
+		for( BIT_UINT32 x = CurrentEntry.CellMin.x; x <= CurrentEntry.CellMax.x; x++ )
+		{
+			m_Cells[ y * m_GridSize.x + x ].push_back( p_Id );
+		}
+	}
+}
+
+void WidgetGrid::Unlink( const BIT_UINT32 p_Id )
+{
+	const Entry & CurrentEntry = m_Entries[ p_Id ];
+
+	// The order within a cell doesn't matter, swap with the last id
+	for( BIT_UINT32 y = CurrentEntry.CellMin.y; y <= CurrentEntry.CellMax.y; y++ )
+	{
+		for( BIT_UINT32 x = CurrentEntry.CellMin.x; x <= CurrentEntry.CellMax.x; x++ )
+		{
+			std::vector< BIT_UINT32 > & Cell = m_Cells[ y * m_GridSize.x + x ];
+			for( BIT_MEMSIZE i = 0; i < Cell.size( ); i++ )
+			{
+				if( Cell[ i ] == p_Id )
+				{
+					Cell[ i ] = Cell.back( );
+					Cell.pop_back( );
+					break;
+				}
+			}
+		}
+	}
+}
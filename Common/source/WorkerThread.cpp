@@ -0,0 +1,149 @@
+// ///////////////////////////////////////////////////////////////////////////
+// Copyright (C) 2013 Jimmie Bergmann - jimmiebergmann@gmail.com
+//
+// This software is provided 'as-is', without any express or
+// implied warranty. In no event will the authors be held
+// liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute
+// it freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented;
+//    you must not claim that you wrote the original software.
+//    If you use this software in a product, an acknowledgment
+//    in the product documentation would be appreciated but
+//    is not required.
+//
+// 2. Altered source versions must be plainly marked as such,
+//    and must not be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any
+//    source distribution.
+// ///////////////////////////////////////////////////////////////////////////
+
+
+#include <WorkerThread.hpp>
+#ifdef BIT_PLATFORM_WINDOWS
+	#include <windows.h>
+#endif
+#include <Bit/System/Debugger.hpp>
+#include <Bit/System/MemoryLeak.hpp>
+
+// Mutex
+Mutex::Mutex( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	CRITICAL_SECTION * pCriticalSection = new CRITICAL_SECTION;
+	InitializeCriticalSection( pCriticalSection );
+	m_pCriticalSection = pCriticalSection;
+#else
+	pthread_mutex_init( &m_Mutex, BIT_NULL );
+#endif
+}
+
+Mutex::~Mutex( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	CRITICAL_SECTION * pCriticalSection = static_cast< CRITICAL_SECTION * >( m_pCriticalSection );
+	DeleteCriticalSection( pCriticalSection );
+	delete pCriticalSection;
+#else
+	pthread_mutex_destroy( &m_Mutex );
+#endif
+}
+
+void Mutex::Lock( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	EnterCriticalSection( static_cast< CRITICAL_SECTION * >( m_pCriticalSection ) );
+#else
+	pthread_mutex_lock( &m_Mutex );
+#endif
+}
+
+void Mutex::Unlock( )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	LeaveCriticalSection( static_cast< CRITICAL_SECTION * >( m_pCriticalSection ) );
+#else
+	pthread_mutex_unlock( &m_Mutex );
+#endif
+}
+
+// Worker thread, constructor/destructor
+WorkerThread::WorkerThread( ) :
+	m_Function( BIT_NULL ),
+	m_pUserData( BIT_NULL ),
+	m_Running( BIT_FALSE )
+{
+#ifdef BIT_PLATFORM_WINDOWS
+	m_Handle = BIT_NULL;
+#endif
+}
+
+WorkerThread::~WorkerThread( )
+{
+	Join( );
+}
+
+// Public functions
+BIT_UINT32 WorkerThread::Start( Function p_Function, void * p_pUserData )
+{
+	if( m_Running )
+	{
+		bitTrace( "[WorkerThread::Start] The thread is already running\n" );
+		return BIT_ERROR;
+	}
+
+	m_Function = p_Function;
+	m_pUserData = p_pUserData;
+
+#ifdef BIT_PLATFORM_WINDOWS
+	if( ( m_Handle = CreateThread( BIT_NULL, 0, Entry, this, 0, BIT_NULL ) ) == BIT_NULL )
+#else
+	if( pthread_create( &m_Thread, BIT_NULL, Entry, this ) != 0 )
+#endif
+	{
+		bitTrace( "[WorkerThread::Start] Can not create the thread\n" );
+		return BIT_ERROR;
+	}
+
+	m_Running = BIT_TRUE;
+	return BIT_OK;
+}
+
+void WorkerThread::Join( )
+{
+	if( !m_Running )
+	{
+		return;
+	}
+
+#ifdef BIT_PLATFORM_WINDOWS
+	WaitForSingleObject( m_Handle, INFINITE );
+	CloseHandle( m_Handle );
+	m_Handle = BIT_NULL;
+#else
+	pthread_join( m_Thread, BIT_NULL );
+#endif
+	m_Running = BIT_FALSE;
+}
+
+// Get functions
+BIT_BOOL WorkerThread::IsRunning( ) const
+{
+	return m_Running;
+}
+
+// Static functions
+#ifdef BIT_PLATFORM_WINDOWS
+unsigned long __stdcall WorkerThread::Entry( void * p_pThread )
+#else
+void * WorkerThread::Entry( void * p_pThread )
+#endif
+{
+	WorkerThread * pThread = static_cast< WorkerThread * >( p_pThread );
+	pThread->m_Function( pThread->m_pUserData );
+	return 0;
+}
@@ -12,20 +12,27 @@
 #include <Bit/System/Debugger.hpp>
 #include <Bit/System/MemoryLeak.hpp>
 #include <Camera.hpp>
+#include <FrameUniformBlock.hpp>
+#include <RenderGraph.hpp>
+#include <ShaderPermutations.hpp>
+#include <GUIManager.hpp>
+#include <TextRenderer.hpp>
+#include <PerformanceHUD.hpp>
+#include <fstream>
 
 // Window/graphic device
 Bit::Window * pWindow = BIT_NULL;
 Bit::GraphicDevice * pGraphicDevice = BIT_NULL;
 
-// Level variables
+// Level variables, the shadow filter and the fog are compiled into shader variants
 const std::string LevelModelPath = "../../../Data/Level.obj";
 Bit::Model * pLevelModel = BIT_NULL;
-Bit::Texture * pLevelColorTexture = BIT_NULL;
-Bit::Texture * pLevelDepthTexture = BIT_NULL;
-Bit::Framebuffer * pLevelFramebuffer = BIT_NULL;
-Bit::ShaderProgram * pLevelShaderProgram = BIT_NULL;
-Bit::Shader * pLevelVertexShader = BIT_NULL;
-Bit::Shader * pLevelFragmentShader = BIT_NULL;
+ShaderPermutations * pLevelPermutations = BIT_NULL;
+BIT_UINT32 LevelFeature_ShadowPCF = 0;
+BIT_UINT32 LevelFeature_ShadowPCFWide = 0;
+BIT_UINT32 LevelFeature_Fog = 0;
+const BIT_UINT32 LevelFrameMembers = FrameUniformBlock::Member_ProjectionMatrix | FrameUniformBlock::Member_ViewMatrix |
+	FrameUniformBlock::Member_LightMatrix | FrameUniformBlock::Member_LightPosition;
 
 // Camera variables
 Camera ViewCamera;
@@ -44,14 +51,39 @@ Bit::Framebuffer * pShadowFramebuffer = BIT_NULL;
 Bit::ShaderProgram * pShadowShaderProgram = BIT_NULL;
 Bit::Shader * pShadowVertexShader = BIT_NULL;
 Bit::Shader * pShadowFragmentShader = BIT_NULL;
+ShaderUniforms * pShadowUniforms = BIT_NULL;
+const BIT_UINT32 ShadowFrameMembers = FrameUniformBlock::Member_ShadowMatrix;
 Bit::Vector3_f32 LightPosition( 24.0f, 11.0f, 9.0f );
 Bit::Vector3_f32 LightDirection( -0.817f, -0.508f, -0.271f );
 Bit::Matrix4x4 ShadowViewMatrix;
 Bit::Matrix4x4 BiasMatrix;
 
+// Uniform variables
+FrameUniformBlock FrameUniforms;
+
+// Render graph, the level color and depth textures are transient
+RenderGraph * pRenderGraph = BIT_NULL;
+BIT_UINT32 LevelColorHandle = RenderGraph::InvalidHandle;
+
+// Performance overlay, the counters are collected while rendering the frame
+GUIManager * GUI = BIT_NULL;
+TextRenderer * Text = BIT_NULL;
+PerformanceHUD * HUD = BIT_NULL;
+PerformanceHUD::Counters FrameCounters;
+BIT_UINT32 LevelTriangleCount = 0;
+
 // Setting varialbes
 const Bit::Vector2_ui32 WindowSize( 1024, 768 );
 BIT_BOOL UseNormalMapping = BIT_TRUE;
+enum eShadowFilter
+{
+	ShadowFilter_None = 0,
+	ShadowFilter_PCF = 1,
+	ShadowFilter_PCFWide = 2
+};
+BIT_UINT32 ShadowFilter = ShadowFilter_PCFWide;
+const char * ShadowFilterNames[ 3 ] = { "no", "3x3 PCF", "11x11 PCF" };
+BIT_BOOL UseFog = BIT_FALSE;
 
 
 // Global functions
@@ -61,10 +93,17 @@ BIT_UINT32 CreateWindow( );
 BIT_UINT32 CreateGraphicDevice( );
 BIT_UINT32 LoadMatrices( );
 BIT_UINT32 LoadLevelData( );
+void SetupLevelProgram( ShaderPermutations::Permutation & p_Permutation, void * p_pUserData );
+BIT_UINT32 GetLevelPermutationKey( );
 BIT_UINT32 LoadFullscreenData( );
 BIT_UINT32 LoadShadowData( );
 BIT_UINT32 InitializeShadowMap( );
+BIT_UINT32 BuildRenderGraph( );
+void ExecuteLevelPass( RenderGraph & p_Graph, void * p_pUserData );
+void ExecuteFullscreenPass( RenderGraph & p_Graph, void * p_pUserData );
 void Render( );
+BIT_UINT32 CountLevelTriangles( );
+BIT_UINT32 CreatePerformanceHUD( );
 
 // Main function
 int main( int argc, char ** argv )
@@ -85,7 +124,9 @@ int main( int argc, char ** argv )
 		LoadLevelData( ) != BIT_OK ||
 		LoadFullscreenData( ) != BIT_OK ||
 		LoadShadowData( ) != BIT_OK ||
-		InitializeShadowMap( ) != BIT_OK )
+		InitializeShadowMap( ) != BIT_OK ||
+		BuildRenderGraph( ) != BIT_OK ||
+		CreatePerformanceHUD( ) != BIT_OK )
 	{
 		return CloseApplication( 0 );
 	}
@@ -209,6 +250,32 @@ int main( int argc, char ** argv )
 							pShaderProgram_Model->Unbind( );*/
 						}
 						break;
+						case Bit::Keyboard::Key_F:
+						{
+							// Cycle the shadow filters, the next frame picks the matching shader variant
+							ShadowFilter = ( ShadowFilter + 1 ) % 3;
+							bitTrace( "Using %s shadow filtering.\n", ShadowFilterNames[ ShadowFilter ] );
+						}
+						break;
+						case Bit::Keyboard::Key_O:
+						{
+							UseFog = !UseFog;
+							bitTrace( "Fog: %s.\n", UseFog ? "on" : "off" );
+						}
+						break;
+						case Bit::Keyboard::Key_T:
+						{
+							// GPU pass timings for the overlay, they stall the GPU after every pass
+							pRenderGraph->SetTimingEnabled( !pRenderGraph->GetTimingEnabled( ) );
+							pRenderGraph->ResetTimings( );
+							bitTrace( "Pass timings: %s.\n", pRenderGraph->GetTimingEnabled( ) ? "on" : "off" );
+						}
+						break;
+						case Bit::Keyboard::Key_U:
+						{
+							HUD->SetVisible( !HUD->GetVisible( ) );
+						}
+						break;
 
 						// Exit keys
 						case Bit::Keyboard::Key_Escape:
@@ -268,41 +335,20 @@ int main( int argc, char ** argv )
 		}
 
 
-		// ///////////////////////////////////////////////////
-		// Render the level to the level framebuffer
-		pLevelFramebuffer->Bind( );
-		pGraphicDevice->EnableDepthTest( );
-		pGraphicDevice->ClearColor( );
-		pGraphicDevice->ClearDepth( );
-
-		// Bind the level model shader program
-		pLevelShaderProgram->Bind( );
-		pShadowDepthTexture->Bind( 0 );
-
 		// Update the camera if needed
 		if( ViewCamera.Update( DeltaTime ) )
 		{
-			pLevelShaderProgram->SetUniformMatrix4x4f( "ViewMatrix", ViewCamera.GetMatrix( ) );
+			FrameUniforms.SetViewMatrix( ViewCamera.GetMatrix( ) );
 		}
 
-		// Render the model
-		pLevelModel->Render( Bit::VertexObject::RenderMode_Triangles );
+		// Render the level and the fullscreen quad
+		FrameCounters = PerformanceHUD::Counters( );
+		pRenderGraph->Execute( );
+		FrameCounters.Memory = pRenderGraph->GetPeakMemory( );
+		HUD->Update( DeltaTime * 1000.0f, FrameCounters, pRenderGraph );
 
-		// Unbind the level model shader program
-		pLevelShaderProgram->Unbind( );
-
-
-		// ///////////////////////////////////////////////////
-		// Render the fullscreen quad
-		pGraphicDevice->BindDefaultFramebuffer( );
-		pGraphicDevice->DisableDepthTest( );
-		pGraphicDevice->ClearColor( );
-
-		// Bind the fullscreen shader program
-		pFullscreenShaderProgram->Bind( );
-		pLevelColorTexture->Bind( 0 );
-		pFullscreenVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
-		pFullscreenShaderProgram->Unbind( );
+		// Render the performance overlay
+		HUD->Render( );
 
 		// Present the buffers
 		pGraphicDevice->Present( );
@@ -318,6 +364,19 @@ int CloseApplication( const int p_Code )
 	// Release the resource manager
 	Bit::ResourceManager::Release( );
 
+	if( pLevelPermutations )
+	{
+		bitTrace( "Level shader: %u variants compiled in %.3f ms.\n",
+			pLevelPermutations->GetPermutationCount( ), pLevelPermutations->GetCompileTime( ) );
+		delete pLevelPermutations;
+		pLevelPermutations = BIT_NULL;
+	}
+
+	if( pShadowUniforms )
+	{
+		delete pShadowUniforms;
+		pShadowUniforms = BIT_NULL;
+	}
 
 	if( pShadowDepthTexture )
 	{
@@ -373,40 +432,28 @@ int CloseApplication( const int p_Code )
 		pFullscreenVertexObject = BIT_NULL;
 	}
 
-	if( pLevelFragmentShader )
-	{
-		delete pLevelFragmentShader;
-		pLevelFragmentShader = BIT_NULL;
-	}
-
-	if( pLevelVertexShader )
-	{
-		delete pLevelVertexShader;
-		pLevelVertexShader = BIT_NULL;
-	}
-
-	if( pLevelShaderProgram )
+	if( HUD )
 	{
-		delete pLevelShaderProgram;
-		pLevelShaderProgram = BIT_NULL;
+		delete HUD;
+		HUD = BIT_NULL;
 	}
 
-	if( pLevelColorTexture )
+	if( Text )
 	{
-		delete pLevelColorTexture;
-		pLevelColorTexture = BIT_NULL;
+		delete Text;
+		Text = BIT_NULL;
 	}
 
-	if( pLevelDepthTexture )
+	if( GUI )
 	{
-		delete pLevelDepthTexture;
-		pLevelDepthTexture = BIT_NULL;
+		delete GUI;
+		GUI = BIT_NULL;
 	}
 
-	if( pLevelFramebuffer )
+	if( pRenderGraph )
 	{
-		delete pLevelFramebuffer;
-		pLevelFramebuffer = BIT_NULL;
+		delete pRenderGraph;
+		pRenderGraph = BIT_NULL;
 	}
 
 	if( pLevelModel )
@@ -530,6 +577,12 @@ BIT_UINT32 LoadMatrices( )
 	ShadowViewMatrix.Identity( );
 	ShadowViewMatrix.LookAt( LightPosition, LightDirection, Bit::Vector3_f32( 0.0f, 1.0f, 0.0f ) );
 
+	// Frame uniforms
+	FrameUniforms.SetProjectionMatrix( Bit::MatrixManager::GetMatrix( Bit::MatrixManager::Mode_Projection ) );
+	FrameUniforms.SetLightMatrices( BiasMatrix, Bit::MatrixManager::GetMatrix( Bit::MatrixManager::Mode_Projection ),
+		ShadowViewMatrix );
+	FrameUniforms.SetLightPosition( LightPosition );
+
 	// Initialize the camera
 	InitializeCamera( );
 
@@ -554,6 +607,7 @@ void InitializeCamera( )
 	// Set the matrix to the matrix manager
 	Bit::MatrixManager::SetMode( Bit::MatrixManager::Mode_ModelView );
 	Bit::MatrixManager::SetMatrix( ViewCamera.GetMatrix( ) );
+	FrameUniforms.SetViewMatrix( ViewCamera.GetMatrix( ) );
 
 }
 
@@ -603,65 +657,6 @@ BIT_UINT32 LoadLevelData( )
 
 
 
-	// Level textures / framebuffer
-
-	if( ( pLevelColorTexture = pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
-	{
-		bitTrace( "[Error] Can not create the level color texture\n" );
-		return BIT_ERROR;
-	}
-	if( ( pLevelDepthTexture = pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
-	{
-		bitTrace( "[Error] Can not create the level depth texture\n" );
-		return BIT_ERROR;
-	}
-
-
-	// Load the level textures
-	if( pLevelColorTexture->Load( WindowSize, Bit::RGB, Bit::RGB, Bit::Type_UChar8, BIT_NULL ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not load the level color texture\n" );
-		return BIT_ERROR;
-	}
-	if( pLevelDepthTexture->Load( WindowSize, Bit::Depth, Bit::Depth, Bit::Type_Float32, BIT_NULL ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not load the level depth texture\n" );
-		return BIT_ERROR;
-	}
-
-	if( pLevelColorTexture->SetFilters( TextureFilters ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not set the level color texture filters\n" );
-		return BIT_ERROR;
-	}
-	if( pLevelDepthTexture->SetFilters( TextureFilters ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not set the level depth texture filters\n" );
-		return BIT_ERROR;
-	}
-
-
-
-	// Create the shadow framebuffer
-	if( ( pLevelFramebuffer = pGraphicDevice->CreateFramebuffer( ) ) == BIT_NULL )
-	{
-		bitTrace( "[Error] Can not create the level framebuffer\n" );
-		return BIT_ERROR;
-	}
-
-	// Attach the depth shadow texture to the framebuffer
-	if( pLevelFramebuffer->Attach( pLevelColorTexture ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not attach the color texture to the level framebuffer\n" );
-		return BIT_ERROR;
-	}
-	if( pLevelFramebuffer->Attach( pLevelDepthTexture ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not attach the depth texture to the level framebuffer\n" );
-		return BIT_ERROR;
-	}
-
-
 	// Level shaders
 
 	// Shader sources
@@ -675,14 +670,17 @@ BIT_UINT32 LoadLevelData( )
 		"out vec3 out_Position; \n"
 		"out vec3 out_Normal; \n"
 
-		"uniform mat4 BiasMatrix; \n"
 		"uniform mat4 ProjectionMatrix; \n"
 		"uniform mat4 ViewMatrix; \n"
-		"uniform mat4 ShadowViewMatrix; \n"
+		"uniform mat4 LightMatrix; \n"
 
 		// Shadow data
 		"out vec4 LightVertexPosition; \n"
 
+		"#ifdef FOG \n"
+		"out float out_ViewDepth; \n"
+		"#endif \n"
+
 		"void main(void) \n"
 		"{ \n"
 
@@ -691,11 +689,17 @@ BIT_UINT32 LoadLevelData( )
 		"	out_Normal = normalize( Normal ); \n"
 
 		// Set position and shadow light position
-		"	LightVertexPosition = BiasMatrix * ProjectionMatrix * ShadowViewMatrix * vec4( Position, 1.0 ); \n"
-		"	gl_Position = ProjectionMatrix * ViewMatrix * vec4( Position, 1.0 ); \n"
+		"	LightVertexPosition = LightMatrix * vec4( Position, 1.0 ); \n"
+		"	vec4 ViewPosition = ViewMatrix * vec4( Position, 1.0 ); \n"
+		"	gl_Position = ProjectionMatrix * ViewPosition; \n"
+
+		"#ifdef FOG \n"
+		"	out_ViewDepth = -ViewPosition.z; \n"
+		"#endif \n"
 
 		"} \n";
 
+	// The shadow filter is one of none, SHADOW_FILTER_PCF or SHADOW_FILTER_PCF_WIDE
 	static const std::string FragmentSource =
 		"#version 330 \n"
 		"precision highp float; \n"
@@ -710,6 +714,11 @@ BIT_UINT32 LoadLevelData( )
 		"uniform sampler2D ShadowTexture; \n"
 		"in vec4 LightVertexPosition; \n"
 
+		"#ifdef FOG \n"
+		"in float out_ViewDepth; \n"
+		"uniform vec3 FogColor; \n"
+		"uniform float FogDensity; \n"
+		"#endif \n"
 
 		"void main(void) \n"
 		"{ \n"
@@ -718,6 +727,20 @@ BIT_UINT32 LoadLevelData( )
 		"	vec4 LightVertexPosition2 = LightVertexPosition; \n"
 		"	LightVertexPosition2 /= LightVertexPosition2.w; \n"
 
+		"#if defined( SHADOW_FILTER_PCF ) \n"
+		"	vec2 TexelSize = 1.0 / vec2( textureSize( ShadowTexture, 0 ) ); \n"
+		"	float ShadowValue = 0.0; \n"
+		"	for( int x = -1; x <= 1; x++ ) \n"
+		"	{ \n"
+		"		for( int y = -1; y <= 1; y++ ) \n"
+		"		{ \n"
+		"			ShadowValue += step( LightVertexPosition2.z, \n"
+		"				texture2D( ShadowTexture, LightVertexPosition2.xy + vec2( x, y ) * TexelSize ).r ); \n"
+		"		} \n"
+		"	} \n"
+		"	ShadowValue /= 9.0; \n"
+
+		"#elif defined( SHADOW_FILTER_PCF_WIDE ) \n"
 		"	float ShadowValue = 0.0; \n"
 
 		"	for( float x = -0.0005; x <= 0.0005; x += 0.0001 ) \n"
@@ -736,90 +759,74 @@ BIT_UINT32 LoadLevelData( )
 
 		"	ShadowValue /= 100.0; \n"
 
+		"#else \n"
+		"	float ShadowValue = step( LightVertexPosition2.z, texture2D( ShadowTexture, LightVertexPosition2.xy ).r ); \n"
+		"#endif \n"
+
 
 		"	vec3 LightDirection = normalize( vec3( LightPosition - out_Position ) ); \n"
 		"	float Light = max( dot( out_Normal, LightDirection ) , 0.0f ); \n"
 		"	vec4 LightVector = vec4( Light, Light, Light, 1.0 ); \n"
 		// Set the output color
 		"	out_Color = vec4( ShadowValue, ShadowValue, ShadowValue, 1.0 ) * LightVector; \n"
+
+		"#ifdef FOG \n"
+		"	out_Color.rgb = mix( FogColor, out_Color.rgb, exp( -out_ViewDepth * FogDensity ) ); \n"
+		"#endif \n"
 		"} \n";
 
-	// Load the shaders
-	// Create the vertex and fragment shaders
-	if( ( pLevelVertexShader = pGraphicDevice->CreateShader( Bit::Shader::Vertex ) ) == BIT_NULL )
-	{
-		bitTrace( "[Error] Can not create the level vertex shader\n" );
-		return BIT_ERROR;
-	}
-	if( ( pLevelFragmentShader = pGraphicDevice->CreateShader( Bit::Shader::Fragment ) ) == BIT_NULL )
-	{
-		bitTrace( "[Error] Can not create the level vertex shader\n" );
-		return BIT_ERROR;
-	}
+	// Create the permutations, the variants are compiled the first time they are rendered
+	pLevelPermutations = new ShaderPermutations( pGraphicDevice, "Level" );
+	pLevelPermutations->SetSources( VertexSource, FragmentSource );
+	pLevelPermutations->SetSetupFunction( SetupLevelProgram, BIT_NULL );
+	LevelFeature_ShadowPCF = pLevelPermutations->AddFeature( "SHADOW_FILTER_PCF" );
+	LevelFeature_ShadowPCFWide = pLevelPermutations->AddFeature( "SHADOW_FILTER_PCF_WIDE" );
+	LevelFeature_Fog = pLevelPermutations->AddFeature( "FOG" );
 
-	// Set the sources
-	pLevelVertexShader->SetSource( VertexSource );
-	pLevelFragmentShader->SetSource( FragmentSource );
+	// Set attribute locations
+	pLevelPermutations->AddAttribute( "Position", 0 );
+	pLevelPermutations->AddAttribute( "Normal", 1 );
 
-	// Compile the shaders
-	if( pLevelVertexShader->Compile( ) != BIT_OK )
+	// Compile the variant of the current settings right away to catch errors early
+	if( pLevelPermutations->Get( GetLevelPermutationKey( ) ) == BIT_NULL )
 	{
-		bitTrace( "[Error] Can not compile the level vertex shader\n" );
-		return BIT_ERROR;
-	}
-	if( pLevelFragmentShader->Compile( ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not compile the level fragment shader\n" );
+		bitTrace( "[Error] Can not compile the level shader\n" );
 		return BIT_ERROR;
 	}
 
+	return BIT_OK;
+}
 
-	// Create the shader program
-	if( ( pLevelShaderProgram = pGraphicDevice->CreateShaderProgram( ) ) == BIT_NULL )
+void SetupLevelProgram( ShaderPermutations::Permutation & p_Permutation, void * /* p_pUserData */ )
+{
+	p_Permutation.pShaderProgram->SetUniform1i( "ShadowTexture", 0 );
+
+	if( p_Permutation.Key & LevelFeature_Fog )
 	{
-		bitTrace( "[Error] Can not create the level shader program\n" );
-		return BIT_ERROR;
+		p_Permutation.pShaderProgram->SetUniform3f( "FogColor", 0.5f, 0.5f, 0.55f );
+		p_Permutation.pShaderProgram->SetUniform1f( "FogDensity", 0.03f );
 	}
+}
 
-	// Attach the shaders
-	if( pLevelShaderProgram->AttachShaders( pLevelVertexShader ) != BIT_OK )
+BIT_UINT32 GetLevelPermutationKey( )
+{
+	BIT_UINT32 Key = 0;
+
+	if( ShadowFilter == ShadowFilter_PCF )
 	{
-		bitTrace( "[Error] Can not attach the level vertex shader\n" );
-		return BIT_ERROR;
+		Key |= LevelFeature_ShadowPCF;
 	}
-	if( pLevelShaderProgram->AttachShaders( pLevelFragmentShader ) != BIT_OK )
+	else if( ShadowFilter == ShadowFilter_PCFWide )
 	{
-		bitTrace( "[Error] Can not attach the level fragment shader\n" );
-		return BIT_ERROR;
+		Key |= LevelFeature_ShadowPCFWide;
 	}
 
-	// Set attribute locations
-	pLevelShaderProgram->SetAttributeLocation( "Position", 0 );
-	pLevelShaderProgram->SetAttributeLocation( "Normal", 1 );
-
-
-	// Link the shaders
-	if( pLevelShaderProgram->Link( ) != BIT_OK )
+	if( UseFog )
 	{
-		bitTrace( "[Error] Can not link the level shader program\n" );
-		return BIT_ERROR;
+		Key |= LevelFeature_Fog;
 	}
 
-	// Set uniforms
-	pLevelShaderProgram->Bind( );
-
-	pLevelShaderProgram->SetUniformMatrix4x4f( "BiasMatrix", BiasMatrix );
-	pLevelShaderProgram->SetUniformMatrix4x4f( "ProjectionMatrix",
-		Bit::MatrixManager::GetMatrix( Bit::MatrixManager::Mode_Projection ) );
-	pLevelShaderProgram->SetUniformMatrix4x4f( "ViewMatrix",
-		Bit::MatrixManager::GetMatrix( Bit::MatrixManager::Mode_ModelView ) );
-	pLevelShaderProgram->SetUniformMatrix4x4f( "ShadowViewMatrix", ShadowViewMatrix );
-	pLevelShaderProgram->SetUniform1i( "ShadowTexture", 0 );
-	pLevelShaderProgram->SetUniform3f( "LightPosition", LightPosition.x, LightPosition.y, LightPosition.z );
-
-	pLevelShaderProgram->Unbind( );
-
-	return BIT_OK;
+	return Key;
 }
 
 BIT_UINT32 LoadFullscreenData( )
@@ -1054,14 +1061,13 @@ BIT_UINT32 LoadShadowData( )
 		"precision highp float; \n"
 
 		"in vec3 Position; \n"
-		"uniform mat4 ProjectionMatrix; \n"
-		"uniform mat4 ViewMatrix; \n"
+		"uniform mat4 ShadowMatrix; \n"
 
 		"void main(void) \n"
 		"{ \n"
 
 		// Set the output position
-		"	gl_Position = ProjectionMatrix * ViewMatrix * vec4( Position, 1.0 ); \n"
+		"	gl_Position = ShadowMatrix * vec4( Position, 1.0 ); \n"
 
 		"} \n";
 
@@ -1136,10 +1142,9 @@ BIT_UINT32 LoadShadowData( )
 	}
 
 	// Set uniforms
+	pShadowUniforms = new ShaderUniforms( pShadowShaderProgram );
 	pShadowShaderProgram->Bind( );
-	pShadowShaderProgram->SetUniformMatrix4x4f( "ProjectionMatrix",
-		Bit::MatrixManager::GetMatrix( Bit::MatrixManager::Mode_Projection ) );
-	pShadowShaderProgram->SetUniformMatrix4x4f( "ViewMatrix", ShadowViewMatrix );
+	FrameUniforms.Apply( *pShadowUniforms, ShadowFrameMembers );
 	pShadowShaderProgram->Unbind( );
 
 
@@ -1168,3 +1173,142 @@ BIT_UINT32 InitializeShadowMap( )
 
 	return BIT_OK;
 }
+
+BIT_UINT32 BuildRenderGraph( )
+{
+	pRenderGraph = new RenderGraph( pGraphicDevice, WindowSize );
+
+	// The shadow map is rendered once at startup, the graph only reads it
+	const BIT_UINT32 ShadowDepth = pRenderGraph->ImportTexture( "ShadowDepth", pShadowDepthTexture,
+		RenderGraph::TextureDescription( WindowSize, RenderGraph::Format_Depth32F, BIT_FALSE ) );
+	LevelColorHandle = pRenderGraph->CreateTexture( "LevelColor",
+		RenderGraph::TextureDescription( WindowSize, RenderGraph::Format_RGB8, BIT_FALSE ) );
+	const BIT_UINT32 LevelDepth = pRenderGraph->CreateTexture( "LevelDepth",
+		RenderGraph::TextureDescription( WindowSize, RenderGraph::Format_Depth32F, BIT_FALSE ) );
+
+	// Level pass
+	const BIT_UINT32 LevelPass = pRenderGraph->AddPass( "Level", ExecuteLevelPass, BIT_NULL );
+	pRenderGraph->Read( LevelPass, ShadowDepth );
+	pRenderGraph->Write( LevelPass, LevelColorHandle );
+	pRenderGraph->Write( LevelPass, LevelDepth );
+
+	// Fullscreen pass
+	const BIT_UINT32 FullscreenPass = pRenderGraph->AddPass( "Fullscreen", ExecuteFullscreenPass, BIT_NULL, BIT_TRUE );
+	pRenderGraph->Read( FullscreenPass, LevelColorHandle );
+
+	if( pRenderGraph->Compile( ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not compile the render graph\n" );
+		return BIT_ERROR;
+	}
+
+	pRenderGraph->PrintStatistics( );
+	return BIT_OK;
+}
+
+void ExecuteLevelPass( RenderGraph & /* p_Graph */, void * /* p_pUserData */ )
+{
+	pGraphicDevice->EnableDepthTest( );
+	pGraphicDevice->ClearColor( );
+	pGraphicDevice->ClearDepth( );
+
+	// Get the shader variant of the current settings, it's compiled the first time it's used
+	ShaderPermutations::Permutation * pPermutation = pLevelPermutations->Get( GetLevelPermutationKey( ) );
+	if( pPermutation == BIT_NULL )
+	{
+		return;
+	}
+
+	// Bind the level model shader program
+	pPermutation->pShaderProgram->Bind( );
+	pShadowDepthTexture->Bind( 0 );
+
+	// Upload the parts of the frame block the level shader hasn't seen yet
+	FrameUniforms.Apply( *pPermutation->pUniforms, LevelFrameMembers );
+
+	// Render the model
+	pLevelModel->Render( Bit::VertexObject::RenderMode_Triangles );
+
+	// Unbind the level model shader program
+	pPermutation->pShaderProgram->Unbind( );
+
+	FrameCounters.DrawCalls++;
+	FrameCounters.Triangles += LevelTriangleCount;
+	FrameCounters.Binds += 2;
+}
+
+void ExecuteFullscreenPass( RenderGraph & p_Graph, void * /* p_pUserData */ )
+{
+	pGraphicDevice->DisableDepthTest( );
+	pGraphicDevice->ClearColor( );
+
+	// Bind the fullscreen shader program
+	pFullscreenShaderProgram->Bind( );
+	p_Graph.GetTexture( LevelColorHandle )->Bind( 0 );
+	pFullscreenVertexObject->Render( Bit::VertexObject::RenderMode_Triangles );
+	pFullscreenShaderProgram->Unbind( );
+
+	FrameCounters.DrawCalls++;
+	FrameCounters.Triangles += 2;
+	FrameCounters.Binds += 2;
+}
+
+BIT_UINT32 CountLevelTriangles( )
+{
+	// Faces are triangulated as fans, a face of n vertices is n - 2 triangles
+	std::ifstream ModelFile( Bit::GetAbsolutePath( LevelModelPath ).c_str( ), std::ifstream::in );
+	std::string Line;
+	BIT_UINT32 Count = 0;
+
+	while( std::getline( ModelFile, Line ) )
+	{
+		if( Line.compare( 0, 2, "f " ) != 0 )
+		{
+			continue;
+		}
+
+		BIT_UINT32 Vertices = 0;
+		for( BIT_MEMSIZE i = 1; i < Line.size( ); i++ )
+		{
+			if( Line[ i - 1 ] == ' ' && Line[ i ] != ' ' && Line[ i ] != '\r' )
+			{
+				Vertices++;
+			}
+		}
+
+		Count += Vertices > 2 ? Vertices - 2 : 0;
+	}
+
+	return Count;
+}
+
+BIT_UINT32 CreatePerformanceHUD( )
+{
+	// The model doesn't tell its size, the overlay counts the triangles itself
+	LevelTriangleCount = CountLevelTriangles( );
+
+	// The overlay draws through the GUI batch, toggled with U
+	GUI = new GUIManager( pGraphicDevice );
+	if( GUI->Load( ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the GUI manager\n" );
+		return BIT_ERROR;
+	}
+
+	Text = new TextRenderer( GUI );
+	if( Text->Load( ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the text renderer\n" );
+		return BIT_ERROR;
+	}
+
+	HUD = new PerformanceHUD( GUI, Text );
+	if( HUD->Load( ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the performance overlay\n" );
+		return BIT_ERROR;
+	}
+	HUD->SetPosition( Bit::Vector2_si32( 8, static_cast< BIT_SINT32 >( WindowSize.y ) - 8 ) );
+
+	return BIT_OK;
+}
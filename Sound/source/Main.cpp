@@ -1,25 +1,62 @@
 #include <Bit/Audio/AudioDevice.hpp>
 #include <Bit/Audio/AudioBuffer.hpp>
-#include <Bit/Audio/Audio.hpp>
 #include <Bit/System/Keyboard.hpp>
 #include <Bit/System.hpp>
 #include <Bit/System/Vector3.hpp>
 #include <Bit/System/Debugger.hpp>
 #include <Bit/System/MemoryLeak.hpp>
+#include <EventWaiter.hpp>
+#include <AudioStream.hpp>
+#include <VoicePool.hpp>
+#include <AudioMixer.hpp>
+#include <AudioOutput.hpp>
+#include <Resampler.hpp>
+#include <AdpcmBuffer.hpp>
+#include <AudioSpatializer.hpp>
+#include <AudioThread.hpp>
+#include <Bit/System/Timer.hpp>
+#include <CpuUsage.hpp>
+#include <cstring>
+#include <cmath>
 
 // Audio varaibles
 Bit::AudioDevice * pAudioDevice = BIT_NULL;
-Bit::Audio * pAudio = BIT_NULL;
 Bit::Keyboard * pKeyboard = BIT_NULL;
+VoicePool Voices;
+BIT_SINT32 PowerUpSound = -1;
+AudioStream Music;
+
+// The key-triggered sounds are mixed in software, the game thread only queues commands to the audio thread
+AudioMixer Mixer;
+OpenALAudioOutput MixerOutput;
+AudioThread Audio;
+BIT_SINT32 MixerPowerUpSound = -1;
+AudioThread::VoiceHandle LastVoice = AudioThread::InvalidVoice;
+
+// Main loop variables
+EventWaiter MainLoopWaiter;
+BIT_BOOL BusyLoop = BIT_FALSE;
 
 // Settings
 const std::string SoundFilePath = "../../../Data/PowerUp1.wav";
+const std::string MusicFilePath = "../../../Data/Music.wav";
+const BIT_UINT32 VoiceCount = 32;
+const BIT_UINT32 MixerSampleRate = 44100;
+
+// The keyboard only reports its state, so it's polled at this rate while idling (seconds).
+const BIT_FLOAT64 InputPollInterval = 0.01f;
 
 
 // Global functions
 int CloseApplication( const int p_Code );
 BIT_UINT32 LoadAudio( );
 BIT_UINT32 LoadInput( );
+void RunVoiceStressTest( );
+void RunMixerBenchmark( );
+void RunResamplerBenchmark( );
+BIT_UINT32 RunAdpcmBenchmark( );
+void RunSpatializerBenchmark( );
+void RunAudioThreadBenchmark( );
 
 // Main function
 int main( int argc, char ** argv )
@@ -30,6 +67,39 @@ int main( int argc, char ** argv )
 	// Setting the absolute path in order to read files.
 	Bit::SetAbsolutePath( argv[ 0 ] );
 
+	// The software mixer doesn't need the audio device, benchmark it before opening one
+	for( int i = 1; i < argc; i++ )
+	{
+		if( strcmp( argv[ i ], "-benchmark-mixer" ) == 0 )
+		{
+			RunMixerBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-resampler" ) == 0 )
+		{
+			RunResamplerBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-adpcm" ) == 0 )
+		{
+			return CloseApplication( RunAdpcmBenchmark( ) == BIT_OK ? 0 : 1 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-spatializer" ) == 0 )
+		{
+			RunSpatializerBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-audio-thread" ) == 0 )
+		{
+			RunAudioThreadBenchmark( );
+			return CloseApplication( 0 );
+		}
+	}
+
 	// Initialize the application
 	if( LoadAudio( ) != BIT_OK ||
 		LoadInput( ) != BIT_OK )
@@ -38,6 +108,24 @@ int main( int argc, char ** argv )
 	}
 
 
+	// -busy spins like the old loop, for comparing the CPU usage
+	for( int i = 1; i < argc; i++ )
+	{
+		if( strcmp( argv[ i ], "-busy" ) == 0 )
+		{
+			BusyLoop = BIT_TRUE;
+		}
+
+		if( strcmp( argv[ i ], "-stress-voices" ) == 0 )
+		{
+			RunVoiceStressTest( );
+			return CloseApplication( 0 );
+		}
+	}
+
+	CpuUsage Usage;
+	BIT_FLOAT64 SoundEndTime = -1.0f;
+
 	while( 1 )
 	{
 
@@ -50,14 +138,74 @@ int main( int argc, char ** argv )
 			break;
 		}
 
-		// Play sound
+		// Play sound, every press gets its own voice. S stops the last one.
 		if( pKeyboard->KeyIsJustReleased( Bit::Keyboard::Key_P ) )
 		{
-			pAudio->Play( );
+			LastVoice = Audio.Play( MixerPowerUpSound );
+			if( LastVoice != AudioThread::InvalidVoice )
+			{
+				SoundEndTime = Usage.GetWallTime( ) + Voices.GetSoundLength( PowerUpSound );
+			}
+		}
+		if( pKeyboard->KeyIsJustReleased( Bit::Keyboard::Key_S ) && LastVoice != AudioThread::InvalidVoice )
+		{
+			Audio.Stop( LastVoice );
+			LastVoice = AudioThread::InvalidVoice;
+		}
+
+		// Play/pause, rewind and loop the music
+		if( Music.IsOpen( ) )
+		{
+			if( pKeyboard->KeyIsJustReleased( Bit::Keyboard::Key_M ) )
+			{
+				if( Music.IsPlaying( ) )
+				{
+					Music.Pause( );
+				}
+				else
+				{
+					Music.Play( );
+				}
+			}
+			if( pKeyboard->KeyIsJustReleased( Bit::Keyboard::Key_R ) )
+			{
+				Music.Seek( 0.0f );
+			}
+			if( pKeyboard->KeyIsJustReleased( Bit::Keyboard::Key_L ) )
+			{
+				Music.SetLoop( !Music.GetLoop( ) );
+				bitTrace( "Music loop: %s\n", Music.GetLoop( ) ? "on" : "off" );
+			}
+		}
+
+		// The sound is done when its length has passed
+		const BIT_FLOAT64 Time = Usage.GetWallTime( );
+		if( SoundEndTime >= 0.0f && Time >= SoundEndTime )
+		{
+			bitTrace( "Sound finished.\n" );
+			SoundEndTime = -1.0f;
+		}
+
+		// Sleep until the next input poll, the end of the sound or a notification
+		if( !BusyLoop )
+		{
+			BIT_FLOAT64 Timeout = InputPollInterval;
+			if( SoundEndTime >= 0.0f && SoundEndTime - Time < Timeout )
+			{
+				Timeout = SoundEndTime - Time;
+			}
+			MainLoopWaiter.Wait( Timeout );
 		}
 
 	}
 
+	bitTrace( "CPU usage: %.1f%% of one core over %.1f seconds (%s loop).\n", Usage.GetUsage( ) * 100.0f,
+		Usage.GetWallTime( ), BusyLoop ? "busy" : "event driven" );
+	if( Music.IsOpen( ) )
+	{
+		bitTrace( "Music: %u buffer underruns.\n", Music.GetUnderrunCount( ) );
+	}
+
 	// We are done
 	bitTrace( "Closing the program.\n" );
 	return CloseApplication( 0 );
@@ -65,12 +213,14 @@ int main( int argc, char ** argv )
 
 int CloseApplication( const int p_Code )
 {
-	if( pAudio )
-	{
-		delete pAudio;
-		pAudio = BIT_NULL;
-	}
-	
+	Audio.Stop( );
+	MixerOutput.Close( );
+	Mixer.Close( );
+
+	Music.Close( );
+
+	Voices.Close( );
+
 	if( pAudioDevice )
 	{
 		delete pAudioDevice;
@@ -115,20 +265,39 @@ BIT_UINT32 LoadAudio( )
 		return BIT_ERROR;
 	}
 
-	// Create the sound
-	if( ( pAudio = pAudioDevice->CreateAudio( ) ) == BIT_NULL )
+
+	// Create the voices and load the sound once for all of them
+	if( Voices.Open( VoiceCount ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not create the audio \n" );
+		bitTrace( "[Error] Can not create the voices \n" );
 		return BIT_ERROR;
 	}
 
-	// Load the sound
-	if( pAudio->Load( AudioBuffer ) != BIT_OK )
+	if( ( PowerUpSound = Voices.LoadSound( AudioBuffer ) ) < 0 )
 	{
 		bitTrace( "[Error] Can not load the sound \n" );
 		return BIT_ERROR;
 	}
-	pAudio->SetRelative( BIT_TRUE );
+
+	// The sounds are loaded before the audio thread starts, the mixer belongs to it from then on.
+	// The output waits for the device, so it paces the audio thread.
+	if( Mixer.Open( MixerSampleRate, VoiceCount ) != BIT_OK ||
+		( MixerPowerUpSound = Mixer.LoadSound( AudioBuffer ) ) < 0 ||
+		MixerOutput.Open( MixerSampleRate, 2 ) != BIT_OK ||
+		Audio.Start( Mixer, &MixerOutput, BIT_FALSE ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not start the audio thread\n" );
+		return BIT_ERROR;
+	}
+	bitTrace( "P plays the sound on the audio thread, S stops the last one.\n" );
+
+	// The music is streamed from disk, it's optional
+	if( Music.Open( Bit::GetAbsolutePath( MusicFilePath ) ) == BIT_OK )
+	{
+		Music.SetFinishedWaiter( &MainLoopWaiter );
+		bitTrace( "Streaming %.1f seconds of music with %u bytes of buffers, M plays/pauses, R rewinds and L loops.\n",
+			Music.GetLength( ), Music.GetBufferMemory( ) );
+	}
 
 	return BIT_OK;
 }
@@ -142,4 +311,473 @@ BIT_UINT32 LoadInput( )
 	}
 
 	return BIT_OK;
-}
\ No newline at end of file
+}
+
+void RunVoiceStressTest( )
+{
+	// Many more overlapping one-shots than voices, mixed priorities and volumes
+	const BIT_UINT32 PlayCount = 5000;
+	const BIT_UINT32 PlaysPerMillisecond = 4;
+
+	Bit::Timer PlayTimer;
+	BIT_FLOAT64 TotalTime = 0.0f;
+	BIT_FLOAT64 MaxTime = 0.0f;
+	BIT_UINT32 PeakActive = 0;
+	BIT_UINT32 Started = 0;
+
+	for( BIT_UINT32 i = 0; i < PlayCount; i++ )
+	{
+		const BIT_SINT32 Priority = static_cast< BIT_SINT32 >( ( i * 7 ) % 4 );
+		const BIT_FLOAT32 Volume = static_cast< BIT_FLOAT32 >( ( i * 13 ) % 10 + 1 ) / 10.0f;
+
+		PlayTimer.Start( );
+		const VoicePool::VoiceHandle Voice = Voices.Play( PowerUpSound, Priority, Volume );
+		PlayTimer.Stop( );
+
+		const BIT_FLOAT64 Time = PlayTimer.GetTime( ) * 1000000.0f;
+		TotalTime += Time;
+		MaxTime = Time > MaxTime ? Time : MaxTime;
+		Started += Voice != VoicePool::InvalidVoice ? 1 : 0;
+		PeakActive = Voices.GetActiveCount( ) > PeakActive ? Voices.GetActiveCount( ) : PeakActive;
+
+		if( ( i % PlaysPerMillisecond ) == PlaysPerMillisecond - 1 )
+		{
+			Voices.Update( );
+			MainLoopWaiter.Wait( 0.001f );
+		}
+	}
+
+	bitTrace( "Voice stress test, %u one-shots on %u voices:\n", PlayCount, Voices.GetVoiceCount( ) );
+	bitTrace( "  started %u, stolen %u, rejected %u, peak active %u\n", Started, Voices.GetStealCount( ),
+		Voices.GetRejectCount( ), PeakActive );
+	bitTrace( "  play %.2f us average, %.2f us max\n", TotalTime / static_cast< BIT_FLOAT64 >( PlayCount ), MaxTime );
+
+	Voices.StopAll( );
+}
+
+void RunMixerBenchmark( )
+{
+	// Ten seconds of a busy scene, every voice moves its gain and pan each block
+	const BIT_UINT32 SampleRate = 44100;
+	const BIT_UINT32 VoiceCount = 256;
+	const BIT_UINT32 BlockSize = 256;
+	const BIT_UINT32 FrameCount = SampleRate * 10;
+
+	// A mono tone and a stereo chord, a bit over a second long so the one-shots restart
+	const BIT_UINT32 SoundFrames = SampleRate + SampleRate / 3;
+	std::vector< BIT_FLOAT32 > MonoSamples( SoundFrames );
+	std::vector< BIT_FLOAT32 > StereoSamples( SoundFrames * 2 );
+	for( BIT_UINT32 i = 0; i < SoundFrames; i++ )
+	{
+		const BIT_FLOAT32 Time = static_cast< BIT_FLOAT32 >( i ) / static_cast< BIT_FLOAT32 >( SampleRate );
+		MonoSamples[ i ] = sinf( Time * 2.0f * 3.14159265f * 440.0f ) * 0.5f;
+		StereoSamples[ i * 2 ] = sinf( Time * 2.0f * 3.14159265f * 261.6f ) * 0.5f;
+		StereoSamples[ i * 2 + 1 ] = sinf( Time * 2.0f * 3.14159265f * 329.6f ) * 0.5f;
+	}
+
+	bitTrace( "Mixer benchmark, %u voices for %.0f seconds at %u Hz in blocks of %u frames:\n", VoiceCount,
+		static_cast< BIT_FLOAT64 >( FrameCount ) / static_cast< BIT_FLOAT64 >( SampleRate ), SampleRate, BlockSize );
+
+	const BIT_UINT32 SetCount = 1 + static_cast< BIT_UINT32 >( CpuFeatures::GetSupportedInstructionSet( ) );
+	for( BIT_UINT32 Set = 0; Set < SetCount; Set++ )
+	{
+		const CpuFeatures::eInstructionSet InstructionSet = static_cast< CpuFeatures::eInstructionSet >( Set );
+
+		AudioMixer Mixer;
+		if( Mixer.Open( SampleRate, VoiceCount, BlockSize ) != BIT_OK ||
+			Mixer.SetInstructionSet( InstructionSet ) != BIT_OK )
+		{
+			bitTrace( "[Error] Can not open the mixer\n" );
+			return;
+		}
+		const BIT_SINT32 MonoSound = Mixer.LoadSound( &MonoSamples[ 0 ], SoundFrames, 1, SampleRate );
+		const BIT_SINT32 StereoSound = Mixer.LoadSound( &StereoSamples[ 0 ], SoundFrames, 2, SampleRate );
+		Mixer.SetMasterGain( 0.1f );
+
+		std::vector< AudioMixer::VoiceHandle > Handles( VoiceCount, AudioMixer::InvalidVoice );
+		NullAudioOutput Output;
+		Output.Open( SampleRate, 2 );
+
+		CpuUsage Usage;
+		for( BIT_UINT32 Frame = 0; Frame < FrameCount; Frame += BlockSize )
+		{
+			for( BIT_UINT32 i = 0; i < VoiceCount; i++ )
+			{
+				// Restart finished one-shots, every fourth voice loops
+				if( !Mixer.IsPlaying( Handles[ i ] ) )
+				{
+					Handles[ i ] = Mixer.Play( ( i & 1 ) ? StereoSound : MonoSound, 0.0f, 0.0f, ( i & 3 ) == 0 );
+				}
+
+				const BIT_FLOAT32 Phase = static_cast< BIT_FLOAT32 >( Frame ) * 0.0001f + static_cast< BIT_FLOAT32 >( i );
+				Mixer.SetGain( Handles[ i ], 0.5f + sinf( Phase ) * 0.5f );
+				Mixer.SetPan( Handles[ i ], cosf( Phase * 0.7f ) );
+			}
+
+			Mixer.Render( Output, FrameCount - Frame < BlockSize ? FrameCount - Frame : BlockSize );
+		}
+		const BIT_FLOAT64 CpuTime = Usage.GetCpuTime( ) * 1000.0f;
+
+		// One voice mixed for one millisecond of audio per millisecond of CPU time is real time for a single voice
+		const BIT_FLOAT64 VoiceTime = static_cast< BIT_FLOAT64 >( Mixer.GetVoiceFrameCount( ) ) * 1000.0f /
+			static_cast< BIT_FLOAT64 >( SampleRate );
+		bitTrace( "  %-6s %8.1f ms cpu, %8.0f voice-ms mixed per cpu ms, limiter at %.2f\n",
+			CpuFeatures::GetInstructionSetName( InstructionSet ), CpuTime,
+			CpuTime > 0.0f ? VoiceTime / CpuTime : 0.0f, Mixer.GetLimiterGain( ) );
+	}
+}
+
+void RunResamplerBenchmark( )
+{
+	// Ten seconds of stereo from 44.1 to 48 kHz, streamed in blocks like a voice
+	const BIT_UINT32 InputRate = 44100;
+	const BIT_UINT32 OutputRate = 48000;
+	const BIT_UINT32 BlockSize = 256;
+	const BIT_UINT32 FrameCount = OutputRate * 10;
+
+	std::vector< BIT_FLOAT32 > Input( InputRate * 2 );
+	for( BIT_UINT32 i = 0; i < InputRate; i++ )
+	{
+		const BIT_FLOAT32 Time = static_cast< BIT_FLOAT32 >( i ) / static_cast< BIT_FLOAT32 >( InputRate );
+		Input[ i * 2 ] = sinf( Time * 2.0f * 3.14159265f * 440.0f ) * 0.5f;
+		Input[ i * 2 + 1 ] = sinf( Time * 2.0f * 3.14159265f * 554.4f ) * 0.5f;
+	}
+	std::vector< BIT_FLOAT32 > Output( BlockSize * 2 );
+
+	bitTrace( "Resampler benchmark, stereo from %u Hz to %u Hz in blocks of %u frames:\n", InputRate, OutputRate, BlockSize );
+
+	const BIT_UINT32 SetCount = 1 + static_cast< BIT_UINT32 >( CpuFeatures::GetSupportedInstructionSet( ) );
+	for( BIT_UINT32 Quality = ResamplerFilter::Quality_Low; Quality <= ResamplerFilter::Quality_High; Quality++ )
+	{
+		ResamplerFilter Filter;
+		Filter.Create( static_cast< ResamplerFilter::eQuality >( Quality ), 1.0f );
+
+		for( BIT_UINT32 Set = 0; Set < SetCount; Set++ )
+		{
+			const CpuFeatures::eInstructionSet InstructionSet = static_cast< CpuFeatures::eInstructionSet >( Set );
+			Resampler Converter;
+			Converter.Open( &Filter, 2, static_cast< BIT_FLOAT64 >( InputRate ) / static_cast< BIT_FLOAT64 >( OutputRate ) );
+			Converter.SetInstructionSet( InstructionSet );
+
+			CpuUsage Usage;
+			BIT_UINT32 InputPosition = 0;
+			for( BIT_UINT32 Frame = 0; Frame < FrameCount; Frame += BlockSize )
+			{
+				// The input second loops, only the cost matters here
+				BIT_UINT32 Needed = Converter.GetInputFrameCount( BlockSize );
+				while( Needed )
+				{
+					const BIT_UINT32 Count = Needed < InputRate - InputPosition ? Needed : InputRate - InputPosition;
+					Converter.Write( &Input[ InputPosition * 2 ], Count );
+					InputPosition = ( InputPosition + Count ) % InputRate;
+					Needed -= Count;
+				}
+				Converter.Read( &Output[ 0 ], BlockSize );
+			}
+			const BIT_FLOAT64 CpuTime = Usage.GetCpuTime( );
+
+			bitTrace( "  %-6s %2u taps, %-6s %8.1f ms cpu, %7.1f million samples per second per core\n",
+				ResamplerFilter::GetQualityName( static_cast< ResamplerFilter::eQuality >( Quality ) ), Filter.GetTapCount( ),
+				CpuFeatures::GetInstructionSetName( InstructionSet ), CpuTime * 1000.0f,
+				CpuTime > 0.0f ? static_cast< BIT_FLOAT64 >( FrameCount * 2 ) / CpuTime / 1000000.0f : 0.0f );
+		}
+	}
+}
+
+BIT_UINT32 RunAdpcmBenchmark( )
+{
+	// A minute of stereo, a chord with some noise so the encoder has work to do
+	const BIT_UINT32 SampleRate = 44100;
+	const BIT_UINT32 FrameCount = SampleRate * 60;
+	std::vector< BIT_SINT16 > Samples( FrameCount * 2 );
+	BIT_UINT32 Noise = 1;
+	for( BIT_UINT32 i = 0; i < FrameCount; i++ )
+	{
+		const BIT_FLOAT32 Time = static_cast< BIT_FLOAT32 >( i ) / static_cast< BIT_FLOAT32 >( SampleRate );
+		Noise = Noise * 1664525 + 1013904223;
+		const BIT_FLOAT32 Hiss = static_cast< BIT_FLOAT32 >( static_cast< BIT_SINT32 >( Noise >> 16 ) - 32768 ) * 0.02f;
+		Samples[ i * 2 ] = static_cast< BIT_SINT16 >( sinf( Time * 2.0f * 3.14159265f * 261.6f ) * 9000.0f +
+			sinf( Time * 2.0f * 3.14159265f * 1318.5f ) * 3000.0f + Hiss );
+		Samples[ i * 2 + 1 ] = static_cast< BIT_SINT16 >( sinf( Time * 2.0f * 3.14159265f * 329.6f ) * 9000.0f +
+			sinf( Time * 2.0f * 3.14159265f * 2093.0f ) * 2000.0f + Hiss );
+	}
+
+	// Encoding
+	AdpcmBuffer Buffer;
+	CpuUsage Usage;
+	Buffer.Encode( &Samples[ 0 ], FrameCount, 2, SampleRate );
+	const BIT_FLOAT64 EncodeTime = Usage.GetCpuTime( );
+
+	// Decoding block by block like a voice does
+	std::vector< BIT_SINT16 > Decoded( Buffer.GetBlockCount( ) * Buffer.GetFramesPerBlock( ) * 2 );
+	Usage.Start( );
+	for( BIT_UINT32 i = 0; i < Buffer.GetBlockCount( ); i++ )
+	{
+		Buffer.DecodeBlock( i, &Decoded[ i * Buffer.GetFramesPerBlock( ) * 2 ] );
+	}
+	const BIT_FLOAT64 DecodeTime = Usage.GetCpuTime( );
+
+	// The table decoder has to match the reference decoder exactly, on the chord and on full scale noise
+	// where the steps are the largest and the predictor clamps
+	std::vector< BIT_SINT16 > FullScale( SampleRate * 2 );
+	for( BIT_UINT32 i = 0; i < FullScale.size( ); i++ )
+	{
+		Noise = Noise * 1664525 + 1013904223;
+		FullScale[ i ] = static_cast< BIT_SINT16 >( Noise >> 16 );
+	}
+	AdpcmBuffer FullScaleBuffer;
+	FullScaleBuffer.Encode( &FullScale[ 0 ], SampleRate, 2, SampleRate );
+
+	BIT_UINT32 Mismatches = 0;
+	const AdpcmBuffer * pBuffers[ 2 ] = { &Buffer, &FullScaleBuffer };
+	std::vector< BIT_SINT16 > Table( Buffer.GetFramesPerBlock( ) * 2 );
+	std::vector< BIT_SINT16 > Reference( Buffer.GetFramesPerBlock( ) * 2 );
+	for( BIT_UINT32 b = 0; b < 2; b++ )
+	{
+		for( BIT_UINT32 i = 0; i < pBuffers[ b ]->GetBlockCount( ); i++ )
+		{
+			const BIT_UINT32 Count = pBuffers[ b ]->DecodeBlock( i, &Table[ 0 ] );
+			if( pBuffers[ b ]->DecodeBlockReference( i, &Reference[ 0 ] ) != Count )
+			{
+				Mismatches++;
+				continue;
+			}
+
+			for( BIT_UINT32 j = 0; j < Count * 2; j++ )
+			{
+				Mismatches += Table[ j ] != Reference[ j ] ? 1 : 0;
+			}
+		}
+	}
+
+	BIT_FLOAT64 Signal = 0.0f;
+	BIT_FLOAT64 Error = 0.0f;
+	for( BIT_UINT32 i = 0; i < FrameCount * 2; i++ )
+	{
+		const BIT_FLOAT64 Difference = static_cast< BIT_FLOAT64 >( Decoded[ i ] - Samples[ i ] );
+		Signal += static_cast< BIT_FLOAT64 >( Samples[ i ] ) * static_cast< BIT_FLOAT64 >( Samples[ i ] );
+		Error += Difference * Difference;
+	}
+
+	const BIT_FLOAT64 SampleCount = static_cast< BIT_FLOAT64 >( FrameCount * 2 );
+	bitTrace( "IMA-ADPCM benchmark, %u seconds of 16 bit stereo at %u Hz:\n", FrameCount / SampleRate, SampleRate );
+	bitTrace( "  %u bytes instead of %u, %.2f to 1, %.1f dB signal to noise\n", Buffer.GetDataSize( ), FrameCount * 4,
+		static_cast< BIT_FLOAT64 >( FrameCount * 4 ) / static_cast< BIT_FLOAT64 >( Buffer.GetDataSize( ) ),
+		Error > 0.0f ? 10.0f * log10( Signal / Error ) : 0.0f );
+	bitTrace( "  encode %8.1f ms cpu, %7.1f million samples per second\n", EncodeTime * 1000.0f,
+		EncodeTime > 0.0f ? SampleCount / EncodeTime / 1000000.0f : 0.0f );
+	bitTrace( "  decode %8.1f ms cpu, %7.1f million samples per second\n", DecodeTime * 1000.0f,
+		DecodeTime > 0.0f ? SampleCount / DecodeTime / 1000000.0f : 0.0f );
+	bitTrace( "  decoder against the reference: %s, %u samples differ\n", Mismatches ? "FAIL" : "ok", Mismatches );
+
+	// The same scene in the mixer with float and with compressed sounds
+	const BIT_UINT32 VoiceCount = 256;
+	const BIT_UINT32 MixFrameCount = SampleRate * 10;
+	for( BIT_UINT32 Compress = 0; Compress < 2; Compress++ )
+	{
+		AudioMixer Mixer;
+		Mixer.Open( SampleRate, VoiceCount );
+		Mixer.SetCompressSounds( Compress ? BIT_TRUE : BIT_FALSE );
+		Mixer.SetMasterGain( 0.05f );
+
+		// Every voice plays its own second of the minute, as if they were all different clips
+		std::vector< BIT_FLOAT32 > Clip( SampleRate * 2 );
+		for( BIT_UINT32 i = 0; i < VoiceCount; i++ )
+		{
+			const BIT_UINT32 First = ( i % 60 ) * SampleRate * 2;
+			for( BIT_UINT32 j = 0; j < Clip.size( ); j++ )
+			{
+				Clip[ j ] = static_cast< BIT_FLOAT32 >( Samples[ First + j ] ) / 32768.0f;
+			}
+			Mixer.LoadSound( &Clip[ 0 ], SampleRate, 2, SampleRate );
+			Mixer.Play( i, 1.0f, 0.0f, BIT_TRUE );
+		}
+
+		NullAudioOutput Output;
+		Output.Open( SampleRate, 2 );
+		Usage.Start( );
+		Mixer.Render( Output, MixFrameCount );
+		const BIT_FLOAT64 CpuTime = Usage.GetCpuTime( ) * 1000.0f;
+
+		bitTrace( "  mixer, %u %s voices: %8.1f ms cpu for %u seconds, %u bytes of sounds\n", VoiceCount,
+			Compress ? "compressed" : "float", CpuTime, MixFrameCount / SampleRate, Mixer.GetSoundMemory( ) );
+	}
+
+	if( Mismatches )
+	{
+		bitTrace( "[Error] The table decoder doesn't match the reference decoder\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+void RunSpatializerBenchmark( )
+{
+	// Ten thousand emitters spread over a 400 by 400 meter level, moving around a moving listener
+	const BIT_UINT32 SampleRate = 44100;
+	const BIT_UINT32 EmitterCount = 10000;
+	const BIT_UINT32 VoiceCount = 64;
+	const BIT_UINT32 BlockSize = 256;
+	const BIT_UINT32 PassCount = 1000;
+	const BIT_FLOAT64 Budget = 0.5f;
+
+	// A short looping tone for the voices
+	std::vector< BIT_FLOAT32 > Samples( SampleRate / 10 );
+	for( BIT_UINT32 i = 0; i < Samples.size( ); i++ )
+	{
+		Samples[ i ] = sinf( static_cast< BIT_FLOAT32 >( i ) * 2.0f * 3.14159265f * 440.0f / static_cast< BIT_FLOAT32 >( SampleRate ) ) * 0.5f;
+	}
+
+	bitTrace( "Spatializer benchmark, %u moving emitters, %u passes:\n", EmitterCount, PassCount );
+
+	const BIT_UINT32 SetCount = 1 + static_cast< BIT_UINT32 >( CpuFeatures::GetSupportedInstructionSet( ) );
+	for( BIT_UINT32 Set = 0; Set < SetCount; Set++ )
+	{
+		const CpuFeatures::eInstructionSet InstructionSet = static_cast< CpuFeatures::eInstructionSet >( Set );
+
+		AudioMixer Mixer;
+		if( Mixer.Open( SampleRate, VoiceCount, BlockSize ) != BIT_OK )
+		{
+			bitTrace( "[Error] Can not open the mixer\n" );
+			return;
+		}
+		const BIT_SINT32 Sound = Mixer.LoadSound( &Samples[ 0 ], static_cast< BIT_UINT32 >( Samples.size( ) ), 1, SampleRate );
+
+		AudioSpatializer Spatializer;
+		Spatializer.SetInstructionSet( InstructionSet );
+		BIT_UINT32 Random = 1;
+		for( BIT_UINT32 i = 0; i < EmitterCount; i++ )
+		{
+			BIT_FLOAT32 Values[ 5 ];
+			for( BIT_UINT32 j = 0; j < 5; j++ )
+			{
+				Random = Random * 1664525 + 1013904223;
+				Values[ j ] = static_cast< BIT_FLOAT32 >( Random >> 8 ) / 16777216.0f - 0.5f;
+			}
+
+			const BIT_UINT32 Emitter = Spatializer.AddEmitter( Sound, Bit::Vector3_f32( Values[ 0 ] * 400.0f, Values[ 1 ] * 20.0f,
+				Values[ 2 ] * 400.0f ), 0.5f + Values[ 3 ] );
+			Spatializer.SetEmitterVelocity( Emitter, Bit::Vector3_f32( Values[ 3 ] * 40.0f, 0.0f, Values[ 4 ] * 40.0f ) );
+			Spatializer.SetEmitterDistances( Emitter, 2.0f, 60.0f );
+		}
+
+		std::vector< BIT_SINT16 > Frames( BlockSize * 2 );
+		Bit::Timer PassTimer;
+		BIT_FLOAT64 SpatializeTime = 0.0f;
+		BIT_FLOAT64 MaxTime = 0.0f;
+		BIT_FLOAT64 ApplyTime = 0.0f;
+		BIT_UINT32 AudibleCount = 0;
+		BIT_UINT32 OverBudget = 0;
+
+		for( BIT_UINT32 Pass = 0; Pass < PassCount; Pass++ )
+		{
+			// The listener walks in a circle, a pass per block of audio
+			const BIT_FLOAT32 Angle = static_cast< BIT_FLOAT32 >( Pass ) * 0.01f;
+			Spatializer.SetListenerPosition( Bit::Vector3_f32( cosf( Angle ) * 50.0f, 0.0f, sinf( Angle ) * 50.0f ) );
+			Spatializer.SetListenerVelocity( Bit::Vector3_f32( -sinf( Angle ) * 5.0f, 0.0f, cosf( Angle ) * 5.0f ) );
+			Spatializer.SetListenerTarget( Bit::Vector3_f32( -sinf( Angle ), 0.0f, cosf( Angle ) ) );
+			for( BIT_UINT32 i = Pass % 10; i < EmitterCount; i += 10 )
+			{
+				Spatializer.SetEmitterPosition( i, Bit::Vector3_f32( cosf( Angle + static_cast< BIT_FLOAT32 >( i ) ) * 150.0f, 0.0f,
+					sinf( Angle * 0.5f + static_cast< BIT_FLOAT32 >( i ) ) * 150.0f ) );
+			}
+
+			PassTimer.Start( );
+			Spatializer.Spatialize( );
+			PassTimer.Stop( );
+			const BIT_FLOAT64 Time = PassTimer.GetTime( ) * 1000.0f;
+			SpatializeTime += Time;
+			MaxTime = Time > MaxTime ? Time : MaxTime;
+			OverBudget += Time > Budget ? 1 : 0;
+			AudibleCount += Spatializer.GetAudibleCount( );
+
+			PassTimer.Start( );
+			Spatializer.Apply( Mixer, VoiceCount );
+			PassTimer.Stop( );
+			ApplyTime += PassTimer.GetTime( ) * 1000.0f;
+
+			Mixer.Mix( &Frames[ 0 ], BlockSize );
+		}
+
+		bitTrace( "  %-6s spatialize %.3f ms average, %.3f ms max, %u of %u passes over %.1f ms\n",
+			CpuFeatures::GetInstructionSetName( InstructionSet ), SpatializeTime / static_cast< BIT_FLOAT64 >( PassCount ), MaxTime,
+			OverBudget, PassCount, Budget );
+		bitTrace( "         %u audible on average, %u voices, apply %.3f ms average\n", AudibleCount / PassCount,
+			Spatializer.GetVoiceCount( ), ApplyTime / static_cast< BIT_FLOAT64 >( PassCount ) );
+
+		Spatializer.Clear( Mixer );
+	}
+}
+
+void RunAudioThreadBenchmark( )
+{
+	// Five seconds of a 60 fps game loop sending commands to the mixer on the audio thread
+	const BIT_UINT32 SampleRate = 44100;
+	const BIT_UINT32 VoiceCount = 64;
+	const BIT_UINT32 BlockSize = 256;
+	const BIT_UINT32 FrameCount = 300;
+
+	AudioMixer Mixer;
+	if( Mixer.Open( SampleRate, VoiceCount, BlockSize ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not open the mixer\n" );
+		return;
+	}
+
+	std::vector< BIT_FLOAT32 > Samples( SampleRate / 2 );
+	for( BIT_UINT32 i = 0; i < Samples.size( ); i++ )
+	{
+		Samples[ i ] = sinf( static_cast< BIT_FLOAT32 >( i ) * 2.0f * 3.14159265f * 440.0f / static_cast< BIT_FLOAT32 >( SampleRate ) ) * 0.5f;
+	}
+	const BIT_SINT32 Sound = Mixer.LoadSound( &Samples[ 0 ], static_cast< BIT_UINT32 >( Samples.size( ) ), 1, SampleRate );
+
+	NullAudioOutput Output;
+	Output.Open( SampleRate, 2 );
+	AudioThread Audio;
+	if( Audio.Start( Mixer, &Output ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not start the audio thread\n" );
+		return;
+	}
+	Audio.SetMasterGain( 0.1f );
+
+	Bit::Timer CommandTimer;
+	BIT_FLOAT64 TotalTime = 0.0f;
+	BIT_FLOAT64 MaxTime = 0.0f;
+	BIT_UINT32 CommandCount = 0;
+	std::vector< AudioThread::VoiceHandle > Handles( 16, AudioThread::InvalidVoice );
+
+	for( BIT_UINT32 Frame = 0; Frame < FrameCount; Frame++ )
+	{
+		// A one-shot every frame, the oldest stopped, and every voice moved
+		const BIT_UINT32 Slot = Frame % Handles.size( );
+		CommandTimer.Start( );
+		Audio.Stop( Handles[ Slot ] );
+		Handles[ Slot ] = Audio.Play( Sound, 0.5f, 0.0f, BIT_TRUE );
+		for( BIT_UINT32 i = 0; i < Handles.size( ); i++ )
+		{
+			const BIT_FLOAT32 Phase = static_cast< BIT_FLOAT32 >( Frame ) * 0.05f + static_cast< BIT_FLOAT32 >( i );
+			Audio.SetGain( Handles[ i ], 0.5f + sinf( Phase ) * 0.5f );
+			Audio.SetPan( Handles[ i ], cosf( Phase ) );
+		}
+		CommandTimer.Stop( );
+
+		const BIT_FLOAT64 Time = CommandTimer.GetTime( ) * 1000000.0f;
+		TotalTime += Time;
+		MaxTime = Time > MaxTime ? Time : MaxTime;
+		CommandCount += 2 + static_cast< BIT_UINT32 >( Handles.size( ) ) * 2;
+
+		MainLoopWaiter.Wait( 1.0f / 60.0f );
+	}
+
+	Audio.Stop( );
+
+	bitTrace( "Audio thread benchmark, %u game frames, blocks of %u frames at %u Hz:\n", FrameCount, BlockSize, SampleRate );
+	bitTrace( "  game thread: %u commands, %.3f us per command on average, %.1f us max per frame, %u dropped\n",
+		CommandCount, TotalTime / static_cast< BIT_FLOAT64 >( CommandCount ), MaxTime, Audio.GetDroppedCount( ) );
+	bitTrace( "  audio thread: %u blocks, %u underruns\n", static_cast< BIT_UINT32 >( Audio.GetBlockCount( ) ),
+		Audio.GetUnderrunCount( ) );
+	bitTrace( "  command to first rendered sample: %.2f ms average, %.2f ms max over %u commands\n",
+		Audio.GetAverageLatency( ) * 1000.0f, Audio.GetMaxLatency( ) * 1000.0f, Audio.GetLatencyCount( ) );
+}
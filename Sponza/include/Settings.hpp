@@ -34,6 +34,14 @@ class Settings
 
 public:
 
+	// Public enums
+	enum eLightingMode
+	{
+		Lighting_Forward = 0,	// The single light of the frame uniform block
+		Lighting_Deferred = 1,
+		Lighting_Clustered = 2
+	};
+
 	// Constructor/destructor
 	Settings( );
 	~Settings( );
@@ -44,16 +52,50 @@ public:
 	// Set functions
 	void SetWindowSize( const Bit::Vector2_ui32 p_WindowSize );
 	void SetUseNormalMapping( const BIT_BOOL p_Status );
+	void SetBloomLevels( const BIT_UINT32 p_Levels );
+	void SetBloomThreshold( const BIT_FLOAT32 p_Threshold );
+	void SetBloomIntensity( const BIT_FLOAT32 p_Intensity );
+	void SetUseDepthPrepass( const BIT_BOOL p_Status );
+	void SetLightingMode( const BIT_UINT32 p_Mode );
+	void SetLightCount( const BIT_UINT32 p_Count );
+	void SetUseDynamicResolution( const BIT_BOOL p_Status );
+	void SetTargetFrameTime( const BIT_FLOAT32 p_Time );
+	void SetResolutionScaleRange( const BIT_FLOAT32 p_Min, const BIT_FLOAT32 p_Max );
+	void SetResolutionGains( const BIT_FLOAT32 p_Proportional, const BIT_FLOAT32 p_Integral );
 
 	// Get functions
 	Bit::Vector2_ui32 GetWindowSize( ) const;
 	BIT_BOOL GetUseNormalMapping( ) const;
+	BIT_UINT32 GetBloomLevels( ) const;
+	BIT_FLOAT32 GetBloomThreshold( ) const;
+	BIT_FLOAT32 GetBloomIntensity( ) const;
+	BIT_BOOL GetUseDepthPrepass( ) const;
+	BIT_UINT32 GetLightingMode( ) const;
+	BIT_UINT32 GetLightCount( ) const;
+	BIT_BOOL GetUseDynamicResolution( ) const;
+	BIT_FLOAT32 GetTargetFrameTime( ) const;
+	BIT_FLOAT32 GetMinResolutionScale( ) const;
+	BIT_FLOAT32 GetMaxResolutionScale( ) const;
+	BIT_FLOAT32 GetResolutionGainP( ) const;
+	BIT_FLOAT32 GetResolutionGainI( ) const;
 
 private:
 
 	// Private members
 	Bit::Vector2_ui32 m_WindowSize;
 	BIT_BOOL m_UseNormalMapping;
+	BIT_UINT32 m_BloomLevels;
+	BIT_FLOAT32 m_BloomThreshold;
+	BIT_FLOAT32 m_BloomIntensity;
+	BIT_BOOL m_UseDepthPrepass;
+	BIT_UINT32 m_LightingMode;
+	BIT_UINT32 m_LightCount;
+	BIT_BOOL m_UseDynamicResolution;
+	BIT_FLOAT32 m_TargetFrameTime;
+	BIT_FLOAT32 m_MinResolutionScale;
+	BIT_FLOAT32 m_MaxResolutionScale;
+	BIT_FLOAT32 m_ResolutionGainP;
+	BIT_FLOAT32 m_ResolutionGainI;
 
 };
 
@@ -12,6 +12,22 @@
 #include <Settings.hpp>
 #include <Camera.hpp>
 #include <GUIManager.hpp>
+#include <TextRenderer.hpp>
+#include <PerformanceHUD.hpp>
+#include <FrameUniformBlock.hpp>
+#include <PostProcessingDualBloom.hpp>
+#include <RenderGraph.hpp>
+#include <DeferredRenderer.hpp>
+#include <LightClusterGrid.hpp>
+#include <PointLightSet.hpp>
+#include <ShaderPermutations.hpp>
+#include <DynamicResolution.hpp>
+#include <MathKernels.hpp>
+#include <OpenGL.hpp>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
 
 // Window/graphic device
 Bit::Window * pWindow = BIT_NULL;
@@ -21,12 +37,54 @@ Bit::GraphicDevice * pGraphicDevice = BIT_NULL;
 const std::string SettingsFilePath = "../../../Data/SponzaSettings.txt";
 Settings SponzaSettings;
 
-// Level variables
+// Level variables, the model shader variants are picked per draw by a feature key
 const std::string LevelModelPath = "../../../../Sponza/sponza.obj";
 Bit::Model * pLevelModel = BIT_NULL;
-Bit::ShaderProgram * pShaderProgram_Model = BIT_NULL;
-Bit::Shader * pVertexShader_Model = BIT_NULL;
-Bit::Shader * pFragmentShader_Model = BIT_NULL;
+ShaderPermutations * pModelPermutations = BIT_NULL;
+BIT_UINT32 ModelFeature_NormalMapping = 0;
+BIT_UINT32 ModelFeature_AlphaTest = 0;
+BIT_UINT32 ModelFeature_Clustered = 0;
+BIT_UINT32 ModelFeature_Fog = 0;
+const BIT_UINT32 FrameMembers_Model = FrameUniformBlock::Member_ProjectionMatrix |
+	FrameUniformBlock::Member_ViewMatrix | FrameUniformBlock::Member_LightPosition;
+
+// Depth pre-pass variables. The color pass after the pre-pass uses a variant without
+// the alpha test, the discard would otherwise turn off early depth testing.
+Bit::ShaderProgram * pShaderProgram_Prepass = BIT_NULL;
+Bit::Shader * pVertexShader_Prepass = BIT_NULL;
+Bit::Shader * pFragmentShader_Prepass = BIT_NULL;
+ShaderUniforms * pUniforms_Prepass = BIT_NULL;
+const BIT_UINT32 FrameMembers_Prepass = FrameUniformBlock::Member_ProjectionMatrix |
+	FrameUniformBlock::Member_ViewMatrix;
+BIT_UINT32 AlphaTestedMaterialCount = 0;
+
+// Many lights variables, the lights are spread over the bounds of the level.
+// The forward path keeps using the single light of the frame uniform block.
+DeferredRenderer * pDeferredRenderer = BIT_NULL;
+LightClusterGrid * pLightClusterGrid = BIT_NULL;
+PointLightSet SceneLights;
+BIT_BOOL AnimateLights = BIT_TRUE;
+const char * LightingModeNames[ 3 ] = { "forward", "deferred", "clustered forward" };
+const Bit::Vector3_f32 LightBoundsMin( -1800.0f, 0.0f, -800.0f );
+const Bit::Vector3_f32 LightBoundsMax( 1700.0f, 1200.0f, 800.0f );
+const BIT_UINT32 LightSeed = 1337;
+const BIT_UINT32 MaxLightCount = 4096;
+const BIT_UINT32 TimingFrameCount = 120;
+const BIT_UINT32 ClusterGridX = 16;
+const BIT_UINT32 ClusterGridY = 9;
+const BIT_UINT32 ClusterGridZ = 24;
+const BIT_UINT32 MaxClusterIndices = 1024 * 1024;
+const BIT_FLOAT32 AmbientLight = 0.1f;
+
+// Fog variables, the fog is a feature of the forward and clustered forward shaders
+BIT_BOOL UseFog = BIT_FALSE;
+const Bit::Vector3_f32 FogColor( 0.55f, 0.55f, 0.6f );
+const BIT_FLOAT32 FogDensity = 0.0004f;
+
+// Uniform variables
+FrameUniformBlock FrameUniforms;
+const UniformHandle FragmentWeightHandle( "FragmentWeight" );
+const UniformHandle ScreenSizeHandle( "ScreenSize" );
 
 // Camera variables
 Camera ViewCamera;
@@ -41,15 +99,35 @@ GUICheckbox * Checkbox1 = BIT_NULL;
 GUICheckbox * Checkbox2 = BIT_NULL;
 GUISlider * Slider1 = BIT_NULL;
 GUISlider * Slider2 = BIT_NULL;
+TextRenderer * Text = BIT_NULL;
 
-// Fullscreen rendering
-Bit::Framebuffer * pFramebuffer = BIT_NULL;
+// Performance overlay, the counters are collected while rendering the frame
+PerformanceHUD * HUD = BIT_NULL;
+PerformanceHUD::Counters FrameCounters;
+BIT_UINT32 LevelTriangleCount = 0;
+
+// Fullscreen rendering, the scene depth is a transient render graph texture
 Bit::Texture * pColorTexture = BIT_NULL;
-Bit::Texture * pDepthTexture = BIT_NULL;
 Bit::VertexObject * pFullscreenVertexObject = BIT_NULL;
+RenderGraph * pRenderGraph = BIT_NULL;
+
+// Dynamic resolution, the scene textures are sized for the largest scale and the
+// scene is rendered into a viewport in their lower left corner.
+// The dual filter bloom composite stretches the viewport over the window.
+DynamicResolution ResolutionController;
+Bit::Vector2_ui32 RenderViewportSize( 0, 0 );
 
 // Post-Processing varaibles
 Bit::PostProcessingBloom * pPostProcessingBloom = BIT_NULL;
+PostProcessingDualBloom * pPostProcessingDualBloom = BIT_NULL;
+enum eBloomMode
+{
+	Bloom_DualFilter = 0,
+	Bloom_Engine = 1,
+	Bloom_None = 2
+};
+BIT_UINT32 BloomMode = Bloom_DualFilter;
+const char * BloomModeNames[ 3 ] = { "dual filter", "engine", "no" };
 
 // Global functions
 int CloseApplication( const int p_Code );
@@ -59,9 +137,35 @@ void InitializeCamera( );
 BIT_UINT32 CreateWindow( );
 BIT_UINT32 CreateGraphicDevice( );
 BIT_UINT32 CreateFullscreenRendering( );
+Bit::VertexObject * CreateFullscreenVertexObject( const Bit::Vector2_ui32 p_Size );
 BIT_UINT32 CreatePostProcessing( );
+void RunBloomBenchmark( );
+void RunGUIBenchmark( );
+void RunHitTestBenchmark( );
+void RunTextBenchmark( );
+BIT_UINT32 RunCameraBenchmark( );
+void RunMathBenchmark( );
+BIT_BOOL EqualVectorArrays( const Vector3Array & p_A, const Vector3Array & p_B );
+BIT_UINT32 BuildRenderGraph( );
+void ExecuteScenePass( RenderGraph & p_Graph, void * p_pUserData );
+void ExecuteBloomPass( RenderGraph & p_Graph, void * p_pUserData );
+void RenderDepthPrepass( );
+void RenderModel( const BIT_UINT32 p_Key );
+BIT_UINT64 CountFragments( const BIT_BOOL p_DepthTest, const BIT_BOOL p_Prepass );
+void RunPrepassBenchmark( );
+void RunClusteredBenchmark( );
 BIT_UINT32 CreateModel( );
+BIT_UINT32 CountAlphaTestedMaterials( );
+BIT_UINT32 CountModelTriangles( );
 BIT_UINT32 CreateModelShader( );
+void SetupModelProgram( ShaderPermutations::Permutation & p_Permutation, void * p_pUserData );
+BIT_UINT32 GetModelPermutationKey( );
+BIT_UINT32 CreatePrepassShader( );
+BIT_UINT32 CreateDeferredRenderer( );
+BIT_UINT32 CreateClusteredLighting( );
+void GenerateLights( );
+void PrintFrameTimings( );
+void ApplyRenderScale( );
 BIT_UINT32 CreateGUI( );
 
 // Main function
@@ -89,13 +193,70 @@ int main( int argc, char ** argv )
 		CreatePostProcessing( ) != BIT_OK ||
 		CreateModel( ) != BIT_OK  ||
 		CreateModelShader( ) != BIT_OK ||
+		CreatePrepassShader( ) != BIT_OK ||
+		CreateDeferredRenderer( ) != BIT_OK ||
+		CreateClusteredLighting( ) != BIT_OK ||
+		BuildRenderGraph( ) != BIT_OK ||
 		CreateGUI( ) != BIT_OK )
 	{
 		return CloseApplication( 0 );
 	}
 
+	// Run the bloom benchmark instead of the scene?
+	for( int i = 1; i < argc; i++ )
+	{
+		if( strcmp( argv[ i ], "-benchmark-bloom" ) == 0 )
+		{
+			RunBloomBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-prepass" ) == 0 )
+		{
+			RunPrepassBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-clustered" ) == 0 )
+		{
+			RunClusteredBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-gui" ) == 0 )
+		{
+			RunGUIBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-hit-test" ) == 0 )
+		{
+			RunHitTestBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-text" ) == 0 )
+		{
+			RunTextBenchmark( );
+			return CloseApplication( 0 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-camera" ) == 0 )
+		{
+			return CloseApplication( RunCameraBenchmark( ) == BIT_OK ? 0 : 1 );
+		}
+
+		if( strcmp( argv[ i ], "-benchmark-math" ) == 0 )
+		{
+			RunMathBenchmark( );
+			return CloseApplication( 0 );
+		}
+	}
+
 	// Create a timer and run a main loop for some time
 	BIT_FLOAT64 DeltaTime = 0.0f;
+	BIT_FLOAT64 LightTime = 0.0f;
+	BIT_UINT32 FrameCount = 0;
 	Bit::Timer Timer;
 	Timer.Start( );
 
@@ -106,8 +267,6 @@ int main( int argc, char ** argv )
 		DeltaTime = Timer.GetLapsedTime( );
 		Timer.Start( );
 
-		//bitTrace( "FPS: %f\n", 1.0f / DeltaTime );
-
 		// Do evenets
 		pWindow->Update( );
 
@@ -214,13 +373,96 @@ int main( int argc, char ** argv )
 						break;
 						case Bit::Keyboard::Key_M:
 						{
-							// Flip the flag
+							// Flip the flag, the next draw picks the matching shader variant
 							SponzaSettings.SetUseNormalMapping( !SponzaSettings.GetUseNormalMapping( ) );
-
-							// Bind and update the uniform
-							pShaderProgram_Model->Bind( );
-							pShaderProgram_Model->SetUniform1i( "UseNormalMapping", SponzaSettings.GetUseNormalMapping( ) );
-							pShaderProgram_Model->Unbind( );
+							pDeferredRenderer->SetUseNormalMapping( SponzaSettings.GetUseNormalMapping( ) );
+						}
+						break;
+						case Bit::Keyboard::Key_O:
+						{
+							UseFog = !UseFog;
+							bitTrace( "Fog: %s.\n", UseFog ? "on" : "off" );
+						}
+						break;
+						case Bit::Keyboard::Key_P:
+						{
+							SponzaSettings.SetUseDepthPrepass( !SponzaSettings.GetUseDepthPrepass( ) );
+							bitTrace( "Depth pre-pass: %s.\n", SponzaSettings.GetUseDepthPrepass( ) ? "on" : "off" );
+						}
+						break;
+						case Bit::Keyboard::Key_F:
+						{
+							// Cycle the forward, deferred and clustered forward paths
+							SponzaSettings.SetLightingMode( ( SponzaSettings.GetLightingMode( ) + 1 ) % 3 );
+							bitTrace( "Using %s shading.\n", LightingModeNames[ SponzaSettings.GetLightingMode( ) ] );
+
+							if( BuildRenderGraph( ) != BIT_OK )
+							{
+								return CloseApplication( 0 );
+							}
+						}
+						break;
+						case Bit::Keyboard::Key_I:
+						{
+							// Double the light count
+							const BIT_UINT32 LightCount = SponzaSettings.GetLightCount( ) * 2;
+							SponzaSettings.SetLightCount( LightCount > MaxLightCount ? MaxLightCount : ( LightCount ? LightCount : 1 ) );
+							GenerateLights( );
+						}
+						break;
+						case Bit::Keyboard::Key_K:
+						{
+							// Halve the light count
+							SponzaSettings.SetLightCount( SponzaSettings.GetLightCount( ) / 2 );
+							GenerateLights( );
+						}
+						break;
+						case Bit::Keyboard::Key_T:
+						{
+							// Per-pass timings, they stall the GPU after every pass
+							pRenderGraph->SetTimingEnabled( !pRenderGraph->GetTimingEnabled( ) );
+							pRenderGraph->ResetTimings( );
+							FrameCount = 0;
+							bitTrace( "Pass timings: %s.\n", pRenderGraph->GetTimingEnabled( ) ? "on" : "off" );
+						}
+						break;
+						case Bit::Keyboard::Key_G:
+						{
+							// Cycle the dual filter bloom, the engine's bloom and no bloom at all
+							BloomMode = ( BloomMode + 1 ) % 3;
+							bitTrace( "Using %s bloom.\n", BloomModeNames[ BloomMode ] );
+							ApplyRenderScale( );
+
+							// The unused effect's passes are culled by the graph
+							if( BuildRenderGraph( ) != BIT_OK )
+							{
+								return CloseApplication( 0 );
+							}
+						}
+						break;
+						case Bit::Keyboard::Key_R:
+						{
+							// Back to the native resolution when it's turned off
+							SponzaSettings.SetUseDynamicResolution( !SponzaSettings.GetUseDynamicResolution( ) );
+							ResolutionController.SetScale( 1.0f );
+							ApplyRenderScale( );
+							bitTrace( "Dynamic resolution: %s.\n", SponzaSettings.GetUseDynamicResolution( ) ? "on" : "off" );
+						}
+						break;
+						case Bit::Keyboard::Key_H:
+						{
+							ResolutionController.PrintHistory( );
+						}
+						break;
+						case Bit::Keyboard::Key_U:
+						{
+							HUD->SetVisible( !HUD->GetVisible( ) );
+						}
+						break;
+						case Bit::Keyboard::Key_L:
+						{
+							AnimateLights = !AnimateLights;
+							bitTrace( "Light animation: %s.\n", AnimateLights ? "on" : "off" );
 						}
 						break;
 
@@ -297,49 +539,72 @@ int main( int argc, char ** argv )
 			ViewCamera.Rotate( MouseDiff );
 		}
 
-
-		// Bind the framebuffer
-		pFramebuffer->Bind( );
-		pGraphicDevice->EnableDepthTest( );
-
-		// Clear the buffers
-		pGraphicDevice->ClearColor( );
-		pGraphicDevice->ClearDepth( );
-
-		// Bind the model shader program
-		pShaderProgram_Model->Bind( );
-
 		// Update the camera if needed
 		if( ViewCamera.Update( DeltaTime ) )
 		{
-			pShaderProgram_Model->SetUniformMatrix4x4f( "ViewMatrix", ViewCamera.GetMatrix( ) );
+			FrameUniforms.SetViewMatrix( ViewCamera.GetMatrix( ) );
 		}
 
-		// Render the model
-		pLevelModel->Render( Bit::VertexObject::RenderMode_Triangles );
+		// Move the lights, paused lights keep their version and the light caches
+		if( AnimateLights )
+		{
+			LightTime += DeltaTime;
+			SceneLights.Update( LightTime );
+		}
 
-		// Unbind the shader program
-		pShaderProgram_Model->Unbind( );
+		// Render the scene and the post-processing
+		FrameCounters = PerformanceHUD::Counters( );
+		pRenderGraph->Execute( );
+		FrameCounters.Memory = pRenderGraph->GetPeakMemory( );
+		HUD->Update( DeltaTime * 1000.0f, FrameCounters, pRenderGraph );
 
-		// Unbind the framebuffer (binding the standard framebuffer)
-		pFramebuffer->Unbind( );
+		// Adjust the resolution scale, the pass timings measure the GPU work when they are on.
+		// The engine's bloom can't read a part of the color texture, the scale is paused.
+		if( SponzaSettings.GetUseDynamicResolution( ) && BloomMode != Bloom_Engine )
+		{
+			const BIT_FLOAT64 FrameTime = pRenderGraph->GetTimingEnabled( ) ?
+				pRenderGraph->GetFrameTime( ) : DeltaTime * 1000.0f;
 
-		// Post-processing
-		pGraphicDevice->DisableDepthTest( );
-		pGraphicDevice->ClearColor( );
+			if( ResolutionController.Update( FrameTime ) )
+			{
+				ApplyRenderScale( );
+			}
+		}
 
-		// Apply bloom
-		pPostProcessingBloom->Process( );
+		// Print the pass timings now and then
+		if( pRenderGraph->GetTimingEnabled( ) && ++FrameCount >= TimingFrameCount )
+		{
+			PrintFrameTimings( );
+			FrameCount = 0;
+		}
 
 		// Render the GUI
 		// GUI->Render( );
 
+		// Render the performance overlay, or just the frame rate when it's hidden
+		if( HUD->GetVisible( ) )
+		{
+			HUD->Render( );
+		}
+		else
+		{
+			char FrameText[ 64 ];
+			sprintf( FrameText, "FPS: %.0f\n%.2f ms", DeltaTime > 0.0f ? 1.0f / DeltaTime : 0.0f, DeltaTime * 1000.0f );
+			Text->Begin( );
+			Text->Add( Bit::Vector2_si32( 8, SponzaSettings.GetWindowSize( ).y - 8 ), FrameText, 2 );
+			Text->Render( );
+		}
+
 		// Present the buffers
 		pGraphicDevice->Present( );
 	}
 
 	// We are done
 	bitTrace( "Closing the program.\n" );
+	if( SponzaSettings.GetUseDynamicResolution( ) )
+	{
+		ResolutionController.PrintHistory( );
+	}
 	return CloseApplication( 0 );
 }
 
@@ -348,6 +613,32 @@ int CloseApplication( const int p_Code )
 	// Release the resource manager
 	Bit::ResourceManager::Release( );
 
+	if( pModelPermutations )
+	{
+		bitTrace( "Model shader: %u variants compiled in %.3f ms.\n",
+			pModelPermutations->GetPermutationCount( ), pModelPermutations->GetCompileTime( ) );
+		delete pModelPermutations;
+		pModelPermutations = BIT_NULL;
+	}
+
+	if( pUniforms_Prepass )
+	{
+		delete pUniforms_Prepass;
+		pUniforms_Prepass = BIT_NULL;
+	}
+
+	if( HUD )
+	{
+		delete HUD;
+		HUD = BIT_NULL;
+	}
+
+	if( Text )
+	{
+		delete Text;
+		Text = BIT_NULL;
+	}
+
 	if( Slider2 )
 	{
 		delete Slider2;
@@ -385,22 +676,22 @@ int CloseApplication( const int p_Code )
 		pLevelModel = BIT_NULL;
 	}
 
-	if( pShaderProgram_Model )
+	if( pShaderProgram_Prepass )
 	{
-		delete pShaderProgram_Model;
-		pShaderProgram_Model = BIT_NULL;
+		delete pShaderProgram_Prepass;
+		pShaderProgram_Prepass = BIT_NULL;
 	}
 
-	if( pVertexShader_Model )
+	if( pVertexShader_Prepass )
 	{
-		delete pVertexShader_Model;
-		pVertexShader_Model = BIT_NULL;
+		delete pVertexShader_Prepass;
+		pVertexShader_Prepass = BIT_NULL;
 	}
 
-	if( pFragmentShader_Model )
+	if( pFragmentShader_Prepass )
 	{
-		delete pFragmentShader_Model;
-		pFragmentShader_Model = BIT_NULL;
+		delete pFragmentShader_Prepass;
+		pFragmentShader_Prepass = BIT_NULL;
 	}
 
 	if( pPostProcessingBloom )
@@ -409,22 +700,34 @@ int CloseApplication( const int p_Code )
 		pPostProcessingBloom = BIT_NULL;
 	}
 
-	if( pFramebuffer )
+	if( pPostProcessingDualBloom )
 	{
-		delete pFramebuffer;
-		pFramebuffer = BIT_NULL;
+		delete pPostProcessingDualBloom;
+		pPostProcessingDualBloom = BIT_NULL;
 	}
 
-	if( pColorTexture )
+	if( pDeferredRenderer )
 	{
-		delete pColorTexture;
-		pColorTexture = BIT_NULL;
+		delete pDeferredRenderer;
+		pDeferredRenderer = BIT_NULL;
+	}
+
+	if( pLightClusterGrid )
+	{
+		delete pLightClusterGrid;
+		pLightClusterGrid = BIT_NULL;
+	}
+
+	if( pRenderGraph )
+	{
+		delete pRenderGraph;
+		pRenderGraph = BIT_NULL;
 	}
 
-	if( pDepthTexture )
+	if( pColorTexture )
 	{
-		delete pDepthTexture;
-		pDepthTexture = BIT_NULL;
+		delete pColorTexture;
+		pColorTexture = BIT_NULL;
 	}
 
 	if( pFullscreenVertexObject )
@@ -471,6 +774,10 @@ void InitializeMatrixManager( )
 	// Model view
 	Bit::MatrixManager::SetMode( Bit::MatrixManager::Mode_ModelView );
 	Bit::MatrixManager::LoadIdentity( );
+
+	// Frame uniforms
+	FrameUniforms.SetProjectionMatrix( Bit::MatrixManager::GetMatrix( Bit::MatrixManager::Mode_Projection ) );
+	FrameUniforms.SetLightPosition( Bit::Vector3_f32( 1.0f, 100.0f, 0.0f ) );
 }
 
 void InitializeCamera( )
@@ -486,6 +793,7 @@ void InitializeCamera( )
 	// Set the matrix to the matrix manager
 	Bit::MatrixManager::SetMode( Bit::MatrixManager::Mode_ModelView );
 	Bit::MatrixManager::SetMatrix( ViewCamera.GetMatrix( ) );
+	FrameUniforms.SetViewMatrix( ViewCamera.GetMatrix( ) );
 }
 
 BIT_UINT32 CreateWindow( )
@@ -562,39 +870,40 @@ BIT_UINT32 CreateGraphicDevice( )
 
 BIT_UINT32 CreateFullscreenRendering( )
 {
-	// Create the textures
-	if( ( pColorTexture = pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
+	// Load the resolution controller, it sizes the scene textures
+	if( ResolutionController.Load( SponzaSettings.GetWindowSize( ),
+		SponzaSettings.GetMinResolutionScale( ), SponzaSettings.GetMaxResolutionScale( ) ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not create the fullscreen color texture\n" );
+		bitTrace( "[Error] Can not load the dynamic resolution controller\n" );
 		return BIT_ERROR;
 	}
 
-	if( ( pDepthTexture = pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
-	{
-		bitTrace( "[Error] Can not create the fullscreen depth texture\n" );
-		return BIT_ERROR;
-	}
+	ResolutionController.SetTargetFrameTime( SponzaSettings.GetTargetFrameTime( ) );
+	ResolutionController.SetGains( SponzaSettings.GetResolutionGainP( ), SponzaSettings.GetResolutionGainI( ) );
+	RenderViewportSize = ResolutionController.GetViewportSize( );
 
-	// Load the textures
-	if( pColorTexture->Load( SponzaSettings.GetWindowSize( ), Bit::RGB, Bit::RGB, Bit::Type_UChar8, BIT_NULL ) != BIT_OK )
+	// Create the color texture, the engine's bloom needs it at creation time
+	// so it's imported into the render graph instead of being transient.
+	if( ( pColorTexture = pGraphicDevice->CreateTexture( ) ) == BIT_NULL )
 	{
-		bitTrace( "[Error] Can not load the fullscreen color texture\n" );
+		bitTrace( "[Error] Can not create the fullscreen color texture\n" );
 		return BIT_ERROR;
 	}
 
-	if( pDepthTexture->Load( SponzaSettings.GetWindowSize( ), Bit::Depth, Bit::Depth, Bit::Type_Float32, BIT_NULL ) != BIT_OK )
+	// Load the texture
+	if( pColorTexture->Load( ResolutionController.GetTargetSize( ), Bit::RGB, Bit::RGB, Bit::Type_UChar8, BIT_NULL ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not load the fullscreen depth texture\n" );
+		bitTrace( "[Error] Can not load the fullscreen color texture\n" );
 		return BIT_ERROR;
 	}
 
-	// Set texture filters
+	// Set texture filters, the composite upscales the viewport bilinearly
 	Bit::Texture::eFilter TextureFilters[ ] =
 	{
-		Bit::Texture::Filter_Min, Bit::Texture::Filter_Nearest,
-		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Nearest,
-		Bit::Texture::Filter_Wrap_X, Bit::Texture::Filter_Repeat,
-		Bit::Texture::Filter_Wrap_Y, Bit::Texture::Filter_Repeat,
+		Bit::Texture::Filter_Min, Bit::Texture::Filter_Linear,
+		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Linear,
+		Bit::Texture::Filter_Wrap_X, Bit::Texture::Filter_Clamp,
+		Bit::Texture::Filter_Wrap_Y, Bit::Texture::Filter_Clamp,
 		Bit::Texture::Filter_None, Bit::Texture::Filter_None
 	};
 
@@ -604,50 +913,41 @@ BIT_UINT32 CreateFullscreenRendering( )
 		return BIT_ERROR;
 	}
 
-	if( pDepthTexture->SetFilters( TextureFilters ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not set the fullscreen depth texture filers\n" );
-		return BIT_ERROR;
-	}
-
-
-	// Create the frame buffer
-	if( ( pFramebuffer = pGraphicDevice->CreateFramebuffer( ) ) == BIT_NULL )
-	{
-		bitTrace( "[Error] Can not create the framebuffer texture\n" );
-		return BIT_ERROR;
-	}
+	// Create the render graph
+	pRenderGraph = new RenderGraph( pGraphicDevice, SponzaSettings.GetWindowSize( ) );
 
-	// Attach the texture to the framebuffer
-	if( pFramebuffer->Attach( pColorTexture ) != BIT_OK )
+	// Create the fullscreen vertex object
+	if( ( pFullscreenVertexObject = CreateFullscreenVertexObject( SponzaSettings.GetWindowSize( ) ) ) == BIT_NULL )
 	{
-		bitTrace( "[Error] Can not create attach the color texture to the framebuffer\n" );
+		bitTrace( "[Error] Can not create the fullscreen vertex object\n" );
 		return BIT_ERROR;
 	}
 
-	if( pFramebuffer->Attach( pDepthTexture ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not create attach the depth texture to the framebuffer\n" );
-		return BIT_ERROR;
-	}
+	return BIT_OK;
+}
 
+Bit::VertexObject * CreateFullscreenVertexObject( const Bit::Vector2_ui32 p_Size )
+{
 	// Create the fullscreen vertex object
-	if( ( pFullscreenVertexObject = pGraphicDevice->CreateVertexObject( ) ) == BIT_NULL )
+	Bit::VertexObject * pVertexObject = BIT_NULL;
+	if( ( pVertexObject = pGraphicDevice->CreateVertexObject( ) ) == BIT_NULL )
 	{
 		bitTrace( "[Error] Can not create the fullscreen vertex object\n" );
-		return BIT_ERROR;
+		return BIT_NULL;
 	}
 
 	// Load the fullscreen vertex object
+	const BIT_FLOAT32 Width = static_cast<BIT_FLOAT32>( p_Size.x );
+	const BIT_FLOAT32 Height = static_cast<BIT_FLOAT32>( p_Size.y );
 
 	BIT_FLOAT32 VertexPositions[ 18 ] =
 	{
 		0.0f, 0.0f, 0.0f,
-		static_cast<BIT_FLOAT32>(SponzaSettings.GetWindowSize( ).x), 0.0f, 0.0f,
-		static_cast<BIT_FLOAT32>(SponzaSettings.GetWindowSize( ).x), static_cast<BIT_FLOAT32>(SponzaSettings.GetWindowSize( ).y), 0.0f,
+		Width, 0.0f, 0.0f,
+		Width, Height, 0.0f,
 		0.0f, 0.0f, 0.0f,
-		static_cast<BIT_FLOAT32>(SponzaSettings.GetWindowSize( ).x), static_cast<BIT_FLOAT32>(SponzaSettings.GetWindowSize( ).y), 0.0f,
-		0.0f, static_cast<BIT_FLOAT32>(SponzaSettings.GetWindowSize( ).y), 0.0f
+		Width, Height, 0.0f,
+		0.0f, Height, 0.0f
 	};
 
 	BIT_FLOAT32 VertexTextures[ 12 ] =
@@ -656,32 +956,22 @@ BIT_UINT32 CreateFullscreenRendering( )
 		0.0f, 0.0f,		1.0f, 1.0f,		0.0f, 1.0f
 	};
 
-	// SLOW WAY
-
-
-	if( pFullscreenVertexObject->AddVertexBuffer( VertexPositions, 3, Bit::Type_Float32 ) != BIT_OK )
+	if( pVertexObject->AddVertexBuffer( VertexPositions, 3, Bit::Type_Float32 ) != BIT_OK ||
+		pVertexObject->AddVertexBuffer( VertexTextures, 2, Bit::Type_Float32 ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not add vertex position buffer to the fullscreen vertex object\n" );
-		return BIT_ERROR;
-	}
-	if( pFullscreenVertexObject->AddVertexBuffer( VertexTextures, 2, Bit::Type_Float32 ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not add vertex texture buffer to the fullscreen vertex object\n" );
-		return BIT_ERROR;
+		bitTrace( "[Error] Can not add the vertex buffers to the fullscreen vertex object\n" );
+		delete pVertexObject;
+		return BIT_NULL;
 	}
 
-	if( pFullscreenVertexObject->Load( 2, 3 ) != BIT_OK )
+	if( pVertexObject->Load( 2, 3 ) != BIT_OK )
 	{
 		bitTrace( "[Error] Can not load the fullscreen vertex object\n" );
-		return BIT_ERROR;
+		delete pVertexObject;
+		return BIT_NULL;
 	}
-	/*if( pFullscreenVertexObject->LoadFullscreenQuad( WindowSize ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not load the fullscreen vertex object\n" );
-		return BIT_ERROR;
-	}*/
 
-	return BIT_OK;
+	return pVertexObject;
 }
 
 BIT_UINT32 CreatePostProcessing( )
@@ -700,235 +990,1560 @@ BIT_UINT32 CreatePostProcessing( )
 		return BIT_ERROR;
 	}
 
+	// Create and load the dual filter bloom effect, the render graph owns its render targets
+	pPostProcessingDualBloom = new PostProcessingDualBloom( pGraphicDevice, pFullscreenVertexObject, pColorTexture );
+	if( pPostProcessingDualBloom->Load( SponzaSettings.GetWindowSize( ), SponzaSettings.GetBloomLevels( ),
+		SponzaSettings.GetBloomThreshold( ), SponzaSettings.GetBloomIntensity( ), BIT_FALSE ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the dual filter bloom post-processing effect.\n" );
+		return BIT_ERROR;
+	}
+
+	// The color texture is larger than the window with a maximum scale above 1
+	pPostProcessingDualBloom->SetSourceSize( ResolutionController.GetTargetSize( ) );
+	pPostProcessingDualBloom->SetSourceScale( ResolutionController.GetTextureScale( ) );
+
 	return BIT_OK;
 }
 
-
-BIT_UINT32 CreateModel( )
+BIT_UINT32 BuildRenderGraph( )
 {
-	// Allocate the image
-	if( ( pLevelModel = pGraphicDevice->CreateModel( Bit::Model::Model_OBJ ) ) == BIT_NULL )
-	{
-		bitTrace( "[Error] Can not create the model\n" );
-	}
+	pRenderGraph->Reset( );
 
-	Bit::Timer Timer;
-	Timer.Start( );
+	// Scene textures, sized for the largest resolution scale
+	const Bit::Vector2_ui32 Size = ResolutionController.GetTargetSize( );
+	const BIT_UINT32 Color = pRenderGraph->ImportTexture( "SceneColor", pColorTexture,
+		RenderGraph::TextureDescription( Size, RenderGraph::Format_RGB8, BIT_FALSE ) );
 
-	BIT_UINT32 Status = BIT_OK;
-	if( ( Status = pLevelModel->ReadFile( Bit::GetAbsolutePath( LevelModelPath ).c_str( ) ) ) != BIT_OK )
+	// Scene passes, the clustered path only swaps the programs of the forward scene pass
+	if( SponzaSettings.GetLightingMode( ) == Settings::Lighting_Deferred )
 	{
-		if( Status == BIT_ERROR_OPEN_FILE )
-		{
-			bitTrace( "[Error] Can not open the file\n" );
-		}
-		else
-		{
-			bitTrace( "[Error] Can not read the model file\n" );
-		}
+		pDeferredRenderer->AddPasses( *pRenderGraph, Color );
+	}
+	else
+	{
+		const BIT_UINT32 Depth = pRenderGraph->CreateTexture( "SceneDepth",
+			RenderGraph::TextureDescription( Size, RenderGraph::Format_Depth32F, BIT_FALSE ) );
 
-		return BIT_ERROR;
+		const BIT_UINT32 ScenePass = pRenderGraph->AddPass( "Scene", ExecuteScenePass, BIT_NULL );
+		pRenderGraph->Write( ScenePass, Color );
+		pRenderGraph->Write( ScenePass, Depth );
 	}
 
-	// Load the model
-	BIT_UINT32 ModelVerteBits = Bit::VertexObject::Vertex_Position | Bit::VertexObject::Vertex_Texture
-		| Bit::VertexObject::Vertex_Normal | Bit::VertexObject::Vertex_Tangent | Bit::VertexObject::Vertex_Binormal;
-	Bit::Texture::eFilter TextureFilters[ ] =
+	// Bloom passes, the dual filter chain is always declared and culled when it's unused.
+	// Without bloom the dual filter composite is a copy and the chain isn't declared at all.
+	pPostProcessingDualBloom->SetEnabled( BloomMode == Bloom_DualFilter );
+	pPostProcessingDualBloom->AddPasses( *pRenderGraph, Color, BloomMode != Bloom_Engine );
+
+	if( BloomMode == Bloom_Engine )
 	{
-		Bit::Texture::Filter_Min, Bit::Texture::Filter_Linear_Mipmap,
-		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Linear_Mipmap,
-		Bit::Texture::Filter_None, Bit::Texture::Filter_None
-	};
-	if( pLevelModel->Load( ModelVerteBits, TextureFilters, BIT_TRUE ) != BIT_OK )
+		const BIT_UINT32 BloomPass = pRenderGraph->AddPass( "EngineBloom", ExecuteBloomPass, BIT_NULL, BIT_TRUE );
+		pRenderGraph->Read( BloomPass, Color );
+	}
+
+	if( pRenderGraph->Compile( ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not load the model\n" );
+		bitTrace( "[Error] Can not compile the render graph.\n" );
 		return BIT_ERROR;
 	}
 
-	Timer.Stop( );
-	bitTrace( "Model load time: %f ms.\n", Timer.GetTime( ) * 1000.0f );
-
+	pRenderGraph->PrintStatistics( );
 	return BIT_OK;
 }
 
-BIT_UINT32 CreateModelShader( )
+void ExecuteScenePass( RenderGraph & /* p_Graph */, void * /* p_pUserData */ )
 {
-	// Shader sources
-	static const std::string VertexSource =
-		"#version 330 \n"
-		"precision highp float; \n"
-
-		"in vec3 Position; \n"
-		"in vec2 Texture; \n"
-		"in vec3 Normal; \n"
-		"in vec3 Tangent; \n"
-		"in vec3 Binormal; \n"
+	pGraphicDevice->SetViewport( 0, 0, RenderViewportSize.x, RenderViewportSize.y );
+	pGraphicDevice->EnableDepthTest( );
 
-		"out vec3 out_Position; \n"
-		"out vec2 out_Texture; \n"
-		"out vec3 out_Normal; \n"
-		"out vec3 out_Tangent; \n"
-		"out vec3 out_Binormal; \n"
-		"out mat3 out_TangentSpace; \n"
+	// Clear the buffers
+	pGraphicDevice->ClearColor( );
+	pGraphicDevice->ClearDepth( );
 
-		"uniform mat4 ProjectionMatrix; \n"
-		"uniform mat4 ViewMatrix; \n"
+	// The shader variant of the lighting path and the toggles
+	const BIT_UINT32 Key = GetModelPermutationKey( );
 
-		"void main(void) \n"
-		"{ \n"
+	if( SponzaSettings.GetLightingMode( ) == Settings::Lighting_Clustered )
+	{
+		// Assign the lights to the clusters of this frame's view
+		const FrameUniformBlock::Data & FrameData = FrameUniforms.GetData( );
+		pLightClusterGrid->Assign( SceneLights, FrameData.ViewMatrix, FrameData.ProjectionMatrix,
+			FrameUniforms.GetMemberVersion( FrameUniformBlock::Member_ProjectionMatrix | FrameUniformBlock::Member_ViewMatrix ) );
+		pLightClusterGrid->Upload( SceneLights );
+		pLightClusterGrid->Bind( 2, 3, 4 );
+	}
 
-		// Set some out values
-		"	vec4 NewPosition = vec4( Position, 1.0 ); \n"
-		"	out_Position = NewPosition.xyz; \n"
-		"	out_Texture = Texture; \n"
-		"	out_Normal = normalize( Normal ); \n"
-		"	out_Tangent = normalize( Tangent ); \n"
-		"	out_Binormal = normalize( Binormal ); \n"
+	if( SponzaSettings.GetUseDepthPrepass( ) )
+	{
+		RenderDepthPrepass( );
 
-		// Calculate the tangent space matrix
-		"	out_TangentSpace[ 0 ] = out_Tangent; \n"
-		"	out_TangentSpace[ 1 ] = out_Binormal; \n"
-		"	out_TangentSpace[ 2 ] = out_Normal; \n"
+		// Only the closest fragment of every pixel reaches the lighting shader
+		GLint DepthFunction = GL_LESS;
+		glGetIntegerv( GL_DEPTH_FUNC, &DepthFunction );
+		glDepthMask( GL_FALSE );
+		glDepthFunc( GL_EQUAL );
 
-		// Set the output position
-		"	gl_Position = ProjectionMatrix * ViewMatrix * NewPosition; \n"
+		RenderModel( Key );
 
-		"} \n";
+		glDepthFunc( DepthFunction );
+		glDepthMask( GL_TRUE );
+	}
+	else
+	{
+		RenderModel( AlphaTestedMaterialCount > 0 ? Key | ModelFeature_AlphaTest : Key );
+	}
 
-	static const std::string FragmentSource =
-		"#version 330 \n"
-		"precision highp float; \n"
+	// The post-processing passes run without depth
+	pGraphicDevice->DisableDepthTest( );
+}
 
-		"in vec3 out_Position; \n"
-		"in vec2 out_Texture; \n"
-		"in vec3 out_Normal; \n"
-		"in vec3 out_Tangent; \n"
-		"in vec3 out_Binormal; \n"
-		"in vec3 out_LightVec; \n"
-		"in mat3 out_TangentSpace; \n"
+void RenderDepthPrepass( )
+{
+	glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
 
-		"out vec4 out_Color; \n"
+	pShaderProgram_Prepass->Bind( );
+	FrameUniforms.Apply( *pUniforms_Prepass, FrameMembers_Prepass );
+	pLevelModel->Render( Bit::VertexObject::RenderMode_Triangles );
+	pShaderProgram_Prepass->Unbind( );
 
-		"uniform sampler2D DiffuseTexture; \n"
-		"uniform sampler2D NormalTexture; \n"
-		"uniform vec3 LightPosition; \n"
-		"uniform int UseNormalMapping; \n"
+	FrameCounters.DrawCalls++;
+	FrameCounters.Triangles += LevelTriangleCount;
+	FrameCounters.Binds++;
 
+	glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+}
 
-		"void main(void) \n"
+void RenderModel( const BIT_UINT32 p_Key )
+{
+	// Get the shader variant, it's compiled the first time it's used
+	ShaderPermutations::Permutation * pPermutation = pModelPermutations->Get( p_Key );
+	if( pPermutation == BIT_NULL )
+	{
+		return;
+	}
+
+	// Bind the model shader program
+	pPermutation->pShaderProgram->Bind( );
+
+	// Upload the parts of the frame block the model shader hasn't seen yet
+	FrameUniforms.Apply( *pPermutation->pUniforms, FrameMembers_Model );
+
+	// The clusters cover the viewport, it changes with the resolution scale
+	if( p_Key & ModelFeature_Clustered )
+	{
+		pPermutation->pUniforms->SetUniform2f( ScreenSizeHandle,
+			static_cast< BIT_FLOAT32 >( RenderViewportSize.x ), static_cast< BIT_FLOAT32 >( RenderViewportSize.y ) );
+	}
+
+	// Render the model
+	pLevelModel->Render( Bit::VertexObject::RenderMode_Triangles );
+
+	// Unbind the shader program
+	pPermutation->pShaderProgram->Unbind( );
+
+	FrameCounters.DrawCalls++;
+	FrameCounters.Triangles += LevelTriangleCount;
+	FrameCounters.Binds++;
+}
+
+BIT_UINT64 CountFragments( const BIT_BOOL p_DepthTest, const BIT_BOOL p_Prepass )
+{
+	// Every fragment adds 1/255 to the red channel of the back buffer,
+	// a pixel saturates after 255 layers which Sponza never gets close to.
+	const Bit::Vector2_ui32 Size = SponzaSettings.GetWindowSize( );
+	pGraphicDevice->BindDefaultFramebuffer( );
+	pGraphicDevice->SetViewport( 0, 0, Size.x, Size.y );
+	pGraphicDevice->EnableDepthTest( );
+	pGraphicDevice->ClearColor( );
+	pGraphicDevice->ClearDepth( );
+
+	GLint DepthFunction = GL_LESS;
+	glGetIntegerv( GL_DEPTH_FUNC, &DepthFunction );
+
+	if( p_Prepass )
+	{
+		RenderDepthPrepass( );
+		glDepthMask( GL_FALSE );
+		glDepthFunc( GL_EQUAL );
+	}
+	else if( !p_DepthTest )
+	{
+		pGraphicDevice->DisableDepthTest( );
+	}
+
+	// The pre-pass program runs the same alpha test as the model program
+	glBlendFunc( GL_ONE, GL_ONE );
+	pShaderProgram_Prepass->Bind( );
+	FrameUniforms.Apply( *pUniforms_Prepass, FrameMembers_Prepass );
+	pUniforms_Prepass->SetUniform1f( FragmentWeightHandle, 1.0f / 255.0f );
+	pLevelModel->Render( Bit::VertexObject::RenderMode_Triangles );
+	pUniforms_Prepass->SetUniform1f( FragmentWeightHandle, 0.0f );
+	pShaderProgram_Prepass->Unbind( );
+	pGraphicDevice->EnableAlpha( );
+
+	glDepthFunc( DepthFunction );
+	glDepthMask( GL_TRUE );
+	pGraphicDevice->EnableDepthTest( );
+
+	// Read back and sum up the layers
+	std::vector< BIT_UINT8 > Pixels( Size.x * Size.y * 3 );
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	glReadPixels( 0, 0, Size.x, Size.y, GL_RGB, GL_UNSIGNED_BYTE, &Pixels[ 0 ] );
+
+	BIT_UINT64 Count = 0;
+	for( BIT_MEMSIZE i = 0; i < Pixels.size( ); i += 3 )
+	{
+		Count += Pixels[ i ];
+	}
+
+	pGraphicDevice->Present( );
+	return Count;
+}
+
+void RunPrepassBenchmark( )
+{
+	static const BIT_UINT32 Iterations = 100;
+	const Bit::Vector2_ui32 Size = SponzaSettings.GetWindowSize( );
+	const BIT_FLOAT64 PixelCount = static_cast< BIT_FLOAT64 >( Size.x * Size.y );
+
+	// Fragment counts, the alpha test disables early depth testing so every
+	// rasterized fragment runs the lighting shader without the pre-pass.
+	const BIT_UINT64 Rasterized = CountFragments( BIT_FALSE, BIT_FALSE );
+	const BIT_UINT64 DepthPassed = CountFragments( BIT_TRUE, BIT_FALSE );
+	const BIT_UINT64 DepthEqual = CountFragments( BIT_TRUE, BIT_TRUE );
+
+	bitTrace( "Depth pre-pass benchmark at %ux%u, %u alpha tested materials:\n",
+		Size.x, Size.y, AlphaTestedMaterialCount );
+	bitTrace( "  Rasterized fragments:       %.2f M (overdraw %.2f)\n",
+		static_cast< BIT_FLOAT64 >( Rasterized ) / 1000000.0, static_cast< BIT_FLOAT64 >( Rasterized ) / PixelCount );
+	bitTrace( "  Fragments passing depth:    %.2f M (overdraw %.2f)\n",
+		static_cast< BIT_FLOAT64 >( DepthPassed ) / 1000000.0, static_cast< BIT_FLOAT64 >( DepthPassed ) / PixelCount );
+	bitTrace( "  Shaded after the pre-pass:  %.2f M (overdraw %.2f)\n",
+		static_cast< BIT_FLOAT64 >( DepthEqual ) / 1000000.0, static_cast< BIT_FLOAT64 >( DepthEqual ) / PixelCount );
+	if( Rasterized > 0 )
+	{
+		bitTrace( "  Lighting shader invocations saved: %.1f%%\n",
+			100.0 - static_cast< BIT_FLOAT64 >( DepthEqual ) * 100.0 / static_cast< BIT_FLOAT64 >( Rasterized ) );
+	}
+
+	// Frame times, Present( ) every iteration so the driver can't queue up the work
+	const BIT_BOOL UseDepthPrepass = SponzaSettings.GetUseDepthPrepass( );
+	BIT_FLOAT64 Times[ 2 ];
+
+	for( BIT_UINT32 i = 0; i < 2; i++ )
+	{
+		SponzaSettings.SetUseDepthPrepass( i == 1 );
+
+		Bit::Timer Timer;
+		Timer.Start( );
+		for( BIT_UINT32 j = 0; j < Iterations; j++ )
+		{
+			pRenderGraph->Execute( );
+			pGraphicDevice->Present( );
+		}
+		Timer.Stop( );
+
+		Times[ i ] = Timer.GetTime( ) * 1000.0f / static_cast<BIT_FLOAT64>( Iterations );
+	}
+
+	SponzaSettings.SetUseDepthPrepass( UseDepthPrepass );
+	bitTrace( "  Frame time: %.3f ms without, %.3f ms with the pre-pass\n", Times[ 0 ], Times[ 1 ] );
+}
+
+void RunClusteredBenchmark( )
+{
+	// Light counts from 1 to 4096, the scene pass is timed by the render graph
+	static const BIT_UINT32 Iterations = 50;
+	const BIT_UINT32 LightingMode = SponzaSettings.GetLightingMode( );
+	const BIT_UINT32 LightCount = SponzaSettings.GetLightCount( );
+
+	SponzaSettings.SetLightingMode( Settings::Lighting_Clustered );
+	if( BuildRenderGraph( ) != BIT_OK )
+	{
+		return;
+	}
+	pRenderGraph->SetTimingEnabled( BIT_TRUE );
+
+	bitTrace( "Clustered forward benchmark, %ux%ux%u clusters, %u threads, %u frames per light count:\n",
+		ClusterGridX, ClusterGridY, ClusterGridZ, pLightClusterGrid->GetThreadCount( ), Iterations );
+
+	for( BIT_UINT32 Count = 1; Count <= MaxLightCount; Count *= 2 )
+	{
+		SponzaSettings.SetLightCount( Count );
+		SceneLights.Generate( Count, LightBoundsMin, LightBoundsMax, 150.0f, 400.0f, LightSeed );
+		pRenderGraph->ResetTimings( );
+
+		BIT_FLOAT64 AssignTime = 0.0f;
+		BIT_FLOAT64 UploadTime = 0.0f;
+		for( BIT_UINT32 i = 0; i < Iterations; i++ )
+		{
+			pRenderGraph->Execute( );
+			pGraphicDevice->Present( );
+			AssignTime += pLightClusterGrid->GetAssignTime( );
+			UploadTime += pLightClusterGrid->GetUploadTime( );
+		}
+
+		// The scene pass is the first pass, its time includes the assignment and the upload
+		AssignTime /= static_cast< BIT_FLOAT64 >( Iterations );
+		UploadTime /= static_cast< BIT_FLOAT64 >( Iterations );
+		const BIT_FLOAT64 ShadingTime = pRenderGraph->GetPassTime( 0 ) - AssignTime - UploadTime;
+
+		bitTrace( "  %4u lights  assignment: %7.3f ms  upload: %6.3f ms  shading: %7.3f ms  indices: %7u%s\n",
+			Count, AssignTime, UploadTime, ShadingTime,
+			pLightClusterGrid->GetIndexCount( ), pLightClusterGrid->GetOverflow( ) ? " (overflow)" : "" );
+	}
+
+	// Restore the settings
+	pRenderGraph->SetTimingEnabled( BIT_FALSE );
+	SponzaSettings.SetLightingMode( LightingMode );
+	SponzaSettings.SetLightCount( LightCount );
+	GenerateLights( );
+	BuildRenderGraph( );
+}
+
+void ExecuteBloomPass( RenderGraph & /* p_Graph */, void * /* p_pUserData */ )
+{
+	pGraphicDevice->ClearColor( );
+	pPostProcessingBloom->Process( );
+}
+
+void RunBloomBenchmark( )
+{
+	// Both effects are run back to back on an empty color texture,
+	// Present( ) is called every iteration so the driver can't queue up the work.
+	static const BIT_UINT32 Iterations = 200;
+	static const Bit::Vector2_ui32 Resolutions[ ] =
+	{
+		Bit::Vector2_ui32( 800, 600 ),
+		Bit::Vector2_ui32( 1280, 720 ),
+		Bit::Vector2_ui32( 1400, 1000 ),
+		Bit::Vector2_ui32( 1920, 1080 )
+	};
+
+	pGraphicDevice->DisableDepthTest( );
+	bitTrace( "Bloom benchmark, %u iterations per resolution:\n", Iterations );
+
+	for( BIT_MEMSIZE i = 0; i < sizeof( Resolutions ) / sizeof( Resolutions[ 0 ] ); i++ )
+	{
+		const Bit::Vector2_ui32 Size = Resolutions[ i ];
+
+		// Create the resources for this resolution
+		Bit::Texture * pTexture = pGraphicDevice->CreateTexture( );
+		Bit::VertexObject * pVertexObject = CreateFullscreenVertexObject( Size );
+		Bit::PostProcessingBloom * pBloom = BIT_NULL;
+		PostProcessingDualBloom * pDualBloom = BIT_NULL;
+
+		if( pTexture && pVertexObject &&
+			pTexture->Load( Size, Bit::RGB, Bit::RGB, Bit::Type_UChar8, BIT_NULL ) == BIT_OK &&
+			( pBloom = pGraphicDevice->CreatePostProcessingBloom( pVertexObject, pTexture ) ) != BIT_NULL &&
+			pBloom->Load( 0.25f, 2, 1.0f ) == BIT_OK )
+		{
+			pDualBloom = new PostProcessingDualBloom( pGraphicDevice, pVertexObject, pTexture );
+		}
+
+		if( pDualBloom == BIT_NULL || pDualBloom->Load( Size, SponzaSettings.GetBloomLevels( ),
+			SponzaSettings.GetBloomThreshold( ), SponzaSettings.GetBloomIntensity( ) ) != BIT_OK )
+		{
+			bitTrace( "[Error] Can not load the bloom effects for %ux%u\n", Size.x, Size.y );
+		}
+		else
+		{
+			Bit::Timer Timer;
+
+			// Engine bloom
+			Timer.Start( );
+			for( BIT_UINT32 j = 0; j < Iterations; j++ )
+			{
+				pGraphicDevice->SetViewport( 0, 0, Size.x, Size.y );
+				pBloom->Process( );
+				pGraphicDevice->Present( );
+			}
+			Timer.Stop( );
+			const BIT_FLOAT64 BloomTime = Timer.GetTime( ) * 1000.0f / static_cast<BIT_FLOAT64>( Iterations );
+
+			// Dual filter bloom
+			Timer.Start( );
+			for( BIT_UINT32 j = 0; j < Iterations; j++ )
+			{
+				pDualBloom->Process( );
+				pGraphicDevice->Present( );
+			}
+			Timer.Stop( );
+			const BIT_FLOAT64 DualBloomTime = Timer.GetTime( ) * 1000.0f / static_cast<BIT_FLOAT64>( Iterations );
+
+			bitTrace( "  %4ux%-4u  engine: %.3f ms  dual filter (%u levels): %.3f ms  %.2fx\n",
+				Size.x, Size.y, BloomTime, pDualBloom->GetLevelCount( ), DualBloomTime, BloomTime / DualBloomTime );
+		}
+
+		// Clean up
+		delete pDualBloom;
+		delete pBloom;
+		delete pVertexObject;
+		delete pTexture;
+	}
+
+	// Restore the viewport
+	pGraphicDevice->SetViewport( 0, 0, SponzaSettings.GetWindowSize( ).x, SponzaSettings.GetWindowSize( ).y );
+}
+
+void RunGUIBenchmark( )
+{
+	// A grid of checkboxes over the window, rendered per widget, batched and retained.
+	// One checkbox is toggled every tenth frame, the retained mode skips the other frames.
+	// The CPU time only covers Render( ), the frame time waits for the GPU as well.
+	static const BIT_UINT32 Iterations = 100;
+	static const BIT_UINT32 WidgetCount = 10000;
+	static const BIT_UINT32 Columns = 100;
+	static const BIT_UINT32 ToggleInterval = 10;
+	static const char * ModeNames[ 3 ] = { "batched", "per widget", "retained" };
+	static const GUIManager::eRenderMode Modes[ 3 ] =
+	{
+		GUIManager::Render_Batched, GUIManager::Render_PerWidget, GUIManager::Render_Retained
+	};
+	const Bit::Vector2_ui32 Size = SponzaSettings.GetWindowSize( );
+
+	GUIManager * pManager = new GUIManager( pGraphicDevice );
+	std::vector< GUICheckbox * > Checkboxes( WidgetCount );
+
+	pGraphicDevice->BindDefaultFramebuffer( );
+	pGraphicDevice->SetViewport( 0, 0, Size.x, Size.y );
+	pGraphicDevice->DisableDepthTest( );
+
+	if( pManager->Load( ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the GUI manager for the benchmark\n" );
+		delete pManager;
+		return;
+	}
+
+	for( BIT_UINT32 i = 0; i < WidgetCount; i++ )
+	{
+		const Bit::Vector2_si32 Position( ( i % Columns ) * Size.x / Columns, ( i / Columns ) * Size.y / Columns );
+		Checkboxes[ i ] = new GUICheckbox( Position, Bit::Vector2_ui32( 12, 8 ), ( i % 3 ) == 0 );
+		pManager->Add( Checkboxes[ i ] );
+	}
+
+	bitTrace( "GUI benchmark, %u checkboxes, %u iterations:\n", WidgetCount, Iterations );
+
+	for( BIT_UINT32 i = 0; i < 3; i++ )
+	{
+		pManager->SetRenderMode( Modes[ i ] );
+
+		// Warm up, compiles the shader variant and grows the batch
+		pManager->Render( );
+		glFinish( );
+		pManager->ResetLayerStatistics( );
+
+		BIT_FLOAT64 RenderTime = 0.0f;
+		Bit::Timer Timer;
+		Timer.Start( );
+		for( BIT_UINT32 j = 0; j < Iterations; j++ )
+		{
+			if( ( j % ToggleInterval ) == 0 )
+			{
+				GUICheckbox * pCheckbox = Checkboxes[ ( j * 7919 ) % WidgetCount ];
+				pCheckbox->SetStatus( !pCheckbox->GetStatus( ) );
+			}
+
+			pGraphicDevice->ClearColor( );
+			pManager->Render( );
+			RenderTime += pManager->GetRenderTime( );
+			glFinish( );
+			pGraphicDevice->Present( );
+		}
+		Timer.Stop( );
+
+		bitTrace( "  %-10s  draw calls: %5u  CPU: %.3f ms  frame: %.3f ms\n", ModeNames[ i ],
+			pManager->GetDrawCallCount( ), RenderTime / static_cast< BIT_FLOAT64 >( Iterations ),
+			Timer.GetTime( ) * 1000.0f / static_cast< BIT_FLOAT64 >( Iterations ) );
+
+		if( Modes[ i ] == GUIManager::Render_Retained )
+		{
+			bitTrace( "  %-10s  redrawn frames: %u  skipped frames: %u\n", "",
+				pManager->GetRedrawFrameCount( ), pManager->GetSkippedFrameCount( ) );
+		}
+	}
+
+	// Clean up
+	delete pManager;
+	for( BIT_UINT32 i = 0; i < WidgetCount; i++ )
+	{
+		delete Checkboxes[ i ];
+	}
+}
+
+void RunHitTestBenchmark( )
+{
+	// Synthetic mouse events over a grid of checkboxes, resolved through the GUI manager's
+	// grid and by a linear scan over every checkbox. Moving the checkboxes afterwards
+	// measures the incremental grid updates.
+	static const BIT_UINT32 EventCount = 100000;
+	static const BIT_UINT32 WidgetCount = 10000;
+	static const BIT_UINT32 Columns = 100;
+	const Bit::Vector2_ui32 Size = SponzaSettings.GetWindowSize( );
+
+	GUIManager * pManager = new GUIManager( pGraphicDevice );
+	std::vector< GUICheckbox * > Checkboxes( WidgetCount );
+
+	if( pManager->Load( ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the GUI manager for the benchmark\n" );
+		delete pManager;
+		return;
+	}
+
+	for( BIT_UINT32 i = 0; i < WidgetCount; i++ )
+	{
+		const Bit::Vector2_si32 Position( ( i % Columns ) * Size.x / Columns, ( i / Columns ) * Size.y / Columns );
+		Checkboxes[ i ] = new GUICheckbox( Position, Bit::Vector2_ui32( 12, 8 ), BIT_FALSE );
+		pManager->Add( Checkboxes[ i ] );
+	}
+
+	// Generate the events, mostly moves with a click now and then
+	std::vector< Bit::Event > Events( EventCount );
+	BIT_UINT32 RandomState = 1337;
+
+	for( BIT_UINT32 i = 0; i < EventCount; i++ )
+	{
+		RandomState = RandomState * 1664525 + 1013904223;
+		Events[ i ].Type = ( i % 10 ) == 8 ? Bit::Event::ButtonJustPressed :
+			( ( i % 10 ) == 9 ? Bit::Event::ButtonJustReleased : Bit::Event::MouseMoved );
+		Events[ i ].Button = RotateMouseButton;
+		Events[ i ].MousePosition = ( i % 10 ) == 9 ? Events[ i - 1 ].MousePosition :
+			Bit::Vector2_si32( ( RandomState >> 8 ) % Size.x, ( RandomState >> 20 ) % Size.y );
+	}
+
+	Bit::Timer Timer;
+
+	// Grid
+	BIT_UINT32 GridHits = 0;
+	Timer.Start( );
+	for( BIT_UINT32 i = 0; i < EventCount; i++ )
+	{
+		pManager->Update( Events[ i ] );
+		if( Events[ i ].Type == Bit::Event::MouseMoved && pManager->GetHoveredCheckbox( ) )
+		{
+			GridHits++;
+		}
+	}
+	Timer.Stop( );
+	const BIT_FLOAT64 GridTime = Timer.GetTime( ) * 1000.0f;
+
+	// Linear scan, the last checkbox is on top
+	BIT_UINT32 LinearHits = 0;
+	Timer.Start( );
+	for( BIT_UINT32 i = 0; i < EventCount; i++ )
+	{
+		if( Events[ i ].Type != Bit::Event::MouseMoved )
+		{
+			continue;
+		}
+
+		const Bit::Vector2_si32 Position( Events[ i ].MousePosition.x,
+			static_cast< BIT_SINT32 >( Size.y ) - 1 - Events[ i ].MousePosition.y );
+
+		for( BIT_SINT32 j = WidgetCount - 1; j >= 0; j-- )
+		{
+			const Bit::Vector2_si32 WidgetPosition = Checkboxes[ j ]->GetPosition( );
+			const Bit::Vector2_ui32 WidgetSize = Checkboxes[ j ]->GetSize( );
+
+			if( Position.x >= WidgetPosition.x && Position.y >= WidgetPosition.y &&
+				Position.x < WidgetPosition.x + static_cast< BIT_SINT32 >( WidgetSize.x ) &&
+				Position.y < WidgetPosition.y + static_cast< BIT_SINT32 >( WidgetSize.y ) )
+			{
+				LinearHits++;
+				break;
+			}
+		}
+	}
+	Timer.Stop( );
+	const BIT_FLOAT64 LinearTime = Timer.GetTime( ) * 1000.0f;
+
+	// Move every checkbox by a pixel, only the ones crossing a cell border are relinked
+	Timer.Start( );
+	for( BIT_UINT32 i = 0; i < WidgetCount; i++ )
+	{
+		const Bit::Vector2_si32 Position = Checkboxes[ i ]->GetPosition( );
+		Checkboxes[ i ]->SetPosition( Bit::Vector2_si32( Position.x + 1, Position.y ) );
+	}
+	Timer.Stop( );
+	const BIT_FLOAT64 MoveTime = Timer.GetTime( ) * 1000.0f;
+
+	const Bit::Vector2_ui32 GridSize = pManager->GetGrid( ).GetGridSize( );
+	bitTrace( "Hit-test benchmark, %u checkboxes, %u events, %ux%u grid cells:\n",
+		WidgetCount, EventCount, GridSize.x, GridSize.y );
+	bitTrace( "  Grid:         %.3f ms (%.1f ns per event)\n", GridTime,
+		GridTime * 1000000.0f / static_cast< BIT_FLOAT64 >( EventCount ) );
+	bitTrace( "  Linear scan:  %.3f ms, mouse moves only\n", LinearTime );
+	bitTrace( "  Hovered checkboxes: grid %u, linear %u\n", GridHits, LinearHits );
+	bitTrace( "  Moving %u checkboxes: %.3f ms, %u relinks\n", WidgetCount, MoveTime,
+		pManager->GetGrid( ).GetRelinkCount( ) );
+
+	// Clean up
+	delete pManager;
+	for( BIT_UINT32 i = 0; i < WidgetCount; i++ )
+	{
+		delete Checkboxes[ i ];
+	}
+}
+
+void RunTextBenchmark( )
+{
+	// Fills the window with lines of text, the layout time covers Begin( ) and Add( ),
+	// the frame time includes the draw and waits for the GPU.
+	static const BIT_UINT32 Iterations = 100;
+	static const BIT_UINT32 LineLength = 200;
+	const Bit::Vector2_ui32 Size = SponzaSettings.GetWindowSize( );
+
+	pGraphicDevice->BindDefaultFramebuffer( );
+	pGraphicDevice->SetViewport( 0, 0, Size.x, Size.y );
+	pGraphicDevice->DisableDepthTest( );
+
+	// Printable characters over and over
+	std::string Line( LineLength, ' ' );
+	for( BIT_UINT32 i = 0; i < LineLength; i++ )
+	{
+		Line[ i ] = static_cast< char >( '!' + ( i % 94 ) );
+	}
+
+	const BIT_UINT32 LineCount = Size.y / Text->GetGlyphSize( ).y;
+	const BIT_UINT32 DrawCallCount = GUI->GetDrawCallCount( );
+	BIT_FLOAT64 LayoutTime = 0.0f;
+	Bit::Timer FrameTimer;
+	Bit::Timer LayoutTimer;
+
+	FrameTimer.Start( );
+	for( BIT_UINT32 i = 0; i < Iterations; i++ )
+	{
+		LayoutTimer.Start( );
+		Text->Begin( );
+		for( BIT_UINT32 j = 0; j < LineCount; j++ )
+		{
+			Text->Add( Bit::Vector2_si32( 0, Size.y - j * Text->GetGlyphSize( ).y ), Line );
+		}
+		LayoutTimer.Stop( );
+		LayoutTime += LayoutTimer.GetTime( ) * 1000.0f;
+
+		pGraphicDevice->ClearColor( );
+		Text->Render( );
+		glFinish( );
+		pGraphicDevice->Present( );
+	}
+	FrameTimer.Stop( );
+
+	bitTrace( "Text benchmark, %u glyphs, %u iterations:\n", Text->GetGlyphCount( ), Iterations );
+	bitTrace( "  draw calls: %u  layout: %.3f ms  frame: %.3f ms\n", ( GUI->GetDrawCallCount( ) - DrawCallCount ) / Iterations,
+		LayoutTime / static_cast< BIT_FLOAT64 >( Iterations ),
+		FrameTimer.GetTime( ) * 1000.0f / static_cast< BIT_FLOAT64 >( Iterations ) );
+}
+
+BIT_UINT32 RunCameraBenchmark( )
+{
+	// Enough views for cascades, light views and reflection probes, far more than a frame needs
+	const BIT_UINT32 CameraCount = 4096;
+	const BIT_UINT32 Iterations = 100;
+
+	// The paths differ by about 1e-6, a broken sine/cosine or matrix layout is far off
+	const BIT_FLOAT32 Tolerance = 1.0e-4f;
+
+	// Spread the angles over every octant and the positions over the level
+	std::vector< Camera::ViewState > States( CameraCount );
+	for( BIT_UINT32 i = 0; i < CameraCount; i++ )
+	{
+		States[ i ].Pitch = static_cast< BIT_FLOAT32 >( ( i * 37 ) % 720 ) - 360.0f;
+		States[ i ].Yaw = static_cast< BIT_FLOAT32 >( ( i * 113 ) % 720 ) * 0.5f;
+		States[ i ].Roll = static_cast< BIT_FLOAT32 >( ( i * 7 ) % 21 ) - 10.0f;
+		States[ i ].Position = Bit::Vector3_f32( static_cast< BIT_FLOAT32 >( ( i * 251 ) % 4000 ) - 2000.0f,
+			static_cast< BIT_FLOAT32 >( ( i * 61 ) % 1500 ), static_cast< BIT_FLOAT32 >( ( i * 149 ) % 2000 ) - 1000.0f );
+	}
+
+	std::vector< Bit::Matrix4x4 > Reference( CameraCount );
+	std::vector< Bit::Matrix4x4 > Single( CameraCount );
+	std::vector< Bit::Matrix4x4 > Batch( CameraCount );
+	BIT_FLOAT64 Times[ 3 ] = { 0.0f, 0.0f, 0.0f };
+	Bit::Timer Timer;
+
+	for( BIT_UINT32 i = 0; i < Iterations; i++ )
+	{
+		// The rotate and translate chain the camera used to build
+		Timer.Start( );
+		for( BIT_UINT32 j = 0; j < CameraCount; j++ )
+		{
+			Bit::Matrix4x4 & Matrix = Reference[ j ];
+			Matrix.Identity( );
+			Matrix.RotateZ( States[ j ].Roll );
+			Matrix.RotateX( States[ j ].Pitch );
+			Matrix.RotateY( States[ j ].Yaw );
+			Matrix.Translate( -States[ j ].Position.x, -States[ j ].Position.y, -States[ j ].Position.z );
+		}
+		Timer.Stop( );
+		Times[ 0 ] += Timer.GetTime( ) * 1000.0f;
+
+		Timer.Start( );
+		for( BIT_UINT32 j = 0; j < CameraCount; j++ )
+		{
+			Camera::BuildViewMatrix( States[ j ], Single[ j ] );
+		}
+		Timer.Stop( );
+		Times[ 1 ] += Timer.GetTime( ) * 1000.0f;
+
+		Timer.Start( );
+		Camera::BuildViewMatrices( &States[ 0 ], &Batch[ 0 ], CameraCount );
+		Timer.Stop( );
+		Times[ 2 ] += Timer.GetTime( ) * 1000.0f;
+	}
+
+	// Largest difference, the translation relative to the size of the level
+	BIT_FLOAT32 Errors[ 2 ] = { 0.0f, 0.0f };
+	for( BIT_UINT32 i = 0; i < CameraCount; i++ )
+	{
+		for( BIT_UINT32 j = 0; j < 16; j++ )
+		{
+			const BIT_FLOAT32 Scale = j >= 12 ? 4000.0f : 1.0f;
+			const BIT_FLOAT32 SingleError = fabs( Single[ i ].m[ j ] - Reference[ i ].m[ j ] ) / Scale;
+			const BIT_FLOAT32 BatchError = fabs( Batch[ i ].m[ j ] - Reference[ i ].m[ j ] ) / Scale;
+			Errors[ 0 ] = SingleError > Errors[ 0 ] ? SingleError : Errors[ 0 ];
+			Errors[ 1 ] = BatchError > Errors[ 1 ] ? BatchError : Errors[ 1 ];
+		}
+	}
+
+	const char * Names[ 3 ] = { "rotate chain", "closed form", "batch" };
+	bitTrace( "Camera benchmark, %u view matrices, %u iterations:\n", CameraCount, Iterations );
+	for( BIT_UINT32 i = 0; i < 3; i++ )
+	{
+		const BIT_FLOAT64 Time = Times[ i ] / static_cast< BIT_FLOAT64 >( Iterations );
+		bitTrace( "  %-12s  %.3f ms (%.1f ns per camera)  %.2fx", Names[ i ], Time,
+			Time * 1000000.0f / static_cast< BIT_FLOAT64 >( CameraCount ), Times[ 0 ] / Times[ i ] );
+		if( i > 0 )
+		{
+			bitTrace( "  max error: %g %s", Errors[ i - 1 ], Errors[ i - 1 ] <= Tolerance ? "ok" : "FAIL" );
+		}
+		bitTrace( "\n" );
+	}
+
+	if( !( Errors[ 0 ] <= Tolerance && Errors[ 1 ] <= Tolerance ) )
+	{
+		bitTrace( "[Error] The closed form view matrices differ from the rotate chain by more than %g\n", Tolerance );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+BIT_BOOL EqualVectorArrays( const Vector3Array & p_A, const Vector3Array & p_B )
+{
+	const BIT_MEMSIZE Size = p_A.GetCount( ) * sizeof( BIT_FLOAT32 );
+	return p_A.GetCount( ) == p_B.GetCount( ) && memcmp( p_A.GetX( ), p_B.GetX( ), Size ) == 0 &&
+		memcmp( p_A.GetY( ), p_B.GetY( ), Size ) == 0 && memcmp( p_A.GetZ( ), p_B.GetZ( ), Size ) == 0;
+}
+
+void RunMathBenchmark( )
+{
+	// About the vertex and bounding volume count of a large scene
+	const BIT_UINT32 Count = 100000;
+	const BIT_UINT32 Iterations = 20;
+	const BIT_UINT32 KernelCount = 7;
+	const BIT_UINT32 PathCount = 2 + static_cast< BIT_UINT32 >( CpuFeatures::GetSupportedInstructionSet( ) );
+
+	// Points spread over the level, directions and box sizes from simple hashes of the index
+	std::vector< Bit::Vector3_f32 > Points( Count );
+	std::vector< Bit::Vector3_f32 > Directions( Count );
+	std::vector< Bit::Vector3_f32 > BoxMin( Count );
+	std::vector< Bit::Vector3_f32 > BoxMax( Count );
+	Vector3Array SoAPoints( Count );
+	Vector3Array SoADirections( Count );
+	Vector3Array SoABoxMin( Count );
+	Vector3Array SoABoxMax( Count );
+	std::vector< BIT_FLOAT32 > Radii( SoAPoints.GetPaddedCount( ), 0.0f );
+
+	for( BIT_UINT32 i = 0; i < Count; i++ )
+	{
+		const Bit::Vector3_f32 Size( static_cast< BIT_FLOAT32 >( i % 50 ) + 1.0f,
+			static_cast< BIT_FLOAT32 >( ( i * 7 ) % 30 ) + 1.0f, static_cast< BIT_FLOAT32 >( ( i * 13 ) % 40 ) + 1.0f );
+		Points[ i ] = Bit::Vector3_f32( static_cast< BIT_FLOAT32 >( ( i * 251 ) % 4000 ) - 2000.0f,
+			static_cast< BIT_FLOAT32 >( ( i * 61 ) % 1500 ), static_cast< BIT_FLOAT32 >( ( i * 149 ) % 2000 ) - 1000.0f );
+		Directions[ i ] = Bit::Vector3_f32( static_cast< BIT_FLOAT32 >( ( i * 17 ) % 201 ) - 100.0f,
+			static_cast< BIT_FLOAT32 >( ( i * 29 ) % 201 ) - 100.0f, static_cast< BIT_FLOAT32 >( ( i * 43 ) % 201 ) - 100.0f );
+		BoxMin[ i ] = Points[ i ] - Size;
+		BoxMax[ i ] = Points[ i ] + Size;
+
+		SoAPoints.Set( i, Points[ i ] );
+		SoADirections.Set( i, Directions[ i ] );
+		SoABoxMin.Set( i, BoxMin[ i ] );
+		SoABoxMax.Set( i, BoxMax[ i ] );
+		Radii[ i ] = Size.Length( );
+	}
+
+	// A camera in the middle of the atrium
+	Camera::ViewState State;
+	State.Pitch = 10.0f;
+	State.Yaw = 60.0f;
+	State.Roll = 0.0f;
+	State.Position = Bit::Vector3_f32( 0.0f, 200.0f, 0.0f );
+	Bit::Matrix4x4 View;
+	Camera::BuildViewMatrix( State, View );
+	Bit::Matrix4x4 Projection;
+	Projection.Perspective( 45.0f, 16.0f / 9.0f, 2.0f, 4000.0f );
+	Frustum ViewFrustum;
+	ViewFrustum.Extract( Projection * View );
+	const BIT_FLOAT32 * m = View.m;
+
+	// Results of the array of structures loops and of the kernels
+	std::vector< BIT_FLOAT32 > AoSDots( Count );
+	std::vector< Bit::Vector3_f32 > AoSVectors( Count );
+	std::vector< Bit::Vector3_f32 > AoSMin( Count );
+	std::vector< Bit::Vector3_f32 > AoSMax( Count );
+	std::vector< BIT_UINT8 > AoSVisible( Count );
+	std::vector< BIT_FLOAT32 > Dots;
+	Vector3Array Vectors;
+	Vector3Array Normals;
+	Vector3Array ResultMin;
+	Vector3Array ResultMax;
+	std::vector< BIT_UINT8 > Visible;
+
+	// The scalar kernel results every other instruction set is compared to
+	std::vector< BIT_FLOAT32 > ScalarDots;
+	Vector3Array ScalarVectors[ KernelCount ];
+	Vector3Array ScalarMax;
+	std::vector< BIT_UINT8 > ScalarVisible[ KernelCount ];
+
+	BIT_FLOAT64 Times[ KernelCount ][ 4 ];
+	BIT_BOOL Exact[ KernelCount ][ 4 ];
+	Bit::Timer Timer;
+
+	for( BIT_UINT32 Path = 0; Path < PathCount; Path++ )
+	{
+		if( Path > 0 )
+		{
+			MathKernels::SetInstructionSet( static_cast< CpuFeatures::eInstructionSet >( Path - 1 ) );
+		}
+
+		for( BIT_UINT32 k = 0; k < KernelCount; k++ )
+		{
+			Times[ k ][ Path ] = 0.0f;
+			Exact[ k ][ Path ] = BIT_TRUE;
+
+			for( BIT_UINT32 i = 0; i < Iterations; i++ )
+			{
+				// Normalize works in place
+				if( k == 2 && Path > 0 )
+				{
+					Normals = SoADirections;
+				}
+
+				Timer.Start( );
+				switch( k )
+				{
+					case 0:
+						if( Path == 0 )
+						{
+							for( BIT_UINT32 j = 0; j < Count; j++ )
+							{
+								AoSDots[ j ] = Points[ j ].Dot( Directions[ j ] );
+							}
+						}
+						else
+						{
+							MathKernels::Dot( SoAPoints, SoADirections, Dots );
+						}
+						break;
+					case 1:
+						if( Path == 0 )
+						{
+							for( BIT_UINT32 j = 0; j < Count; j++ )
+							{
+								AoSVectors[ j ] = Points[ j ].Cross( Directions[ j ] );
+							}
+						}
+						else
+						{
+							MathKernels::Cross( SoAPoints, SoADirections, Vectors );
+						}
+						break;
+					case 2:
+						if( Path == 0 )
+						{
+							for( BIT_UINT32 j = 0; j < Count; j++ )
+							{
+								AoSVectors[ j ] = Directions[ j ].Normal( );
+							}
+						}
+						else
+						{
+							MathKernels::Normalize( Normals );
+						}
+						break;
+					case 3:
+						if( Path == 0 )
+						{
+							for( BIT_UINT32 j = 0; j < Count; j++ )
+							{
+								const Bit::Vector3_f32 & p = Points[ j ];
+								AoSVectors[ j ] = Bit::Vector3_f32( m[ 0 ] * p.x + m[ 4 ] * p.y + m[ 8 ] * p.z + m[ 12 ],
+									m[ 1 ] * p.x + m[ 5 ] * p.y + m[ 9 ] * p.z + m[ 13 ],
+									m[ 2 ] * p.x + m[ 6 ] * p.y + m[ 10 ] * p.z + m[ 14 ] );
+							}
+						}
+						else
+						{
+							MathKernels::TransformPoints( View, SoAPoints, Vectors );
+						}
+						break;
+					case 4:
+						if( Path == 0 )
+						{
+							// Arvo, one row of the matrix at a time
+							for( BIT_UINT32 j = 0; j < Count; j++ )
+							{
+								const BIT_FLOAT32 Min[ 3 ] = { BoxMin[ j ].x, BoxMin[ j ].y, BoxMin[ j ].z };
+								const BIT_FLOAT32 Max[ 3 ] = { BoxMax[ j ].x, BoxMax[ j ].y, BoxMax[ j ].z };
+								BIT_FLOAT32 NewMin[ 3 ];
+								BIT_FLOAT32 NewMax[ 3 ];
+								for( BIT_UINT32 r = 0; r < 3; r++ )
+								{
+									NewMin[ r ] = NewMax[ r ] = m[ 12 + r ];
+									for( BIT_UINT32 c = 0; c < 3; c++ )
+									{
+										const BIT_FLOAT32 A = m[ c * 4 + r ] * Min[ c ];
+										const BIT_FLOAT32 B = m[ c * 4 + r ] * Max[ c ];
+										NewMin[ r ] += A < B ? A : B;
+										NewMax[ r ] += A > B ? A : B;
+									}
+								}
+								AoSMin[ j ] = Bit::Vector3_f32( NewMin[ 0 ], NewMin[ 1 ], NewMin[ 2 ] );
+								AoSMax[ j ] = Bit::Vector3_f32( NewMax[ 0 ], NewMax[ 1 ], NewMax[ 2 ] );
+							}
+						}
+						else
+						{
+							MathKernels::TransformBoxes( View, SoABoxMin, SoABoxMax, ResultMin, ResultMax );
+						}
+						break;
+					case 5:
+						if( Path == 0 )
+						{
+							for( BIT_UINT32 j = 0; j < Count; j++ )
+							{
+								AoSVisible[ j ] = ViewFrustum.IntersectsSphere( Points[ j ].x, Points[ j ].y, Points[ j ].z, Radii[ j ] ) ? 1 : 0;
+							}
+						}
+						else
+						{
+							MathKernels::TestSpheres( ViewFrustum, SoAPoints, Radii, Visible );
+						}
+						break;
+					default:
+						if( Path == 0 )
+						{
+							// The box corner furthest along the plane normal
+							for( BIT_UINT32 j = 0; j < Count; j++ )
+							{
+								AoSVisible[ j ] = 1;
+								for( BIT_UINT32 p = 0; p < 6; p++ )
+								{
+									const BIT_FLOAT32 * pPlane = ViewFrustum.GetPlane( static_cast< Frustum::ePlane >( p ) );
+									const BIT_FLOAT32 X = pPlane[ 0 ] >= 0.0f ? BoxMax[ j ].x : BoxMin[ j ].x;
+									const BIT_FLOAT32 Y = pPlane[ 1 ] >= 0.0f ? BoxMax[ j ].y : BoxMin[ j ].y;
+									const BIT_FLOAT32 Z = pPlane[ 2 ] >= 0.0f ? BoxMax[ j ].z : BoxMin[ j ].z;
+									if( pPlane[ 0 ] * X + pPlane[ 1 ] * Y + pPlane[ 2 ] * Z + pPlane[ 3 ] < 0.0f )
+									{
+										AoSVisible[ j ] = 0;
+										break;
+									}
+								}
+							}
+						}
+						else
+						{
+							MathKernels::TestBoxes( ViewFrustum, SoABoxMin, SoABoxMax, Visible );
+						}
+						break;
+				}
+				Timer.Stop( );
+				Times[ k ][ Path ] += Timer.GetTime( ) * 1000.0f;
+			}
+
+			// Keep the scalar results and compare the SIMD results bit by bit
+			if( Path == 0 )
+			{
+				continue;
+			}
+
+			const Vector3Array & Result = k == 2 ? Normals : ( k == 4 ? ResultMin : Vectors );
+			if( Path == 1 )
+			{
+				ScalarDots = Dots;
+				ScalarVectors[ k ] = Result;
+				ScalarMax = ResultMax;
+				ScalarVisible[ k ] = Visible;
+				continue;
+			}
+
+			if( k == 0 )
+			{
+				Exact[ k ][ Path ] = memcmp( &Dots[ 0 ], &ScalarDots[ 0 ], Count * sizeof( BIT_FLOAT32 ) ) == 0;
+			}
+			else if( k >= 5 )
+			{
+				Exact[ k ][ Path ] = memcmp( &Visible[ 0 ], &ScalarVisible[ k ][ 0 ], Count ) == 0;
+			}
+			else
+			{
+				Exact[ k ][ Path ] = EqualVectorArrays( Result, ScalarVectors[ k ] ) &&
+					( k != 4 || EqualVectorArrays( ResultMax, ScalarMax ) );
+			}
+		}
+	}
+
+	MathKernels::SetInstructionSet( CpuFeatures::GetSupportedInstructionSet( ) );
+
+	const char * Names[ KernelCount ] = { "dot", "cross", "normalize", "transform", "box transform", "sphere test", "box test" };
+	bitTrace( "Math benchmark, %u elements, %u iterations, speedup over the Bit::Vector3 loops:\n", Count, Iterations );
+	for( BIT_UINT32 k = 0; k < KernelCount; k++ )
+	{
+		bitTrace( "  %-14s  loop %.3f ms", Names[ k ], Times[ k ][ 0 ] / static_cast< BIT_FLOAT64 >( Iterations ) );
+		for( BIT_UINT32 Path = 1; Path < PathCount; Path++ )
+		{
+			const BIT_FLOAT64 Time = Times[ k ][ Path ] / static_cast< BIT_FLOAT64 >( Iterations );
+			bitTrace( "  %s %.3f ms (%.0f M/s) %.2fx%s",
+				CpuFeatures::GetInstructionSetName( static_cast< CpuFeatures::eInstructionSet >( Path - 1 ) ), Time,
+				static_cast< BIT_FLOAT64 >( Count ) / ( Time * 1000.0f ), Times[ k ][ 0 ] / Times[ k ][ Path ],
+				Exact[ k ][ Path ] ? "" : " differs" );
+		}
+		bitTrace( "\n" );
+	}
+}
+
+
+BIT_UINT32 CreateModel( )
+{
+	// Allocate the image
+	if( ( pLevelModel = pGraphicDevice->CreateModel( Bit::Model::Model_OBJ ) ) == BIT_NULL )
+	{
+		bitTrace( "[Error] Can not create the model\n" );
+	}
+
+	Bit::Timer Timer;
+	Timer.Start( );
+
+	BIT_UINT32 Status = BIT_OK;
+	if( ( Status = pLevelModel->ReadFile( Bit::GetAbsolutePath( LevelModelPath ).c_str( ) ) ) != BIT_OK )
+	{
+		if( Status == BIT_ERROR_OPEN_FILE )
+		{
+			bitTrace( "[Error] Can not open the file\n" );
+		}
+		else
+		{
+			bitTrace( "[Error] Can not read the model file\n" );
+		}
+
+		return BIT_ERROR;
+	}
+
+	// Load the model
+	BIT_UINT32 ModelVerteBits = Bit::VertexObject::Vertex_Position | Bit::VertexObject::Vertex_Texture
+		| Bit::VertexObject::Vertex_Normal | Bit::VertexObject::Vertex_Tangent | Bit::VertexObject::Vertex_Binormal;
+	Bit::Texture::eFilter TextureFilters[ ] =
+	{
+		Bit::Texture::Filter_Min, Bit::Texture::Filter_Linear_Mipmap,
+		Bit::Texture::Filter_Mag, Bit::Texture::Filter_Linear_Mipmap,
+		Bit::Texture::Filter_None, Bit::Texture::Filter_None
+	};
+	if( pLevelModel->Load( ModelVerteBits, TextureFilters, BIT_TRUE ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the model\n" );
+		return BIT_ERROR;
+	}
+
+	Timer.Stop( );
+	bitTrace( "Model load time: %f ms.\n", Timer.GetTime( ) * 1000.0f );
+
+	// Find the materials that need the alpha test
+	AlphaTestedMaterialCount = CountAlphaTestedMaterials( );
+	bitTrace( "Alpha tested materials: %u.\n", AlphaTestedMaterialCount );
+
+	// The model doesn't tell its size, the overlay counts the triangles itself
+	LevelTriangleCount = CountModelTriangles( );
+
+	return BIT_OK;
+}
+
+BIT_UINT32 CountAlphaTestedMaterials( )
+{
+	// Find the material library of the model
+	const std::string ModelPath = Bit::GetAbsolutePath( LevelModelPath );
+	std::ifstream ModelFile( ModelPath.c_str( ), std::ifstream::in );
+	std::string Line;
+	std::string MaterialPath;
+
+	while( std::getline( ModelFile, Line ) )
+	{
+		if( Line.compare( 0, 7, "mtllib " ) == 0 )
+		{
+			MaterialPath = ModelPath.substr( 0, ModelPath.find_last_of( "/\\" ) + 1 ) + Line.substr( 7 );
+			break;
+		}
+	}
+
+	// Materials with an alpha map (map_d) are the ones discarding fragments
+	std::ifstream MaterialFile( MaterialPath.c_str( ), std::ifstream::in );
+	BIT_UINT32 Count = 0;
+
+	while( std::getline( MaterialFile, Line ) )
+	{
+		const BIT_MEMSIZE Start = Line.find_first_not_of( " \t" );
+		if( Start != std::string::npos && Line.compare( Start, 6, "map_d " ) == 0 )
+		{
+			Count++;
+		}
+	}
+
+	return Count;
+}
+
+BIT_UINT32 CountModelTriangles( )
+{
+	// Faces are triangulated as fans, a face of n vertices is n - 2 triangles
+	std::ifstream ModelFile( Bit::GetAbsolutePath( LevelModelPath ).c_str( ), std::ifstream::in );
+	std::string Line;
+	BIT_UINT32 Count = 0;
+
+	while( std::getline( ModelFile, Line ) )
+	{
+		if( Line.compare( 0, 2, "f " ) != 0 )
+		{
+			continue;
+		}
+
+		BIT_UINT32 Vertices = 0;
+		for( BIT_MEMSIZE i = 1; i < Line.size( ); i++ )
+		{
+			if( Line[ i - 1 ] == ' ' && Line[ i ] != ' ' && Line[ i ] != '\r' )
+			{
+				Vertices++;
+			}
+		}
+
+		Count += Vertices > 2 ? Vertices - 2 : 0;
+	}
+
+	return Count;
+}
+
+BIT_UINT32 CreateModelShader( )
+{
+	// Shader sources
+	static const std::string VertexSource =
+		"#version 330 \n"
+		"precision highp float; \n"
+
+		"in vec3 Position; \n"
+		"in vec2 Texture; \n"
+		"in vec3 Normal; \n"
+		"in vec3 Tangent; \n"
+		"in vec3 Binormal; \n"
+
+		"out vec3 out_Position; \n"
+		"out vec2 out_Texture; \n"
+		"out vec3 out_Normal; \n"
+		"out vec3 out_Tangent; \n"
+		"out vec3 out_Binormal; \n"
+		"out mat3 out_TangentSpace; \n"
+		"invariant gl_Position; \n"
+
+		"uniform mat4 ProjectionMatrix; \n"
+		"uniform mat4 ViewMatrix; \n"
+
+		"void main(void) \n"
 		"{ \n"
 
-		// Diffuse color map
-		"	vec4 DiffuseMap = texture2D( DiffuseTexture, out_Texture ); \n"
-		"	if( DiffuseMap.a == 0.0 ) { discard; } \n"
+		// Set some out values
+		"	vec4 NewPosition = vec4( Position, 1.0 ); \n"
+		"	out_Position = NewPosition.xyz; \n"
+		"	out_Texture = Texture; \n"
+		"	out_Normal = normalize( Normal ); \n"
+		"	out_Tangent = normalize( Tangent ); \n"
+		"	out_Binormal = normalize( Binormal ); \n"
+
+		// Calculate the tangent space matrix
+		"	out_TangentSpace[ 0 ] = out_Tangent; \n"
+		"	out_TangentSpace[ 1 ] = out_Binormal; \n"
+		"	out_TangentSpace[ 2 ] = out_Normal; \n"
 
-		"	vec3 Light; \n"
+		// Set the output position
+		"	gl_Position = ProjectionMatrix * ViewMatrix * NewPosition; \n"
 
-		// Compute the direction of the light source
-		"	vec3 LightDirection = normalize( vec3( LightPosition - out_Position ) ); \n"
+		"} \n";
 
-		// Are we using normal maps?
-		"	if( UseNormalMapping == 1 ) \n"
-		"	{ \n"
-				// Normal color map
-		"		vec4 NormalMap = texture2D( NormalTexture, out_Texture ); \n"
-		"		NormalMap.y = 1.0 - NormalMap.y; \n"
-		"		vec3 OldNormalDirection = 2.0 * NormalMap.rgb - 1.0; \n"
+	// Every feature is an #ifdef block, see GetModelPermutationKey( ) for the features in use.
+	// The clustered lighting reads the textures of LightClusterGrid.
+	static const std::string FragmentSource =
+		"#version 330 \n"
+		"precision highp float; \n"
+
+		"in vec3 out_Position; \n"
+		"in vec2 out_Texture; \n"
+		"in vec3 out_Normal; \n"
+		"in vec3 out_Tangent; \n"
+		"in vec3 out_Binormal; \n"
+		"in vec3 out_LightVec; \n"
+		"in mat3 out_TangentSpace; \n"
 
-		"		vec3 NormalDirection = normalize( out_TangentSpace * OldNormalDirection ); \n"
+		"out vec4 out_Color; \n"
 
-		// Compute the light
-		"		Light = vec3( max( dot( LightDirection, NormalDirection ), 0.1 ) ); \n"
+		"uniform sampler2D DiffuseTexture; \n"
+		"#ifdef NORMAL_MAPPING \n"
+		"uniform sampler2D NormalTexture; \n"
+		"#endif \n"
 
-		"	} \n"
-		// Use normal lighting
-		"	else \n"
+		"#if defined( CLUSTERED_LIGHTING ) || defined( FOG ) \n"
+		"uniform mat4 ViewMatrix; \n"
+		"#endif \n"
+
+		"#ifdef CLUSTERED_LIGHTING \n"
+		"uniform sampler2D LightTexture; \n"
+		"uniform sampler2D ClusterTexture; \n"
+		"uniform sampler2D IndexTexture; \n"
+		"uniform vec3 ClusterGrid; \n"
+		"uniform vec2 ClusterDepth; \n"
+		"uniform vec2 ScreenSize; \n"
+		"uniform float Ambient; \n"
+		"#else \n"
+		"uniform vec3 LightPosition; \n"
+		"#endif \n"
+
+		"#ifdef FOG \n"
+		"uniform vec3 FogColor; \n"
+		"uniform float FogDensity; \n"
+		"#endif \n"
+
+		"void main(void) \n"
+		"{ \n"
+
+		// Diffuse color map
+		"	vec4 DiffuseMap = texture2D( DiffuseTexture, out_Texture ); \n"
+		"#ifdef ALPHA_TEST \n"
+		"	if( DiffuseMap.a == 0.0 ) { discard; } \n"
+		"#endif \n"
+
+		// Normal color map
+		"#ifdef NORMAL_MAPPING \n"
+		"	vec4 NormalMap = texture2D( NormalTexture, out_Texture ); \n"
+		"	NormalMap.y = 1.0 - NormalMap.y; \n"
+		"	vec3 Normal = normalize( out_TangentSpace * ( 2.0 * NormalMap.rgb - 1.0 ) ); \n"
+		"#else \n"
+		"	vec3 Normal = normalize( out_Normal ); \n"
+		"#endif \n"
+
+		"#if defined( CLUSTERED_LIGHTING ) || defined( FOG ) \n"
+		"	float ViewDepth = -( ViewMatrix * vec4( out_Position, 1.0 ) ).z; \n"
+		"#endif \n"
+
+		"#ifdef CLUSTERED_LIGHTING \n"
+		// Find the cluster, the depth slices are exponential
+		"	ivec3 Cluster = ivec3( vec3( gl_FragCoord.xy / ScreenSize * ClusterGrid.xy, \n"
+		"		log( ViewDepth / ClusterDepth.x ) * ClusterDepth.y ) ); \n"
+		"	Cluster = clamp( Cluster, ivec3( 0 ), ivec3( ClusterGrid ) - 1 ); \n"
+		"	vec4 ClusterData = texelFetch( ClusterTexture, \n"
+		"		ivec2( Cluster.x + Cluster.y * int( ClusterGrid.x ), Cluster.z ), 0 ); \n"
+		"	int Offset = int( ClusterData.x ); \n"
+		"	int Count = int( ClusterData.y ); \n"
+
+		// Accumulate the lights of the cluster, four indices per texel
+		"	vec3 Light = vec3( Ambient ); \n"
+		"	for( int i = 0; i < Count; i++ ) \n"
 		"	{ \n"
-		"		Light = vec3( max( dot( LightDirection, out_Normal ), 0.1 ) ); \n"
+		"		int Index = Offset + i; \n"
+		"		int LightIndex = int( texelFetch( IndexTexture, ivec2( ( Index >> 2 ) & 1023, Index >> 12 ), 0 )[ Index & 3 ] ); \n"
+		"		vec4 PositionRadius = texelFetch( LightTexture, ivec2( 0, LightIndex ), 0 ); \n"
+		"		vec3 LightColor = texelFetch( LightTexture, ivec2( 1, LightIndex ), 0 ).rgb; \n"
+		"		vec3 ToLight = PositionRadius.xyz - out_Position; \n"
+		"		float Distance = max( length( ToLight ), 0.0001 ); \n"
+		"		float Attenuation = clamp( 1.0 - Distance / PositionRadius.w, 0.0, 1.0 ); \n"
+		"		Light += LightColor * ( max( dot( Normal, ToLight / Distance ), 0.0 ) * Attenuation * Attenuation ); \n"
 		"	} \n"
+		"#else \n"
+		// Compute the light of the single light source
+		"	vec3 LightDirection = normalize( vec3( LightPosition - out_Position ) ); \n"
+		"	vec3 Light = vec3( max( dot( LightDirection, Normal ), 0.1 ) ); \n"
+		"#endif \n"
 
 		// Set the output color
-		"	out_Color = DiffuseMap * vec4( Light.xyz, 1.0 ); \n"
+		"	out_Color = DiffuseMap * vec4( Light, 1.0 ); \n"
+		"#ifdef FOG \n"
+		"	out_Color.rgb = mix( FogColor, out_Color.rgb, exp( -ViewDepth * FogDensity ) ); \n"
+		"#endif \n"
+		"} \n";
+
+	// Create the permutations, the variants are compiled when they are first rendered
+	pModelPermutations = new ShaderPermutations( pGraphicDevice, "Model" );
+	pModelPermutations->SetSources( VertexSource, FragmentSource );
+	pModelPermutations->SetSetupFunction( SetupModelProgram, BIT_NULL );
+	ModelFeature_NormalMapping = pModelPermutations->AddFeature( "NORMAL_MAPPING" );
+	ModelFeature_AlphaTest = pModelPermutations->AddFeature( "ALPHA_TEST" );
+	ModelFeature_Clustered = pModelPermutations->AddFeature( "CLUSTERED_LIGHTING" );
+	ModelFeature_Fog = pModelPermutations->AddFeature( "FOG" );
+
+	// Set attribute locations
+	pModelPermutations->AddAttribute( "Position", 0 );
+	pModelPermutations->AddAttribute( "Texture", 1 );
+	pModelPermutations->AddAttribute( "Normal", 2 );
+	pModelPermutations->AddAttribute( "Tangent", 3 );
+	pModelPermutations->AddAttribute( "Binormal", 4 );
+
+	// Compile the variant of the current settings right away to catch errors early
+	if( pModelPermutations->Get( GetModelPermutationKey( ) | ModelFeature_AlphaTest ) == BIT_NULL )
+	{
+		bitTrace( "[Error] Can not compile the model shader\n" );
+		return BIT_ERROR;
+	}
+
+	return BIT_OK;
+}
+
+void SetupModelProgram( ShaderPermutations::Permutation & p_Permutation, void * /* p_pUserData */ )
+{
+	Bit::ShaderProgram * pShaderProgram = p_Permutation.pShaderProgram;
+	pShaderProgram->SetUniform1i( "DiffuseTexture", 0 );
+	pShaderProgram->SetUniform1i( "NormalTexture", 1 );
+
+	if( p_Permutation.Key & ModelFeature_Clustered )
+	{
+		// The near and far planes are read from the projection matrix
+		const Bit::Matrix4x4 & Projection = FrameUniforms.GetData( ).ProjectionMatrix;
+		const BIT_FLOAT32 Near = Projection.m[ 14 ] / ( Projection.m[ 10 ] - 1.0f );
+		const BIT_FLOAT32 Far = Projection.m[ 14 ] / ( Projection.m[ 10 ] + 1.0f );
+
+		pShaderProgram->SetUniform1i( "LightTexture", 2 );
+		pShaderProgram->SetUniform1i( "ClusterTexture", 3 );
+		pShaderProgram->SetUniform1i( "IndexTexture", 4 );
+		pShaderProgram->SetUniform3f( "ClusterGrid", static_cast< BIT_FLOAT32 >( ClusterGridX ),
+			static_cast< BIT_FLOAT32 >( ClusterGridY ), static_cast< BIT_FLOAT32 >( ClusterGridZ ) );
+		pShaderProgram->SetUniform2f( "ClusterDepth", Near, static_cast< BIT_FLOAT32 >( ClusterGridZ ) / logf( Far / Near ) );
+		pShaderProgram->SetUniform1f( "Ambient", AmbientLight );
+	}
+
+	if( p_Permutation.Key & ModelFeature_Fog )
+	{
+		pShaderProgram->SetUniform3f( "FogColor", FogColor.x, FogColor.y, FogColor.z );
+		pShaderProgram->SetUniform1f( "FogDensity", FogDensity );
+	}
+}
+
+BIT_UINT32 GetModelPermutationKey( )
+{
+	// The alpha test is added by the caller, it depends on the depth pre-pass
+	BIT_UINT32 Key = 0;
+
+	if( SponzaSettings.GetUseNormalMapping( ) )
+	{
+		Key |= ModelFeature_NormalMapping;
+	}
+
+	if( SponzaSettings.GetLightingMode( ) == Settings::Lighting_Clustered )
+	{
+		Key |= ModelFeature_Clustered;
+	}
+
+	if( UseFog )
+	{
+		Key |= ModelFeature_Fog;
+	}
+
+	return Key;
+}
+
+BIT_UINT32 CreatePrepassShader( )
+{
+	// Shader sources, the position has to be calculated exactly like in the model
+	// vertex shader or the depth equal test in the color pass fails.
+	static const std::string VertexSource =
+		"#version 330 \n"
+		"precision highp float; \n"
+
+		"in vec3 Position; \n"
+		"in vec2 Texture; \n"
+		"out vec2 out_Texture; \n"
+		"invariant gl_Position; \n"
+
+		"uniform mat4 ProjectionMatrix; \n"
+		"uniform mat4 ViewMatrix; \n"
+
+		"void main(void) \n"
+		"{ \n"
+		"	vec4 NewPosition = vec4( Position, 1.0 ); \n"
+		"	out_Texture = Texture; \n"
+		"	gl_Position = ProjectionMatrix * ViewMatrix * NewPosition; \n"
+		"} \n";
+
+	// The color is masked out in the pre-pass, the weight is only used when counting fragments.
+	static const std::string FragmentSourceHead =
+		"#version 330 \n"
+		"precision highp float; \n"
+
+		"in vec2 out_Texture; \n"
+		"out vec4 out_Color; \n"
+
+		"uniform sampler2D DiffuseTexture; \n"
+		"uniform float FragmentWeight; \n"
+
+		"void main(void) \n"
+		"{ \n";
+
+	static const std::string AlphaTestSource =
+		"	if( texture2D( DiffuseTexture, out_Texture ).a == 0.0 ) { discard; } \n";
+
+	static const std::string FragmentSourceTail =
+		"	out_Color = vec4( FragmentWeight ); \n"
 		"} \n";
 
-	// Load the shaders
+	// Models without alpha maps get a position only pre-pass
+	const std::string FragmentSource = AlphaTestedMaterialCount > 0 ?
+		FragmentSourceHead + AlphaTestSource + FragmentSourceTail :
+		FragmentSourceHead + FragmentSourceTail;
+
 	// Create the vertex and fragment shaders
-	if( ( pVertexShader_Model = pGraphicDevice->CreateShader( Bit::Shader::Vertex ) ) == BIT_NULL )
+	if( ( pVertexShader_Prepass = pGraphicDevice->CreateShader( Bit::Shader::Vertex ) ) == BIT_NULL )
 	{
-		bitTrace( "[Error] Can not create the vertex shader\n" );
+		bitTrace( "[Error] Can not create the pre-pass vertex shader\n" );
 		return BIT_ERROR;
 	}
-	if( ( pFragmentShader_Model = pGraphicDevice->CreateShader( Bit::Shader::Fragment ) ) == BIT_NULL )
+	if( ( pFragmentShader_Prepass = pGraphicDevice->CreateShader( Bit::Shader::Fragment ) ) == BIT_NULL )
 	{
-		bitTrace( "[Error] Can not create the vertex shader\n" );
+		bitTrace( "[Error] Can not create the pre-pass fragment shader\n" );
 		return BIT_ERROR;
 	}
 
 	// Set the sources
-	pVertexShader_Model->SetSource( VertexSource );
-	pFragmentShader_Model->SetSource( FragmentSource );
+	pVertexShader_Prepass->SetSource( VertexSource );
+	pFragmentShader_Prepass->SetSource( FragmentSource );
 
 	// Compile the shaders
-	if( pVertexShader_Model->Compile( ) != BIT_OK )
+	if( pVertexShader_Prepass->Compile( ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not compile the vertex shader\n" );
+		bitTrace( "[Error] Can not compile the pre-pass vertex shader\n" );
 		return BIT_ERROR;
 	}
-	if( pFragmentShader_Model->Compile( ) != BIT_OK )
+	if( pFragmentShader_Prepass->Compile( ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not compile the fragment shader\n" );
+		bitTrace( "[Error] Can not compile the pre-pass fragment shader\n" );
 		return BIT_ERROR;
 	}
 
-
 	// Create the shader program
-	if( ( pShaderProgram_Model = pGraphicDevice->CreateShaderProgram( ) ) == BIT_NULL )
+	if( ( pShaderProgram_Prepass = pGraphicDevice->CreateShaderProgram( ) ) == BIT_NULL )
 	{
-		bitTrace( "[Error] Can not create the shader program\n" );
+		bitTrace( "[Error] Can not create the pre-pass shader program\n" );
 		return BIT_ERROR;
 	}
 
 	// Attach the shaders
-	if( pShaderProgram_Model->AttachShaders( pVertexShader_Model ) != BIT_OK )
+	if( pShaderProgram_Prepass->AttachShaders( pVertexShader_Prepass ) != BIT_OK ||
+		pShaderProgram_Prepass->AttachShaders( pFragmentShader_Prepass ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not attach the vertex shader\n" );
-		return BIT_ERROR;
-	}
-	if( pShaderProgram_Model->AttachShaders( pFragmentShader_Model ) != BIT_OK )
-	{
-		bitTrace( "[Error] Can not attach the fragment shader\n" );
+		bitTrace( "[Error] Can not attach the pre-pass shaders\n" );
 		return BIT_ERROR;
 	}
 
 	// Set attribute locations
-	pShaderProgram_Model->SetAttributeLocation( "Position", 0 );
-	pShaderProgram_Model->SetAttributeLocation( "Texture", 1 );
-	pShaderProgram_Model->SetAttributeLocation( "Normal", 2 );
-	pShaderProgram_Model->SetAttributeLocation( "Tangent", 3 );
-	pShaderProgram_Model->SetAttributeLocation( "Binormal", 4 );
+	pShaderProgram_Prepass->SetAttributeLocation( "Position", 0 );
+	pShaderProgram_Prepass->SetAttributeLocation( "Texture", 1 );
 
 	// Link the shaders
-	if( pShaderProgram_Model->Link( ) != BIT_OK )
+	if( pShaderProgram_Prepass->Link( ) != BIT_OK )
 	{
-		bitTrace( "[Error] Can not link the shader program\n" );
+		bitTrace( "[Error] Can not link the pre-pass shader program\n" );
 		return BIT_ERROR;
 	}
 
 	// Set uniforms
-	pShaderProgram_Model->Bind( );
-	pShaderProgram_Model->SetUniform1i( "DiffuseTexture", 0 );
-	pShaderProgram_Model->SetUniform1i( "NormalTexture", 1 );
-	pShaderProgram_Model->SetUniformMatrix4x4f( "ProjectionMatrix",
-		Bit::MatrixManager::GetMatrix( Bit::MatrixManager::Mode_Projection ) );
-	pShaderProgram_Model->SetUniformMatrix4x4f( "ViewMatrix",
-		Bit::MatrixManager::GetMatrix( Bit::MatrixManager::Mode_ModelView ) );
-	pShaderProgram_Model->SetUniform3f( "LightPosition", 1.0f, 100.0f, 0.0f );
-	pShaderProgram_Model->SetUniform1i( "UseNormalMapping", SponzaSettings.GetUseNormalMapping( ) );
-	pShaderProgram_Model->Unbind( );
+	pUniforms_Prepass = new ShaderUniforms( pShaderProgram_Prepass );
+	pShaderProgram_Prepass->Bind( );
+	pShaderProgram_Prepass->SetUniform1i( "DiffuseTexture", 0 );
+	pUniforms_Prepass->SetUniform1f( FragmentWeightHandle, 0.0f );
+	FrameUniforms.Apply( *pUniforms_Prepass, FrameMembers_Prepass );
+	pShaderProgram_Prepass->Unbind( );
+
+	return BIT_OK;
+}
+
+BIT_UINT32 CreateDeferredRenderer( )
+{
+	GenerateLights( );
+
+	pDeferredRenderer = new DeferredRenderer( pGraphicDevice, pLevelModel, &SceneLights, &FrameUniforms );
+	if( pDeferredRenderer->Load( ResolutionController.GetTargetSize( ) ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the deferred renderer.\n" );
+		return BIT_ERROR;
+	}
 
+	pDeferredRenderer->SetUseNormalMapping( SponzaSettings.GetUseNormalMapping( ) );
+	pDeferredRenderer->SetAmbient( AmbientLight );
+	pDeferredRenderer->SetViewportSize( RenderViewportSize );
 	return BIT_OK;
 }
 
+BIT_UINT32 CreateClusteredLighting( )
+{
+	pLightClusterGrid = new LightClusterGrid( pGraphicDevice );
+	if( pLightClusterGrid->Load( ClusterGridX, ClusterGridY, ClusterGridZ, MaxLightCount, MaxClusterIndices ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the light cluster grid.\n" );
+		return BIT_ERROR;
+	}
+
+	bitTrace( "Light cluster grid: %ux%ux%u, %u threads.\n", ClusterGridX, ClusterGridY, ClusterGridZ,
+		pLightClusterGrid->GetThreadCount( ) );
+	return BIT_OK;
+}
+
+void GenerateLights( )
+{
+	// The same seed gives the same first lights for every light count
+	SceneLights.Generate( SponzaSettings.GetLightCount( ), LightBoundsMin, LightBoundsMax, 150.0f, 400.0f, LightSeed );
+	bitTrace( "Light count: %u.\n", SceneLights.GetCount( ) );
+}
+
+void PrintFrameTimings( )
+{
+	bitTrace( "%s shading, %u frames:\n", LightingModeNames[ SponzaSettings.GetLightingMode( ) ], TimingFrameCount );
+	pRenderGraph->PrintTimings( );
+
+	if( SponzaSettings.GetLightingMode( ) == Settings::Lighting_Deferred )
+	{
+		bitTrace( "  Lights: %u, visible: %u, culling: %.3f ms, skipped culls: %u\n", SceneLights.GetCount( ),
+			pDeferredRenderer->GetVisibleLightCount( ), pDeferredRenderer->GetCullTime( ), pDeferredRenderer->GetCullSkipCount( ) );
+	}
+	else if( SponzaSettings.GetLightingMode( ) == Settings::Lighting_Clustered )
+	{
+		bitTrace( "  Lights: %u, light indices: %u%s, assignment: %.3f ms (%u threads), upload: %.3f ms\n",
+			SceneLights.GetCount( ), pLightClusterGrid->GetIndexCount( ), pLightClusterGrid->GetOverflow( ) ? " (overflow)" : "",
+			pLightClusterGrid->GetAssignTime( ), pLightClusterGrid->GetThreadCount( ), pLightClusterGrid->GetUploadTime( ) );
+		bitTrace( "  Skipped assignments: %u, skipped uploads: %u\n",
+			pLightClusterGrid->GetAssignSkipCount( ), pLightClusterGrid->GetUploadSkipCount( ) );
+	}
+
+	// Work saved by the version checks since the start
+	bitTrace( "  Camera version: %u, skipped camera updates: %u\n", ViewCamera.GetVersion( ), ViewCamera.GetSkipCount( ) );
+
+	pRenderGraph->ResetTimings( );
+}
+
+void ApplyRenderScale( )
+{
+	// The engine's bloom reads the whole color texture
+	RenderViewportSize = BloomMode == Bloom_Engine ?
+		ResolutionController.GetTargetSize( ) : ResolutionController.GetViewportSize( );
+
+	const Bit::Vector2_ui32 TargetSize = ResolutionController.GetTargetSize( );
+	pPostProcessingDualBloom->SetSourceScale( Bit::Vector2_f32(
+		static_cast< BIT_FLOAT32 >( RenderViewportSize.x ) / static_cast< BIT_FLOAT32 >( TargetSize.x ),
+		static_cast< BIT_FLOAT32 >( RenderViewportSize.y ) / static_cast< BIT_FLOAT32 >( TargetSize.y ) ) );
+	pDeferredRenderer->SetViewportSize( RenderViewportSize );
+}
+
 BIT_UINT32 CreateGUI( )
 {
 	// Allocate everything
@@ -947,6 +2562,24 @@ BIT_UINT32 CreateGUI( )
 	GUI->Add( Checkbox1 );
 	GUI->Add( Checkbox2 );
 
+	// Load the text renderer, the glyphs go into the GUI atlas
+	Text = new TextRenderer( GUI );
+	if( Text->Load( ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the text renderer\n" );
+		return BIT_ERROR;
+	}
+
+	// Load the performance overlay in the upper left corner, toggled with U
+	HUD = new PerformanceHUD( GUI, Text );
+	if( HUD->Load( ) != BIT_OK )
+	{
+		bitTrace( "[Error] Can not load the performance overlay\n" );
+		return BIT_ERROR;
+	}
+	HUD->SetPosition( Bit::Vector2_si32( 8, static_cast< BIT_SINT32 >( SponzaSettings.GetWindowSize( ).y ) - 8 ) );
+	HUD->SetTargetFrameTime( SponzaSettings.GetTargetFrameTime( ) );
+
 	/*
 
 	GUIManager * GUI = BIT_NULL;
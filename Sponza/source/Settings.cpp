@@ -6,7 +6,20 @@
 
 // Constructor/destructor
 Settings::Settings( ) :
-	m_WindowSize( 0, 0 )
+	m_WindowSize( 0, 0 ),
+	m_UseNormalMapping( BIT_TRUE ),
+	m_BloomLevels( 5 ),
+	m_BloomThreshold( 0.6f ),
+	m_BloomIntensity( 1.0f ),
+	m_UseDepthPrepass( BIT_TRUE ),
+	m_LightingMode( Lighting_Forward ),
+	m_LightCount( 256 ),
+	m_UseDynamicResolution( BIT_FALSE ),
+	m_TargetFrameTime( 16.6f ),
+	m_MinResolutionScale( 0.5f ),
+	m_MaxResolutionScale( 1.0f ),
+	m_ResolutionGainP( 0.2f ),
+	m_ResolutionGainI( 0.1f )
 {
 }
 
@@ -41,12 +54,107 @@ BIT_UINT32 Settings::Open( const char * p_FilePath )
 		fin >> m_UseNormalMapping;
 	}
 
+	// Read the bloom settings
+	if( !fin.eof( ) )
+	{
+		fin >> m_BloomLevels;
+	}
+	if( !fin.eof( ) )
+	{
+		fin >> m_BloomThreshold;
+	}
+	if( !fin.eof( ) )
+	{
+		fin >> m_BloomIntensity;
+	}
+
+	// Read the depth pre-pass flag
+	if( !fin.eof( ) )
+	{
+		fin >> m_UseDepthPrepass;
+	}
+
+	// Read the many lights settings
+	if( !fin.eof( ) )
+	{
+		fin >> m_LightingMode;
+	}
+	if( !fin.eof( ) )
+	{
+		fin >> m_LightCount;
+	}
+
+	// Read the dynamic resolution settings, the frame time is in milliseconds
+	if( !fin.eof( ) )
+	{
+		fin >> m_UseDynamicResolution;
+	}
+	if( !fin.eof( ) )
+	{
+		fin >> m_TargetFrameTime;
+	}
+	if( !fin.eof( ) )
+	{
+		fin >> m_MinResolutionScale;
+	}
+	if( !fin.eof( ) )
+	{
+		fin >> m_MaxResolutionScale;
+	}
+	if( !fin.eof( ) )
+	{
+		fin >> m_ResolutionGainP;
+	}
+	if( !fin.eof( ) )
+	{
+		fin >> m_ResolutionGainI;
+	}
+
 	// Error check the widnow size
 	if( m_WindowSize.x > 4096 || m_WindowSize.y > 4096 )
 	{
 		bitTrace( "[Settings::Open] The window size is way too large.\n" );
 		return BIT_ERROR;
 	}
+
+	// Error check the bloom chain, every level halves the size
+	if( m_BloomLevels == 0 || m_BloomLevels > 10 )
+	{
+		bitTrace( "[Settings::Open] The bloom level count has to be between 1 and 10.\n" );
+		return BIT_ERROR;
+	}
+
+	// Error check the lighting mode and the light count
+	if( m_LightingMode > Lighting_Clustered )
+	{
+		bitTrace( "[Settings::Open] Unknown lighting mode.\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_LightCount > 4096 )
+	{
+		bitTrace( "[Settings::Open] The light count can not be larger than 4096.\n" );
+		return BIT_ERROR;
+	}
+
+	// Error check the dynamic resolution, the max scale sizes the render targets
+	if( m_TargetFrameTime <= 0.0f )
+	{
+		bitTrace( "[Settings::Open] The target frame time has to be positive.\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_MinResolutionScale < 0.1f || m_MinResolutionScale > m_MaxResolutionScale || m_MaxResolutionScale > 2.0f )
+	{
+		bitTrace( "[Settings::Open] The resolution scale range has to be within 0.1 and 2.\n" );
+		return BIT_ERROR;
+	}
+
+	if( m_ResolutionGainP < 0.0f || m_ResolutionGainI < 0.0f )
+	{
+		bitTrace( "[Settings::Open] The resolution gains can not be negative.\n" );
+		return BIT_ERROR;
+	}
 	
 	// Everything is ok
 	return BIT_OK;
@@ -63,6 +171,58 @@ void Settings::SetUseNormalMapping( const BIT_BOOL p_Status )
 	m_UseNormalMapping = p_Status;
 }
 
+void Settings::SetBloomLevels( const BIT_UINT32 p_Levels )
+{
+	m_BloomLevels = p_Levels;
+}
+
+void Settings::SetBloomThreshold( const BIT_FLOAT32 p_Threshold )
+{
+	m_BloomThreshold = p_Threshold;
+}
+
+void Settings::SetBloomIntensity( const BIT_FLOAT32 p_Intensity )
+{
+	m_BloomIntensity = p_Intensity;
+}
+
+void Settings::SetUseDepthPrepass( const BIT_BOOL p_Status )
+{
+	m_UseDepthPrepass = p_Status;
+}
+
+void Settings::SetLightingMode( const BIT_UINT32 p_Mode )
+{
+	m_LightingMode = p_Mode;
+}
+
+void Settings::SetLightCount( const BIT_UINT32 p_Count )
+{
+	m_LightCount = p_Count;
+}
+
+void Settings::SetUseDynamicResolution( const BIT_BOOL p_Status )
+{
+	m_UseDynamicResolution = p_Status;
+}
+
+void Settings::SetTargetFrameTime( const BIT_FLOAT32 p_Time )
+{
+	m_TargetFrameTime = p_Time;
+}
+
+void Settings::SetResolutionScaleRange( const BIT_FLOAT32 p_Min, const BIT_FLOAT32 p_Max )
+{
+	m_MinResolutionScale = p_Min;
+	m_MaxResolutionScale = p_Max;
+}
+
+void Settings::SetResolutionGains( const BIT_FLOAT32 p_Proportional, const BIT_FLOAT32 p_Integral )
+{
+	m_ResolutionGainP = p_Proportional;
+	m_ResolutionGainI = p_Integral;
+}
+
 // Get functions
 Bit::Vector2_ui32 Settings::GetWindowSize( ) const
 {
@@ -72,4 +232,64 @@ Bit::Vector2_ui32 Settings::GetWindowSize( ) const
 BIT_BOOL Settings::GetUseNormalMapping( ) const
 {
 	return m_UseNormalMapping;
-}
\ No newline at end of file
+}
+
+BIT_UINT32 Settings::GetBloomLevels( ) const
+{
+	return m_BloomLevels;
+}
+
+BIT_FLOAT32 Settings::GetBloomThreshold( ) const
+{
+	return m_BloomThreshold;
+}
+
+BIT_FLOAT32 Settings::GetBloomIntensity( ) const
+{
+	return m_BloomIntensity;
+}
+
+BIT_BOOL Settings::GetUseDepthPrepass( ) const
+{
+	return m_UseDepthPrepass;
+}
+
+BIT_UINT32 Settings::GetLightingMode( ) const
+{
+	return m_LightingMode;
+}
+
+BIT_UINT32 Settings::GetLightCount( ) const
+{
+	return m_LightCount;
+}
+
+BIT_BOOL Settings::GetUseDynamicResolution( ) const
+{
+	return m_UseDynamicResolution;
+}
+
+BIT_FLOAT32 Settings::GetTargetFrameTime( ) const
+{
+	return m_TargetFrameTime;
+}
+
+BIT_FLOAT32 Settings::GetMinResolutionScale( ) const
+{
+	return m_MinResolutionScale;
+}
+
+BIT_FLOAT32 Settings::GetMaxResolutionScale( ) const
+{
+	return m_MaxResolutionScale;
+}
+
+BIT_FLOAT32 Settings::GetResolutionGainP( ) const
+{
+	return m_ResolutionGainP;
+}
+
+BIT_FLOAT32 Settings::GetResolutionGainI( ) const
+{
+	return m_ResolutionGainI;
+}